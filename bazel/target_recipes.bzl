@@ -9,6 +9,7 @@ TARGET_RECIPES = {
     "tcmalloc_and_profiler": "gperftools",
     "luajit": "luajit",
     "nghttp2": "nghttp2",
+    "re2": "re2",
     "yaml_cpp": "yaml-cpp",
     "zlib": "zlib",
 }
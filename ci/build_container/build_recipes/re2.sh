@@ -0,0 +1,10 @@
+#!/bin/bash
+
+set -e
+
+VERSION=2018-07-01
+
+wget -O re2-"$VERSION".tar.gz https://github.com/google/re2/archive/"$VERSION".tar.gz
+tar xf re2-"$VERSION".tar.gz
+cd re2-"$VERSION"
+make CXX="$CXX" CXXFLAGS="${CXXFLAGS} ${CPPFLAGS}" prefix="$THIRDPARTY_BUILD" static-install
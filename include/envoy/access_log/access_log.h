@@ -76,10 +76,24 @@ class Formatter {
 public:
   virtual ~Formatter() {}
 
+  /**
+   * @return std::string the formatted log line.
+   */
   virtual std::string format(const Http::HeaderMap& request_headers,
                              const Http::HeaderMap& response_headers,
                              const Http::HeaderMap& response_trailers,
                              const RequestInfo::RequestInfo& request_info) const PURE;
+
+  /**
+   * Append the formatted log line to output. A caller that reuses output across calls does not
+   * allocate once its capacity has grown to fit a line.
+   * @param output supplies the string to append to.
+   */
+  virtual void formatInto(const Http::HeaderMap& request_headers,
+                          const Http::HeaderMap& response_headers,
+                          const Http::HeaderMap& response_trailers,
+                          const RequestInfo::RequestInfo& request_info,
+                          std::string& output) const PURE;
 };
 
 typedef std::unique_ptr<Formatter> FormatterPtr;
@@ -49,12 +49,32 @@ public:
    */
   virtual ssize_t recv(int socket, void* buffer, size_t length, int flags) PURE;
 
+  /**
+   * @see sendmsg (man 2 sendmsg)
+   */
+  virtual ssize_t sendmsg(int socket, const msghdr* message, int flags) PURE;
+
+  /**
+   * @see recvmsg (man 2 recvmsg)
+   */
+  virtual ssize_t recvmsg(int socket, msghdr* message, int flags) PURE;
+
   /**
    * Release all resources allocated for fd.
    * @return zero on success, -1 returned otherwise.
    */
   virtual int close(int fd) PURE;
 
+  /**
+   * @see man 2 dup
+   */
+  virtual int dup(int fd) PURE;
+
+  /**
+   * @see man 2 shutdown
+   */
+  virtual int shutdown(int sockfd, int how) PURE;
+
   /**
    * @see shm_open (man 3 shm_open)
    */
@@ -75,11 +95,32 @@ public:
    */
   virtual void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) PURE;
 
+  /**
+   * @see man 2 munmap
+   */
+  virtual int munmap(void* addr, size_t length) PURE;
+
   /**
    * @see man 2 stat
    */
   virtual int stat(const char* pathname, struct stat* buf) PURE;
 
+  /**
+   * @see man 2 fstat
+   */
+  virtual int fstat(int fd, struct stat* buf) PURE;
+
+  /**
+   * @see man 2 flock
+   */
+  virtual int flock(int fd, int operation) PURE;
+
+  /**
+   * @see man 3 posix_fallocate
+   * @return zero on success, or the error number on failure. errno is not set.
+   */
+  virtual int posixFallocate(int fd, off_t offset, off_t length) PURE;
+
   /**
    * @see man 2 setsockopt
    */
@@ -7,6 +7,8 @@
 
 #include "envoy/common/pure.h"
 
+#include "absl/strings/string_view.h"
+
 namespace Envoy {
 namespace Buffer {
 
@@ -76,6 +78,19 @@ public:
    */
   virtual void add(const Instance& data) PURE;
 
+  /**
+   * Prepend a string_view to the buffer.
+   * @param data supplies the string_view to copy.
+   */
+  virtual void prepend(absl::string_view data) PURE;
+
+  /**
+   * Prepend data from another buffer to this buffer.
+   * The supplied buffer is drained after this operation.
+   * @param data supplies the buffer to be prepended.
+   */
+  virtual void prepend(Instance& data) PURE;
+
   /**
    * Commit a set of slices originally obtained from reserve(). The number of slices can be
    * different from the number obtained from reserve(). The size of each slice can also be altered.
@@ -111,7 +126,7 @@ public:
    * end. However, calling getRawSlices(iovec, SOME_CONST), WILL return potentially empty slices
    * beyond the end of the buffer. Code that is trying to avoid stack overflow by limiting the
    * number of returned slices needs to deal with this. When we get rid of evbuffer we can rework
-   * all of this.
+   * all of this. The native slice-based implementation never returns empty slices.
    */
   virtual uint64_t getRawSlices(RawSlice* out, uint64_t out_size) const PURE;
 
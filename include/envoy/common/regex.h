@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "envoy/common/pure.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Regex {
+
+/**
+ * A regular expression compiled when configuration is loaded. Implementations are immutable once
+ * constructed and may be used concurrently from multiple threads.
+ */
+class CompiledMatcher {
+public:
+  virtual ~CompiledMatcher() {}
+
+  /**
+   * @param value supplies the value to match.
+   * @return bool true if the regex matches the entire value.
+   */
+  virtual bool match(absl::string_view value) const PURE;
+
+  /**
+   * Find the leftmost match of the regex in a value.
+   * @param value supplies the value to search.
+   * @param groups supplies the vector to fill with the text of the match, followed by the text of
+   *        each capture group. Groups that did not participate in the match have a null data().
+   *        Every element refers into value.
+   * @return bool true if the regex matches any part of value.
+   */
+  virtual bool search(absl::string_view value, std::vector<absl::string_view>& groups) const PURE;
+};
+
+typedef std::unique_ptr<const CompiledMatcher> CompiledMatcherPtr;
+typedef std::shared_ptr<const CompiledMatcher> CompiledMatcherSharedPtr;
+
+} // namespace Regex
+} // namespace Envoy
@@ -115,6 +115,20 @@ public:
    */
   virtual void deferredDelete(DeferredDeletablePtr&& to_delete) PURE;
 
+  /**
+   * Hand an item that outlives its creator to the dispatcher. The dispatcher keeps the item until
+   * it is taken back with disown() or, failing that, until the dispatcher itself is destroyed.
+   * @param to_own supplies the item.
+   */
+  virtual void own(DeferredDeletablePtr&& to_own) PURE;
+
+  /**
+   * Take back an item previously passed to own(), typically to then pass it to deferredDelete().
+   * @param owned supplies the item.
+   * @return DeferredDeletablePtr the item.
+   */
+  virtual DeferredDeletablePtr disown(DeferredDeletable& owned) PURE;
+
   /**
    * Exit the event loop.
    */
@@ -151,6 +165,15 @@ public:
    * @return the watermark buffer factory for this dispatcher.
    */
   virtual Buffer::WatermarkFactory& getWatermarkFactory() PURE;
+
+  /**
+   * Create stats for resources owned by this dispatcher, such as its buffer slice pool. Stats are
+   * not tracked until this is called.
+   * @param scope supplies the scope to create the stats in.
+   * @param prefix supplies the prefix for the stat names. Dispatchers sharing a prefix aggregate
+   *        into the same stats.
+   */
+  virtual void initializeStats(Stats::Scope& scope, const std::string& prefix) PURE;
 };
 
 typedef std::unique_ptr<Dispatcher> DispatcherPtr;
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <limits>
 #include <memory>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
 #include "envoy/common/pure.h"
@@ -190,6 +191,13 @@ public:
  * HTTP/1.* Codec settings
  */
 struct Http1Settings {
+  enum class Parser {
+    // http_parser (https://github.com/nodejs/http-parser).
+    HttpParser,
+    // Http1::VectorizedParserImpl, which scans with SSE4.2 or AVX2 where the CPU supports them.
+    Vectorized,
+  };
+
   // Enable codec to parse absolute uris. This enables forward/explicit proxy support for non TLS
   // traffic
   bool allow_absolute_url_{false};
@@ -197,6 +205,11 @@ struct Http1Settings {
   bool accept_http_10_{false};
   // Set a default host if no Host: header is present for HTTP/1.0 requests.`
   std::string default_host_for_http_10_;
+  // Parser used to parse requests from downstream.
+  Parser parser_{Parser::HttpParser};
+  // Maximum number of pipelined requests from downstream that may be in flight at once. Responses
+  // are sent in the order requests were received. 1 disables pipelining.
+  uint32_t max_pipelined_requests_{1};
 };
 
 /**
@@ -205,9 +218,19 @@ struct Http1Settings {
 struct Http2Settings {
   // TODO(jwfang): support other HTTP/2 settings
   uint32_t hpack_table_size_{DEFAULT_HPACK_TABLE_SIZE};
+  // Upper bound on the dynamic table our HPACK encoder uses, regardless of the size the peer
+  // allows. hpack_table_size_ above is the size we allow the peer's encoder.
+  uint32_t hpack_encoder_table_size_{DEFAULT_HPACK_TABLE_SIZE};
+  // Headers that are always sent as never-indexed literals so that they do not churn the dynamic
+  // table and are not indexed by intermediaries. Shared by all connections using the settings, and
+  // null if there are none.
+  std::shared_ptr<const std::vector<LowerCaseString>> hpack_never_index_headers_;
   uint32_t max_concurrent_streams_{DEFAULT_MAX_CONCURRENT_STREAMS};
   uint32_t initial_stream_window_size_{DEFAULT_INITIAL_STREAM_WINDOW_SIZE};
   uint32_t initial_connection_window_size_{DEFAULT_INITIAL_CONNECTION_WINDOW_SIZE};
+  // Number of connections an upstream connection pool keeps open to each host. Only used for
+  // upstream clusters.
+  uint32_t max_connections_per_host_{DEFAULT_MAX_CONNECTIONS_PER_HOST};
 
   // disable HPACK compression
   static const uint32_t MIN_HPACK_TABLE_SIZE = 0;
@@ -241,6 +264,9 @@ struct Http2Settings {
   // our default connection-level window also equals to our stream-level
   static const uint32_t DEFAULT_INITIAL_CONNECTION_WINDOW_SIZE = 256 * 1024 * 1024;
   static const uint32_t MAX_INITIAL_CONNECTION_WINDOW_SIZE = (1U << 31) - 1;
+
+  // a single connection per host, with all streams multiplexed onto it
+  static const uint32_t DEFAULT_MAX_CONNECTIONS_PER_HOST = 1;
 };
 
 /**
@@ -342,6 +368,13 @@ public:
    * @return StreamEncoder& supplies the encoder to write the request into.
    */
   virtual StreamEncoder& newStream(StreamDecoder& response_decoder) PURE;
+
+  /**
+   * @return uint32_t the maximum number of streams the remote currently allows to be active at
+   *         once on this connection. For HTTP/2 this is the peer's SETTINGS_MAX_CONCURRENT_STREAMS,
+   *         which is unlimited until the peer's SETTINGS frame is received.
+   */
+  virtual uint32_t maxConcurrentStreams() PURE;
 };
 
 typedef std::unique_ptr<ClientConnection> ClientConnectionPtr;
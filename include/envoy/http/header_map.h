@@ -18,21 +18,46 @@ namespace Http {
 
 /**
  * Wrapper for a lower case string used in header operations to generally avoid needless case
- * insensitive compares.
+ * insensitive compares. The hash of the string is computed once at construction so that header
+ * maps can look up keys without rehashing them; most keys are long lived (e.g. Http::Headers) so
+ * the cost is paid once per process.
  */
 class LowerCaseString {
 public:
-  LowerCaseString(LowerCaseString&& rhs) : string_(std::move(rhs.string_)) {}
-  LowerCaseString(const LowerCaseString& rhs) : string_(rhs.string_) {}
-  explicit LowerCaseString(const std::string& new_string) : string_(new_string) { lower(); }
+  LowerCaseString(LowerCaseString&& rhs) : string_(std::move(rhs.string_)), hash_(rhs.hash_) {}
+  LowerCaseString(const LowerCaseString& rhs) : string_(rhs.string_), hash_(rhs.hash_) {}
+  explicit LowerCaseString(const std::string& new_string) : string_(new_string) {
+    lower();
+    hash_ = hash(string_);
+  }
 
   const std::string& get() const { return string_; }
   bool operator==(const LowerCaseString& rhs) const { return string_ == rhs.string_; }
 
+  /**
+   * @return uint64_t the precomputed hash of the string. Equal to hash(get()).
+   */
+  uint64_t hash() const { return hash_; }
+
+  /**
+   * Hash a header key. This is the hash cached by LowerCaseString and used by header maps to index
+   * keys, so keys that arrive as raw strings (e.g. from a codec) hash identically.
+   * @param key supplies the key to hash.
+   * @return uint64_t the 64-bit FNV-1a hash of the key.
+   */
+  static uint64_t hash(absl::string_view key) {
+    uint64_t value = 14695981039346656037UL;
+    for (const char c : key) {
+      value = (value ^ static_cast<uint8_t>(c)) * 1099511628211UL;
+    }
+    return value;
+  }
+
 private:
   void lower() { std::transform(string_.begin(), string_.end(), string_.begin(), tolower); }
 
   std::string string_;
+  uint64_t hash_;
 };
 
 /**
@@ -341,6 +366,20 @@ public:
    */
   virtual void addReferenceKey(const LowerCaseString& key, const std::string& value) PURE;
 
+  /**
+   * Add a header with a reference key to the map. The key MUST point to point to data that will
+   * live beyond the lifetime of any request/response using the string (since a codec may optimize
+   * for zero copy). The value is moved into the map, so that a value built up in a HeaderString is
+   * not copied again.
+   *
+   * Calling addReferenceKey multiple times for the same header will result in multiple headers
+   * being present in the HeaderMap.
+   *
+   * @param key specifies the name of the header to add; it WILL NOT be copied.
+   * @param value specifies the value of the header to add; it WILL be moved from.
+   */
+  virtual void addReferenceKey(const LowerCaseString& key, HeaderString&& value) PURE;
+
   /**
    * Add a header by copying both the header key and the value.
    *
@@ -389,6 +428,20 @@ public:
    */
   virtual void setReferenceKey(const LowerCaseString& key, const std::string& value) PURE;
 
+  /**
+   * Set a header with a reference key in the map. The key MUST point to point to data that will
+   * live beyond the lifetime of any request/response using the string (since a codec may optimize
+   * for zero copy). The value is moved into the map, so that a value built up in a HeaderString is
+   * not copied again.
+   *
+   * Calling setReferenceKey multiple times for the same header will result in only the last header
+   * being present in the HeaderMap.
+   *
+   * @param key specifies the name of the header to set; it WILL NOT be copied.
+   * @param value specifies the value of the header to set; it WILL be moved from.
+   */
+  virtual void setReferenceKey(const LowerCaseString& key, HeaderString&& value) PURE;
+
   /**
    * @return uint64_t the approximate size of the header map in bytes.
    */
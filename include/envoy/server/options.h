@@ -158,6 +158,12 @@ public:
    * @return bool indicating whether the hot restart functionality has been disabled via cli flags.
    */
   virtual bool hotRestartDisabled() const PURE;
+
+  /**
+   * @return bool indicating whether buffers should use the libevent evbuffer implementation rather
+   * than the native slice-based implementation.
+   */
+  virtual bool libeventBuffersEnabled() const PURE;
 };
 
 } // namespace Server
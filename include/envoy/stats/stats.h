@@ -24,6 +24,9 @@ class Instance;
 
 namespace Stats {
 
+class StatName;
+class SymbolTable;
+
 /**
  * General representation of a tag.
  */
@@ -102,19 +105,27 @@ class Metric {
 public:
   virtual ~Metric() {}
   /**
-   * Returns the full name of the Metric.
+   * Returns the full name of the Metric. Implementations may store names in an encoded form and
+   * decode them on each call, so this should not be called in the data path.
    */
-  virtual const std::string& name() const PURE;
+  virtual std::string name() const PURE;
 
   /**
    * Returns a vector of configurable tags to identify this Metric.
    */
-  virtual const std::vector<Tag>& tags() const PURE;
+  virtual std::vector<Tag> tags() const PURE;
 
   /**
    * Returns the name of the Metric with the portions designated as tags removed.
    */
-  virtual const std::string& tagExtractedName() const PURE;
+  virtual std::string tagExtractedName() const PURE;
+
+  /**
+   * Returns the full name of the Metric, encoded with the SymbolTable of the allocator that made
+   * it. The storage is owned by the Metric, so this is cheap, and can be used as a map key for as
+   * long as the Metric is alive.
+   */
+  virtual StatName statName() const PURE;
 
   /**
    * Indicates whether this metric has been updated since the server was started.
@@ -281,7 +292,8 @@ public:
 
   /**
    * Flush a single histogram sample. Note: this call is called synchronously as a part of recording
-   * the metric, so implementations must be thread-safe.
+   * the metric, so implementations must be thread-safe. The name and tags of the histogram are kept
+   * decoded, so they are cheap to read here, unlike those of other metrics.
    * @param histogram the histogram that this sample applies to.
    * @param value the value of the sample.
    */
@@ -437,6 +449,13 @@ public:
   virtual GaugeSharedPtr makeGauge(const std::string& name, std::string&& tag_extracted_name,
                                    std::vector<Tag>&& tags) PURE;
 
+  /**
+   * @return SymbolTable& the table the names of the stats made by this allocator are encoded with.
+   *     Stores using the allocator encode the names of their stats with it too, so that each
+   *     token is only stored once.
+   */
+  virtual SymbolTable& symbolTable() PURE;
+
   // TODO(jmarantz): create a parallel mechanism to instantiate histograms. At
   // the moment, histograms don't fit the same pattern of counters and gaugaes
   // as they are not actually created in the context of a stats allocator.
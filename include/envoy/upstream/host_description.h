@@ -1,9 +1,11 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
 
 #include "envoy/api/v2/core/base.pb.h"
+#include "envoy/common/time.h"
 #include "envoy/network/address.h"
 #include "envoy/stats/stats_macros.h"
 #include "envoy/upstream/health_check_host_monitor.h"
@@ -38,6 +40,28 @@ struct HostStats {
   ALL_HOST_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
 };
 
+/**
+ * Estimate of the response latency of a host that decays over time. It is updated for each
+ * response of the host and read by latency aware load balancers, from any thread.
+ */
+class LatencyEstimator {
+public:
+  virtual ~LatencyEstimator() {}
+
+  /**
+   * Record the latency of a response.
+   * @param latency supplies the time from the end of the request to the response headers.
+   * @param now supplies the time the response headers were received.
+   */
+  virtual void putLatency(std::chrono::microseconds latency, MonotonicTime now) PURE;
+
+  /**
+   * @param now supplies the current time.
+   * @return the estimated latency at time now in microseconds, or 0 if no latency was recorded.
+   */
+  virtual double estimate(MonotonicTime now) const PURE;
+};
+
 class ClusterInfo;
 
 /**
@@ -72,6 +96,11 @@ public:
    */
   virtual HealthCheckHostMonitor& healthChecker() const PURE;
 
+  /**
+   * @return the host's response latency estimator.
+   */
+  virtual LatencyEstimator& latencyEstimator() const PURE;
+
   /**
    * @return the hostname associated with the host if any.
    * Empty string "" indicates that hostname is not a DNS name.
@@ -215,6 +215,29 @@ public:
    */
   virtual const HostsPerLocality& healthyHostsPerLocality() const PURE;
 
+  /**
+   * @return HostVectorConstSharedPtr the vector behind hosts(). Host sets never modify a vector
+   *         they have been given, so it can be shared with other host sets, e.g. on workers,
+   *         instead of being copied.
+   */
+  virtual HostVectorConstSharedPtr hostsPtr() const PURE;
+
+  /**
+   * @return HostVectorConstSharedPtr the vector behind healthyHosts(). See hostsPtr().
+   */
+  virtual HostVectorConstSharedPtr healthyHostsPtr() const PURE;
+
+  /**
+   * @return HostsPerLocalityConstSharedPtr the hosts behind hostsPerLocality(). See hostsPtr().
+   */
+  virtual HostsPerLocalityConstSharedPtr hostsPerLocalityPtr() const PURE;
+
+  /**
+   * @return HostsPerLocalityConstSharedPtr the hosts behind healthyHostsPerLocality(). See
+   *         hostsPtr().
+   */
+  virtual HostsPerLocalityConstSharedPtr healthyHostsPerLocalityPtr() const PURE;
+
   /**
    * @return weights for each locality in the host set.
    */
@@ -292,6 +315,9 @@ public:
 #define ALL_CLUSTER_STATS(COUNTER, GAUGE, HISTOGRAM)                                               \
   COUNTER  (lb_healthy_panic)                                                                      \
   COUNTER  (lb_local_cluster_not_ok)                                                               \
+  COUNTER  (lb_rebuild_entries_moved)                                                              \
+  COUNTER  (lb_rebuild_incremental)                                                                \
+  HISTOGRAM(lb_rebuild_ms)                                                                         \
   COUNTER  (lb_recalculate_zone_structures)                                                        \
   COUNTER  (lb_zone_cluster_too_small)                                                             \
   COUNTER  (lb_zone_no_capacity_left)                                                              \
@@ -316,6 +342,7 @@ public:
   COUNTER  (upstream_cx_overflow)                                                                  \
   HISTOGRAM(upstream_cx_connect_ms)                                                                \
   HISTOGRAM(upstream_cx_length_ms)                                                                 \
+  HISTOGRAM(upstream_cx_reuse_distance)                                                            \
   COUNTER  (upstream_cx_destroy)                                                                   \
   COUNTER  (upstream_cx_destroy_local)                                                             \
   COUNTER  (upstream_cx_destroy_remote)                                                            \
@@ -332,6 +359,8 @@ public:
   COUNTER  (upstream_cx_none_healthy)                                                              \
   COUNTER  (upstream_rq_total)                                                                     \
   GAUGE    (upstream_rq_active)                                                                    \
+  COUNTER  (upstream_rq_pipelined)                                                                 \
+  HISTOGRAM(upstream_rq_pipeline_depth)                                                            \
   COUNTER  (upstream_rq_pending_total)                                                             \
   COUNTER  (upstream_rq_pending_overflow)                                                          \
   COUNTER  (upstream_rq_pending_failure_eject)                                                     \
@@ -430,6 +459,12 @@ public:
    */
   virtual uint64_t features() const PURE;
 
+  /**
+   * @return const Http::Http1Settings& for HTTP/1.1 connections created on behalf of this cluster.
+   *         @see Http::Http1Settings.
+   */
+  virtual const Http::Http1Settings& http1Settings() const PURE;
+
   /**
    * @return const Http::Http2Settings& for HTTP/2 connections created on behalf of this cluster.
    *         @see Http::Http2Settings.
@@ -1,6 +1,7 @@
 #include "common/access_log/access_log_formatter.h"
 
 #include <cstdint>
+#include <regex>
 #include <string>
 #include <vector>
 
@@ -21,6 +22,32 @@ namespace AccessLog {
 
 static const std::string UnspecifiedValueString = "-";
 
+namespace {
+
+void appendInt(uint64_t value, std::string& output) {
+  const fmt::FormatInt formatted(value);
+  output.append(formatted.data(), formatted.size());
+}
+
+void appendDuration(const absl::optional<std::chrono::nanoseconds>& time, std::string& output) {
+  if (time) {
+    appendInt(std::chrono::duration_cast<std::chrono::milliseconds>(time.value()).count(), output);
+  } else {
+    output.append(UnspecifiedValueString);
+  }
+}
+
+// Appends value, truncated to max_length if one is set.
+void appendTruncated(absl::string_view value, const absl::optional<size_t>& max_length,
+                     std::string& output) {
+  if (max_length && value.size() > max_length.value()) {
+    value = value.substr(0, max_length.value());
+  }
+  output.append(value.data(), value.size());
+}
+
+} // namespace
+
 const std::string AccessLogFormatUtils::DEFAULT_FORMAT =
     "[%START_TIME%] \"%REQ(:METHOD)% %REQ(X-ENVOY-ORIGINAL-PATH?:PATH)% %PROTOCOL%\" "
     "%RESPONSE_CODE% %RESPONSE_FLAGS% %BYTES_RECEIVED% %BYTES_SENT% %DURATION% "
@@ -34,13 +61,9 @@ FormatterPtr AccessLogFormatUtils::defaultAccessLogFormatter() {
 
 std::string
 AccessLogFormatUtils::durationToString(const absl::optional<std::chrono::nanoseconds>& time) {
-  if (time) {
-    return fmt::FormatInt(
-               std::chrono::duration_cast<std::chrono::milliseconds>(time.value()).count())
-        .str();
-  } else {
-    return UnspecifiedValueString;
-  }
+  std::string duration;
+  appendDuration(time, duration);
+  return duration;
 }
 
 const std::string&
@@ -61,13 +84,28 @@ std::string FormatterImpl::format(const Http::HeaderMap& request_headers,
                                   const RequestInfo::RequestInfo& request_info) const {
   std::string log_line;
   log_line.reserve(256);
+  formatInto(request_headers, response_headers, response_trailers, request_info, log_line);
+  return log_line;
+}
 
+void FormatterImpl::formatInto(const Http::HeaderMap& request_headers,
+                               const Http::HeaderMap& response_headers,
+                               const Http::HeaderMap& response_trailers,
+                               const RequestInfo::RequestInfo& request_info,
+                               std::string& output) const {
   for (const FormatterPtr& formatter : formatters_) {
-    log_line +=
-        formatter->format(request_headers, response_headers, response_trailers, request_info);
+    formatter->formatInto(request_headers, response_headers, response_trailers, request_info,
+                          output);
   }
+}
 
-  return log_line;
+std::string AppendingFormatter::format(const Http::HeaderMap& request_headers,
+                                       const Http::HeaderMap& response_headers,
+                                       const Http::HeaderMap& response_trailers,
+                                       const RequestInfo::RequestInfo& request_info) const {
+  std::string output;
+  formatInto(request_headers, response_headers, response_trailers, request_info, output);
+  return output;
 }
 
 void AccessLogFormatParser::parseCommandHeader(const std::string& token, const size_t start,
@@ -214,96 +252,97 @@ std::vector<FormatterPtr> AccessLogFormatParser::parse(const std::string& format
 RequestInfoFormatter::RequestInfoFormatter(const std::string& field_name) {
 
   if (field_name == "REQUEST_DURATION") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return AccessLogFormatUtils::durationToString(request_info.lastDownstreamRxByteReceived());
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      appendDuration(request_info.lastDownstreamRxByteReceived(), output);
     };
   } else if (field_name == "RESPONSE_DURATION") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return AccessLogFormatUtils::durationToString(request_info.firstUpstreamRxByteReceived());
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      appendDuration(request_info.firstUpstreamRxByteReceived(), output);
     };
   } else if (field_name == "BYTES_RECEIVED") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return fmt::FormatInt(request_info.bytesReceived()).str();
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      appendInt(request_info.bytesReceived(), output);
     };
   } else if (field_name == "PROTOCOL") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return AccessLogFormatUtils::protocolToString(request_info.protocol());
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output.append(AccessLogFormatUtils::protocolToString(request_info.protocol()));
     };
   } else if (field_name == "RESPONSE_CODE") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return request_info.responseCode() ? fmt::FormatInt(request_info.responseCode().value()).str()
-                                         : "0";
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      appendInt(request_info.responseCode() ? request_info.responseCode().value() : 0, output);
     };
   } else if (field_name == "BYTES_SENT") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return fmt::FormatInt(request_info.bytesSent()).str();
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      appendInt(request_info.bytesSent(), output);
     };
   } else if (field_name == "DURATION") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return AccessLogFormatUtils::durationToString(request_info.requestComplete());
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      appendDuration(request_info.requestComplete(), output);
     };
   } else if (field_name == "RESPONSE_FLAGS") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return RequestInfo::ResponseFlagUtils::toShortString(request_info);
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output.append(RequestInfo::ResponseFlagUtils::toShortString(request_info));
     };
   } else if (field_name == "UPSTREAM_HOST") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
       if (request_info.upstreamHost()) {
-        return request_info.upstreamHost()->address()->asString();
+        output.append(request_info.upstreamHost()->address()->asString());
       } else {
-        return UnspecifiedValueString;
+        output.append(UnspecifiedValueString);
       }
     };
   } else if (field_name == "UPSTREAM_CLUSTER") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      std::string upstream_cluster_name;
-      if (nullptr != request_info.upstreamHost()) {
-        upstream_cluster_name = request_info.upstreamHost()->cluster().name();
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      if (nullptr != request_info.upstreamHost() &&
+          !request_info.upstreamHost()->cluster().name().empty()) {
+        output.append(request_info.upstreamHost()->cluster().name());
+      } else {
+        output.append(UnspecifiedValueString);
       }
-
-      return upstream_cluster_name.empty() ? UnspecifiedValueString : upstream_cluster_name;
     };
   } else if (field_name == "UPSTREAM_LOCAL_ADDRESS") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return request_info.upstreamLocalAddress() != nullptr
-                 ? request_info.upstreamLocalAddress()->asString()
-                 : UnspecifiedValueString;
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output.append(request_info.upstreamLocalAddress() != nullptr
+                        ? request_info.upstreamLocalAddress()->asString()
+                        : UnspecifiedValueString);
     };
   } else if (field_name == "DOWNSTREAM_LOCAL_ADDRESS") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return request_info.downstreamLocalAddress()->asString();
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output.append(request_info.downstreamLocalAddress()->asString());
     };
   } else if (field_name == "DOWNSTREAM_LOCAL_ADDRESS_WITHOUT_PORT") {
-    field_extractor_ = [](const Envoy::RequestInfo::RequestInfo& request_info) {
-      return RequestInfo::Utility::formatDownstreamAddressNoPort(
-          *request_info.downstreamLocalAddress());
+    field_extractor_ = [](const Envoy::RequestInfo::RequestInfo& request_info,
+                          std::string& output) {
+      output.append(RequestInfo::Utility::formatDownstreamAddressNoPort(
+          *request_info.downstreamLocalAddress()));
     };
   } else if (field_name == "DOWNSTREAM_REMOTE_ADDRESS") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return request_info.downstreamRemoteAddress()->asString();
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output.append(request_info.downstreamRemoteAddress()->asString());
     };
   } else if (field_name == "DOWNSTREAM_REMOTE_ADDRESS_WITHOUT_PORT") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return RequestInfo::Utility::formatDownstreamAddressNoPort(
-          *request_info.downstreamRemoteAddress());
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output.append(RequestInfo::Utility::formatDownstreamAddressNoPort(
+          *request_info.downstreamRemoteAddress()));
     };
   } else {
     throw EnvoyException(fmt::format("Not supported field in RequestInfo: {}", field_name));
   }
 }
 
-std::string RequestInfoFormatter::format(const Http::HeaderMap&, const Http::HeaderMap&,
-                                         const Http::HeaderMap&,
-                                         const RequestInfo::RequestInfo& request_info) const {
-  return field_extractor_(request_info);
+void RequestInfoFormatter::formatInto(const Http::HeaderMap&, const Http::HeaderMap&,
+                                      const Http::HeaderMap&,
+                                      const RequestInfo::RequestInfo& request_info,
+                                      std::string& output) const {
+  field_extractor_(request_info, output);
 }
 
 PlainStringFormatter::PlainStringFormatter(const std::string& str) : str_(str) {}
 
-std::string PlainStringFormatter::format(const Http::HeaderMap&, const Http::HeaderMap&,
-                                         const Http::HeaderMap&,
-                                         const RequestInfo::RequestInfo&) const {
-  return str_;
+void PlainStringFormatter::formatInto(const Http::HeaderMap&, const Http::HeaderMap&,
+                                      const Http::HeaderMap&, const RequestInfo::RequestInfo&,
+                                      std::string& output) const {
+  output.append(str_);
 }
 
 HeaderFormatter::HeaderFormatter(const std::string& main_header,
@@ -311,25 +350,16 @@ HeaderFormatter::HeaderFormatter(const std::string& main_header,
                                  absl::optional<size_t> max_length)
     : main_header_(main_header), alternative_header_(alternative_header), max_length_(max_length) {}
 
-std::string HeaderFormatter::format(const Http::HeaderMap& headers) const {
+void HeaderFormatter::formatInto(const Http::HeaderMap& headers, std::string& output) const {
   const Http::HeaderEntry* header = headers.get(main_header_);
 
   if (!header && !alternative_header_.get().empty()) {
     header = headers.get(alternative_header_);
   }
 
-  std::string header_value_string;
-  if (!header) {
-    header_value_string = UnspecifiedValueString;
-  } else {
-    header_value_string = header->value().c_str();
-  }
-
-  if (max_length_ && header_value_string.length() > max_length_.value()) {
-    return header_value_string.substr(0, max_length_.value());
-  }
-
-  return header_value_string;
+  appendTruncated(header ? header->value().getStringView()
+                         : absl::string_view(UnspecifiedValueString),
+                  max_length_, output);
 }
 
 ResponseHeaderFormatter::ResponseHeaderFormatter(const std::string& main_header,
@@ -337,11 +367,11 @@ ResponseHeaderFormatter::ResponseHeaderFormatter(const std::string& main_header,
                                                  absl::optional<size_t> max_length)
     : HeaderFormatter(main_header, alternative_header, max_length) {}
 
-std::string ResponseHeaderFormatter::format(const Http::HeaderMap&,
-                                            const Http::HeaderMap& response_headers,
-                                            const Http::HeaderMap&,
-                                            const RequestInfo::RequestInfo&) const {
-  return HeaderFormatter::format(response_headers);
+void ResponseHeaderFormatter::formatInto(const Http::HeaderMap&,
+                                         const Http::HeaderMap& response_headers,
+                                         const Http::HeaderMap&, const RequestInfo::RequestInfo&,
+                                         std::string& output) const {
+  HeaderFormatter::formatInto(response_headers, output);
 }
 
 RequestHeaderFormatter::RequestHeaderFormatter(const std::string& main_header,
@@ -349,10 +379,11 @@ RequestHeaderFormatter::RequestHeaderFormatter(const std::string& main_header,
                                                absl::optional<size_t> max_length)
     : HeaderFormatter(main_header, alternative_header, max_length) {}
 
-std::string RequestHeaderFormatter::format(const Http::HeaderMap& request_headers,
-                                           const Http::HeaderMap&, const Http::HeaderMap&,
-                                           const RequestInfo::RequestInfo&) const {
-  return HeaderFormatter::format(request_headers);
+void RequestHeaderFormatter::formatInto(const Http::HeaderMap& request_headers,
+                                        const Http::HeaderMap&, const Http::HeaderMap&,
+                                        const RequestInfo::RequestInfo&,
+                                        std::string& output) const {
+  HeaderFormatter::formatInto(request_headers, output);
 }
 
 ResponseTrailerFormatter::ResponseTrailerFormatter(const std::string& main_header,
@@ -360,10 +391,11 @@ ResponseTrailerFormatter::ResponseTrailerFormatter(const std::string& main_heade
                                                    absl::optional<size_t> max_length)
     : HeaderFormatter(main_header, alternative_header, max_length) {}
 
-std::string ResponseTrailerFormatter::format(const Http::HeaderMap&, const Http::HeaderMap&,
-                                             const Http::HeaderMap& response_trailers,
-                                             const RequestInfo::RequestInfo&) const {
-  return HeaderFormatter::format(response_trailers);
+void ResponseTrailerFormatter::formatInto(const Http::HeaderMap&, const Http::HeaderMap&,
+                                          const Http::HeaderMap& response_trailers,
+                                          const RequestInfo::RequestInfo&,
+                                          std::string& output) const {
+  HeaderFormatter::formatInto(response_trailers, output);
 }
 
 MetadataFormatter::MetadataFormatter(const std::string& filter_namespace,
@@ -371,28 +403,28 @@ MetadataFormatter::MetadataFormatter(const std::string& filter_namespace,
                                      absl::optional<size_t> max_length)
     : filter_namespace_(filter_namespace), path_(path), max_length_(max_length) {}
 
-std::string MetadataFormatter::format(const envoy::api::v2::core::Metadata& metadata) const {
+void MetadataFormatter::formatInto(const envoy::api::v2::core::Metadata& metadata,
+                                   std::string& output) const {
   const Protobuf::Message* data;
   if (path_.empty()) {
     const auto filter_it = metadata.filter_metadata().find(filter_namespace_);
     if (filter_it == metadata.filter_metadata().end()) {
-      return UnspecifiedValueString;
+      output.append(UnspecifiedValueString);
+      return;
     }
     data = &(filter_it->second);
   } else {
     const ProtobufWkt::Value& val = Metadata::metadataValue(metadata, filter_namespace_, path_);
     if (val.kind_case() == ProtobufWkt::Value::KindCase::KIND_NOT_SET) {
-      return UnspecifiedValueString;
+      output.append(UnspecifiedValueString);
+      return;
     }
     data = &val;
   }
   ProtobufTypes::String json;
   const auto status = Protobuf::util::MessageToJsonString(*data, &json);
   RELEASE_ASSERT(status.ok());
-  if (max_length_ && json.length() > max_length_.value()) {
-    return json.substr(0, max_length_.value());
-  }
-  return json;
+  appendTruncated(json, max_length_, output);
 }
 
 // TODO(glicht): Consider adding support for route/listener/cluster metadata as suggested by @htuch.
@@ -402,21 +434,23 @@ DynamicMetadataFormatter::DynamicMetadataFormatter(const std::string& filter_nam
                                                    absl::optional<size_t> max_length)
     : MetadataFormatter(filter_namespace, path, max_length) {}
 
-std::string DynamicMetadataFormatter::format(const Http::HeaderMap&, const Http::HeaderMap&,
-                                             const Http::HeaderMap&,
-                                             const RequestInfo::RequestInfo& request_info) const {
-  return MetadataFormatter::format(request_info.dynamicMetadata());
+void DynamicMetadataFormatter::formatInto(const Http::HeaderMap&, const Http::HeaderMap&,
+                                          const Http::HeaderMap&,
+                                          const RequestInfo::RequestInfo& request_info,
+                                          std::string& output) const {
+  MetadataFormatter::formatInto(request_info.dynamicMetadata(), output);
 }
 
 StartTimeFormatter::StartTimeFormatter(const std::string& format) : date_formatter_(format) {}
 
-std::string StartTimeFormatter::format(const Http::HeaderMap&, const Http::HeaderMap&,
-                                       const Http::HeaderMap&,
-                                       const RequestInfo::RequestInfo& request_info) const {
+void StartTimeFormatter::formatInto(const Http::HeaderMap&, const Http::HeaderMap&,
+                                    const Http::HeaderMap&,
+                                    const RequestInfo::RequestInfo& request_info,
+                                    std::string& output) const {
   if (date_formatter_.formatString().empty()) {
-    return AccessLogDateTimeFormatter::fromTime(request_info.startTime());
+    output.append(AccessLogDateTimeFormatter::fromTime(request_info.startTime()));
   } else {
-    return date_formatter_.fromTime(request_info.startTime());
+    output.append(date_formatter_.fromTime(request_info.startTime()));
   }
 }
 
@@ -92,22 +92,39 @@ public:
                      const Http::HeaderMap& response_headers,
                      const Http::HeaderMap& response_trailers,
                      const RequestInfo::RequestInfo& request_info) const override;
+  void formatInto(const Http::HeaderMap& request_headers, const Http::HeaderMap& response_headers,
+                  const Http::HeaderMap& response_trailers,
+                  const RequestInfo::RequestInfo& request_info,
+                  std::string& output) const override;
 
 private:
   std::vector<FormatterPtr> formatters_;
 };
 
+/**
+ * Base for the formatters that make up a FormatterImpl. They only implement formatInto(), which
+ * FormatterImpl calls to append each of them to the same log line.
+ */
+class AppendingFormatter : public Formatter {
+public:
+  // Formatter::format
+  std::string format(const Http::HeaderMap& request_headers,
+                     const Http::HeaderMap& response_headers,
+                     const Http::HeaderMap& response_trailers,
+                     const RequestInfo::RequestInfo& request_info) const override;
+};
+
 /**
  * Formatter for string literal. It ignores headers and request info and returns string by which it
  * was initialized.
  */
-class PlainStringFormatter : public Formatter {
+class PlainStringFormatter : public AppendingFormatter {
 public:
   PlainStringFormatter(const std::string& str);
 
   // Formatter::format
-  std::string format(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
-                     const RequestInfo::RequestInfo&) const override;
+  void formatInto(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
+                  const RequestInfo::RequestInfo&, std::string& output) const override;
 
 private:
   std::string str_;
@@ -118,7 +135,7 @@ public:
   HeaderFormatter(const std::string& main_header, const std::string& alternative_header,
                   absl::optional<size_t> max_length);
 
-  std::string format(const Http::HeaderMap& headers) const;
+  void formatInto(const Http::HeaderMap& headers, std::string& output) const;
 
 private:
   Http::LowerCaseString main_header_;
@@ -129,56 +146,59 @@ private:
 /**
  * Formatter based on request header.
  */
-class RequestHeaderFormatter : public Formatter, HeaderFormatter {
+class RequestHeaderFormatter : public AppendingFormatter, HeaderFormatter {
 public:
   RequestHeaderFormatter(const std::string& main_header, const std::string& alternative_header,
                          absl::optional<size_t> max_length);
 
   // Formatter::format
-  std::string format(const Http::HeaderMap& request_headers, const Http::HeaderMap&,
-                     const Http::HeaderMap&, const RequestInfo::RequestInfo&) const override;
+  void formatInto(const Http::HeaderMap& request_headers, const Http::HeaderMap&,
+                  const Http::HeaderMap&, const RequestInfo::RequestInfo&,
+                  std::string& output) const override;
 };
 
 /**
  * Formatter based on the response header.
  */
-class ResponseHeaderFormatter : public Formatter, HeaderFormatter {
+class ResponseHeaderFormatter : public AppendingFormatter, HeaderFormatter {
 public:
   ResponseHeaderFormatter(const std::string& main_header, const std::string& alternative_header,
                           absl::optional<size_t> max_length);
 
   // Formatter::format
-  std::string format(const Http::HeaderMap&, const Http::HeaderMap& response_headers,
-                     const Http::HeaderMap&, const RequestInfo::RequestInfo&) const override;
+  void formatInto(const Http::HeaderMap&, const Http::HeaderMap& response_headers,
+                  const Http::HeaderMap&, const RequestInfo::RequestInfo&,
+                  std::string& output) const override;
 };
 
 /**
  * Formatter based on the response trailer.
  */
-class ResponseTrailerFormatter : public Formatter, HeaderFormatter {
+class ResponseTrailerFormatter : public AppendingFormatter, HeaderFormatter {
 public:
   ResponseTrailerFormatter(const std::string& main_header, const std::string& alternative_header,
                            absl::optional<size_t> max_length);
 
   // Formatter::format
-  std::string format(const Http::HeaderMap&, const Http::HeaderMap&,
-                     const Http::HeaderMap& response_trailers,
-                     const RequestInfo::RequestInfo&) const override;
+  void formatInto(const Http::HeaderMap&, const Http::HeaderMap&,
+                  const Http::HeaderMap& response_trailers, const RequestInfo::RequestInfo&,
+                  std::string& output) const override;
 };
 
 /**
  * Formatter based on the RequestInfo field.
  */
-class RequestInfoFormatter : public Formatter {
+class RequestInfoFormatter : public AppendingFormatter {
 public:
   RequestInfoFormatter(const std::string& field_name);
 
   // Formatter::format
-  std::string format(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
-                     const RequestInfo::RequestInfo& request_info) const override;
+  void formatInto(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
+                  const RequestInfo::RequestInfo& request_info,
+                  std::string& output) const override;
 
 private:
-  std::function<std::string(const RequestInfo::RequestInfo&)> field_extractor_;
+  std::function<void(const RequestInfo::RequestInfo&, std::string&)> field_extractor_;
 };
 
 /**
@@ -189,7 +209,7 @@ public:
   MetadataFormatter(const std::string& filter_namespace, const std::vector<std::string>& path,
                     absl::optional<size_t> max_length);
 
-  std::string format(const envoy::api::v2::core::Metadata& metadata) const;
+  void formatInto(const envoy::api::v2::core::Metadata& metadata, std::string& output) const;
 
 private:
   std::string filter_namespace_;
@@ -200,24 +220,25 @@ private:
 /**
  * Formatter based on the DynamicMetadata from RequestInfo.
  */
-class DynamicMetadataFormatter : public Formatter, MetadataFormatter {
+class DynamicMetadataFormatter : public AppendingFormatter, MetadataFormatter {
 public:
   DynamicMetadataFormatter(const std::string& filter_namespace,
                            const std::vector<std::string>& path, absl::optional<size_t> max_length);
 
   // Formatter::format
-  std::string format(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
-                     const RequestInfo::RequestInfo& request_info) const override;
+  void formatInto(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
+                  const RequestInfo::RequestInfo& request_info,
+                  std::string& output) const override;
 };
 
 /**
  * Formatter
  */
-class StartTimeFormatter : public Formatter {
+class StartTimeFormatter : public AppendingFormatter {
 public:
   StartTimeFormatter(const std::string& format);
-  std::string format(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
-                     const RequestInfo::RequestInfo&) const override;
+  void formatInto(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
+                  const RequestInfo::RequestInfo&, std::string& output) const override;
 
 private:
   const Envoy::DateFormatter date_formatter_;
@@ -6,6 +6,8 @@
 #include "envoy/api/api.h"
 #include "envoy/filesystem/filesystem.h"
 
+#include "common/filesystem/filesystem_impl.h"
+
 namespace Envoy {
 namespace Api {
 
@@ -26,6 +28,8 @@ public:
 
 private:
   std::chrono::milliseconds file_flush_interval_msec_;
+  // Shared by all the files that are created, so that they are flushed by a single thread.
+  const Filesystem::FileFlusherSharedPtr file_flusher_;
 };
 
 } // namespace Api
@@ -1,6 +1,7 @@
 #include "common/api/os_sys_calls_impl.h"
 
 #include <fcntl.h>
+#include <sys/file.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -17,6 +18,10 @@ int OsSysCallsImpl::open(const std::string& full_path, int flags, int mode) {
 
 int OsSysCallsImpl::close(int fd) { return ::close(fd); }
 
+int OsSysCallsImpl::dup(int fd) { return ::dup(fd); }
+
+int OsSysCallsImpl::shutdown(int sockfd, int how) { return ::shutdown(sockfd, how); }
+
 ssize_t OsSysCallsImpl::write(int fd, const void* buffer, size_t num_bytes) {
   return ::write(fd, buffer, num_bytes);
 }
@@ -33,6 +38,14 @@ ssize_t OsSysCallsImpl::recv(int socket, void* buffer, size_t length, int flags)
   return ::recv(socket, buffer, length, flags);
 }
 
+ssize_t OsSysCallsImpl::sendmsg(int socket, const msghdr* message, int flags) {
+  return ::sendmsg(socket, message, flags);
+}
+
+ssize_t OsSysCallsImpl::recvmsg(int socket, msghdr* message, int flags) {
+  return ::recvmsg(socket, message, flags);
+}
+
 int OsSysCallsImpl::shmOpen(const char* name, int oflag, mode_t mode) {
   return ::shm_open(name, oflag, mode);
 }
@@ -45,8 +58,18 @@ void* OsSysCallsImpl::mmap(void* addr, size_t length, int prot, int flags, int f
   return ::mmap(addr, length, prot, flags, fd, offset);
 }
 
+int OsSysCallsImpl::munmap(void* addr, size_t length) { return ::munmap(addr, length); }
+
 int OsSysCallsImpl::stat(const char* pathname, struct stat* buf) { return ::stat(pathname, buf); }
 
+int OsSysCallsImpl::fstat(int fd, struct stat* buf) { return ::fstat(fd, buf); }
+
+int OsSysCallsImpl::flock(int fd, int operation) { return ::flock(fd, operation); }
+
+int OsSysCallsImpl::posixFallocate(int fd, off_t offset, off_t length) {
+  return ::posix_fallocate(fd, offset, length);
+}
+
 int OsSysCallsImpl::setsockopt(int sockfd, int level, int optname, const void* optval,
                                socklen_t optlen) {
   return ::setsockopt(sockfd, level, optname, optval, optlen);
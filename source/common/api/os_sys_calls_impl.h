@@ -16,12 +16,20 @@ public:
   ssize_t writev(int fd, const iovec* iovec, int num_iovec) override;
   ssize_t readv(int fd, const iovec* iovec, int num_iovec) override;
   ssize_t recv(int socket, void* buffer, size_t length, int flags) override;
+  ssize_t sendmsg(int socket, const msghdr* message, int flags) override;
+  ssize_t recvmsg(int socket, msghdr* message, int flags) override;
   int close(int fd) override;
+  int dup(int fd) override;
+  int shutdown(int sockfd, int how) override;
   int shmOpen(const char* name, int oflag, mode_t mode) override;
   int shmUnlink(const char* name) override;
   int ftruncate(int fd, off_t length) override;
   void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) override;
+  int munmap(void* addr, size_t length) override;
   int stat(const char* pathname, struct stat* buf) override;
+  int fstat(int fd, struct stat* buf) override;
+  int flock(int fd, int operation) override;
+  int posixFallocate(int fd, off_t offset, off_t length) override;
   int setsockopt(int sockfd, int level, int optname, const void* optval, socklen_t optlen) override;
   int getsockopt(int sockfd, int level, int optname, void* optval, socklen_t* optlen) override;
 };
@@ -20,18 +20,71 @@ static_assert(offsetof(RawSlice, mem_) == offsetof(evbuffer_iovec, iov_base),
 static_assert(offsetof(RawSlice, len_) == offsetof(evbuffer_iovec, iov_len),
               "RawSlice != evbuffer_iovec");
 
-void OwnedImpl::add(const void* data, uint64_t size) { evbuffer_add(buffer_.get(), data, size); }
+// The evbuffer backend remains the default until the native implementation has been validated in
+// production; it can be selected with --use-libevent-buffers.
+bool OwnedImpl::use_old_impl_ = true;
 
-void OwnedImpl::addBufferFragment(BufferFragment& fragment) {
-  evbuffer_add_reference(
-      buffer_.get(), fragment.data(), fragment.size(),
-      [](const void*, size_t, void* arg) { static_cast<BufferFragment*>(arg)->done(); }, &fragment);
+void OwnedImpl::useOldImpl(bool use_old_impl) { use_old_impl_ = use_old_impl; }
+
+bool OwnedImpl::newBuffersUseOldImpl() { return use_old_impl_; }
+
+bool OwnedImpl::isSameBufferImpl(const Instance& rhs) const {
+  const OwnedImpl* other = dynamic_cast<const OwnedImpl*>(&rhs);
+  if (other == nullptr) {
+    return false;
+  }
+  return usesOldImpl() == other->usesOldImpl();
 }
 
-void OwnedImpl::add(const std::string& data) {
-  evbuffer_add(buffer_.get(), data.c_str(), data.size());
+void OwnedImpl::appendSlice(SlicePtr&& slice) {
+  const uint64_t slice_size = slice->dataSize();
+  if (slice_size == 0) {
+    return;
+  }
+  if (slice_size <= CopyThreshold && !slices_.empty() &&
+      slices_.back()->reservableSize() >= slice_size) {
+    slices_.back()->append(slice->data(), slice_size);
+  } else {
+    slices_.emplace_back(std::move(slice));
+  }
+  length_ += slice_size;
 }
 
+void OwnedImpl::add(const void* data, uint64_t size) {
+  if (old_impl_) {
+    evbuffer_add(buffer_.get(), data, size);
+    return;
+  }
+
+  const uint8_t* src = static_cast<const uint8_t*>(data);
+  bool new_slice_needed = slices_.empty();
+  while (size != 0) {
+    if (new_slice_needed) {
+      slices_.emplace_back(OwnedSlice::create(size));
+    }
+    const uint64_t copy_size = slices_.back()->append(src, size);
+    src += copy_size;
+    size -= copy_size;
+    length_ += copy_size;
+    new_slice_needed = true;
+  }
+}
+
+void OwnedImpl::addBufferFragment(BufferFragment& fragment) {
+  if (old_impl_) {
+    evbuffer_add_reference(
+        buffer_.get(), fragment.data(), fragment.size(),
+        [](const void*, size_t, void* arg) { static_cast<BufferFragment*>(arg)->done(); },
+        &fragment);
+    return;
+  }
+
+  length_ += fragment.size();
+  slices_.emplace_back(std::make_unique<UnownedSlice>(fragment));
+}
+
+void OwnedImpl::add(const std::string& data) { add(data.data(), data.size()); }
+
 void OwnedImpl::add(const Instance& data) {
   uint64_t num_slices = data.getRawSlices(nullptr, 0);
   RawSlice slices[num_slices];
@@ -41,57 +94,284 @@ void OwnedImpl::add(const Instance& data) {
   }
 }
 
+void OwnedImpl::prepend(absl::string_view data) {
+  if (old_impl_) {
+    int rc = evbuffer_prepend(buffer_.get(), data.data(), data.size());
+    ASSERT(rc == 0);
+    return;
+  }
+
+  uint64_t size = data.size();
+  bool new_slice_needed = slices_.empty();
+  while (size != 0) {
+    if (new_slice_needed) {
+      slices_.emplace_front(OwnedSlice::create(size));
+    }
+    const uint64_t copy_size = slices_.front()->prepend(data.data(), size);
+    size -= copy_size;
+    length_ += copy_size;
+    new_slice_needed = true;
+  }
+}
+
+void OwnedImpl::prepend(Instance& data) {
+  ASSERT(&data != this);
+  ASSERT(isSameBufferImpl(data));
+  // See the comments in move() for why we do the static_cast.
+  if (old_impl_) {
+    int rc =
+        evbuffer_prepend_buffer(buffer_.get(), static_cast<LibEventInstance&>(data).buffer().get());
+    ASSERT(rc == 0);
+    ASSERT(data.length() == 0);
+    static_cast<LibEventInstance&>(data).postProcess();
+    return;
+  }
+
+  OwnedImpl& other = static_cast<OwnedImpl&>(data);
+  while (!other.slices_.empty()) {
+    const uint64_t slice_size = other.slices_.back()->dataSize();
+    if (slice_size != 0) {
+      length_ += slice_size;
+      slices_.emplace_front(std::move(other.slices_.back()));
+    }
+    other.slices_.pop_back();
+    other.length_ -= slice_size;
+  }
+  ASSERT(other.length_ == 0);
+  other.postProcess();
+}
+
 void OwnedImpl::commit(RawSlice* iovecs, uint64_t num_iovecs) {
-  int rc =
-      evbuffer_commit_space(buffer_.get(), reinterpret_cast<evbuffer_iovec*>(iovecs), num_iovecs);
-  ASSERT(rc == 0);
+  if (old_impl_) {
+    int rc =
+        evbuffer_commit_space(buffer_.get(), reinterpret_cast<evbuffer_iovec*>(iovecs), num_iovecs);
+    ASSERT(rc == 0);
+    return;
+  }
+
+  if (num_iovecs == 0 || slices_.empty()) {
+    return;
+  }
+  // Find the slices in the buffer that correspond to the iovecs:
+  // First, scan backward from the end of the buffer to find the last slice containing any content.
+  // Reservations are made from the end of the buffer, and out-of-order commits aren't supported,
+  // so any slices before this point cannot match the iovecs being committed.
+  ssize_t slice_index = static_cast<ssize_t>(slices_.size()) - 1;
+  while (slice_index >= 0 && slices_[slice_index]->dataSize() == 0) {
+    slice_index--;
+  }
+  if (slice_index < 0) {
+    // There was no slice containing any data, so rewind the iterator at the first slice.
+    slice_index = 0;
+  }
+
+  // Next, scan forward and attempt to match the slices against iovecs.
+  uint64_t num_slices_committed = 0;
+  while (num_slices_committed < num_iovecs && static_cast<size_t>(slice_index) < slices_.size()) {
+    if (slices_[slice_index]->commit(iovecs[num_slices_committed])) {
+      length_ += iovecs[num_slices_committed].len_;
+      num_slices_committed++;
+    }
+    slice_index++;
+  }
+
+  ASSERT(num_slices_committed > 0);
 }
 
 void OwnedImpl::copyOut(size_t start, uint64_t size, void* data) const {
-  ASSERT(start + size <= length());
+  if (old_impl_) {
+    ASSERT(start + size <= length());
 
-  evbuffer_ptr start_ptr;
-  int rc = evbuffer_ptr_set(buffer_.get(), &start_ptr, start, EVBUFFER_PTR_SET);
-  ASSERT(rc != -1);
+    evbuffer_ptr start_ptr;
+    int rc = evbuffer_ptr_set(buffer_.get(), &start_ptr, start, EVBUFFER_PTR_SET);
+    ASSERT(rc != -1);
+
+    ev_ssize_t copied = evbuffer_copyout_from(buffer_.get(), &start_ptr, data, size);
+    ASSERT(static_cast<uint64_t>(copied) == size);
+    return;
+  }
 
-  ev_ssize_t copied = evbuffer_copyout_from(buffer_.get(), &start_ptr, data, size);
-  ASSERT(static_cast<uint64_t>(copied) == size);
+  uint64_t bytes_to_skip = start;
+  uint8_t* dest = static_cast<uint8_t*>(data);
+  for (size_t slice_index = 0; slice_index < slices_.size() && size != 0; slice_index++) {
+    const auto& slice = slices_[slice_index];
+    uint64_t data_size = slice->dataSize();
+    if (data_size <= bytes_to_skip) {
+      // The offset where the caller wants to start copying is after the end of this slice,
+      // so just skip over this slice completely.
+      bytes_to_skip -= data_size;
+      continue;
+    }
+    uint64_t copy_size = std::min(size, data_size - bytes_to_skip);
+    memcpy(dest, slice->data() + bytes_to_skip, copy_size);
+    size -= copy_size;
+    dest += copy_size;
+    // Now that we've started copying, there are no bytes left to skip over. If there
+    // is any more data to be copied, the next iteration can start copying from the very
+    // beginning of the next slice.
+    bytes_to_skip = 0;
+  }
+  ASSERT(size == 0);
 }
 
 void OwnedImpl::drain(uint64_t size) {
-  ASSERT(size <= length());
-  int rc = evbuffer_drain(buffer_.get(), size);
-  ASSERT(rc == 0);
+  if (old_impl_) {
+    ASSERT(size <= length());
+    int rc = evbuffer_drain(buffer_.get(), size);
+    ASSERT(rc == 0);
+    return;
+  }
+
+  ASSERT(size <= length_);
+  while (size != 0) {
+    if (slices_.empty()) {
+      break;
+    }
+    const uint64_t slice_size = slices_.front()->dataSize();
+    if (slice_size <= size) {
+      slices_.pop_front();
+      length_ -= slice_size;
+      size -= slice_size;
+    } else {
+      slices_.front()->drain(size);
+      length_ -= size;
+      size = 0;
+    }
+  }
 }
 
 uint64_t OwnedImpl::getRawSlices(RawSlice* out, uint64_t out_size) const {
-  return evbuffer_peek(buffer_.get(), -1, nullptr, reinterpret_cast<evbuffer_iovec*>(out),
-                       out_size);
+  if (old_impl_) {
+    return evbuffer_peek(buffer_.get(), -1, nullptr, reinterpret_cast<evbuffer_iovec*>(out),
+                         out_size);
+  }
+
+  uint64_t num_slices = 0;
+  for (size_t slice_index = 0; slice_index < slices_.size(); slice_index++) {
+    const auto& slice = slices_[slice_index];
+    if (slice->dataSize() == 0) {
+      continue;
+    }
+    if (num_slices < out_size) {
+      out[num_slices].mem_ = slice->data();
+      out[num_slices].len_ = slice->dataSize();
+    }
+    // Per the definition of getRawSlices in include/envoy/buffer/buffer.h, we need to return
+    // the total number of slices needed to access all the data in the buffer, which can be
+    // larger than out_size. So we keep iterating and counting non-empty slices here, even
+    // if all the caller-supplied slices have been filled.
+    num_slices++;
+  }
+  return num_slices;
 }
 
-uint64_t OwnedImpl::length() const { return evbuffer_get_length(buffer_.get()); }
+uint64_t OwnedImpl::length() const {
+  if (old_impl_) {
+    return evbuffer_get_length(buffer_.get());
+  }
+  return length_;
+}
 
 void* OwnedImpl::linearize(uint32_t size) {
-  ASSERT(size <= length());
-  return evbuffer_pullup(buffer_.get(), size);
+  if (old_impl_) {
+    ASSERT(size <= length());
+    return evbuffer_pullup(buffer_.get(), size);
+  }
+
+  RELEASE_ASSERT(size <= length_);
+  // Empty slices at the front can only be left behind by reservations that were never committed,
+  // so it is safe to discard them here.
+  while (!slices_.empty() && slices_.front()->dataSize() == 0) {
+    slices_.pop_front();
+  }
+  if (slices_.empty()) {
+    return nullptr;
+  }
+  if (slices_.front()->dataSize() >= size) {
+    // Fast path: the requested data is already contiguous in the first slice.
+    return slices_.front()->data();
+  }
+
+  uint64_t linearized_size = 0;
+  uint64_t num_slices_to_linearize = 0;
+  for (size_t slice_index = 0; slice_index < slices_.size(); slice_index++) {
+    linearized_size += slices_[slice_index]->dataSize();
+    num_slices_to_linearize++;
+    if (linearized_size >= size) {
+      break;
+    }
+  }
+  ASSERT(num_slices_to_linearize > 1);
+
+  // Copy the whole of each affected slice, so that the remainder of the buffer stays intact and
+  // the new first slice can be used for further contiguous reads.
+  SlicePtr new_slice = OwnedSlice::create(linearized_size);
+  for (uint64_t i = 0; i < num_slices_to_linearize; i++) {
+    new_slice->append(slices_.front()->data(), slices_.front()->dataSize());
+    slices_.pop_front();
+  }
+  ASSERT(new_slice->dataSize() == linearized_size);
+  slices_.emplace_front(std::move(new_slice));
+  return slices_.front()->data();
 }
 
 void OwnedImpl::move(Instance& rhs) {
-  // We do the static cast here because in practice we only have one buffer implementation right
-  // now and this is safe. Using the evbuffer move routines require having access to both evbuffers.
-  // This is a reasonable compromise in a high performance path where we want to maintain an
-  // abstraction in case we get rid of evbuffer later.
-  int rc = evbuffer_add_buffer(buffer_.get(), static_cast<LibEventInstance&>(rhs).buffer().get());
-  ASSERT(rc == 0);
-  static_cast<LibEventInstance&>(rhs).postProcess();
+  ASSERT(&rhs != this);
+  ASSERT(isSameBufferImpl(rhs));
+  if (old_impl_) {
+    // We do the static cast here because in practice we only have one buffer implementation right
+    // now and this is safe. Using the evbuffer move routines require having access to both
+    // evbuffers. This is a reasonable compromise in a high performance path where we want to
+    // maintain an abstraction in case we get rid of evbuffer later.
+    int rc = evbuffer_add_buffer(buffer_.get(), static_cast<LibEventInstance&>(rhs).buffer().get());
+    ASSERT(rc == 0);
+    static_cast<LibEventInstance&>(rhs).postProcess();
+    return;
+  }
+
+  // Same reasoning as above: transferring slices requires access to the other buffer's deque.
+  OwnedImpl& other = static_cast<OwnedImpl&>(rhs);
+  while (!other.slices_.empty()) {
+    const uint64_t slice_size = other.slices_.front()->dataSize();
+    appendSlice(std::move(other.slices_.front()));
+    other.slices_.pop_front();
+    other.length_ -= slice_size;
+  }
+  ASSERT(other.length_ == 0);
+  other.postProcess();
 }
 
 void OwnedImpl::move(Instance& rhs, uint64_t length) {
-  // See move() above for why we do the static cast.
-  int rc = evbuffer_remove_buffer(static_cast<LibEventInstance&>(rhs).buffer().get(), buffer_.get(),
-                                  length);
-  ASSERT(static_cast<uint64_t>(rc) == length);
-  static_cast<LibEventInstance&>(rhs).postProcess();
+  ASSERT(&rhs != this);
+  ASSERT(isSameBufferImpl(rhs));
+  if (old_impl_) {
+    // See move() above for why we do the static cast.
+    int rc = evbuffer_remove_buffer(static_cast<LibEventInstance&>(rhs).buffer().get(),
+                                    buffer_.get(), length);
+    ASSERT(static_cast<uint64_t>(rc) == length);
+    static_cast<LibEventInstance&>(rhs).postProcess();
+    return;
+  }
+
+  OwnedImpl& other = static_cast<OwnedImpl&>(rhs);
+  while (length != 0 && !other.slices_.empty()) {
+    const uint64_t slice_size = other.slices_.front()->dataSize();
+    if (slice_size <= length) {
+      // Whole slices are transferred without copying the data.
+      appendSlice(std::move(other.slices_.front()));
+      other.slices_.pop_front();
+      other.length_ -= slice_size;
+      length -= slice_size;
+    } else {
+      // Only part of this slice is needed, so copy that part and leave the rest behind.
+      add(other.slices_.front()->data(), length);
+      other.slices_.front()->drain(length);
+      other.length_ -= length;
+      length = 0;
+    }
+  }
+  ASSERT(length == 0);
+  other.postProcess();
 }
 
 int OwnedImpl::read(int fd, uint64_t max_length) {
@@ -134,48 +414,237 @@ int OwnedImpl::read(int fd, uint64_t max_length) {
 }
 
 uint64_t OwnedImpl::reserve(uint64_t length, RawSlice* iovecs, uint64_t num_iovecs) {
-  uint64_t ret = evbuffer_reserve_space(buffer_.get(), length,
-                                        reinterpret_cast<evbuffer_iovec*>(iovecs), num_iovecs);
-  ASSERT(ret >= 1);
-  return ret;
+  if (old_impl_) {
+    uint64_t ret = evbuffer_reserve_space(buffer_.get(), length,
+                                          reinterpret_cast<evbuffer_iovec*>(iovecs), num_iovecs);
+    ASSERT(ret >= 1);
+    return ret;
+  }
+
+  if (num_iovecs == 0 || length == 0) {
+    return 0;
+  }
+
+  // Check whether there are any empty slices with reservable space at the end of the buffer.
+  size_t first_reservable_slice = slices_.size();
+  while (first_reservable_slice > 0) {
+    if (slices_[first_reservable_slice - 1]->reservableSize() == 0) {
+      break;
+    }
+    first_reservable_slice--;
+    if (slices_[first_reservable_slice]->dataSize() != 0) {
+      // There is some content in this slice, so anything in front of it is non-reservable.
+      break;
+    }
+  }
+
+  // Having found the sequence of reservable slices at the back of the buffer, reserve
+  // as much space as possible from each one.
+  uint64_t num_slices_used = 0;
+  uint64_t bytes_remaining = length;
+  size_t slice_index = first_reservable_slice;
+  while (slice_index < slices_.size() && bytes_remaining != 0 && num_slices_used < num_iovecs) {
+    auto& slice = slices_[slice_index];
+    const uint64_t reservation_size = std::min(slice->reservableSize(), bytes_remaining);
+    if (num_slices_used + 1 == num_iovecs && reservation_size < bytes_remaining) {
+      // There is only one iovec left, and this next slice does not have enough space to
+      // complete the reservation. Stop iterating, with last one iovec still unpopulated,
+      // so the code following this loop can allocate a new slice to hold the rest of the
+      // reservation.
+      break;
+    }
+    iovecs[num_slices_used] = slice->reserve(reservation_size);
+    bytes_remaining -= iovecs[num_slices_used].len_;
+    num_slices_used++;
+    slice_index++;
+  }
+
+  // If needed, allocate one more slice at the end to provide the remainder of the reservation.
+  if (bytes_remaining != 0) {
+    slices_.emplace_back(OwnedSlice::create(bytes_remaining));
+    iovecs[num_slices_used] = slices_.back()->reserve(bytes_remaining);
+    bytes_remaining -= iovecs[num_slices_used].len_;
+    num_slices_used++;
+  }
+
+  ASSERT(num_slices_used <= num_iovecs);
+  ASSERT(bytes_remaining == 0);
+  return num_slices_used;
 }
 
 ssize_t OwnedImpl::search(const void* data, uint64_t size, size_t start) const {
-  evbuffer_ptr start_ptr;
-  if (-1 == evbuffer_ptr_set(buffer_.get(), &start_ptr, start, EVBUFFER_PTR_SET)) {
-    return -1;
+  if (old_impl_) {
+    evbuffer_ptr start_ptr;
+    if (-1 == evbuffer_ptr_set(buffer_.get(), &start_ptr, start, EVBUFFER_PTR_SET)) {
+      return -1;
+    }
+
+    evbuffer_ptr result_ptr =
+        evbuffer_search(buffer_.get(), static_cast<const char*>(data), size, &start_ptr);
+    return result_ptr.pos;
   }
 
-  evbuffer_ptr result_ptr =
-      evbuffer_search(buffer_.get(), static_cast<const char*>(data), size, &start_ptr);
-  return result_ptr.pos;
+  // This implementation uses the same search algorithm as evbuffer_search(), a naive
+  // scan that requires O(M*N) comparisons in the worst case.
+  if (size == 0) {
+    return (start <= length_) ? start : -1;
+  }
+  ssize_t offset = 0;
+  const uint8_t* needle = static_cast<const uint8_t*>(data);
+  for (size_t slice_index = 0; slice_index < slices_.size(); slice_index++) {
+    const auto& slice = slices_[slice_index];
+    const uint64_t slice_size = slice->dataSize();
+    if (slice_size <= start) {
+      start -= slice_size;
+      offset += slice_size;
+      continue;
+    }
+    const uint8_t* slice_start = slice->data();
+    const uint8_t* haystack = slice_start + start;
+    const uint8_t* haystack_end = slice_start + slice_size;
+    while (haystack < haystack_end) {
+      // Search within this slice for the first byte of the needle.
+      const uint8_t* first_byte_match =
+          static_cast<const uint8_t*>(memchr(haystack, needle[0], haystack_end - haystack));
+      if (first_byte_match == nullptr) {
+        break;
+      }
+      // After finding a match for the first byte of the needle, check whether the following
+      // bytes in the buffer match the remainder of the needle. Note that the match can span
+      // two or more slices.
+      size_t i = 1;
+      size_t match_index = slice_index;
+      const uint8_t* match_next = first_byte_match + 1;
+      const uint8_t* match_end = haystack_end;
+      while (i < size) {
+        if (match_next >= match_end) {
+          // We've hit the end of this slice, so continue checking against the next slice.
+          match_index++;
+          if (match_index == slices_.size()) {
+            // We've hit the end of the entire buffer.
+            break;
+          }
+          const auto& match_slice = slices_[match_index];
+          match_next = match_slice->data();
+          match_end = match_next + match_slice->dataSize();
+          continue;
+        }
+        if (*match_next++ != needle[i]) {
+          break;
+        }
+        i++;
+      }
+      if (i == size) {
+        // Successful match of the entire needle.
+        return offset + (first_byte_match - slice_start);
+      }
+      // If this wasn't a successful match, start scanning again at the next byte.
+      haystack = first_byte_match + 1;
+    }
+    start = 0;
+    offset += slice_size;
+  }
+  return -1;
 }
 
-int OwnedImpl::write(int fd) {
-  constexpr uint64_t MaxSlices = 16;
-  RawSlice slices[MaxSlices];
-  const uint64_t num_slices = std::min(getRawSlices(slices, MaxSlices), MaxSlices);
-  struct iovec iov[num_slices];
-  uint64_t num_slices_to_write = 0;
-  for (uint64_t i = 0; i < num_slices; i++) {
-    if (slices[i].mem_ != nullptr && slices[i].len_ != 0) {
-      iov[num_slices_to_write].iov_base = slices[i].mem_;
-      iov[num_slices_to_write].iov_len = slices[i].len_;
-      num_slices_to_write++;
+uint64_t OwnedImpl::fillIovecs(iovec* iov, uint64_t max_iov) const {
+  uint64_t num_iov = 0;
+  if (old_impl_) {
+    RawSlice slices[max_iov];
+    const uint64_t num_slices = std::min(getRawSlices(slices, max_iov), max_iov);
+    for (uint64_t i = 0; i < num_slices; i++) {
+      if (slices[i].mem_ != nullptr && slices[i].len_ != 0) {
+        iov[num_iov].iov_base = slices[i].mem_;
+        iov[num_iov].iov_len = slices[i].len_;
+        num_iov++;
+      }
+    }
+    return num_iov;
+  }
+
+  for (size_t i = 0; i < slices_.size() && num_iov < max_iov; i++) {
+    const auto& slice = slices_[i];
+    if (slice->dataSize() != 0) {
+      iov[num_iov].iov_base = const_cast<uint8_t*>(slice->data());
+      iov[num_iov].iov_len = slice->dataSize();
+      num_iov++;
     }
   }
-  if (num_slices_to_write == 0) {
+  return num_iov;
+}
+
+int OwnedImpl::write(int fd) {
+  // Gather as many slices as a single writev() accepts, so that a buffer built up from many
+  // small writes still goes out in a single system call.
+  const uint64_t num_slices = getRawSlices(nullptr, 0);
+  const uint64_t max_iov = num_slices < MaxWriteSlices ? num_slices : MaxWriteSlices;
+  if (max_iov == 0) {
+    return 0;
+  }
+  iovec iov[max_iov];
+  const uint64_t num_iov = fillIovecs(iov, max_iov);
+  if (num_iov == 0) {
     return 0;
   }
   auto& os_syscalls = Api::OsSysCallsSingleton::get();
-  const ssize_t rc = os_syscalls.writev(fd, iov, num_slices_to_write);
+  const ssize_t rc = os_syscalls.writev(fd, iov, num_iov);
   if (rc > 0) {
     drain(static_cast<uint64_t>(rc));
   }
   return static_cast<int>(rc);
 }
 
-OwnedImpl::OwnedImpl() : buffer_(evbuffer_new()) {}
+int OwnedImpl::writeRetained(int fd, int flags, std::vector<SlicePtr>& written) {
+  ASSERT(!old_impl_);
+  const uint64_t max_iov = slices_.size() < MaxWriteSlices ? slices_.size() : MaxWriteSlices;
+  if (max_iov == 0) {
+    return 0;
+  }
+  iovec iov[max_iov];
+  const uint64_t num_iov = fillIovecs(iov, max_iov);
+  if (num_iov == 0) {
+    return 0;
+  }
+  msghdr message{};
+  message.msg_iov = iov;
+  message.msg_iovlen = num_iov;
+  auto& os_syscalls = Api::OsSysCallsSingleton::get();
+  const ssize_t rc = os_syscalls.sendmsg(fd, &message, flags);
+  if (rc <= 0) {
+    return static_cast<int>(rc);
+  }
+
+  uint64_t bytes_remaining = rc;
+  while (bytes_remaining != 0) {
+    ASSERT(!slices_.empty());
+    const uint64_t slice_size = slices_.front()->dataSize();
+    if (slice_size <= bytes_remaining) {
+      if (slice_size != 0) {
+        written.emplace_back(std::move(slices_.front()));
+      }
+      slices_.pop_front();
+      length_ -= slice_size;
+      bytes_remaining -= slice_size;
+    } else {
+      // The written part must stay where it is until the caller releases it, so share the slice
+      // between the caller and this buffer rather than copying the unwritten part.
+      std::shared_ptr<Slice> owner(std::move(slices_.front()));
+      uint8_t* data = owner->data();
+      written.emplace_back(std::make_unique<SharedSlice>(owner, data, bytes_remaining));
+      slices_.front() = std::make_unique<SharedSlice>(owner, data + bytes_remaining,
+                                                      slice_size - bytes_remaining);
+      length_ -= bytes_remaining;
+      bytes_remaining = 0;
+    }
+  }
+  // The slices were moved out rather than drained, so let subclasses, e.g. WatermarkBuffer, see
+  // the new length.
+  postProcess();
+  return static_cast<int>(rc);
+}
+
+OwnedImpl::OwnedImpl()
+    : old_impl_(use_old_impl_), buffer_(old_impl_ ? evbuffer_new() : nullptr) {}
 
 OwnedImpl::OwnedImpl(const std::string& data) : OwnedImpl() { add(data); }
 
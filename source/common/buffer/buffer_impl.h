@@ -1,16 +1,353 @@
 #pragma once
 
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <climits>
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
 
+#include "common/buffer/slice_pool.h"
+#include "common/common/assert.h"
 #include "common/common/non_copyable.h"
 #include "common/event/libevent.h"
 
 namespace Envoy {
 namespace Buffer {
 
+/**
+ * A Slice manages a contiguous block of bytes.
+ * The block is arranged like this:
+ *                   |<- dataSize() ->|<- reservableSize() ->|
+ * +-----------------+----------------+----------------------+
+ * | Drained         | Data           | Reservable           |
+ * | Unused space    | Usable content | New content can be   |
+ * | that formerly   |                | added here with      |
+ * | was in the Data |                | reserve()/commit()   |
+ * | section         |                | or append()          |
+ * +-----------------+----------------+----------------------+
+ *                   ^                ^                      ^
+ *                   |                |                      |
+ *                   base_ + data_    base_ + reservable_    base_ + capacity_
+ */
+class Slice {
+public:
+  virtual ~Slice() {}
+
+  /**
+   * @return a pointer to the start of the usable content.
+   */
+  const uint8_t* data() const { return base_ + data_; }
+
+  /**
+   * @return a pointer to the start of the usable content.
+   */
+  uint8_t* data() { return base_ + data_; }
+
+  /**
+   * @return the size in bytes of the usable content.
+   */
+  uint64_t dataSize() const { return reservable_ - data_; }
+
+  /**
+   * Remove the first `size` bytes of usable content. Runs in O(1) time.
+   * @param size number of bytes to remove. If greater than dataSize(), the result is undefined.
+   */
+  void drain(uint64_t size) {
+    ASSERT(data_ + size <= reservable_);
+    data_ += size;
+  }
+
+  /**
+   * @return the number of bytes available to be reserved or appended.
+   * @note Read-only implementations of Slice should return zero from this method.
+   */
+  uint64_t reservableSize() const { return capacity_ - reservable_; }
+
+  /**
+   * Reserve `size` bytes that the caller can populate with content. The caller SHOULD then
+   * call commit() to add the newly populated content from the Reserved section to the Data
+   * section. As with evbuffer, a reservation is invalidated by any other operation that adds
+   * content to the slice.
+   * @param size the number of bytes to reserve. The Slice implementation MAY reserve fewer bytes
+   *             than requested (for example, if it doesn't have enough room in the Reservable
+   *             section to fulfill the whole request).
+   * @return a RawSlice describing the reservation, or {nullptr, 0} if no space is reservable.
+   */
+  RawSlice reserve(uint64_t size) {
+    const uint64_t reservation_size = std::min(size, reservableSize());
+    if (reservation_size == 0) {
+      return {nullptr, 0};
+    }
+    return {base_ + reservable_, static_cast<size_t>(reservation_size)};
+  }
+
+  /**
+   * Commit a Reservation that was previously obtained from a call to reserve().
+   * The Reservation's size is added to the Data section.
+   * @param reservation a reservation obtained from a previous call to reserve().
+   *        If the reservation is not from this Slice, commit() will return false.
+   *        If the caller is committing fewer bytes than provided by reserve(), it
+   *        should change the len_ field of the reservation before calling commit().
+   *        For example, if a caller reserve()s 4KB to do a nonblocking socket read,
+   *        and the read only returns two bytes, the caller should set
+   *        reservation.len_ = 2 and then call `commit(reservation)`.
+   * @return whether the Reservation was successfully committed to the Slice.
+   */
+  bool commit(const RawSlice& reservation) {
+    if (static_cast<const uint8_t*>(reservation.mem_) != base_ + reservable_ ||
+        reservation.len_ > reservableSize()) {
+      // The reservation is not from this Slice.
+      return false;
+    }
+    reservable_ += reservation.len_;
+    return true;
+  }
+
+  /**
+   * Copy as much of the supplied data as possible to the end of the slice.
+   * @param data start of the data to copy.
+   * @param size number of bytes to copy.
+   * @return number of bytes copied (may be smaller than size, may even be zero).
+   */
+  uint64_t append(const void* data, uint64_t size) {
+    const uint64_t copy_size = std::min(size, reservableSize());
+    if (copy_size != 0) {
+      memcpy(base_ + reservable_, data, copy_size);
+      reservable_ += copy_size;
+    }
+    return copy_size;
+  }
+
+  /**
+   * Copy as much of the supplied data as possible to the front of the slice.
+   * If only part of the data will fit in the slice, the bytes from the _end_ are
+   * copied.
+   * @param data start of the data to copy.
+   * @param size number of bytes to copy.
+   * @return number of bytes copied (may be smaller than size, may even be zero).
+   */
+  uint64_t prepend(const void* data, uint64_t size) {
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    uint64_t copy_size;
+    if (dataSize() == 0 && reservableSize() != 0) {
+      // There is nothing in the slice, so put the data at the very end in case the caller
+      // later tries to prepend anything else in front of it.
+      copy_size = std::min(size, capacity_);
+      reservable_ = capacity_;
+      data_ = capacity_ - copy_size;
+    } else {
+      copy_size = std::min(size, data_);
+      data_ -= copy_size;
+    }
+    if (copy_size != 0) {
+      memcpy(base_ + data_, src + size - copy_size, copy_size);
+    }
+    return copy_size;
+  }
+
+protected:
+  Slice(uint64_t data, uint64_t reservable, uint64_t capacity)
+      : data_(data), reservable_(reservable), capacity_(capacity) {}
+
+  // Start of the slice. Subclasses must set base_.
+  uint8_t* base_{nullptr};
+
+  // Offset in bytes from the start of the slice to the start of the Data section.
+  uint64_t data_;
+
+  // Offset in bytes from the start of the slice to the start of the Reservable section.
+  uint64_t reservable_;
+
+  // Total number of bytes in the slice.
+  uint64_t capacity_;
+};
+
+typedef std::unique_ptr<Slice> SlicePtr;
+
+/**
+ * A Slice whose storage is allocated inline with the Slice object itself, so that creating a
+ * slice costs a single heap allocation. Capacities are rounded up so that the whole allocation
+ * (header plus storage) is a multiple of PageSize; this keeps slices in a small number of fixed
+ * size classes, which is friendlier to the allocator than exact-sized blocks.
+ */
+class OwnedSlice : public Slice {
+public:
+  // The size granularity of slices. A buffer that only ever holds small amounts of data
+  // will use a single slice of this size.
+  static constexpr uint64_t PageSize = 4096;
+
+  /**
+   * Create an empty OwnedSlice.
+   * @param capacity number of bytes of space the slice should have.
+   * @return an OwnedSlice with at least the specified capacity.
+   */
+  static SlicePtr create(uint64_t capacity) {
+    const uint64_t slice_capacity = sliceSize(capacity);
+    return SlicePtr(new (slice_capacity) OwnedSlice(slice_capacity));
+  }
+
+  /**
+   * Create an OwnedSlice and initialize it with a copy of the supplied data.
+   * @param data the content to copy into the slice.
+   * @param size length of the content.
+   * @return an OwnedSlice containing a copy of the content, which may (dependent on
+   *         the internal implementation) have a nonzero amount of reservable space at the end.
+   */
+  static SlicePtr create(const void* data, uint64_t size) {
+    SlicePtr slice = create(size);
+    slice->append(data, size);
+    return slice;
+  }
+
+  // Storage is allocated together with the object, so plain new/delete must not be used. The
+  // memory comes from the current thread's SlicePool, if any.
+  static void* operator new(size_t object_size, size_t data_size) {
+    return SlicePool::allocate(object_size + data_size);
+  }
+  static void operator delete(void* address) { SlicePool::release(address); }
+
+private:
+  OwnedSlice(uint64_t size) : Slice(0, 0, size) { base_ = storage_; }
+
+  /**
+   * Compute a slice size big enough to hold a specified amount of data.
+   * @param data_size the minimum amount of data the slice must be able to store, in bytes.
+   * @return a recommended slice size, in bytes.
+   */
+  static uint64_t sliceSize(uint64_t data_size) {
+    constexpr uint64_t header_size = sizeof(OwnedSlice) + SlicePool::BlockOverhead;
+    const uint64_t num_pages = (header_size + data_size + PageSize - 1) / PageSize;
+    return num_pages * PageSize - header_size;
+  }
+
+  uint8_t storage_[];
+};
+
+/**
+ * A read-only Slice that references externally owned data supplied through a BufferFragment.
+ * The fragment's done() is called when the slice is destroyed.
+ */
+class UnownedSlice : public Slice {
+public:
+  UnownedSlice(BufferFragment& fragment)
+      : Slice(0, fragment.size(), fragment.size()), fragment_(fragment) {
+    base_ = static_cast<uint8_t*>(const_cast<void*>(fragment.data()));
+  }
+
+  ~UnownedSlice() override { fragment_.done(); }
+
+private:
+  BufferFragment& fragment_;
+};
+
+/**
+ * A read-only Slice that references part of another slice, sharing ownership of it. This splits a
+ * slice without copying when different parts of it need different lifetimes.
+ */
+class SharedSlice : public Slice {
+public:
+  SharedSlice(std::shared_ptr<Slice> owner, uint8_t* data, uint64_t size)
+      : Slice(0, size, size), owner_(std::move(owner)) {
+    base_ = data;
+  }
+
+private:
+  const std::shared_ptr<Slice> owner_;
+};
+
+/**
+ * Queue of SlicePtr that supports efficient read and write access to both the front and the back
+ * of the queue.
+ * @note This class has similar properties to std::deque<SlicePtr>. A custom implementation is
+ *       used because std::deque allocates its block map and first block as soon as it is
+ *       constructed, which is a heap allocation per buffer even for the many buffers that only
+ *       ever hold a handful of slices. Up to InlineRingCapacity slices are stored inline.
+ */
+class SliceDeque : NonCopyable {
+public:
+  SliceDeque() : ring_(inline_ring_), capacity_(InlineRingCapacity) {}
+
+  void emplace_back(SlicePtr&& slice) {
+    growRing();
+    ring_[internalIndex(size_)] = std::move(slice);
+    size_++;
+  }
+
+  void emplace_front(SlicePtr&& slice) {
+    growRing();
+    start_ = (start_ == 0) ? capacity_ - 1 : start_ - 1;
+    ring_[start_] = std::move(slice);
+    size_++;
+  }
+
+  bool empty() const { return size() == 0; }
+  size_t size() const { return size_; }
+
+  SlicePtr& front() { return ring_[start_]; }
+  const SlicePtr& front() const { return ring_[start_]; }
+  SlicePtr& back() { return ring_[internalIndex(size_ - 1)]; }
+  const SlicePtr& back() const { return ring_[internalIndex(size_ - 1)]; }
+
+  SlicePtr& operator[](size_t i) { return ring_[internalIndex(i)]; }
+  const SlicePtr& operator[](size_t i) const { return ring_[internalIndex(i)]; }
+
+  void pop_front() {
+    ASSERT(size_ != 0);
+    front().reset();
+    size_--;
+    start_++;
+    if (start_ == capacity_) {
+      start_ = 0;
+    }
+  }
+
+  void pop_back() {
+    ASSERT(size_ != 0);
+    back().reset();
+    size_--;
+  }
+
+private:
+  static constexpr size_t InlineRingCapacity = 8;
+
+  size_t internalIndex(size_t index) const {
+    size_t internal_index = start_ + index;
+    if (internal_index >= capacity_) {
+      internal_index -= capacity_;
+      ASSERT(internal_index < capacity_);
+    }
+    return internal_index;
+  }
+
+  void growRing() {
+    if (size_ < capacity_) {
+      return;
+    }
+    const size_t new_capacity = capacity_ * 2;
+    std::unique_ptr<SlicePtr[]> new_ring(new SlicePtr[new_capacity]);
+    for (size_t i = 0; i < size_; i++) {
+      new_ring[i] = std::move(ring_[internalIndex(i)]);
+    }
+    external_ring_.swap(new_ring);
+    ring_ = external_ring_.get();
+    start_ = 0;
+    capacity_ = new_capacity;
+  }
+
+  SlicePtr inline_ring_[InlineRingCapacity];
+  std::unique_ptr<SlicePtr[]> external_ring_;
+  SlicePtr* ring_; // points to start of either inline or external ring.
+  size_t start_{0};
+  size_t size_{0};
+  size_t capacity_;
+};
+
 /**
  * An implementation of BufferFragment where a releasor callback is called when the data is
  * no longer needed.
@@ -55,10 +392,14 @@ public:
 };
 
 /**
- * Wraps an allocated and owned evbuffer.
+ * Buffer implementation with two interchangeable backends: the original wrapper around an
+ * allocated and owned evbuffer, and a native implementation built on a SliceDeque of Slices. The
+ * backend is chosen process-wide with useOldImpl() and captured by each buffer when it is
+ * constructed.
  *
- * Note that due to the internals of move() accessing buffer(), OwnedImpl is not
- * compatible with non-LibEventInstance buffers.
+ * Note that due to the internals of move() accessing buffer() or the slices of the other buffer,
+ * OwnedImpl is not compatible with non-OwnedImpl buffers, nor with OwnedImpl buffers using the
+ * other backend.
  */
 class OwnedImpl : public LibEventInstance {
 public:
@@ -72,6 +413,8 @@ public:
   void addBufferFragment(BufferFragment& fragment) override;
   void add(const std::string& data) override;
   void add(const Instance& data) override;
+  void prepend(absl::string_view data) override;
+  void prepend(Instance& data) override;
   void commit(RawSlice* iovecs, uint64_t num_iovecs) override;
   void copyOut(size_t start, uint64_t size, void* data) const override;
   void drain(uint64_t size) override;
@@ -89,8 +432,81 @@ public:
 
   Event::Libevent::BufferPtr& buffer() override { return buffer_; }
 
+  /**
+   * Select the buffer backend for all OwnedImpl instances constructed after this call. This is
+   * intended to be called once at startup, before any buffers are created.
+   * @param use_old_impl true to use the evbuffer-backed implementation, false to use the native
+   *        slice-based implementation.
+   */
+  static void useOldImpl(bool use_old_impl);
+
+  /**
+   * @return whether newly constructed buffers use the evbuffer-backed implementation.
+   */
+  static bool newBuffersUseOldImpl();
+
+  /**
+   * @return whether this buffer uses the evbuffer-backed implementation.
+   */
+  bool usesOldImpl() const { return old_impl_; }
+
+  /**
+   * Write data to a socket with sendmsg(), keeping the memory holding the written data alive by
+   * handing it to the caller instead of freeing it. This is intended for MSG_ZEROCOPY, where the
+   * kernel keeps transmitting from the buffer's memory after the call returns. A partially
+   * written slice is split so that its unwritten part stays in this buffer. Only supported by the
+   * native slice-based implementation.
+   * @param fd supplies the socket to write to.
+   * @param flags supplies the sendmsg() flags.
+   * @param written receives the slices holding the written data.
+   * @return the sendmsg() result.
+   */
+  int writeRetained(int fd, int flags, std::vector<SlicePtr>& written);
+
 private:
+  /**
+   * @param rhs another buffer.
+   * @return whether the rhs buffer is also an instance of OwnedImpl (or a subclass) that uses
+   *         the same internal implementation as this buffer.
+   */
+  bool isSameBufferImpl(const Instance& rhs) const;
+
+  /**
+   * Move a slice into the back of this buffer. Small slices are copied into the spare capacity
+   * of the last slice instead, which keeps buffers built from many small writes compact.
+   * @param slice the slice to take ownership of.
+   */
+  void appendSlice(SlicePtr&& slice);
+
+  /**
+   * Fill iovecs with the non-empty slices at the front of the buffer.
+   * @param iov supplies the iovecs to fill.
+   * @param max_iov supplies the number of entries in iov.
+   * @return the number of iovecs filled.
+   */
+  uint64_t fillIovecs(iovec* iov, uint64_t max_iov) const;
+
+  // The most slices gathered into a single write, which is the most a single writev() accepts.
+  static constexpr uint64_t MaxWriteSlices = IOV_MAX;
+
+  // Process-wide backend selection, captured by each buffer as old_impl_ at construction.
+  static bool use_old_impl_;
+
+  // Slices smaller than this are copied rather than transferred by move(), if they fit in the
+  // spare capacity of the last slice of the destination buffer.
+  static constexpr uint64_t CopyThreshold = 512;
+
+  // Whether this buffer uses the evbuffer-backed implementation.
+  const bool old_impl_;
+
+  // Used if old_impl_==true.
   Event::Libevent::BufferPtr buffer_;
+
+  // Used if old_impl_==false.
+  SliceDeque slices_;
+
+  // Sum of the dataSize of all slices. Used if old_impl_==false.
+  uint64_t length_{0};
 };
 
 } // namespace Buffer
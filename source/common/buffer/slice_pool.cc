@@ -0,0 +1,119 @@
+#include "common/buffer/slice_pool.h"
+
+#include <cstddef>
+#include <new>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Buffer {
+
+static_assert(SlicePool::BlockOverhead >= sizeof(uint64_t) &&
+                  SlicePool::BlockOverhead % alignof(std::max_align_t) == 0,
+              "block header must preserve allocation alignment");
+
+constexpr uint64_t SlicePool::PageSize;
+constexpr uint64_t SlicePool::ReadSize;
+constexpr uint64_t SlicePool::NumSizeClasses;
+constexpr uint64_t SlicePool::BlockOverhead;
+constexpr uint64_t SlicePool::DefaultMaxRetainedBytes;
+
+thread_local SlicePool* SlicePool::current_ = nullptr;
+
+SlicePool::SlicePool(uint64_t max_retained_bytes) : max_retained_bytes_(max_retained_bytes) {}
+
+SlicePool::~SlicePool() {
+  ASSERT(current_ != this);
+  for (FreeBlock*& free_list : free_lists_) {
+    while (free_list != nullptr) {
+      FreeBlock* block = free_list;
+      free_list = block->next_;
+      ::operator delete(block);
+    }
+  }
+  if (stats_ != nullptr) {
+    stats_->bytes_retained_.sub(bytes_retained_);
+  }
+}
+
+void SlicePool::initializeStats(Stats::Scope& scope, const std::string& prefix) {
+  const std::string final_prefix = prefix + "slice_pool.";
+  stats_.reset(new SlicePoolStats{
+      ALL_SLICE_POOL_STATS(POOL_COUNTER_PREFIX(scope, final_prefix),
+                           POOL_GAUGE_PREFIX(scope, final_prefix))});
+  stats_->bytes_retained_.add(bytes_retained_);
+}
+
+uint64_t SlicePool::sizeClass(uint64_t block_size) {
+  const uint64_t size_class = (block_size + PageSize - 1) / PageSize - 1;
+  return size_class < NumSizeClasses ? size_class : NumSizeClasses;
+}
+
+void* SlicePool::allocate(uint64_t size) {
+  uint64_t block_size = size + BlockOverhead;
+  const uint64_t size_class = sizeClass(block_size);
+  void* memory;
+  if (size_class < NumSizeClasses) {
+    // Round poolable blocks up to their size class so that any block in a class can satisfy any
+    // request for that class.
+    block_size = (size_class + 1) * PageSize;
+    memory = current_ != nullptr ? current_->allocateBlock(block_size)
+                                 : ::operator new(block_size);
+  } else {
+    memory = ::operator new(block_size);
+  }
+
+  *static_cast<uint64_t*>(memory) = block_size;
+  return static_cast<uint8_t*>(memory) + BlockOverhead;
+}
+
+void SlicePool::release(void* block) {
+  if (block == nullptr) {
+    return;
+  }
+  void* memory = static_cast<uint8_t*>(block) - BlockOverhead;
+  const uint64_t block_size = *static_cast<uint64_t*>(memory);
+  if (current_ != nullptr && sizeClass(block_size) < NumSizeClasses) {
+    current_->releaseBlock(memory, block_size);
+  } else {
+    ::operator delete(memory);
+  }
+}
+
+void* SlicePool::allocateBlock(uint64_t block_size) {
+  FreeBlock*& free_list = free_lists_[sizeClass(block_size)];
+  if (free_list == nullptr) {
+    if (stats_ != nullptr) {
+      stats_->misses_.inc();
+    }
+    return ::operator new(block_size);
+  }
+
+  FreeBlock* block = free_list;
+  free_list = block->next_;
+  bytes_retained_ -= block_size;
+  if (stats_ != nullptr) {
+    stats_->hits_.inc();
+    stats_->bytes_retained_.sub(block_size);
+  }
+  return block;
+}
+
+void SlicePool::releaseBlock(void* memory, uint64_t block_size) {
+  if (bytes_retained_ + block_size > max_retained_bytes_) {
+    ::operator delete(memory);
+    return;
+  }
+
+  FreeBlock*& free_list = free_lists_[sizeClass(block_size)];
+  FreeBlock* block = static_cast<FreeBlock*>(memory);
+  block->next_ = free_list;
+  free_list = block;
+  bytes_retained_ += block_size;
+  if (stats_ != nullptr) {
+    stats_->bytes_retained_.add(block_size);
+  }
+}
+
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "envoy/stats/stats.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Buffer {
+
+/**
+ * All slice pool stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_SLICE_POOL_STATS(COUNTER, GAUGE)                                                       \
+  COUNTER(hits)                                                                                    \
+  COUNTER(misses)                                                                                  \
+  GAUGE  (bytes_retained)
+// clang-format on
+
+/**
+ * Struct definition for all slice pool stats. @see stats_macros.h
+ */
+struct SlicePoolStats {
+  ALL_SLICE_POOL_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * A cache of memory blocks for buffer slice storage. Each dispatcher owns a pool and installs it
+ * as the current thread's pool (see ScopedSlicePool) while its event loop runs, so every buffer
+ * slice allocated or freed on a worker thread is served from that worker's pool without locking.
+ *
+ * Blocks are cached in size classes of whole pages, up to the class that holds a 16KiB socket
+ * read plus the slice header. Larger blocks, and all blocks allocated or freed on a thread without
+ * a current pool, go straight to the heap. Because every block comes from the global heap
+ * originally, a block allocated from one pool may safely be cached by another; this happens when
+ * a buffer is destroyed on a different thread than the one that filled it.
+ */
+class SlicePool : NonCopyable {
+public:
+  // Size class granularity, matching the slice size granularity.
+  static constexpr uint64_t PageSize = 4096;
+
+  // The largest amount of data a single socket read produces. The largest size class holds this
+  // much data plus the slice header.
+  static constexpr uint64_t ReadSize = 16384;
+
+  // The number of size classes. Class N (0-based) caches blocks of (N + 1) * PageSize bytes.
+  static constexpr uint64_t NumSizeClasses = (ReadSize + PageSize - 1) / PageSize + 1;
+
+  // Bytes in front of each block used to remember the block's size.
+  static constexpr uint64_t BlockOverhead = 16;
+
+  // Default limit on the memory a single pool retains across all size classes.
+  static constexpr uint64_t DefaultMaxRetainedBytes = 1024 * 1024;
+
+  SlicePool(uint64_t max_retained_bytes = DefaultMaxRetainedBytes);
+  ~SlicePool();
+
+  /**
+   * Allocate a block of memory from the current thread's pool, or from the heap if there is no
+   * current pool or the size is not poolable. The returned memory is suitably aligned for any
+   * object type.
+   * @param size supplies the number of usable bytes needed.
+   * @return void* the block. Must be freed with release().
+   */
+  static void* allocate(uint64_t size);
+
+  /**
+   * Release a block previously obtained from allocate(), caching it in the current thread's pool
+   * if possible.
+   * @param block supplies the block to release.
+   */
+  static void release(void* block);
+
+  /**
+   * @return SlicePool* the pool installed for the current thread, or nullptr if none.
+   */
+  static SlicePool* current() { return current_; }
+
+  /**
+   * Create stats for this pool in the given scope.
+   * @param scope supplies the scope to create the stats in.
+   * @param prefix supplies the prefix for the stat names.
+   */
+  void initializeStats(Stats::Scope& scope, const std::string& prefix);
+
+  /**
+   * @return uint64_t the number of bytes currently cached by this pool.
+   */
+  uint64_t bytesRetained() const { return bytes_retained_; }
+
+private:
+  struct FreeBlock {
+    FreeBlock* next_;
+  };
+
+  friend class ScopedSlicePool;
+
+  void* allocateBlock(uint64_t block_size);
+  void releaseBlock(void* block, uint64_t block_size);
+
+  /**
+   * @return the size class for a block of block_size bytes, or NumSizeClasses if the block is not
+   *         poolable.
+   */
+  static uint64_t sizeClass(uint64_t block_size);
+
+  static thread_local SlicePool* current_;
+
+  const uint64_t max_retained_bytes_;
+  uint64_t bytes_retained_{0};
+  FreeBlock* free_lists_[NumSizeClasses]{};
+  std::unique_ptr<SlicePoolStats> stats_;
+};
+
+/**
+ * Installs a SlicePool as the current thread's pool for the lifetime of this object, restoring the
+ * previously installed pool (if any) on destruction.
+ */
+class ScopedSlicePool : NonCopyable {
+public:
+  ScopedSlicePool(SlicePool& pool) : previous_(SlicePool::current_) {
+    SlicePool::current_ = &pool;
+  }
+  ~ScopedSlicePool() { SlicePool::current_ = previous_; }
+
+private:
+  SlicePool* const previous_;
+};
+
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,56 @@
+#include "common/common/regex.h"
+
+#include "envoy/common/exception.h"
+
+#include "common/common/fmt.h"
+
+namespace Envoy {
+namespace Regex {
+
+namespace {
+
+re2::RE2::Options re2Options() {
+  re2::RE2::Options options;
+  // Invalid regexes are reported through the EnvoyException thrown by the constructor.
+  options.set_log_errors(false);
+  return options;
+}
+
+re2::StringPiece toStringPiece(absl::string_view value) {
+  return re2::StringPiece(value.data(), value.size());
+}
+
+} // namespace
+
+Re2Matcher::Re2Matcher(const std::string& regex) : regex_(regex, re2Options()) {
+  if (!regex_.ok()) {
+    throw EnvoyException(fmt::format("Invalid regex '{}': {}", regex, regex_.error()));
+  }
+}
+
+bool Re2Matcher::match(absl::string_view value) const {
+  return re2::RE2::FullMatch(toStringPiece(value), regex_);
+}
+
+bool Re2Matcher::search(absl::string_view value, std::vector<absl::string_view>& groups) const {
+  const int num_groups = regex_.NumberOfCapturingGroups() + 1;
+  std::vector<re2::StringPiece> submatches(num_groups);
+  if (!regex_.Match(toStringPiece(value), 0, value.size(), re2::RE2::UNANCHORED,
+                    submatches.data(), num_groups)) {
+    return false;
+  }
+
+  groups.clear();
+  groups.reserve(num_groups);
+  for (const re2::StringPiece& submatch : submatches) {
+    groups.emplace_back(submatch.data(), submatch.size());
+  }
+  return true;
+}
+
+CompiledMatcherPtr Utility::parseRegex(const std::string& regex) {
+  return std::make_unique<Re2Matcher>(regex);
+}
+
+} // namespace Regex
+} // namespace Envoy
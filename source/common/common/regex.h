@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "envoy/common/regex.h"
+
+#include "re2/re2.h"
+
+namespace Envoy {
+namespace Regex {
+
+/**
+ * CompiledMatcher backed by RE2. RE2 compiles the regex into an automaton, so matching takes time
+ * linear in the size of the input and a bounded amount of memory, whatever the regex. In exchange
+ * it does not support backreferences or lookaround assertions.
+ */
+class Re2Matcher : public CompiledMatcher {
+public:
+  /**
+   * @param regex supplies the regex to compile. See https://github.com/google/re2/wiki/Syntax.
+   * @throw EnvoyException if the regex is invalid.
+   */
+  Re2Matcher(const std::string& regex);
+
+  // Regex::CompiledMatcher
+  bool match(absl::string_view value) const override;
+  bool search(absl::string_view value, std::vector<absl::string_view>& groups) const override;
+
+private:
+  const re2::RE2 regex_;
+};
+
+/**
+ * Utilities for compiling regular expressions from configuration.
+ */
+class Utility {
+public:
+  /**
+   * Compile a regex with the default engine.
+   * @param regex supplies the regex to compile.
+   * @return CompiledMatcherPtr the compiled regex.
+   * @throw EnvoyException if the regex is invalid.
+   */
+  static CompiledMatcherPtr parseRegex(const std::string& regex);
+};
+
+} // namespace Regex
+} // namespace Envoy
@@ -129,6 +129,21 @@ void DispatcherImpl::deferredDelete(DeferredDeletablePtr&& to_delete) {
   }
 }
 
+void DispatcherImpl::own(DeferredDeletablePtr&& to_own) {
+  ASSERT(isThreadSafe());
+  DeferredDeletable* key = to_own.get();
+  owned_.emplace(key, std::move(to_own));
+}
+
+DeferredDeletablePtr DispatcherImpl::disown(DeferredDeletable& owned) {
+  ASSERT(isThreadSafe());
+  auto it = owned_.find(&owned);
+  ASSERT(it != owned_.end());
+  DeferredDeletablePtr item = std::move(it->second);
+  owned_.erase(it);
+  return item;
+}
+
 void DispatcherImpl::exit() { event_base_loopexit(base_.get(), nullptr); }
 
 SignalEventPtr DispatcherImpl::listenForSignal(int signal_num, SignalCb cb) {
@@ -149,9 +164,17 @@ void DispatcherImpl::post(std::function<void()> callback) {
   }
 }
 
+void DispatcherImpl::initializeStats(Stats::Scope& scope, const std::string& prefix) {
+  slice_pool_.initializeStats(scope, prefix);
+}
+
 void DispatcherImpl::run(RunType type) {
   run_tid_ = Thread::Thread::currentThreadId();
 
+  // Buffer slices allocated and freed by this thread while the loop runs are cached in this
+  // dispatcher's pool, which needs no locking since only this thread uses it.
+  Buffer::ScopedSlicePool slice_pool(slice_pool_);
+
   // Flush all post callbacks before we run the event loop. We do this because there are post
   // callbacks that have to get run before the initial event loop starts running. libevent does
   // not gaurantee that events are run in any particular order. So even if we post() and call
@@ -3,12 +3,14 @@
 #include <cstdint>
 #include <functional>
 #include <list>
+#include <unordered_map>
 #include <vector>
 
 #include "envoy/event/deferred_deletable.h"
 #include "envoy/event/dispatcher.h"
 #include "envoy/network/connection_handler.h"
 
+#include "common/buffer/slice_pool.h"
 #include "common/common/logger.h"
 #include "common/common/thread.h"
 #include "common/event/libevent.h"
@@ -50,11 +52,14 @@ public:
                                       bool hand_off_restored_destination_connections) override;
   TimerPtr createTimer(TimerCb cb) override;
   void deferredDelete(DeferredDeletablePtr&& to_delete) override;
+  void own(DeferredDeletablePtr&& to_own) override;
+  DeferredDeletablePtr disown(DeferredDeletable& owned) override;
   void exit() override;
   SignalEventPtr listenForSignal(int signal_num, SignalCb cb) override;
   void post(std::function<void()> callback) override;
   void run(RunType type) override;
   Buffer::WatermarkFactory& getWatermarkFactory() override { return *buffer_factory_; }
+  void initializeStats(Stats::Scope& scope, const std::string& prefix) override;
 
 private:
   void runPostCallbacks();
@@ -67,6 +72,8 @@ private:
   }
 
   Thread::ThreadId run_tid_{};
+  // Declared first so that it outlives everything that may release slices on destruction.
+  Buffer::SlicePool slice_pool_;
   Buffer::WatermarkFactoryPtr buffer_factory_;
   Libevent::BasePtr base_;
   TimerPtr deferred_delete_timer_;
@@ -74,6 +81,9 @@ private:
   std::vector<DeferredDeletablePtr> to_delete_1_;
   std::vector<DeferredDeletablePtr> to_delete_2_;
   std::vector<DeferredDeletablePtr>* current_to_delete_;
+  // Items handed over with own(). Destroyed before base_ so that they can still release their
+  // events.
+  std::unordered_map<DeferredDeletable*, DeferredDeletablePtr> owned_;
   Thread::MutexBasicLockable post_lock_;
   std::list<std::function<void()>> post_callbacks_ GUARDED_BY(post_lock_);
   bool deferred_deleting_{};
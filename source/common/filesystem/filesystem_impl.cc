@@ -1,8 +1,11 @@
 #include "common/filesystem/filesystem_impl.h"
 
 #include <dirent.h>
+#include <limits.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <fstream>
@@ -20,6 +23,7 @@
 #include "common/common/fmt.h"
 #include "common/common/lock_guard.h"
 #include "common/common/thread.h"
+#include "common/common/utility.h"
 
 #include "absl/strings/match.h"
 
@@ -93,12 +97,84 @@ bool illegalPath(const std::string& path) {
   }
 }
 
+FileFlusher::~FileFlusher() {
+  {
+    Thread::LockGuard lock(lock_);
+    ASSERT(queue_.empty());
+    exit_ = true;
+    flush_event_.notifyOne();
+  }
+
+  if (flush_thread_ != nullptr) {
+    flush_thread_->join();
+  }
+}
+
+void FileFlusher::schedule(FileImpl& file) {
+  Thread::LockGuard lock(lock_);
+  if (flush_thread_ == nullptr) {
+    flush_thread_ = std::make_unique<Thread::Thread>([this]() -> void { flushThreadFunc(); });
+  }
+
+  if (!file.queued_for_flush_) {
+    file.queued_for_flush_ = true;
+    queue_.push_back(&file);
+    flush_event_.notifyOne();
+  }
+}
+
+void FileFlusher::cancel(FileImpl& file) {
+  Thread::LockGuard lock(lock_);
+  if (file.queued_for_flush_) {
+    file.queued_for_flush_ = false;
+    queue_.remove(&file);
+  }
+
+  while (flushing_ == &file) {
+    flush_complete_.wait(lock_);
+  }
+}
+
+void FileFlusher::flushThreadFunc() {
+  FileImpl* file = nullptr;
+
+  while (true) {
+    {
+      Thread::LockGuard lock(lock_);
+
+      if (file != nullptr) {
+        // A file that is being destroyed waits until it is no longer being flushed.
+        flushing_ = nullptr;
+        flush_complete_.notifyAll();
+      }
+
+      while (queue_.empty() && !exit_) {
+        // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
+        flush_event_.wait(lock_);
+      }
+
+      if (exit_) {
+        return;
+      }
+
+      file = queue_.front();
+      queue_.pop_front();
+      file->queued_for_flush_ = false;
+      flushing_ = file;
+    }
+
+    // The lock is not held while the file is written, so that files can keep being queued.
+    file->flushFromFlusher();
+  }
+}
+
 FileImpl::FileImpl(const std::string& path, Event::Dispatcher& dispatcher,
                    Thread::BasicLockable& lock, Stats::Store& stats_store,
-                   std::chrono::milliseconds flush_interval_msec)
-    : path_(path), file_lock_(lock), flush_timer_(dispatcher.createTimer([this]() -> void {
+                   std::chrono::milliseconds flush_interval_msec, FileFlusherSharedPtr flusher)
+    : path_(path), file_lock_(lock), flusher_(flusher),
+      flush_timer_(dispatcher.createTimer([this]() -> void {
         stats_.flushed_by_timer_.inc();
-        flush_event_.notifyOne();
+        flusher_->schedule(*this);
         flush_timer_->enableTimer(flush_interval_msec_);
       })),
       os_sys_calls_(Api::OsSysCallsSingleton::get()), flush_interval_msec_(flush_interval_msec),
@@ -119,15 +195,7 @@ void FileImpl::open() {
 void FileImpl::reopen() { reopen_file_ = true; }
 
 FileImpl::~FileImpl() {
-  {
-    Thread::LockGuard lock(write_lock_);
-    flush_thread_exit_ = true;
-    flush_event_.notifyOne();
-  }
-
-  if (flush_thread_ != nullptr) {
-    flush_thread_->join();
-  }
+  flusher_->cancel(*this);
 
   // Flush any remaining data. If file was not opened for some reason, skip flushing part.
   if (fd_ != -1) {
@@ -140,10 +208,20 @@ FileImpl::~FileImpl() {
 }
 
 void FileImpl::doWrite(Buffer::Instance& buffer) {
-  uint64_t num_slices = buffer.getRawSlices(nullptr, 0);
+  const uint64_t num_slices = buffer.getRawSlices(nullptr, 0);
   Buffer::RawSlice slices[num_slices];
   buffer.getRawSlices(slices, num_slices);
 
+  iovec iovecs[num_slices];
+  uint64_t num_iovecs = 0;
+  for (const Buffer::RawSlice& slice : slices) {
+    if (slice.len_ > 0) {
+      iovecs[num_iovecs].iov_base = slice.mem_;
+      iovecs[num_iovecs].iov_len = slice.len_;
+      num_iovecs++;
+    }
+  }
+
   // We must do the actual writes to disk under lock, so that we don't intermix chunks from
   // different FileImpl pointing to the same underlying file. This can happen either via hot
   // restart or if calling code opens the same underlying file into a different FileImpl in the
@@ -154,10 +232,27 @@ void FileImpl::doWrite(Buffer::Instance& buffer) {
   //            process lock or had multiple locks.
   {
     Thread::LockGuard lock(file_lock_);
-    for (Buffer::RawSlice& slice : slices) {
-      ssize_t rc = os_sys_calls_.write(fd_, slice.mem_, slice.len_);
-      ASSERT(rc == static_cast<ssize_t>(slice.len_));
+    iovec* next = iovecs;
+    uint64_t remaining = num_iovecs;
+    while (remaining > 0) {
+      const ssize_t rc = os_sys_calls_.writev(fd_, next, std::min<uint64_t>(remaining, IOV_MAX));
+      if (rc <= 0) {
+        // The file can not be written to. The data is dropped, as it would be by a failed reopen.
+        break;
+      }
       stats_.write_completed_.inc();
+
+      // Skip what was written. A short write leaves the rest of a slice to be written next.
+      uint64_t written = rc;
+      while (remaining > 0 && written >= next->iov_len) {
+        written -= next->iov_len;
+        next++;
+        remaining--;
+      }
+      if (written > 0) {
+        next->iov_base = static_cast<char*>(next->iov_base) + written;
+        next->iov_len -= written;
+      }
     }
   }
 
@@ -165,44 +260,41 @@ void FileImpl::doWrite(Buffer::Instance& buffer) {
   buffer.drain(buffer.length());
 }
 
-void FileImpl::flushThreadFunc() {
+void FileImpl::flushFromFlusher() {
+  std::unique_lock<Thread::BasicLockable> flush_lock;
+  MonotonicTime first_buffered_time;
 
-  while (true) {
-    std::unique_lock<Thread::BasicLockable> flush_lock;
+  {
+    Thread::LockGuard write_lock(write_lock_);
 
-    {
-      Thread::LockGuard write_lock(write_lock_);
+    // The file can be queued both by the timer and by a large enough flush_buffer_, and can be
+    // flushed synchronously while it is queued, so flush_buffer_ can be empty.
+    if (flush_buffer_.length() == 0) {
+      return;
+    }
 
-      // flush_event_ can be woken up either by large enough flush_buffer or by timer.
-      // In case it was timer, flush_buffer_ can be empty.
-      while (flush_buffer_.length() == 0 && !flush_thread_exit_) {
-        // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
-        flush_event_.wait(write_lock_);
-      }
+    flush_lock = std::unique_lock<Thread::BasicLockable>(flush_lock_);
+    about_to_write_buffer_.move(flush_buffer_);
+    ASSERT(flush_buffer_.length() == 0);
+    first_buffered_time = first_buffered_time_;
+  }
 
-      if (flush_thread_exit_) {
-        return;
+  // if we failed to open file before (-1 == fd_), then simply ignore
+  if (fd_ != -1) {
+    try {
+      if (reopen_file_) {
+        reopen_file_ = false;
+        os_sys_calls_.close(fd_);
+        open();
       }
 
-      flush_lock = std::unique_lock<Thread::BasicLockable>(flush_lock_);
-      ASSERT(flush_buffer_.length() > 0);
-      about_to_write_buffer_.move(flush_buffer_);
-      ASSERT(flush_buffer_.length() == 0);
-    }
-
-    // if we failed to open file before (-1 == fd_), then simply ignore
-    if (fd_ != -1) {
-      try {
-        if (reopen_file_) {
-          reopen_file_ = false;
-          os_sys_calls_.close(fd_);
-          open();
-        }
-
-        doWrite(about_to_write_buffer_);
-      } catch (const EnvoyException&) {
-        stats_.reopen_failed_.inc();
-      }
+      doWrite(about_to_write_buffer_);
+      stats_.flush_latency_ms_.set(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                       ProdMonotonicTimeSource::instance_.currentTime() -
+                                       first_buffered_time)
+                                       .count());
+    } catch (const EnvoyException&) {
+      stats_.reopen_failed_.inc();
     }
   }
 }
@@ -214,7 +306,7 @@ void FileImpl::flush() {
     Thread::LockGuard write_lock(write_lock_);
 
     // flush_lock_ must be held while checking this or else it is
-    // possible that flushThreadFunc() has already moved data from
+    // possible that flushFromFlusher() has already moved data from
     // flush_buffer_ to about_to_write_buffer_, has unlocked write_lock_,
     // but has not yet completed doWrite(). This would allow flush() to
     // return before the pending data has actually been written to disk.
@@ -234,22 +326,28 @@ void FileImpl::flush() {
 void FileImpl::write(absl::string_view data) {
   Thread::LockGuard lock(write_lock_);
 
-  if (flush_thread_ == nullptr) {
-    createFlushStructures();
+  if (flush_buffer_.length() + data.size() > MAX_BUFFER_SIZE) {
+    stats_.write_dropped_.inc();
+    return;
+  }
+
+  // The first write is flushed straight away, rather than waiting for the timer.
+  const bool first_write = !flush_timer_enabled_;
+  if (first_write) {
+    flush_timer_enabled_ = true;
+    flush_timer_->enableTimer(flush_interval_msec_);
   }
 
+  if (flush_buffer_.length() == 0) {
+    first_buffered_time_ = ProdMonotonicTimeSource::instance_.currentTime();
+  }
   stats_.write_buffered_.inc();
   stats_.write_total_buffered_.add(data.length());
   flush_buffer_.add(data.data(), data.size());
-  if (flush_buffer_.length() > MIN_FLUSH_SIZE) {
-    flush_event_.notifyOne();
+  if (first_write || flush_buffer_.length() > MIN_FLUSH_SIZE) {
+    flusher_->schedule(*this);
   }
 }
 
-void FileImpl::createFlushStructures() {
-  flush_thread_.reset(new Thread::Thread([this]() -> void { flushThreadFunc(); }));
-  flush_timer_->enableTimer(flush_interval_msec_);
-}
-
 } // namespace Filesystem
 } // namespace Envoy
@@ -4,9 +4,12 @@
 #include <chrono>
 #include <cstdint>
 #include <cstdlib>
+#include <list>
+#include <memory>
 #include <string>
 
 #include "envoy/api/os_sys_calls.h"
+#include "envoy/common/time.h"
 #include "envoy/event/dispatcher.h"
 #include "envoy/filesystem/filesystem.h"
 #include "envoy/stats/stats_macros.h"
@@ -19,8 +22,10 @@ namespace Envoy {
 #define FILESYSTEM_STATS(COUNTER, GAUGE)                                                           \
   COUNTER(write_buffered)                                                                          \
   COUNTER(write_completed)                                                                         \
+  COUNTER(write_dropped)                                                                           \
   COUNTER(flushed_by_timer)                                                                        \
   COUNTER(reopen_failed)                                                                           \
+  GAUGE  (flush_latency_ms)                                                                        \
   GAUGE  (write_total_buffered)
 // clang-format on
 
@@ -71,17 +76,55 @@ std::string canonicalPath(const std::string& path);
  */
 bool illegalPath(const std::string& path);
 
+class FileImpl;
+
+/**
+ * Flushes the buffered data of FileImpl instances on a single thread, so that the number of
+ * flush threads does not grow with the number of open files. The thread is started when the first
+ * flush is scheduled. Files hold a shared pointer to the flusher, so it outlives all of them.
+ */
+class FileFlusher {
+public:
+  ~FileFlusher();
+
+  /**
+   * Queue a file to be flushed by the flush thread. Does nothing if the file is already queued.
+   * @param file supplies the file to flush.
+   */
+  void schedule(FileImpl& file);
+
+  /**
+   * Remove a file from the queue, and wait for the flush thread if it is flushing the file. Must
+   * be called before the file is destroyed.
+   * @param file supplies the file.
+   */
+  void cancel(FileImpl& file);
+
+private:
+  void flushThreadFunc();
+
+  Thread::MutexBasicLockable lock_;
+  Thread::CondVar flush_event_;    // Signalled when a file is queued or the thread must exit.
+  Thread::CondVar flush_complete_; // Signalled when the thread has finished flushing a file.
+  std::list<FileImpl*> queue_ GUARDED_BY(lock_);
+  FileImpl* flushing_ GUARDED_BY(lock_){};
+  bool exit_ GUARDED_BY(lock_){};
+  Thread::ThreadPtr flush_thread_;
+};
+
+typedef std::shared_ptr<FileFlusher> FileFlusherSharedPtr;
+
 /**
  * This is a file implementation geared for writing out access logs. It turn out that in certain
  * cases even if a standard file is opened with O_NONBLOCK, the kernel can still block when writing.
- * This implementation uses a flush thread per file, with the idea there there aren't that many
- * files. If this turns out to be a good implementation we can potentially have a single flush
- * thread that flushes all files, but we will start with this.
+ * Writes are buffered and written to disk by a FileFlusher thread that is shared by all files,
+ * each flush writing the whole buffer with as few writev() calls as possible.
  */
 class FileImpl : public File {
 public:
   FileImpl(const std::string& path, Event::Dispatcher& dispatcher, Thread::BasicLockable& lock,
-           Stats::Store& stats_store, std::chrono::milliseconds flush_interval_msec);
+           Stats::Store& stats_store, std::chrono::milliseconds flush_interval_msec,
+           FileFlusherSharedPtr flusher);
   ~FileImpl();
 
   // Filesystem::File
@@ -99,13 +142,18 @@ public:
   void flush() override;
 
 private:
+  friend class FileFlusher;
+
   void doWrite(Buffer::Instance& buffer);
-  void flushThreadFunc();
+  // Called by the flush thread to write out the flush buffer.
+  void flushFromFlusher();
   void open();
-  void createFlushStructures();
 
   // Minimum size before the flush thread will be told to flush.
   static const uint64_t MIN_FLUSH_SIZE = 1024 * 64;
+  // Maximum size of the flush buffer. Writes that would grow the buffer beyond this, because the
+  // disk is not keeping up, are dropped rather than let the buffer grow without bound.
+  static const uint64_t MAX_BUFFER_SIZE = 1024 * 1024 * 16;
 
   int fd_;
   std::string path_;
@@ -127,9 +175,11 @@ private:
       write_lock_; // The lock is used when filling the flush buffer. It allows
                    // multiple threads to write to the same file at relatively
                    // high performance. It is always local to the process.
-  Thread::ThreadPtr flush_thread_;
-  Thread::CondVar flush_event_;
-  std::atomic<bool> flush_thread_exit_{};
+  const FileFlusherSharedPtr flusher_;
+  bool queued_for_flush_{}; // Guarded by the flusher's lock.
+  bool flush_timer_enabled_ GUARDED_BY(write_lock_){};
+  // When the oldest data in flush_buffer_ was written, to measure how long flushes lag behind.
+  MonotonicTime first_buffered_time_ GUARDED_BY(write_lock_);
   std::atomic<bool> reopen_file_{};
   Buffer::OwnedImpl flush_buffer_
       GUARDED_BY(write_lock_); // This buffer is used by multiple threads. It gets filled and
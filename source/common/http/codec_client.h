@@ -83,6 +83,12 @@ public:
    */
   size_t numActiveRequests() { return active_requests_.size(); }
 
+  /**
+   * @return uint32_t the number of concurrent streams the peer currently allows on this
+   *         connection. @see Http::ClientConnection::maxConcurrentStreams().
+   */
+  uint32_t maxConcurrentStreams() { return codec_->maxConcurrentStreams(); }
+
   /**
    * Create a new stream. Note: The CodecClient will NOT buffer multiple requests for HTTP1
    * connections. Thus, calling newStream() before the previous request has been fully encoded
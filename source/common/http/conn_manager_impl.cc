@@ -150,10 +150,17 @@ void ConnectionManagerImpl::doEndStream(ActiveStream& stream) {
   checkForDeferredClose();
 
   // Reading may have been disabled for the non-multiplexing case, so enable it again.
-  // Also be sure to unwind any read-disable done by the prior downstream
-  // connection.
+  // Once no stream is left, also be sure to unwind any read-disable done by the prior downstream
+  // connection. Pipelined streams still in flight undo their own read-disables, so only undo the
+  // one done while the maximum number of requests were in flight.
   if (drain_state_ != DrainState::Closing && codec_->protocol() != Protocol::Http2) {
-    while (!read_callbacks_->connection().readEnabled()) {
+    if (streams_.empty()) {
+      while (!read_callbacks_->connection().readEnabled()) {
+        read_callbacks_->connection().readDisable(false);
+      }
+      pipelined_reads_disabled_ = false;
+    } else if (pipelined_reads_disabled_) {
+      pipelined_reads_disabled_ = false;
       read_callbacks_->connection().readDisable(false);
     }
   }
@@ -245,16 +252,24 @@ Network::FilterStatus ConnectionManagerImpl::onData(Buffer::Instance& data, bool
     // The HTTP/1 codec will pause dispatch after a single message is complete. We want to
     // either redispatch if there are no streams and we have more data. If we have a single
     // complete non-WebSocket stream but have not responded yet we will pause socket reads
-    // to apply back pressure.
+    // to apply back pressure. With pipelining, the codec only leaves data in the buffer once the
+    // maximum number of requests are in flight, so pause socket reads until a stream completes.
     if (codec_->protocol() != Protocol::Http2) {
-      if (read_callbacks_->connection().state() == Network::Connection::State::Open &&
-          data.length() > 0 && streams_.empty()) {
+      const bool connection_open =
+          read_callbacks_->connection().state() == Network::Connection::State::Open;
+      if (connection_open && data.length() > 0 && streams_.empty()) {
         redispatch = true;
       }
 
-      if (!streams_.empty() && streams_.front()->state_.remote_complete_ &&
-          !isOldStyleWebSocketConnection()) {
-        read_callbacks_->connection().readDisable(true);
+      if (!streams_.empty() && !isOldStyleWebSocketConnection()) {
+        if (config_.http1Settings().max_pipelined_requests_ > 1) {
+          if (connection_open && data.length() > 0 && !pipelined_reads_disabled_) {
+            read_callbacks_->connection().readDisable(true);
+            pipelined_reads_disabled_ = true;
+          }
+        } else if (streams_.front()->state_.remote_complete_) {
+          read_callbacks_->connection().readDisable(true);
+        }
       }
     }
   } while (redispatch);
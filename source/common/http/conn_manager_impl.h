@@ -427,6 +427,8 @@ private:
   Stats::TimespanPtr conn_length_;
   const Network::DrainDecision& drain_close_;
   DrainState drain_state_{DrainState::NotDraining};
+  // Whether reads are disabled because the maximum number of pipelined requests are in flight.
+  bool pipelined_reads_disabled_{};
   UserAgent user_agent_;
   Event::TimerPtr idle_timer_;
   Event::TimerPtr drain_timer_;
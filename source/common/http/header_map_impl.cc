@@ -1,7 +1,7 @@
 #include "common/http/header_map_impl.h"
 
+#include <algorithm>
 #include <cstdint>
-#include <list>
 #include <string>
 
 #include "common/common/assert.h"
@@ -192,20 +192,15 @@ void HeaderString::setReference(const std::string& ref_value) {
   string_length_ = ref_value.size();
 }
 
-// Specialization needed for HeaderMapImpl::HeaderList::insert() when key is LowerCaseString.
-// A fully specialized template must be defined once in the program, hence this may not be in
-// a header file.
-template <> bool HeaderMapImpl::HeaderList::isPseudoHeader(const LowerCaseString& key) {
-  return key.get().c_str()[0] == ':';
-}
-
-HeaderMapImpl::HeaderEntryImpl::HeaderEntryImpl(const LowerCaseString& key) : key_(key) {}
+HeaderMapImpl::HeaderEntryImpl::HeaderEntryImpl(const LowerCaseString& key)
+    : key_(key), hash_(key.hash()) {}
 
 HeaderMapImpl::HeaderEntryImpl::HeaderEntryImpl(const LowerCaseString& key, HeaderString&& value)
-    : key_(key), value_(std::move(value)) {}
+    : key_(key), value_(std::move(value)), hash_(key.hash()) {}
 
-HeaderMapImpl::HeaderEntryImpl::HeaderEntryImpl(HeaderString&& key, HeaderString&& value)
-    : key_(std::move(key)), value_(std::move(value)) {}
+HeaderMapImpl::HeaderEntryImpl::HeaderEntryImpl(HeaderString&& key, HeaderString&& value,
+                                                uint64_t hash)
+    : key_(std::move(key)), value_(std::move(value)), hash_(hash) {}
 
 void HeaderMapImpl::HeaderEntryImpl::value(const char* value, uint32_t size) {
   value_.setCopy(value, size);
@@ -221,6 +216,184 @@ void HeaderMapImpl::HeaderEntryImpl::value(const HeaderEntry& header) {
   value(header.value().c_str(), header.value().size());
 }
 
+HeaderMapImpl::HeaderEntryImpl&
+HeaderMapImpl::HeaderList::insert(HeaderEntryImplPtr&& entry) {
+  HeaderEntryImpl& inserted = *entry;
+  if (headers_.capacity() == 0) {
+    // Most maps hold at least a handful of headers; skip the first few reallocations.
+    headers_.reserve(IndexThreshold);
+  }
+  if (inserted.isPseudoHeader()) {
+    // Pseudo headers normally arrive first, in which case nothing needs renumbering.
+    headers_.insert(headers_.begin() + pseudo_headers_end_, std::move(entry));
+    for (size_t i = pseudo_headers_end_; i < headers_.size(); i++) {
+      if (headers_[i] != nullptr) {
+        headers_[i]->position_ = i;
+      }
+    }
+    pseudo_headers_end_++;
+  } else {
+    inserted.position_ = headers_.size();
+    headers_.push_back(std::move(entry));
+  }
+  size_++;
+
+  if (!index_.empty()) {
+    indexEntry(inserted);
+  } else if (size_ > IndexThreshold) {
+    // Size the index for a typical request so that it rarely needs to grow.
+    rebuildIndex(IndexThreshold * 8);
+  }
+  return inserted;
+}
+
+void HeaderMapImpl::HeaderList::erase(HeaderEntryImpl& entry) {
+  if (!index_.empty()) {
+    unindexEntry(entry);
+  }
+  release(entry);
+}
+
+void HeaderMapImpl::HeaderList::eraseKey(absl::string_view key, uint64_t hash) {
+  if (index_.empty()) {
+    compact([&](const HeaderEntryImpl& entry) { return entry.keyEquals(key, hash); });
+    return;
+  }
+
+  const size_t slot = findSlot(key, hash);
+  HeaderEntryImpl* entry = index_[slot].entry_;
+  if (entry == nullptr) {
+    return;
+  }
+  eraseSlot(slot);
+  while (entry != nullptr) {
+    HeaderEntryImpl* next = entry->next_same_key_;
+    release(*entry);
+    entry = next;
+  }
+}
+
+void HeaderMapImpl::HeaderList::release(HeaderEntryImpl& entry) {
+  const size_t position = entry.position_;
+  ASSERT(headers_[position].get() == &entry);
+  headers_[position].reset();
+  size_--;
+
+  if (position + 1 == headers_.size()) {
+    while (!headers_.empty() && headers_.back() == nullptr) {
+      headers_.pop_back();
+    }
+    pseudo_headers_end_ = std::min(pseudo_headers_end_, headers_.size());
+  }
+  // Squeezing the holes out costs at most twice the number of holes, so erasing stays amortized
+  // O(1).
+  if (headers_.size() - size_ > size_) {
+    compact([](const HeaderEntryImpl&) { return false; });
+  }
+}
+
+HeaderMapImpl::HeaderEntryImpl* HeaderMapImpl::HeaderList::find(absl::string_view key,
+                                                                uint64_t hash) const {
+  if (!index_.empty()) {
+    return index_[findSlot(key, hash)].entry_;
+  }
+
+  for (const HeaderEntryImplPtr& header : headers_) {
+    if (header != nullptr && header->keyEquals(key, hash)) {
+      return header.get();
+    }
+  }
+  return nullptr;
+}
+
+size_t HeaderMapImpl::HeaderList::findSlot(absl::string_view key, uint64_t hash) const {
+  const size_t mask = index_.size() - 1;
+  size_t slot = hash & mask;
+  while (index_[slot].entry_ != nullptr && !index_[slot].entry_->keyEquals(key, hash)) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+void HeaderMapImpl::HeaderList::indexEntry(HeaderEntryImpl& entry) {
+  entry.next_same_key_ = nullptr;
+  const size_t slot = findSlot(entry.key().getStringView(), entry.hash_);
+  if (index_[slot].entry_ != nullptr) {
+    // An earlier entry with the same key is already indexed. Entries are indexed in list order,
+    // since pseudo headers, the only ones not appended, only share keys with pseudo headers.
+    index_[slot].last_->next_same_key_ = &entry;
+    index_[slot].last_ = &entry;
+    return;
+  }
+
+  index_[slot] = {entry.hash_, &entry, &entry};
+  indexed_keys_++;
+  // Keep the load factor at or below 1/2 so probe sequences stay short.
+  if (indexed_keys_ * 2 > index_.size()) {
+    rebuildIndex(index_.size() * 2);
+  }
+}
+
+void HeaderMapImpl::HeaderList::unindexEntry(HeaderEntryImpl& entry) {
+  const size_t slot = findSlot(entry.key().getStringView(), entry.hash_);
+  IndexSlot& index_slot = index_[slot];
+  ASSERT(index_slot.entry_ != nullptr);
+  if (index_slot.entry_ == &entry) {
+    index_slot.entry_ = entry.next_same_key_;
+    if (index_slot.entry_ == nullptr) {
+      eraseSlot(slot);
+    }
+    return;
+  }
+
+  // Only entries sharing the key are walked, which are few.
+  HeaderEntryImpl* previous = index_slot.entry_;
+  while (previous->next_same_key_ != &entry) {
+    previous = previous->next_same_key_;
+    ASSERT(previous != nullptr);
+  }
+  previous->next_same_key_ = entry.next_same_key_;
+  if (index_slot.last_ == &entry) {
+    index_slot.last_ = previous;
+  }
+}
+
+void HeaderMapImpl::HeaderList::eraseSlot(size_t slot) {
+  // Backward shift deletion: move later entries of the probe sequence into the hole so that no
+  // tombstones are needed.
+  const size_t mask = index_.size() - 1;
+  size_t hole = slot;
+  size_t next = slot;
+  while (true) {
+    next = (next + 1) & mask;
+    if (index_[next].entry_ == nullptr) {
+      break;
+    }
+    // An entry may fill the hole only if its home slot is not cyclically within (hole, next].
+    const size_t home = index_[next].hash_ & mask;
+    const bool stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+    if (!stays) {
+      index_[hole] = index_[next];
+      hole = next;
+    }
+  }
+  index_[hole].entry_ = nullptr;
+  indexed_keys_--;
+}
+
+void HeaderMapImpl::HeaderList::rebuildIndex(size_t capacity) {
+  while (size_ * 2 > capacity) {
+    capacity *= 2;
+  }
+  index_.assign(capacity, IndexSlot{0, nullptr, nullptr});
+  indexed_keys_ = 0;
+  for (const HeaderEntryImplPtr& header : headers_) {
+    if (header != nullptr) {
+      indexEntry(*header);
+    }
+  }
+}
+
 #define INLINE_HEADER_STATIC_MAP_ENTRY(name)                                                       \
   add(Headers::get().name.get().c_str(), [](HeaderMapImpl& h) -> StaticLookupResponse {            \
     return {&h.inline_headers_.name##_, &Headers::get().name};                                     \
@@ -277,6 +450,7 @@ void HeaderMapImpl::appendToHeader(HeaderString& header, absl::string_view data)
 HeaderMapImpl::HeaderMapImpl() { memset(&inline_headers_, 0, sizeof(inline_headers_)); }
 
 HeaderMapImpl::HeaderMapImpl(const HeaderMap& rhs) : HeaderMapImpl() {
+  headers_.reserve(rhs.size());
   rhs.iterate(
       [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
         // TODO(mattklein123) PERF: Avoid copying here is not necessary.
@@ -319,16 +493,29 @@ bool HeaderMapImpl::operator==(const HeaderMapImpl& rhs) const {
 }
 
 void HeaderMapImpl::insertByKey(HeaderString&& key, HeaderString&& value) {
+  if (!insertInline(key, value)) {
+    const uint64_t hash = LowerCaseString::hash(key.getStringView());
+    headers_.insert(std::make_unique<HeaderEntryImpl>(std::move(key), std::move(value), hash));
+  }
+}
+
+void HeaderMapImpl::insertByKey(HeaderString&& key, HeaderString&& value, uint64_t hash) {
+  if (!insertInline(key, value)) {
+    headers_.insert(std::make_unique<HeaderEntryImpl>(std::move(key), std::move(value), hash));
+  }
+}
+
+bool HeaderMapImpl::insertInline(HeaderString& key, HeaderString& value) {
   StaticLookupEntry::EntryCb cb = ConstSingleton<StaticLookupTable>::get().find(key.c_str());
-  if (cb) {
-    key.clear();
-    StaticLookupResponse ref_lookup_response = cb(*this);
-    ASSERT(*ref_lookup_response.entry_ == nullptr); // This function doesn't handle append.
-    maybeCreateInline(ref_lookup_response.entry_, *ref_lookup_response.key_, std::move(value));
-  } else {
-    std::list<HeaderEntryImpl>::iterator i = headers_.insert(std::move(key), std::move(value));
-    i->entry_ = i;
+  if (!cb) {
+    return false;
   }
+
+  key.clear();
+  StaticLookupResponse ref_lookup_response = cb(*this);
+  ASSERT(*ref_lookup_response.entry_ == nullptr); // This function doesn't handle append.
+  maybeCreateInline(ref_lookup_response.entry_, *ref_lookup_response.key_, std::move(value));
+  return true;
 }
 
 void HeaderMapImpl::addViaMove(HeaderString&& key, HeaderString&& value) {
@@ -354,16 +541,20 @@ void HeaderMapImpl::addReferenceKey(const LowerCaseString& key, uint64_t value)
   HeaderString ref_key(key);
   HeaderString new_value;
   new_value.setInteger(value);
-  insertByKey(std::move(ref_key), std::move(new_value));
+  insertByKey(std::move(ref_key), std::move(new_value), key.hash());
   ASSERT(new_value.empty());
 }
 
 void HeaderMapImpl::addReferenceKey(const LowerCaseString& key, const std::string& value) {
-  HeaderString ref_key(key);
   HeaderString new_value;
   new_value.setCopy(value.c_str(), value.size());
-  insertByKey(std::move(ref_key), std::move(new_value));
-  ASSERT(new_value.empty());
+  addReferenceKey(key, std::move(new_value));
+}
+
+void HeaderMapImpl::addReferenceKey(const LowerCaseString& key, HeaderString&& value) {
+  HeaderString ref_key(key);
+  insertByKey(std::move(ref_key), std::move(value), key.hash());
+  ASSERT(value.empty());
 }
 
 void HeaderMapImpl::addCopy(const LowerCaseString& key, uint64_t value) {
@@ -378,7 +569,7 @@ void HeaderMapImpl::addCopy(const LowerCaseString& key, uint64_t value) {
   new_key.setCopy(key.get().c_str(), key.get().size());
   HeaderString new_value;
   new_value.setInteger(value);
-  insertByKey(std::move(new_key), std::move(new_value));
+  insertByKey(std::move(new_key), std::move(new_value), key.hash());
   ASSERT(new_key.empty());
   ASSERT(new_value.empty());
 }
@@ -393,7 +584,7 @@ void HeaderMapImpl::addCopy(const LowerCaseString& key, const std::string& value
   new_key.setCopy(key.get().c_str(), key.get().size());
   HeaderString new_value;
   new_value.setCopy(value.c_str(), value.size());
-  insertByKey(std::move(new_key), std::move(new_value));
+  insertByKey(std::move(new_key), std::move(new_value), key.hash());
   ASSERT(new_key.empty());
   ASSERT(new_value.empty());
 }
@@ -402,16 +593,20 @@ void HeaderMapImpl::setReference(const LowerCaseString& key, const std::string&
   HeaderString ref_key(key);
   HeaderString ref_value(value);
   remove(key);
-  insertByKey(std::move(ref_key), std::move(ref_value));
+  insertByKey(std::move(ref_key), std::move(ref_value), key.hash());
 }
 
 void HeaderMapImpl::setReferenceKey(const LowerCaseString& key, const std::string& value) {
-  HeaderString ref_key(key);
   HeaderString new_value;
   new_value.setCopy(value.c_str(), value.size());
+  setReferenceKey(key, std::move(new_value));
+}
+
+void HeaderMapImpl::setReferenceKey(const LowerCaseString& key, HeaderString&& value) {
+  HeaderString ref_key(key);
   remove(key);
-  insertByKey(std::move(ref_key), std::move(new_value));
-  ASSERT(new_value.empty());
+  insertByKey(std::move(ref_key), std::move(value), key.hash());
+  ASSERT(value.empty());
 }
 
 uint64_t HeaderMapImpl::byteSize() const {
@@ -425,23 +620,11 @@ uint64_t HeaderMapImpl::byteSize() const {
 }
 
 const HeaderEntry* HeaderMapImpl::get(const LowerCaseString& key) const {
-  for (const HeaderEntryImpl& header : headers_) {
-    if (header.key() == key.get().c_str()) {
-      return &header;
-    }
-  }
-
-  return nullptr;
+  return headers_.find(key.get(), key.hash());
 }
 
 HeaderEntry* HeaderMapImpl::get(const LowerCaseString& key) {
-  for (HeaderEntryImpl& header : headers_) {
-    if (header.key() == key.get().c_str()) {
-      return &header;
-    }
-  }
-
-  return nullptr;
+  return headers_.find(key.get(), key.hash());
 }
 
 void HeaderMapImpl::iterate(ConstIterateCb cb, void* context) const {
@@ -453,7 +636,7 @@ void HeaderMapImpl::iterate(ConstIterateCb cb, void* context) const {
 }
 
 void HeaderMapImpl::iterateReverse(ConstIterateCb cb, void* context) const {
-  for (auto it = headers_.rbegin(); it != headers_.rend(); it++) {
+  for (auto it = headers_.rbegin(); it != headers_.rend(); ++it) {
     if (cb(*it, context) == HeaderMap::Iterate::Break) {
       break;
     }
@@ -489,13 +672,7 @@ void HeaderMapImpl::remove(const LowerCaseString& key) {
     StaticLookupResponse ref_lookup_response = cb(*this);
     removeInline(ref_lookup_response.entry_);
   } else {
-    for (auto i = headers_.begin(); i != headers_.end();) {
-      if (i->key() == key.get().c_str()) {
-        i = headers_.erase(i);
-      } else {
-        ++i;
-      }
-    }
+    headers_.eraseKey(key.get(), key.hash());
   }
 }
 
@@ -524,9 +701,7 @@ HeaderMapImpl::HeaderEntryImpl& HeaderMapImpl::maybeCreateInline(HeaderEntryImpl
     return **entry;
   }
 
-  std::list<HeaderEntryImpl>::iterator i = headers_.insert(key);
-  i->entry_ = i;
-  *entry = &(*i);
+  *entry = &headers_.insert(std::make_unique<HeaderEntryImpl>(key));
   return **entry;
 }
 
@@ -538,9 +713,7 @@ HeaderMapImpl::HeaderEntryImpl& HeaderMapImpl::maybeCreateInline(HeaderEntryImpl
     return **entry;
   }
 
-  std::list<HeaderEntryImpl>::iterator i = headers_.insert(key, std::move(value));
-  i->entry_ = i;
-  *entry = &(*i);
+  *entry = &headers_.insert(std::make_unique<HeaderEntryImpl>(key, std::move(value)));
   return **entry;
 }
 
@@ -560,7 +733,7 @@ void HeaderMapImpl::removeInline(HeaderEntryImpl** ptr_to_entry) {
 
   HeaderEntryImpl* entry = *ptr_to_entry;
   *ptr_to_entry = nullptr;
-  headers_.erase(entry->entry_);
+  headers_.erase(*entry);
 }
 
 } // namespace Http
@@ -2,9 +2,9 @@
 
 #include <array>
 #include <cstdint>
-#include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/http/header_map.h"
 
@@ -32,8 +32,9 @@ public:
  * Implementation of Http::HeaderMap. This is heavily optimized for performance. Roughly, when
  * headers are added to the map, we do a hash lookup to see if it's one of the O(1) headers.
  * If it is, we store a reference to it that can be accessed later directly. Most high performance
- * paths use O(1) direct access. In general, we try to copy as little as possible and allocate as
- * little as possible in any of the paths.
+ * paths use O(1) direct access. Lookups of any other header by name use a small open addressing
+ * index keyed by the header's precomputed hash (see LowerCaseString::hash()). In general, we try
+ * to copy as little as possible and allocate as little as possible in any of the paths.
  */
 class HeaderMapImpl : public HeaderMap {
 public:
@@ -65,10 +66,12 @@ public:
   void addReference(const LowerCaseString& key, const std::string& value) override;
   void addReferenceKey(const LowerCaseString& key, uint64_t value) override;
   void addReferenceKey(const LowerCaseString& key, const std::string& value) override;
+  void addReferenceKey(const LowerCaseString& key, HeaderString&& value) override;
   void addCopy(const LowerCaseString& key, uint64_t value) override;
   void addCopy(const LowerCaseString& key, const std::string& value) override;
   void setReference(const LowerCaseString& key, const std::string& value) override;
   void setReferenceKey(const LowerCaseString& key, const std::string& value) override;
+  void setReferenceKey(const LowerCaseString& key, HeaderString&& value) override;
   uint64_t byteSize() const override;
   const HeaderEntry* get(const LowerCaseString& key) const override;
   HeaderEntry* get(const LowerCaseString& key) override;
@@ -83,7 +86,7 @@ protected:
   struct HeaderEntryImpl : public HeaderEntry, NonCopyable {
     HeaderEntryImpl(const LowerCaseString& key);
     HeaderEntryImpl(const LowerCaseString& key, HeaderString&& value);
-    HeaderEntryImpl(HeaderString&& key, HeaderString&& value);
+    HeaderEntryImpl(HeaderString&& key, HeaderString&& value, uint64_t hash);
 
     // HeaderEntry
     const HeaderString& key() const override { return key_; }
@@ -94,11 +97,21 @@ protected:
     const HeaderString& value() const override { return value_; }
     HeaderString& value() override { return value_; }
 
+    bool isPseudoHeader() const { return key_.c_str()[0] == ':'; }
+    bool keyEquals(absl::string_view key, uint64_t hash) const {
+      return hash_ == hash && key_.getStringView() == key;
+    }
+
     HeaderString key_;
     HeaderString value_;
-    std::list<HeaderEntryImpl>::iterator entry_;
+    const uint64_t hash_;
+    // Maintained by HeaderList.
+    size_t position_{};
+    HeaderEntryImpl* next_same_key_{};
   };
 
+  typedef std::unique_ptr<HeaderEntryImpl> HeaderEntryImplPtr;
+
   struct StaticLookupResponse {
     HeaderEntryImpl** entry_;
     const LowerCaseString* key_;
@@ -128,60 +141,162 @@ protected:
   };
 
   /**
-   * List of HeaderEntryImpl that keeps the pseudo headers (key starting with ':') in the front
-   * of the list (as required by nghttp2) and otherwise maintains insertion order.
+   * Flat list of HeaderEntryImpl that keeps the pseudo headers (key starting with ':') in the front
+   * of the list (as required by nghttp2) and otherwise maintains insertion order. Entries are
+   * individually allocated so references to them stay valid while the list changes.
+   *
+   * Once the list grows past IndexThreshold entries, it also maintains an open addressing index
+   * (linear probing, power of two capacity) from each distinct key to the first entry with that
+   * key, so that find() is O(1) for maps with many headers. Entries with the same key are chained
+   * in list order from the indexed one. Smaller lists are searched linearly, comparing the cached
+   * key hashes before the keys themselves.
+   *
+   * Each entry records its position, so erasing it leaves a hole rather than shifting the entries
+   * that follow. The holes are skipped when iterating and squeezed out once they outnumber the
+   * entries.
    */
   class HeaderList {
   public:
-    HeaderList() : pseudo_headers_end_(headers_.end()) {}
-
-    template <class Key> bool isPseudoHeader(const Key& key) { return key.c_str()[0] == ':'; }
-
-    template <class Key, class... Value>
-    std::list<HeaderEntryImpl>::iterator insert(Key&& key, Value&&... value) {
-      const bool is_pseudo_header = isPseudoHeader(key);
-      std::list<HeaderEntryImpl>::iterator i =
-          headers_.emplace(is_pseudo_header ? pseudo_headers_end_ : headers_.end(),
-                           std::forward<Key>(key), std::forward<Value>(value)...);
-      if (!is_pseudo_header && pseudo_headers_end_ == headers_.end()) {
-        pseudo_headers_end_ = i;
+    // The number of entries at which the index is built.
+    static constexpr size_t IndexThreshold = 8;
+
+    /**
+     * Iterates over the entries of the list, skipping holes.
+     */
+    template <class Iterator> class EntryIterator {
+    public:
+      EntryIterator(Iterator it, Iterator end) : it_(it), end_(end) { skipHoles(); }
+
+      const HeaderEntryImpl& operator*() const { return **it_; }
+      const HeaderEntryImpl* operator->() const { return it_->get(); }
+      EntryIterator& operator++() {
+        ++it_;
+        skipHoles();
+        return *this;
       }
-      return i;
-    }
+      bool operator!=(const EntryIterator& rhs) const { return it_ != rhs.it_; }
 
-    std::list<HeaderEntryImpl>::iterator erase(std::list<HeaderEntryImpl>::iterator i) {
-      if (pseudo_headers_end_ == i) {
-        pseudo_headers_end_++;
+    private:
+      void skipHoles() {
+        while (it_ != end_ && *it_ == nullptr) {
+          ++it_;
+        }
       }
-      return headers_.erase(i);
-    }
 
+      Iterator it_;
+      Iterator end_;
+    };
+
+    typedef EntryIterator<std::vector<HeaderEntryImplPtr>::const_iterator> ConstIterator;
+    typedef EntryIterator<std::vector<HeaderEntryImplPtr>::const_reverse_iterator>
+        ConstReverseIterator;
+
+    /**
+     * Insert an entry. Pseudo headers are inserted after any existing pseudo headers; all other
+     * headers are appended.
+     * @param entry supplies the entry to insert.
+     * @return HeaderEntryImpl& the inserted entry.
+     */
+    HeaderEntryImpl& insert(HeaderEntryImplPtr&& entry);
+
+    /**
+     * Remove and destroy a single entry.
+     * @param entry supplies the entry, which must be in the list.
+     */
+    void erase(HeaderEntryImpl& entry);
+
+    /**
+     * Remove and destroy all entries with the given key.
+     * @param key supplies the key.
+     * @param hash supplies the hash of the key.
+     */
+    void eraseKey(absl::string_view key, uint64_t hash);
+
+    /**
+     * @param key supplies the key to find.
+     * @param hash supplies the hash of the key.
+     * @return HeaderEntryImpl* the first entry with the given key, or nullptr if none.
+     */
+    HeaderEntryImpl* find(absl::string_view key, uint64_t hash) const;
+
+    /**
+     * Remove and destroy all entries matching a predicate.
+     * @param p supplies the predicate, taking a const HeaderEntryImpl&.
+     */
     template <class UnaryPredicate> void remove_if(UnaryPredicate p) {
-      headers_.remove_if([&](const HeaderEntryImpl& entry) {
-        const bool to_remove = p(entry);
-        if (to_remove) {
-          if (pseudo_headers_end_ == entry.entry_) {
-            pseudo_headers_end_++;
-          }
-        }
-        return to_remove;
-      });
+      compact(p);
+      if (!index_.empty()) {
+        rebuildIndex(index_.size());
+      }
     }
 
-    std::list<HeaderEntryImpl>::iterator begin() { return headers_.begin(); }
-    std::list<HeaderEntryImpl>::iterator end() { return headers_.end(); }
-    std::list<HeaderEntryImpl>::const_iterator begin() const { return headers_.begin(); }
-    std::list<HeaderEntryImpl>::const_iterator end() const { return headers_.end(); }
-    std::list<HeaderEntryImpl>::const_reverse_iterator rbegin() const { return headers_.rbegin(); }
-    std::list<HeaderEntryImpl>::const_reverse_iterator rend() const { return headers_.rend(); }
-    size_t size() const { return headers_.size(); }
+    void reserve(size_t size) { headers_.reserve(size); }
+    ConstIterator begin() const { return {headers_.begin(), headers_.end()}; }
+    ConstIterator end() const { return {headers_.end(), headers_.end()}; }
+    ConstReverseIterator rbegin() const { return {headers_.rbegin(), headers_.rend()}; }
+    ConstReverseIterator rend() const { return {headers_.rend(), headers_.rend()}; }
+    size_t size() const { return size_; }
 
   private:
-    std::list<HeaderEntryImpl> headers_;
-    std::list<HeaderEntryImpl>::iterator pseudo_headers_end_;
+    struct IndexSlot {
+      uint64_t hash_;
+      // First entry with the slot's key, or nullptr if the slot is empty.
+      HeaderEntryImpl* entry_;
+      // Last entry with the slot's key.
+      HeaderEntryImpl* last_;
+    };
+
+    /**
+     * Remove and destroy all entries matching a predicate and squeeze out the holes. Does not
+     * update the index.
+     */
+    template <class UnaryPredicate> void compact(UnaryPredicate p) {
+      size_t kept = 0;
+      size_t pseudo_headers_kept = 0;
+      for (size_t i = 0; i < headers_.size(); i++) {
+        if (headers_[i] == nullptr || p(static_cast<const HeaderEntryImpl&>(*headers_[i]))) {
+          continue;
+        }
+        if (i < pseudo_headers_end_) {
+          pseudo_headers_kept++;
+        }
+        headers_[i]->position_ = kept;
+        if (kept != i) {
+          headers_[kept] = std::move(headers_[i]);
+        }
+        kept++;
+      }
+      headers_.resize(kept);
+      pseudo_headers_end_ = pseudo_headers_kept;
+      size_ = kept;
+    }
+
+    /**
+     * @return the slot holding the given key if the key is indexed, otherwise the empty slot at
+     *         which the key would be inserted.
+     */
+    size_t findSlot(absl::string_view key, uint64_t hash) const;
+    void indexEntry(HeaderEntryImpl& entry);
+    void unindexEntry(HeaderEntryImpl& entry);
+    void eraseSlot(size_t slot);
+    void rebuildIndex(size_t capacity);
+    void release(HeaderEntryImpl& entry);
+
+    // Holds nullptr where an entry was erased.
+    std::vector<HeaderEntryImplPtr> headers_;
+    size_t size_{0};
+    size_t pseudo_headers_end_{0};
+    std::vector<IndexSlot> index_;
+    size_t indexed_keys_{0};
   };
 
   void insertByKey(HeaderString&& key, HeaderString&& value);
+  void insertByKey(HeaderString&& key, HeaderString&& value, uint64_t hash);
+  /**
+   * Insert a header if it is one of the O(1) headers.
+   * @return bool whether the header was inserted. If not, key and value are untouched.
+   */
+  bool insertInline(HeaderString& key, HeaderString& value);
   HeaderEntryImpl& maybeCreateInline(HeaderEntryImpl** entry, const LowerCaseString& key);
   HeaderEntryImpl& maybeCreateInline(HeaderEntryImpl** entry, const LowerCaseString& key,
                                      HeaderString&& value);
@@ -158,10 +158,13 @@ public:
   } ExpectValues;
 
   struct {
+    const std::string Delete{"DELETE"};
     const std::string Get{"GET"};
     const std::string Head{"HEAD"};
     const std::string Post{"POST"};
+    const std::string Put{"PUT"};
     const std::string Options{"OPTIONS"};
+    const std::string Trace{"TRACE"};
   } MethodValues;
 
   struct {
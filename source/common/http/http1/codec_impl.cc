@@ -1,5 +1,7 @@
 #include "common/http/http1/codec_impl.h"
 
+#include <http_parser.h>
+
 #include <cstdint>
 #include <string>
 
@@ -12,6 +14,8 @@
 #include "common/common/utility.h"
 #include "common/http/exception.h"
 #include "common/http/headers.h"
+#include "common/http/http1/http_parser_impl.h"
+#include "common/http/http1/vectorized_parser_impl.h"
 #include "common/http/utility.h"
 
 namespace Envoy {
@@ -114,7 +118,7 @@ void StreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_stream)
   if (end_stream) {
     endEncode();
   } else {
-    connection_.flushOutput();
+    flushOutput();
   }
 }
 
@@ -136,7 +140,7 @@ void StreamEncoderImpl::encodeData(Buffer::Instance& data, bool end_stream) {
   if (end_stream) {
     endEncode();
   } else {
-    connection_.flushOutput();
+    flushOutput();
   }
 }
 
@@ -147,21 +151,32 @@ void StreamEncoderImpl::endEncode() {
     connection_.buffer().add(LAST_CHUNK);
   }
 
-  connection_.flushOutput();
+  flushOutput();
+  encode_complete_ = true;
   connection_.onEncodeComplete();
 }
 
-void ConnectionImpl::flushOutput() {
+void StreamEncoderImpl::flushOutput() { connection_.flushOutput(); }
+
+void ConnectionImpl::commitReservedOutput() {
   if (reserved_current_) {
     reserved_iovec_.len_ = reserved_current_ - static_cast<char*>(reserved_iovec_.mem_);
     output_buffer_.commit(&reserved_iovec_, 1);
     reserved_current_ = nullptr;
   }
+}
 
+void ConnectionImpl::flushOutput() {
+  commitReservedOutput();
   connection().write(output_buffer_, false);
   ASSERT(0UL == output_buffer_.length());
 }
 
+void ConnectionImpl::flushOutput(Buffer::Instance& output) {
+  commitReservedOutput();
+  output.move(output_buffer_);
+}
+
 void ConnectionImpl::addCharToBuffer(char c) {
   ASSERT(bufferRemainingSize() >= 1);
   *reserved_current_++ = c;
@@ -231,6 +246,39 @@ void ResponseStreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end
   StreamEncoderImpl::encodeHeaders(headers, end_stream);
 }
 
+void ResponseStreamEncoderImpl::holdOutput() {
+  ASSERT(!held_output_);
+  // Once the response is complete the stream is gone, so watermarks no longer matter.
+  held_output_ = std::make_unique<Buffer::WatermarkBuffer>(
+      [this]() -> void {
+        if (!encodeComplete()) {
+          runLowWatermarkCallbacks();
+        }
+      },
+      [this]() -> void {
+        if (!encodeComplete()) {
+          runHighWatermarkCallbacks();
+        }
+      });
+  held_output_->setWatermarks(connection_.bufferLimit());
+}
+
+void ResponseStreamEncoderImpl::releaseOutput() {
+  ASSERT(held_output_);
+  if (held_output_->length() > 0) {
+    connection_.connection().write(*held_output_, false);
+  }
+  held_output_.reset();
+}
+
+void ResponseStreamEncoderImpl::flushOutput() {
+  if (held_output_) {
+    connection_.flushOutput(*held_output_);
+  } else {
+    StreamEncoderImpl::flushOutput();
+  }
+}
+
 static const char REQUEST_POSTFIX[] = " HTTP/1.1\r\n";
 
 void RequestStreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_stream) {
@@ -253,50 +301,25 @@ void RequestStreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_
   StreamEncoderImpl::encodeHeaders(headers, end_stream);
 }
 
-http_parser_settings ConnectionImpl::settings_{
-    [](http_parser* parser) -> int {
-      static_cast<ConnectionImpl*>(parser->data)->onMessageBeginBase();
-      return 0;
-    },
-    [](http_parser* parser, const char* at, size_t length) -> int {
-      static_cast<ConnectionImpl*>(parser->data)->onUrl(at, length);
-      return 0;
-    },
-    nullptr, // on_status
-    [](http_parser* parser, const char* at, size_t length) -> int {
-      static_cast<ConnectionImpl*>(parser->data)->onHeaderField(at, length);
-      return 0;
-    },
-    [](http_parser* parser, const char* at, size_t length) -> int {
-      static_cast<ConnectionImpl*>(parser->data)->onHeaderValue(at, length);
-      return 0;
-    },
-    [](http_parser* parser) -> int {
-      return static_cast<ConnectionImpl*>(parser->data)->onHeadersCompleteBase();
-    },
-    [](http_parser* parser, const char* at, size_t length) -> int {
-      static_cast<ConnectionImpl*>(parser->data)->onBody(at, length);
-      return 0;
-    },
-    [](http_parser* parser) -> int {
-      static_cast<ConnectionImpl*>(parser->data)->onMessageComplete();
-      return 0;
-    },
-    nullptr, // on_chunk_header
-    nullptr  // on_chunk_complete
-};
-
 const ToLowerTable& ConnectionImpl::toLowerTable() {
   static ToLowerTable* table = new ToLowerTable();
   return *table;
 }
 
-ConnectionImpl::ConnectionImpl(Network::Connection& connection, http_parser_type type)
+ConnectionImpl::ConnectionImpl(Network::Connection& connection, ParserType type,
+                               Http1Settings::Parser parser)
     : connection_(connection), output_buffer_([&]() -> void { this->onBelowLowWatermark(); },
                                               [&]() -> void { this->onAboveHighWatermark(); }) {
   output_buffer_.setWatermarks(connection.bufferLimit());
-  http_parser_init(&parser_, type);
-  parser_.data = this;
+  ParserCallbacks& callbacks = *this;
+  switch (parser) {
+  case Http1Settings::Parser::HttpParser:
+    parser_ = std::make_unique<HttpParserImpl>(type, callbacks);
+    break;
+  case Http1Settings::Parser::Vectorized:
+    parser_ = std::make_unique<VectorizedParserImpl>(type, callbacks);
+    break;
+  }
 }
 
 void ConnectionImpl::completeLastHeader() {
@@ -317,7 +340,7 @@ void ConnectionImpl::dispatch(Buffer::Instance& data) {
   ENVOY_CONN_LOG(trace, "parsing {} bytes", connection_, data.length());
 
   // Always unpause before dispatch.
-  http_parser_pause(&parser_, 0);
+  parser_->resume();
 
   ssize_t total_parsed = 0;
   if (data.length() > 0) {
@@ -336,11 +359,11 @@ void ConnectionImpl::dispatch(Buffer::Instance& data) {
 }
 
 size_t ConnectionImpl::dispatchSlice(const char* slice, size_t len) {
-  ssize_t rc = http_parser_execute(&parser_, &settings_, slice, len);
-  if (HTTP_PARSER_ERRNO(&parser_) != HPE_OK && HTTP_PARSER_ERRNO(&parser_) != HPE_PAUSED) {
+  ssize_t rc = parser_->execute(slice, len);
+  if (parser_->error() != HPE_OK && parser_->error() != HPE_PAUSED) {
     sendProtocolError();
     throw CodecProtocolException("http/1.1 protocol error: " +
-                                 std::string(http_errno_name(HTTP_PARSER_ERRNO(&parser_))));
+                                 std::string(http_errno_name(parser_->error())));
   }
 
   return rc;
@@ -372,7 +395,7 @@ void ConnectionImpl::onHeaderValue(const char* data, size_t length) {
 int ConnectionImpl::onHeadersCompleteBase() {
   ENVOY_CONN_LOG(trace, "headers complete", connection_);
   completeLastHeader();
-  if (!(parser_.http_major == 1 && parser_.http_minor == 1)) {
+  if (!(parser_->httpMajor() == 1 && parser_->httpMinor() == 1)) {
     // This is not necessarily true, but it's good enough since higher layers only care if this is
     // HTTP/1.1 or not.
     protocol_ = Protocol::Http10;
@@ -400,46 +423,72 @@ void ConnectionImpl::onResetStreamBase(StreamResetReason reason) {
 ServerConnectionImpl::ServerConnectionImpl(Network::Connection& connection,
                                            ServerConnectionCallbacks& callbacks,
                                            Http1Settings settings)
-    : ConnectionImpl(connection, HTTP_REQUEST), callbacks_(callbacks), codec_settings_(settings) {}
+    : ConnectionImpl(connection, ParserType::Request, settings.parser_), callbacks_(callbacks),
+      codec_settings_(settings) {}
+
+void ServerConnectionImpl::dispatch(Buffer::Instance& data) {
+  // With pipelining, leave the data in the buffer until a response completes if the maximum number
+  // of requests are already in flight. The caller is expected to stop reading in the meantime.
+  if (codec_settings_.max_pipelined_requests_ > 1 && !canPipeline()) {
+    return;
+  }
+
+  ConnectionImpl::dispatch(data);
+}
+
+ServerConnectionImpl::ActiveRequest* ServerConnectionImpl::decodingRequest() {
+  if (active_requests_.empty() || active_requests_.back()->remote_complete_) {
+    return nullptr;
+  }
+
+  return active_requests_.back().get();
+}
 
 void ServerConnectionImpl::onEncodeComplete() {
-  ASSERT(active_request_);
-  if (active_request_->remote_complete_) {
-    // Only do this if remote is complete. If we are replying before the request is complete the
-    // only logical thing to do is for higher level code to reset() / close the connection so we
-    // leave the request around so that it can fire reset callbacks.
-    active_request_.reset();
+  ASSERT(!active_requests_.empty());
+  // The encoder that completed may belong to a pipelined request whose response is being held.
+  // Retire requests from the front of the queue for as long as they are complete, releasing the
+  // held response of each request that moves to the front. Only do this if remote is complete. If
+  // we are replying before the request is complete the only logical thing to do is for higher
+  // level code to reset() / close the connection so we leave the request around so that it can
+  // fire reset callbacks.
+  while (!active_requests_.empty() && active_requests_.front()->complete()) {
+    active_requests_.pop_front();
+    if (!active_requests_.empty()) {
+      active_requests_.front()->response_encoder_.releaseOutput();
+    }
   }
 }
 
-void ServerConnectionImpl::handlePath(HeaderMapImpl& headers, unsigned int method) {
+void ServerConnectionImpl::handlePath(ActiveRequest& request, HeaderMapImpl& headers,
+                                      unsigned int method) {
   HeaderString path(Headers::get().Path);
 
   bool is_connect = (method == HTTP_CONNECT);
 
   // The url is relative or a wildcard when the method is OPTIONS. Nothing to do here.
-  if (active_request_->request_url_.c_str()[0] == '/' ||
-      ((method == HTTP_OPTIONS) && active_request_->request_url_.c_str()[0] == '*')) {
-    headers.addViaMove(std::move(path), std::move(active_request_->request_url_));
+  if (request.request_url_.c_str()[0] == '/' ||
+      ((method == HTTP_OPTIONS) && request.request_url_.c_str()[0] == '*')) {
+    headers.addViaMove(std::move(path), std::move(request.request_url_));
     return;
   }
 
   // If absolute_urls and/or connect are not going be handled, copy the url and return.
   // This forces the behavior to be backwards compatible with the old codec behavior.
   if (!codec_settings_.allow_absolute_url_) {
-    headers.addViaMove(std::move(path), std::move(active_request_->request_url_));
+    headers.addViaMove(std::move(path), std::move(request.request_url_));
     return;
   }
 
   if (is_connect) {
-    headers.addViaMove(std::move(path), std::move(active_request_->request_url_));
+    headers.addViaMove(std::move(path), std::move(request.request_url_));
     return;
   }
 
   struct http_parser_url u;
   http_parser_url_init(&u);
-  int result = http_parser_parse_url(active_request_->request_url_.buffer(),
-                                     active_request_->request_url_.size(), is_connect, &u);
+  int result = http_parser_parse_url(request.request_url_.buffer(),
+                                     request.request_url_.size(), is_connect, &u);
 
   if (result != 0) {
     sendProtocolError();
@@ -463,7 +512,7 @@ void ServerConnectionImpl::handlePath(HeaderMapImpl& headers, unsigned int metho
       }
 
       // Insert the host header, this will later be converted to :authority
-      std::string new_host(active_request_->request_url_.c_str() + u.field_data[UF_HOST].off,
+      std::string new_host(request.request_url_.c_str() + u.field_data[UF_HOST].off,
                            authority_len);
 
       headers.insertHost().value(new_host);
@@ -472,8 +521,8 @@ void ServerConnectionImpl::handlePath(HeaderMapImpl& headers, unsigned int metho
       // must start with /
       if ((u.field_set & (1 << UF_PATH)) == (1 << UF_PATH) && u.field_data[UF_PATH].len > 0) {
         HeaderString new_path;
-        new_path.setCopy(active_request_->request_url_.c_str() + u.field_data[UF_PATH].off,
-                         active_request_->request_url_.size() - u.field_data[UF_PATH].off);
+        new_path.setCopy(request.request_url_.c_str() + u.field_data[UF_PATH].off,
+                         request.request_url_.size() - u.field_data[UF_PATH].off);
         headers.addViaMove(std::move(path), std::move(new_path));
       } else {
         HeaderString new_path;
@@ -481,7 +530,7 @@ void ServerConnectionImpl::handlePath(HeaderMapImpl& headers, unsigned int metho
         headers.addViaMove(std::move(path), std::move(new_path));
       }
 
-      active_request_->request_url_.clear();
+      request.request_url_.clear();
       return;
     }
     sendProtocolError();
@@ -493,17 +542,18 @@ int ServerConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
   // Handle the case where response happens prior to request complete. It's up to upper layer code
   // to disconnect the connection but we shouldn't fire any more events since it doesn't make
   // sense.
-  if (active_request_) {
-    const char* method_string = http_method_str(static_cast<http_method>(parser_.method));
+  ActiveRequest* request = decodingRequest();
+  if (request) {
+    const char* method_string = http_method_str(parser_->method());
 
     // Inform the response encoder about any HEAD method, so it can set content
     // length and transfer encoding headers correctly.
-    active_request_->response_encoder_.isResponseToHeadRequest(parser_.method == HTTP_HEAD);
+    request->response_encoder_.isResponseToHeadRequest(parser_->method() == HTTP_HEAD);
 
     // Currently, CONNECT is not supported, however; http_parser_parse_url needs to know about
     // CONNECT
-    handlePath(*headers, parser_.method);
-    ASSERT(active_request_->request_url_.empty());
+    handlePath(*request, *headers, parser_->method());
+    ASSERT(request->request_url_.empty());
 
     headers->insertMethod().value(method_string, strlen(method_string));
 
@@ -513,14 +563,13 @@ int ServerConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
     // with message complete. This allows upper layers to behave like HTTP/2 and prevents a proxy
     // scenario where the higher layers stream through and implicitly switch to chunked transfer
     // encoding because end stream with zero body length has not yet been indicated.
-    if (parser_.flags & F_CHUNKED ||
-        (parser_.content_length > 0 && parser_.content_length != ULLONG_MAX)) {
-      active_request_->request_decoder_->decodeHeaders(std::move(headers), false);
+    if (parser_->isChunked() || parser_->contentLength().value_or(0) > 0) {
+      request->request_decoder_->decodeHeaders(std::move(headers), false);
 
       // If the connection has been closed (or is closing) after decoding headers, pause the parser
       // so we return control to the caller.
       if (connection_.state() != Network::Connection::State::Open) {
-        http_parser_pause(&parser_, 1);
+        parser_->pause();
       }
 
     } else {
@@ -533,52 +582,68 @@ int ServerConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
 
 void ServerConnectionImpl::onMessageBegin() {
   if (!resetStreamCalled()) {
-    ASSERT(!active_request_);
-    active_request_.reset(new ActiveRequest(*this));
-    active_request_->request_decoder_ = &callbacks_.newStream(active_request_->response_encoder_);
+    ASSERT(!decodingRequest());
+    active_requests_.emplace_back(new ActiveRequest(*this));
+    ActiveRequest& request = *active_requests_.back();
+    if (active_requests_.size() > 1) {
+      // The response must wait for the responses to the requests ahead of this one.
+      request.response_encoder_.holdOutput();
+    }
+    request.request_decoder_ = &callbacks_.newStream(request.response_encoder_);
   }
 }
 
 void ServerConnectionImpl::onUrl(const char* data, size_t length) {
-  if (active_request_) {
-    active_request_->request_url_.append(data, length);
+  ActiveRequest* request = decodingRequest();
+  if (request) {
+    request->request_url_.append(data, length);
   }
 }
 
 void ServerConnectionImpl::onBody(const char* data, size_t length) {
   ASSERT(!deferred_end_stream_headers_);
-  if (active_request_) {
+  ActiveRequest* request = decodingRequest();
+  if (request) {
     ENVOY_CONN_LOG(trace, "body size={}", connection_, length);
     Buffer::OwnedImpl buffer(data, length);
-    active_request_->request_decoder_->decodeData(buffer, false);
+    request->request_decoder_->decodeData(buffer, false);
   }
 }
 
 void ServerConnectionImpl::onMessageComplete() {
-  if (active_request_) {
+  ActiveRequest* request = decodingRequest();
+  if (request) {
     ENVOY_CONN_LOG(trace, "message complete", connection_);
     Buffer::OwnedImpl buffer;
-    active_request_->remote_complete_ = true;
+    request->remote_complete_ = true;
 
     if (deferred_end_stream_headers_) {
-      active_request_->request_decoder_->decodeHeaders(std::move(deferred_end_stream_headers_),
-                                                       true);
+      request->request_decoder_->decodeHeaders(std::move(deferred_end_stream_headers_), true);
       deferred_end_stream_headers_.reset();
     } else {
-      active_request_->request_decoder_->decodeData(buffer, true);
+      request->request_decoder_->decodeData(buffer, true);
     }
   }
 
-  // Always pause the parser so that the calling code can process 1 request at a time and apply
-  // back pressure. However this means that the calling code needs to detect if there is more data
-  // in the buffer and dispatch it again.
-  http_parser_pause(&parser_, 1);
+  // Without pipelining, always pause the parser so that the calling code can process 1 request at
+  // a time and apply back pressure. However this means that the calling code needs to detect if
+  // there is more data in the buffer and dispatch it again. With pipelining, only pause once the
+  // maximum number of requests are in flight.
+  if (codec_settings_.max_pipelined_requests_ <= 1 || !canPipeline()) {
+    parser_->pause();
+  }
 }
 
 void ServerConnectionImpl::onResetStream(StreamResetReason reason) {
-  ASSERT(active_request_);
-  active_request_->response_encoder_.runResetCallbacks(reason);
-  active_request_.reset();
+  ASSERT(!active_requests_.empty());
+  // A reset ends the connection, so it applies to every request in flight.
+  std::list<ActiveRequestPtr> requests;
+  requests.swap(active_requests_);
+  for (ActiveRequestPtr& request : requests) {
+    if (!request->complete()) {
+      request->response_encoder_.runResetCallbacks(reason);
+    }
+  }
 }
 
 void ServerConnectionImpl::sendProtocolError() {
@@ -586,7 +651,9 @@ void ServerConnectionImpl::sendProtocolError() {
   // layers can only operate on streams, so there is no coherent way to allow them to send an error
   // "out of band." On one hand this is kind of a hack but on the other hand it normalizes HTTP/1.1
   // to look more like HTTP/2 to higher layers.
-  if (!active_request_ || !active_request_->response_encoder_.startedResponse()) {
+  // Only the request at the front of the queue writes to the connection, so the error response can
+  // be sent as long as its response has not started.
+  if (active_requests_.empty() || !active_requests_.front()->response_encoder_.startedResponse()) {
     Buffer::OwnedImpl bad_request_response(
         fmt::format("HTTP/1.1 {} {}\r\ncontent-length: 0\r\nconnection: close\r\n\r\n",
                     std::to_string(enumToInt(error_code_)), CodeUtility::toString(error_code_)));
@@ -596,22 +663,26 @@ void ServerConnectionImpl::sendProtocolError() {
 }
 
 void ServerConnectionImpl::onAboveHighWatermark() {
-  if (active_request_) {
-    active_request_->response_encoder_.runHighWatermarkCallbacks();
+  for (ActiveRequestPtr& request : active_requests_) {
+    if (!request->complete()) {
+      request->response_encoder_.runHighWatermarkCallbacks();
+    }
   }
 }
 void ServerConnectionImpl::onBelowLowWatermark() {
-  if (active_request_) {
-    active_request_->response_encoder_.runLowWatermarkCallbacks();
+  for (ActiveRequestPtr& request : active_requests_) {
+    if (!request->complete()) {
+      request->response_encoder_.runLowWatermarkCallbacks();
+    }
   }
 }
 
 ClientConnectionImpl::ClientConnectionImpl(Network::Connection& connection, ConnectionCallbacks&)
-    : ConnectionImpl(connection, HTTP_RESPONSE) {}
+    : ConnectionImpl(connection, ParserType::Response) {}
 
 bool ClientConnectionImpl::cannotHaveBody() {
-  if ((!pending_responses_.empty() && pending_responses_.front().head_request_) ||
-      parser_.status_code == 204 || parser_.status_code == 304) {
+  if ((!pending_responses_.empty() && pending_responses_.front().encoder_->headRequest()) ||
+      parser_->statusCode() == 204 || parser_->statusCode() == 304) {
     return true;
   } else {
     return false;
@@ -625,22 +696,25 @@ StreamEncoder& ClientConnectionImpl::newStream(StreamDecoder& response_decoder)
   // Streams are responsible for unwinding any outstanding readDisable(true)
   // calls done on the underlying connection as they are destroyed. As this is
   // the only place a HTTP/1 stream is destroyed where the Network::Connection is
-  // reused, unwind any outstanding readDisable() calls here.
-  while (!connection_.readEnabled()) {
-    connection_.readDisable(false);
+  // reused, unwind any outstanding readDisable() calls here. A pipelined request
+  // must leave flow control alone as the responses ahead of it still own it.
+  if (pending_responses_.empty()) {
+    while (!connection_.readEnabled()) {
+      connection_.readDisable(false);
+    }
   }
-  request_encoder_.reset(new RequestStreamEncoderImpl(*this));
-  pending_responses_.emplace_back(&response_decoder);
-  return *request_encoder_;
-}
-
-void ClientConnectionImpl::onEncodeComplete() {
-  // Transfer head request state into the pending response before we reuse the encoder.
-  pending_responses_.back().head_request_ = request_encoder_->headRequest();
+  pending_responses_.emplace_back(*this, &response_decoder);
+  RequestStreamEncoderImpl& request_encoder = *pending_responses_.back().encoder_;
+  // If the requests ahead of this one have backed up the connection, this request starts out above
+  // the high watermark and is released along with them.
+  if (connection_.aboveHighWatermark()) {
+    request_encoder.runHighWatermarkCallbacks();
+  }
+  return request_encoder;
 }
 
 int ClientConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
-  headers->insertStatus().value(parser_.status_code);
+  headers->insertStatus().value(parser_->statusCode());
 
   // Handle the case where the client is closing a kept alive connection (by sending a 408
   // with a 'Connection: close' header). In this case we just let response flush out followed
@@ -648,7 +722,7 @@ int ClientConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
   if (pending_responses_.empty() && !resetStreamCalled()) {
     throw PrematureResponseException(std::move(headers));
   } else if (!pending_responses_.empty()) {
-    if (parser_.status_code == 100) {
+    if (parser_->statusCode() == 100) {
       // http-parser treats 100 continue headers as their own complete response.
       // Swallow the spurious onMessageComplete and continue processing.
       ignore_message_complete_for_100_continue_ = true;
@@ -682,7 +756,8 @@ void ClientConnectionImpl::onMessageComplete() {
   }
   if (!pending_responses_.empty()) {
     // After calling decodeData() with end stream set to true, we should no longer be able to reset.
-    PendingResponse response = pending_responses_.front();
+    // The encoder stays alive until the decoder callbacks have unwound.
+    PendingResponse response = std::move(pending_responses_.front());
     pending_responses_.pop_front();
 
     if (deferred_end_stream_headers_) {
@@ -692,29 +767,41 @@ void ClientConnectionImpl::onMessageComplete() {
       Buffer::OwnedImpl buffer;
       response.decoder_->decodeData(buffer, true);
     }
+
+    // The completed stream may not have unwound its readDisable() calls. Pipelined requests are
+    // still waiting on the connection, so unwind them here rather than in newStream().
+    if (!pending_responses_.empty() && !resetStreamCalled()) {
+      while (!connection_.readEnabled()) {
+        connection_.readDisable(false);
+      }
+    }
   }
 }
 
 void ClientConnectionImpl::onResetStream(StreamResetReason reason) {
   // Only raise reset if we did not already dispatch a complete response.
   if (!pending_responses_.empty()) {
-    pending_responses_.clear();
-    request_encoder_->runResetCallbacks(reason);
+    reset_responses_.splice(reset_responses_.end(), pending_responses_);
+    for (PendingResponse& response : reset_responses_) {
+      response.encoder_->runResetCallbacks(reason);
+    }
   }
 }
 
 void ClientConnectionImpl::onAboveHighWatermark() {
   // This should never happen without an active stream/request.
   ASSERT(!pending_responses_.empty());
-  request_encoder_->runHighWatermarkCallbacks();
+  for (PendingResponse& response : pending_responses_) {
+    response.encoder_->runHighWatermarkCallbacks();
+  }
 }
 
 void ClientConnectionImpl::onBelowLowWatermark() {
   // This can get called without an active stream/request when upstream decides to do bad things
   // such as sending multiple responses to the same request, causing us to close the connection, but
   // in doing so go below low watermark.
-  if (!pending_responses_.empty()) {
-    request_encoder_->runLowWatermarkCallbacks();
+  for (PendingResponse& response : pending_responses_) {
+    response.encoder_->runLowWatermarkCallbacks();
   }
 }
 
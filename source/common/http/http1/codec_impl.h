@@ -1,7 +1,5 @@
 #pragma once
 
-#include <http_parser.h>
-
 #include <array>
 #include <cstdint>
 #include <list>
@@ -17,6 +15,7 @@
 #include "common/http/codec_helper.h"
 #include "common/http/codes.h"
 #include "common/http/header_map_impl.h"
+#include "common/http/http1/parser.h"
 
 namespace Envoy {
 namespace Http {
@@ -48,9 +47,19 @@ public:
 
   void isResponseToHeadRequest(bool value) { is_response_to_head_request_ = value; }
 
+  /**
+   * @return bool whether the stream has been completely encoded.
+   */
+  bool encodeComplete() { return encode_complete_; }
+
 protected:
   StreamEncoderImpl(ConnectionImpl& connection) : connection_(connection) {}
 
+  /**
+   * Called to flush encoded output after each encode call.
+   */
+  virtual void flushOutput();
+
   static const std::string CRLF;
   static const std::string LAST_CHUNK;
 
@@ -74,6 +83,7 @@ private:
   bool chunk_encoding_{true};
   bool processing_100_continue_{false};
   bool is_response_to_head_request_{false};
+  bool encode_complete_{false};
 };
 
 /**
@@ -85,11 +95,28 @@ public:
 
   bool startedResponse() { return started_response_; }
 
+  /**
+   * Buffer the response instead of writing it to the connection until releaseOutput() is called.
+   * Used for responses to pipelined requests which must be sent in order. The held output is
+   * bounded by the connection's buffer limit, above which the stream's high watermark callbacks
+   * are run.
+   */
+  void holdOutput();
+
+  /**
+   * Write any held output to the connection and stop holding further output.
+   */
+  void releaseOutput();
+
   // Http::StreamEncoder
   void encodeHeaders(const HeaderMap& headers, bool end_stream) override;
 
 private:
+  // StreamEncoderImpl
+  void flushOutput() override;
+
   bool started_response_{};
+  Buffer::WatermarkBufferPtr held_output_;
 };
 
 /**
@@ -111,7 +138,9 @@ private:
 /**
  * Base class for HTTP/1.1 client and server connections.
  */
-class ConnectionImpl : public virtual Connection, protected Logger::Loggable<Logger::Id::http> {
+class ConnectionImpl : public virtual Connection,
+                       protected Logger::Loggable<Logger::Id::http>,
+                       private ParserCallbacks {
 public:
   /**
    * @return Network::Connection& the backing network connection.
@@ -135,6 +164,12 @@ public:
    */
   void flushOutput();
 
+  /**
+   * Move all pending output from encoding into a buffer instead of writing it to the connection.
+   * @param output supplies the buffer to move the output into.
+   */
+  void flushOutput(Buffer::Instance& output);
+
   void addCharToBuffer(char c);
   void addIntToBuffer(uint64_t i);
   Buffer::WatermarkBuffer& buffer() { return output_buffer_; }
@@ -156,12 +191,13 @@ public:
   virtual bool supports_http_10() { return false; }
 
 protected:
-  ConnectionImpl(Network::Connection& connection, http_parser_type type);
+  ConnectionImpl(Network::Connection& connection, ParserType type,
+                 Http1Settings::Parser parser = Http1Settings::Parser::HttpParser);
 
   bool resetStreamCalled() { return reset_stream_called_; }
 
   Network::Connection& connection_;
-  http_parser parser_;
+  ParserPtr parser_;
   HeaderMapPtr deferred_end_stream_headers_;
   Http::Code error_code_{Http::Code::BadRequest};
 
@@ -173,6 +209,11 @@ private:
    */
   void completeLastHeader();
 
+  /**
+   * Commit any reserved output to output_buffer_.
+   */
+  void commitReservedOutput();
+
   /**
    * Dispatch a memory span.
    * @param slice supplies the start address.
@@ -184,50 +225,31 @@ private:
    * Called when a request/response is beginning. A base routine happens first then a virtual
    * dispatch is invoked.
    */
-  void onMessageBeginBase();
+  void onMessageBeginBase() override;
   virtual void onMessageBegin() PURE;
 
-  /**
-   * Called when URL data is received.
-   * @param data supplies the start address.
-   * @param lenth supplies the length.
-   */
-  virtual void onUrl(const char* data, size_t length) PURE;
-
   /**
    * Called when header field data is received.
    * @param data supplies the start address.
    * @param length supplies the length.
    */
-  void onHeaderField(const char* data, size_t length);
+  void onHeaderField(const char* data, size_t length) override;
 
   /**
    * Called when header value data is received.
    * @param data supplies the start address.
    * @param length supplies the length.
    */
-  void onHeaderValue(const char* data, size_t length);
+  void onHeaderValue(const char* data, size_t length) override;
 
   /**
    * Called when headers are complete. A base routine happens first then a virtual disaptch is
    * invoked.
    * @return 0 if no error, 1 if there should be no body.
    */
-  int onHeadersCompleteBase();
+  int onHeadersCompleteBase() override;
   virtual int onHeadersComplete(HeaderMapImplPtr&& headers) PURE;
 
-  /**
-   * Called when body data is received.
-   * @param data supplies the start address.
-   * @param length supplies the length.
-   */
-  virtual void onBody(const char* data, size_t length) PURE;
-
-  /**
-   * Called when the request/response is complete.
-   */
-  virtual void onMessageComplete() PURE;
-
   /**
    * @see onResetStreamBase().
    */
@@ -250,7 +272,6 @@ private:
    */
   virtual void onBelowLowWatermark() PURE;
 
-  static http_parser_settings settings_;
   static const ToLowerTable& toLowerTable();
 
   HeaderMapImplPtr current_header_map_;
@@ -272,6 +293,9 @@ public:
   ServerConnectionImpl(Network::Connection& connection, ServerConnectionCallbacks& callbacks,
                        Http1Settings settings);
 
+  // Http::Connection
+  void dispatch(Buffer::Instance& data) override;
+
   virtual bool supports_http_10() override { return codec_settings_.accept_http_10_; }
 
 private:
@@ -281,21 +305,41 @@ private:
   struct ActiveRequest {
     ActiveRequest(ConnectionImpl& connection) : response_encoder_(connection) {}
 
+    /**
+     * @return bool whether both the request and the response are complete. A complete request
+     *         may still be waiting for the requests ahead of it to complete.
+     */
+    bool complete() { return remote_complete_ && response_encoder_.encodeComplete(); }
+
     HeaderString request_url_;
     StreamDecoder* request_decoder_{};
     ResponseStreamEncoderImpl response_encoder_;
     bool remote_complete_{};
   };
 
+  typedef std::unique_ptr<ActiveRequest> ActiveRequestPtr;
+
+  /**
+   * @return ActiveRequest* the request currently being decoded, or nullptr if there is none.
+   */
+  ActiveRequest* decodingRequest();
+
+  /**
+   * @return bool whether more requests may be decoded before responses to the requests in flight
+   *         have been sent. Only applies when pipelining is enabled.
+   */
+  bool canPipeline() { return active_requests_.size() < codec_settings_.max_pipelined_requests_; }
+
   /**
    * Manipulate the request's first line, parsing the url and converting to a relative path if
    * neccessary. Compute Host / :authority headers based on 7230#5.7 and 7230#6
    *
-   * @param is_connect true if the request has the CONNECT method
+   * @param request the request being decoded
    * @param headers the request's headers
+   * @param method the request's method
    * @throws CodecProtocolException on an invalid url in the request line
    */
-  void handlePath(HeaderMapImpl& headers, unsigned int method);
+  void handlePath(ActiveRequest& request, HeaderMapImpl& headers, unsigned int method);
 
   // ConnectionImpl
   void onEncodeComplete() override;
@@ -310,7 +354,9 @@ private:
   void onBelowLowWatermark() override;
 
   ServerConnectionCallbacks& callbacks_;
-  std::unique_ptr<ActiveRequest> active_request_;
+  // Requests in the order they were received. Only the request at the front writes its response
+  // to the connection; responses to pipelined requests behind it are held until it completes.
+  std::list<ActiveRequestPtr> active_requests_;
   Http1Settings codec_settings_;
 };
 
@@ -323,19 +369,25 @@ public:
 
   // Http::ClientConnection
   StreamEncoder& newStream(StreamDecoder& response_decoder) override;
+  uint32_t maxConcurrentStreams() override { return 1; }
 
 private:
+  /**
+   * A request awaiting its response. Each pipelined request owns its encoder so that the encoder
+   * outlives later calls to newStream() until the matching response has been decoded.
+   */
   struct PendingResponse {
-    PendingResponse(StreamDecoder* decoder) : decoder_(decoder) {}
+    PendingResponse(ConnectionImpl& connection, StreamDecoder* decoder)
+        : encoder_(new RequestStreamEncoderImpl(connection)), decoder_(decoder) {}
 
+    std::unique_ptr<RequestStreamEncoderImpl> encoder_;
     StreamDecoder* decoder_;
-    bool head_request_{};
   };
 
   bool cannotHaveBody();
 
   // ConnectionImpl
-  void onEncodeComplete() override;
+  void onEncodeComplete() override {}
   void onMessageBegin() override {}
   void onUrl(const char*, size_t) override { NOT_IMPLEMENTED; }
   int onHeadersComplete(HeaderMapImplPtr&& headers) override;
@@ -346,8 +398,10 @@ private:
   void onAboveHighWatermark() override;
   void onBelowLowWatermark() override;
 
-  std::unique_ptr<RequestStreamEncoderImpl> request_encoder_;
   std::list<PendingResponse> pending_responses_;
+  // Requests whose streams were reset. Their encoders are kept until the connection is destroyed as
+  // the reset may have been raised from within one of them.
+  std::list<PendingResponse> reset_responses_;
   // Set true between receiving 100-Continue headers and receiving the spurious onMessageComplete.
   bool ignore_message_complete_for_100_continue_{};
 };
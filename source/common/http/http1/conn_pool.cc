@@ -1,5 +1,6 @@
 #include "common/http/http1/conn_pool.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <list>
 
@@ -20,6 +21,25 @@ namespace Envoy {
 namespace Http {
 namespace Http1 {
 
+namespace {
+
+/**
+ * @return bool whether the request uses a method that RFC 7231 section 4.2.2 defines as idempotent.
+ */
+bool isIdempotent(const HeaderMap& headers) {
+  if (headers.Method() == nullptr) {
+    return false;
+  }
+
+  const HeaderString& method = headers.Method()->value();
+  const auto& values = Headers::get().MethodValues;
+  return method == values.Get.c_str() || method == values.Head.c_str() ||
+         method == values.Options.c_str() || method == values.Trace.c_str() ||
+         method == values.Put.c_str() || method == values.Delete.c_str();
+}
+
+} // namespace
+
 ConnPoolImpl::ConnPoolImpl(Event::Dispatcher& dispatcher, Upstream::HostConstSharedPtr host,
                            Upstream::ResourcePriority priority,
                            const Network::ConnectionSocket::OptionsSharedPtr& options)
@@ -35,6 +55,10 @@ ConnPoolImpl::~ConnPoolImpl() {
     busy_clients_.front()->codec_client_->close();
   }
 
+  while (!pipelining_clients_.empty()) {
+    pipelining_clients_.front()->codec_client_->close();
+  }
+
   // Make sure all clients are destroyed before we are destroyed.
   dispatcher_.clearDeferredDeleteList();
 }
@@ -44,10 +68,14 @@ void ConnPoolImpl::drainConnections() {
     ready_clients_.front()->codec_client_->close();
   }
 
-  // We drain busy clients by manually setting remaining requests to 1. Thus, when the next
-  // response completes the client will be destroyed.
+  // We drain busy clients by manually setting remaining requests to the number of outstanding
+  // requests (at least 1). Thus, when the last of those responses completes the client will be
+  // destroyed, and no further requests are pipelined onto it in the meantime.
   for (const auto& client : busy_clients_) {
-    client->remaining_requests_ = 1;
+    client->remaining_requests_ = std::max<uint64_t>(1, client->stream_wrappers_.size());
+  }
+  for (const auto& client : pipelining_clients_) {
+    client->remaining_requests_ = client->stream_wrappers_.size();
   }
 }
 
@@ -58,13 +86,49 @@ void ConnPoolImpl::addDrainedCallback(DrainedCb cb) {
 
 void ConnPoolImpl::attachRequestToClient(ActiveClient& client, StreamDecoder& response_decoder,
                                          ConnectionPool::Callbacks& callbacks) {
-  ASSERT(!client.stream_wrapper_);
-  client.stream_wrapper_.reset(new StreamWrapper(response_decoder, client));
-  callbacks.onPoolReady(*client.stream_wrapper_, client.real_host_description_);
+  ASSERT(client.stream_wrappers_.empty() || client.canPipeline());
+  if (!client.stream_wrappers_.empty()) {
+    ENVOY_CONN_LOG(debug, "pipelining request behind {} others", *client.codec_client_,
+                   client.stream_wrappers_.size());
+    host_->cluster().stats().upstream_rq_pipelined_.inc();
+    host_->cluster().stats().upstream_rq_pipeline_depth_.recordValue(
+        client.stream_wrappers_.size() + 1);
+  }
+
+  requests_attached_++;
+  client.stream_wrappers_.emplace_back(new StreamWrapper(response_decoder, client));
+  callbacks.onPoolReady(*client.stream_wrappers_.back(), client.real_host_description_);
+}
+
+ConnPoolImpl::ActiveClient* ConnPoolImpl::availableClient() {
+  // Clients are pushed onto the front of the ready list as they go idle, so the front is the most
+  // recently used connection.
+  if (!ready_clients_.empty()) {
+    ActiveClient& client = *ready_clients_.front();
+    host_->cluster().stats().upstream_cx_reuse_distance_.recordValue(requests_attached_ -
+                                                                      client.idle_since_);
+    client.moveBetweenLists(ready_clients_, busy_clients_);
+    return &client;
+  }
+
+  // Attaching a request means the client cannot take another until that request is encoded, so
+  // move it to the busy list first. Clients that can no longer pipeline (e.g., because they saw a
+  // 'connection: close' header) are moved there too.
+  while (!pipelining_clients_.empty()) {
+    ActiveClient& client = *pipelining_clients_.front();
+    client.moveBetweenLists(pipelining_clients_, busy_clients_);
+    client.pipelining_ = false;
+    if (client.canPipeline()) {
+      return &client;
+    }
+  }
+
+  return nullptr;
 }
 
 void ConnPoolImpl::checkForDrained() {
-  if (!drained_callbacks_.empty() && pending_requests_.empty() && busy_clients_.empty()) {
+  if (!drained_callbacks_.empty() && pending_requests_.empty() && busy_clients_.empty() &&
+      pipelining_clients_.empty()) {
     while (!ready_clients_.empty()) {
       ready_clients_.front()->codec_client_->close();
     }
@@ -81,12 +145,28 @@ void ConnPoolImpl::createNewConnection() {
   client->moveIntoList(std::move(client), busy_clients_);
 }
 
+void ConnPoolImpl::checkForPipelining(ActiveClient& client) {
+  if (client.pipelining_ || client.stream_wrappers_.empty() || !client.canPipeline()) {
+    return;
+  }
+
+  ENVOY_CONN_LOG(debug, "moving to pipelining", *client.codec_client_);
+  client.moveBetweenLists(busy_clients_, pipelining_clients_);
+  client.pipelining_ = true;
+
+  // Attach pending requests in the next dispatcher loop rather than from within the encode of the
+  // request that made this client available.
+  if (!pending_requests_.empty()) {
+    scheduleOnUpstreamReady();
+  }
+}
+
 ConnectionPool::Cancellable* ConnPoolImpl::newStream(StreamDecoder& response_decoder,
                                                      ConnectionPool::Callbacks& callbacks) {
-  if (!ready_clients_.empty()) {
-    ready_clients_.front()->moveBetweenLists(ready_clients_, busy_clients_);
-    ENVOY_CONN_LOG(debug, "using existing connection", *busy_clients_.front()->codec_client_);
-    attachRequestToClient(*busy_clients_.front(), response_decoder, callbacks);
+  ActiveClient* client = availableClient();
+  if (client != nullptr) {
+    ENVOY_CONN_LOG(debug, "using existing connection", *client->codec_client_);
+    attachRequestToClient(*client, response_decoder, callbacks);
     return nullptr;
   }
 
@@ -98,7 +178,9 @@ ConnectionPool::Cancellable* ConnPoolImpl::newStream(StreamDecoder& response_dec
     }
 
     // If we have no connections at all, make one no matter what so we don't starve.
-    if ((ready_clients_.size() == 0 && busy_clients_.size() == 0) || can_create_connection) {
+    if ((ready_clients_.size() == 0 && busy_clients_.size() == 0 &&
+         pipelining_clients_.size() == 0) ||
+        can_create_connection) {
       createNewConnection();
     }
 
@@ -121,8 +203,9 @@ void ConnPoolImpl::onConnectionEvent(ActiveClient& client, Network::ConnectionEv
     ENVOY_CONN_LOG(debug, "client disconnected", *client.codec_client_);
     ActiveClientPtr removed;
     bool check_for_drained = true;
-    if (client.stream_wrapper_) {
-      if (!client.stream_wrapper_->decode_complete_) {
+    if (!client.stream_wrappers_.empty()) {
+      // Responses complete in order, so the newest request is the last to be decoded.
+      if (!client.stream_wrappers_.back()->decode_complete_) {
         if (event == Network::ConnectionEvent::LocalClose) {
           host_->cluster().stats().upstream_cx_destroy_local_with_active_rq_.inc();
         }
@@ -132,10 +215,10 @@ void ConnPoolImpl::onConnectionEvent(ActiveClient& client, Network::ConnectionEv
         host_->cluster().stats().upstream_cx_destroy_with_active_rq_.inc();
       }
 
-      // There is an active request attached to this client. The underlying codec client will
-      // already have "reset" the stream to fire the reset callback. All we do here is just
+      // There are active requests attached to this client. The underlying codec client will
+      // already have "reset" the streams to fire the reset callbacks. All we do here is just
       // destroy the client.
-      removed = client.removeFromList(busy_clients_);
+      removed = client.removeFromList(client.pipelining_ ? pipelining_clients_ : busy_clients_);
     } else if (!client.connect_timer_) {
       // The connect timer is destroyed on connect. The lack of a connect timer means that this
       // client is idle and in the ready pool.
@@ -166,7 +249,8 @@ void ConnPoolImpl::onConnectionEvent(ActiveClient& client, Network::ConnectionEv
     dispatcher_.deferredDelete(std::move(removed));
 
     // If we have pending requests and we just lost a connection we should make a new one.
-    if (pending_requests_.size() > (ready_clients_.size() + busy_clients_.size())) {
+    if (pending_requests_.size() >
+        (ready_clients_.size() + busy_clients_.size() + pipelining_clients_.size())) {
       createNewConnection();
     }
 
@@ -204,10 +288,11 @@ void ConnPoolImpl::onPendingRequestCancel(PendingRequest& request) {
 
 void ConnPoolImpl::onResponseComplete(ActiveClient& client) {
   ENVOY_CONN_LOG(debug, "response complete", *client.codec_client_);
-  if (!client.stream_wrapper_->encode_complete_) {
+  const StreamWrapper& stream_wrapper = *client.stream_wrappers_.front();
+  if (!stream_wrapper.encode_complete_) {
     ENVOY_CONN_LOG(debug, "response before request complete", *client.codec_client_);
     onDownstreamReset(client);
-  } else if (client.stream_wrapper_->saw_close_header_ || client.codec_client_->remoteClosed()) {
+  } else if (stream_wrapper.saw_close_header_ || client.codec_client_->remoteClosed()) {
     ENVOY_CONN_LOG(debug, "saw upstream connection: close", *client.codec_client_);
     onDownstreamReset(client);
   } else if (client.remaining_requests_ > 0 && --client.remaining_requests_ == 0) {
@@ -215,33 +300,48 @@ void ConnPoolImpl::onResponseComplete(ActiveClient& client) {
     host_->cluster().stats().upstream_cx_max_requests_.inc();
     onDownstreamReset(client);
   } else {
-    // Upstream connection might be closed right after response is complete. Setting delay=true
-    // here to attach pending requests in next dispatcher loop to handle that case.
-    // https://github.com/envoyproxy/envoy/issues/2715
-    processIdleClient(client, true);
+    client.stream_wrappers_.pop_front();
+    if (client.stream_wrappers_.empty()) {
+      // Upstream connection might be closed right after response is complete. Setting delay=true
+      // here to attach pending requests in next dispatcher loop to handle that case.
+      // https://github.com/envoyproxy/envoy/issues/2715
+      processIdleClient(client, true);
+    } else {
+      // Pipelined requests are still outstanding. The client may now have room for another.
+      checkForPipelining(client);
+    }
   }
 }
 
 void ConnPoolImpl::onUpstreamReady() {
   upstream_ready_enabled_ = false;
-  while (!pending_requests_.empty() && !ready_clients_.empty()) {
-    ActiveClient& client = *ready_clients_.front();
-    ENVOY_CONN_LOG(debug, "attaching to next request", *client.codec_client_);
-    // There is work to do so bind a request to the client and move it to the busy list. Pending
-    // requests are pushed onto the front, so pull from the back.
-    attachRequestToClient(client, pending_requests_.back()->decoder_,
+  while (!pending_requests_.empty()) {
+    ActiveClient* client = availableClient();
+    if (client == nullptr) {
+      break;
+    }
+
+    ENVOY_CONN_LOG(debug, "attaching to next request", *client->codec_client_);
+    // There is work to do so bind a request to the client, which availableClient() has moved to
+    // the busy list. Pending requests are pushed onto the front, so pull from the back.
+    attachRequestToClient(*client, pending_requests_.back()->decoder_,
                           pending_requests_.back()->callbacks_);
     pending_requests_.pop_back();
-    client.moveBetweenLists(ready_clients_, busy_clients_);
   }
 }
 
 void ConnPoolImpl::processIdleClient(ActiveClient& client, bool delay) {
-  client.stream_wrapper_.reset();
+  ASSERT(client.stream_wrappers_.empty());
+  if (client.pipelining_) {
+    client.moveBetweenLists(pipelining_clients_, busy_clients_);
+    client.pipelining_ = false;
+  }
+
   if (pending_requests_.empty() || delay) {
     // There is nothing to service or delayed processing is requested, so just move the connection
     // into the ready list.
     ENVOY_CONN_LOG(debug, "moving to ready", *client.codec_client_);
+    client.idle_since_ = requests_attached_;
     client.moveBetweenLists(busy_clients_, ready_clients_);
   } else {
     // There is work to do immediately so bind a request to the client and move it to the busy list.
@@ -252,14 +352,20 @@ void ConnPoolImpl::processIdleClient(ActiveClient& client, bool delay) {
     pending_requests_.pop_back();
   }
 
-  if (delay && !pending_requests_.empty() && !upstream_ready_enabled_) {
-    upstream_ready_enabled_ = true;
-    upstream_ready_timer_->enableTimer(std::chrono::milliseconds(0));
+  if (delay && !pending_requests_.empty()) {
+    scheduleOnUpstreamReady();
   }
 
   checkForDrained();
 }
 
+void ConnPoolImpl::scheduleOnUpstreamReady() {
+  if (!upstream_ready_enabled_) {
+    upstream_ready_enabled_ = true;
+    upstream_ready_timer_->enableTimer(std::chrono::milliseconds(0));
+  }
+}
+
 ConnPoolImpl::StreamWrapper::StreamWrapper(StreamDecoder& response_decoder, ActiveClient& parent)
     : StreamEncoderWrapper(parent.codec_client_->newStream(*this)),
       StreamDecoderWrapper(response_decoder), parent_(parent) {
@@ -276,7 +382,16 @@ ConnPoolImpl::StreamWrapper::~StreamWrapper() {
   parent_.parent_.host_->stats().rq_active_.dec();
 }
 
-void ConnPoolImpl::StreamWrapper::onEncodeComplete() { encode_complete_ = true; }
+void ConnPoolImpl::StreamWrapper::encodeHeaders(const HeaderMap& headers, bool end_stream) {
+  // This must be known before the base class raises onEncodeComplete().
+  idempotent_ = isIdempotent(headers);
+  StreamEncoderWrapper::encodeHeaders(headers, end_stream);
+}
+
+void ConnPoolImpl::StreamWrapper::onEncodeComplete() {
+  encode_complete_ = true;
+  parent_.parent_.checkForPipelining(parent_);
+}
 
 void ConnPoolImpl::StreamWrapper::decodeHeaders(HeaderMapPtr&& headers, bool end_stream) {
   if (headers->Connection() &&
@@ -290,6 +405,7 @@ void ConnPoolImpl::StreamWrapper::decodeHeaders(HeaderMapPtr&& headers, bool end
 }
 
 void ConnPoolImpl::StreamWrapper::onDecodeComplete() {
+  ASSERT(parent_.stream_wrappers_.front().get() == this);
   decode_complete_ = encode_complete_;
   parent_.parent_.onResponseComplete(parent_);
 }
@@ -344,6 +460,24 @@ ConnPoolImpl::ActiveClient::~ActiveClient() {
   parent_.host_->cluster().resourceManager(parent_.priority_).connections().dec();
 }
 
+bool ConnPoolImpl::ActiveClient::canPipeline() const {
+  if (stream_wrappers_.size() >=
+          parent_.host_->cluster().http1Settings().max_pipelined_requests_ ||
+      (remaining_requests_ > 0 && stream_wrappers_.size() >= remaining_requests_) ||
+      codec_client_->remoteClosed()) {
+    return false;
+  }
+
+  for (const StreamWrapperPtr& stream_wrapper : stream_wrappers_) {
+    if (!stream_wrapper->encode_complete_ || !stream_wrapper->idempotent_ ||
+        stream_wrapper->saw_close_header_) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 void ConnPoolImpl::ActiveClient::onConnectTimeout() {
   // We just close the client at this point. This will result in both a timeout and a connect
   // failure and will fold into all the normal connect failure logic.
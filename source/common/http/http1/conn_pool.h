@@ -23,6 +23,13 @@ namespace Http1 {
 
 /**
  * A connection pool implementation for HTTP/1.1 connections.
+ *
+ * Idle connections are reused most recently used first. This keeps the busy set of connections
+ * warm and lets the remainder go unused long enough for the cluster's idle timeout to close them.
+ * If the cluster allows pipelining (Http1Settings::max_pipelined_requests_), further requests are
+ * sent on a busy connection once every request outstanding on it has been fully encoded and is
+ * idempotent (RFC 7230 section 6.3.2).
+ *
  * NOTE: The connection pool does NOT do DNS resolution. It assumes it is being given a numeric IP
  *       address. Higher layer code should handle resolving DNS on error and creating a new pool
  *       bound to a different IP address.
@@ -52,6 +59,7 @@ protected:
     ~StreamWrapper();
 
     // StreamEncoderWrapper
+    void encodeHeaders(const HeaderMap& headers, bool end_stream) override;
     void onEncodeComplete() override;
 
     // StreamDecoderWrapper
@@ -68,6 +76,7 @@ protected:
     bool encode_complete_{};
     bool saw_close_header_{};
     bool decode_complete_{};
+    bool idempotent_{};
   };
 
   typedef std::unique_ptr<StreamWrapper> StreamWrapperPtr;
@@ -78,6 +87,10 @@ protected:
     ActiveClient(ConnPoolImpl& parent);
     ~ActiveClient();
 
+    /**
+     * @return bool whether another request can be pipelined behind the outstanding ones.
+     */
+    bool canPipeline() const;
     void onConnectTimeout();
 
     // Network::ConnectionCallbacks
@@ -90,10 +103,15 @@ protected:
     ConnPoolImpl& parent_;
     CodecClientPtr codec_client_;
     Upstream::HostDescriptionConstSharedPtr real_host_description_;
-    StreamWrapperPtr stream_wrapper_;
+    // Outstanding requests in the order they were sent. The front receives the next response.
+    std::list<StreamWrapperPtr> stream_wrappers_;
     Event::TimerPtr connect_timer_;
     Stats::TimespanPtr conn_length_;
     uint64_t remaining_requests_;
+    // The value of ConnPoolImpl::requests_attached_ when this client last became ready.
+    uint64_t idle_since_{};
+    // Whether this client is in pipelining_clients_ rather than busy_clients_.
+    bool pipelining_{};
   };
 
   typedef std::unique_ptr<ActiveClient> ActiveClientPtr;
@@ -115,8 +133,10 @@ protected:
 
   void attachRequestToClient(ActiveClient& client, StreamDecoder& response_decoder,
                              ConnectionPool::Callbacks& callbacks);
+  ActiveClient* availableClient();
   virtual CodecClientPtr createCodecClient(Upstream::Host::CreateConnectionData& data) PURE;
   void checkForDrained();
+  void checkForPipelining(ActiveClient& client);
   void createNewConnection();
   void onConnectionEvent(ActiveClient& client, Network::ConnectionEvent event);
   void onDownstreamReset(ActiveClient& client);
@@ -124,18 +144,23 @@ protected:
   void onResponseComplete(ActiveClient& client);
   void onUpstreamReady();
   void processIdleClient(ActiveClient& client, bool delay);
+  void scheduleOnUpstreamReady();
 
   Stats::TimespanPtr conn_connect_ms_;
   Event::Dispatcher& dispatcher_;
   Upstream::HostConstSharedPtr host_;
   std::list<ActiveClientPtr> ready_clients_;
   std::list<ActiveClientPtr> busy_clients_;
+  // Busy clients that can accept another pipelined request.
+  std::list<ActiveClientPtr> pipelining_clients_;
   std::list<PendingRequestPtr> pending_requests_;
   std::list<DrainedCb> drained_callbacks_;
   Upstream::ResourcePriority priority_;
   const Network::ConnectionSocket::OptionsSharedPtr socket_options_;
   Event::TimerPtr upstream_ready_timer_;
   bool upstream_ready_enabled_{false};
+  // Total requests attached to clients, used to measure how long ready clients sit idle.
+  uint64_t requests_attached_{};
 };
 
 /**
@@ -0,0 +1,60 @@
+#include "common/http/http1/http_parser_impl.h"
+
+#include <climits>
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+http_parser_settings HttpParserImpl::settings_{
+    [](http_parser* parser) -> int {
+      static_cast<ParserCallbacks*>(parser->data)->onMessageBeginBase();
+      return 0;
+    },
+    [](http_parser* parser, const char* at, size_t length) -> int {
+      static_cast<ParserCallbacks*>(parser->data)->onUrl(at, length);
+      return 0;
+    },
+    nullptr, // on_status
+    [](http_parser* parser, const char* at, size_t length) -> int {
+      static_cast<ParserCallbacks*>(parser->data)->onHeaderField(at, length);
+      return 0;
+    },
+    [](http_parser* parser, const char* at, size_t length) -> int {
+      static_cast<ParserCallbacks*>(parser->data)->onHeaderValue(at, length);
+      return 0;
+    },
+    [](http_parser* parser) -> int {
+      return static_cast<ParserCallbacks*>(parser->data)->onHeadersCompleteBase();
+    },
+    [](http_parser* parser, const char* at, size_t length) -> int {
+      static_cast<ParserCallbacks*>(parser->data)->onBody(at, length);
+      return 0;
+    },
+    [](http_parser* parser) -> int {
+      static_cast<ParserCallbacks*>(parser->data)->onMessageComplete();
+      return 0;
+    },
+    nullptr, // on_chunk_header
+    nullptr  // on_chunk_complete
+};
+
+HttpParserImpl::HttpParserImpl(ParserType type, ParserCallbacks& callbacks) {
+  http_parser_init(&parser_, type == ParserType::Request ? HTTP_REQUEST : HTTP_RESPONSE);
+  parser_.data = &callbacks;
+}
+
+size_t HttpParserImpl::execute(const char* data, size_t length) {
+  return http_parser_execute(&parser_, &settings_, data, length);
+}
+
+absl::optional<uint64_t> HttpParserImpl::contentLength() const {
+  if (parser_.content_length == ULLONG_MAX) {
+    return absl::nullopt;
+  }
+  return parser_.content_length;
+}
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
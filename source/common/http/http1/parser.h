@@ -0,0 +1,145 @@
+#pragma once
+
+#include <http_parser.h>
+
+#include <cstdint>
+#include <memory>
+
+#include "envoy/common/pure.h"
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+/**
+ * The kind of messages a parser parses.
+ */
+enum class ParserType { Request, Response };
+
+/**
+ * Callbacks raised by a Parser while parsing. Data passed to the callbacks points into the span
+ * passed to Parser::execute() and is only valid for the duration of the callback. The url, each
+ * header field and value, and the body may each be delivered in several pieces.
+ */
+class ParserCallbacks {
+public:
+  virtual ~ParserCallbacks() {}
+
+  /**
+   * Called when the first byte of a message is parsed.
+   */
+  virtual void onMessageBeginBase() PURE;
+
+  /**
+   * Called with request target (url) data.
+   * @param data supplies the start address.
+   * @param length supplies the length.
+   */
+  virtual void onUrl(const char* data, size_t length) PURE;
+
+  /**
+   * Called with header field data.
+   * @param data supplies the start address.
+   * @param length supplies the length.
+   */
+  virtual void onHeaderField(const char* data, size_t length) PURE;
+
+  /**
+   * Called with header value data. Called at least once, possibly with zero length, for each
+   * header.
+   * @param data supplies the start address.
+   * @param length supplies the length.
+   */
+  virtual void onHeaderValue(const char* data, size_t length) PURE;
+
+  /**
+   * Called when all headers of a message have been parsed.
+   * @return 0 if no error, 1 if the message has no body regardless of what its headers say.
+   */
+  virtual int onHeadersCompleteBase() PURE;
+
+  /**
+   * Called with body data. Chunk framing has already been removed.
+   * @param data supplies the start address.
+   * @param length supplies the length.
+   */
+  virtual void onBody(const char* data, size_t length) PURE;
+
+  /**
+   * Called when a message is complete.
+   */
+  virtual void onMessageComplete() PURE;
+};
+
+/**
+ * An incremental HTTP/1 parser. Errors and methods use the http_parser enums so that every
+ * implementation reports them the same way.
+ */
+class Parser {
+public:
+  virtual ~Parser() {}
+
+  /**
+   * Parse a span of data, raising callbacks as messages are parsed. Parsing stops early if a
+   * callback pauses the parser or an error is found.
+   * @param data supplies the start address. An empty span signals the end of the connection.
+   * @param length supplies the length.
+   * @return size_t the number of bytes consumed.
+   */
+  virtual size_t execute(const char* data, size_t length) PURE;
+
+  /**
+   * Pause the parser. execute() returns as soon as the current callback returns and parses nothing
+   * more until resume() is called.
+   */
+  virtual void pause() PURE;
+
+  /**
+   * Resume a paused parser.
+   */
+  virtual void resume() PURE;
+
+  /**
+   * @return http_errno HPE_OK, HPE_PAUSED if paused, or the error that stopped parsing.
+   */
+  virtual http_errno error() const PURE;
+
+  /**
+   * @return http_method the method of the current request.
+   */
+  virtual http_method method() const PURE;
+
+  /**
+   * @return uint16_t the status code of the current response.
+   */
+  virtual uint16_t statusCode() const PURE;
+
+  /**
+   * @return uint16_t the major HTTP version of the current message.
+   */
+  virtual uint16_t httpMajor() const PURE;
+
+  /**
+   * @return uint16_t the minor HTTP version of the current message.
+   */
+  virtual uint16_t httpMinor() const PURE;
+
+  /**
+   * @return bool whether the current message has a chunked body. Valid once headers are complete.
+   */
+  virtual bool isChunked() const PURE;
+
+  /**
+   * @return absl::optional<uint64_t> the content length of the current message, if it has one.
+   *         Valid in onHeadersCompleteBase().
+   */
+  virtual absl::optional<uint64_t> contentLength() const PURE;
+};
+
+typedef std::unique_ptr<Parser> ParserPtr;
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
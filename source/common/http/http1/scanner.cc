@@ -0,0 +1,183 @@
+#include "common/http/http1/scanner.h"
+
+#include <array>
+#include <cstdint>
+
+#include "common/common/assert.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ENVOY_HTTP1_SCANNER_X86
+#include <immintrin.h>
+#endif
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+namespace {
+
+// Bytes that end a header value: CTL other than HTAB, and DEL.
+bool endsValue(uint8_t c) { return (c < 0x20 && c != '\t') || c == 0x7f; }
+
+// Bytes that end a request target: CTL, SP, and DEL.
+bool endsTarget(uint8_t c) { return c <= 0x20 || c == 0x7f; }
+
+template <bool (*Ends)(uint8_t)> struct Table {
+  Table() {
+    for (size_t c = 0; c < 256; c++) {
+      ends_[c] = Ends(c);
+    }
+  }
+  std::array<bool, 256> ends_;
+};
+
+const Table<endsValue> value_table_;
+const Table<endsTarget> target_table_;
+
+const char* scalarFindValueEnd(const char* begin, const char* end) {
+  while (begin != end && !value_table_.ends_[static_cast<uint8_t>(*begin)]) {
+    begin++;
+  }
+  return begin;
+}
+
+const char* scalarFindTargetEnd(const char* begin, const char* end) {
+  while (begin != end && !target_table_.ends_[static_cast<uint8_t>(*begin)]) {
+    begin++;
+  }
+  return begin;
+}
+
+#ifdef ENVOY_HTTP1_SCANNER_X86
+
+// SSE4.2: PCMPESTRI compares each 16 byte block against a set of byte ranges and returns the index
+// of the first byte in any range, or 16 if there is none. The ranges are loaded as 16 bytes, so
+// the arrays are padded to that size; the explicit length passed to PCMPESTRI excludes the padding.
+alignas(16) const char value_ranges_[16] = "\x00\x08\x0a\x1f\x7f\x7f";
+alignas(16) const char target_ranges_[16] = "\x00\x20\x7f\x7f";
+
+__attribute__((target("sse4.2"))) const char* sse42FindValueEnd(const char* begin,
+                                                                 const char* end) {
+  // 3 ranges of 2 bytes each.
+  const __m128i ranges = _mm_load_si128(reinterpret_cast<const __m128i*>(value_ranges_));
+  while (end - begin >= 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    const int index = _mm_cmpestri(ranges, 6, block, 16,
+                                   _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+    if (index != 16) {
+      return begin + index;
+    }
+    begin += 16;
+  }
+  return scalarFindValueEnd(begin, end);
+}
+
+__attribute__((target("sse4.2"))) const char* sse42FindTargetEnd(const char* begin,
+                                                                  const char* end) {
+  // 2 ranges of 2 bytes each.
+  const __m128i ranges = _mm_load_si128(reinterpret_cast<const __m128i*>(target_ranges_));
+  while (end - begin >= 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    const int index = _mm_cmpestri(ranges, 4, block, 16,
+                                   _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+    if (index != 16) {
+      return begin + index;
+    }
+    begin += 16;
+  }
+  return scalarFindTargetEnd(begin, end);
+}
+
+// AVX2: classify 32 bytes at a time with saturating subtraction (c <= limit iff c -sat limit == 0)
+// and equality tests, then find the first set bit of the combined mask.
+__attribute__((target("avx2"))) const char* avx2FindValueEnd(const char* begin,
+                                                              const char* end) {
+  const __m256i ctl_limit = _mm256_set1_epi8(0x1f);
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i del = _mm256_set1_epi8(0x7f);
+  const __m256i zero = _mm256_setzero_si256();
+  while (end - begin >= 32) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+    const __m256i ctl = _mm256_cmpeq_epi8(_mm256_subs_epu8(block, ctl_limit), zero);
+    const __m256i ends =
+        _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi8(block, tab), ctl),
+                        _mm256_cmpeq_epi8(block, del));
+    const uint32_t mask = _mm256_movemask_epi8(ends);
+    if (mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+    begin += 32;
+  }
+  return scalarFindValueEnd(begin, end);
+}
+
+__attribute__((target("avx2"))) const char* avx2FindTargetEnd(const char* begin,
+                                                               const char* end) {
+  const __m256i ctl_limit = _mm256_set1_epi8(0x20);
+  const __m256i del = _mm256_set1_epi8(0x7f);
+  const __m256i zero = _mm256_setzero_si256();
+  while (end - begin >= 32) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+    const __m256i ends = _mm256_or_si256(
+        _mm256_cmpeq_epi8(_mm256_subs_epu8(block, ctl_limit), zero), _mm256_cmpeq_epi8(block, del));
+    const uint32_t mask = _mm256_movemask_epi8(ends);
+    if (mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+    begin += 32;
+  }
+  return scalarFindTargetEnd(begin, end);
+}
+
+#endif
+
+} // namespace
+
+const Scanner::Functions* Scanner::functions(Impl impl) {
+  static const Functions scalar{Impl::Scalar, scalarFindValueEnd, scalarFindTargetEnd};
+#ifdef ENVOY_HTTP1_SCANNER_X86
+  static const Functions sse42{Impl::Sse42, sse42FindValueEnd, sse42FindTargetEnd};
+  static const Functions avx2{Impl::Avx2, avx2FindValueEnd, avx2FindTargetEnd};
+#endif
+
+  switch (impl) {
+  case Impl::Scalar:
+    return &scalar;
+#ifdef ENVOY_HTTP1_SCANNER_X86
+  case Impl::Sse42:
+    return __builtin_cpu_supports("sse4.2") ? &sse42 : nullptr;
+  case Impl::Avx2:
+    return __builtin_cpu_supports("avx2") ? &avx2 : nullptr;
+#else
+  case Impl::Sse42:
+  case Impl::Avx2:
+    return nullptr;
+#endif
+  }
+
+  NOT_REACHED;
+}
+
+const Scanner::Functions* Scanner::bestImpl() {
+#ifdef ENVOY_HTTP1_SCANNER_X86
+  __builtin_cpu_init();
+#endif
+  for (Impl impl : {Impl::Avx2, Impl::Sse42}) {
+    if (functions(impl) != nullptr) {
+      return functions(impl);
+    }
+  }
+  return functions(Impl::Scalar);
+}
+
+bool Scanner::supported(Impl impl) { return functions(impl) != nullptr; }
+
+void Scanner::setImpl(Impl impl) {
+  ASSERT(supported(impl));
+  impl_ = functions(impl);
+}
+
+const Scanner::Functions* Scanner::impl_ = Scanner::bestImpl();
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+/**
+ * Vectorized searches for the bytes that end the variable length parts of an HTTP/1 message. These
+ * are where a parser spends most of its time, so they are implemented with SSE4.2 and AVX2
+ * instructions in addition to a scalar fallback. The fastest implementation the CPU supports is
+ * selected when the process starts.
+ */
+class Scanner {
+public:
+  enum class Impl { Scalar, Sse42, Avx2 };
+
+  /**
+   * Find the end of a run of header value (or reason phrase) bytes.
+   * @param begin supplies the start of the data.
+   * @param end supplies the end of the data.
+   * @return const char* the first byte in [begin, end) that may not appear in a header value, i.e.
+   *         a control character other than HTAB, or DEL. end if there is none.
+   */
+  static const char* findValueEnd(const char* begin, const char* end) {
+    return impl_->find_value_end_(begin, end);
+  }
+
+  /**
+   * Find the end of a run of request target bytes.
+   * @param begin supplies the start of the data.
+   * @param end supplies the end of the data.
+   * @return const char* the first byte in [begin, end) that may not appear in a request target,
+   *         i.e. a control character, SP, or DEL. end if there is none.
+   */
+  static const char* findTargetEnd(const char* begin, const char* end) {
+    return impl_->find_target_end_(begin, end);
+  }
+
+  /**
+   * @param impl supplies an implementation.
+   * @return bool whether the implementation is supported by this build and CPU.
+   */
+  static bool supported(Impl impl);
+
+  /**
+   * Select the implementation to use. For tests and benchmarks.
+   * @param impl supplies the implementation, which must be supported.
+   */
+  static void setImpl(Impl impl);
+
+  /**
+   * @return Impl the implementation in use.
+   */
+  static Impl impl() { return impl_->impl_; }
+
+private:
+  typedef const char* (*FindFn)(const char* begin, const char* end);
+
+  struct Functions {
+    Impl impl_;
+    FindFn find_value_end_;
+    FindFn find_target_end_;
+  };
+
+  static const Functions* bestImpl();
+  static const Functions* functions(Impl impl);
+
+  static const Functions* impl_;
+};
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
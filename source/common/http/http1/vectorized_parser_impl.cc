@@ -0,0 +1,637 @@
+#include "common/http/http1/vectorized_parser_impl.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "common/common/assert.h"
+#include "common/common/utility.h"
+#include "common/http/http1/scanner.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+namespace {
+
+struct MethodName {
+  http_method method_;
+  absl::string_view name_;
+};
+
+#define METHOD_NAME(num, name, string) {HTTP_##name, #string},
+const MethodName method_names_[] = {HTTP_METHOD_MAP(METHOD_NAME)};
+#undef METHOD_NAME
+
+// tchar from RFC 7230 section 3.2.6.
+struct TokenTable {
+  TokenTable() {
+    for (size_t c = 0; c < 256; c++) {
+      token_[c] = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                  (c != 0 && strchr("!#$%&'*+-.^_`|~", static_cast<char>(c)) != nullptr);
+    }
+  }
+  std::array<bool, 256> token_;
+};
+
+const TokenTable token_table_;
+
+bool isToken(char c) { return token_table_.token_[static_cast<uint8_t>(c)]; }
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+bool isLineEnd(char c) { return c == '\r' || c == '\n'; }
+bool isWhitespace(char c) { return c == ' ' || c == '\t'; }
+char toLower(char c) { return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c; }
+
+int hexValue(char c) {
+  if (isDigit(c)) {
+    return c - '0';
+  }
+  c = toLower(c);
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+} // namespace
+
+VectorizedParserImpl::VectorizedParserImpl(ParserType type, ParserCallbacks& callbacks)
+    : callbacks_(callbacks), type_(type) {}
+
+http_errno VectorizedParserImpl::error() const {
+  if (error_ != HPE_OK) {
+    return error_;
+  }
+  return paused_ ? HPE_PAUSED : HPE_OK;
+}
+
+absl::optional<uint64_t> VectorizedParserImpl::contentLength() const {
+  if (!has_content_length_) {
+    return absl::nullopt;
+  }
+  return content_length_;
+}
+
+size_t VectorizedParserImpl::execute(const char* data, size_t length) {
+  if (error_ != HPE_OK || paused_) {
+    return 0;
+  }
+
+  if (length == 0) {
+    if (state_ == State::BodyUntilEof) {
+      onMessageDone();
+    } else if (state_ != State::MessageStart) {
+      setError(HPE_INVALID_EOF_STATE);
+    }
+    return 0;
+  }
+
+  const char* p = data;
+  const char* const end = data + length;
+  while (error_ == HPE_OK && !paused_) {
+    // These states are entered once the byte that ends the headers or the message has been
+    // consumed, and raise their callbacks whether or not there is more data.
+    if (state_ == State::HeadersDone) {
+      onHeadersDone();
+      continue;
+    }
+    if (state_ == State::MessageDone) {
+      const bool upgrade = upgrade_;
+      onMessageDone();
+      if (upgrade) {
+        // Like http_parser, return after an upgrade so that the caller can decide what to do with
+        // the rest of the data.
+        break;
+      }
+      continue;
+    }
+    if (p == end) {
+      break;
+    }
+
+    const State state = state_;
+    const char* const begin = p;
+    const char c = *p;
+    switch (state) {
+    case State::MessageStart:
+      if (isLineEnd(c)) {
+        // Skip line endings between messages.
+        p++;
+        break;
+      }
+      if (type_ == ParserType::Request ? !(c >= 'A' && c <= 'Z') : c != 'H') {
+        setError(type_ == ParserType::Request ? HPE_INVALID_METHOD : HPE_INVALID_CONSTANT);
+        break;
+      }
+      onMessageBegin();
+      break;
+
+    case State::Method:
+      if (c == ' ') {
+        if (!onMethodEnd()) {
+          break;
+        }
+        p++;
+        state_ = State::Target;
+      } else if (((c >= 'A' && c <= 'Z') || c == '-') && method_length_ < sizeof(method_buffer_)) {
+        method_buffer_[method_length_++] = c;
+        p++;
+      } else {
+        setError(HPE_INVALID_METHOD);
+      }
+      break;
+
+    case State::Target: {
+      if (url_length_ == 0 && !validTargetStart(c)) {
+        setError(HPE_INVALID_URL);
+        break;
+      }
+      const char* target_end = Scanner::findTargetEnd(p, end);
+      if (target_end != p) {
+        callbacks_.onUrl(p, target_end - p);
+        url_length_ += target_end - p;
+        p = target_end;
+      } else if (c == ' ' && url_length_ == 0) {
+        p++;
+      } else if (url_length_ == 0) {
+        setError(HPE_INVALID_URL);
+      } else if (c == ' ') {
+        p++;
+        state_ = State::RequestVersion;
+      } else if (isLineEnd(c)) {
+        // A request line without a version is an HTTP/0.9 request.
+        http_major_ = 0;
+        http_minor_ = 9;
+        p++;
+        lineEnd(c, State::HeaderLineStart);
+      } else {
+        setError(HPE_INVALID_URL);
+      }
+      break;
+    }
+
+    case State::RequestVersion:
+      if (version_position_ < VersionLength) {
+        if (parseVersion(c)) {
+          p++;
+        }
+      } else if (isLineEnd(c)) {
+        p++;
+        lineEnd(c, State::HeaderLineStart);
+      } else {
+        setError(HPE_INVALID_VERSION);
+      }
+      break;
+
+    case State::ResponseVersion:
+      if (version_position_ < VersionLength) {
+        if (parseVersion(c)) {
+          p++;
+        }
+      } else if (c == ' ') {
+        p++;
+        state_ = State::StatusCode;
+      } else {
+        setError(HPE_INVALID_VERSION);
+      }
+      break;
+
+    case State::StatusCode:
+      if (isDigit(c) && status_digits_ < 3) {
+        status_code_ = status_code_ * 10 + (c - '0');
+        status_digits_++;
+        p++;
+      } else if (status_digits_ != 3) {
+        setError(HPE_INVALID_STATUS);
+      } else if (c == ' ') {
+        p++;
+        state_ = State::Reason;
+      } else if (isLineEnd(c)) {
+        p++;
+        lineEnd(c, State::HeaderLineStart);
+      } else {
+        setError(HPE_INVALID_STATUS);
+      }
+      break;
+
+    case State::Reason:
+      p = Scanner::findValueEnd(p, end);
+      if (p == end) {
+        break;
+      }
+      if (isLineEnd(*p)) {
+        lineEnd(*p++, State::HeaderLineStart);
+      } else {
+        setError(HPE_INVALID_STATUS);
+      }
+      break;
+
+    case State::LineFeed:
+      if (c == '\n') {
+        p++;
+        state_ = line_feed_next_;
+      } else {
+        setError(HPE_LF_EXPECTED);
+      }
+      break;
+
+    case State::HeaderLineStart:
+      if (isLineEnd(c)) {
+        p++;
+        lineEnd(c, State::HeadersDone);
+      } else if (isWhitespace(c)) {
+        // Obsolete line folding, or whitespace before the first header.
+        setError(HPE_INVALID_HEADER_TOKEN);
+      } else {
+        field_length_ = 0;
+        state_ = State::HeaderField;
+      }
+      break;
+
+    case State::HeaderField: {
+      const char* field_end = p;
+      while (field_end != end && isToken(*field_end)) {
+        if (field_length_ < sizeof(field_buffer_)) {
+          field_buffer_[field_length_] = toLower(*field_end);
+        }
+        field_length_++;
+        field_end++;
+      }
+      if (field_end != p) {
+        callbacks_.onHeaderField(p, field_end - p);
+        p = field_end;
+        if (p == end) {
+          break;
+        }
+      }
+      if (*p == ':' && field_length_ > 0) {
+        p++;
+        onHeaderFieldEnd();
+        state_ = State::HeaderValueStart;
+      } else {
+        setError(HPE_INVALID_HEADER_TOKEN);
+      }
+      break;
+    }
+
+    case State::HeaderValueStart:
+      // Skip leading whitespace.
+      if (isWhitespace(c)) {
+        p++;
+      } else {
+        value_length_ = 0;
+        state_ = State::HeaderValue;
+      }
+      break;
+
+    case State::HeaderValue: {
+      const char* value_end = Scanner::findValueEnd(p, end);
+      if (value_end != p) {
+        callbacks_.onHeaderValue(p, value_end - p);
+        if (framing_header_ != FramingHeader::None) {
+          framing_value_.append(p, value_end - p);
+        }
+        value_length_ += value_end - p;
+        p = value_end;
+        if (p == end) {
+          break;
+        }
+      }
+      if (!isLineEnd(*p)) {
+        setError(HPE_INVALID_HEADER_TOKEN);
+        break;
+      }
+      if (value_length_ == 0) {
+        callbacks_.onHeaderValue(p, 0);
+      }
+      if (onHeaderValueEnd()) {
+        lineEnd(*p++, State::HeaderLineStart);
+      }
+      break;
+    }
+
+    case State::Body: {
+      const size_t body_length = std::min<uint64_t>(remaining_, end - p);
+      callbacks_.onBody(p, body_length);
+      p += body_length;
+      remaining_ -= body_length;
+      if (remaining_ == 0) {
+        state_ = State::MessageDone;
+      }
+      break;
+    }
+
+    case State::BodyUntilEof:
+      callbacks_.onBody(p, end - p);
+      p = end;
+      break;
+
+    case State::ChunkSize: {
+      const int digit = hexValue(c);
+      if (digit >= 0) {
+        if (remaining_ > (UINT64_MAX >> 4)) {
+          setError(HPE_INVALID_CONTENT_LENGTH);
+          break;
+        }
+        remaining_ = (remaining_ << 4) | digit;
+        chunk_size_valid_ = true;
+        p++;
+      } else if (!chunk_size_valid_) {
+        setError(HPE_INVALID_CHUNK_SIZE);
+      } else if (c == ';' || isWhitespace(c)) {
+        p++;
+        state_ = State::ChunkExtension;
+      } else if (isLineEnd(c)) {
+        p++;
+        onChunkSizeEnd(c);
+      } else {
+        setError(HPE_INVALID_CHUNK_SIZE);
+      }
+      break;
+    }
+
+    case State::ChunkExtension:
+      // Chunk extensions are ignored.
+      while (p != end && !isLineEnd(*p)) {
+        p++;
+      }
+      if (p != end) {
+        onChunkSizeEnd(*p++);
+      }
+      break;
+
+    case State::ChunkData: {
+      const size_t chunk_length = std::min<uint64_t>(remaining_, end - p);
+      callbacks_.onBody(p, chunk_length);
+      p += chunk_length;
+      remaining_ -= chunk_length;
+      if (remaining_ == 0) {
+        state_ = State::ChunkDataEnd;
+      }
+      break;
+    }
+
+    case State::ChunkDataEnd:
+      if (isLineEnd(c)) {
+        p++;
+        remaining_ = 0;
+        chunk_size_valid_ = false;
+        header_bytes_ = 0;
+        lineEnd(c, State::ChunkSize);
+      } else {
+        setError(HPE_INVALID_CHUNK_SIZE);
+      }
+      break;
+
+    case State::TrailerLineStart:
+      if (isLineEnd(c)) {
+        p++;
+        lineEnd(c, State::MessageDone);
+      } else if (isToken(c)) {
+        state_ = State::TrailerField;
+      } else {
+        setError(HPE_INVALID_HEADER_TOKEN);
+      }
+      break;
+
+    case State::TrailerField:
+      while (p != end && isToken(*p)) {
+        p++;
+      }
+      if (p == end) {
+        break;
+      }
+      if (*p++ == ':') {
+        state_ = State::TrailerLine;
+      } else {
+        setError(HPE_INVALID_HEADER_TOKEN);
+      }
+      break;
+
+    case State::TrailerLine:
+      p = Scanner::findValueEnd(p, end);
+      if (p == end) {
+        break;
+      }
+      if (isLineEnd(*p)) {
+        lineEnd(*p++, State::TrailerLineStart);
+      } else {
+        setError(HPE_INVALID_HEADER_TOKEN);
+      }
+      break;
+
+    case State::HeadersDone:
+    case State::MessageDone:
+      NOT_REACHED;
+    }
+
+    if (state != State::MessageStart && state != State::Body && state != State::BodyUntilEof &&
+        state != State::ChunkData) {
+      header_bytes_ += p - begin;
+      if (header_bytes_ > MaxHeaderSize) {
+        setError(HPE_HEADER_OVERFLOW);
+      }
+    }
+  }
+
+  return p - data;
+}
+
+bool VectorizedParserImpl::validTargetStart(char c) const {
+  // Leading spaces are skipped. Otherwise, as with http_parser, the target must be in origin
+  // (path), asterisk or absolute form, or in authority form for CONNECT, whose host is checked
+  // later along with the rest of an absolute or authority form target.
+  return c == ' ' || c == '/' || c == '*' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         method_ == HTTP_CONNECT;
+}
+
+void VectorizedParserImpl::lineEnd(char c, State next) {
+  ASSERT(isLineEnd(c));
+  if (c == '\r') {
+    line_feed_next_ = next;
+    state_ = State::LineFeed;
+  } else {
+    state_ = next;
+  }
+}
+
+bool VectorizedParserImpl::parseVersion(char c) {
+  static const char prefix[] = "HTTP/";
+  if (version_position_ < sizeof(prefix) - 1) {
+    if (c != prefix[version_position_]) {
+      setError(HPE_INVALID_CONSTANT);
+      return false;
+    }
+  } else if (version_position_ == sizeof(prefix)) {
+    if (c != '.') {
+      setError(HPE_INVALID_VERSION);
+      return false;
+    }
+  } else {
+    if (!isDigit(c)) {
+      setError(HPE_INVALID_VERSION);
+      return false;
+    }
+    (version_position_ < sizeof(prefix) ? http_major_ : http_minor_) = c - '0';
+  }
+  version_position_++;
+  return true;
+}
+
+void VectorizedParserImpl::onMessageBegin() {
+  method_length_ = 0;
+  method_ = HTTP_GET;
+  url_length_ = 0;
+  version_position_ = 0;
+  http_major_ = 0;
+  http_minor_ = 0;
+  status_digits_ = 0;
+  status_code_ = 0;
+  header_bytes_ = 0;
+  has_content_length_ = false;
+  content_length_ = 0;
+  chunked_ = false;
+  has_upgrade_header_ = false;
+  connection_upgrade_ = false;
+  upgrade_ = false;
+
+  state_ = type_ == ParserType::Request ? State::Method : State::ResponseVersion;
+  callbacks_.onMessageBeginBase();
+}
+
+bool VectorizedParserImpl::onMethodEnd() {
+  const absl::string_view name(method_buffer_, method_length_);
+  for (const MethodName& method_name : method_names_) {
+    if (method_name.name_ == name) {
+      method_ = method_name.method_;
+      return true;
+    }
+  }
+  setError(HPE_INVALID_METHOD);
+  return false;
+}
+
+void VectorizedParserImpl::onHeaderFieldEnd() {
+  framing_header_ = FramingHeader::None;
+  framing_value_.clear();
+  if (field_length_ > sizeof(field_buffer_)) {
+    return;
+  }
+
+  const absl::string_view field(field_buffer_, field_length_);
+  if (field == "content-length") {
+    framing_header_ = FramingHeader::ContentLength;
+  } else if (field == "transfer-encoding") {
+    framing_header_ = FramingHeader::TransferEncoding;
+  } else if (field == "connection") {
+    framing_header_ = FramingHeader::Connection;
+  } else if (field == "upgrade") {
+    framing_header_ = FramingHeader::Upgrade;
+  }
+}
+
+bool VectorizedParserImpl::onHeaderValueEnd() {
+  switch (framing_header_) {
+  case FramingHeader::None:
+    break;
+
+  case FramingHeader::ContentLength: {
+    if (has_content_length_) {
+      setError(HPE_UNEXPECTED_CONTENT_LENGTH);
+      break;
+    }
+    const absl::string_view value = StringUtil::rtrim(framing_value_);
+    if (value.empty()) {
+      setError(HPE_INVALID_CONTENT_LENGTH);
+      break;
+    }
+    uint64_t content_length = 0;
+    for (const char c : value) {
+      if (!isDigit(c) || content_length > (UINT64_MAX - 9) / 10) {
+        setError(HPE_INVALID_CONTENT_LENGTH);
+        return false;
+      }
+      content_length = content_length * 10 + (c - '0');
+    }
+    has_content_length_ = true;
+    content_length_ = content_length;
+    break;
+  }
+
+  case FramingHeader::TransferEncoding: {
+    // The message is chunked if chunked is the last transfer coding applied.
+    const absl::string_view value = framing_value_;
+    chunked_ = StringUtil::caseCompare(StringUtil::trim(value.substr(value.rfind(',') + 1)),
+                                       "chunked");
+    break;
+  }
+
+  case FramingHeader::Connection:
+    if (StringUtil::caseFindToken(framing_value_, ",", "upgrade")) {
+      connection_upgrade_ = true;
+    }
+    break;
+
+  case FramingHeader::Upgrade:
+    has_upgrade_header_ = true;
+    break;
+  }
+
+  framing_header_ = FramingHeader::None;
+  return error_ == HPE_OK;
+}
+
+void VectorizedParserImpl::onHeadersDone() {
+  if (chunked_ && has_content_length_) {
+    setError(HPE_UNEXPECTED_CONTENT_LENGTH);
+    return;
+  }
+
+  const bool skip_body = callbacks_.onHeadersCompleteBase() == 1;
+  header_bytes_ = 0;
+
+  // Same upgrade semantics as http_parser: a request or 101 response with Upgrade and Connection:
+  // upgrade headers, or a CONNECT request.
+  if (has_upgrade_header_ && connection_upgrade_) {
+    upgrade_ = type_ == ParserType::Request || status_code_ == 101;
+  } else {
+    upgrade_ = type_ == ParserType::Request && method_ == HTTP_CONNECT;
+  }
+  const bool has_body = chunked_ || (has_content_length_ && content_length_ > 0);
+  if (upgrade_ && (method_ == HTTP_CONNECT || skip_body || !has_body)) {
+    state_ = State::MessageDone;
+    return;
+  }
+  upgrade_ = false;
+
+  if (skip_body) {
+    state_ = State::MessageDone;
+  } else if (chunked_) {
+    remaining_ = 0;
+    chunk_size_valid_ = false;
+    state_ = State::ChunkSize;
+  } else if (has_content_length_) {
+    remaining_ = content_length_;
+    state_ = remaining_ > 0 ? State::Body : State::MessageDone;
+  } else if (type_ == ParserType::Request || status_code_ / 100 == 1 || status_code_ == 204 ||
+             status_code_ == 304) {
+    state_ = State::MessageDone;
+  } else {
+    // A response without framing headers is delimited by the connection closing.
+    state_ = State::BodyUntilEof;
+  }
+}
+
+void VectorizedParserImpl::onChunkSizeEnd(char c) {
+  header_bytes_ = 0;
+  lineEnd(c, remaining_ > 0 ? State::ChunkData : State::TrailerLineStart);
+}
+
+void VectorizedParserImpl::onMessageDone() {
+  state_ = State::MessageStart;
+  upgrade_ = false;
+  callbacks_.onMessageComplete();
+}
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
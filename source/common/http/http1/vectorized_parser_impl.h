@@ -0,0 +1,142 @@
+#pragma once
+
+#include <http_parser.h>
+
+#include <cstdint>
+#include <string>
+
+#include "common/http/http1/parser.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+/**
+ * HTTP/1 parser that finds the ends of request targets, header values and reason phrases with
+ * Http1::Scanner, and otherwise parses a byte at a time like http_parser. Each run of bytes found
+ * by the scanner is passed to the callbacks in one piece, directly out of the span being parsed,
+ * so a header that is not split across spans is delivered with a single field and value callback.
+ *
+ * It follows http_parser's semantics for everything the HTTP/1 codec relies on (message framing,
+ * pausing, upgrades, HTTP/0.9 request lines, the 80KiB header limit and the error codes it
+ * reports), except that it is stricter where RFC 7230 allows a recipient to reject a message:
+ * obsolete line folding, whitespace in header names, bytes other than LF after CR, and a
+ * Content-Length together with chunked Transfer-Encoding are all rejected. Trailers of chunked
+ * messages are checked and skipped without raising header callbacks.
+ */
+class VectorizedParserImpl : public Parser {
+public:
+  // The maximum number of bytes in a request or status line plus headers, or in trailers.
+  static constexpr uint32_t MaxHeaderSize = 80 * 1024;
+
+  VectorizedParserImpl(ParserType type, ParserCallbacks& callbacks);
+
+  // Http1::Parser
+  size_t execute(const char* data, size_t length) override;
+  void pause() override { paused_ = true; }
+  void resume() override { paused_ = false; }
+  http_errno error() const override;
+  http_method method() const override { return method_; }
+  uint16_t statusCode() const override { return status_code_; }
+  uint16_t httpMajor() const override { return http_major_; }
+  uint16_t httpMinor() const override { return http_minor_; }
+  bool isChunked() const override { return chunked_; }
+  absl::optional<uint64_t> contentLength() const override;
+
+private:
+  enum class State {
+    MessageStart,
+    Method,
+    Target,
+    RequestVersion,
+    ResponseVersion,
+    StatusCode,
+    Reason,
+    LineFeed,
+    HeaderLineStart,
+    HeaderField,
+    HeaderValueStart,
+    HeaderValue,
+    HeadersDone,
+    Body,
+    BodyUntilEof,
+    ChunkSize,
+    ChunkExtension,
+    ChunkData,
+    ChunkDataEnd,
+    TrailerLineStart,
+    TrailerField,
+    TrailerLine,
+    MessageDone,
+  };
+
+  // Headers that affect message framing.
+  enum class FramingHeader { None, ContentLength, TransferEncoding, Connection, Upgrade };
+
+  // The length of "HTTP/x.y".
+  static constexpr uint32_t VersionLength = 8;
+
+  /**
+   * Continue in next after a line ending.
+   * @param c supplies the line ending byte just consumed. If it is CR, a LF must follow.
+   * @param next supplies the state to continue in.
+   */
+  void lineEnd(char c, State next);
+
+  /**
+   * Parse the protocol version a byte at a time.
+   * @param c supplies the next byte of the version.
+   * @return bool false if the byte is invalid, in which case the error is set.
+   */
+  bool parseVersion(char c);
+
+  bool validTargetStart(char c) const;
+  void onMessageBegin();
+  bool onMethodEnd();
+  void onHeaderFieldEnd();
+  bool onHeaderValueEnd();
+  void onHeadersDone();
+  void onChunkSizeEnd(char c);
+  void onMessageDone();
+  void setError(http_errno error) { error_ = error; }
+
+  ParserCallbacks& callbacks_;
+  const ParserType type_;
+  State state_{State::MessageStart};
+  State line_feed_next_{State::MessageStart};
+  http_errno error_{HPE_OK};
+  bool paused_{};
+
+  // Start line.
+  char method_buffer_[24];
+  uint32_t method_length_{};
+  http_method method_{HTTP_GET};
+  uint32_t url_length_{};
+  uint32_t version_position_{};
+  uint16_t http_major_{};
+  uint16_t http_minor_{};
+  uint32_t status_digits_{};
+  uint16_t status_code_{};
+
+  // Headers.
+  uint32_t header_bytes_{};
+  char field_buffer_[24];
+  uint32_t field_length_{};
+  uint32_t value_length_{};
+  FramingHeader framing_header_{FramingHeader::None};
+  std::string framing_value_;
+  bool has_content_length_{};
+  uint64_t content_length_{};
+  bool chunked_{};
+  bool has_upgrade_header_{};
+  bool connection_upgrade_{};
+  bool upgrade_{};
+
+  // Body.
+  uint64_t remaining_{};
+  bool chunk_size_valid_{};
+};
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
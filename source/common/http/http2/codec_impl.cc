@@ -37,7 +37,6 @@ bool Utility::reconstituteCrumbledCookies(const HeaderString& key, const HeaderS
 }
 
 ConnectionImpl::Http2Callbacks ConnectionImpl::http2_callbacks_;
-ConnectionImpl::Http2Options ConnectionImpl::http2_options_;
 
 /**
  * Helper to remove const during a cast. nghttp2 takes non-const pointers for headers even though
@@ -58,7 +57,8 @@ ConnectionImpl::StreamImpl::StreamImpl(ConnectionImpl& parent, uint32_t buffer_l
   }
 }
 
-static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& header) {
+static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& header,
+                         bool never_index) {
   uint8_t flags = 0;
   if (header.key().type() == HeaderString::Type::Reference) {
     flags |= NGHTTP2_NV_FLAG_NO_COPY_NAME;
@@ -66,6 +66,9 @@ static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& he
   if (header.value().type() == HeaderString::Type::Reference) {
     flags |= NGHTTP2_NV_FLAG_NO_COPY_VALUE;
   }
+  if (never_index) {
+    flags |= NGHTTP2_NV_FLAG_NO_INDEX;
+  }
   headers.push_back({remove_const<uint8_t>(header.key().c_str()),
                      remove_const<uint8_t>(header.value().c_str()), header.key().size(),
                      header.value().size(), flags});
@@ -74,13 +77,29 @@ static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& he
 void ConnectionImpl::StreamImpl::buildHeaders(std::vector<nghttp2_nv>& final_headers,
                                               const HeaderMap& headers) {
   final_headers.reserve(headers.size());
+  // The stats are counted here and added once per header block, rather than once per header.
+  struct Context {
+    const ConnectionImpl& parent_;
+    std::vector<nghttp2_nv>& final_headers_;
+    uint64_t header_bytes_;
+    uint64_t never_indexed_;
+  } context{parent_, final_headers, 0, 0};
   headers.iterate(
       [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
-        std::vector<nghttp2_nv>* final_headers = static_cast<std::vector<nghttp2_nv>*>(context);
-        insertHeader(*final_headers, header);
+        Context& build = *static_cast<Context*>(context);
+        const bool never_index = build.parent_.neverIndex(header.key());
+        if (never_index) {
+          build.never_indexed_++;
+        }
+        build.header_bytes_ += header.key().size() + header.value().size();
+        insertHeader(build.final_headers_, header, never_index);
         return HeaderMap::Iterate::Continue;
       },
-      &final_headers);
+      &context);
+  parent_.stats_.tx_header_bytes_.add(context.header_bytes_);
+  if (context.never_indexed_ > 0) {
+    parent_.stats_.tx_header_never_indexed_.add(context.never_indexed_);
+  }
 }
 
 void ConnectionImpl::StreamImpl::encode100ContinueHeaders(const HeaderMap& headers) {
@@ -271,7 +290,37 @@ void ConnectionImpl::StreamImpl::resetStreamWorker(StreamResetReason reason) {
   ASSERT(rc == 0);
 }
 
-ConnectionImpl::~ConnectionImpl() { nghttp2_session_del(session_); }
+ConnectionImpl::~ConnectionImpl() {
+  stats_.hpack_decoder_table_bytes_.sub(hpack_decoder_table_bytes_);
+  stats_.hpack_encoder_table_bytes_.sub(hpack_encoder_table_bytes_);
+  nghttp2_session_del(session_);
+}
+
+bool ConnectionImpl::neverIndex(const HeaderString& key) const {
+  if (never_index_headers_ == nullptr) {
+    return false;
+  }
+  for (const LowerCaseString& header : *never_index_headers_) {
+    if (key.size() == header.get().size() && key == header.get().c_str()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ConnectionImpl::updateHpackTableStats() {
+  // nghttp2 does not report individual table insertions or evictions, so the gauges track the
+  // current size of each dynamic table summed over all connections.
+  const uint64_t decoder_table_bytes = nghttp2_session_get_hd_inflate_dynamic_table_size(session_);
+  stats_.hpack_decoder_table_bytes_.add(decoder_table_bytes);
+  stats_.hpack_decoder_table_bytes_.sub(hpack_decoder_table_bytes_);
+  hpack_decoder_table_bytes_ = decoder_table_bytes;
+
+  const uint64_t encoder_table_bytes = nghttp2_session_get_hd_deflate_dynamic_table_size(session_);
+  stats_.hpack_encoder_table_bytes_.add(encoder_table_bytes);
+  stats_.hpack_encoder_table_bytes_.sub(hpack_encoder_table_bytes_);
+  hpack_encoder_table_bytes_ = encoder_table_bytes;
+}
 
 void ConnectionImpl::dispatch(Buffer::Instance& data) {
   ENVOY_CONN_LOG(trace, "dispatching {} bytes", connection_, data.length());
@@ -343,6 +392,11 @@ int ConnectionImpl::onFrameReceived(const nghttp2_frame* frame) {
     return 0;
   }
 
+  if (frame->hd.type == NGHTTP2_HEADERS) {
+    // The header block has been decoded, which may have changed the decoder's dynamic table.
+    updateHpackTableStats();
+  }
+
   StreamImpl* stream = getStream(frame->hd.stream_id);
   if (!stream) {
     return 0;
@@ -459,6 +513,11 @@ int ConnectionImpl::onFrameSend(const nghttp2_frame* frame) {
   }
 
   case NGHTTP2_HEADERS:
+    // nghttp2 reports a header block split over CONTINUATION frames as a single HEADERS frame
+    // with the length of the whole block.
+    stats_.tx_header_bytes_compressed_.add(frame->hd.length);
+    updateHpackTableStats();
+    FALLTHRU;
   case NGHTTP2_DATA: {
     StreamImpl* stream = getStream(frame->hd.stream_id);
     stream->local_end_stream_sent_ = frame->hd.flags & NGHTTP2_FLAG_END_STREAM;
@@ -469,6 +528,12 @@ int ConnectionImpl::onFrameSend(const nghttp2_frame* frame) {
   return 0;
 }
 
+void ConnectionImpl::onBeginFrame(const nghttp2_frame_hd* hd) {
+  if (hd->type == NGHTTP2_HEADERS || hd->type == NGHTTP2_CONTINUATION) {
+    stats_.rx_header_bytes_compressed_.add(hd->length);
+  }
+}
+
 int ConnectionImpl::onInvalidFrame(int32_t stream_id, int error_code) {
   ENVOY_CONN_LOG(debug, "invalid frame: {}", connection_, nghttp2_strerror(error_code));
 
@@ -544,6 +609,7 @@ int ConnectionImpl::saveHeader(const nghttp2_frame* frame, HeaderString&& name,
     return 0;
   }
 
+  stats_.rx_header_bytes_.add(name.size() + value.size());
   stream->saveHeader(std::move(name), std::move(value));
   if (stream->headers_->byteSize() > StreamImpl::MAX_HEADER_SIZE) {
     // This will cause the library to reset/close the stream.
@@ -664,6 +730,12 @@ ConnectionImpl::Http2Callbacks::Http2Callbacks() {
         return static_cast<StreamImpl*>(source->ptr)->onDataSourceSend(framehd, length);
       });
 
+  nghttp2_session_callbacks_set_on_begin_frame_callback(
+      callbacks_, [](nghttp2_session*, const nghttp2_frame_hd* hd, void* user_data) -> int {
+        static_cast<ConnectionImpl*>(user_data)->onBeginFrame(hd);
+        return 0;
+      });
+
   nghttp2_session_callbacks_set_on_begin_headers_callback(
       callbacks_, [](nghttp2_session*, const nghttp2_frame* frame, void* user_data) -> int {
         return static_cast<ConnectionImpl*>(user_data)->onBeginHeaders(frame);
@@ -723,7 +795,7 @@ ConnectionImpl::Http2Callbacks::Http2Callbacks() {
 
 ConnectionImpl::Http2Callbacks::~Http2Callbacks() { nghttp2_session_callbacks_del(callbacks_); }
 
-ConnectionImpl::Http2Options::Http2Options() {
+ConnectionImpl::Http2Options::Http2Options(const Http2Settings& http2_settings) {
   nghttp2_option_new(&options_);
   // Currently we do not do anything with stream priority. Setting the following option prevents
   // nghttp2 from keeping around closed streams for use during stream priority dependency graph
@@ -731,6 +803,10 @@ ConnectionImpl::Http2Options::Http2Options() {
   // of kept alive HTTP/2 connections.
   nghttp2_option_set_no_closed_streams(options_, 1);
   nghttp2_option_set_no_auto_window_update(options_, 1);
+  if (http2_settings.hpack_encoder_table_size_ != NGHTTP2_DEFAULT_HEADER_TABLE_SIZE) {
+    nghttp2_option_set_max_deflate_dynamic_table_size(options_,
+                                                      http2_settings.hpack_encoder_table_size_);
+  }
 }
 
 ConnectionImpl::Http2Options::~Http2Options() { nghttp2_option_del(options_); }
@@ -739,8 +815,9 @@ ClientConnectionImpl::ClientConnectionImpl(Network::Connection& connection,
                                            Http::ConnectionCallbacks& callbacks,
                                            Stats::Scope& stats, const Http2Settings& http2_settings)
     : ConnectionImpl(connection, stats, http2_settings), callbacks_(callbacks) {
+  Http2Options http2_options(http2_settings);
   nghttp2_session_client_new2(&session_, http2_callbacks_.callbacks(), base(),
-                              http2_options_.options());
+                              http2_options.options());
   sendSettings(http2_settings, true);
 }
 
@@ -757,6 +834,10 @@ Http::StreamEncoder& ClientConnectionImpl::newStream(StreamDecoder& decoder) {
   return *active_streams_.front();
 }
 
+uint32_t ClientConnectionImpl::maxConcurrentStreams() {
+  return nghttp2_session_get_remote_settings(session_, NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS);
+}
+
 int ClientConnectionImpl::onBeginHeaders(const nghttp2_frame* frame) {
   // The client code explicitly does not currently suport push promise.
   RELEASE_ASSERT(frame->hd.type == NGHTTP2_HEADERS);
@@ -783,8 +864,9 @@ ServerConnectionImpl::ServerConnectionImpl(Network::Connection& connection,
                                            Http::ServerConnectionCallbacks& callbacks,
                                            Stats::Scope& scope, const Http2Settings& http2_settings)
     : ConnectionImpl(connection, scope, http2_settings), callbacks_(callbacks) {
+  Http2Options http2_options(http2_settings);
   nghttp2_session_server_new2(&session_, http2_callbacks_.callbacks(), base(),
-                              http2_options_.options());
+                              http2_options.options());
   sendSettings(http2_settings, false);
 }
 
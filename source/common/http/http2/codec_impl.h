@@ -36,21 +36,28 @@ const std::string CLIENT_MAGIC_PREFIX = "PRI * HTTP/2";
  * All stats for the HTTP/2 codec. @see stats_macros.h
  */
 // clang-format off
-#define ALL_HTTP2_CODEC_STATS(COUNTER)                                                             \
+#define ALL_HTTP2_CODEC_STATS(COUNTER, GAUGE)                                                      \
   COUNTER(header_overflow)                                                                         \
   COUNTER(headers_cb_no_stream)                                                                    \
+  COUNTER(rx_header_bytes)                                                                         \
+  COUNTER(rx_header_bytes_compressed)                                                              \
   COUNTER(rx_messaging_error)                                                                      \
   COUNTER(rx_reset)                                                                                \
   COUNTER(too_many_header_frames)                                                                  \
   COUNTER(trailers)                                                                                \
-  COUNTER(tx_reset)
+  COUNTER(tx_header_bytes)                                                                         \
+  COUNTER(tx_header_bytes_compressed)                                                              \
+  COUNTER(tx_header_never_indexed)                                                                 \
+  COUNTER(tx_reset)                                                                                \
+  GAUGE  (hpack_decoder_table_bytes)                                                               \
+  GAUGE  (hpack_encoder_table_bytes)
 // clang-format on
 
 /**
  * Wrapper struct for the HTTP/2 codec stats. @see stats_macros.h
  */
 struct CodecStats {
-  ALL_HTTP2_CODEC_STATS(GENERATE_COUNTER_STRUCT)
+  ALL_HTTP2_CODEC_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
 };
 
 class Utility {
@@ -73,8 +80,10 @@ class ConnectionImpl : public virtual Connection, protected Logger::Loggable<Log
 public:
   ConnectionImpl(Network::Connection& connection, Stats::Scope& stats,
                  const Http2Settings& http2_settings)
-      : stats_{ALL_HTTP2_CODEC_STATS(POOL_COUNTER_PREFIX(stats, "http2."))},
+      : stats_{ALL_HTTP2_CODEC_STATS(POOL_COUNTER_PREFIX(stats, "http2."),
+                                     POOL_GAUGE_PREFIX(stats, "http2."))},
         connection_(connection),
+        never_index_headers_(http2_settings.hpack_never_index_headers_),
         per_stream_buffer_limit_(http2_settings.initial_stream_window_size_), dispatching_(false),
         raised_goaway_(false), pending_deferred_reset_(false) {}
 
@@ -114,11 +123,11 @@ protected:
   };
 
   /**
-   * Wrapper for static nghttp2 session options.
+   * Wrapper for nghttp2 session options.
    */
   class Http2Options {
   public:
-    Http2Options();
+    Http2Options(const Http2Settings& http2_settings);
     ~Http2Options();
 
     const nghttp2_option* options() { return options_; }
@@ -142,7 +151,7 @@ protected:
     ssize_t onDataSourceRead(uint64_t length, uint32_t* data_flags);
     int onDataSourceSend(const uint8_t* framehd, size_t length);
     void resetStreamWorker(StreamResetReason reason);
-    static void buildHeaders(std::vector<nghttp2_nv>& final_headers, const HeaderMap& headers);
+    void buildHeaders(std::vector<nghttp2_nv>& final_headers, const HeaderMap& headers);
     void saveHeader(HeaderString&& name, HeaderString&& value);
     virtual void submitHeaders(const std::vector<nghttp2_nv>& final_headers,
                                nghttp2_data_provider* provider) PURE;
@@ -236,19 +245,22 @@ protected:
   int saveHeader(const nghttp2_frame* frame, HeaderString&& name, HeaderString&& value);
   void sendPendingFrames();
   void sendSettings(const Http2Settings& http2_settings, bool disable_push);
+  bool neverIndex(const HeaderString& key) const;
 
   static Http2Callbacks http2_callbacks_;
-  static Http2Options http2_options_;
 
   std::list<StreamImplPtr> active_streams_;
   nghttp2_session* session_{};
   CodecStats stats_;
   Network::Connection& connection_;
+  // Shared with the settings the connection was created with. Null if there are none.
+  const std::shared_ptr<const std::vector<LowerCaseString>> never_index_headers_;
   uint32_t per_stream_buffer_limit_;
 
 private:
   virtual ConnectionCallbacks& callbacks() PURE;
   virtual int onBeginHeaders(const nghttp2_frame* frame) PURE;
+  void onBeginFrame(const nghttp2_frame_hd* hd);
   int onData(int32_t stream_id, const uint8_t* data, size_t len);
   int onFrameReceived(const nghttp2_frame* frame);
   int onFrameSend(const nghttp2_frame* frame);
@@ -256,7 +268,11 @@ private:
   int onInvalidFrame(int32_t stream_id, int error_code);
   ssize_t onSend(const uint8_t* data, size_t length);
   int onStreamClose(int32_t stream_id, uint32_t error_code);
+  void updateHpackTableStats();
 
+  // The HPACK dynamic table sizes last added to the table size gauges.
+  uint64_t hpack_decoder_table_bytes_{};
+  uint64_t hpack_encoder_table_bytes_{};
   bool dispatching_ : 1;
   bool raised_goaway_ : 1;
   bool pending_deferred_reset_ : 1;
@@ -272,6 +288,7 @@ public:
 
   // Http::ClientConnection
   Http::StreamEncoder& newStream(StreamDecoder& response_decoder) override;
+  uint32_t maxConcurrentStreams() override;
 
 private:
   // ConnectionImpl
@@ -227,6 +227,17 @@ Utility::parseHttp2Settings(const envoy::api::v2::core::Http2ProtocolOptions& co
   ret.initial_connection_window_size_ =
       PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, initial_connection_window_size,
                                       Http::Http2Settings::DEFAULT_INITIAL_CONNECTION_WINDOW_SIZE);
+  ret.max_connections_per_host_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+      config, max_connections_per_host, Http::Http2Settings::DEFAULT_MAX_CONNECTIONS_PER_HOST);
+  ret.hpack_encoder_table_size_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+      config, hpack_encoder_table_size, Http::Http2Settings::DEFAULT_HPACK_TABLE_SIZE);
+  if (!config.hpack_never_index_headers().empty()) {
+    auto never_index_headers = std::make_shared<std::vector<LowerCaseString>>();
+    for (const std::string& header : config.hpack_never_index_headers()) {
+      never_index_headers->emplace_back(header);
+    }
+    ret.hpack_never_index_headers_ = std::move(never_index_headers);
+  }
   return ret;
 }
 
@@ -236,6 +247,17 @@ Utility::parseHttp1Settings(const envoy::api::v2::core::Http1ProtocolOptions& co
   ret.allow_absolute_url_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, allow_absolute_url, false);
   ret.accept_http_10_ = config.accept_http_10();
   ret.default_host_for_http_10_ = config.default_host_for_http_10();
+  switch (config.parser()) {
+  case envoy::api::v2::core::Http1ProtocolOptions::HTTP_PARSER:
+    ret.parser_ = Http1Settings::Parser::HttpParser;
+    break;
+  case envoy::api::v2::core::Http1ProtocolOptions::VECTORIZED:
+    ret.parser_ = Http1Settings::Parser::Vectorized;
+    break;
+  default:
+    NOT_REACHED;
+  }
+  ret.max_pipelined_requests_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_pipelined_requests, 1);
   return ret;
 }
 
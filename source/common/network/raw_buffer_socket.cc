@@ -49,6 +49,10 @@ IoResult RawBufferSocket::doWrite(Buffer::Instance& buffer, bool end_stream) {
   PostIoAction action;
   uint64_t bytes_written = 0;
   ASSERT(!shutdown_ || buffer.length() == 0);
+  if (zero_copy_writes_ != nullptr) {
+    // Completions of earlier zero copy writes also wake up the write path.
+    zero_copy_writes_->processCompletions(callbacks_->fd());
+  }
   do {
     if (buffer.length() == 0) {
       if (end_stream && !shutdown_) {
@@ -60,7 +64,10 @@ IoResult RawBufferSocket::doWrite(Buffer::Instance& buffer, bool end_stream) {
       action = PostIoAction::KeepOpen;
       break;
     }
-    int rc = buffer.write(callbacks_->fd());
+    Buffer::OwnedImpl* zero_copy_buffer = zeroCopyBuffer(buffer);
+    int rc = zero_copy_buffer != nullptr
+                 ? zero_copy_writes_->write(callbacks_->fd(), *zero_copy_buffer)
+                 : buffer.write(callbacks_->fd());
     const int error = errno; // Latch errno before any logging calls can overwrite it.
     ENVOY_CONN_LOG(trace, "write returns: {}", callbacks_->connection(), rc);
     if (rc == -1) {
@@ -81,12 +88,46 @@ IoResult RawBufferSocket::doWrite(Buffer::Instance& buffer, bool end_stream) {
   return {action, bytes_written, false};
 }
 
+Buffer::OwnedImpl* RawBufferSocket::zeroCopyBuffer(Buffer::Instance& buffer) {
+  if (zero_copy_min_bytes_ == 0 || buffer.length() < zero_copy_min_bytes_) {
+    return nullptr;
+  }
+
+  // Only the native buffer implementation can hand over the memory of written data.
+  Buffer::OwnedImpl* owned_buffer = dynamic_cast<Buffer::OwnedImpl*>(&buffer);
+  if (owned_buffer == nullptr || owned_buffer->usesOldImpl()) {
+    zero_copy_min_bytes_ = 0;
+    return nullptr;
+  }
+
+  if (zero_copy_writes_ == nullptr) {
+    if (!ZeroCopyWrites::enable(callbacks_->fd())) {
+      ENVOY_CONN_LOG(debug, "zero copy writes not supported", callbacks_->connection());
+      zero_copy_min_bytes_ = 0;
+      return nullptr;
+    }
+    zero_copy_writes_ = std::make_unique<ZeroCopyWrites>();
+  } else if (zero_copy_writes_->copied()) {
+    ENVOY_CONN_LOG(debug, "kernel copied zero copy writes, disabling", callbacks_->connection());
+    zero_copy_min_bytes_ = 0;
+    return nullptr;
+  }
+  return owned_buffer;
+}
+
+void RawBufferSocket::closeSocket(Network::ConnectionEvent) {
+  if (zero_copy_writes_ != nullptr) {
+    ZeroCopyLinger::start(callbacks_->connection().dispatcher(), callbacks_->fd(),
+                          std::move(zero_copy_writes_));
+  }
+}
+
 std::string RawBufferSocket::protocol() const { return EMPTY_STRING; }
 
 void RawBufferSocket::onConnected() { callbacks_->raiseEvent(ConnectionEvent::Connected); }
 
 TransportSocketPtr RawBufferSocketFactory::createTransportSocket() const {
-  return std::make_unique<RawBufferSocket>();
+  return std::make_unique<RawBufferSocket>(zero_copy_min_bytes_);
 }
 
 bool RawBufferSocketFactory::implementsSecureTransport() const { return false; }
@@ -4,18 +4,26 @@
 #include "envoy/network/connection.h"
 #include "envoy/network/transport_socket.h"
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/logger.h"
+#include "common/network/zero_copy.h"
 
 namespace Envoy {
 namespace Network {
 
 class RawBufferSocket : public TransportSocket, protected Logger::Loggable<Logger::Id::connection> {
 public:
+  /**
+   * @param zero_copy_min_bytes supplies the smallest write sent with MSG_ZEROCOPY, or 0 to never
+   *        use zero copy writes.
+   */
+  RawBufferSocket(uint32_t zero_copy_min_bytes = 0) : zero_copy_min_bytes_(zero_copy_min_bytes) {}
+
   // Network::TransportSocket
   void setTransportSocketCallbacks(TransportSocketCallbacks& callbacks) override;
   std::string protocol() const override;
   bool canFlushClose() override { return true; }
-  void closeSocket(Network::ConnectionEvent) override {}
+  void closeSocket(Network::ConnectionEvent) override;
   void onConnected() override;
   IoResult doRead(Buffer::Instance& buffer) override;
   IoResult doWrite(Buffer::Instance& buffer, bool end_stream) override;
@@ -23,15 +31,32 @@ public:
   const Ssl::Connection* ssl() const override { return nullptr; }
 
 private:
+  /**
+   * @return the native buffer to write with MSG_ZEROCOPY, or nullptr to write normally.
+   */
+  Buffer::OwnedImpl* zeroCopyBuffer(Buffer::Instance& buffer);
+
   TransportSocketCallbacks* callbacks_{};
   bool shutdown_{};
+  uint32_t zero_copy_min_bytes_;
+  ZeroCopyWritesPtr zero_copy_writes_;
 };
 
 class RawBufferSocketFactory : public TransportSocketFactory {
 public:
+  /**
+   * @param zero_copy_min_bytes supplies the smallest write sent with MSG_ZEROCOPY by the sockets
+   *        created by this factory, or 0 to never use zero copy writes.
+   */
+  RawBufferSocketFactory(uint32_t zero_copy_min_bytes = 0)
+      : zero_copy_min_bytes_(zero_copy_min_bytes) {}
+
   // Network::TransportSocketFactory
   TransportSocketPtr createTransportSocket() const override;
   bool implementsSecureTransport() const override;
+
+private:
+  const uint32_t zero_copy_min_bytes_;
 };
 
 } // namespace Network
@@ -0,0 +1,175 @@
+#include "common/network/zero_copy.h"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/errqueue.h>
+#endif
+
+#include "common/api/os_sys_calls_impl.h"
+#include "common/common/assert.h"
+
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define ENVOY_ZERO_COPY_WRITES
+#endif
+
+namespace Envoy {
+namespace Network {
+
+bool ZeroCopyWrites::supported() {
+#ifdef ENVOY_ZERO_COPY_WRITES
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool ZeroCopyWrites::enable(int fd) {
+#ifdef ENVOY_ZERO_COPY_WRITES
+  const int one = 1;
+  return Api::OsSysCallsSingleton::get().setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one,
+                                                    sizeof(one)) == 0;
+#else
+  UNREFERENCED_PARAMETER(fd);
+  return false;
+#endif
+}
+
+int ZeroCopyWrites::write(int fd, Buffer::OwnedImpl& buffer) {
+#ifdef ENVOY_ZERO_COPY_WRITES
+  std::vector<Buffer::SlicePtr> slices;
+  const int rc = buffer.writeRetained(fd, MSG_ZEROCOPY, slices);
+  if (rc > 0) {
+    pending_.push_back({next_id_++, std::move(slices)});
+  }
+  return rc;
+#else
+  UNREFERENCED_PARAMETER(fd);
+  UNREFERENCED_PARAMETER(buffer);
+  NOT_IMPLEMENTED;
+#endif
+}
+
+void ZeroCopyWrites::processCompletions(int fd) {
+#ifdef ENVOY_ZERO_COPY_WRITES
+  auto& os_syscalls = Api::OsSysCallsSingleton::get();
+  while (!pending_.empty()) {
+    uint8_t control[CMSG_SPACE(sizeof(sock_extended_err)) + CMSG_SPACE(sizeof(sockaddr_in6))];
+    msghdr message{};
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    if (os_syscalls.recvmsg(fd, &message, MSG_ERRQUEUE) < 0) {
+      // EAGAIN: nothing more has completed yet.
+      return;
+    }
+
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr;
+         header = CMSG_NXTHDR(&message, header)) {
+      if (!((header->cmsg_level == SOL_IP && header->cmsg_type == IP_RECVERR) ||
+            (header->cmsg_level == SOL_IPV6 && header->cmsg_type == IPV6_RECVERR))) {
+        continue;
+      }
+      const auto* error = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(header));
+      if (error->ee_errno != 0 || error->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+        continue;
+      }
+      if (error->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+        copied_ = true;
+      }
+      complete(error->ee_info, error->ee_data);
+    }
+  }
+#else
+  UNREFERENCED_PARAMETER(fd);
+#endif
+}
+
+void ZeroCopyWrites::complete(uint32_t first_id, uint32_t last_id) {
+  ENVOY_LOG(trace, "zero copy writes {}-{} complete", first_id, last_id);
+  // TCP completes writes in order, so normally this only pops from the front. The unsigned
+  // arithmetic handles the id wrapping around.
+  const uint32_t range = last_id - first_id;
+  for (auto it = pending_.begin(); it != pending_.end();) {
+    if (it->id_ - first_id <= range) {
+      it = pending_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void ZeroCopyLinger::start(Event::Dispatcher& dispatcher, int fd, ZeroCopyWritesPtr&& writes) {
+  writes->processCompletions(fd);
+  if (writes->empty()) {
+    return;
+  }
+
+  const int linger_fd = Api::OsSysCallsSingleton::get().dup(fd);
+  if (linger_fd == -1) {
+    // Reset the connection instead, so that closing it discards the data still referencing the
+    // written memory. The caller keeps the writes until after the close.
+    ENVOY_LOG(debug, "unable to linger for zero copy writes: {}", strerror(errno));
+    resetOnClose(fd);
+    return;
+  }
+  dispatcher.own(
+      Event::DeferredDeletablePtr{new ZeroCopyLinger(dispatcher, linger_fd, std::move(writes))});
+}
+
+ZeroCopyLinger::ZeroCopyLinger(Event::Dispatcher& dispatcher, int fd, ZeroCopyWritesPtr&& writes)
+    : dispatcher_(dispatcher), fd_(fd), writes_(std::move(writes)) {
+  // The connection closing its descriptor no longer ends the stream since this duplicate keeps the
+  // socket open, so end it here. Queued data is still sent first, exactly as with close().
+  Api::OsSysCallsSingleton::get().shutdown(fd_, SHUT_WR);
+
+  // Completions are queued on the socket's error queue, which is reported as an error event.
+  file_event_ = dispatcher_.createFileEvent(fd_, [this](uint32_t) -> void { onEvent(); },
+                                            Event::FileTriggerType::Edge,
+                                            Event::FileReadyType::Read);
+  timer_ = dispatcher_.createTimer([this]() -> void { finish(true); });
+  timer_->enableTimer(std::chrono::milliseconds(30000));
+}
+
+ZeroCopyLinger::~ZeroCopyLinger() {
+  if (!finished_) {
+    // The dispatcher is shutting down. The written memory is about to be released, so discard
+    // whatever the kernel still holds of it.
+    resetOnClose(fd_);
+    file_event_.reset();
+    timer_.reset();
+    Api::OsSysCallsSingleton::get().close(fd_);
+  }
+}
+
+void ZeroCopyLinger::resetOnClose(int fd) {
+  const struct linger reset_linger {
+    1, 0
+  };
+  Api::OsSysCallsSingleton::get().setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset_linger,
+                                             sizeof(reset_linger));
+}
+
+void ZeroCopyLinger::onEvent() {
+  writes_->processCompletions(fd_);
+  if (writes_->empty()) {
+    finish(false);
+  }
+}
+
+void ZeroCopyLinger::finish(bool reset) {
+  if (reset) {
+    ENVOY_LOG(debug, "timed out waiting for zero copy writes, resetting connection");
+    resetOnClose(fd_);
+  }
+  file_event_.reset();
+  timer_.reset();
+  Api::OsSysCallsSingleton::get().close(fd_);
+  finished_ = true;
+  dispatcher_.deferredDelete(dispatcher_.disown(*this));
+}
+
+} // namespace Network
+} // namespace Envoy
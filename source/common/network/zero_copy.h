@@ -0,0 +1,124 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "envoy/event/deferred_deletable.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/file_event.h"
+#include "envoy/event/timer.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/logger.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * Writes buffers to a socket with MSG_ZEROCOPY and holds on to the written memory until the kernel
+ * reports, through the socket's error queue, that it no longer references it.
+ */
+class ZeroCopyWrites : Logger::Loggable<Logger::Id::connection> {
+public:
+  /**
+   * @return bool whether MSG_ZEROCOPY is available on this platform.
+   */
+  static bool supported();
+
+  /**
+   * Enable MSG_ZEROCOPY on a socket.
+   * @param fd supplies the socket.
+   * @return bool whether the socket accepted the option.
+   */
+  static bool enable(int fd);
+
+  /**
+   * Write as much of a buffer as the socket accepts in a single sendmsg() call.
+   * @param fd supplies the socket, which must have been passed to enable().
+   * @param buffer supplies the data to write. Written data is drained from the buffer.
+   * @return int the number of bytes written, or -1 with errno set.
+   */
+  int write(int fd, Buffer::OwnedImpl& buffer);
+
+  /**
+   * Release the memory of all writes the kernel has reported complete. Never blocks.
+   * @param fd supplies the socket.
+   */
+  void processCompletions(int fd);
+
+  /**
+   * @return bool whether any written memory is still referenced by the kernel.
+   */
+  bool empty() const { return pending_.empty(); }
+
+  /**
+   * @return bool whether the kernel reported that it had to copy data rather than transmit it in
+   *         place, e.g. because the route uses a device without scatter/gather support or the
+   *         peer is on loopback. In that case zero copy writes only add overhead.
+   */
+  bool copied() const { return copied_; }
+
+private:
+  struct PendingWrite {
+    uint32_t id_;
+    std::vector<Buffer::SlicePtr> slices_;
+  };
+
+  void complete(uint32_t first_id, uint32_t last_id);
+
+  // Writes in the order they were issued. The kernel numbers successful MSG_ZEROCOPY writes
+  // sequentially from zero and reports completions as inclusive ranges of those numbers.
+  std::deque<PendingWrite> pending_;
+  uint32_t next_id_{};
+  bool copied_{};
+};
+
+typedef std::unique_ptr<ZeroCopyWrites> ZeroCopyWritesPtr;
+
+/**
+ * Keeps zero copy writes alive after their connection closes. Closing a socket does not stop the
+ * kernel from transmitting data it has already accepted, so the memory must not be released until
+ * the kernel is done with it. This duplicates the socket so that its error queue can still be
+ * read, shuts down its write side in place of the close, and releases everything once all writes
+ * complete. If that takes longer than 30 seconds the connection is reset, which discards the queued
+ * data. The dispatcher owns the object, and a linger still pending when the dispatcher is destroyed
+ * resets its connection.
+ */
+class ZeroCopyLinger : public Event::DeferredDeletable, Logger::Loggable<Logger::Id::connection> {
+public:
+  /**
+   * Linger for the outstanding writes of a socket that is about to be closed. If lingering is not
+   * possible, the socket is instead set to reset the connection when closed and the writes are
+   * left with the caller, which must keep them until after the close.
+   * @param dispatcher supplies the dispatcher of the closing connection.
+   * @param fd supplies the socket.
+   * @param writes supplies the outstanding writes.
+   */
+  static void start(Event::Dispatcher& dispatcher, int fd, ZeroCopyWritesPtr&& writes);
+
+  ~ZeroCopyLinger();
+
+private:
+  ZeroCopyLinger(Event::Dispatcher& dispatcher, int fd, ZeroCopyWritesPtr&& writes);
+
+  void onEvent();
+  void finish(bool reset);
+
+  /**
+   * Make closing a socket reset the connection, discarding any data still queued for sending.
+   */
+  static void resetOnClose(int fd);
+
+  Event::Dispatcher& dispatcher_;
+  const int fd_;
+  ZeroCopyWritesPtr writes_;
+  Event::FileEventPtr file_event_;
+  Event::TimerPtr timer_;
+  bool finished_{};
+};
+
+} // namespace Network
+} // namespace Envoy
@@ -5,7 +5,6 @@
 #include <cstdint>
 #include <map>
 #include <memory>
-#include <regex>
 #include <string>
 #include <vector>
 
@@ -18,6 +17,7 @@
 #include "common/common/empty_string.h"
 #include "common/common/fmt.h"
 #include "common/common/hash.h"
+#include "common/common/regex.h"
 #include "common/common/utility.h"
 #include "common/config/metadata.h"
 #include "common/config/rds_json.h"
@@ -55,7 +55,7 @@ CorsPolicyImpl::CorsPolicyImpl(const envoy::api::v2::route::CorsPolicy& config)
     allow_origin_.push_back(origin);
   }
   for (const auto& regex : config.allow_origin_regex()) {
-    allow_origin_regex_.push_back(RegexUtil::parseRegex(regex));
+    allow_origin_regex_.push_back(Regex::Utility::parseRegex(regex));
   }
   allow_methods_ = config.allow_methods();
   allow_headers_ = config.allow_headers();
@@ -665,7 +665,7 @@ RegexRouteEntryImpl::RegexRouteEntryImpl(const VirtualHostImpl& vhost,
                                          const envoy::api::v2::route::Route& route,
                                          Server::Configuration::FactoryContext& factory_context)
     : RouteEntryImplBase(vhost, route, factory_context),
-      regex_(RegexUtil::parseRegex(route.match().regex().c_str())),
+      regex_(Regex::Utility::parseRegex(route.match().regex())),
       regex_str_(route.match().regex()) {}
 
 void RegexRouteEntryImpl::rewritePathHeader(Http::HeaderMap& headers,
@@ -674,7 +674,7 @@ void RegexRouteEntryImpl::rewritePathHeader(Http::HeaderMap& headers,
   const char* query_string_start = Http::Utility::findQueryStringStart(path);
   // TODO(yuval-k): This ASSERT can happen if the path was changed by a filter without clearing the
   // route cache. We should consider if ASSERT-ing is the desired behavior in this case.
-  ASSERT(std::regex_match(path.c_str(), query_string_start, regex_));
+  ASSERT(regex_->match(absl::string_view(path.c_str(), query_string_start - path.c_str())));
   std::string matched_path(path.c_str(), query_string_start);
 
   finalizePathHeader(headers, matched_path, insert_envoy_original_path);
@@ -685,7 +685,7 @@ RouteConstSharedPtr RegexRouteEntryImpl::matches(const Http::HeaderMap& headers,
   if (RouteEntryImplBase::matchRoute(headers, random_value)) {
     const Http::HeaderString& path = headers.Path()->value();
     const char* query_string_start = Http::Utility::findQueryStringStart(path);
-    if (std::regex_match(path.c_str(), query_string_start, regex_)) {
+    if (regex_->match(absl::string_view(path.c_str(), query_string_start - path.c_str()))) {
       return clusterEntry(headers, random_value);
     }
   }
@@ -693,11 +693,10 @@ RouteConstSharedPtr RegexRouteEntryImpl::matches(const Http::HeaderMap& headers,
 }
 
 VirtualHostImpl::VirtualHostImpl(const envoy::api::v2::route::VirtualHost& virtual_host,
-                                 const ConfigImpl& global_route_config,
-                                 Server::Configuration::FactoryContext& factory_context,
-                                 bool validate_clusters)
+                                 CommonConfigImplConstSharedPtr global_route_config,
+                                 Server::Configuration::FactoryContext& factory_context)
     : name_(virtual_host.name()), rate_limit_policy_(virtual_host.rate_limits()),
-      global_route_config_(global_route_config),
+      global_route_config_(std::move(global_route_config)),
       request_headers_parser_(HeaderParser::configure(virtual_host.request_headers_to_add())),
       response_headers_parser_(HeaderParser::configure(virtual_host.response_headers_to_add(),
                                                        virtual_host.response_headers_to_remove())),
@@ -723,23 +722,19 @@ VirtualHostImpl::VirtualHostImpl(const envoy::api::v2::route::VirtualHost& virtu
         route.match().path_specifier_case() == envoy::api::v2::route::RouteMatch::kPath;
     const bool has_regex =
         route.match().path_specifier_case() == envoy::api::v2::route::RouteMatch::kRegex;
+    const bool case_sensitive =
+        PROTOBUF_GET_WRAPPED_OR_DEFAULT(route.match(), case_sensitive, true);
+    const uint32_t index = routes_.size();
     if (has_prefix) {
       routes_.emplace_back(new PrefixRouteEntryImpl(*this, route, factory_context));
+      route_index_.addPrefix(route.match().prefix(), case_sensitive, index);
     } else if (has_path) {
       routes_.emplace_back(new PathRouteEntryImpl(*this, route, factory_context));
+      route_index_.addExact(route.match().path(), case_sensitive, index);
     } else {
       ASSERT(has_regex);
       routes_.emplace_back(new RegexRouteEntryImpl(*this, route, factory_context));
-    }
-
-    if (validate_clusters) {
-      routes_.back()->validateClusters(factory_context.clusterManager());
-      if (!routes_.back()->shadowPolicy().cluster().empty()) {
-        if (!factory_context.clusterManager().get(routes_.back()->shadowPolicy().cluster())) {
-          throw EnvoyException(fmt::format("route: unknown shadow cluster '{}'",
-                                           routes_.back()->shadowPolicy().cluster()));
-        }
-      }
+      route_index_.addUnindexed(index);
     }
   }
 
@@ -759,43 +754,57 @@ VirtualHostImpl::VirtualClusterEntry::VirtualClusterEntry(
   }
 
   const std::string pattern = virtual_cluster.pattern();
-  pattern_ = RegexUtil::parseRegex(pattern);
+  pattern_ = Regex::Utility::parseRegex(pattern);
   name_ = virtual_cluster.name();
 }
 
-const Config& VirtualHostImpl::routeConfig() const { return global_route_config_; }
+void VirtualHostImpl::validateClusters(Upstream::ClusterManager& cm) const {
+  for (const auto& route : routes_) {
+    route->validateClusters(cm);
+    if (!route->shadowPolicy().cluster().empty()) {
+      if (!cm.get(route->shadowPolicy().cluster())) {
+        throw EnvoyException(
+            fmt::format("route: unknown shadow cluster '{}'", route->shadowPolicy().cluster()));
+      }
+    }
+  }
+}
+
+const CommonConfig& VirtualHostImpl::routeConfig() const { return *global_route_config_; }
 
 const RouteSpecificFilterConfig* VirtualHostImpl::perFilterConfig(const std::string& name) const {
   return per_filter_configs_.get(name);
 }
 
-const VirtualHostImpl* RouteMatcher::findWildcardVirtualHost(const std::string& host) const {
-  // We do a longest wildcard suffix match against the host that's passed in.
-  // (e.g. foo-bar.baz.com should match *-bar.baz.com before matching *.baz.com)
-  // This is done by scanning the length => wildcards map looking for every
-  // wildcard whose size is < length.
-  for (const auto& iter : wildcard_virtual_host_suffixes_) {
-    const uint32_t wildcard_length = iter.first;
-    const auto& wildcard_map = iter.second;
-    // >= because *.foo.com shouldn't match .foo.com.
-    if (wildcard_length >= host.size()) {
-      continue;
-    }
-    const auto& match = wildcard_map.find(host.substr(host.size() - wildcard_length));
-    if (match != wildcard_map.end()) {
-      return match->second.get();
-    }
-  }
-  return nullptr;
-}
-
 RouteMatcher::RouteMatcher(const envoy::api::v2::RouteConfiguration& route_config,
-                           const ConfigImpl& global_route_config,
+                           const CommonConfigImplConstSharedPtr& global_route_config,
                            Server::Configuration::FactoryContext& factory_context,
-                           bool validate_clusters) {
+                           bool validate_clusters, const RouteMatcher* previous,
+                           const envoy::api::v2::RouteConfiguration* previous_config) {
+  ASSERT(previous == nullptr || previous_config != nullptr);
   for (const auto& virtual_host_config : route_config.virtual_hosts()) {
-    VirtualHostSharedPtr virtual_host(new VirtualHostImpl(virtual_host_config, global_route_config,
-                                                          factory_context, validate_clusters));
+    const uint64_t hash = MessageUtil::hash(virtual_host_config);
+    VirtualHostSharedPtr virtual_host;
+    if (previous != nullptr) {
+      const auto previous_index = previous->virtual_hosts_by_hash_.find(hash);
+      if (previous_index != previous->virtual_hosts_by_hash_.end() &&
+          Protobuf::util::MessageDifferencer::Equals(
+              previous_config->virtual_hosts(previous_index->second), virtual_host_config)) {
+        virtual_host = previous->virtual_hosts_[previous_index->second];
+      }
+    }
+    if (virtual_host == nullptr) {
+      virtual_host = std::make_shared<VirtualHostImpl>(virtual_host_config, global_route_config,
+                                                       factory_context);
+    }
+    // Clusters may have been removed since a reused virtual host was validated, so it is validated
+    // again.
+    if (validate_clusters) {
+      virtual_host->validateClusters(factory_context.clusterManager());
+    }
+    const uint32_t index = virtual_hosts_.size();
+    virtual_hosts_by_hash_.emplace(hash, index);
+    virtual_hosts_.push_back(virtual_host);
     for (const std::string& domain_name : virtual_host_config.domains()) {
       const std::string domain = Http::LowerCaseString(domain_name).get();
       if ("*" == domain) {
@@ -804,14 +813,12 @@ RouteMatcher::RouteMatcher(const envoy::api::v2::RouteConfiguration& route_confi
         }
         default_virtual_host_ = virtual_host;
       } else if (domain.size() > 0 && '*' == domain[0]) {
-        wildcard_virtual_host_suffixes_[domain.size() - 1].emplace(domain.substr(1), virtual_host);
-      } else {
-        if (virtual_hosts_.find(domain) != virtual_hosts_.end()) {
-          throw EnvoyException(fmt::format(
-              "Only unique values for domains are permitted. Duplicate entry of domain {}",
-              domain));
-        }
-        virtual_hosts_.emplace(domain, virtual_host);
+        domains_.addSuffixWildcard(domain.substr(1), index);
+      } else if (domain.size() > 0 && '*' == domain.back()) {
+        domains_.addPrefixWildcard(domain.substr(0, domain.size() - 1), index);
+      } else if (!domains_.addExact(domain, index)) {
+        throw EnvoyException(fmt::format(
+            "Only unique values for domains are permitted. Duplicate entry of domain {}", domain));
       }
     }
   }
@@ -827,9 +834,18 @@ RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const Http::HeaderMap&
     return SSL_REDIRECT_ROUTE;
   }
 
-  // Check for a route that matches the request.
-  for (const RouteEntryImplBaseConstSharedPtr& route : routes_) {
-    RouteConstSharedPtr route_entry = route->matches(headers, random_value);
+  if (routes_.empty()) {
+    return nullptr;
+  }
+
+  // Check for a route that matches the request. Only the routes whose path criterion may match are
+  // evaluated, in configuration order, so the first match is the same as with a full scan.
+  const Http::HeaderString& path = headers.Path()->value();
+  RoutePathIndex::Candidates candidates =
+      route_index_.candidates(absl::string_view(path.c_str(), path.size()));
+  uint32_t index;
+  while (candidates.next(index)) {
+    RouteConstSharedPtr route_entry = routes_[index]->matches(headers, random_value);
     if (nullptr != route_entry) {
       return route_entry;
     }
@@ -840,22 +856,17 @@ RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const Http::HeaderMap&
 
 const VirtualHostImpl* RouteMatcher::findVirtualHost(const Http::HeaderMap& headers) const {
   // Fast path the case where we only have a default virtual host.
-  if (virtual_hosts_.empty() && default_virtual_host_) {
+  if (domains_.empty() && default_virtual_host_) {
     return default_virtual_host_.get();
   }
 
   // TODO (@rshriram) Match Origin header in WebSocket
   // request with VHost, using wildcard match
-  const std::string host = Http::LowerCaseString(headers.Host()->value().c_str()).get();
-  const auto& iter = virtual_hosts_.find(host);
-  if (iter != virtual_hosts_.end()) {
-    return iter->second.get();
-  }
-  if (!wildcard_virtual_host_suffixes_.empty()) {
-    const VirtualHostImpl* vhost = findWildcardVirtualHost(host);
-    if (vhost != nullptr) {
-      return vhost;
-    }
+  const Http::HeaderString& host = headers.Host()->value();
+  const absl::optional<uint32_t> index =
+      domains_.find(absl::string_view(host.c_str(), host.size()));
+  if (index) {
+    return virtual_hosts_[index.value()].get();
   }
   return default_virtual_host_.get();
 }
@@ -881,7 +892,7 @@ VirtualHostImpl::virtualClusterFromEntries(const Http::HeaderMap& headers) const
     bool method_matches =
         !entry.method_ || headers.Method()->value().c_str() == entry.method_.value();
 
-    if (method_matches && std::regex_match(headers.Path()->value().c_str(), entry.pattern_)) {
+    if (method_matches && entry.pattern_->match(headers.Path()->value().getStringView())) {
       return &entry;
     }
   }
@@ -893,21 +904,49 @@ VirtualHostImpl::virtualClusterFromEntries(const Http::HeaderMap& headers) const
   return nullptr;
 }
 
-ConfigImpl::ConfigImpl(const envoy::api::v2::RouteConfiguration& config,
-                       Server::Configuration::FactoryContext& factory_context,
-                       bool validate_clusters_default)
-    : name_(config.name()) {
-  route_matcher_.reset(new RouteMatcher(
-      config, *this, factory_context,
-      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, validate_clusters, validate_clusters_default)));
-
+CommonConfigImpl::CommonConfigImpl(const envoy::api::v2::RouteConfiguration& config)
+    : request_headers_parser_(HeaderParser::configure(config.request_headers_to_add())),
+      response_headers_parser_(HeaderParser::configure(config.response_headers_to_add(),
+                                                       config.response_headers_to_remove())),
+      name_(config.name()) {
   for (const std::string& header : config.internal_only_headers()) {
     internal_only_headers_.push_back(Http::LowerCaseString(header));
   }
+}
+
+bool CommonConfigImpl::sameCommonParts(const envoy::api::v2::RouteConfiguration& lhs,
+                                       const envoy::api::v2::RouteConfiguration& rhs) {
+  return Protobuf::util::MessageDifferencer::Equals(commonParts(lhs), commonParts(rhs));
+}
+
+envoy::api::v2::RouteConfiguration
+CommonConfigImpl::commonParts(const envoy::api::v2::RouteConfiguration& config) {
+  envoy::api::v2::RouteConfiguration common;
+  common.set_name(config.name());
+  *common.mutable_internal_only_headers() = config.internal_only_headers();
+  *common.mutable_response_headers_to_add() = config.response_headers_to_add();
+  *common.mutable_response_headers_to_remove() = config.response_headers_to_remove();
+  *common.mutable_request_headers_to_add() = config.request_headers_to_add();
+  return common;
+}
 
-  request_headers_parser_ = HeaderParser::configure(config.request_headers_to_add());
-  response_headers_parser_ = HeaderParser::configure(config.response_headers_to_add(),
-                                                     config.response_headers_to_remove());
+ConfigImpl::ConfigImpl(const envoy::api::v2::RouteConfiguration& config,
+                       Server::Configuration::FactoryContext& factory_context,
+                       bool validate_clusters_default, const ConfigImpl* previous,
+                       const envoy::api::v2::RouteConfiguration* previous_config) {
+  ASSERT(previous == nullptr || previous_config != nullptr);
+  // Virtual hosts can only be shared with a previous version whose common config is the same,
+  // since each virtual host holds on to the common config it was built with.
+  if (previous != nullptr && CommonConfigImpl::sameCommonParts(*previous_config, config)) {
+    shared_config_ = previous->shared_config_;
+  } else {
+    shared_config_ = std::make_shared<const CommonConfigImpl>(config);
+    previous = nullptr;
+  }
+  route_matcher_.reset(new RouteMatcher(
+      config, shared_config_, factory_context,
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, validate_clusters, validate_clusters_default),
+      previous != nullptr ? previous->route_matcher_.get() : nullptr, previous_config));
 }
 
 PerFilterConfigs::PerFilterConfigs(
@@ -3,15 +3,14 @@
 #include <chrono>
 #include <cstdint>
 #include <list>
-#include <map>
 #include <memory>
-#include <regex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "envoy/api/v2/rds.pb.h"
 #include "envoy/api/v2/route/route.pb.h"
+#include "envoy/common/regex.h"
 #include "envoy/router/router.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/server/filter_config.h"
@@ -19,9 +18,11 @@
 
 #include "common/http/header_utility.h"
 #include "common/router/config_utility.h"
+#include "common/router/domain_trie.h"
 #include "common/router/header_formatter.h"
 #include "common/router/header_parser.h"
 #include "common/router/metadatamatchcriteria_impl.h"
+#include "common/router/route_path_index.h"
 #include "common/router/router_ratelimit.h"
 #include "common/tcp_proxy/tcp_proxy.h"
 
@@ -98,7 +99,9 @@ public:
 
   // Router::CorsPolicy
   const std::list<std::string>& allowOrigins() const override { return allow_origin_; };
-  const std::list<std::regex>& allowOriginRegexes() const override { return allow_origin_regex_; }
+  const std::vector<Regex::CompiledMatcherPtr>& allowOriginRegexes() const override {
+    return allow_origin_regex_;
+  }
   const std::string& allowMethods() const override { return allow_methods_; };
   const std::string& allowHeaders() const override { return allow_headers_; };
   const std::string& exposeHeaders() const override { return expose_headers_; };
@@ -108,7 +111,7 @@ public:
 
 private:
   std::list<std::string> allow_origin_;
-  std::list<std::regex> allow_origin_regex_;
+  std::vector<Regex::CompiledMatcherPtr> allow_origin_regex_;
   std::string allow_methods_;
   std::string allow_headers_;
   std::string expose_headers_;
@@ -117,28 +120,70 @@ private:
   bool enabled_;
 };
 
-class ConfigImpl;
+/**
+ * Holds the parts of a route configuration that all of its virtual hosts share: everything but
+ * the virtual hosts themselves.
+ */
+class CommonConfigImpl : public CommonConfig {
+public:
+  CommonConfigImpl(const envoy::api::v2::RouteConfiguration& config);
+
+  /**
+   * @return bool whether two configurations have the same common parts, in which case a common
+   *         config built from one can be used for the other.
+   */
+  static bool sameCommonParts(const envoy::api::v2::RouteConfiguration& lhs,
+                              const envoy::api::v2::RouteConfiguration& rhs);
+
+  const HeaderParser& requestHeaderParser() const { return *request_headers_parser_; };
+  const HeaderParser& responseHeaderParser() const { return *response_headers_parser_; };
+
+  // Router::CommonConfig
+  const std::list<Http::LowerCaseString>& internalOnlyHeaders() const override {
+    return internal_only_headers_;
+  }
+  const std::string& name() const override { return name_; }
+
+private:
+  static envoy::api::v2::RouteConfiguration
+  commonParts(const envoy::api::v2::RouteConfiguration& config);
+
+  std::list<Http::LowerCaseString> internal_only_headers_;
+  HeaderParserPtr request_headers_parser_;
+  HeaderParserPtr response_headers_parser_;
+  const std::string name_;
+};
+
+typedef std::shared_ptr<const CommonConfigImpl> CommonConfigImplConstSharedPtr;
+
 /**
  * Holds all routing configuration for an entire virtual host.
  */
 class VirtualHostImpl : public VirtualHost {
 public:
   VirtualHostImpl(const envoy::api::v2::route::VirtualHost& virtual_host,
-                  const ConfigImpl& global_route_config,
-                  Server::Configuration::FactoryContext& factory_context, bool validate_clusters);
+                  CommonConfigImplConstSharedPtr global_route_config,
+                  Server::Configuration::FactoryContext& factory_context);
 
   RouteConstSharedPtr getRouteFromEntries(const Http::HeaderMap& headers,
                                           uint64_t random_value) const;
   const VirtualCluster* virtualClusterFromEntries(const Http::HeaderMap& headers) const;
-  const ConfigImpl& globalRouteConfig() const { return global_route_config_; }
+  const CommonConfigImpl& globalRouteConfig() const { return *global_route_config_; }
   const HeaderParser& requestHeaderParser() const { return *request_headers_parser_; };
   const HeaderParser& responseHeaderParser() const { return *response_headers_parser_; };
 
+  /**
+   * Check that the clusters of all routes exist.
+   * @param cm supplies the cluster manager to look the clusters up in.
+   * @throw EnvoyException if a cluster does not exist.
+   */
+  void validateClusters(Upstream::ClusterManager& cm) const;
+
   // Router::VirtualHost
   const CorsPolicy* corsPolicy() const override { return cors_policy_.get(); }
   const std::string& name() const override { return name_; }
   const RateLimitPolicy& rateLimitPolicy() const override { return rate_limit_policy_; }
-  const Config& routeConfig() const override;
+  const CommonConfig& routeConfig() const override;
   const RouteSpecificFilterConfig* perFilterConfig(const std::string&) const override;
 
 private:
@@ -150,7 +195,7 @@ private:
     // Router::VirtualCluster
     const std::string& name() const override { return name_; }
 
-    std::regex pattern_;
+    Regex::CompiledMatcherPtr pattern_;
     absl::optional<std::string> method_;
     std::string name_;
   };
@@ -167,12 +212,12 @@ private:
 
   const std::string name_;
   std::vector<RouteEntryImplBaseConstSharedPtr> routes_;
+  RoutePathIndex route_index_;
   std::vector<VirtualClusterEntry> virtual_clusters_;
   SslRequirements ssl_requirements_;
   const RateLimitPolicyImpl rate_limit_policy_;
   std::unique_ptr<const CorsPolicyImpl> cors_policy_;
-  const ConfigImpl& global_route_config_; // See note in RouteEntryImplBase::clusterEntry() on why
-                                          // raw ref to the top level config is currently safe.
+  const CommonConfigImplConstSharedPtr global_route_config_;
   HeaderParserPtr request_headers_parser_;
   HeaderParserPtr response_headers_parser_;
   PerFilterConfigs per_filter_configs_;
@@ -606,7 +651,7 @@ public:
   void rewritePathHeader(Http::HeaderMap& headers, bool insert_envoy_original_path) const override;
 
 private:
-  const std::regex regex_;
+  const Regex::CompiledMatcherPtr regex_;
   const std::string regex_str_;
 };
 
@@ -616,28 +661,30 @@ private:
  */
 class RouteMatcher {
 public:
+  /**
+   * @param previous supplies the matcher of a previous version of the route configuration with the
+   *        same common config, whose virtual hosts are reused where their configuration has not
+   *        changed, or nullptr to build all virtual hosts.
+   * @param previous_config supplies the configuration previous was built from. Only used if
+   *        previous is not nullptr.
+   */
   RouteMatcher(const envoy::api::v2::RouteConfiguration& config,
-               const ConfigImpl& global_http_config,
-               Server::Configuration::FactoryContext& factory_context, bool validate_clusters);
+               const CommonConfigImplConstSharedPtr& global_route_config,
+               Server::Configuration::FactoryContext& factory_context, bool validate_clusters,
+               const RouteMatcher* previous,
+               const envoy::api::v2::RouteConfiguration* previous_config);
 
   RouteConstSharedPtr route(const Http::HeaderMap& headers, uint64_t random_value) const;
 
 private:
   const VirtualHostImpl* findVirtualHost(const Http::HeaderMap& headers) const;
-  const VirtualHostImpl* findWildcardVirtualHost(const std::string& host) const;
-
-  std::unordered_map<std::string, VirtualHostSharedPtr> virtual_hosts_;
-  // std::greater as a minor optimization to iterate from more to less specific
-  //
-  // A note on using an unordered_map versus a vector of (string, VirtualHostSharedPtr) pairs:
-  //
-  // Based on local benchmarks, each vector entry costs around 20ns for recall and (string)
-  // comparison with a fixed cost of about 25ns. For unordered_map, the empty map costs about 65ns
-  // and climbs to about 110ns once there are any entries.
-  //
-  // The break-even is 4 entries.
-  std::map<int64_t, std::unordered_map<std::string, VirtualHostSharedPtr>, std::greater<int64_t>>
-      wildcard_virtual_host_suffixes_;
+
+  // In the order of the virtual hosts in the configuration.
+  std::vector<VirtualHostSharedPtr> virtual_hosts_;
+  // Positions in virtual_hosts_, keyed by the hash of the virtual host's configuration. A hash
+  // match is only a candidate for reuse until the configurations compare equal.
+  std::unordered_map<uint64_t, uint32_t> virtual_hosts_by_hash_;
+  DomainTrie domains_;
   VirtualHostSharedPtr default_virtual_host_;
 };
 
@@ -646,12 +693,26 @@ private:
  */
 class ConfigImpl : public Config {
 public:
+  /**
+   * @param previous supplies a previous version of the route configuration, or nullptr. If its
+   *        common config is unchanged, the virtual hosts whose configuration has not changed are
+   *        shared with it instead of being built again, so that an update costs work in proportion
+   *        to the virtual hosts it changes.
+   * @param previous_config supplies the configuration previous was built from. It is only needed
+   *        while building, so the caller keeps it rather than every version of the route
+   *        configuration holding a copy. Only used if previous is not nullptr.
+   */
   ConfigImpl(const envoy::api::v2::RouteConfiguration& config,
-             Server::Configuration::FactoryContext& factory_context,
-             bool validate_clusters_default);
+             Server::Configuration::FactoryContext& factory_context, bool validate_clusters_default,
+             const ConfigImpl* previous = nullptr,
+             const envoy::api::v2::RouteConfiguration* previous_config = nullptr);
 
-  const HeaderParser& requestHeaderParser() const { return *request_headers_parser_; };
-  const HeaderParser& responseHeaderParser() const { return *response_headers_parser_; };
+  const HeaderParser& requestHeaderParser() const {
+    return shared_config_->requestHeaderParser();
+  };
+  const HeaderParser& responseHeaderParser() const {
+    return shared_config_->responseHeaderParser();
+  };
 
   // Router::Config
   RouteConstSharedPtr route(const Http::HeaderMap& headers, uint64_t random_value) const override {
@@ -659,17 +720,14 @@ public:
   }
 
   const std::list<Http::LowerCaseString>& internalOnlyHeaders() const override {
-    return internal_only_headers_;
+    return shared_config_->internalOnlyHeaders();
   }
 
-  const std::string& name() const override { return name_; }
+  const std::string& name() const override { return shared_config_->name(); }
 
 private:
+  CommonConfigImplConstSharedPtr shared_config_;
   std::unique_ptr<RouteMatcher> route_matcher_;
-  std::list<Http::LowerCaseString> internal_only_headers_;
-  HeaderParserPtr request_headers_parser_;
-  HeaderParserPtr response_headers_parser_;
-  const std::string name_;
 };
 
 /**
@@ -0,0 +1,122 @@
+#include "common/router/domain_trie.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace Envoy {
+namespace Router {
+
+bool DomainTrie::addExact(const std::string& domain, uint32_t index) {
+  absl::string_view first;
+  Node& node = insert(suffixes_, domain, true, first);
+  auto child = node.children_.find(first);
+  if (child == node.children_.end()) {
+    child = node.children_.emplace(intern(first), std::make_unique<Node>()).first;
+  }
+  if (child->second->exact_) {
+    return false;
+  }
+  child->second->exact_ = index;
+  empty_ = false;
+  return true;
+}
+
+void DomainTrie::addSuffixWildcard(const std::string& suffix, uint32_t index) {
+  insertWildcard(suffixes_, suffix, true, index);
+}
+
+void DomainTrie::addPrefixWildcard(const std::string& prefix, uint32_t index) {
+  insertWildcard(prefixes_, prefix, false, index);
+  has_prefixes_ = true;
+}
+
+absl::optional<uint32_t> DomainTrie::find(absl::string_view host) const {
+  absl::optional<uint32_t> match = find(suffixes_, host, true);
+  if (!match && has_prefixes_) {
+    match = find(prefixes_, host, false);
+  }
+  return match;
+}
+
+DomainTrie::Node& DomainTrie::insert(Node& root, absl::string_view domain, bool reversed,
+                                     absl::string_view& last) {
+  Node* node = &root;
+  absl::string_view rest = domain;
+  while (true) {
+    const size_t dot = reversed ? rest.rfind('.') : rest.find('.');
+    if (dot == absl::string_view::npos) {
+      last = rest;
+      return *node;
+    }
+    const absl::string_view label = reversed ? rest.substr(dot + 1) : rest.substr(0, dot);
+    rest = reversed ? rest.substr(0, dot) : rest.substr(dot + 1);
+    auto child = node->children_.find(label);
+    if (child == node->children_.end()) {
+      child = node->children_.emplace(intern(label), std::make_unique<Node>()).first;
+    }
+    node = child->second.get();
+  }
+}
+
+void DomainTrie::insertWildcard(Node& root, absl::string_view domain, bool reversed,
+                                uint32_t index) {
+  absl::string_view fragment;
+  Node& node = insert(root, domain, reversed, fragment);
+  empty_ = false;
+  if (node.wildcards_.find(fragment) != node.wildcards_.end()) {
+    return;
+  }
+  node.wildcards_.emplace(intern(fragment), index);
+  if (std::find(node.wildcard_lengths_.begin(), node.wildcard_lengths_.end(), fragment.size()) ==
+      node.wildcard_lengths_.end()) {
+    node.wildcard_lengths_.push_back(fragment.size());
+    std::sort(node.wildcard_lengths_.begin(), node.wildcard_lengths_.end(),
+              std::greater<size_t>());
+  }
+}
+
+absl::string_view DomainTrie::intern(absl::string_view str) {
+  strings_.emplace_back(str);
+  return strings_.back();
+}
+
+absl::optional<uint32_t> DomainTrie::find(const Node& root, absl::string_view host,
+                                          bool reversed) {
+  const Node* node = &root;
+  absl::string_view rest = host;
+  absl::optional<uint32_t> match;
+  while (true) {
+    const size_t dot = reversed ? rest.rfind('.') : rest.find('.');
+    const bool last = dot == absl::string_view::npos;
+    const absl::string_view label =
+        last ? rest : (reversed ? rest.substr(dot + 1) : rest.substr(0, dot));
+
+    // The wildcards of a deeper node are longer than those of the nodes above it, so they replace
+    // any match found so far. The part of the host that '*' stands for must not be empty.
+    for (const size_t length : node->wildcard_lengths_) {
+      if (length > label.size() || (length == label.size() && last)) {
+        continue;
+      }
+      const auto wildcard = node->wildcards_.find(
+          reversed ? label.substr(label.size() - length) : label.substr(0, length));
+      if (wildcard != node->wildcards_.end()) {
+        match = wildcard->second;
+        break;
+      }
+    }
+
+    const auto child = node->children_.find(label);
+    if (child == node->children_.end()) {
+      return match;
+    }
+    if (last) {
+      // Exact domains take precedence over wildcards.
+      return child->second->exact_ ? child->second->exact_ : match;
+    }
+    node = child->second.get();
+    rest = reversed ? rest.substr(0, dot) : rest.substr(dot + 1);
+  }
+}
+
+} // namespace Router
+} // namespace Envoy
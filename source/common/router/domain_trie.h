@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/common/utility.h"
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Index from the domains of the virtual hosts of a route configuration to the virtual hosts, each
+ * identified by its position in the configuration. Domains are split into dot separated labels
+ * and kept in tries of labels: one walked from the last label for exact domains and suffix
+ * wildcards, and one walked from the first label for prefix wildcards. Finding the virtual host
+ * for a host costs a single walk over the host's labels, regardless of the number of domains, and
+ * a second walk only if prefix wildcards are configured and no other domain matches. Domains are
+ * compared case insensitively, so hosts do not need to be lowercased.
+ *
+ * A suffix wildcard "*<suffix>" matches a host that ends with <suffix> and is longer than it, so
+ * "*-bar.foo.com" matches "baz-bar.foo.com" but not "-bar.foo.com". Prefix wildcards
+ * "<prefix>*" match the other end of the host in the same way. An exact domain takes precedence
+ * over any wildcard, the longest suffix wildcard over shorter ones and over prefix wildcards, and
+ * the longest prefix wildcard over shorter ones.
+ */
+class DomainTrie {
+public:
+  /**
+   * Add a domain that matches a host equal to it.
+   * @param domain supplies the domain.
+   * @param index supplies the position of the virtual host.
+   * @return bool false if the domain was already added, in which case the index is not changed.
+   */
+  bool addExact(const std::string& domain, uint32_t index);
+
+  /**
+   * Add a wildcard domain that matches a host longer than suffix and ending with it. If the
+   * suffix was already added, the first virtual host added for it is kept.
+   * @param suffix supplies the domain without its leading '*'.
+   * @param index supplies the position of the virtual host.
+   */
+  void addSuffixWildcard(const std::string& suffix, uint32_t index);
+
+  /**
+   * Add a wildcard domain that matches a host longer than prefix and starting with it. If the
+   * prefix was already added, the first virtual host added for it is kept.
+   * @param prefix supplies the domain without its trailing '*'.
+   * @param index supplies the position of the virtual host.
+   */
+  void addPrefixWildcard(const std::string& prefix, uint32_t index);
+
+  /**
+   * Find the virtual host for a host.
+   * @param host supplies the host, in any case.
+   * @return the position of the virtual host, or an empty optional if no domain matches host.
+   */
+  absl::optional<uint32_t> find(absl::string_view host) const;
+
+  /**
+   * @return bool true if no domains have been added.
+   */
+  bool empty() const { return empty_; }
+
+private:
+  typedef std::unordered_map<absl::string_view, uint32_t, StringUtil::CaseInsensitiveHash,
+                             StringUtil::CaseInsensitiveCompare>
+      WildcardMap;
+
+  /**
+   * Node of a trie of labels. A node is reached by matching the labels on its path, and holds the
+   * wildcards whose remaining part is a fragment of the next label of the host: its suffix in the
+   * trie walked from the last label, and its prefix in the trie walked from the first label. The
+   * keys of the maps point into strings_.
+   */
+  struct Node {
+    std::unordered_map<absl::string_view, std::unique_ptr<Node>, StringUtil::CaseInsensitiveHash,
+                       StringUtil::CaseInsensitiveCompare>
+        children_;
+    absl::optional<uint32_t> exact_;
+    WildcardMap wildcards_;
+    // Distinct lengths of the fragments in wildcards_, longest first.
+    std::vector<size_t> wildcard_lengths_;
+  };
+
+  /**
+   * Walk down a trie along the labels of a domain, creating the nodes that do not exist.
+   * @param root supplies the root of the trie.
+   * @param domain supplies the domain.
+   * @param reversed supplies whether the trie is walked from the last label.
+   * @param last supplies the label that was not walked: the first label if reversed, the last
+   *        label otherwise.
+   * @return the node reached.
+   */
+  Node& insert(Node& root, absl::string_view domain, bool reversed, absl::string_view& last);
+  void insertWildcard(Node& root, absl::string_view domain, bool reversed, uint32_t index);
+  absl::string_view intern(absl::string_view str);
+
+  static absl::optional<uint32_t> find(const Node& root, absl::string_view host, bool reversed);
+
+  Node suffixes_;
+  Node prefixes_;
+  // Storage for the labels and fragments that the maps of the nodes point into. A deque does not
+  // move its elements when it grows.
+  std::deque<std::string> strings_;
+  bool has_prefixes_{};
+  bool empty_{true};
+};
+
+} // namespace Router
+} // namespace Envoy
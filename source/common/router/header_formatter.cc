@@ -136,16 +136,15 @@ RequestInfoHeaderFormatter::RequestInfoHeaderFormatter(absl::string_view field_n
           *request_info.downstreamLocalAddress());
     };
   } else if (field_name.find("START_TIME") == 0) {
-    const std::string pattern = fmt::format("%{}%", field_name);
-    if (start_time_formatters_.find(pattern) == start_time_formatters_.end()) {
-      start_time_formatters_.emplace(
-          std::make_pair(pattern, AccessLog::AccessLogFormatParser::parse(pattern)));
-    }
-    field_extractor_ = [this, pattern](const Envoy::RequestInfo::RequestInfo& request_info) {
-      const auto& formatters = start_time_formatters_.at(pattern);
-      ASSERT(formatters.size() == 1);
-      Http::HeaderMapImpl empty_map;
-      return formatters.at(0)->format(empty_map, empty_map, empty_map, request_info);
+    start_time_formatters_ =
+        AccessLog::AccessLogFormatParser::parse(fmt::format("%{}%", field_name));
+    ASSERT(start_time_formatters_.size() == 1);
+    // Captured by pointer rather than through this, so that the extractor stays valid when this
+    // formatter is moved.
+    const AccessLog::Formatter* formatter = start_time_formatters_[0].get();
+    field_extractor_ = [formatter](const Envoy::RequestInfo::RequestInfo& request_info) {
+      static const Http::HeaderMapImpl empty_map;
+      return formatter->format(empty_map, empty_map, empty_map, request_info);
     };
   } else if (field_name.find("UPSTREAM_METADATA") == 0) {
     field_extractor_ =
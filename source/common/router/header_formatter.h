@@ -3,6 +3,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/access_log/access_log.h"
 
@@ -43,49 +44,7 @@ public:
 private:
   std::function<std::string(const Envoy::RequestInfo::RequestInfo&)> field_extractor_;
   const bool append_;
-  std::unordered_map<std::string, std::vector<AccessLog::FormatterPtr>> start_time_formatters_;
-};
-
-/**
- * A formatter that returns back the same static header value.
- */
-class PlainHeaderFormatter : public HeaderFormatter {
-public:
-  PlainHeaderFormatter(const std::string& static_header_value, bool append)
-      : static_value_(static_header_value), append_(append) {}
-
-  // HeaderFormatter::format
-  const std::string format(const Envoy::RequestInfo::RequestInfo&) const override {
-    return static_value_;
-  };
-  bool append() const override { return append_; }
-
-private:
-  const std::string static_value_;
-  const bool append_;
-};
-
-/**
- * A formatter that produces a value by concatenating the results of multiple HeaderFormatters.
- */
-class CompoundHeaderFormatter : public HeaderFormatter {
-public:
-  CompoundHeaderFormatter(std::vector<HeaderFormatterPtr>&& formatters, bool append)
-      : formatters_(std::move(formatters)), append_(append) {}
-
-  // HeaderFormatter::format
-  const std::string format(const Envoy::RequestInfo::RequestInfo& request_info) const override {
-    std::string buf;
-    for (const auto& formatter : formatters_) {
-      buf += formatter->format(request_info);
-    }
-    return buf;
-  };
-  bool append() const override { return append_; }
-
-private:
-  const std::vector<HeaderFormatterPtr> formatters_;
-  const bool append_;
+  std::vector<AccessLog::FormatterPtr> start_time_formatters_;
 };
 
 } // namespace Router
@@ -4,6 +4,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #include "common/common/assert.h"
 #include "common/protobuf/utility.h"
@@ -32,19 +33,15 @@ std::string unescape(absl::string_view sv) { return absl::StrReplaceAll(sv, {{"%
 // Implements a state machine to parse custom headers. Each character of the custom header format
 // is either literal text (with % escaped as %%) or part of a %VAR% or %VAR(["args"])% expression.
 // The statement machine does minimal validation of the arguments (if any) and does not know the
-// names of valid variables. Interpretation of the variable name and arguments is delegated to
+// names of valid variables. The literal text and the variable expressions are passed, in order,
+// to the given callbacks. Interpretation of the variable name and arguments is delegated to
 // RequestInfoHeaderFormatter.
-HeaderFormatterPtr
-parseInternal(const envoy::api::v2::core::HeaderValueOption& header_value_option) {
-  const bool append = PROTOBUF_GET_WRAPPED_OR_DEFAULT(header_value_option, append, true);
-
-  absl::string_view format(header_value_option.header().value());
+void parseInternal(absl::string_view format, const std::function<void(std::string&&)>& add_literal,
+                   const std::function<void(absl::string_view)>& add_variable) {
   if (format.empty()) {
-    return std::make_unique<PlainHeaderFormatter>("", append);
+    return;
   }
 
-  std::vector<HeaderFormatterPtr> formatters;
-
   size_t pos = 0, start = 0;
   ParserState state = ParserState::Literal;
   do {
@@ -69,12 +66,10 @@ parseInternal(const envoy::api::v2::core::HeaderValueOption& header_value_option
         break;
       }
 
-      // Un-escaped %: start of variable name. Create a formatter for preceding characters, if
-      // any.
+      // Un-escaped %: start of variable name. Add the preceding characters, if any.
       state = ParserState::VariableName;
       if (pos > start) {
-        absl::string_view literal = format.substr(start, pos - start);
-        formatters.emplace_back(new PlainHeaderFormatter(unescape(literal), append));
+        add_literal(unescape(format.substr(start, pos - start)));
       }
       start = pos + 1;
       break;
@@ -82,9 +77,8 @@ parseInternal(const envoy::api::v2::core::HeaderValueOption& header_value_option
     case ParserState::VariableName:
       // Consume "VAR" from "%VAR%" or "%VAR(...)%"
       if (ch == '%') {
-        // Found complete variable name, add formatter.
-        formatters.emplace_back(
-            new RequestInfoHeaderFormatter(format.substr(start, pos - start), append));
+        // Found complete variable name.
+        add_variable(format.substr(start, pos - start));
         start = pos + 1;
         state = ParserState::Literal;
         break;
@@ -164,8 +158,7 @@ parseInternal(const envoy::api::v2::core::HeaderValueOption& header_value_option
     case ParserState::ExpectVariableEnd:
       // Search for closing % of a %VAR(...)% expression
       if (ch == '%') {
-        formatters.emplace_back(
-            new RequestInfoHeaderFormatter(format.substr(start, pos - start), append));
+        add_variable(format.substr(start, pos - start));
         start = pos + 1;
         state = ParserState::Literal;
         break;
@@ -192,17 +185,8 @@ parseInternal(const envoy::api::v2::core::HeaderValueOption& header_value_option
 
   if (pos > start) {
     // Trailing constant data.
-    absl::string_view literal = format.substr(start, pos - start);
-    formatters.emplace_back(new PlainHeaderFormatter(unescape(literal), append));
-  }
-
-  ASSERT(formatters.size() > 0);
-
-  if (formatters.size() == 1) {
-    return std::move(formatters[0]);
+    add_literal(unescape(format.substr(start, pos - start)));
   }
-
-  return std::make_unique<CompoundHeaderFormatter>(std::move(formatters), append);
 }
 
 } // namespace
@@ -210,12 +194,27 @@ parseInternal(const envoy::api::v2::core::HeaderValueOption& header_value_option
 HeaderParserPtr HeaderParser::configure(
     const Protobuf::RepeatedPtrField<envoy::api::v2::core::HeaderValueOption>& headers_to_add) {
   HeaderParserPtr header_parser(new HeaderParser());
+  std::unordered_map<std::string, size_t> variable_indexes;
 
   for (const auto& header_value_option : headers_to_add) {
-    HeaderFormatterPtr header_formatter = parseInternal(header_value_option);
-
     header_parser->headers_to_add_.emplace_back(
-        Http::LowerCaseString(header_value_option.header().key()), std::move(header_formatter));
+        header_value_option.header().key(),
+        PROTOBUF_GET_WRAPPED_OR_DEFAULT(header_value_option, append, true));
+    HeaderToAdd& header = header_parser->headers_to_add_.back();
+
+    parseInternal(
+        header_value_option.header().value(),
+        [&header](std::string&& literal) { header.segments_.push_back({std::move(literal), {}}); },
+        [&header, &header_parser, &variable_indexes](absl::string_view variable) {
+          const std::string name(variable);
+          auto it = variable_indexes.find(name);
+          if (it == variable_indexes.end()) {
+            header_parser->variables_.emplace_back(
+                new RequestInfoHeaderFormatter(variable, header.append_));
+            it = variable_indexes.emplace(name, header_parser->variables_.size() - 1).first;
+          }
+          header.segments_.push_back({"", it->second});
+        });
   }
 
   return header_parser;
@@ -235,13 +234,38 @@ HeaderParserPtr HeaderParser::configure(
 
 void HeaderParser::evaluateHeaders(Http::HeaderMap& headers,
                                    const RequestInfo::RequestInfo& request_info) const {
-  for (const auto& formatter : headers_to_add_) {
-    const std::string value = formatter.second->format(request_info);
+  // Each variable is evaluated once, however many headers use it.
+  std::vector<std::string> variable_values;
+  variable_values.reserve(variables_.size());
+  for (const HeaderFormatterPtr& variable : variables_) {
+    variable_values.emplace_back(variable->format(request_info));
+  }
+
+  for (const HeaderToAdd& header : headers_to_add_) {
+    if (header.isStatic()) {
+      // The value lives as long as the route configuration, like the key.
+      const std::string& value = header.segments_[0].literal_;
+      if (header.append_) {
+        headers.addReference(header.key_, value);
+      } else {
+        headers.setReference(header.key_, value);
+      }
+      continue;
+    }
+
+    // The value is built in place in the HeaderString that is moved into the map.
+    Http::HeaderString value;
+    for (const ValueSegment& segment : header.segments_) {
+      const std::string& text =
+          segment.variable_index_ ? variable_values[*segment.variable_index_] : segment.literal_;
+      value.append(text.data(), text.size());
+    }
+
     if (!value.empty()) {
-      if (formatter.second->append()) {
-        headers.addReferenceKey(formatter.first, value);
+      if (header.append_) {
+        headers.addReferenceKey(header.key_, std::move(value));
       } else {
-        headers.setReferenceKey(formatter.first, value);
+        headers.setReferenceKey(header.key_, std::move(value));
       }
     }
   }
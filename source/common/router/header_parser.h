@@ -10,6 +10,8 @@
 #include "common/protobuf/protobuf.h"
 #include "common/router/header_formatter.h"
 
+#include "absl/types/optional.h"
+
 namespace Envoy {
 namespace Router {
 
@@ -17,9 +19,10 @@ class HeaderParser;
 typedef std::unique_ptr<HeaderParser> HeaderParserPtr;
 
 /**
- * HeaderParser manipulates Http::HeaderMap instances. Headers to be added are pre-parsed to select
- * between a constant value implementation and a dynamic value implementation based on
- * RequestInfo::RequestInfo fields.
+ * HeaderParser manipulates Http::HeaderMap instances. Headers to be added are compiled, when the
+ * parser is configured, into literal text and variables based on RequestInfo::RequestInfo fields.
+ * Each variable is evaluated once per request however many headers use it, and headers without
+ * variables are added by reference.
  */
 class HeaderParser {
 public:
@@ -46,7 +49,26 @@ protected:
   HeaderParser() {}
 
 private:
-  std::vector<std::pair<Http::LowerCaseString, HeaderFormatterPtr>> headers_to_add_;
+  // A part of a header value: literal text, or the value of one of the parser's variables.
+  struct ValueSegment {
+    std::string literal_;
+    absl::optional<size_t> variable_index_;
+  };
+
+  struct HeaderToAdd {
+    HeaderToAdd(const std::string& key, bool append) : key_(key), append_(append) {}
+
+    // @return bool whether the value is literal text that can be added by reference.
+    bool isStatic() const { return segments_.size() == 1 && !segments_[0].variable_index_; }
+
+    const Http::LowerCaseString key_;
+    const bool append_;
+    std::vector<ValueSegment> segments_;
+  };
+
+  // The distinct variables used by the headers to add, indexed by ValueSegment::variable_index_.
+  std::vector<HeaderFormatterPtr> variables_;
+  std::vector<HeaderToAdd> headers_to_add_;
   std::vector<Http::LowerCaseString> headers_to_remove_;
 };
 
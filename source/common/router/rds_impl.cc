@@ -116,7 +116,10 @@ void RdsRouteConfigProviderImpl::onConfigUpdate(const ResourceVector& resources,
   }
   const uint64_t new_hash = MessageUtil::hash(route_config);
   if (!config_info_ || new_hash != config_info_.value().last_config_hash_) {
-    ConfigConstSharedPtr new_config(new ConfigImpl(route_config, factory_context_, false));
+    // route_config_proto_ still holds the configuration config_ was built from.
+    std::shared_ptr<const ConfigImpl> new_config = std::make_shared<const ConfigImpl>(
+        route_config, factory_context_, false, config_.get(), &route_config_proto_);
+    config_ = new_config;
     config_info_ = {new_hash, version_info};
     stats_.config_reload_.inc();
     ENVOY_LOG(debug, "rds: loading new configuration: config_name={} hash={}", route_config_name_,
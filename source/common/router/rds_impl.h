@@ -79,6 +79,7 @@ struct RdsStats {
   ALL_RDS_STATS(GENERATE_COUNTER_STRUCT)
 };
 
+class ConfigImpl;
 class RouteConfigProviderManagerImpl;
 
 /**
@@ -144,6 +145,8 @@ private:
   std::string config_source_;
   const std::string route_config_name_;
   absl::optional<LastConfigInfo> config_info_;
+  // The last configuration loaded, whose unchanged virtual hosts the next one shares.
+  std::shared_ptr<const ConfigImpl> config_;
   Stats::ScopePtr scope_;
   RdsStats stats_;
   std::function<void()> initialize_callback_;
@@ -0,0 +1,185 @@
+#include "common/router/route_path_index.h"
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Router {
+
+namespace {
+
+std::string toLower(absl::string_view str) {
+  std::string lower(str);
+  std::transform(lower.begin(), lower.end(), lower.begin(), tolower);
+  return lower;
+}
+
+template <class Map>
+void addToMap(Map& exact, std::deque<std::string>& paths, const std::string& path,
+              uint32_t index) {
+  auto routes = exact.find(path);
+  if (routes == exact.end()) {
+    // The keys are views, so they must refer to strings owned by the index.
+    paths.push_back(path);
+    routes = exact.emplace(paths.back(), std::vector<uint32_t>()).first;
+  }
+  routes->second.push_back(index);
+}
+
+} // namespace
+
+bool RoutePathIndex::Candidates::next(uint32_t& index) {
+  // Each route is in exactly one of the ranges, so taking the smallest head never repeats a route.
+  std::pair<const uint32_t*, const uint32_t*>* smallest = nullptr;
+  for (size_t i = 0; i < num_ranges_; i++) {
+    auto& range = ranges_[i];
+    if (range.first != range.second &&
+        (smallest == nullptr || *range.first < *smallest->first)) {
+      smallest = &range;
+    }
+  }
+
+  if (smallest == nullptr) {
+    return false;
+  }
+
+  index = *smallest->first++;
+  return true;
+}
+
+void RoutePathIndex::Candidates::add(const std::vector<uint32_t>* routes) {
+  if (routes != nullptr && !routes->empty()) {
+    ASSERT(num_ranges_ < ranges_.size());
+    ranges_[num_ranges_++] = {routes->data(), routes->data() + routes->size()};
+  }
+}
+
+void RoutePathIndex::addExact(const std::string& path, bool case_sensitive, uint32_t index) {
+  if (case_sensitive) {
+    addToMap(exact_, exact_paths_, path, index);
+  } else {
+    addToMap(exact_case_insensitive_, exact_paths_, path, index);
+  }
+}
+
+void RoutePathIndex::addPrefix(const std::string& prefix, bool case_sensitive, uint32_t index) {
+  if (case_sensitive) {
+    insert(prefixes_, prefix, index);
+  } else {
+    insert(prefixes_case_insensitive_, toLower(prefix), index);
+    has_case_insensitive_prefixes_ = true;
+  }
+}
+
+void RoutePathIndex::addUnindexed(uint32_t index) { addToSubtree(prefixes_, index); }
+
+RoutePathIndex::Candidates RoutePathIndex::candidates(absl::string_view path) const {
+  Candidates candidates;
+  // Exact paths are compared without the query string, prefixes with it.
+  const absl::string_view path_only = path.substr(0, path.find('?'));
+  candidates.add(find(exact_, path_only));
+  candidates.add(find(exact_case_insensitive_, path_only));
+  candidates.add(find(prefixes_, path, true));
+  if (has_case_insensitive_prefixes_) {
+    candidates.add(find(prefixes_case_insensitive_, path, false));
+  }
+  return candidates;
+}
+
+void RoutePathIndex::insert(Node& root, const std::string& prefix, uint32_t index) {
+  Node* node = &root;
+  size_t position = 0;
+  while (position < prefix.size()) {
+    auto child = node->children_.find(prefix[position]);
+    if (child == node->children_.end()) {
+      auto leaf = std::make_unique<Node>();
+      leaf->label_ = prefix.substr(position);
+      leaf->candidates_ = node->candidates_;
+      leaf->candidates_.push_back(index);
+      node->children_.emplace(prefix[position], std::move(leaf));
+      return;
+    }
+
+    const std::string& label = child->second->label_;
+    size_t common = 0;
+    while (common < label.size() && position + common < prefix.size() &&
+           label[common] == prefix[position + common]) {
+      common++;
+    }
+
+    if (common < label.size()) {
+      // The prefix diverges from or ends inside the edge label. Split the edge so that the shared
+      // part of the label leads to a new node, which has no routes of its own.
+      auto split = std::make_unique<Node>();
+      split->label_ = label.substr(0, common);
+      split->candidates_ = node->candidates_;
+      std::unique_ptr<Node> tail = std::move(child->second);
+      tail->label_ = tail->label_.substr(common);
+      const char tail_key = tail->label_[0];
+      split->children_.emplace(tail_key, std::move(tail));
+      child->second = std::move(split);
+    }
+
+    node = child->second.get();
+    position += common;
+  }
+
+  addToSubtree(*node, index);
+}
+
+void RoutePathIndex::addToSubtree(Node& node, uint32_t index) {
+  // Routes are added in increasing order, so appending keeps the candidates sorted.
+  node.candidates_.push_back(index);
+  for (auto& child : node.children_) {
+    addToSubtree(*child.second, index);
+  }
+}
+
+const std::vector<uint32_t>* RoutePathIndex::find(const Node& root, absl::string_view path,
+                                                  bool case_sensitive) {
+  const auto path_char = [&path, case_sensitive](size_t position) -> char {
+    return case_sensitive ? path[position] : tolower(path[position]);
+  };
+
+  const Node* node = &root;
+  size_t position = 0;
+  while (position < path.size()) {
+    const auto child = node->children_.find(path_char(position));
+    if (child == node->children_.end()) {
+      break;
+    }
+
+    const std::string& label = child->second->label_;
+    if (path.size() - position < label.size()) {
+      break;
+    }
+    size_t matched = 1;
+    while (matched < label.size() && path_char(position + matched) == label[matched]) {
+      matched++;
+    }
+    if (matched < label.size()) {
+      break;
+    }
+
+    node = child->second.get();
+    position += label.size();
+  }
+
+  return &node->candidates_;
+}
+
+template <class Map>
+const std::vector<uint32_t>* RoutePathIndex::find(const Map& exact, absl::string_view path) {
+  if (exact.empty()) {
+    return nullptr;
+  }
+
+  const auto routes = exact.find(path);
+  return routes != exact.end() ? &routes->second : nullptr;
+}
+
+} // namespace Router
+} // namespace Envoy
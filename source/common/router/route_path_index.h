@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/common/utility.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Index over the path match criteria of an ordered list of routes. Each route is identified by its
+ * position in the list. Exact paths are kept in a hash map and prefixes in a radix trie, so finding
+ * the routes whose path criterion can match a request costs time proportional to the path length
+ * rather than to the number of routes. Routes that cannot be indexed (e.g. regex routes) are
+ * always returned as candidates.
+ *
+ * The index only narrows down the routes to evaluate. Callers still evaluate each candidate in
+ * order, which also applies header, query parameter and runtime criteria, so the first matching
+ * route is the same one a linear scan of all routes would find.
+ */
+class RoutePathIndex {
+public:
+  /**
+   * The positions of the routes that may match a request. Every trie node keeps the sorted
+   * positions of its own routes, those of its ancestors and, for the case sensitive trie, the
+   * unindexed routes, so a lookup yields at most four sorted lists which are merged as the
+   * candidates are consumed, without allocating or sorting. Refers to the index that produced it
+   * and must not outlive it.
+   */
+  class Candidates {
+  public:
+    /**
+     * Get the next candidate.
+     * @param index supplies where to store the position of the next route that may match.
+     * @return bool true if a candidate was stored, false if there are no more candidates.
+     */
+    bool next(uint32_t& index);
+
+  private:
+    friend class RoutePathIndex;
+
+    void add(const std::vector<uint32_t>* routes);
+
+    std::array<std::pair<const uint32_t*, const uint32_t*>, 4> ranges_;
+    size_t num_ranges_{};
+  };
+
+  /**
+   * Add a route that matches a request whose path, without the query string, equals path.
+   * @param path supplies the path to match.
+   * @param case_sensitive supplies whether the path is compared case sensitively.
+   * @param index supplies the position of the route. Routes must be added in increasing order.
+   */
+  void addExact(const std::string& path, bool case_sensitive, uint32_t index);
+
+  /**
+   * Add a route that matches a request whose path, including the query string, starts with
+   * prefix.
+   * @param prefix supplies the prefix to match.
+   * @param case_sensitive supplies whether the prefix is compared case sensitively.
+   * @param index supplies the position of the route. Routes must be added in increasing order.
+   */
+  void addPrefix(const std::string& prefix, bool case_sensitive, uint32_t index);
+
+  /**
+   * Add a route that must be evaluated for every request.
+   * @param index supplies the position of the route. Routes must be added in increasing order.
+   */
+  void addUnindexed(uint32_t index);
+
+  /**
+   * Find the routes that may match a request.
+   * @param path supplies the request path, including any query string. It is only used during
+   *        the call.
+   * @return Candidates the positions of the routes that may match, in increasing order.
+   */
+  Candidates candidates(absl::string_view path) const;
+
+private:
+  /**
+   * Radix trie node. Each edge is labelled with a non-empty string, and the labels of the edges
+   * leaving a node start with distinct characters. Labels of the case insensitive trie are lower
+   * case.
+   */
+  struct Node {
+    std::string label_;
+    // Positions of the routes whose prefix ends at this node or at one of its ancestors, plus the
+    // unindexed routes in the case sensitive trie, in increasing order.
+    std::vector<uint32_t> candidates_;
+    std::map<char, std::unique_ptr<Node>> children_;
+  };
+
+  // The keys point into exact_paths_.
+  typedef std::unordered_map<absl::string_view, std::vector<uint32_t>, StringViewHash> ExactMap;
+  typedef std::unordered_map<absl::string_view, std::vector<uint32_t>,
+                             StringUtil::CaseInsensitiveHash, StringUtil::CaseInsensitiveCompare>
+      CaseInsensitiveExactMap;
+
+  static void insert(Node& root, const std::string& prefix, uint32_t index);
+  static void addToSubtree(Node& node, uint32_t index);
+  static const std::vector<uint32_t>* find(const Node& root, absl::string_view path,
+                                           bool case_sensitive);
+  template <class Map>
+  static const std::vector<uint32_t>* find(const Map& exact, absl::string_view path);
+
+  std::deque<std::string> exact_paths_;
+  ExactMap exact_;
+  CaseInsensitiveExactMap exact_case_insensitive_;
+  Node prefixes_;
+  Node prefixes_case_insensitive_;
+  bool has_case_insensitive_prefixes_{};
+};
+
+} // namespace Router
+} // namespace Envoy
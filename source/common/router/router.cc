@@ -585,6 +585,20 @@ void Filter::onUpstreamHeaders(const uint64_t response_code, Http::HeaderMapPtr&
 
   upstream_request_->upstream_host_->outlierDetector().putHttpResponseCode(response_code);
 
+  // Record the latency of the host for latency aware load balancing before deciding on a retry,
+  // so that responses that are retried count as well. It is timed from the end of this attempt's
+  // request, rather than of the downstream request, so that earlier attempts do not count.
+  const MonotonicTime response_received_time = std::chrono::steady_clock::now();
+  const RequestInfo::RequestInfoImpl& upstream_request_info = upstream_request_->request_info_;
+  if (cluster_->lbType() == Upstream::LoadBalancerType::PeakEwma &&
+      upstream_request_info.lastUpstreamTxByteSent()) {
+    upstream_request_->upstream_host_->latencyEstimator().putLatency(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            response_received_time - upstream_request_info.startTimeMonotonic() -
+            upstream_request_info.lastUpstreamTxByteSent().value()),
+        response_received_time);
+  }
+
   if (headers->EnvoyImmediateHealthCheckFail() != nullptr) {
     upstream_request_->upstream_host_->healthChecker().setUnhealthy();
   }
@@ -612,7 +626,6 @@ void Filter::onUpstreamHeaders(const uint64_t response_code, Http::HeaderMapPtr&
   // Only send upstream service time if we received the complete request and this is not a
   // premature response.
   if (DateUtil::timePointValid(downstream_request_complete_time_)) {
-    MonotonicTime response_received_time = std::chrono::steady_clock::now();
     std::chrono::milliseconds ms = std::chrono::duration_cast<std::chrono::milliseconds>(
         response_received_time - downstream_request_complete_time_);
     if (!config_.suppress_envoy_headers_) {
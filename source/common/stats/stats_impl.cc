@@ -10,6 +10,7 @@
 
 #include "common/common/lock_guard.h"
 #include "common/common/perf_annotation.h"
+#include "common/common/regex.h"
 #include "common/common/thread.h"
 #include "common/common/utility.h"
 #include "common/config/well_known_names.h"
@@ -44,6 +45,21 @@ uint64_t RawStatData::size() {
   return roundUpMultipleNaturalAlignment(sizeof(RawStatData) + nameSize());
 }
 
+uint64_t RawStatData::sizeGivenStatName(StatName stat_name) {
+  return roundUpMultipleNaturalAlignment(sizeof(RawStatData) + stat_name.size());
+}
+
+absl::string_view RawStatData::truncate(absl::string_view key) {
+  if (key.size() > maxNameLength()) {
+    ENVOY_LOG_MISC(
+        warn,
+        "Statistic '{}' is too long with {} characters, it will be truncated to {} characters", key,
+        key.size(), maxNameLength());
+    return key.substr(0, maxNameLength());
+  }
+  return key;
+}
+
 uint64_t& RawStatData::initializeAndGetMutableMaxObjNameLength(uint64_t configured_size) {
   // Like CONSTRUCT_ON_FIRST_USE, but non-const so that the value can be changed by tests
   static uint64_t size = configured_size;
@@ -75,7 +91,8 @@ std::string Utility::sanitizeStatsName(const std::string& name) {
 TagExtractorImpl::TagExtractorImpl(const std::string& name, const std::string& regex,
                                    const std::string& substr)
     : name_(name), prefix_(std::string(extractRegexPrefix(regex))), substr_(substr),
-      regex_(RegexUtil::parseRegex(regex)) {}
+      token_matcher_(TagTokenMatcher::compile(regex)),
+      regex_(token_matcher_ ? nullptr : Regex::Utility::parseRegex(regex)) {}
 
 std::string TagExtractorImpl::extractRegexPrefix(absl::string_view regex) {
   std::string prefix;
@@ -96,9 +113,9 @@ std::string TagExtractorImpl::extractRegexPrefix(absl::string_view regex) {
   return prefix;
 }
 
-TagExtractorPtr TagExtractorImpl::createTagExtractor(const std::string& name,
-                                                     const std::string& regex,
-                                                     const std::string& substr) {
+TagExtractorImplPtr TagExtractorImpl::createTagExtractor(const std::string& name,
+                                                         const std::string& regex,
+                                                         const std::string& substr) {
 
   if (name.empty()) {
     throw EnvoyException("tag_name cannot be empty");
@@ -108,7 +125,7 @@ TagExtractorPtr TagExtractorImpl::createTagExtractor(const std::string& name,
     throw EnvoyException(fmt::format(
         "No regex specified for tag specifier and no default regex for name: '{}'", name));
   }
-  return TagExtractorPtr{new TagExtractorImpl(name, regex, substr)};
+  return TagExtractorImplPtr{new TagExtractorImpl(name, regex, substr)};
 }
 
 bool TagExtractorImpl::substrMismatch(const std::string& stat_name) const {
@@ -117,6 +134,16 @@ bool TagExtractorImpl::substrMismatch(const std::string& stat_name) const {
 
 bool TagExtractorImpl::extractTag(const std::string& stat_name, std::vector<Tag>& tags,
                                   IntervalSet<size_t>& remove_characters) const {
+  return extractTag(stat_name,
+                    token_matcher_ ? TagTokenMatcher::tokenize(stat_name)
+                                   : std::vector<absl::string_view>(),
+                    tags, remove_characters);
+}
+
+bool TagExtractorImpl::extractTag(const std::string& stat_name,
+                                  const std::vector<absl::string_view>& tokens,
+                                  std::vector<Tag>& tags,
+                                  IntervalSet<size_t>& remove_characters) const {
   PERF_OPERATION(perf);
 
   if (substrMismatch(stat_name)) {
@@ -124,27 +151,31 @@ bool TagExtractorImpl::extractTag(const std::string& stat_name, std::vector<Tag>
     return false;
   }
 
-  std::smatch match;
+  if (token_matcher_) {
+    absl::string_view value;
+    absl::string_view remove;
+    if (token_matcher_->match(tokens, value, remove)) {
+      addTag(stat_name, value, remove, tags, remove_characters);
+      PERF_RECORD(perf, "token-match", name_);
+      return true;
+    }
+    PERF_RECORD(perf, "token-miss", name_);
+    return false;
+  }
+
+  std::vector<absl::string_view> match;
   // The regex must match and contain one or more subexpressions (all after the first are ignored).
-  if (std::regex_search(stat_name, match, regex_) && match.size() > 1) {
+  if (regex_->search(stat_name, match) && match.size() > 1) {
     // remove_subexpr is the first submatch. It represents the portion of the string to be removed.
-    const auto& remove_subexpr = match[1];
+    const absl::string_view remove_subexpr = match[1];
 
     // value_subexpr is the optional second submatch. It is usually inside the first submatch
     // (remove_subexpr) to allow the expression to strip off extra characters that should be removed
     // from the string but also not necessary in the tag value ("." for example). If there is no
     // second submatch, then the value_subexpr is the same as the remove_subexpr.
-    const auto& value_subexpr = match.size() > 2 ? match[2] : remove_subexpr;
-
-    tags.emplace_back();
-    Tag& tag = tags.back();
-    tag.name_ = name_;
-    tag.value_ = value_subexpr.str();
+    const absl::string_view value_subexpr = match.size() > 2 ? match[2] : remove_subexpr;
 
-    // Determines which characters to remove from stat_name to elide remove_subexpr.
-    std::string::size_type start = remove_subexpr.first - stat_name.begin();
-    std::string::size_type end = remove_subexpr.second - stat_name.begin();
-    remove_characters.insert(start, end);
+    addTag(stat_name, value_subexpr, remove_subexpr, tags, remove_characters);
     PERF_RECORD(perf, "re-match", name_);
     return true;
   }
@@ -152,23 +183,105 @@ bool TagExtractorImpl::extractTag(const std::string& stat_name, std::vector<Tag>
   return false;
 }
 
+void TagExtractorImpl::addTag(const std::string& stat_name, absl::string_view value,
+                              absl::string_view remove, std::vector<Tag>& tags,
+                              IntervalSet<size_t>& remove_characters) const {
+  tags.emplace_back();
+  Tag& tag = tags.back();
+  tag.name_ = name_;
+  tag.value_ = std::string(value);
+
+  // Determines which characters to remove from stat_name to elide remove. A submatch that did not
+  // participate in the match removes nothing.
+  const std::string::size_type start =
+      remove.data() == nullptr ? stat_name.size() : remove.data() - stat_name.data();
+  const std::string::size_type end = start + remove.size();
+  remove_characters.insert(start, end);
+}
+
+MetricImpl::MetricImpl(absl::string_view name, absl::string_view tag_extracted_name,
+                       const std::vector<Tag>& tags, SymbolTable& symbol_table)
+    : symbol_table_(symbol_table) {
+  std::vector<absl::string_view> names;
+  names.reserve(2 + 2 * tags.size());
+  names.push_back(name);
+  names.push_back(tag_extracted_name);
+  for (const Tag& tag : tags) {
+    names.push_back(tag.name_);
+    names.push_back(tag.value_);
+  }
+  stat_names_.populate(names, symbol_table_);
+}
+
+MetricImpl::~MetricImpl() { stat_names_.clear(symbol_table_); }
+
+StatName MetricImpl::statName() const {
+  StatName stat_name;
+  stat_names_.iterate([&stat_name](StatName name) -> bool {
+    stat_name = name;
+    return false;
+  });
+  return stat_name;
+}
+
+std::string MetricImpl::tagExtractedName() const {
+  StatName tag_extracted_name;
+  bool first = true;
+  stat_names_.iterate([&tag_extracted_name, &first](StatName name) -> bool {
+    if (first) {
+      first = false;
+      return true;
+    }
+    tag_extracted_name = name;
+    return false;
+  });
+  return symbol_table_.toString(tag_extracted_name);
+}
+
+std::vector<Tag> MetricImpl::tags() const {
+  std::vector<Tag> tags;
+  uint32_t index = 0;
+  stat_names_.iterate([this, &tags, &index](StatName name) -> bool {
+    // Skip the name and the tag extracted name, then alternate between tag names and values.
+    if (index >= 2) {
+      if (index % 2 == 0) {
+        tags.emplace_back();
+        tags.back().name_ = symbol_table_.toString(name);
+      } else {
+        tags.back().value_ = symbol_table_.toString(name);
+      }
+    }
+    ++index;
+    return true;
+  });
+  return tags;
+}
+
 RawStatData* HeapRawStatDataAllocator::alloc(const std::string& name) {
-  RawStatData* data = static_cast<RawStatData*>(::calloc(RawStatData::size(), 1));
-  data->initialize(name);
-
-  // Because the RawStatData object is initialized with and contains a truncated
-  // version of the std::string name, storing the stats in a map would require
-  // storing the name twice. Performing a lookup on the set is similarly
-  // expensive to performing a map lookup, since both require copying a truncated version of the
-  // string before doing the hash lookup.
+  // Names are truncated like those of blocks in shared memory, so that stats are shared the same
+  // way whichever allocator is used. The block holds the encoded name, which it keeps the
+  // references on the tokens of.
+  const std::vector<uint8_t> encoding = symbolTable().encode(RawStatData::truncate(name));
+  const StatName stat_name(encoding.data());
+  RawStatData* data =
+      static_cast<RawStatData*>(::calloc(RawStatData::sizeGivenStatName(stat_name), 1));
+  data->ref_count_ = 1;
+  stat_name.copyToStorage(reinterpret_cast<uint8_t*>(data->name_));
+
+  // The reference count of an existing entry is incremented under the lock, as stats may be
+  // allocated concurrently from multiple threads, and may race with free() dropping the last
+  // reference.
   Thread::ReleasableLockGuard lock(mutex_);
-  auto ret = stats_.insert(data);
-  RawStatData* existing_data = *ret.first;
+  auto ret = stats_.emplace(data->statName(), data);
+  RawStatData* existing_data = ret.first->second;
+  if (!ret.second) {
+    ++existing_data->ref_count_;
+  }
   lock.release();
 
   if (!ret.second) {
+    symbolTable().free(data->statName());
     ::free(data);
-    ++existing_data->ref_count_;
     return existing_data;
   } else {
     return data;
@@ -180,9 +293,9 @@ RawStatData* HeapRawStatDataAllocator::alloc(const std::string& name) {
  */
 class CounterImpl : public Counter, public MetricImpl {
 public:
-  CounterImpl(RawStatData& data, RawStatDataAllocator& alloc, std::string&& tag_extracted_name,
-              std::vector<Tag>&& tags)
-      : MetricImpl(data.name_, std::move(tag_extracted_name), std::move(tags)), data_(data),
+  CounterImpl(RawStatData& data, RawStatDataAllocator& alloc, const std::string& name,
+              const std::string& tag_extracted_name, const std::vector<Tag>& tags)
+      : MetricImpl(name, tag_extracted_name, tags, alloc.symbolTable()), data_(data),
         alloc_(alloc) {}
   ~CounterImpl() { alloc_.free(data_); }
 
@@ -209,9 +322,9 @@ private:
  */
 class GaugeImpl : public Gauge, public MetricImpl {
 public:
-  GaugeImpl(RawStatData& data, RawStatDataAllocator& alloc, std::string&& tag_extracted_name,
-            std::vector<Tag>&& tags)
-      : MetricImpl(data.name_, std::move(tag_extracted_name), std::move(tags)), data_(data),
+  GaugeImpl(RawStatData& data, RawStatDataAllocator& alloc, const std::string& name,
+            const std::string& tag_extracted_name, const std::vector<Tag>& tags)
+      : MetricImpl(name, tag_extracted_name, tags, alloc.symbolTable()), data_(data),
         alloc_(alloc) {}
   ~GaugeImpl() { alloc_.free(data_); }
 
@@ -282,7 +395,7 @@ int TagProducerImpl::addExtractorsMatching(absl::string_view name) {
   return num_found;
 }
 
-void TagProducerImpl::addExtractor(TagExtractorPtr extractor) {
+void TagProducerImpl::addExtractor(TagExtractorImplPtr extractor) {
   const absl::string_view prefix = extractor->prefixToken();
   if (prefix.empty()) {
     tag_extractors_without_prefix_.emplace_back(std::move(extractor));
@@ -292,18 +405,17 @@ void TagProducerImpl::addExtractor(TagExtractorPtr extractor) {
 }
 
 void TagProducerImpl::forEachExtractorMatching(
-    const std::string& stat_name, std::function<void(const TagExtractorPtr&)> f) const {
-  IntervalSetImpl<size_t> remove_characters;
-  for (const TagExtractorPtr& tag_extractor : tag_extractors_without_prefix_) {
-    f(tag_extractor);
+    const std::string& stat_name, std::function<void(const TagExtractorImpl&)> f) const {
+  for (const TagExtractorImplPtr& tag_extractor : tag_extractors_without_prefix_) {
+    f(*tag_extractor);
   }
   const std::string::size_type dot = stat_name.find('.');
   if (dot != std::string::npos) {
     const absl::string_view token = absl::string_view(stat_name.data(), dot);
     const auto iter = tag_extractor_prefix_map_.find(token);
     if (iter != tag_extractor_prefix_map_.end()) {
-      for (const TagExtractorPtr& tag_extractor : iter->second) {
-        f(tag_extractor);
+      for (const TagExtractorImplPtr& tag_extractor : iter->second) {
+        f(*tag_extractor);
       }
     }
   }
@@ -313,10 +425,13 @@ std::string TagProducerImpl::produceTags(const std::string& metric_name,
                                          std::vector<Tag>& tags) const {
   tags.insert(tags.end(), default_tags_.begin(), default_tags_.end());
   IntervalSetImpl<size_t> remove_characters;
-  forEachExtractorMatching(
-      metric_name, [&remove_characters, &tags, &metric_name](const TagExtractorPtr& tag_extractor) {
-        tag_extractor->extractTag(metric_name, tags, remove_characters);
-      });
+  // The name is split into tokens once, and shared by all the extractors whose regex was compiled
+  // into a TagTokenMatcher.
+  const std::vector<absl::string_view> tokens = TagTokenMatcher::tokenize(metric_name);
+  forEachExtractorMatching(metric_name, [&remove_characters, &tags, &metric_name,
+                                         &tokens](const TagExtractorImpl& tag_extractor) {
+    tag_extractor.extractTag(metric_name, tokens, tags, remove_characters);
+  });
   return StringUtil::removeCharacters(metric_name, remove_characters);
 }
 
@@ -338,35 +453,30 @@ TagProducerImpl::addDefaultExtractors(const envoy::config::metrics::v2::StatsCon
 }
 
 void HeapRawStatDataAllocator::free(RawStatData& data) {
-  ASSERT(data.ref_count_ > 0);
-  if (--data.ref_count_ > 0) {
-    return;
-  }
-
   size_t key_removed;
   {
+    // See the comment in alloc() about holding the lock while updating the reference count.
     Thread::LockGuard lock(mutex_);
-    key_removed = stats_.erase(&data);
+    ASSERT(data.ref_count_ > 0);
+    if (--data.ref_count_ > 0) {
+      return;
+    }
+    key_removed = stats_.erase(data.statName());
   }
 
   ASSERT(key_removed == 1);
+  symbolTable().free(data.statName());
   ::free(&data);
 }
 
 void RawStatData::initialize(absl::string_view key) {
   ASSERT(!initialized());
-  if (key.size() > Stats::RawStatData::maxNameLength()) {
-    ENVOY_LOG_MISC(
-        warn,
-        "Statistic '{}' is too long with {} characters, it will be truncated to {} characters", key,
-        key.size(), Stats::RawStatData::maxNameLength());
-  }
+  key = truncate(key);
   ref_count_ = 1;
 
   // key is not necessarily nul-terminated, but we want to make sure name_ is.
-  uint64_t xfer_size = std::min(nameSize() - 1, key.size());
-  memcpy(name_, key.data(), xfer_size);
-  name_[xfer_size] = '\0';
+  memcpy(name_, key.data(), key.size());
+  name_[key.size()] = '\0';
 }
 
 HistogramStatisticsImpl::HistogramStatisticsImpl(const histogram_t* histogram_ptr)
@@ -427,6 +537,12 @@ void SourceImpl::clearCache() {
   histograms_.reset();
 }
 
+RawStatDataAllocator::RawStatDataAllocator()
+    : owned_symbol_table_(std::make_unique<SymbolTable>()), symbol_table_(*owned_symbol_table_) {}
+
+RawStatDataAllocator::RawStatDataAllocator(SymbolTable& symbol_table)
+    : symbol_table_(symbol_table) {}
+
 CounterSharedPtr RawStatDataAllocator::makeCounter(const std::string& name,
                                                    std::string&& tag_extracted_name,
                                                    std::vector<Tag>&& tags) {
@@ -434,8 +550,7 @@ CounterSharedPtr RawStatDataAllocator::makeCounter(const std::string& name,
   if (data == nullptr) {
     return nullptr;
   }
-  return std::make_shared<CounterImpl>(*data, *this, std::move(tag_extracted_name),
-                                       std::move(tags));
+  return std::make_shared<CounterImpl>(*data, *this, name, tag_extracted_name, tags);
 }
 
 GaugeSharedPtr RawStatDataAllocator::makeGauge(const std::string& name,
@@ -445,7 +560,7 @@ GaugeSharedPtr RawStatDataAllocator::makeGauge(const std::string& name,
   if (data == nullptr) {
     return nullptr;
   }
-  return std::make_shared<GaugeImpl>(*data, *this, std::move(tag_extracted_name), std::move(tags));
+  return std::make_shared<GaugeImpl>(*data, *this, name, tag_extracted_name, tags);
 }
 
 } // namespace Stats
@@ -7,10 +7,10 @@
 #include <functional>
 #include <list>
 #include <memory>
-#include <regex>
 #include <string>
 #include <unordered_map>
 
+#include "envoy/common/regex.h"
 #include "envoy/common/time.h"
 #include "envoy/config/metrics/v2/stats.pb.h"
 #include "envoy/server/options.h"
@@ -23,6 +23,8 @@
 #include "common/common/thread_annotations.h"
 #include "common/common/utility.h"
 #include "common/protobuf/protobuf.h"
+#include "common/stats/symbol_table_impl.h"
+#include "common/stats/tag_token_matcher.h"
 
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
@@ -32,6 +34,14 @@
 namespace Envoy {
 namespace Stats {
 
+class TagExtractorImpl;
+typedef std::unique_ptr<const TagExtractorImpl> TagExtractorImplPtr;
+
+/**
+ * Extracts a tag from stat names with a regex. Regexes written like the default tag regexes are
+ * compiled into a TagTokenMatcher, which matches the tokens of the name without running the regex
+ * engine. Other regexes are run with the regex engine.
+ */
 class TagExtractorImpl : public TagExtractor {
 public:
   /**
@@ -41,10 +51,10 @@ public:
    * @param substr a substring that -- if provided -- must be present in a stat name
    *               in order to match the regex. This is an optional performance tweak
    *               to avoid large numbers of failed regex lookups.
-   * @return TagExtractorPtr newly constructed TagExtractor.
+   * @return TagExtractorImplPtr newly constructed TagExtractor.
    */
-  static TagExtractorPtr createTagExtractor(const std::string& name, const std::string& regex,
-                                            const std::string& substr = "");
+  static TagExtractorImplPtr createTagExtractor(const std::string& name, const std::string& regex,
+                                                const std::string& substr = "");
 
   TagExtractorImpl(const std::string& name, const std::string& regex,
                    const std::string& substr = "");
@@ -53,6 +63,20 @@ public:
                   IntervalSet<size_t>& remove_characters) const override;
   absl::string_view prefixToken() const override { return prefix_; }
 
+  /**
+   * Like extractTag() above, for a stat name that has already been split into tokens, so that the
+   * name is only split once for all the extractors.
+   * @param stat_name the stat name.
+   * @param tokens the tokens of stat_name, as returned by TagTokenMatcher::tokenize().
+   */
+  bool extractTag(const std::string& stat_name, const std::vector<absl::string_view>& tokens,
+                  std::vector<Tag>& tags, IntervalSet<size_t>& remove_characters) const;
+
+  /**
+   * @return bool whether the regex was compiled into a TagTokenMatcher.
+   */
+  bool compiled() const { return token_matcher_ != nullptr; }
+
   /**
    * @param stat_name The stat name
    * @return bool indicates whether tag extraction should be skipped for this stat_name due
@@ -69,10 +93,22 @@ private:
    */
   static std::string extractRegexPrefix(absl::string_view regex);
 
+  /**
+   * Adds a tag and the characters to remove for a match.
+   * @param stat_name the stat name.
+   * @param value the tag value, which refers into stat_name.
+   * @param remove the characters to remove, which refer into stat_name, or have a null data() if
+   *        nothing is removed.
+   */
+  void addTag(const std::string& stat_name, absl::string_view value, absl::string_view remove,
+              std::vector<Tag>& tags, IntervalSet<size_t>& remove_characters) const;
+
   const std::string name_;
   const std::string prefix_;
   const std::string substr_;
-  const std::regex regex_;
+  // Exactly one of these is set.
+  const TagTokenMatcherPtr token_matcher_;
+  const Regex::CompiledMatcherPtr regex_;
 };
 
 /**
@@ -100,7 +136,7 @@ private:
    * produceTags run efficiently by trying only extractors that have a chance to match.
    * @param extractor TagExtractorPtr the extractor to add.
    */
-  void addExtractor(TagExtractorPtr extractor);
+  void addExtractor(TagExtractorImplPtr extractor);
 
   /**
    * Adds all default extractors matching the specified tag name. In this model,
@@ -140,17 +176,17 @@ private:
    * See DefaultTagRegexTester::produceTagsReverse in test/common/stats/stats_impl_test.cc.
    *
    * @param stat_name const std::string& the stat name.
-   * @param f std::function<void(const TagExtractorPtr&)> function to call for each extractor.
+   * @param f std::function<void(const TagExtractorImpl&)> function to call for each extractor.
    */
   void forEachExtractorMatching(const std::string& stat_name,
-                                std::function<void(const TagExtractorPtr&)> f) const;
+                                std::function<void(const TagExtractorImpl&)> f) const;
 
-  std::vector<TagExtractorPtr> tag_extractors_without_prefix_;
+  std::vector<TagExtractorImplPtr> tag_extractors_without_prefix_;
 
   // Maps a prefix word extracted out of a regex to a vector of TagExtractors. Note that
   // the storage for the prefix string is owned by the TagExtractor, which, depending on
   // implementation, may need make a copy of the prefix.
-  std::unordered_map<absl::string_view, std::vector<TagExtractorPtr>, StringViewHash>
+  std::unordered_map<absl::string_view, std::vector<TagExtractorImplPtr>, StringViewHash>
       tag_extractor_prefix_map_;
   std::vector<Tag> default_tags_;
 };
@@ -169,6 +205,10 @@ public:
  * This structure is the backing memory for both CounterImpl and GaugeImpl. It is designed so that
  * it can be allocated from shared memory if needed.
  *
+ * Blocks in shared memory hold the name as a nul-terminated string, so that another process can
+ * find them. Blocks allocated by HeapRawStatDataAllocator hold the name encoded as a StatName
+ * instead, which shares its tokens with all other stats.
+ *
  * @note Due to name_ being variable size, sizeof(RawStatData) probably isn't useful. Use
  * RawStatData::size() instead.
  */
@@ -224,6 +264,19 @@ struct RawStatData {
    */
   static uint64_t size();
 
+  /**
+   * Returns the size of this struct with room for just the given encoded name. This is enough for
+   * blocks that are not stored in an array, such as those allocated from the heap.
+   */
+  static uint64_t sizeGivenStatName(StatName stat_name);
+
+  /**
+   * Truncates a name to maxNameLength(), logging a warning if it was longer.
+   * @param key the name.
+   * @return absl::string_view the prefix of key that fits in a block.
+   */
+  static absl::string_view truncate(absl::string_view key);
+
   /**
    * Initializes this object to have the specified key,
    * a refcount of 1, and all other values zero. This is required by
@@ -242,12 +295,18 @@ struct RawStatData {
   bool initialized() { return name_[0] != '\0'; }
 
   /**
-   * Returns the name as a string_view. This is required by BlockMemoryHashSet.
+   * Returns the name as a string_view. This is required by BlockMemoryHashSet. Only valid for
+   * blocks that hold the name as a string.
    */
   absl::string_view key() const {
     return absl::string_view(name_, strnlen(name_, maxNameLength()));
   }
 
+  /**
+   * Returns the encoded name. Only valid for blocks that hold the name as a StatName.
+   */
+  StatName statName() const { return StatName(reinterpret_cast<const uint8_t*>(name_)); }
+
   std::atomic<uint64_t> value_;
   std::atomic<uint64_t> pending_increment_;
   std::atomic<uint16_t> flags_;
@@ -281,15 +340,20 @@ private:
 /**
  * Implementation of the Metric interface. Virtual inheritance is used because the interfaces that
  * will inherit from Metric will have other base classes that will also inherit from Metric.
+ *
+ * The name, tag extracted name and tags are encoded with a SymbolTable, which shares the storage of
+ * the tokens they have in common with other stats, and are decoded on each access.
  */
 class MetricImpl : public virtual Metric {
 public:
-  MetricImpl(const std::string& name, std::string&& tag_extracted_name, std::vector<Tag>&& tags)
-      : name_(name), tag_extracted_name_(std::move(tag_extracted_name)), tags_(std::move(tags)) {}
+  MetricImpl(absl::string_view name, absl::string_view tag_extracted_name,
+             const std::vector<Tag>& tags, SymbolTable& symbol_table);
+  ~MetricImpl();
 
-  const std::string& name() const override { return name_; }
-  const std::string& tagExtractedName() const override { return tag_extracted_name_; }
-  const std::vector<Tag>& tags() const override { return tags_; }
+  std::string name() const override { return symbol_table_.toString(statName()); }
+  std::string tagExtractedName() const override;
+  std::vector<Tag> tags() const override;
+  StatName statName() const override;
 
 protected:
   /**
@@ -300,9 +364,9 @@ protected:
   };
 
 private:
-  const std::string name_;
-  const std::string tag_extracted_name_;
-  const std::vector<Tag> tags_;
+  // The name, the tag extracted name, then the name and value of each tag.
+  StatNameList stat_names_;
+  SymbolTable& symbol_table_;
 };
 
 /**
@@ -311,6 +375,18 @@ private:
  */
 class RawStatDataAllocator : public StatDataAllocator {
 public:
+  /**
+   * Creates an allocator with a symbol table of its own.
+   */
+  RawStatDataAllocator();
+
+  /**
+   * Creates an allocator that encodes names with the given symbol table, e.g. to make stats with
+   * the same table as another allocator.
+   * @param symbol_table the table, which must outlive the allocator.
+   */
+  explicit RawStatDataAllocator(SymbolTable& symbol_table);
+
   // StatDataAllocator
   CounterSharedPtr makeCounter(const std::string& name, std::string&& tag_extracted_name,
                                std::vector<Tag>&& tags) override;
@@ -332,6 +408,13 @@ public:
    * @param data the data returned by alloc().
    */
   virtual void free(RawStatData& data) PURE;
+
+  // StatDataAllocator
+  SymbolTable& symbolTable() override { return symbol_table_; }
+
+private:
+  std::unique_ptr<SymbolTable> owned_symbol_table_;
+  SymbolTable& symbol_table_;
 };
 
 /**
@@ -363,9 +446,9 @@ private:
  */
 class HistogramImpl : public Histogram, public MetricImpl {
 public:
-  HistogramImpl(const std::string& name, Store& parent, std::string&& tag_extracted_name,
-                std::vector<Tag>&& tags)
-      : MetricImpl(name, std::move(tag_extracted_name), std::move(tags)), parent_(parent) {}
+  HistogramImpl(const std::string& name, Store& parent, const std::string& tag_extracted_name,
+                const std::vector<Tag>& tags, SymbolTable& symbol_table)
+      : MetricImpl(name, tag_extracted_name, tags, symbol_table), parent_(parent) {}
 
   // Stats::Histogram
   void recordValue(uint64_t value) override { parent_.deliverHistogramToSinks(*this, value); }
@@ -400,25 +483,18 @@ private:
  */
 class HeapRawStatDataAllocator : public RawStatDataAllocator {
 public:
-  // RawStatDataAllocator
+  HeapRawStatDataAllocator() {}
+  explicit HeapRawStatDataAllocator(SymbolTable& symbol_table)
+      : RawStatDataAllocator(symbol_table) {}
   ~HeapRawStatDataAllocator() { ASSERT(stats_.empty()); }
+
+  // RawStatDataAllocator
   RawStatData* alloc(const std::string& name) override;
   void free(RawStatData& data) override;
 
 private:
-  struct RawStatDataHash_ {
-    size_t operator()(const RawStatData* a) const { return HashUtil::xxHash64(a->key()); }
-  };
-  struct RawStatDataCompare_ {
-    bool operator()(const RawStatData* a, const RawStatData* b) const {
-      return (a->key() == b->key());
-    }
-  };
-  typedef std::unordered_set<RawStatData*, RawStatDataHash_, RawStatDataCompare_> StringRawDataSet;
-
-  // An unordered set of RawStatData pointers which keys off the key()
-  // field in each object. This necessitates a custom comparator and hasher.
-  StringRawDataSet stats_ GUARDED_BY(mutex_);
+  // The blocks, keyed by the encoded name they hold, so that the name is not stored twice.
+  StatNameHashMap<RawStatData*> stats_ GUARDED_BY(mutex_);
   // A mutex is needed here to protect the stats_ object from both alloc() and free() operations.
   // Although alloc() operations are called under existing locking, free() operations are made from
   // the destructors of the individual stat objects, which are not protected by locks.
@@ -477,8 +553,8 @@ public:
           return alloc_.makeGauge(name, std::move(tag_extracted_name), std::move(tags));
         }),
         histograms_([this](const std::string& name) -> HistogramSharedPtr {
-          return std::make_shared<HistogramImpl>(name, *this, std::string(name),
-                                                 std::vector<Tag>());
+          return std::make_shared<HistogramImpl>(name, *this, name, std::vector<Tag>(),
+                                                 alloc_.symbolTable());
         }) {}
 
   // Stats::Scope
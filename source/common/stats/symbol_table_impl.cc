@@ -0,0 +1,267 @@
+#include "common/stats/symbol_table_impl.h"
+
+#include <string.h>
+
+#include <limits>
+
+#include "absl/strings/str_split.h"
+
+namespace Envoy {
+namespace Stats {
+
+namespace {
+
+// Symbols are encoded 7 bits per byte, least significant bits first. The high bit of a byte is set
+// if more bytes of the same symbol follow.
+const uint8_t SpilloverMask = 0x80;
+const uint8_t Low7Bits = 0x7f;
+
+void appendSymbol(uint32_t symbol, std::vector<uint8_t>& bytes) {
+  do {
+    if (symbol < SpilloverMask) {
+      bytes.push_back(static_cast<uint8_t>(symbol));
+    } else {
+      bytes.push_back(static_cast<uint8_t>((symbol & Low7Bits) | SpilloverMask));
+    }
+    symbol >>= 7;
+  } while (symbol != 0);
+}
+
+void setLengthPrefix(uint64_t length, uint8_t* storage) {
+  RELEASE_ASSERT(length <= std::numeric_limits<uint16_t>::max());
+  storage[0] = static_cast<uint8_t>(length & 0xff);
+  storage[1] = static_cast<uint8_t>(length >> 8);
+}
+
+} // namespace
+
+void StatName::copyToStorage(uint8_t* storage) const {
+  setLengthPrefix(dataSize(), storage);
+  if (dataSize() > 0) {
+    memcpy(storage + LengthPrefixSize, data(), dataSize());
+  }
+}
+
+bool StatName::operator==(const StatName& rhs) const {
+  const uint64_t size = dataSize();
+  return size == rhs.dataSize() && (size == 0 || memcmp(data(), rhs.data(), size) == 0);
+}
+
+SymbolTable::SymbolTable() {}
+
+SymbolTable::~SymbolTable() {
+  // Every encoded name must be freed before the table goes away, otherwise the names would refer
+  // to tokens that no longer exist.
+  ASSERT(numSymbols() == 0);
+}
+
+void SymbolTable::countContention() const {
+  Counter* lock_contention = lock_contention_;
+  if (lock_contention != nullptr) {
+    lock_contention->inc();
+  }
+}
+
+SymbolTable::ExclusiveLock::ExclusiveLock(const SymbolTable& table) : lock_(table.lock_) {
+  if (!lock_.TryLock()) {
+    table.countContention();
+    lock_.Lock();
+  }
+}
+
+SymbolTable::ExclusiveLock::~ExclusiveLock() { lock_.Unlock(); }
+
+SymbolTable::SharedLock::SharedLock(const SymbolTable& table) : lock_(table.lock_) {
+  if (!lock_.ReaderTryLock()) {
+    table.countContention();
+    lock_.ReaderLock();
+  }
+}
+
+SymbolTable::SharedLock::~SharedLock() { lock_.ReaderUnlock(); }
+
+std::vector<uint8_t> SymbolTable::encode(absl::string_view name) {
+  std::vector<uint8_t> bytes(StatName::LengthPrefixSize);
+  if (!name.empty()) {
+    ExclusiveLock lock(*this);
+    for (absl::string_view token : absl::StrSplit(name, '.')) {
+      appendSymbol(toSymbol(token), bytes);
+    }
+  }
+  setLengthPrefix(bytes.size() - StatName::LengthPrefixSize, bytes.data());
+  return bytes;
+}
+
+bool SymbolTable::tryEncodeInterned(absl::string_view name, std::vector<uint8_t>& bytes) const {
+  bytes.assign(StatName::LengthPrefixSize, 0);
+  if (!name.empty()) {
+    SharedLock lock(*this);
+    for (absl::string_view token : absl::StrSplit(name, '.')) {
+      auto encode_find = encode_map_.find(token);
+      if (encode_find == encode_map_.end()) {
+        return false;
+      }
+      appendSymbol(encode_find->second.symbol_, bytes);
+    }
+  }
+  setLengthPrefix(bytes.size() - StatName::LengthPrefixSize, bytes.data());
+  return true;
+}
+
+SymbolTable::Symbol SymbolTable::toSymbol(absl::string_view token) {
+  auto encode_find = encode_map_.find(token);
+  if (encode_find != encode_map_.end()) {
+    ++encode_find->second.ref_count_;
+    return encode_find->second.symbol_;
+  }
+
+  Symbol symbol;
+  if (pool_.empty()) {
+    symbol = decode_map_.size();
+    decode_map_.push_back(nullptr);
+  } else {
+    symbol = pool_.top();
+    pool_.pop();
+  }
+  decode_map_[symbol] = std::make_unique<std::string>(token);
+  encode_map_.emplace(*decode_map_[symbol], SharedSymbol{symbol, 1});
+  return symbol;
+}
+
+SymbolTable::SharedSymbol& SymbolTable::sharedSymbol(Symbol symbol) {
+  ASSERT(symbol < decode_map_.size() && decode_map_[symbol] != nullptr);
+  auto encode_find = encode_map_.find(*decode_map_[symbol]);
+  ASSERT(encode_find != encode_map_.end());
+  return encode_find->second;
+}
+
+std::vector<SymbolTable::Symbol> SymbolTable::decodeSymbols(StatName stat_name) {
+  std::vector<Symbol> symbols;
+  const uint8_t* data = stat_name.data();
+  const uint8_t* end = data + stat_name.dataSize();
+  Symbol symbol = 0;
+  uint32_t shift = 0;
+  for (; data < end; ++data) {
+    symbol |= static_cast<Symbol>(*data & Low7Bits) << shift;
+    if ((*data & SpilloverMask) == 0) {
+      symbols.push_back(symbol);
+      symbol = 0;
+      shift = 0;
+    } else {
+      shift += 7;
+    }
+  }
+  ASSERT(shift == 0);
+  return symbols;
+}
+
+std::string SymbolTable::toString(StatName stat_name) const {
+  const std::vector<Symbol> symbols = decodeSymbols(stat_name);
+  std::string name;
+  SharedLock lock(*this);
+  for (size_t i = 0; i < symbols.size(); ++i) {
+    if (i > 0) {
+      name.push_back('.');
+    }
+    ASSERT(symbols[i] < decode_map_.size() && decode_map_[symbols[i]] != nullptr);
+    name.append(*decode_map_[symbols[i]]);
+  }
+  return name;
+}
+
+void SymbolTable::free(StatName stat_name) {
+  const std::vector<Symbol> symbols = decodeSymbols(stat_name);
+  ExclusiveLock lock(*this);
+  for (const Symbol symbol : symbols) {
+    SharedSymbol& shared_symbol = sharedSymbol(symbol);
+    ASSERT(shared_symbol.ref_count_ > 0);
+    if (--shared_symbol.ref_count_ == 0) {
+      encode_map_.erase(*decode_map_[symbol]);
+      decode_map_[symbol].reset();
+      pool_.push(symbol);
+    }
+  }
+}
+
+void SymbolTable::incRefCount(StatName stat_name) {
+  const std::vector<Symbol> symbols = decodeSymbols(stat_name);
+  ExclusiveLock lock(*this);
+  for (const Symbol symbol : symbols) {
+    ++sharedSymbol(symbol).ref_count_;
+  }
+}
+
+uint64_t SymbolTable::numSymbols() const {
+  SharedLock lock(*this);
+  ASSERT(encode_map_.size() + pool_.size() == decode_map_.size());
+  return encode_map_.size();
+}
+
+StatNameStorage::StatNameStorage(absl::string_view name, SymbolTable& table) {
+  const std::vector<uint8_t> bytes = table.encode(name);
+  bytes_ = std::make_unique<uint8_t[]>(bytes.size());
+  memcpy(bytes_.get(), bytes.data(), bytes.size());
+}
+
+StatNameStorage::StatNameStorage(StatName src, SymbolTable& table) {
+  bytes_ = std::make_unique<uint8_t[]>(src.size());
+  src.copyToStorage(bytes_.get());
+  table.incRefCount(src);
+}
+
+StatNameStorage::~StatNameStorage() {
+  // free() must be called before the storage is destroyed, so that the symbols are released.
+  ASSERT(bytes_ == nullptr);
+}
+
+void StatNameStorage::free(SymbolTable& table) {
+  table.free(statName());
+  bytes_.reset();
+}
+
+StatNameList::~StatNameList() { ASSERT(!populated()); }
+
+void StatNameList::populate(const std::vector<absl::string_view>& names, SymbolTable& table) {
+  RELEASE_ASSERT(names.size() <= std::numeric_limits<uint8_t>::max());
+  ASSERT(!populated());
+
+  std::vector<std::vector<uint8_t>> encodings;
+  encodings.reserve(names.size());
+  uint64_t total_size = 1;
+  for (absl::string_view name : names) {
+    encodings.push_back(table.encode(name));
+    total_size += encodings.back().size();
+  }
+
+  storage_ = std::make_unique<uint8_t[]>(total_size);
+  uint8_t* p = storage_.get();
+  *p++ = static_cast<uint8_t>(names.size());
+  for (const std::vector<uint8_t>& encoding : encodings) {
+    memcpy(p, encoding.data(), encoding.size());
+    p += encoding.size();
+  }
+  ASSERT(p == storage_.get() + total_size);
+}
+
+void StatNameList::iterate(const std::function<bool(StatName)>& f) const {
+  const uint8_t* p = storage_.get();
+  const uint8_t num_names = *p++;
+  for (uint8_t i = 0; i < num_names; ++i) {
+    const StatName stat_name(p);
+    p += stat_name.size();
+    if (!f(stat_name)) {
+      break;
+    }
+  }
+}
+
+void StatNameList::clear(SymbolTable& table) {
+  iterate([&table](StatName stat_name) -> bool {
+    table.free(stat_name);
+    return true;
+  });
+  storage_.reset();
+}
+
+} // namespace Stats
+} // namespace Envoy
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stack>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "envoy/stats/stats.h"
+
+#include "common/common/assert.h"
+#include "common/common/hash.h"
+#include "common/common/non_copyable.h"
+#include "common/common/thread_annotations.h"
+#include "common/common/utility.h"
+
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * Runtime representation of an encoded stat name. A StatName does not own its storage; see
+ * StatNameStorage and StatNameList. The storage starts with a two byte length, followed by the
+ * symbols of the '.' separated tokens of the name, each encoded as a variable length integer.
+ */
+class StatName {
+public:
+  StatName() {}
+  explicit StatName(const uint8_t* size_and_data) : size_and_data_(size_and_data) {}
+
+  /**
+   * @return uint64_t the number of bytes in the symbol array, excluding the length prefix.
+   */
+  uint64_t dataSize() const {
+    if (size_and_data_ == nullptr) {
+      return 0;
+    }
+    return size_and_data_[0] | (static_cast<uint64_t>(size_and_data_[1]) << 8);
+  }
+
+  /**
+   * @return uint64_t the number of bytes in the symbol array, including the length prefix.
+   */
+  uint64_t size() const { return dataSize() + LengthPrefixSize; }
+
+  /**
+   * @return const uint8_t* the symbol array, excluding the length prefix.
+   */
+  const uint8_t* data() const {
+    return size_and_data_ == nullptr ? nullptr : size_and_data_ + LengthPrefixSize;
+  }
+
+  /**
+   * Copies the encoded name, including the length prefix, to storage, which must have room for
+   * size() bytes.
+   */
+  void copyToStorage(uint8_t* storage) const;
+
+  uint64_t hash() const {
+    return HashUtil::xxHash64(
+        absl::string_view(reinterpret_cast<const char*>(data()), dataSize()));
+  }
+  bool operator==(const StatName& rhs) const;
+  bool operator!=(const StatName& rhs) const { return !(*this == rhs); }
+
+  static const uint64_t LengthPrefixSize = 2;
+
+private:
+  const uint8_t* size_and_data_{};
+};
+
+struct StatNameHash {
+  size_t operator()(const StatName& name) const { return name.hash(); }
+};
+
+template <class T> using StatNameHashMap = std::unordered_map<StatName, T, StatNameHash>;
+typedef std::unordered_set<StatName, StatNameHash> StatNameHashSet;
+
+/**
+ * Interns the '.' separated tokens of stat names, so that each distinct token is stored once no
+ * matter how many stats it appears in. Tokens are reference counted, and a token is released when
+ * the last name referencing it is freed. This is useful for deployments with a large number of
+ * clusters, as every cluster has dozens of stats whose names repeat the same prefixes and suffixes.
+ *
+ * Encoding and freeing names take the table's lock exclusively, and decoding takes it shared, so
+ * names should be encoded when stats are created, and decoded only when they are exported, e.g. to
+ * sinks or the admin endpoint. Looking up a stat by name should use tryEncodeInterned(), which
+ * also only takes the lock shared.
+ */
+class SymbolTable : NonCopyable {
+public:
+  SymbolTable();
+  ~SymbolTable();
+
+  /**
+   * Encodes a stat name, taking a reference on each of its tokens.
+   * @param name the name to encode.
+   * @return std::vector<uint8_t> the encoded name, including the length prefix.
+   */
+  std::vector<uint8_t> encode(absl::string_view name);
+
+  /**
+   * Encodes a stat name without taking references on its tokens, so that it can be used to look up
+   * a name encoded with encode(). The result is only meaningful while the tokens are known to stay
+   * interned, e.g. while holding the lock of a map keyed by encoded names that the result is
+   * looked up in: if the map holds an equal name, it holds references on the same tokens.
+   * @param name the name to encode.
+   * @param bytes receives the encoded name, including the length prefix.
+   * @return bool false if a token of the name is not interned, in which case no encoded name can be
+   *         equal to it.
+   */
+  bool tryEncodeInterned(absl::string_view name, std::vector<uint8_t>& bytes) const;
+
+  /**
+   * @param stat_name the encoded name.
+   * @return std::string the decoded name.
+   */
+  std::string toString(StatName stat_name) const;
+
+  /**
+   * Releases the references taken on the tokens of a name when it was encoded.
+   * @param stat_name the encoded name.
+   */
+  void free(StatName stat_name);
+
+  /**
+   * Takes another reference on each of the tokens of a name, e.g. when a copy of the encoded name
+   * is made.
+   * @param stat_name the encoded name.
+   */
+  void incRefCount(StatName stat_name);
+
+  /**
+   * @return uint64_t the number of distinct tokens currently interned.
+   */
+  uint64_t numSymbols() const;
+
+  /**
+   * Sets a counter incremented each time a thread has to wait for the table's lock.
+   * @param counter the counter, or nullptr to stop counting. The counter must stay valid until it
+   *        is unset.
+   */
+  void setLockContentionCounter(Counter* counter) { lock_contention_ = counter; }
+
+private:
+  typedef uint32_t Symbol;
+
+  struct SharedSymbol {
+    Symbol symbol_;
+    uint32_t ref_count_;
+  };
+
+  /**
+   * Holds the table's lock exclusively for its lifetime, counting the acquisitions that had to
+   * wait.
+   */
+  class SCOPED_LOCKABLE ExclusiveLock {
+  public:
+    ExclusiveLock(const SymbolTable& table) EXCLUSIVE_LOCK_FUNCTION(table.lock_);
+    ~ExclusiveLock() UNLOCK_FUNCTION();
+
+  private:
+    absl::Mutex& lock_;
+  };
+
+  /**
+   * Holds the table's lock shared for its lifetime, counting the acquisitions that had to wait.
+   */
+  class SCOPED_LOCKABLE SharedLock {
+  public:
+    SharedLock(const SymbolTable& table) SHARED_LOCK_FUNCTION(table.lock_);
+    ~SharedLock() UNLOCK_FUNCTION();
+
+  private:
+    absl::Mutex& lock_;
+  };
+
+  Symbol toSymbol(absl::string_view token) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  SharedSymbol& sharedSymbol(Symbol symbol) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  static std::vector<Symbol> decodeSymbols(StatName stat_name);
+  void countContention() const;
+
+  // Reader/writer lock guarding the maps below.
+  mutable absl::Mutex lock_;
+  std::atomic<Counter*> lock_contention_{};
+
+  // Maps each interned token to its symbol. The keys refer to the strings owned by decode_map_, so
+  // tokens can be looked up without copying them.
+  std::unordered_map<absl::string_view, SharedSymbol, StringViewHash>
+      encode_map_ GUARDED_BY(lock_);
+
+  // The tokens, indexed by symbol. Entries for released symbols are null until the symbol is
+  // reused.
+  std::vector<std::unique_ptr<std::string>> decode_map_ GUARDED_BY(lock_);
+
+  // Symbols released by free(), which are handed out again before new ones are allocated.
+  std::stack<Symbol> pool_ GUARDED_BY(lock_);
+};
+
+/**
+ * Owns the storage of an encoded stat name. As the storage does not keep a reference to the
+ * symbol table, free() must be called before the object is destroyed.
+ */
+class StatNameStorage {
+public:
+  StatNameStorage(absl::string_view name, SymbolTable& table);
+
+  /**
+   * Makes a copy of an encoded name, taking another reference on each of its tokens.
+   */
+  StatNameStorage(StatName src, SymbolTable& table);
+
+  StatNameStorage(StatNameStorage&& src) = default;
+  ~StatNameStorage();
+
+  /**
+   * Releases the tokens of the name and the storage.
+   * @param table the symbol table the name was encoded with.
+   */
+  void free(SymbolTable& table);
+
+  StatName statName() const { return StatName(bytes_.get()); }
+
+private:
+  std::unique_ptr<uint8_t[]> bytes_;
+};
+
+/**
+ * Owns the storage of a short list of encoded stat names in a single allocation. Like
+ * StatNameStorage, clear() must be called before the object is destroyed.
+ */
+class StatNameList {
+public:
+  ~StatNameList();
+
+  /**
+   * Encodes the names and stores them in the list.
+   * @param names the names to encode, at most 255.
+   * @param table the symbol table to encode the names with.
+   */
+  void populate(const std::vector<absl::string_view>& names, SymbolTable& table);
+
+  /**
+   * @return bool true if populate() has been called and clear() has not.
+   */
+  bool populated() const { return storage_ != nullptr; }
+
+  /**
+   * Calls f for each name in the list, in order, until f returns false.
+   */
+  void iterate(const std::function<bool(StatName)>& f) const;
+
+  /**
+   * Releases the tokens of the names and the storage.
+   * @param table the symbol table the names were encoded with.
+   */
+  void clear(SymbolTable& table);
+
+private:
+  // The first byte is the number of names, followed by each encoded name with its length prefix.
+  std::unique_ptr<uint8_t[]> storage_;
+};
+
+} // namespace Stats
+} // namespace Envoy
@@ -0,0 +1,204 @@
+#include "common/stats/tag_token_matcher.h"
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
+
+namespace Envoy {
+namespace Stats {
+
+namespace {
+
+// Whether a token can be matched by '.*?'. Like the regex engine, '.' does not match a newline.
+bool matchesAnyChars(absl::string_view token) {
+  return token.find('\n') == absl::string_view::npos;
+}
+
+bool isWordChars(absl::string_view token) {
+  if (token.empty()) {
+    return false;
+  }
+  for (const char c : token) {
+    if (!absl::ascii_isalnum(c) && c != '_') {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Consumes a literal token, or a non-capturing group of alternative literal tokens, from the
+// start of regex. Returns the literals, or an empty vector if regex does not start with either.
+std::vector<std::string> consumeLiterals(absl::string_view& regex) {
+  std::vector<std::string> literals;
+  absl::string_view remaining = regex;
+  const bool group = absl::ConsumePrefix(&remaining, "(?:");
+  do {
+    size_t length = 0;
+    while (length < remaining.size() &&
+           (absl::ascii_isalnum(remaining[length]) || remaining[length] == '_')) {
+      ++length;
+    }
+    if (length == 0) {
+      return {};
+    }
+    literals.emplace_back(remaining.substr(0, length));
+    remaining.remove_prefix(length);
+  } while (group && absl::ConsumePrefix(&remaining, "|"));
+
+  if (group && !absl::ConsumePrefix(&remaining, ")")) {
+    return {};
+  }
+  regex = remaining;
+  return literals;
+}
+
+} // namespace
+
+std::vector<absl::string_view> TagTokenMatcher::tokenize(absl::string_view name) {
+  return absl::StrSplit(name, '.');
+}
+
+TagTokenMatcherPtr TagTokenMatcher::compile(absl::string_view regex) {
+  if (!absl::ConsumePrefix(&regex, "^")) {
+    return nullptr;
+  }
+
+  std::unique_ptr<TagTokenMatcher> matcher(new TagTokenMatcher());
+  uint32_t num_values = 0;
+  // Each iteration starts at the beginning of a token.
+  while (!regex.empty()) {
+    if (absl::ConsumePrefix(&regex, "(?:.*?\\.)??")) {
+      matcher->elements_.push_back({Op::Skip, {}});
+      continue;
+    }
+    if (absl::ConsumePrefix(&regex, "((.*?)\\.)")) {
+      matcher->elements_.push_back({Op::Value, {}});
+      ++num_values;
+      continue;
+    }
+    if (regex == "\\w+?$" || regex == "\\w+$") {
+      matcher->elements_.push_back({Op::WordEnd, {}});
+      break;
+    }
+
+    std::vector<std::string> literals = consumeLiterals(regex);
+    if (literals.empty()) {
+      return nullptr;
+    }
+    if (absl::ConsumePrefix(&regex, "\\.")) {
+      matcher->elements_.push_back({Op::Literal, std::move(literals)});
+    } else if (regex == "$") {
+      matcher->elements_.push_back({Op::LiteralEnd, std::move(literals)});
+      break;
+    } else if (regex == "(\\.(.*?))$") {
+      matcher->elements_.push_back({Op::LiteralThenValue, std::move(literals)});
+      matcher->remove_preceding_dot_ = true;
+      ++num_values;
+      break;
+    } else {
+      return nullptr;
+    }
+  }
+
+  if (num_values != 1) {
+    return nullptr;
+  }
+  return std::move(matcher);
+}
+
+bool TagTokenMatcher::match(const std::vector<absl::string_view>& tokens, absl::string_view& value,
+                            absl::string_view& remove) const {
+  ValueTokens value_tokens{0, 0};
+  if (!matchFrom(0, 0, tokens, value_tokens)) {
+    return false;
+  }
+
+  // The tokens refer into the same name, so the value spans from the start of its first token to
+  // the end of its last one.
+  const char* begin = tokens[value_tokens.begin_].data();
+  const absl::string_view last = tokens[value_tokens.end_ - 1];
+  value = absl::string_view(begin, last.data() + last.size() - begin);
+  if (remove_preceding_dot_) {
+    remove = absl::string_view(value.data() - 1, value.size() + 1);
+  } else {
+    remove = absl::string_view(value.data(), value.size() + 1);
+  }
+  return true;
+}
+
+bool TagTokenMatcher::matchesLiteral(const Element& element, absl::string_view token) const {
+  for (const std::string& literal : element.literals_) {
+    if (token == literal) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TagTokenMatcher::matchFrom(size_t element, size_t token,
+                                const std::vector<absl::string_view>& tokens,
+                                ValueTokens& value) const {
+  // A regex that ends after a '.' accepts any remainder. There is always a token at this point, as
+  // every element except the terminal ones is followed by a '.'.
+  if (element == elements_.size()) {
+    return true;
+  }
+
+  const Element& current = elements_[element];
+  const size_t num_tokens = tokens.size();
+  switch (current.op_) {
+  case Op::Literal:
+    return token + 1 < num_tokens && matchesLiteral(current, tokens[token]) &&
+           matchFrom(element + 1, token + 1, tokens, value);
+
+  case Op::LiteralEnd:
+    return token + 1 == num_tokens && matchesLiteral(current, tokens[token]);
+
+  case Op::LiteralThenValue:
+    if (token + 1 == num_tokens || !matchesLiteral(current, tokens[token])) {
+      return false;
+    }
+    for (size_t i = token + 1; i < num_tokens; ++i) {
+      if (!matchesAnyChars(tokens[i])) {
+        return false;
+      }
+    }
+    value = {token + 1, num_tokens};
+    return true;
+
+  case Op::Skip:
+    // Prefer skipping fewer tokens, like the lazy quantifiers of the regex.
+    for (size_t end = token; end < num_tokens; ++end) {
+      if (end > token && !matchesAnyChars(tokens[end - 1])) {
+        return false;
+      }
+      if (matchFrom(element + 1, end, tokens, value)) {
+        return true;
+      }
+    }
+    return false;
+
+  case Op::Value:
+    // Prefer shorter values, like the lazy quantifiers of the regex. The value must be followed by
+    // another token.
+    for (size_t end = token + 1; end < num_tokens; ++end) {
+      if (!matchesAnyChars(tokens[end - 1])) {
+        return false;
+      }
+      value = {token, end};
+      if (matchFrom(element + 1, end, tokens, value)) {
+        return true;
+      }
+    }
+    return false;
+
+  case Op::WordEnd:
+    return token + 1 == num_tokens && isWordChars(tokens[token]);
+  }
+
+  return false;
+}
+
+} // namespace Stats
+} // namespace Envoy
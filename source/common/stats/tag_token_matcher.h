@@ -0,0 +1,96 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Stats {
+
+class TagTokenMatcher;
+typedef std::unique_ptr<const TagTokenMatcher> TagTokenMatcherPtr;
+
+/**
+ * Matches a tag extraction regex against the '.' separated tokens of a stat name, without running
+ * a regex engine. Only regexes built from the constructs the default tag regexes are written with
+ * can be compiled:
+ *   ^               the regex must be anchored at the start of the name.
+ *   foo\.           a literal token. (?:foo|bar)\. matches any of several literal tokens, and foo$
+ *                   matches a literal last token.
+ *   (?:.*?\.)??     any number of tokens, preferring fewer.
+ *   ((.*?)\.)       the tag value: one or more tokens, preferring fewer. The value is removed from
+ *                   the name along with the '.' that follows it.
+ *   foo(\.(.*?))$   a literal token followed by the tag value, which is the rest of the name. The
+ *                   value is removed from the name along with the '.' that precedes it.
+ *   \w+?$ or \w+$   a last token made of one or more word characters.
+ * A regex that ends after a '.' accepts any remainder of the name. The tag value and the characters
+ * removed are the same as for the leftmost-first match of the regex.
+ */
+class TagTokenMatcher {
+public:
+  /**
+   * @param name a stat name.
+   * @return std::vector<absl::string_view> the '.' separated tokens of the name, including empty
+   *         ones. There is always at least one token.
+   */
+  static std::vector<absl::string_view> tokenize(absl::string_view name);
+
+  /**
+   * @param regex a tag extraction regex.
+   * @return TagTokenMatcherPtr the compiled matcher, or nullptr if the regex uses constructs that
+   *         cannot be compiled, or does not have exactly one tag value.
+   */
+  static TagTokenMatcherPtr compile(absl::string_view regex);
+
+  /**
+   * @param tokens the tokens of a stat name, as returned by tokenize().
+   * @param value filled with the tag value if the name matches. Refers into the name.
+   * @param remove filled with the characters to remove from the name if it matches. Refers into
+   *        the name.
+   * @return bool true if the name matches.
+   */
+  bool match(const std::vector<absl::string_view>& tokens, absl::string_view& value,
+             absl::string_view& remove) const;
+
+private:
+  enum class Op {
+    // Matches a literal token followed by another token.
+    Literal,
+    // Matches a literal last token.
+    LiteralEnd,
+    // Matches a literal token, followed by the tag value made of the remaining tokens.
+    LiteralThenValue,
+    // Skips any number of tokens.
+    Skip,
+    // Matches the tag value, made of one or more tokens followed by another token.
+    Value,
+    // Matches a last token made of word characters.
+    WordEnd,
+  };
+
+  struct Element {
+    Op op_;
+    std::vector<std::string> literals_;
+  };
+
+  // The tokens of the tag value, in [begin, end).
+  struct ValueTokens {
+    size_t begin_;
+    size_t end_;
+  };
+
+  TagTokenMatcher() {}
+
+  bool matchFrom(size_t element, size_t token, const std::vector<absl::string_view>& tokens,
+                 ValueTokens& value) const;
+  bool matchesLiteral(const Element& element, absl::string_view token) const;
+
+  std::vector<Element> elements_;
+  // Whether the '.' that precedes the value is removed, rather than the one that follows it.
+  bool remove_preceding_dot_{};
+};
+
+} // namespace Stats
+} // namespace Envoy
@@ -13,12 +13,20 @@ namespace Envoy {
 namespace Stats {
 
 ThreadLocalStoreImpl::ThreadLocalStoreImpl(StatDataAllocator& alloc)
-    : alloc_(alloc), default_scope_(createScope("")),
+    : alloc_(alloc), symbol_table_(alloc.symbolTable()), default_scope_(createScope("")),
       tag_producer_(std::make_unique<TagProducerImpl>()),
-      num_last_resort_stats_(default_scope_->counter("stats.overflow")), source_(*this) {}
+      num_last_resort_stats_(default_scope_->counter("stats.overflow")),
+      central_cache_lock_contention_(
+          default_scope_->counter("stats.central_cache_lock_contention")),
+      symbol_table_lock_contention_(default_scope_->counter("stats.symbol_table_lock_contention")),
+      heap_allocator_(symbol_table_), source_(*this) {
+  symbol_table_.setLockContentionCounter(&symbol_table_lock_contention_);
+}
 
 ThreadLocalStoreImpl::~ThreadLocalStoreImpl() {
   ASSERT(shutting_down_);
+  // The counter goes away with the default scope, while names are still being freed.
+  symbol_table_.setLockContentionCounter(nullptr);
   default_scope_.reset();
   ASSERT(scopes_.empty());
 }
@@ -26,9 +34,10 @@ ThreadLocalStoreImpl::~ThreadLocalStoreImpl() {
 std::vector<CounterSharedPtr> ThreadLocalStoreImpl::counters() const {
   // Handle de-dup due to overlapping scopes.
   std::vector<CounterSharedPtr> ret;
-  std::unordered_set<std::string> names;
+  StatNameHashSet names;
   Thread::LockGuard lock(lock_);
   for (ScopeImpl* scope : scopes_) {
+    Thread::LockGuard scope_lock(scope->central_cache_lock_);
     for (auto& counter : scope->central_cache_.counters_) {
       if (names.insert(counter.first).second) {
         ret.push_back(counter.second);
@@ -49,9 +58,10 @@ ScopePtr ThreadLocalStoreImpl::createScope(const std::string& name) {
 std::vector<GaugeSharedPtr> ThreadLocalStoreImpl::gauges() const {
   // Handle de-dup due to overlapping scopes.
   std::vector<GaugeSharedPtr> ret;
-  std::unordered_set<std::string> names;
+  StatNameHashSet names;
   Thread::LockGuard lock(lock_);
   for (ScopeImpl* scope : scopes_) {
+    Thread::LockGuard scope_lock(scope->central_cache_lock_);
     for (auto& gauge : scope->central_cache_.gauges_) {
       if (names.insert(gauge.first).second) {
         ret.push_back(gauge.second);
@@ -65,7 +75,6 @@ std::vector<GaugeSharedPtr> ThreadLocalStoreImpl::gauges() const {
 std::vector<ParentHistogramSharedPtr> ThreadLocalStoreImpl::histograms() const {
   // Handle de-dup due to overlapping scopes.
   std::vector<ParentHistogramSharedPtr> ret;
-  std::unordered_set<std::string> names;
   Thread::LockGuard lock(lock_);
   // TODO(ramaraochavali): As histograms don't share storage, there is a chance of duplicate names
   // here. We need to create global storage for histograms similar to how we have a central storage
@@ -73,9 +82,9 @@ std::vector<ParentHistogramSharedPtr> ThreadLocalStoreImpl::histograms() const {
   // in histograms with duplicate names, but until shared storage is implementing it's ultimately
   // less confusing for users who have such configs.
   for (ScopeImpl* scope : scopes_) {
+    Thread::LockGuard scope_lock(scope->central_cache_lock_);
     for (const auto& name_histogram_pair : scope->central_cache_.histograms_) {
-      const ParentHistogramSharedPtr& parent_hist = name_histogram_pair.second;
-      ret.push_back(parent_hist);
+      ret.push_back(name_histogram_pair.second);
     }
   }
 
@@ -159,22 +168,35 @@ std::atomic<uint64_t> ThreadLocalStoreImpl::ScopeImpl::next_scope_id_;
 
 ThreadLocalStoreImpl::ScopeImpl::~ScopeImpl() { parent_.releaseScopeCrossThread(this); }
 
+ThreadLocalStoreImpl::CentralCacheLockGuard::CentralCacheLockGuard(const ScopeImpl& scope)
+    : lock_(scope.central_cache_lock_) {
+  if (!lock_.tryLock()) {
+    scope.parent_.central_cache_lock_contention_.inc();
+    lock_.lock();
+  }
+}
+
+ThreadLocalStoreImpl::CentralCacheLockGuard::~CentralCacheLockGuard() { lock_.unlock(); }
+
 template <class StatType>
-StatType& ThreadLocalStoreImpl::ScopeImpl::safeMakeStat(
-    const std::string& name,
-    std::unordered_map<std::string, std::shared_ptr<StatType>>& central_cache_map,
-    MakeStatFn<StatType> make_stat, std::shared_ptr<StatType>* tls_ref) {
+StatType& ThreadLocalStoreImpl::ScopeImpl::safeMakeStat(const std::string& name,
+                                                        StatMap<StatType>& central_cache_map,
+                                                        MakeStatFn<StatType> make_stat,
+                                                        StatMap<StatType>* tls_cache_map) {
 
   // If we have a valid cache entry, return it.
-  if (tls_ref && *tls_ref) {
-    return **tls_ref;
+  if (tls_cache_map != nullptr) {
+    std::shared_ptr<StatType> tls_ref = findTls(name, *tls_cache_map);
+    if (tls_ref != nullptr) {
+      return *tls_ref;
+    }
   }
 
-  // We must now look in the central store so we must be locked. We grab a reference to the
-  // central store location. It might contain nothing. In this case, we allocate a new stat.
-  Thread::LockGuard lock(parent_.lock_);
-  std::shared_ptr<StatType>& central_ref = central_cache_map[name];
-  if (!central_ref) {
+  // We must now look in the central store, which is keyed by the encoded name. Only if there is no
+  // entry are the tags extracted and the stat allocated, which encodes its name, all without
+  // holding the lock of the central cache, so that the lock is only held for the lookups.
+  std::shared_ptr<StatType> central_ref = findCentral(name, central_cache_map);
+  if (central_ref == nullptr) {
     std::vector<Tag> tags;
     std::string tag_extracted_name = parent_.getTagsForName(name, tags);
     std::shared_ptr<StatType> stat =
@@ -185,29 +207,76 @@ StatType& ThreadLocalStoreImpl::ScopeImpl::safeMakeStat(
           make_stat(parent_.heap_allocator_, name, std::move(tag_extracted_name), std::move(tags));
       ASSERT(stat != nullptr);
     }
-    central_ref = stat;
+    central_ref = insertCentral(std::move(stat), central_cache_map);
   }
 
   // If we have a TLS location to store or allocation into, do it.
-  if (tls_ref) {
-    *tls_ref = central_ref;
+  if (tls_cache_map != nullptr) {
+    tls_cache_map->emplace(central_ref->statName(), central_ref);
   }
 
   // Finally we return the reference.
   return *central_ref;
 }
 
+template <class StatType>
+std::shared_ptr<StatType>
+ThreadLocalStoreImpl::ScopeImpl::findTls(const std::string& name,
+                                         const StatMap<StatType>& tls_cache_map) const {
+  if (tls_cache_map.empty()) {
+    return nullptr;
+  }
+  // Every name in the cache holds references on its tokens, so none of its symbols can be
+  // reassigned between encoding the name and the lookup, and no other thread adds to the cache.
+  std::vector<uint8_t> bytes;
+  if (!parent_.symbol_table_.tryEncodeInterned(name, bytes)) {
+    return nullptr;
+  }
+  auto tls_entry = tls_cache_map.find(StatName(bytes.data()));
+  if (tls_entry == tls_cache_map.end()) {
+    return nullptr;
+  }
+  return tls_entry->second;
+}
+
+template <class StatType>
+std::shared_ptr<StatType>
+ThreadLocalStoreImpl::ScopeImpl::findCentral(const std::string& name,
+                                             StatMap<StatType>& central_cache_map) {
+  CentralCacheLockGuard lock(*this);
+  // The name is encoded while holding the lock, so that an entry with an equal encoding holds
+  // references on the same tokens the encoding was made from.
+  std::vector<uint8_t> bytes;
+  if (!parent_.symbol_table_.tryEncodeInterned(name, bytes)) {
+    return nullptr;
+  }
+  auto central_entry = central_cache_map.find(StatName(bytes.data()));
+  if (central_entry == central_cache_map.end()) {
+    return nullptr;
+  }
+  return central_entry->second;
+}
+
+template <class StatType>
+std::shared_ptr<StatType>
+ThreadLocalStoreImpl::ScopeImpl::insertCentral(std::shared_ptr<StatType> stat,
+                                               StatMap<StatType>& central_cache_map) {
+  CentralCacheLockGuard lock(*this);
+  auto central_entry = central_cache_map.emplace(stat->statName(), stat);
+  // If another thread made the same stat while the lock was not held, its stat is kept, and ours
+  // is released when it goes out of scope.
+  return central_entry.first->second;
+}
+
 Counter& ThreadLocalStoreImpl::ScopeImpl::counter(const std::string& name) {
   // Determine the final name based on the prefix and the passed name.
   std::string final_name = prefix_ + name;
 
-  // We now try to acquire a *reference* to the TLS cache shared pointer. This might remain null
-  // if we don't have TLS initialized currently. The de-referenced pointer might be null if there
-  // is no cache entry.
-  CounterSharedPtr* tls_ref = nullptr;
+  // We now try to acquire the TLS cache of the scope. This might remain null if we don't have TLS
+  // initialized currently.
+  StatMap<Counter>* tls_cache_map = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref =
-        &parent_.tls_->getTyped<TlsCache>().scope_cache_[this->scope_id_].counters_[final_name];
+    tls_cache_map = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this->scope_id_].counters_;
   }
 
   return safeMakeStat<Counter>(
@@ -216,7 +285,7 @@ Counter& ThreadLocalStoreImpl::ScopeImpl::counter(const std::string& name) {
          std::vector<Tag>&& tags) -> CounterSharedPtr {
         return allocator.makeCounter(name, std::move(tag_extracted_name), std::move(tags));
       },
-      tls_ref);
+      tls_cache_map);
 }
 
 void ThreadLocalStoreImpl::ScopeImpl::deliverHistogramToSinks(const Histogram& histogram,
@@ -239,9 +308,9 @@ Gauge& ThreadLocalStoreImpl::ScopeImpl::gauge(const std::string& name) {
   // See comments in counter(). There is no super clean way (via templates or otherwise) to
   // share this code so I'm leaving it largely duplicated for now.
   std::string final_name = prefix_ + name;
-  GaugeSharedPtr* tls_ref = nullptr;
+  StatMap<Gauge>* tls_cache_map = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this->scope_id_].gauges_[final_name];
+    tls_cache_map = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this->scope_id_].gauges_;
   }
 
   return safeMakeStat<Gauge>(
@@ -250,59 +319,60 @@ Gauge& ThreadLocalStoreImpl::ScopeImpl::gauge(const std::string& name) {
          std::vector<Tag>&& tags) -> GaugeSharedPtr {
         return allocator.makeGauge(name, std::move(tag_extracted_name), std::move(tags));
       },
-      tls_ref);
+      tls_cache_map);
 }
 
 Histogram& ThreadLocalStoreImpl::ScopeImpl::histogram(const std::string& name) {
   // See comments in counter(). There is no super clean way (via templates or otherwise) to
   // share this code so I'm leaving it largely duplicated for now.
   std::string final_name = prefix_ + name;
-  ParentHistogramSharedPtr* tls_ref = nullptr;
-
+  StatMap<ParentHistogramImpl>* tls_cache_map = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>()
-                   .scope_cache_[this->scope_id_]
-                   .parent_histograms_[final_name];
+    tls_cache_map =
+        &parent_.tls_->getTyped<TlsCache>().scope_cache_[this->scope_id_].parent_histograms_;
   }
 
-  if (tls_ref && *tls_ref) {
-    return **tls_ref;
+  if (tls_cache_map != nullptr) {
+    ParentHistogramImplSharedPtr tls_ref = findTls(final_name, *tls_cache_map);
+    if (tls_ref != nullptr) {
+      return *tls_ref;
+    }
   }
 
-  Thread::LockGuard lock(parent_.lock_);
-  ParentHistogramImplSharedPtr& central_ref = central_cache_.histograms_[final_name];
-  if (!central_ref) {
+  ParentHistogramImplSharedPtr central_ref = findCentral(final_name, central_cache_.histograms_);
+  if (central_ref == nullptr) {
     std::vector<Tag> tags;
     std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
-    central_ref.reset(new ParentHistogramImpl(final_name, parent_, *this,
-                                              std::move(tag_extracted_name), std::move(tags)));
+    ParentHistogramImplSharedPtr stat = std::make_shared<ParentHistogramImpl>(
+        final_name, parent_, *this, tag_extracted_name, tags, parent_.symbol_table_);
+    central_ref = insertCentral(std::move(stat), central_cache_.histograms_);
   }
 
-  if (tls_ref) {
-    *tls_ref = central_ref;
+  if (tls_cache_map != nullptr) {
+    tls_cache_map->emplace(central_ref->statName(), central_ref);
   }
   return *central_ref;
 }
 
-Histogram& ThreadLocalStoreImpl::ScopeImpl::tlsHistogram(const std::string& name,
-                                                         ParentHistogramImpl& parent) {
+Histogram& ThreadLocalStoreImpl::ScopeImpl::tlsHistogram(ParentHistogramImpl& parent) {
   // See comments in counter() which explains the logic here.
 
-  // Here prefix will not be considered because, by the time ParentHistogram calls this method
-  // during recordValue, the prefix is already attached to the name.
+  // The TLS histograms are keyed by the encoded name of the parent, which already has the prefix
+  // attached, so that recording a value does not require decoding or encoding a name.
   TlsHistogramSharedPtr* tls_ref = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this->scope_id_].histograms_[name];
+    tls_ref = &parent_.tls_->getTyped<TlsCache>()
+                   .scope_cache_[this->scope_id_]
+                   .histograms_[parent.statName()];
   }
 
   if (tls_ref && *tls_ref) {
     return **tls_ref;
   }
 
-  std::vector<Tag> tags;
-  std::string tag_extracted_name = parent_.getTagsForName(name, tags);
+  // The tags were already extracted for the parent, so they are reused.
   TlsHistogramSharedPtr hist_tls_ptr = std::make_shared<ThreadLocalHistogramImpl>(
-      name, std::move(tag_extracted_name), std::move(tags));
+      parent.name(), parent.tagExtractedName(), parent.tags(), parent_.symbol_table_);
 
   parent.addTlsHistogram(hist_tls_ptr);
 
@@ -313,10 +383,11 @@ Histogram& ThreadLocalStoreImpl::ScopeImpl::tlsHistogram(const std::string& name
 }
 
 ThreadLocalHistogramImpl::ThreadLocalHistogramImpl(const std::string& name,
-                                                   std::string&& tag_extracted_name,
-                                                   std::vector<Tag>&& tags)
-    : MetricImpl(name, std::move(tag_extracted_name), std::move(tags)), current_active_(0),
-      flags_(0), created_thread_id_(std::this_thread::get_id()) {
+                                                   const std::string& tag_extracted_name,
+                                                   const std::vector<Tag>& tags,
+                                                   SymbolTable& symbol_table)
+    : MetricImpl(name, tag_extracted_name, tags, symbol_table), current_active_(0), flags_(0),
+      created_thread_id_(std::this_thread::get_id()) {
   histograms_[0] = hist_alloc();
   histograms_[1] = hist_alloc();
 }
@@ -339,10 +410,11 @@ void ThreadLocalHistogramImpl::merge(histogram_t* target) {
 }
 
 ParentHistogramImpl::ParentHistogramImpl(const std::string& name, Store& parent,
-                                         TlsScope& tls_scope, std::string&& tag_extracted_name,
-                                         std::vector<Tag>&& tags)
-    : MetricImpl(name, std::move(tag_extracted_name), std::move(tags)), parent_(parent),
-      tls_scope_(tls_scope), interval_histogram_(hist_alloc()), cumulative_histogram_(hist_alloc()),
+                                         TlsScope& tls_scope, const std::string& tag_extracted_name,
+                                         const std::vector<Tag>& tags, SymbolTable& symbol_table)
+    : MetricImpl(name, tag_extracted_name, tags, symbol_table), name_(name),
+      tag_extracted_name_(tag_extracted_name), tags_(tags), parent_(parent), tls_scope_(tls_scope),
+      interval_histogram_(hist_alloc()), cumulative_histogram_(hist_alloc()),
       interval_statistics_(interval_histogram_), cumulative_statistics_(cumulative_histogram_),
       merged_(false) {}
 
@@ -352,7 +424,7 @@ ParentHistogramImpl::~ParentHistogramImpl() {
 }
 
 void ParentHistogramImpl::recordValue(uint64_t value) {
-  Histogram& tls_histogram = tls_scope_.tlsHistogram(name(), *this);
+  Histogram& tls_histogram = tls_scope_.tlsHistogram(*this);
   tls_histogram.recordValue(value);
   parent_.deliverHistogramToSinks(*this, value);
 }
@@ -10,7 +10,10 @@
 
 #include "envoy/thread_local/thread_local.h"
 
+#include "common/common/thread.h"
+#include "common/common/thread_annotations.h"
 #include "common/stats/stats_impl.h"
+#include "common/stats/symbol_table_impl.h"
 
 namespace Envoy {
 namespace Stats {
@@ -22,8 +25,8 @@ namespace Stats {
  */
 class ThreadLocalHistogramImpl : public Histogram, public MetricImpl {
 public:
-  ThreadLocalHistogramImpl(const std::string& name, std::string&& tag_extracted_name,
-                           std::vector<Tag>&& tags);
+  ThreadLocalHistogramImpl(const std::string& name, const std::string& tag_extracted_name,
+                           const std::vector<Tag>& tags, SymbolTable& symbol_table);
   ~ThreadLocalHistogramImpl();
 
   void merge(histogram_t* target);
@@ -55,18 +58,26 @@ typedef std::shared_ptr<ThreadLocalHistogramImpl> TlsHistogramSharedPtr;
 class TlsScope;
 
 /**
- * Log Linear Histogram implementation that is stored in the main thread.
+ * Log Linear Histogram implementation that is stored in the main thread. Unlike other metrics, it
+ * keeps its name and tags decoded, since sinks read them each time a value is recorded, on the
+ * recording thread. Histograms are few compared to counters and gauges, so this costs little.
  */
 class ParentHistogramImpl : public ParentHistogram, public MetricImpl {
 public:
   ParentHistogramImpl(const std::string& name, Store& parent, TlsScope& tlsScope,
-                      std::string&& tag_extracted_name, std::vector<Tag>&& tags);
+                      const std::string& tag_extracted_name, const std::vector<Tag>& tags,
+                      SymbolTable& symbol_table);
   ~ParentHistogramImpl();
 
   void addTlsHistogram(const TlsHistogramSharedPtr& hist_ptr);
   bool used() const override;
   void recordValue(uint64_t value) override;
 
+  // Stats::Metric
+  std::string name() const override { return name_; }
+  std::string tagExtractedName() const override { return tag_extracted_name_; }
+  std::vector<Tag> tags() const override { return tags_; }
+
   /**
    * This method is called during the main stats flush process for each of the histograms. It
    * iterates through the TLS histograms and collects the histogram data of all of them
@@ -84,6 +95,9 @@ public:
 private:
   bool usedLockHeld() const EXCLUSIVE_LOCKS_REQUIRED(merge_lock_);
 
+  const std::string name_;
+  const std::string tag_extracted_name_;
+  const std::vector<Tag> tags_;
   Store& parent_;
   TlsScope& tls_scope_;
   histogram_t* interval_histogram_;
@@ -107,9 +121,9 @@ public:
   // TODO(ramaraochavali): Allow direct TLS access for the advanced consumers.
   /**
    * @return a ThreadLocalHistogram within the scope's namespace.
-   * @param name name of the histogram with scope prefix attached.
+   * @param parent the parent histogram, whose name already has the scope prefix attached.
    */
-  virtual Histogram& tlsHistogram(const std::string& name, ParentHistogramImpl& parent) PURE;
+  virtual Histogram& tlsHistogram(ParentHistogramImpl& parent) PURE;
 };
 
 /**
@@ -119,7 +133,7 @@ public:
  * - Overlapping scopes with proper reference counting (2 scopes with the same name will point to
  *   the same backing stats).
  * - Scope deletion.
- * - Lockless in the fast path.
+ * - The fast path takes no lock but the symbol table's, shared, to encode the name looked up.
  *
  * This implementation is complicated so here is a rough overview of the threading model.
  * - The store can be used before threading is initialized. This is needed during server init.
@@ -128,6 +142,14 @@ public:
  * - Scopes can be deleted from any thread, and they are in practice as scopes are likely to be
  *   shared across all worker threads.
  * - Per thread caches are checked, and if empty, they are populated from the central cache.
+ * - Both the per thread and the central caches are keyed by the encoded name of each stat, which
+ *   the stat owns, so the caches do not store names of their own. Names are encoded with the
+ *   symbol table of the allocator, which the store shares, so each token is stored once. A name
+ *   being looked up is encoded without taking references on its tokens; see
+ *   SymbolTable::tryEncodeInterned() for when this is safe.
+ * - Each scope's central cache has its own lock, so threads populating their caches for different
+ *   scopes do not contend, e.g. when a CDS update adds many clusters at once. Stats are created
+ *   without holding the lock, and only inserted if no other thread got there first.
  * - Scopes are entirely owned by the caller. The store only keeps weak pointers.
  * - When a scope is destroyed, a cache flush operation is run on all threads to flush any cached
  *   data owned by the destroyed scope.
@@ -196,17 +218,22 @@ public:
   Source& source() override { return source_; }
 
 private:
+  // Keyed by the encoded name of each stat, which is owned by the stat the entry holds.
+  template <class StatType> using StatMap = StatNameHashMap<std::shared_ptr<StatType>>;
+
   struct TlsCacheEntry {
-    std::unordered_map<std::string, CounterSharedPtr> counters_;
-    std::unordered_map<std::string, GaugeSharedPtr> gauges_;
-    std::unordered_map<std::string, TlsHistogramSharedPtr> histograms_;
-    std::unordered_map<std::string, ParentHistogramSharedPtr> parent_histograms_;
+    StatMap<Counter> counters_;
+    StatMap<Gauge> gauges_;
+    StatMap<ParentHistogramImpl> parent_histograms_;
+
+    // Keyed by the name of the parent histogram, whose storage outlives the entry.
+    StatNameHashMap<TlsHistogramSharedPtr> histograms_;
   };
 
   struct CentralCacheEntry {
-    std::unordered_map<std::string, CounterSharedPtr> counters_;
-    std::unordered_map<std::string, GaugeSharedPtr> gauges_;
-    std::unordered_map<std::string, ParentHistogramImplSharedPtr> histograms_;
+    StatMap<Counter> counters_;
+    StatMap<Gauge> gauges_;
+    StatMap<ParentHistogramImpl> histograms_;
   };
 
   struct ScopeImpl : public TlsScope {
@@ -223,7 +250,7 @@ private:
     void deliverHistogramToSinks(const Histogram& histogram, uint64_t value) override;
     Gauge& gauge(const std::string& name) override;
     Histogram& histogram(const std::string& name) override;
-    Histogram& tlsHistogram(const std::string& name, ParentHistogramImpl& parent) override;
+    Histogram& tlsHistogram(ParentHistogramImpl& parent) override;
 
     template <class StatType>
     using MakeStatFn =
@@ -239,23 +266,70 @@ private:
      * @param name the full name of the stat (not tag extracted).
      * @param central_cache_map a map from name to the desired object in the central cache.
      * @param make_stat a function to generate the stat object, called if it's not in cache.
-     * @param tls_ref possibly null reference to a cache entry for this stat, which will be
-     *     used if non-empty, or filled in if empty (and non-null).
+     * @param tls_cache_map possibly null per thread cache, which the stat is looked up in first,
+     *     and added to if it is not there.
+     */
+    template <class StatType>
+    StatType& safeMakeStat(const std::string& name, StatMap<StatType>& central_cache_map,
+                           MakeStatFn<StatType> make_stat, StatMap<StatType>* tls_cache_map);
+
+    /**
+     * Looks up a stat in a per thread cache. The name is encoded without taking references on its
+     * tokens, which is safe because only the calling thread adds to the cache.
+     * @param name the full name of the stat.
+     * @param tls_cache_map the per thread cache to look the stat up in.
+     * @return the stat from the cache, or nullptr if there is none.
+     */
+    template <class StatType>
+    std::shared_ptr<StatType> findTls(const std::string& name,
+                                      const StatMap<StatType>& tls_cache_map) const;
+
+    /**
+     * Looks up a stat without encoding its name for keeping, which only takes the symbol table
+     * lock shared.
+     * @param name the full name of the stat.
+     * @param central_cache_map the map to look the stat up in.
+     * @return the stat from the central cache, or nullptr if there is none.
+     */
+    template <class StatType>
+    std::shared_ptr<StatType> findCentral(const std::string& name,
+                                          StatMap<StatType>& central_cache_map);
+
+    /**
+     * Adds a stat to the central cache, unless another thread added one with the same name since
+     * findCentral() was called, in which case the passed stat is dropped.
+     *
+     * @param stat the stat to add, whose encoded name the entry is keyed by.
+     * @param central_cache_map the map to add the stat to.
+     * @return the stat in the central cache.
      */
     template <class StatType>
-    StatType&
-    safeMakeStat(const std::string& name,
-                 std::unordered_map<std::string, std::shared_ptr<StatType>>& central_cache_map,
-                 MakeStatFn<StatType> make_stat, std::shared_ptr<StatType>* tls_ref);
+    std::shared_ptr<StatType> insertCentral(std::shared_ptr<StatType> stat,
+                                            StatMap<StatType>& central_cache_map);
 
     static std::atomic<uint64_t> next_scope_id_;
 
     const uint64_t scope_id_;
     ThreadLocalStoreImpl& parent_;
     const std::string prefix_;
+    mutable Thread::MutexBasicLockable central_cache_lock_;
     CentralCacheEntry central_cache_;
   };
 
+  /**
+   * Locks the central cache of a scope, counting the acquisitions that had to wait for another
+   * thread in stats.central_cache_lock_contention.
+   */
+  class SCOPED_LOCKABLE CentralCacheLockGuard {
+  public:
+    explicit CentralCacheLockGuard(const ScopeImpl& scope)
+        EXCLUSIVE_LOCK_FUNCTION(scope.central_cache_lock_);
+    ~CentralCacheLockGuard() UNLOCK_FUNCTION();
+
+  private:
+    Thread::BasicLockable& lock_;
+  };
+
   struct TlsCache : public ThreadLocal::ThreadLocalObject {
     // The TLS scope cache is keyed by scope ID. This is used to avoid complex circular references
     // during scope destruction. An ID is required vs. using the address of the scope pointer
@@ -273,8 +347,12 @@ private:
   void mergeInternal(PostMergeCb mergeCb);
 
   StatDataAllocator& alloc_;
+  // The symbol table of alloc_, which encodes the names of all the stats of the store.
+  SymbolTable& symbol_table_;
   Event::Dispatcher* main_thread_dispatcher_{};
   ThreadLocal::SlotPtr tls_;
+  // Guards the set of scopes. When both are needed, this is taken before the central cache lock of
+  // a scope.
   mutable Thread::MutexBasicLockable lock_;
   std::unordered_set<ScopeImpl*> scopes_ GUARDED_BY(lock_);
   ScopePtr default_scope_;
@@ -283,6 +361,8 @@ private:
   std::atomic<bool> shutting_down_{};
   std::atomic<bool> merge_in_progress_{};
   Counter& num_last_resort_stats_;
+  Counter& central_cache_lock_contention_;
+  Counter& symbol_table_lock_contention_;
   HeapRawStatDataAllocator heap_allocator_;
   SourceImpl source_;
 };
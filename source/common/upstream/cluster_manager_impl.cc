@@ -572,21 +572,18 @@ void ClusterManagerImpl::postThreadLocalClusterUpdate(const Cluster& cluster, ui
                                                       const HostVector& hosts_removed) {
   const auto& host_set = cluster.prioritySet().hostSetsPerPriority()[priority];
 
-  // TODO(htuch): Can we skip these copies by exporting out const shared_ptr from HostSet?
-  HostVectorConstSharedPtr hosts_copy(new HostVector(host_set->hosts()));
-  HostVectorConstSharedPtr healthy_hosts_copy(new HostVector(host_set->healthyHosts()));
-  HostsPerLocalityConstSharedPtr hosts_per_locality_copy = host_set->hostsPerLocality().clone();
-  HostsPerLocalityConstSharedPtr healthy_hosts_per_locality_copy =
-      host_set->healthyHostsPerLocality().clone();
-
+  // The host vectors are immutable, so every worker shares the main thread's vectors and only
+  // swaps its pointers to them.
   tls_->runOnAllThreads([
-    this, name = cluster.info()->name(), priority, hosts_copy, healthy_hosts_copy,
-    hosts_per_locality_copy, healthy_hosts_per_locality_copy,
+    this, name = cluster.info()->name(), priority, hosts = host_set->hostsPtr(),
+    healthy_hosts = host_set->healthyHostsPtr(),
+    hosts_per_locality = host_set->hostsPerLocalityPtr(),
+    healthy_hosts_per_locality = host_set->healthyHostsPerLocalityPtr(),
     locality_weights = host_set->localityWeights(), hosts_added, hosts_removed
   ]() {
     ThreadLocalClusterManagerImpl::updateClusterMembership(
-        name, priority, hosts_copy, healthy_hosts_copy, hosts_per_locality_copy,
-        healthy_hosts_per_locality_copy, locality_weights, hosts_added, hosts_removed, *tls_);
+        name, priority, hosts, healthy_hosts, hosts_per_locality, healthy_hosts_per_locality,
+        locality_weights, hosts_added, hosts_removed, *tls_);
   });
 }
 
@@ -944,6 +941,13 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::ClusterEntry(
                                            parent.parent_.random_, cluster->lbConfig()));
       break;
     }
+    case LoadBalancerType::PeakEwma: {
+      ASSERT(lb_factory_ == nullptr);
+      lb_.reset(new PeakEwmaLoadBalancer(priority_set_, parent_.local_priority_set_,
+                                         cluster->stats(), parent.parent_.runtime_,
+                                         parent.parent_.random_, cluster->lbConfig()));
+      break;
+    }
     case LoadBalancerType::RingHash:
     case LoadBalancerType::Maglev: {
       ASSERT(lb_factory_ != nullptr);
@@ -1,6 +1,8 @@
 #include "common/upstream/load_balancer_impl.h"
 
+#include <chrono>
 #include <cstdint>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -18,6 +20,9 @@ namespace {
 static const std::string RuntimeZoneEnabled = "upstream.zone_routing.enabled";
 static const std::string RuntimeMinClusterSize = "upstream.zone_routing.min_cluster_size";
 static const std::string RuntimePanicThreshold = "upstream.healthy_panic_threshold";
+// Cost of a host that has active requests but has never responded, above the cost of any host
+// that has. As in Finagle, such a host is only chosen over another in the same situation.
+static const double PeakEwmaPenalty = std::numeric_limits<int64_t>::max() >> 16;
 } // namespace
 
 uint32_t LoadBalancerBase::choosePriority(uint64_t hash,
@@ -523,5 +528,30 @@ HostConstSharedPtr RandomLoadBalancer::chooseHost(LoadBalancerContext*) {
   return hosts_to_use[random_.random() % hosts_to_use.size()];
 }
 
+HostConstSharedPtr PeakEwmaLoadBalancer::chooseHost(LoadBalancerContext*) {
+  const HostVector& hosts_to_use = hostSourceToHosts(hostSourceToUse());
+  if (hosts_to_use.empty()) {
+    return nullptr;
+  }
+
+  const HostSharedPtr& host1 = hosts_to_use[random_.random() % hosts_to_use.size()];
+  const HostSharedPtr& host2 = hosts_to_use[random_.random() % hosts_to_use.size()];
+  const MonotonicTime now = std::chrono::steady_clock::now();
+  if (cost(*host1, now) < cost(*host2, now)) {
+    return host1;
+  } else {
+    return host2;
+  }
+}
+
+double PeakEwmaLoadBalancer::cost(const Host& host, MonotonicTime now) {
+  const uint64_t active_requests = host.stats().rq_active_.value();
+  const double latency = host.latencyEstimator().estimate(now);
+  if (latency == 0 && active_requests > 0) {
+    return PeakEwmaPenalty + active_requests;
+  }
+  return latency * (active_requests + 1) / host.weight();
+}
+
 } // namespace Upstream
 } // namespace Envoy
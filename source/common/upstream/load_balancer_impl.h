@@ -354,6 +354,32 @@ public:
   HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
 };
 
+/**
+ * Latency aware load balancer that picks two random hosts and chooses the one with the lower cost:
+ * the estimate of its response latency times its active requests plus one, divided by its weight.
+ * Unlike the least request load balancer, it avoids slow hosts even when they have few active
+ * requests. The latency estimates are the peak EWMA estimates of the hosts, fed by the router.
+ */
+class PeakEwmaLoadBalancer : public LoadBalancer, ZoneAwareLoadBalancerBase {
+public:
+  PeakEwmaLoadBalancer(const PrioritySet& priority_set, const PrioritySet* local_priority_set,
+                       ClusterStats& stats, Runtime::Loader& runtime,
+                       Runtime::RandomGenerator& random,
+                       const envoy::api::v2::Cluster::CommonLbConfig& common_config)
+      : ZoneAwareLoadBalancerBase(priority_set, local_priority_set, stats, runtime, random,
+                                  common_config) {}
+
+  // Upstream::LoadBalancer
+  HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
+
+  /**
+   * @param host supplies the host.
+   * @param now supplies the current time.
+   * @return the cost of sending a request to host at time now.
+   */
+  static double cost(const Host& host, MonotonicTime now);
+};
+
 /**
  * Implementation of LoadBalancerSubsetInfo.
  */
@@ -72,6 +72,9 @@ private:
     Outlier::DetectorHostMonitor& outlierDetector() const override {
       return logical_host_->outlierDetector();
     }
+    LatencyEstimator& latencyEstimator() const override {
+      return logical_host_->latencyEstimator();
+    }
     const HostStats& stats() const override { return logical_host_->stats(); }
     const std::string& hostname() const override { return logical_host_->hostname(); }
     Network::Address::InstanceConstSharedPtr address() const override { return address_; }
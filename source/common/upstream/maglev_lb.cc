@@ -1,11 +1,18 @@
 #include "common/upstream/maglev_lb.h"
 
+#include <algorithm>
+
 namespace Envoy {
 namespace Upstream {
 
+const uint32_t MaglevTable::EmptyEntry;
+
 MaglevTable::MaglevTable(const HostsPerLocality& hosts_per_locality,
                          const LocalityWeightsConstSharedPtr& locality_weights, uint64_t table_size)
-    : table_size_(table_size) {
+    : MaglevTable(weightedHosts(hosts_per_locality, locality_weights), table_size) {}
+
+MaglevTable::MaglevTable(WeightedHostVector weighted_hosts, uint64_t table_size)
+    : weighted_hosts_(std::move(weighted_hosts)), table_size_(table_size) {
   // TODO(mattklein123): The Maglev table must have a size that is a prime number for the algorithm
   // to work. Currently, the table size is not user configurable. In the future, if the table size
   // is made user configurable, we will need proper error checking that the user cannot configure a
@@ -13,45 +20,29 @@ MaglevTable::MaglevTable(const HostsPerLocality& hosts_per_locality,
   // not good!).
   ASSERT(Primes::isPrime(table_size));
 
-  // Compute host weight combined with locality weight where applicable.
-  const auto effective_weight = [&locality_weights](uint32_t host_weight,
-                                                    uint32_t locality_index) -> uint32_t {
-    if (locality_weights == nullptr || locality_weights->empty()) {
-      return host_weight;
-    } else {
-      return host_weight * (*locality_weights)[locality_index];
-    }
-  };
-
   // Compute maximum host weight. If this is zero, we are doing unweighted Maglev.
   uint32_t max_host_weight = 0;
-  uint32_t total_hosts = 0;
-  for (uint32_t i = 0; i < hosts_per_locality.get().size(); ++i) {
-    for (const auto& host : hosts_per_locality.get()[i]) {
-      max_host_weight = std::max(effective_weight(host->weight(), i), max_host_weight);
-      ++total_hosts;
-    }
+  for (const auto& weighted_host : weighted_hosts_) {
+    max_host_weight = std::max(weighted_host.second, max_host_weight);
+    total_weight_ += weighted_host.second;
   }
 
   // We can't do anything sensible with no hosts.
-  if (total_hosts == 0) {
+  if (weighted_hosts_.empty()) {
     return;
   }
 
   // Implementation of pseudocode listing 1 in the paper (see header file for more info).
   std::vector<TableBuildEntry> table_build_entries;
-  table_build_entries.reserve(total_hosts);
-  for (uint32_t i = 0; i < hosts_per_locality.get().size(); ++i) {
-    for (const auto& host : hosts_per_locality.get()[i]) {
-      const std::string& address = host->address()->asString();
-      table_build_entries.emplace_back(host, HashUtil::xxHash64(address) % table_size_,
-                                       (HashUtil::xxHash64(address, 1) % (table_size_ - 1)) + 1,
-                                       max_host_weight > 0 ? effective_weight(host->weight(), i)
-                                                           : 0);
-    }
+  table_build_entries.reserve(weighted_hosts_.size());
+  for (uint32_t i = 0; i < weighted_hosts_.size(); i++) {
+    const std::string& address = weighted_hosts_[i].first->address()->asString();
+    table_build_entries.emplace_back(i, HashUtil::xxHash64(address) % table_size_,
+                                     (HashUtil::xxHash64(address, 1) % (table_size_ - 1)) + 1,
+                                     max_host_weight > 0 ? weighted_hosts_[i].second : 0);
   }
 
-  table_.resize(table_size_);
+  table_.resize(table_size_, EmptyEntry);
   uint64_t table_index = 0;
   uint32_t iteration = 1;
   while (true) {
@@ -70,18 +61,18 @@ MaglevTable::MaglevTable(const HostsPerLocality& hosts_per_locality,
         entry.counts_ += max_host_weight;
       }
       uint64_t c = permutation(entry);
-      while (table_[c] != nullptr) {
+      while (table_[c] != EmptyEntry) {
         entry.next_++;
         c = permutation(entry);
       }
 
-      table_[c] = entry.host_;
+      table_[c] = entry.host_index_;
       entry.next_++;
       table_index++;
       if (table_index == table_size_) {
         if (ENVOY_LOG_CHECK_LEVEL(trace)) {
           for (uint64_t i = 0; i < table_.size(); i++) {
-            ENVOY_LOG(trace, "maglev: i={} host={}", i, table_[i]->address()->asString());
+            ENVOY_LOG(trace, "maglev: i={} host={}", i, host(i)->address()->asString());
           }
         }
         return;
@@ -91,17 +82,118 @@ MaglevTable::MaglevTable(const HostsPerLocality& hosts_per_locality,
   }
 }
 
+MaglevTable::WeightedHostVector
+MaglevTable::weightedHosts(const HostsPerLocality& hosts_per_locality,
+                           const LocalityWeightsConstSharedPtr& locality_weights) {
+  const bool has_locality_weights = locality_weights != nullptr && !locality_weights->empty();
+  WeightedHostVector weighted_hosts;
+  for (uint32_t i = 0; i < hosts_per_locality.get().size(); ++i) {
+    for (const auto& host : hosts_per_locality.get()[i]) {
+      // Compute host weight combined with locality weight where applicable.
+      weighted_hosts.emplace_back(host, has_locality_weights
+                                            ? host->weight() * (*locality_weights)[i]
+                                            : host->weight());
+    }
+  }
+  return weighted_hosts;
+}
+
+uint64_t MaglevTable::entriesMoved(const MaglevTable& previous) const {
+  if (table_.empty() || previous.table_.empty()) {
+    return std::max(table_.size(), previous.table_.size());
+  }
+
+  ASSERT(table_.size() == previous.table_.size());
+  uint64_t entries_moved = 0;
+  for (uint64_t i = 0; i < table_.size(); i++) {
+    if (host(i) != previous.host(i)) {
+      entries_moved++;
+    }
+  }
+  return entries_moved;
+}
+
 HostConstSharedPtr MaglevTable::chooseHost(uint64_t hash) const {
   if (table_.empty()) {
     return nullptr;
   }
 
-  return table_[hash % table_size_];
+  return host(hash % table_size_);
+}
+
+HostConstSharedPtr MaglevTable::chooseHost(uint64_t hash,
+                                           const HostOverloadedCb& overloaded) const {
+  if (table_.empty()) {
+    return nullptr;
+  }
+
+  // The hosts of consecutive entries are spread like the hosts of random entries. Each host found
+  // overloaded is remembered rather than asked about again at its next entry, and the walk stops
+  // once all the hosts of the table have been. The first round of filling the table gives an
+  // entry to each host, as long as there are enough entries.
+  const uint64_t num_table_hosts = std::min<uint64_t>(weighted_hosts_.size(), table_size_);
+  std::vector<bool> overloaded_hosts;
+  uint64_t num_overloaded_hosts = 0;
+  const uint64_t first_entry = hash % table_size_;
+  uint64_t entry = first_entry;
+  do {
+    const uint32_t host_index = table_[entry];
+    if (overloaded_hosts.empty() || !overloaded_hosts[host_index]) {
+      const double load_share = total_weight_ > 0
+                                    ? static_cast<double>(weighted_hosts_[host_index].second) /
+                                          total_weight_
+                                    : 1.0 / weighted_hosts_.size();
+      if (!overloaded(*weighted_hosts_[host_index].first, load_share)) {
+        return weighted_hosts_[host_index].first;
+      }
+      if (++num_overloaded_hosts == num_table_hosts) {
+        break;
+      }
+      overloaded_hosts.resize(weighted_hosts_.size());
+      overloaded_hosts[host_index] = true;
+    }
+    entry = (entry + 1) % table_size_;
+  } while (entry != first_entry);
+
+  return host(first_entry);
 }
 
 uint64_t MaglevTable::permutation(const TableBuildEntry& entry) {
   return (entry.offset_ + (entry.skip_ * entry.next_)) % table_size_;
 }
 
+ThreadAwareLoadBalancerBase::HashingLoadBalancerSharedPtr
+MaglevLoadBalancer::createLoadBalancer(const HostSet& host_set,
+                                       const HashingLoadBalancerSharedPtr& previous) {
+  // Note that we only compute global panic on host set refresh. Given that the runtime setting
+  // will rarely change, this is a reasonable compromise to avoid creating extra LBs when we only
+  // need to create one per priority level.
+  const bool has_locality =
+      host_set.localityWeights() != nullptr && !host_set.localityWeights()->empty();
+  const bool global_panic = isGlobalPanic(host_set);
+  MaglevTable::WeightedHostVector weighted_hosts;
+  if (!has_locality) {
+    weighted_hosts = MaglevTable::weightedHosts(
+        HostsPerLocalityImpl(global_panic ? host_set.hosts() : host_set.healthyHosts(), false),
+        nullptr);
+  } else {
+    weighted_hosts = MaglevTable::weightedHosts(
+        global_panic ? host_set.hostsPerLocality() : host_set.healthyHostsPerLocality(),
+        host_set.localityWeights());
+  }
+
+  const MaglevTable* previous_table = dynamic_cast<const MaglevTable*>(previous.get());
+  if (previous_table != nullptr && previous_table->weightedHosts() == weighted_hosts) {
+    stats_.lb_rebuild_incremental_.inc();
+    return previous;
+  }
+
+  auto table = std::make_shared<MaglevTable>(std::move(weighted_hosts), table_size_);
+  if (previous_table != nullptr) {
+    stats_.lb_rebuild_entries_moved_.add(table->entriesMoved(*previous_table));
+  }
+  return table;
+}
+
 } // namespace Upstream
 } // namespace Envoy
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
+#include <vector>
+
 #include "common/upstream/thread_aware_lb_impl.h"
 #include "common/upstream/upstream_impl.h"
 
@@ -15,22 +19,48 @@ namespace Upstream {
 class MaglevTable : public ThreadAwareLoadBalancerBase::HashingLoadBalancer,
                     Logger::Loggable<Logger::Id::upstream> {
 public:
+  /**
+   * Hosts of a table, in the order they fill it, with their weights multiplied by the weights of
+   * their localities.
+   */
+  typedef std::vector<std::pair<HostSharedPtr, uint32_t>> WeightedHostVector;
+
   MaglevTable(const HostsPerLocality& hosts_per_locality,
               const LocalityWeightsConstSharedPtr& locality_weights,
               uint64_t table_size = DefaultTableSize);
+  MaglevTable(WeightedHostVector weighted_hosts, uint64_t table_size);
 
   // ThreadAwareLoadBalancerBase::HashingLoadBalancer
   HostConstSharedPtr chooseHost(uint64_t hash) const override;
+  HostConstSharedPtr chooseHost(uint64_t hash, const HostOverloadedCb& overloaded) const override;
+
+  /**
+   * @return the hosts that a table built for hosts_per_locality and locality_weights is filled
+   *         with. Two tables of the same size with equal weighted hosts are identical.
+   */
+  static WeightedHostVector weightedHosts(const HostsPerLocality& hosts_per_locality,
+                                          const LocalityWeightsConstSharedPtr& locality_weights);
+
+  /**
+   * @return the hosts that this table is filled with.
+   */
+  const WeightedHostVector& weightedHosts() const { return weighted_hosts_; }
+
+  /**
+   * @return the number of entries of this table whose host is not the one of the same entry in
+   *         previous, which is of the same size.
+   */
+  uint64_t entriesMoved(const MaglevTable& previous) const;
 
   // Recommended table size in section 5.3 of the paper.
   static const uint64_t DefaultTableSize = 65537;
 
 private:
   struct TableBuildEntry {
-    TableBuildEntry(const HostSharedPtr& host, uint64_t offset, uint64_t skip, uint64_t weight)
-        : host_(host), offset_(offset), skip_(skip), weight_(weight) {}
+    TableBuildEntry(uint32_t host_index, uint64_t offset, uint64_t skip, uint64_t weight)
+        : host_index_(host_index), offset_(offset), skip_(skip), weight_(weight) {}
 
-    HostSharedPtr host_;
+    const uint32_t host_index_;
     const uint64_t offset_;
     const uint64_t skip_;
     const uint64_t weight_;
@@ -39,13 +69,22 @@ private:
   };
 
   uint64_t permutation(const TableBuildEntry& entry);
+  const HostSharedPtr& host(uint64_t entry) const { return weighted_hosts_[table_[entry]].first; }
+
+  static const uint32_t EmptyEntry = std::numeric_limits<uint32_t>::max();
 
+  const WeightedHostVector weighted_hosts_;
+  uint64_t total_weight_{};
   const uint64_t table_size_;
-  HostVector table_;
+  // The index in weighted_hosts_ of the host of each entry.
+  std::vector<uint32_t> table_;
 };
 
 /**
- * Thread aware load balancer implementation for Maglev.
+ * Thread aware load balancer implementation for Maglev. The table of a priority level is kept
+ * when its weighted hosts did not change. Otherwise it is rebuilt in full: the table is filled by
+ * the hosts taking turns in order, so any change can move entries anywhere, and it must not
+ * depend on previous updates so that every Envoy with the same hosts has the same table.
  */
 class MaglevLoadBalancer : public ThreadAwareLoadBalancerBase {
 public:
@@ -58,30 +97,9 @@ public:
 
 private:
   // ThreadAwareLoadBalancerBase
-  HashingLoadBalancerSharedPtr createLoadBalancer(const HostSet& host_set) override {
-    // Note that we only compute global panic on host set refresh. Given that the runtime setting
-    // will rarely change, this is a reasonable compromise to avoid creating extra LBs when we only
-    // need to create one per priority level.
-    const bool has_locality =
-        host_set.localityWeights() != nullptr && !host_set.localityWeights()->empty();
-    if (isGlobalPanic(host_set)) {
-      if (!has_locality) {
-        return std::make_shared<MaglevTable>(HostsPerLocalityImpl(host_set.hosts(), false), nullptr,
-                                             table_size_);
-      } else {
-        return std::make_shared<MaglevTable>(host_set.hostsPerLocality(),
-                                             host_set.localityWeights(), table_size_);
-      }
-    } else {
-      if (!has_locality) {
-        return std::make_shared<MaglevTable>(HostsPerLocalityImpl(host_set.healthyHosts(), false),
-                                             nullptr, table_size_);
-      } else {
-        return std::make_shared<MaglevTable>(host_set.healthyHostsPerLocality(),
-                                             host_set.localityWeights(), table_size_);
-      }
-    }
-  }
+  HashingLoadBalancerSharedPtr
+  createLoadBalancer(const HostSet& host_set,
+                     const HashingLoadBalancerSharedPtr& previous) override;
 
   const uint64_t table_size_;
 };
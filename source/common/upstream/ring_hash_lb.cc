@@ -1,6 +1,8 @@
 #include "common/upstream/ring_hash_lb.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -18,120 +20,315 @@ RingHashLoadBalancer::RingHashLoadBalancer(
     const absl::optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
     const envoy::api::v2::Cluster::CommonLbConfig& common_config)
     : ThreadAwareLoadBalancerBase(priority_set, stats, runtime, random, common_config),
-      config_(config) {}
+      min_ring_size_(
+          config ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value(), minimum_ring_size, 1024) : 1024),
+      use_std_hash_(config ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value().deprecated_v1(),
+                                                             use_std_hash, true)
+                           : true) {}
 
-HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(uint64_t h) const {
-  if (ring_.empty()) {
-    return nullptr;
-  }
+ThreadAwareLoadBalancerBase::HashingLoadBalancerSharedPtr
+RingHashLoadBalancer::createLoadBalancer(const HostSet& host_set,
+                                         const HashingLoadBalancerSharedPtr& previous) {
+  // Note that we only compute global panic on host set refresh. Given that the runtime setting
+  // will rarely change, this is a reasonable compromise to avoid creating extra LBs when we only
+  // need to create one per priority level.
+  const HostVector& hosts = isGlobalPanic(host_set) ? host_set.hosts() : host_set.healthyHosts();
+  const uint64_t hashes_per_host = hashesPerHost(hosts.size());
+  ENVOY_LOG(info, "ring hash: min_ring_size={} hashes_per_host={}", min_ring_size_,
+            hashes_per_host);
 
-  // Ported from https://github.com/RJ/ketama/blob/master/libketama/ketama.c (ketama_get_server)
-  // I've generally kept the variable names to make the code easier to compare.
-  // NOTE: The algorithm depends on using signed integers for lowp, midp, and highp. Do not
-  //       change them!
-  int64_t lowp = 0;
-  int64_t highp = ring_.size();
-  while (true) {
-    int64_t midp = (lowp + highp) / 2;
+  const Ring* previous_ring = dynamic_cast<const Ring*>(previous.get());
+  if (previous_ring == nullptr) {
+    return std::make_shared<Ring>(hosts, hashes_per_host, use_std_hash_);
+  }
 
-    if (midp == static_cast<int64_t>(ring_.size())) {
-      return ring_[0].host_;
+  // Count the entries of the previous ring that are removed and the entries that are added: all
+  // the entries of removed and added hosts, and for the hosts that are kept, the entries past the
+  // smaller of the previous and new number of entries per host.
+  uint64_t kept_hosts = 0;
+  for (const auto& host : hosts) {
+    if (previous_ring->host_positions_.count(host.get()) > 0) {
+      kept_hosts++;
     }
+  }
+  const uint64_t previous_hashes_per_host = previous_ring->hashes_per_host_;
+  const uint64_t entries_moved =
+      (previous_ring->hosts_.size() - kept_hosts) * previous_hashes_per_host +
+      (hosts.size() - kept_hosts) * hashes_per_host +
+      kept_hosts * (std::max(hashes_per_host, previous_hashes_per_host) -
+                    std::min(hashes_per_host, previous_hashes_per_host));
+  stats_.lb_rebuild_entries_moved_.add(entries_moved);
 
-    uint64_t midval = ring_[midp].hash_;
-    uint64_t midval1 = midp == 0 ? 0 : ring_[midp - 1].hash_;
+  if (entries_moved == 0) {
+    stats_.lb_rebuild_incremental_.inc();
+    return previous;
+  }
+  // Updating the previous ring only pays off when most of its entries are kept.
+  if (2 * entries_moved > hosts.size() * hashes_per_host) {
+    return std::make_shared<Ring>(hosts, hashes_per_host, use_std_hash_);
+  }
+  stats_.lb_rebuild_incremental_.inc();
+  return std::make_shared<Ring>(*previous_ring, hosts, hashes_per_host, use_std_hash_);
+}
 
-    if (h <= midval && h > midval1) {
-      return ring_[midp].host_;
-    }
+uint64_t RingHashLoadBalancer::hashesPerHost(uint64_t num_hosts) const {
+  if (num_hosts == 0) {
+    return 0;
+  }
 
-    if (midval < h) {
-      lowp = midp + 1;
-    } else {
-      highp = midp - 1;
+  // Currently we specify the minimum size of the ring, and determine the replication factor
+  // based on the number of hosts. It's possible we might want to support more sophisticated
+  // configuration in the future.
+  uint64_t hashes_per_host = 1;
+  if (num_hosts < min_ring_size_) {
+    hashes_per_host = min_ring_size_ / num_hosts;
+    if ((min_ring_size_ % num_hosts) != 0) {
+      hashes_per_host++;
     }
+  }
+  return hashes_per_host;
+}
 
-    if (lowp > highp) {
-      return ring_[0].host_;
+HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(uint64_t h) const {
+  if (size() == 0) {
+    return nullptr;
+  }
+
+  return hosts_[hostIndex(find(h))];
+}
+
+HostConstSharedPtr
+RingHashLoadBalancer::Ring::chooseHost(uint64_t h, const HostOverloadedCb& overloaded) const {
+  if (size() == 0) {
+    return nullptr;
+  }
+
+  // The ring does not support weighting, so all hosts have the same share of the load.
+  const double load_share = 1.0 / hosts_.size();
+  // The entries of a host are spread over the ring, so each host found overloaded is remembered
+  // rather than asked about again at its next entry, and the walk stops once all hosts have been.
+  std::vector<bool> overloaded_hosts;
+  uint32_t num_overloaded_hosts = 0;
+  const uint64_t first_entry = find(h);
+  uint64_t k = first_entry;
+  do {
+    const uint32_t host_index = hostIndex(k);
+    if (overloaded_hosts.empty() || !overloaded_hosts[host_index]) {
+      const HostSharedPtr& host = hosts_[host_index];
+      if (!overloaded(*host, load_share)) {
+        return host;
+      }
+      if (++num_overloaded_hosts == hosts_.size()) {
+        break;
+      }
+      overloaded_hosts.resize(hosts_.size());
+      overloaded_hosts[host_index] = true;
+    }
+    k = next(k);
+    if (k == 0) {
+      k = first_;
     }
+  } while (k != first_entry);
+
+  return hosts_[hostIndex(first_entry)];
+}
+
+uint64_t RingHashLoadBalancer::Ring::find(uint64_t h) const {
+  const uint64_t n = size();
+
+  // As in ketama (https://github.com/RJ/ketama/blob/master/libketama/ketama.c, ketama_get_server),
+  // choose the entry with the smallest hash that is not smaller than h, or the first entry if
+  // there is none. Walk down the tree from the root, going right when the hash is smaller than h.
+  uint64_t k = 1;
+  while (k <= n) {
+    // The descendants of k three levels below are 8 consecutive hashes, a cache line.
+    __builtin_prefetch(hashes_.data() + std::min(8 * k, n));
+    k = 2 * k + (hashes_[k] < h);
   }
+  // The bits of k after its leading one are the path taken, with a one for each right turn. The
+  // entry found is the one where the path last turned left, so drop the trailing right turns and
+  // that left turn. If the path never turned left, k becomes 0 and the ring wraps around.
+  k >>= __builtin_ffsll(~k);
+  return k == 0 ? first_ : k;
 }
 
-RingHashLoadBalancer::Ring::Ring(
-    const absl::optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
-    const HostVector& hosts) {
+RingHashLoadBalancer::Ring::Ring(const HostVector& hosts, uint64_t hashes_per_host,
+                                 bool use_std_hash)
+    : hosts_(hosts), hashes_per_host_(hashes_per_host) {
   ENVOY_LOG(trace, "ring hash: building ring");
   if (hosts.empty()) {
     return;
   }
 
-  // Currently we specify the minimum size of the ring, and determine the replication factor
-  // based on the number of hosts. It's possible we might want to support more sophisticated
-  // configuration in the future.
-  // NOTE: Currently we keep a ring for healthy hosts and unhealthy hosts, and this is done per
-  //       thread. This is the simplest implementation, but it's expensive from a memory
-  //       standpoint and duplicates the regeneration computation. In the future we might want
-  //       to generate the rings centrally and then just RCU them out to each thread. This is
-  //       sufficient for getting started.
-  const uint64_t min_ring_size =
-      config ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value(), minimum_ring_size, 1024) : 1024;
+  std::vector<RingEntry> entries;
+  entries.reserve(hosts.size() * hashes_per_host);
+  host_positions_.reserve(hosts.size());
+  for (uint32_t i = 0; i < hosts_.size(); i++) {
+    host_positions_.emplace(hosts_[i].get(), i);
+    addEntries(hosts_[i], i, 0, hashes_per_host, use_std_hash, entries);
+  }
+  sortEntries(entries);
 
-  uint64_t hashes_per_host = 1;
-  if (hosts.size() < min_ring_size) {
-    hashes_per_host = min_ring_size / hosts.size();
-    if ((min_ring_size % hosts.size()) != 0) {
-      hashes_per_host++;
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    for (const RingEntry& entry : entries) {
+      ENVOY_LOG(trace, "ring hash: host={} hash={}",
+                hosts_[entry.host_index_]->address()->asString(), entry.hash_);
     }
   }
+  setEntries(entries);
+}
 
-  ENVOY_LOG(info, "ring hash: min_ring_size={} hashes_per_host={}", min_ring_size, hashes_per_host);
-  ring_.reserve(hosts.size() * hashes_per_host);
+RingHashLoadBalancer::Ring::Ring(const Ring& previous, const HostVector& hosts,
+                                 uint64_t hashes_per_host, bool use_std_hash)
+    : hosts_(hosts), hashes_per_host_(hashes_per_host) {
+  ENVOY_LOG(trace, "ring hash: updating ring");
 
-  const bool use_std_hash =
-      config ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value().deprecated_v1(), use_std_hash, true)
-             : true;
+  // Compute the entries that are added to the previous ring, and the entries of the kept hosts
+  // that are removed from it when there are fewer entries per host.
+  std::vector<RingEntry> added_entries;
+  std::vector<RingEntry> trimmed_entries;
+  host_positions_.reserve(hosts.size());
+  for (uint32_t i = 0; i < hosts_.size(); i++) {
+    const HostSharedPtr& host = hosts_[i];
+    host_positions_.emplace(host.get(), i);
+    if (previous.host_positions_.count(host.get()) == 0) {
+      addEntries(host, i, 0, hashes_per_host, use_std_hash, added_entries);
+    } else if (hashes_per_host > previous.hashes_per_host_) {
+      addEntries(host, i, previous.hashes_per_host_, hashes_per_host, use_std_hash, added_entries);
+    } else if (hashes_per_host < previous.hashes_per_host_) {
+      addEntries(host, i, hashes_per_host, previous.hashes_per_host_, use_std_hash,
+                 trimmed_entries);
+    }
+  }
+  sortEntries(added_entries);
+  sortEntries(trimmed_entries);
 
-  char hash_key_buffer[196];
-  for (const auto& host : hosts) {
-    const std::string& address_string = host->address()->asString();
-    uint64_t offset_start = address_string.size();
-
-    // Currently, we support both IP and UDS addresses. The UDS max path length is ~108 on all Unix
-    // platforms that I know of. Given that, we can use a 196 char buffer which is plenty of room
-    // for UDS, '_', and up to 21 characters for the node ID. To be on the super safe side, there
-    // is a RELEASE_ASSERT here that checks this, in case someone in the future adds some type of
-    // new address that is larger, or runs on a platform where UDS is larger. I don't think it's
-    // worth the defensive coding to deal with the heap allocation case (e.g. via
-    // absl::InlinedVector) at the current time.
-    RELEASE_ASSERT(address_string.size() + 1 + StringUtil::MIN_ITOA_OUT_LEN <=
-                   sizeof(hash_key_buffer));
-    memcpy(hash_key_buffer, address_string.c_str(), offset_start);
-    hash_key_buffer[offset_start++] = '_';
-    for (uint64_t i = 0; i < hashes_per_host; i++) {
-      const uint64_t total_hash_key_len =
-          offset_start +
-          StringUtil::itoa(hash_key_buffer + offset_start, StringUtil::MIN_ITOA_OUT_LEN, i);
-      absl::string_view hash_key(hash_key_buffer, total_hash_key_len);
-
-      // Sadly std::hash provides no mechanism for hashing arbitrary bytes so we must copy here.
-      // xxHash is done wihout copies.
-      const uint64_t hash = use_std_hash ? std::hash<std::string>()(std::string(hash_key))
-                                         : HashUtil::xxHash64(hash_key);
-      ENVOY_LOG(trace, "ring hash: hash_key={} hash={}", hash_key.data(), hash);
-      ring_.push_back({hash, host});
+  // Map the hosts of the previous ring to their index in this one.
+  const uint32_t removed_host = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> host_indexes(previous.hosts_.size(), removed_host);
+  for (uint32_t i = 0; i < previous.hosts_.size(); i++) {
+    const auto position = host_positions_.find(previous.hosts_[i].get());
+    if (position != host_positions_.end()) {
+      host_indexes[i] = position->second;
     }
   }
 
-  std::sort(ring_.begin(), ring_.end(), [](const RingEntry& lhs, const RingEntry& rhs) -> bool {
-    return lhs.hash_ < rhs.hash_;
-  });
+  // The previous ring is walked in hash order, and the other entries are sorted by hash, so they
+  // can be merged in a single pass.
+  std::vector<RingEntry> entries;
+  entries.reserve(hosts.size() * hashes_per_host);
+  auto added = added_entries.begin();
+  auto trimmed = trimmed_entries.begin();
+  for (uint64_t k = previous.first_; k != 0; k = previous.next(k)) {
+    const RingEntry entry{previous.hashes_[k], host_indexes[previous.hostIndex(k)]};
+    if (entry.host_index_ == removed_host) {
+      continue;
+    }
+    while (trimmed != trimmed_entries.end() && trimmed->hash_ < entry.hash_) {
+      ++trimmed;
+    }
+    if (trimmed != trimmed_entries.end() && trimmed->hash_ == entry.hash_ &&
+        trimmed->host_index_ == entry.host_index_) {
+      ++trimmed;
+      continue;
+    }
+    while (added != added_entries.end() && added->hash_ < entry.hash_) {
+      entries.push_back(*added++);
+    }
+    entries.push_back(entry);
+  }
+  entries.insert(entries.end(), added, added_entries.end());
+  setEntries(entries);
+}
 
-  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
-    for (auto entry : ring_) {
-      ENVOY_LOG(trace, "ring hash: host={} hash={}", entry.host_->address()->asString(),
-                entry.hash_);
+void RingHashLoadBalancer::Ring::setEntries(const std::vector<RingEntry>& entries) {
+  if (entries.empty()) {
+    return;
+  }
+
+  hashes_.resize(entries.size() + 1);
+  if (hosts_.size() > std::numeric_limits<uint16_t>::max() + 1) {
+    wide_host_indexes_.resize(hashes_.size());
+  } else {
+    narrow_host_indexes_.resize(hashes_.size());
+  }
+
+  // Fill the tree in order.
+  first_ = 1;
+  while (2 * first_ < hashes_.size()) {
+    first_ *= 2;
+  }
+  uint64_t k = first_;
+  for (const RingEntry& entry : entries) {
+    hashes_[k] = entry.hash_;
+    if (wide_host_indexes_.empty()) {
+      narrow_host_indexes_[k] = entry.host_index_;
+    } else {
+      wide_host_indexes_[k] = entry.host_index_;
+    }
+    k = next(k);
+  }
+}
+
+uint64_t RingHashLoadBalancer::Ring::next(uint64_t k) const {
+  if (k == 0) {
+    return first_;
+  }
+
+  // The next entry is the leftmost entry of the right subtree of k if there is one. Otherwise it is
+  // the parent of the first ancestor of k, or k itself, that is a left child.
+  const uint64_t n = size();
+  if (2 * k + 1 <= n) {
+    k = 2 * k + 1;
+    while (2 * k <= n) {
+      k = 2 * k;
     }
+    return k;
   }
+  while (k & 1) {
+    k >>= 1;
+  }
+  return k >> 1;
+}
+
+void RingHashLoadBalancer::Ring::addEntries(const HostSharedPtr& host, uint32_t host_index,
+                                            uint64_t first, uint64_t last, bool use_std_hash,
+                                            std::vector<RingEntry>& entries) {
+  const std::string& address_string = host->address()->asString();
+  uint64_t offset_start = address_string.size();
+
+  // Currently, we support both IP and UDS addresses. The UDS max path length is ~108 on all Unix
+  // platforms that I know of. Given that, we can use a 196 char buffer which is plenty of room
+  // for UDS, '_', and up to 21 characters for the node ID. To be on the super safe side, there
+  // is a RELEASE_ASSERT here that checks this, in case someone in the future adds some type of
+  // new address that is larger, or runs on a platform where UDS is larger. I don't think it's
+  // worth the defensive coding to deal with the heap allocation case (e.g. via
+  // absl::InlinedVector) at the current time.
+  char hash_key_buffer[196];
+  RELEASE_ASSERT(address_string.size() + 1 + StringUtil::MIN_ITOA_OUT_LEN <=
+                 sizeof(hash_key_buffer));
+  memcpy(hash_key_buffer, address_string.c_str(), offset_start);
+  hash_key_buffer[offset_start++] = '_';
+  for (uint64_t i = first; i < last; i++) {
+    const uint64_t total_hash_key_len =
+        offset_start +
+        StringUtil::itoa(hash_key_buffer + offset_start, StringUtil::MIN_ITOA_OUT_LEN, i);
+    absl::string_view hash_key(hash_key_buffer, total_hash_key_len);
+
+    // Sadly std::hash provides no mechanism for hashing arbitrary bytes so we must copy here.
+    // xxHash is done wihout copies.
+    const uint64_t hash = use_std_hash ? std::hash<std::string>()(std::string(hash_key))
+                                       : HashUtil::xxHash64(hash_key);
+    ENVOY_LOG(trace, "ring hash: hash_key={} hash={}", hash_key.data(), hash);
+    entries.push_back({hash, host_index});
+  }
+}
+
+void RingHashLoadBalancer::Ring::sortEntries(std::vector<RingEntry>& entries) {
+  std::sort(entries.begin(), entries.end(),
+            [](const RingEntry& lhs, const RingEntry& rhs) -> bool {
+              return lhs.hash_ < rhs.hash_;
+            });
 }
 
 } // namespace Upstream
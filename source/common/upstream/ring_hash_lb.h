@@ -1,5 +1,6 @@
 #pragma once
 
+#include <unordered_map>
 #include <vector>
 
 #include "envoy/runtime/runtime.h"
@@ -14,6 +15,9 @@ namespace Upstream {
  * A load balancer that implements consistent modulo hashing ("ketama"). Currently, zone aware
  * routing is not supported. A ring is kept for all hosts as well as a ring for healthy hosts.
  * Unless we are in panic mode, the healthy host ring is used.
+ * When the hosts of a priority level change, its ring is updated from the previous one: the
+ * entries of the removed hosts are dropped and the entries of the added hosts are merged in, so
+ * only the hashes of the added hosts are computed. The ring is the same as one built from scratch.
  * In the future it would be nice to support:
  * 1) Weighting.
  * 2) Per-zone rings and optional zone aware routing (not all applications will want this).
@@ -28,35 +32,101 @@ public:
                        const envoy::api::v2::Cluster::CommonLbConfig& common_config);
 
 private:
+  // An entry of a ring while it is built.
   struct RingEntry {
     uint64_t hash_;
-    HostConstSharedPtr host_;
+    uint32_t host_index_;
   };
 
+  /**
+   * The ring keeps the hashes of its entries and the indexes of their hosts in separate arrays, so
+   * that an entry takes 10 bytes, or 12 bytes with more than 65536 hosts, instead of a hash and a
+   * host pointer with its reference count. The arrays are in Eytzinger order, the order of a
+   * breadth first walk of the binary search tree of the sorted entries: the children of the entry
+   * at index k are at indexes 2k and 2k + 1, and index 0 is unused. A lookup walks down the tree
+   * without branching on the comparisons and prefetches the entries a few levels below, and the
+   * top levels of the tree, which every lookup reads, share a few cache lines.
+   */
   struct Ring : public HashingLoadBalancer {
-    Ring(const absl::optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
-         const HostVector& hosts);
+    /**
+     * Build a ring from scratch.
+     */
+    Ring(const HostVector& hosts, uint64_t hashes_per_host, bool use_std_hash);
+
+    /**
+     * Build a ring from the ring of previous hosts.
+     * @param previous supplies the previous ring.
+     * @param hosts supplies the hosts of the new ring.
+     * @param hashes_per_host supplies the number of entries of each host in the new ring, which may
+     *        differ from the one of the previous ring.
+     * @param use_std_hash supplies whether the entries are hashed with std::hash, as in previous.
+     */
+    Ring(const Ring& previous, const HostVector& hosts, uint64_t hashes_per_host,
+         bool use_std_hash);
 
     // ThreadAwareLoadBalancerBase::HashingLoadBalancer
     HostConstSharedPtr chooseHost(uint64_t hash) const override;
+    HostConstSharedPtr chooseHost(uint64_t hash,
+                                  const HostOverloadedCb& overloaded) const override;
+
+    /**
+     * @return the index of the entry chosen for hash. The ring must not be empty.
+     */
+    uint64_t find(uint64_t hash) const;
+
+    /**
+     * Append the entries with indexes in [first, last) of a host to entries.
+     */
+    static void addEntries(const HostSharedPtr& host, uint32_t host_index, uint64_t first,
+                           uint64_t last, bool use_std_hash, std::vector<RingEntry>& entries);
+    static void sortEntries(std::vector<RingEntry>& entries);
+
+    /**
+     * Set the entries of the ring.
+     * @param entries supplies the entries sorted by hash.
+     */
+    void setEntries(const std::vector<RingEntry>& entries);
+
+    /**
+     * @return the number of entries of the ring.
+     */
+    uint64_t size() const { return hashes_.empty() ? 0 : hashes_.size() - 1; }
 
-    std::vector<RingEntry> ring_;
+    /**
+     * @return the index in hosts_ of the host of the entry at index k.
+     */
+    uint32_t hostIndex(uint64_t k) const {
+      return wide_host_indexes_.empty() ? narrow_host_indexes_[k] : wide_host_indexes_[k];
+    }
+
+    /**
+     * @return the index of the entry with the smallest hash larger than the one at index k, or
+     *         the index of the entry with the smallest hash if k is 0. The ring must not be empty.
+     */
+    uint64_t next(uint64_t k) const;
+
+    std::vector<uint64_t> hashes_;
+    // Only one of these is used: 16 bit indexes are enough for up to 65536 hosts.
+    std::vector<uint16_t> narrow_host_indexes_;
+    std::vector<uint32_t> wide_host_indexes_;
+    HostVector hosts_;
+    // The index in hosts_ of each host.
+    std::unordered_map<const Host*, uint32_t> host_positions_;
+    uint64_t hashes_per_host_{};
+    // The index of the entry with the smallest hash.
+    uint64_t first_{};
   };
   typedef std::shared_ptr<const Ring> RingConstSharedPtr;
 
   // ThreadAwareLoadBalancerBase
-  HashingLoadBalancerSharedPtr createLoadBalancer(const HostSet& host_set) override {
-    // Note that we only compute global panic on host set refresh. Given that the runtime setting
-    // will rarely change, this is a reasonable compromise to avoid creating extra LBs when we only
-    // need to create one per priority level.
-    if (isGlobalPanic(host_set)) {
-      return std::make_shared<Ring>(config_, host_set.hosts());
-    } else {
-      return std::make_shared<Ring>(config_, host_set.healthyHosts());
-    }
-  }
+  HashingLoadBalancerSharedPtr
+  createLoadBalancer(const HostSet& host_set,
+                     const HashingLoadBalancerSharedPtr& previous) override;
+
+  uint64_t hashesPerHost(uint64_t num_hosts) const;
 
-  const absl::optional<envoy::api::v2::Cluster::RingHashLbConfig>& config_;
+  const uint64_t min_ring_size_;
+  const bool use_std_hash_;
 };
 
 } // namespace Upstream
@@ -399,6 +399,12 @@ SubsetLoadBalancer::PrioritySubsetImpl::PrioritySubsetImpl(const SubsetLoadBalan
                                          subset_lb.common_config_));
     break;
 
+  case LoadBalancerType::PeakEwma:
+    lb_.reset(new PeakEwmaLoadBalancer(*this, subset_lb.original_local_priority_set_,
+                                       subset_lb.stats_, subset_lb.runtime_, subset_lb.random_,
+                                       subset_lb.common_config_));
+    break;
+
   case LoadBalancerType::RingHash:
     // TODO(mattklein123): The ring hash LB is thread aware, but currently the subset LB is not.
     // We should make the subset LB thread aware since the calculations are costly, and then we
@@ -1,5 +1,9 @@
 #include "common/upstream/thread_aware_lb_impl.h"
 
+#include <cmath>
+
+#include "envoy/stats/timespan.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -11,22 +15,43 @@ void ThreadAwareLoadBalancerBase::initialize() {
   // complicated initialization as the load balancer would need its own initialized callback. I
   // think the synchronous/asynchronous split is probably the best option.
   priority_set_.addMemberUpdateCb(
-      [this](uint32_t, const HostVector&, const HostVector&) -> void { refresh(); });
+      [this](uint32_t priority, const HostVector&, const HostVector&) -> void {
+        refresh(priority);
+      });
 
-  refresh();
+  refresh({});
 }
 
-void ThreadAwareLoadBalancerBase::refresh() {
+void ThreadAwareLoadBalancerBase::refresh(absl::optional<uint32_t> updated_priority) {
   auto per_priority_state_vector = std::make_shared<std::vector<PerPriorityStatePtr>>(
       priority_set_.hostSetsPerPriority().size());
   auto per_priority_load = std::make_shared<std::vector<uint32_t>>(per_priority_load_);
+  // The state is only written on this thread, so it can be read without taking the lock.
+  const std::shared_ptr<std::vector<PerPriorityStatePtr>> previous_state_vector =
+      factory_->per_priority_state_;
 
   for (const auto& host_set : priority_set_.hostSetsPerPriority()) {
     const uint32_t priority = host_set->priority();
     (*per_priority_state_vector)[priority].reset(new PerPriorityState);
     const auto& per_priority_state = (*per_priority_state_vector)[priority];
-    per_priority_state->current_lb_ = createLoadBalancer(*host_set);
     per_priority_state->global_panic_ = isGlobalPanic(*host_set);
+
+    HashingLoadBalancerSharedPtr previous_lb;
+    if (previous_state_vector != nullptr && priority < previous_state_vector->size()) {
+      const auto& previous_state = (*previous_state_vector)[priority];
+      // The hosts of a priority level whose panic state did not change are the same as when its
+      // load balancer was created, so the load balancer can be kept.
+      if (updated_priority && updated_priority.value() != priority &&
+          previous_state->global_panic_ == per_priority_state->global_panic_) {
+        per_priority_state->current_lb_ = previous_state->current_lb_;
+        continue;
+      }
+      previous_lb = previous_state->current_lb_;
+    }
+
+    Stats::Timespan rebuild_timer(stats_.lb_rebuild_ms_);
+    per_priority_state->current_lb_ = createLoadBalancer(*host_set, previous_lb);
+    rebuild_timer.complete();
   }
 
   {
@@ -56,11 +81,24 @@ ThreadAwareLoadBalancerBase::LoadBalancerImpl::chooseHost(LoadBalancerContext* c
   if (per_priority_state->global_panic_) {
     stats_.lb_healthy_panic_.inc();
   }
-  return per_priority_state->current_lb_->chooseHost(h);
+  if (hash_balance_factor_ == 0) {
+    return per_priority_state->current_lb_->chooseHost(h);
+  }
+
+  // Consistent hashing with bounded loads (https://arxiv.org/abs/1608.01350): a host is
+  // overloaded when taking the request would put it over its capacity, which is its share of the
+  // active requests of the cluster counting this one, times the balance factor, rounded up.
+  const double active_requests = stats_.upstream_rq_active_.value() + 1;
+  const double balance_factor = hash_balance_factor_ / 100.0;
+  return per_priority_state->current_lb_->chooseHost(
+      h, [active_requests, balance_factor](const Host& host, double load_share) -> bool {
+        return host.stats().rq_active_.value() + 1 >
+               std::ceil(active_requests * load_share * balance_factor);
+      });
 }
 
 LoadBalancerPtr ThreadAwareLoadBalancerBase::LoadBalancerFactoryImpl::create() {
-  auto lb = std::make_unique<LoadBalancerImpl>(stats_, random_);
+  auto lb = std::make_unique<LoadBalancerImpl>(stats_, random_, hash_balance_factor_);
 
   // We must protect current_lb_ via a RW lock since it is accessed and written to by multiple
   // threads. All complex processing has already been precalculated however.
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <functional>
 #include <shared_mutex>
 
+#include "common/protobuf/utility.h"
 #include "common/upstream/load_balancer_impl.h"
 
 namespace Envoy {
@@ -19,8 +21,24 @@ public:
    */
   class HashingLoadBalancer {
   public:
+    /**
+     * Callback that returns whether a host is overloaded, given the share of the load of the load
+     * balancer that it should take: its weight divided by the total weight of the hosts.
+     */
+    typedef std::function<bool(const Host& host, double load_share)> HostOverloadedCb;
+
     virtual ~HashingLoadBalancer() {}
     virtual HostConstSharedPtr chooseHost(uint64_t hash) const PURE;
+
+    /**
+     * Choose a host with consistent hashing with bounded loads: the host chosen for hash, or if
+     * it is overloaded, the host of the first entry after its entry whose host is not.
+     * @param hash supplies the hash of the request.
+     * @param overloaded supplies whether a host is overloaded. It is called at most once per host.
+     * @return the host chosen, or the host chosen for hash if all the hosts are overloaded.
+     */
+    virtual HostConstSharedPtr chooseHost(uint64_t hash,
+                                          const HostOverloadedCb& overloaded) const PURE;
   };
   typedef std::shared_ptr<HashingLoadBalancer> HashingLoadBalancerSharedPtr;
 
@@ -33,7 +51,10 @@ protected:
                               Runtime::Loader& runtime, Runtime::RandomGenerator& random,
                               const envoy::api::v2::Cluster::CommonLbConfig& common_config)
       : LoadBalancerBase(priority_set, stats, runtime, random, common_config),
-        factory_(new LoadBalancerFactoryImpl(stats, random)) {}
+        factory_(new LoadBalancerFactoryImpl(
+            stats, random,
+            PROTOBUF_GET_WRAPPED_OR_DEFAULT(common_config.consistent_hashing_lb_config(),
+                                            hash_balance_factor, 0))) {}
 
 private:
   struct PerPriorityState {
@@ -43,27 +64,33 @@ private:
   typedef std::unique_ptr<PerPriorityState> PerPriorityStatePtr;
 
   struct LoadBalancerImpl : public LoadBalancer {
-    LoadBalancerImpl(ClusterStats& stats, Runtime::RandomGenerator& random)
-        : stats_(stats), random_(random) {}
+    LoadBalancerImpl(ClusterStats& stats, Runtime::RandomGenerator& random,
+                     uint32_t hash_balance_factor)
+        : stats_(stats), random_(random), hash_balance_factor_(hash_balance_factor) {}
 
     // Upstream::LoadBalancer
     HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
 
     ClusterStats& stats_;
     Runtime::RandomGenerator& random_;
+    // The load of a host is bounded to this percentage of its share of the active requests of the
+    // cluster, or not bounded if 0.
+    const uint32_t hash_balance_factor_;
     std::shared_ptr<std::vector<PerPriorityStatePtr>> per_priority_state_;
     std::shared_ptr<std::vector<uint32_t>> per_priority_load_;
   };
 
   struct LoadBalancerFactoryImpl : public LoadBalancerFactory {
-    LoadBalancerFactoryImpl(ClusterStats& stats, Runtime::RandomGenerator& random)
-        : stats_(stats), random_(random) {}
+    LoadBalancerFactoryImpl(ClusterStats& stats, Runtime::RandomGenerator& random,
+                            uint32_t hash_balance_factor)
+        : stats_(stats), random_(random), hash_balance_factor_(hash_balance_factor) {}
 
     // Upstream::LoadBalancerFactory
     LoadBalancerPtr create() override;
 
     ClusterStats& stats_;
     Runtime::RandomGenerator& random_;
+    const uint32_t hash_balance_factor_;
     std::shared_timed_mutex mutex_;
     // TOOD(mattklein123): Added GUARDED_BY(mutex_) to to the following variables. OSX clang
     // seems to not like them with shared mutexes so we need to ifdef them out on OSX. I don't
@@ -73,8 +100,24 @@ private:
     std::shared_ptr<std::vector<uint32_t>> per_priority_load_;
   };
 
-  virtual HashingLoadBalancerSharedPtr createLoadBalancer(const HostSet& host_set) PURE;
-  void refresh();
+  /**
+   * Create the hashing load balancer for a priority level.
+   * @param host_set supplies the hosts of the priority level.
+   * @param previous supplies the load balancer previously created for the priority level, or
+   *        nullptr if there is none. It may be returned as is if it is still valid, or be used to
+   *        build the new load balancer incrementally.
+   * @return the load balancer for the priority level.
+   */
+  virtual HashingLoadBalancerSharedPtr
+  createLoadBalancer(const HostSet& host_set, const HashingLoadBalancerSharedPtr& previous) PURE;
+
+  /**
+   * Recreate the load balancers of the priority levels.
+   * @param updated_priority supplies the priority level whose hosts changed. The load balancers of
+   *        other priority levels are kept unless their panic state changed. If empty, all of
+   *        them are recreated.
+   */
+  void refresh(absl::optional<uint32_t> updated_priority);
 
   std::shared_ptr<LoadBalancerFactoryImpl> factory_;
 };
@@ -1,10 +1,12 @@
 #include "common/upstream/upstream_impl.h"
 
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -148,6 +150,35 @@ HostImpl::createConnection(Event::Dispatcher& dispatcher, const ClusterInfo& clu
   return connection;
 }
 
+const std::chrono::microseconds PeakEwmaLatencyEstimator::DecayTime = std::chrono::seconds(10);
+
+void PeakEwmaLatencyEstimator::putLatency(std::chrono::microseconds latency, MonotonicTime now) {
+  const double sample = latency.count();
+  const double estimate = estimate_.load(std::memory_order_relaxed);
+  if (sample > estimate) {
+    estimate_.store(sample, std::memory_order_relaxed);
+  } else {
+    const double weight = decay(now);
+    estimate_.store(estimate * weight + sample * (1 - weight), std::memory_order_relaxed);
+  }
+  last_update_.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+double PeakEwmaLatencyEstimator::estimate(MonotonicTime now) const {
+  return estimate_.load(std::memory_order_relaxed) * decay(now);
+}
+
+double PeakEwmaLatencyEstimator::decay(MonotonicTime now) const {
+  const MonotonicTime last_update{
+      MonotonicTime::duration(last_update_.load(std::memory_order_relaxed))};
+  // Another worker may have recorded a latency after now was read.
+  if (now <= last_update) {
+    return 1;
+  }
+  const std::chrono::duration<double, std::micro> elapsed = now - last_update;
+  return std::exp(-elapsed.count() / DecayTime.count());
+}
+
 void HostImpl::weight(uint32_t new_weight) { weight_ = std::max(1U, std::min(128U, new_weight)); }
 
 HostsPerLocalityConstSharedPtr
@@ -281,6 +312,7 @@ ClusterInfoImpl::ClusterInfoImpl(const envoy::api::v2::Cluster& config,
       stats_(generateStats(*stats_scope_)),
       load_report_stats_(generateLoadReportStats(load_report_stats_store_)),
       features_(parseFeatures(config)),
+      http1_settings_(Http::Utility::parseHttp1Settings(config.http_protocol_options())),
       http2_settings_(Http::Utility::parseHttp2Settings(config.http2_protocol_options())),
       resource_managers_(config, runtime, name_),
       maintenance_mode_runtime_key_(fmt::format("upstream.maintenance_mode.{}", name_)),
@@ -336,6 +368,9 @@ ClusterInfoImpl::ClusterInfoImpl(const envoy::api::v2::Cluster& config,
   case envoy::api::v2::Cluster::MAGLEV:
     lb_type_ = LoadBalancerType::Maglev;
     break;
+  case envoy::api::v2::Cluster::PEAK_EWMA:
+    lb_type_ = LoadBalancerType::PeakEwma;
+    break;
   default:
     NOT_REACHED;
   }
@@ -569,12 +604,11 @@ void ClusterImplBase::reloadHealthyHosts() {
   }
 
   for (auto& host_set : prioritySet().hostSetsPerPriority()) {
-    // TODO(htuch): Can we skip these copies by exporting out const shared_ptr from HostSet?
-    HostVectorConstSharedPtr hosts_copy(new HostVector(host_set->hosts()));
-    HostsPerLocalityConstSharedPtr hosts_per_locality_copy = host_set->hostsPerLocality().clone();
+    // Only the healthy hosts change, so the host vectors are shared with the new update.
     host_set->updateHosts(
-        hosts_copy, createHealthyHostList(host_set->hosts()), hosts_per_locality_copy,
-        createHealthyHostLists(host_set->hostsPerLocality()), host_set->localityWeights(), {}, {});
+        host_set->hostsPtr(), createHealthyHostList(host_set->hosts()),
+        host_set->hostsPerLocalityPtr(), createHealthyHostLists(host_set->hostsPerLocality()),
+        host_set->localityWeights(), {}, {});
   }
 }
 
@@ -696,54 +730,54 @@ bool BaseDynamicClusterImpl::updateDynamicHostList(const HostVector& new_hosts,
   bool health_changed = false;
 
   // Go through and see if the list we have is different from what we just got. If it is, we make a
-  // new host list and raise a change notification. This uses an N^2 search given that this does not
-  // happen very often and the list sizes should be small (see
-  // https://github.com/envoyproxy/envoy/issues/2874). We also check for duplicates here. It's
-  // possible for DNS to return the same address multiple times, and a bad SDS implementation could
-  // do the same thing.
+  // new host list and raise a change notification. The current hosts are indexed by address, so
+  // that this costs time linear in the number of hosts even for large clusters with frequent
+  // updates. We also check for duplicates here. It's possible for DNS to return the same address
+  // multiple times, and a bad SDS implementation could do the same thing.
+  std::unordered_map<std::string, size_t> current_host_indexes;
+  current_host_indexes.reserve(current_hosts.size());
+  for (size_t i = 0; i < current_hosts.size(); ++i) {
+    current_host_indexes.emplace(current_hosts[i]->address()->asString(), i);
+  }
+  std::vector<bool> current_host_kept(current_hosts.size());
+
   std::unordered_set<std::string> host_addresses;
   HostVector final_hosts;
   for (const HostSharedPtr& host : new_hosts) {
-    if (host_addresses.count(host->address()->asString())) {
+    const std::string& address = host->address()->asString();
+    if (!host_addresses.emplace(address).second) {
       continue;
     }
-    host_addresses.emplace(host->address()->asString());
 
-    bool found = false;
-    for (auto i = current_hosts.begin(); i != current_hosts.end();) {
+    const auto current_host_index = current_host_indexes.find(address);
+    if (current_host_index != current_host_indexes.end()) {
       // If we find a host matched based on address, we keep it. However we do change weight inline
       // so do that here.
-      if (*(*i)->address() == *host->address()) {
-        if (host->weight() > max_host_weight) {
-          max_host_weight = host->weight();
-        }
+      const HostSharedPtr& current_host = current_hosts[current_host_index->second];
+      if (host->weight() > max_host_weight) {
+        max_host_weight = host->weight();
+      }
 
-        if ((*i)->healthFlagGet(Host::HealthFlag::FAILED_EDS_HEALTH) !=
-            host->healthFlagGet(Host::HealthFlag::FAILED_EDS_HEALTH)) {
-          const bool previously_healthy = (*i)->healthy();
-          if (host->healthFlagGet(Host::HealthFlag::FAILED_EDS_HEALTH)) {
-            (*i)->healthFlagSet(Host::HealthFlag::FAILED_EDS_HEALTH);
-            // If the host was previously healthy and we're now unhealthy, we need to
-            // rebuild.
-            health_changed |= previously_healthy;
-          } else {
-            (*i)->healthFlagClear(Host::HealthFlag::FAILED_EDS_HEALTH);
-            // If the host was previously unhealthy and now healthy, we need to
-            // rebuild.
-            health_changed |= !previously_healthy && (*i)->healthy();
-          }
+      if (current_host->healthFlagGet(Host::HealthFlag::FAILED_EDS_HEALTH) !=
+          host->healthFlagGet(Host::HealthFlag::FAILED_EDS_HEALTH)) {
+        const bool previously_healthy = current_host->healthy();
+        if (host->healthFlagGet(Host::HealthFlag::FAILED_EDS_HEALTH)) {
+          current_host->healthFlagSet(Host::HealthFlag::FAILED_EDS_HEALTH);
+          // If the host was previously healthy and we're now unhealthy, we need to
+          // rebuild.
+          health_changed |= previously_healthy;
+        } else {
+          current_host->healthFlagClear(Host::HealthFlag::FAILED_EDS_HEALTH);
+          // If the host was previously unhealthy and now healthy, we need to
+          // rebuild.
+          health_changed |= !previously_healthy && current_host->healthy();
         }
-
-        (*i)->weight(host->weight());
-        final_hosts.push_back(*i);
-        i = current_hosts.erase(i);
-        found = true;
-      } else {
-        i++;
       }
-    }
 
-    if (!found) {
+      current_host->weight(host->weight());
+      final_hosts.push_back(current_host);
+      current_host_kept[current_host_index->second] = true;
+    } else {
       if (host->weight() > max_host_weight) {
         max_host_weight = host->weight();
       }
@@ -758,22 +792,32 @@ bool BaseDynamicClusterImpl::updateDynamicHostList(const HostVector& new_hosts,
     }
   }
 
+  // Leave only the hosts that are not in the new list in current_hosts, in their original order.
+  HostVector hosts_not_found;
+  for (size_t i = 0; i < current_hosts.size(); ++i) {
+    if (!current_host_kept[i]) {
+      hosts_not_found.push_back(std::move(current_hosts[i]));
+    }
+  }
+  current_hosts = std::move(hosts_not_found);
+
   const bool dont_remove_healthy_hosts =
       health_checker_ != nullptr && !info()->drainConnectionsOnHostRemoval();
   // If there are removed hosts, check to see if we should only delete if unhealthy.
   if (!current_hosts.empty() && dont_remove_healthy_hosts) {
-    for (auto i = current_hosts.begin(); i != current_hosts.end();) {
-      if (!(*i)->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC)) {
-        if ((*i)->weight() > max_host_weight) {
-          max_host_weight = (*i)->weight();
+    HostVector unhealthy_hosts;
+    for (HostSharedPtr& host : current_hosts) {
+      if (!host->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC)) {
+        if (host->weight() > max_host_weight) {
+          max_host_weight = host->weight();
         }
 
-        final_hosts.push_back(*i);
-        i = current_hosts.erase(i);
+        final_hosts.push_back(std::move(host));
       } else {
-        i++;
+        unhealthy_hosts.push_back(std::move(host));
       }
     }
+    current_hosts = std::move(unhealthy_hosts);
   }
 
   // TODO(mattklein123): This stat is used by both the RR and LR load balancer to decide at
@@ -50,6 +50,31 @@ public:
   void setUnhealthy() override {}
 };
 
+/**
+ * Peak EWMA latency estimator, as used by Finagle's and linkerd's latency aware load balancers.
+ * The estimate jumps to any latency above it, and otherwise moves towards each latency and decays
+ * towards 0 between latencies, with a time constant of DecayTime. Hosts are shared by the workers,
+ * so the state is kept in relaxed atomics rather than under a lock: a latency recorded by one
+ * worker while another records one may be lost, which a moving average tolerates.
+ */
+class PeakEwmaLatencyEstimator : public LatencyEstimator {
+public:
+  // Upstream::LatencyEstimator
+  void putLatency(std::chrono::microseconds latency, MonotonicTime now) override;
+  double estimate(MonotonicTime now) const override;
+
+  static const std::chrono::microseconds DecayTime;
+
+private:
+  /**
+   * @return the factor that the estimate decays by from its last update to now.
+   */
+  double decay(MonotonicTime now) const;
+
+  std::atomic<double> estimate_{};
+  std::atomic<MonotonicTime::rep> last_update_{};
+};
+
 /**
  * Implementation of Upstream::HostDescription.
  */
@@ -95,6 +120,7 @@ public:
       return *null_outlier_detector;
     }
   }
+  LatencyEstimator& latencyEstimator() const override { return latency_estimator_; }
   const HostStats& stats() const override { return stats_; }
   const std::string& hostname() const override { return hostname_; }
   Network::Address::InstanceConstSharedPtr address() const override { return address_; }
@@ -115,6 +141,7 @@ protected:
   HostStats stats_;
   Outlier::DetectorHostMonitorPtr outlier_detector_;
   HealthCheckHostMonitorPtr health_checker_;
+  mutable PeakEwmaLatencyEstimator latency_estimator_;
 };
 
 /**
@@ -231,6 +258,14 @@ public:
   const HostsPerLocality& healthyHostsPerLocality() const override {
     return *healthy_hosts_per_locality_;
   }
+  HostVectorConstSharedPtr hostsPtr() const override { return hosts_; }
+  HostVectorConstSharedPtr healthyHostsPtr() const override { return healthy_hosts_; }
+  HostsPerLocalityConstSharedPtr hostsPerLocalityPtr() const override {
+    return hosts_per_locality_;
+  }
+  HostsPerLocalityConstSharedPtr healthyHostsPerLocalityPtr() const override {
+    return healthy_hosts_per_locality_;
+  }
   LocalityWeightsConstSharedPtr localityWeights() const override { return locality_weights_; }
   absl::optional<uint32_t> chooseLocality() override;
   uint32_t priority() const override { return priority_; }
@@ -331,6 +366,7 @@ public:
     return per_connection_buffer_limit_bytes_;
   }
   uint64_t features() const override { return features_; }
+  const Http::Http1Settings& http1Settings() const override { return http1_settings_; }
   const Http::Http2Settings& http2Settings() const override { return http2_settings_; }
   LoadBalancerType lbType() const override { return lb_type_; }
   envoy::api::v2::Cluster::DiscoveryType type() const override { return type_; }
@@ -391,6 +427,7 @@ private:
   mutable ClusterLoadReportStats load_report_stats_;
   Network::TransportSocketFactoryPtr transport_socket_factory_;
   const uint64_t features_;
+  const Http::Http1Settings http1_settings_;
   const Http::Http2Settings http2_settings_;
   mutable ResourceManagers resource_managers_;
   const std::string maintenance_mode_runtime_key_;
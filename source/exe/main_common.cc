@@ -3,6 +3,7 @@
 #include <iostream>
 #include <memory>
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/compiler_requirements.h"
 #include "common/common/perf_annotation.h"
 #include "common/event/libevent.h"
@@ -42,6 +43,7 @@ MainCommonBase::MainCommonBase(OptionsImpl& options) : options_(options) {
   ares_library_init(ARES_LIB_INIT_ALL);
   Event::Libevent::Global::initialize();
   RELEASE_ASSERT(Envoy::Server::validateProtoDescriptors());
+  Buffer::OwnedImpl::useOldImpl(options_.libeventBuffersEnabled());
 
   Stats::RawStatData::configure(options_);
   switch (options_.mode()) {
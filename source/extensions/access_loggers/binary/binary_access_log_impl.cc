@@ -0,0 +1,120 @@
+#include "extensions/access_loggers/binary/binary_access_log_impl.h"
+
+#include <atomic>
+
+#include "envoy/common/exception.h"
+
+#include "common/common/fmt.h"
+#include "common/http/header_map_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Binary {
+
+RingFileSet::RingFileSet(const std::string& path, uint64_t file_size_bytes,
+                         ThreadLocal::SlotAllocator& tls, Api::OsSysCalls& os_sys_calls)
+    : file_size_bytes_(file_size_bytes), tls_slot_(tls.allocateSlot()) {
+  // One block of the file holds its header.
+  const uint64_t num_blocks = file_size_bytes / RingFileWriter::DefaultBlockSize - 1;
+  std::shared_ptr<std::atomic<uint32_t>> next_index = std::make_shared<std::atomic<uint32_t>>(0);
+
+  tls_slot_->set([path, num_blocks, &os_sys_calls,
+                  next_index](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    std::shared_ptr<ThreadLocalWriter> writer = std::make_shared<ThreadLocalWriter>();
+    while (writer->writer_ == nullptr && writer->error_.empty()) {
+      const std::string file_path = fmt::format("{}.{}", path, (*next_index)++);
+      try {
+        writer->writer_ = std::make_unique<RingFileWriter>(
+            file_path, RingFileWriter::DefaultBlockSize, num_blocks, os_sys_calls);
+      } catch (const RingFileLockedException& e) {
+        // The file is still written by another process, e.g. the parent during a hot restart.
+        ENVOY_LOG(debug, "binary access log: {}", e.what());
+      } catch (const EnvoyException& e) {
+        // The thread's records are dropped and counted.
+        ENVOY_LOG(error, "binary access log: {}", e.what());
+        writer->error_ = e.what();
+      }
+    }
+    return writer;
+  });
+
+  // The main thread's file is opened synchronously, so a bad path fails the configuration.
+  const ThreadLocalWriter& main_thread_writer = tls_slot_->getTyped<ThreadLocalWriter>();
+  if (main_thread_writer.writer_ == nullptr) {
+    throw EnvoyException(main_thread_writer.error_);
+  }
+}
+
+bool RingFileSet::write(absl::string_view record) {
+  ThreadLocalWriter& writer = tls_slot_->getTyped<ThreadLocalWriter>();
+  return writer.writer_ != nullptr && writer.writer_->write(record);
+}
+
+RingFileSetSharedPtr RingFileSetManager::get(const std::string& path, uint64_t file_size_bytes) {
+  RingFileSetSharedPtr ring_files = ring_file_sets_[path].lock();
+  if (ring_files != nullptr) {
+    if (ring_files->fileSizeBytes() != file_size_bytes) {
+      throw EnvoyException(fmt::format(
+          "binary access log '{}' is in use with a file size of {} bytes, not {} bytes", path,
+          ring_files->fileSizeBytes(), file_size_bytes));
+    }
+    return ring_files;
+  }
+
+  ring_files = std::make_shared<RingFileSet>(path, file_size_bytes, tls_, os_sys_calls_);
+  ring_file_sets_[path] = ring_files;
+  return ring_files;
+}
+
+BinaryAccessLog::BinaryAccessLog(AccessLog::FilterPtr&& filter,
+                                 const envoy::config::accesslog::v2::BinaryAccessLog& config,
+                                 RingFileSetSharedPtr ring_files, Stats::Scope& scope)
+    : filter_(std::move(filter)),
+      entry_builder_(config.additional_request_headers_to_log(),
+                     config.additional_response_headers_to_log(),
+                     config.additional_response_trailers_to_log()),
+      ring_files_(ring_files),
+      stats_{ALL_BINARY_ACCESS_LOG_STATS(POOL_COUNTER_PREFIX(scope, "access_log.binary."))} {}
+
+void BinaryAccessLog::log(const Http::HeaderMap* request_headers,
+                          const Http::HeaderMap* response_headers,
+                          const Http::HeaderMap* response_trailers,
+                          const RequestInfo::RequestInfo& request_info) {
+  static Http::HeaderMapImpl empty_headers;
+  if (!request_headers) {
+    request_headers = &empty_headers;
+  }
+  if (!response_headers) {
+    response_headers = &empty_headers;
+  }
+  if (!response_trailers) {
+    response_trailers = &empty_headers;
+  }
+
+  if (filter_) {
+    if (!filter_->evaluate(request_info, *request_headers)) {
+      return;
+    }
+  }
+
+  // The entry and the record are reused by each thread, so that they keep the memory they have
+  // allocated between requests.
+  static thread_local envoy::data::accesslog::v2::HTTPAccessLogEntry log_entry;
+  static thread_local std::string record;
+  log_entry.Clear();
+  entry_builder_.build(*request_headers, *response_headers, *response_trailers, request_info,
+                       log_entry);
+  log_entry.SerializeToString(&record);
+
+  if (ring_files_->write(record)) {
+    stats_.records_written_.inc();
+  } else {
+    stats_.records_dropped_.inc();
+  }
+}
+
+} // namespace Binary
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "envoy/access_log/access_log.h"
+#include "envoy/api/os_sys_calls.h"
+#include "envoy/config/accesslog/v2/binary.pb.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/common/logger.h"
+
+#include "extensions/access_loggers/binary/ring_file.h"
+#include "extensions/access_loggers/common/http_log_entry_builder.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Binary {
+
+/**
+ * All binary access log stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_BINARY_ACCESS_LOG_STATS(COUNTER)                                                       \
+  COUNTER(records_written)                                                                         \
+  COUNTER(records_dropped)
+// clang-format on
+
+/**
+ * Struct definition for all binary access log stats. @see stats_macros.h
+ */
+struct BinaryAccessLogStats {
+  ALL_BINARY_ACCESS_LOG_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * The ring files written for a binary access log path. Each thread writes its own file, named by
+ * appending '.' and an index to the path, so threads never contend. The index is assigned when
+ * the thread's file is opened, starting at 0 for the main thread. Files locked by the writers of
+ * another process, such as the parent during a hot restart, are skipped.
+ */
+class RingFileSet : Logger::Loggable<Logger::Id::file> {
+public:
+  /**
+   * Open the ring file of every thread.
+   * @param path supplies the path the file names are made from.
+   * @param file_size_bytes supplies the size of each thread's file.
+   * @param tls supplies the slot allocator used to give each thread its file.
+   * @param os_sys_calls supplies the system calls used to create and map the files.
+   * @throw EnvoyException if the main thread's file cannot be opened.
+   */
+  RingFileSet(const std::string& path, uint64_t file_size_bytes, ThreadLocal::SlotAllocator& tls,
+              Api::OsSysCalls& os_sys_calls);
+
+  /**
+   * Append a record to the calling thread's ring file.
+   * @param record supplies the record.
+   * @return bool false if the record was dropped, because it is too large or the thread's file
+   *         could not be opened.
+   */
+  bool write(absl::string_view record);
+
+  uint64_t fileSizeBytes() const { return file_size_bytes_; }
+
+private:
+  struct ThreadLocalWriter : public ThreadLocal::ThreadLocalObject {
+    RingFileWriterPtr writer_;
+    std::string error_;
+  };
+
+  const uint64_t file_size_bytes_;
+  ThreadLocal::SlotPtr tls_slot_;
+};
+
+typedef std::shared_ptr<RingFileSet> RingFileSetSharedPtr;
+
+/**
+ * Gives the binary access logs that write to the same path the same RingFileSet, so that each
+ * ring file has a single writer even while a listener update replaces one log with another.
+ * Only used on the main thread.
+ */
+class RingFileSetManager : public Singleton::Instance {
+public:
+  RingFileSetManager(ThreadLocal::SlotAllocator& tls, Api::OsSysCalls& os_sys_calls)
+      : tls_(tls), os_sys_calls_(os_sys_calls) {}
+
+  /**
+   * @param path supplies the path of the access log.
+   * @param file_size_bytes supplies the size of each thread's file.
+   * @return RingFileSetSharedPtr the files of the path, opened if no other log is using them.
+   * @throw EnvoyException if the files cannot be opened, or are in use with a different size.
+   */
+  RingFileSetSharedPtr get(const std::string& path, uint64_t file_size_bytes);
+
+private:
+  ThreadLocal::SlotAllocator& tls_;
+  Api::OsSysCalls& os_sys_calls_;
+  std::unordered_map<std::string, std::weak_ptr<RingFileSet>> ring_file_sets_;
+};
+
+typedef std::shared_ptr<RingFileSetManager> RingFileSetManagerSharedPtr;
+
+/**
+ * Access log Instance that writes HTTPAccessLogEntry protos, as length-prefixed binary records,
+ * into per-thread memory-mapped ring files. Logging a request never formats text, takes a lock or
+ * makes a system call.
+ */
+class BinaryAccessLog : public AccessLog::Instance {
+public:
+  BinaryAccessLog(AccessLog::FilterPtr&& filter,
+                  const envoy::config::accesslog::v2::BinaryAccessLog& config,
+                  RingFileSetSharedPtr ring_files, Stats::Scope& scope);
+
+  // AccessLog::Instance
+  void log(const Http::HeaderMap* request_headers, const Http::HeaderMap* response_headers,
+           const Http::HeaderMap* response_trailers,
+           const RequestInfo::RequestInfo& request_info) override;
+
+private:
+  AccessLog::FilterPtr filter_;
+  const Common::HttpLogEntryBuilder entry_builder_;
+  RingFileSetSharedPtr ring_files_;
+  BinaryAccessLogStats stats_;
+};
+
+} // namespace Binary
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
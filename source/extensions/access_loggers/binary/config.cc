@@ -0,0 +1,72 @@
+#include "extensions/access_loggers/binary/config.h"
+
+#include "envoy/common/exception.h"
+#include "envoy/config/accesslog/v2/binary.pb.validate.h"
+#include "envoy/registry/registry.h"
+#include "envoy/server/filter_config.h"
+
+#include "common/api/os_sys_calls_impl.h"
+#include "common/common/fmt.h"
+#include "common/protobuf/protobuf.h"
+#include "common/protobuf/utility.h"
+
+#include "extensions/access_loggers/binary/binary_access_log_impl.h"
+#include "extensions/access_loggers/well_known_names.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Binary {
+
+namespace {
+const uint64_t DefaultFileSizeBytes = 64 * 1024 * 1024;
+// The header block and two record blocks.
+const uint64_t MinFileSizeBytes = 3 * RingFileWriter::DefaultBlockSize;
+} // namespace
+
+// Singleton registration via macro defined in envoy/singleton/manager.h
+SINGLETON_MANAGER_REGISTRATION(binary_access_log_ring_files);
+
+AccessLog::InstanceSharedPtr
+BinaryAccessLogFactory::createAccessLogInstance(const Protobuf::Message& config,
+                                                AccessLog::FilterPtr&& filter,
+                                                Server::Configuration::FactoryContext& context) {
+  const auto& proto_config =
+      MessageUtil::downcastAndValidate<const envoy::config::accesslog::v2::BinaryAccessLog&>(
+          config);
+  const uint64_t file_size_bytes =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, file_size_bytes, DefaultFileSizeBytes);
+  if (file_size_bytes < MinFileSizeBytes) {
+    throw EnvoyException(fmt::format("binary access log file_size_bytes must be at least {}",
+                                     MinFileSizeBytes));
+  }
+
+  RingFileSetManagerSharedPtr ring_file_set_manager =
+      context.singletonManager().getTyped<RingFileSetManager>(
+          SINGLETON_MANAGER_REGISTERED_NAME(binary_access_log_ring_files), [&context] {
+            return std::make_shared<RingFileSetManager>(context.threadLocal(),
+                                                        Api::OsSysCallsSingleton::get());
+          });
+
+  return std::make_shared<BinaryAccessLog>(
+      std::move(filter), proto_config,
+      ring_file_set_manager->get(proto_config.path(), file_size_bytes), context.scope());
+}
+
+ProtobufTypes::MessagePtr BinaryAccessLogFactory::createEmptyConfigProto() {
+  return ProtobufTypes::MessagePtr{new envoy::config::accesslog::v2::BinaryAccessLog()};
+}
+
+std::string BinaryAccessLogFactory::name() const { return AccessLogNames::get().BINARY; }
+
+/**
+ * Static registration for the binary access log. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<BinaryAccessLogFactory,
+                                 Server::Configuration::AccessLogInstanceFactory>
+    register_;
+
+} // namespace Binary
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
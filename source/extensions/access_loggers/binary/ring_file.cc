@@ -0,0 +1,210 @@
+#include "extensions/access_loggers/binary/ring_file.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "common/common/fmt.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Binary {
+
+constexpr char RingFileHeader::Magic[8];
+constexpr uint32_t RingFileWriter::DefaultBlockSize;
+
+RingFileWriter::RingFileWriter(const std::string& path, uint32_t block_size, uint64_t num_blocks,
+                               Api::OsSysCalls& os_sys_calls)
+    : os_sys_calls_(os_sys_calls), block_size_(block_size), num_blocks_(num_blocks),
+      mapping_size_((num_blocks + 1) * block_size) {
+  if (block_size_ <= sizeof(RingFileBlockHeader) + sizeof(uint32_t) || num_blocks_ < 2) {
+    throw EnvoyException(
+        fmt::format("ring file '{}' needs at least two blocks larger than {} bytes", path,
+                    sizeof(RingFileBlockHeader) + sizeof(uint32_t)));
+  }
+
+  fd_ = os_sys_calls_.open(path, O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP);
+  if (fd_ == -1) {
+    throw EnvoyException(fmt::format("unable to open ring file '{}': {}", path, strerror(errno)));
+  }
+
+  // The lock is released when the file is closed, including when the process exits.
+  if (os_sys_calls_.flock(fd_, LOCK_EX | LOCK_NB) == -1) {
+    const int error = errno;
+    os_sys_calls_.close(fd_);
+    if (error == EWOULDBLOCK) {
+      throw RingFileLockedException(
+          fmt::format("ring file '{}' is locked by another writer", path));
+    }
+    throw EnvoyException(fmt::format("unable to lock ring file '{}': {}", path, strerror(error)));
+  }
+
+  // Growing the file zero fills it, so blocks that were not in the file are never written blocks.
+  struct stat info;
+  if (os_sys_calls_.fstat(fd_, &info) == -1 ||
+      (static_cast<size_t>(info.st_size) != mapping_size_ &&
+       os_sys_calls_.ftruncate(fd_, mapping_size_) == -1)) {
+    const int error = errno;
+    os_sys_calls_.close(fd_);
+    throw EnvoyException(fmt::format("unable to size ring file '{}': {}", path, strerror(error)));
+  }
+
+  // The file may be sparse. Writing to a page of the mapping that no disk space can be allocated
+  // for raises SIGBUS, so all of it is allocated now, while a full disk can still be reported.
+  const int allocate_error = os_sys_calls_.posixFallocate(fd_, 0, mapping_size_);
+  if (allocate_error != 0) {
+    os_sys_calls_.close(fd_);
+    throw EnvoyException(
+        fmt::format("unable to allocate ring file '{}': {}", path, strerror(allocate_error)));
+  }
+
+  void* mapping =
+      os_sys_calls_.mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (mapping == MAP_FAILED) {
+    const int error = errno;
+    os_sys_calls_.close(fd_);
+    throw EnvoyException(fmt::format("unable to map ring file '{}': {}", path, strerror(error)));
+  }
+  mapping_ = static_cast<char*>(mapping);
+
+  const RingFileHeader& header = *reinterpret_cast<const RingFileHeader*>(mapping_);
+  if (static_cast<size_t>(info.st_size) == mapping_size_ &&
+      memcmp(header.magic_, RingFileHeader::Magic, sizeof(header.magic_)) == 0 &&
+      header.block_size_ == block_size_ && header.num_blocks_ == num_blocks_) {
+    resume();
+  } else {
+    initialize();
+  }
+}
+
+RingFileWriter::~RingFileWriter() {
+  os_sys_calls_.munmap(mapping_, mapping_size_);
+  os_sys_calls_.close(fd_);
+}
+
+void RingFileWriter::initialize() {
+  // The magic is written last, so that a file that was being initialized when the process stopped
+  // is initialized again rather than resumed with garbage blocks.
+  memset(mapping_, 0, sizeof(RingFileHeader));
+  for (uint64_t i = 0; i < num_blocks_; ++i) {
+    memset(&block(i), 0, sizeof(RingFileBlockHeader));
+  }
+
+  RingFileHeader& header = *reinterpret_cast<RingFileHeader*>(mapping_);
+  header.block_size_ = block_size_;
+  header.num_blocks_ = num_blocks_;
+  memcpy(header.magic_, RingFileHeader::Magic, sizeof(header.magic_));
+  startBlock(0, 1);
+}
+
+void RingFileWriter::resume() {
+  // Carry on writing in the most recently started block.
+  uint64_t latest = 0;
+  for (uint64_t i = 0; i < num_blocks_; ++i) {
+    if (block(i).sequence_ > block(latest).sequence_) {
+      latest = i;
+    }
+  }
+
+  RingFileBlockHeader& latest_block = block(latest);
+  if (latest_block.sequence_ == 0) {
+    startBlock(0, 1);
+    return;
+  }
+  current_block_ = latest;
+  sequence_ = latest_block.sequence_;
+  if (latest_block.used_ > block_size_ - sizeof(RingFileBlockHeader)) {
+    // The process stopped mid-update. Start afresh in the next block rather than trust it.
+    startBlock((latest + 1) % num_blocks_, sequence_ + 1);
+  }
+}
+
+void RingFileWriter::startBlock(uint64_t index, uint64_t sequence) {
+  RingFileBlockHeader& header = block(index);
+  // Empty the block before stamping it, so that a reader never attributes the records of the old
+  // block to the new sequence number.
+  header.used_ = 0;
+  header.sequence_ = sequence;
+  current_block_ = index;
+  sequence_ = sequence;
+}
+
+bool RingFileWriter::write(absl::string_view record) {
+  if (record.size() > maxRecordSize()) {
+    return false;
+  }
+
+  const uint32_t record_size = sizeof(uint32_t) + record.size();
+  if (block(current_block_).used_ + record_size > block_size_ - sizeof(RingFileBlockHeader)) {
+    startBlock((current_block_ + 1) % num_blocks_, sequence_ + 1);
+  }
+
+  RingFileBlockHeader& header = block(current_block_);
+  char* dest = reinterpret_cast<char*>(&header) + sizeof(RingFileBlockHeader) + header.used_;
+  const uint32_t length = record.size();
+  memcpy(dest, &length, sizeof(length));
+  memcpy(dest + sizeof(length), record.data(), record.size());
+  // The record is only counted once it has been copied in full.
+  header.used_ += record_size;
+  return true;
+}
+
+void RingFileReader::forEachRecord(absl::string_view contents, const RecordCb& cb) {
+  RingFileHeader header;
+  if (contents.size() < sizeof(header)) {
+    throw EnvoyException("not a ring file: too short");
+  }
+  memcpy(&header, contents.data(), sizeof(header));
+  if (memcmp(header.magic_, RingFileHeader::Magic, sizeof(header.magic_)) != 0) {
+    throw EnvoyException("not a ring file: bad magic");
+  }
+  // Nothing is added to num_blocks_, which may hold any value if the header is corrupt.
+  if (header.block_size_ <= sizeof(RingFileBlockHeader) ||
+      header.num_blocks_ >= contents.size() / header.block_size_) {
+    throw EnvoyException("not a ring file: truncated");
+  }
+
+  // Order the written blocks by sequence number.
+  typedef std::pair<uint64_t, absl::string_view> SequencedBlock;
+  std::vector<SequencedBlock> blocks;
+  for (uint64_t i = 0; i < header.num_blocks_; ++i) {
+    const absl::string_view block = contents.substr((i + 1) * header.block_size_,
+                                                    header.block_size_);
+    RingFileBlockHeader block_header;
+    memcpy(&block_header, block.data(), sizeof(block_header));
+    if (block_header.sequence_ == 0) {
+      continue;
+    }
+    const size_t used = std::min<size_t>(block_header.used_,
+                                         header.block_size_ - sizeof(RingFileBlockHeader));
+    blocks.emplace_back(block_header.sequence_, block.substr(sizeof(block_header), used));
+  }
+  std::sort(blocks.begin(), blocks.end(),
+            [](const SequencedBlock& lhs, const SequencedBlock& rhs) {
+              return lhs.first < rhs.first;
+            });
+
+  for (const auto& block : blocks) {
+    absl::string_view records = block.second;
+    while (records.size() >= sizeof(uint32_t)) {
+      uint32_t length;
+      memcpy(&length, records.data(), sizeof(length));
+      records.remove_prefix(sizeof(length));
+      if (length > records.size()) {
+        break;
+      }
+      cb(records.substr(0, length));
+      records.remove_prefix(length);
+    }
+  }
+}
+
+} // namespace Binary
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "envoy/api/os_sys_calls.h"
+#include "envoy/common/exception.h"
+
+#include "common/common/non_copyable.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Binary {
+
+/**
+ * Layout of a ring file. The file is made of fixed size blocks. The first block holds only the
+ * file header, and the others hold records. A block header is followed by length-prefixed records:
+ * a native-endian uint32_t length, then that many bytes. Records never span blocks.
+ *
+ * The writer fills one block at a time. When a block is full it moves on to the next block,
+ * wrapping around to the first record block after the last, and overwrites it. Each block is
+ * stamped with an increasing sequence number when the writer moves to it, so that a reader can put
+ * the blocks back in order. A sequence number of 0 marks a block that was never written.
+ */
+struct RingFileHeader {
+  static constexpr char Magic[8] = {'E', 'N', 'V', 'B', 'L', 'O', 'G', '1'};
+
+  char magic_[8];
+  uint32_t block_size_;
+  uint32_t reserved_;
+  uint64_t num_blocks_; // Number of record blocks, excluding the header block.
+};
+
+struct RingFileBlockHeader {
+  uint64_t sequence_;
+  uint32_t used_; // Bytes of records after the block header.
+  uint32_t reserved_;
+};
+
+static_assert(sizeof(RingFileHeader) == 24, "RingFileHeader is part of the file format");
+static_assert(sizeof(RingFileBlockHeader) == 16, "RingFileBlockHeader is part of the file format");
+
+/**
+ * Thrown when a ring file cannot be written because another writer holds its lock.
+ */
+class RingFileLockedException : public EnvoyException {
+public:
+  RingFileLockedException(const std::string& message) : EnvoyException(message) {}
+};
+
+/**
+ * Appends records to a memory-mapped ring file. The whole file is allocated and mapped when the
+ * writer is created, so writing a record is a copy into the mapping. The kernel writes the pages
+ * back to the file, so records survive a crash of the process but not of the host.
+ *
+ * A writer is used by a single thread. It holds an exclusive lock on its file for as long as it
+ * exists, so that no two writers, in this or another process, write the same file at the same
+ * time.
+ */
+class RingFileWriter : NonCopyable {
+public:
+  static constexpr uint32_t DefaultBlockSize = 64 * 1024;
+
+  /**
+   * Open a ring file, creating it if it does not exist. An existing file with the same layout is
+   * appended to, after its most recently written record. Any other existing file is overwritten.
+   * @param path supplies the path of the file.
+   * @param block_size supplies the size of each block. Records larger than a block, less the block
+   *        header and length prefix, cannot be written.
+   * @param num_blocks supplies the number of record blocks. At least two are needed.
+   * @param os_sys_calls supplies the system calls used to create and map the file.
+   * @throw RingFileLockedException if another writer holds the lock of the file.
+   * @throw EnvoyException if the file cannot be created, allocated or mapped.
+   */
+  RingFileWriter(const std::string& path, uint32_t block_size, uint64_t num_blocks,
+                 Api::OsSysCalls& os_sys_calls);
+  ~RingFileWriter();
+
+  /**
+   * Append a record.
+   * @param record supplies the record.
+   * @return bool false if the record is too large to fit in a block, in which case it is dropped.
+   */
+  bool write(absl::string_view record);
+
+  /**
+   * @return uint64_t the size of the largest record that can be written.
+   */
+  uint64_t maxRecordSize() const {
+    return block_size_ - sizeof(RingFileBlockHeader) - sizeof(uint32_t);
+  }
+
+private:
+  RingFileBlockHeader& block(uint64_t index) {
+    return *reinterpret_cast<RingFileBlockHeader*>(mapping_ + (index + 1) * block_size_);
+  }
+  void initialize();
+  void resume();
+  void startBlock(uint64_t index, uint64_t sequence);
+
+  Api::OsSysCalls& os_sys_calls_;
+  const uint32_t block_size_;
+  const uint64_t num_blocks_;
+  const size_t mapping_size_;
+  int fd_{-1};
+  char* mapping_{};
+  uint64_t current_block_{};
+  uint64_t sequence_{};
+};
+
+typedef std::unique_ptr<RingFileWriter> RingFileWriterPtr;
+
+/**
+ * Reads the records of a ring file.
+ */
+class RingFileReader {
+public:
+  typedef std::function<void(absl::string_view record)> RecordCb;
+
+  /**
+   * Call a function for each record of a ring file, oldest first. The blocks of a file that is
+   * being written may be caught mid-update; records that do not fit in their block are skipped.
+   * @param contents supplies the contents of the file.
+   * @param cb supplies the function to call with each record.
+   * @throw EnvoyException if the contents are not a ring file.
+   */
+  static void forEachRecord(absl::string_view contents, const RecordCb& cb);
+};
+
+} // namespace Binary
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
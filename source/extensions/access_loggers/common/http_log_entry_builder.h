@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+#include "envoy/data/accesslog/v2/accesslog.pb.h"
+#include "envoy/http/header_map.h"
+#include "envoy/request_info/request_info.h"
+
+#include "common/protobuf/protobuf.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Common {
+
+/**
+ * Fills in the HTTPAccessLogEntry for a request. Shared by the access logs that emit the data
+ * access log protos.
+ */
+class HttpLogEntryBuilder {
+public:
+  /**
+   * @param request_headers_to_log supplies the request headers to add to the entry.
+   * @param response_headers_to_log supplies the response headers to add to the entry.
+   * @param response_trailers_to_log supplies the response trailers to add to the entry.
+   */
+  HttpLogEntryBuilder(
+      const Protobuf::RepeatedPtrField<ProtobufTypes::String>& request_headers_to_log,
+      const Protobuf::RepeatedPtrField<ProtobufTypes::String>& response_headers_to_log,
+      const Protobuf::RepeatedPtrField<ProtobufTypes::String>& response_trailers_to_log);
+
+  static void responseFlagsToAccessLogResponseFlags(
+      envoy::data::accesslog::v2::AccessLogCommon& common_access_log,
+      const RequestInfo::RequestInfo& request_info);
+
+  /**
+   * Fill in the entry for a request.
+   * @param log_entry supplies the entry to fill in.
+   */
+  void build(const Http::HeaderMap& request_headers, const Http::HeaderMap& response_headers,
+             const Http::HeaderMap& response_trailers,
+             const RequestInfo::RequestInfo& request_info,
+             envoy::data::accesslog::v2::HTTPAccessLogEntry& log_entry) const;
+
+private:
+  std::vector<Http::LowerCaseString> request_headers_to_log_;
+  std::vector<Http::LowerCaseString> response_headers_to_log_;
+  std::vector<Http::LowerCaseString> response_trailers_to_log_;
+};
+
+} // namespace Common
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
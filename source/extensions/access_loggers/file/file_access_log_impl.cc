@@ -7,6 +7,10 @@ namespace Extensions {
 namespace AccessLoggers {
 namespace File {
 
+namespace {
+const size_t MaxRetainedLogLineCapacity = 64 * 1024;
+} // namespace
+
 FileAccessLog::FileAccessLog(const std::string& access_log_path, AccessLog::FilterPtr&& filter,
                              AccessLog::FormatterPtr&& formatter,
                              AccessLog::AccessLogManager& log_manager)
@@ -35,8 +39,17 @@ void FileAccessLog::log(const Http::HeaderMap* request_headers,
     }
   }
 
-  log_file_->write(
-      formatter_->format(*request_headers, *response_headers, *response_trailers, request_info));
+  // Each worker formats into its own line, which keeps its capacity between requests so that
+  // steady state logging does not allocate for the line itself.
+  static thread_local std::string log_line;
+  log_line.clear();
+  formatter_->formatInto(*request_headers, *response_headers, *response_trailers, request_info,
+                         log_line);
+  log_file_->write(log_line);
+  if (log_line.capacity() > MaxRetainedLogLineCapacity) {
+    // Don't hold on to the memory of an unusually long line.
+    std::string().swap(log_line);
+  }
 }
 
 } // namespace File
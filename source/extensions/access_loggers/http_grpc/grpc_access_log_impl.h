@@ -13,6 +13,8 @@
 #include "envoy/singleton/instance.h"
 #include "envoy/thread_local/thread_local.h"
 
+#include "extensions/access_loggers/common/http_log_entry_builder.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace AccessLoggers {
@@ -117,10 +119,6 @@ public:
                     const envoy::config::accesslog::v2::HttpGrpcAccessLogConfig& config,
                     GrpcAccessLogStreamerSharedPtr grpc_access_log_streamer);
 
-  static void responseFlagsToAccessLogResponseFlags(
-      envoy::data::accesslog::v2::AccessLogCommon& common_access_log,
-      const RequestInfo::RequestInfo& request_info);
-
   // AccessLog::Instance
   void log(const Http::HeaderMap* request_headers, const Http::HeaderMap* response_headers,
            const Http::HeaderMap* response_trailers,
@@ -130,9 +128,7 @@ private:
   AccessLog::FilterPtr filter_;
   const envoy::config::accesslog::v2::HttpGrpcAccessLogConfig config_;
   GrpcAccessLogStreamerSharedPtr grpc_access_log_streamer_;
-  std::vector<Http::LowerCaseString> request_headers_to_log_;
-  std::vector<Http::LowerCaseString> response_headers_to_log_;
-  std::vector<Http::LowerCaseString> response_trailers_to_log_;
+  const Common::HttpLogEntryBuilder entry_builder_;
 };
 
 } // namespace HttpGrpc
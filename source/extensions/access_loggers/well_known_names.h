@@ -16,6 +16,8 @@ public:
   const std::string FILE = "envoy.file_access_log";
   // HTTP gRPC access log
   const std::string HTTP_GRPC = "envoy.http_grpc_access_log";
+  // Binary access log
+  const std::string BINARY = "envoy.access_loggers.binary";
 };
 
 typedef ConstSingleton<AccessLogNameValues> AccessLogNames;
@@ -42,6 +42,8 @@ public:
   void addBufferFragment(Buffer::BufferFragment&) override { NOT_IMPLEMENTED; }
   void add(const std::string&) override { NOT_IMPLEMENTED; }
   void add(const Buffer::Instance&) override { NOT_IMPLEMENTED; }
+  void prepend(absl::string_view) override { NOT_IMPLEMENTED; }
+  void prepend(Buffer::Instance&) override { NOT_IMPLEMENTED; }
   void commit(Buffer::RawSlice*, uint64_t) override { NOT_IMPLEMENTED; }
   uint64_t getRawSlices(Buffer::RawSlice*, uint64_t) const override { NOT_IMPLEMENTED; }
   void move(Buffer::Instance&) override { NOT_IMPLEMENTED; }
@@ -1,27 +1,38 @@
 #include "extensions/transport_sockets/raw_buffer/config.h"
 
+#include "envoy/config/transport_socket/raw_buffer/v2alpha/raw_buffer.pb.h"
+#include "envoy/config/transport_socket/raw_buffer/v2alpha/raw_buffer.pb.validate.h"
 #include "envoy/registry/registry.h"
 
 #include "common/network/raw_buffer_socket.h"
+#include "common/protobuf/utility.h"
 
 namespace Envoy {
 namespace Extensions {
 namespace TransportSockets {
 namespace RawBuffer {
 
+Network::TransportSocketFactoryPtr
+RawBufferSocketFactory::createFactory(const Protobuf::Message& message) {
+  const auto& config = MessageUtil::downcastAndValidate<
+      const envoy::config::transport_socket::raw_buffer::v2alpha::RawBuffer&>(message);
+  return std::make_unique<Network::RawBufferSocketFactory>(
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, zero_copy_min_bytes, 0));
+}
+
 Network::TransportSocketFactoryPtr UpstreamRawBufferSocketFactory::createTransportSocketFactory(
-    const Protobuf::Message&, Server::Configuration::TransportSocketFactoryContext&) {
-  return std::make_unique<Network::RawBufferSocketFactory>();
+    const Protobuf::Message& message, Server::Configuration::TransportSocketFactoryContext&) {
+  return createFactory(message);
 }
 
 Network::TransportSocketFactoryPtr DownstreamRawBufferSocketFactory::createTransportSocketFactory(
-    const Protobuf::Message&, Server::Configuration::TransportSocketFactoryContext&,
+    const Protobuf::Message& message, Server::Configuration::TransportSocketFactoryContext&,
     const std::vector<std::string>&) {
-  return std::make_unique<Network::RawBufferSocketFactory>();
+  return createFactory(message);
 }
 
 ProtobufTypes::MessagePtr RawBufferSocketFactory::createEmptyConfigProto() {
-  return std::make_unique<ProtobufWkt::Empty>();
+  return std::make_unique<envoy::config::transport_socket::raw_buffer::v2alpha::RawBuffer>();
 }
 
 static Registry::RegisterFactory<UpstreamRawBufferSocketFactory,
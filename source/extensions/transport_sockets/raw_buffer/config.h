@@ -18,6 +18,9 @@ public:
   virtual ~RawBufferSocketFactory() {}
   std::string name() const override { return TransportSocketNames::get().RAW_BUFFER; }
   ProtobufTypes::MessagePtr createEmptyConfigProto() override;
+
+protected:
+  Network::TransportSocketFactoryPtr createFactory(const Protobuf::Message& message);
 };
 
 class UpstreamRawBufferSocketFactory
@@ -105,6 +105,9 @@ OptionsImpl::OptionsImpl(int argc, const char* const* argv,
                                              cmd);
   TCLAP::SwitchArg disable_hot_restart("", "disable-hot-restart",
                                        "Disable hot restart functionality", cmd, false);
+  TCLAP::ValueArg<bool> use_libevent_buffers("", "use-libevent-buffers",
+                                             "Use the original libevent buffer implementation",
+                                             false, true, "bool", cmd);
 
   cmd.setExceptionHandling(false);
   try {
@@ -139,6 +142,7 @@ OptionsImpl::OptionsImpl(int argc, const char* const* argv,
   // TODO(jmarantz): should we also multiply these to bound the total amount of memory?
 
   hot_restart_disabled_ = disable_hot_restart.getValue();
+  libevent_buffers_enabled_ = use_libevent_buffers.getValue();
 
   log_level_ = default_log_level;
   for (size_t i = 0; i < ARRAY_SIZE(spdlog::level::level_names); i++) {
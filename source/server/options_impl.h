@@ -66,6 +66,9 @@ public:
   void setHotRestartDisabled(bool hot_restart_disabled) {
     hot_restart_disabled_ = hot_restart_disabled;
   }
+  void setLibeventBuffersEnabled(bool libevent_buffers_enabled) {
+    libevent_buffers_enabled_ = libevent_buffers_enabled;
+  }
 
   // Server::Options
   uint64_t baseId() const override { return base_id_; }
@@ -93,6 +96,7 @@ public:
   uint64_t maxStats() const override { return max_stats_; }
   uint64_t maxObjNameLength() const override { return max_obj_name_length_; }
   bool hotRestartDisabled() const override { return hot_restart_disabled_; }
+  bool libeventBuffersEnabled() const override { return libevent_buffers_enabled_; }
 
 private:
   uint64_t base_id_;
@@ -116,6 +120,7 @@ private:
   uint64_t max_stats_;
   uint64_t max_obj_name_length_;
   bool hot_restart_disabled_;
+  bool libevent_buffers_enabled_;
 };
 
 /**
@@ -54,7 +54,7 @@ InstanceImpl::InstanceImpl(Options& options, Network::Address::InstanceConstShar
       singleton_manager_(new Singleton::ManagerImpl()),
       handler_(new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher_)),
       random_generator_(std::move(random_generator)), listener_component_factory_(*this),
-      worker_factory_(thread_local_, *api_, hooks),
+      worker_factory_(thread_local_, *api_, hooks, store),
       secret_manager_(new Secret::SecretManagerImpl()),
       dns_resolver_(dispatcher_->createDnsResolver({})),
       access_log_manager_(*api_, *dispatcher_, access_log_lock, store), terminated_(false) {
@@ -215,6 +215,7 @@ void InstanceImpl::initialize(Options& options,
 
   server_stats_.reset(
       new ServerStats{ALL_SERVER_STATS(POOL_GAUGE_PREFIX(stats_store_, "server."))});
+  dispatcher_->initializeStats(stats_store_, "server.");
 
   failHealthcheck(false);
 
@@ -446,6 +446,22 @@ TEST(AccessLogFormatterTest, CompositeFormatterSuccess) {
   }
 }
 
+TEST(AccessLogFormatterTest, CompositeFormatterInto) {
+  RequestInfo::MockRequestInfo request_info;
+  Http::TestHeaderMapImpl request_header{{"first", "GET"}, {":path", "/"}};
+  Http::TestHeaderMapImpl response_header;
+  Http::TestHeaderMapImpl response_trailer;
+  EXPECT_CALL(request_info, bytesSent()).WillRepeatedly(Return(1234));
+  FormatterImpl formatter("%REQ(FIRST)% %REQ(:PATH):0% %BYTES_SENT%\n");
+
+  // The line is appended to what the output already holds.
+  std::string output = "previous\n";
+  formatter.formatInto(request_header, response_header, response_trailer, request_info, output);
+  EXPECT_EQ("previous\nGET  1234\n", output);
+  EXPECT_EQ("GET  1234\n",
+            formatter.format(request_header, response_header, response_trailer, request_info));
+}
+
 TEST(AccessLogFormatterTest, ParserFailures) {
   AccessLogFormatParser parser;
 
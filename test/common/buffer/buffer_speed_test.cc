@@ -0,0 +1,196 @@
+#include "common/buffer/buffer_impl.h"
+
+#include "absl/strings/string_view.h"
+#include "testing/base/public/benchmark.h"
+
+namespace Envoy {
+
+// The benchmarks in this file take an argument selecting the buffer implementation:
+// 0 for the evbuffer-backed implementation, 1 for the native slice-based implementation.
+static void setBufferImpl(benchmark::State& state) {
+  Buffer::OwnedImpl::useOldImpl(state.range(0) == 0);
+}
+
+static const std::string& requestHeaders() {
+  static const std::string* headers = new std::string(
+      "GET /api/v1/resource?id=12345 HTTP/1.1\r\n"
+      "Host: service.example.com\r\n"
+      "User-Agent: benchmark/1.0\r\n"
+      "Accept: */*\r\n"
+      "Accept-Encoding: gzip, deflate\r\n"
+      "X-Request-Id: 2e1c9a6d-1f7a-4bb9-8f4f-6a0e5c2a8a11\r\n"
+      "X-Forwarded-For: 203.0.113.1\r\n"
+      "\r\n");
+  return *headers;
+}
+
+// Test the creation of an empty OwnedImpl.
+static void BM_BufferCreate(benchmark::State& state) {
+  setBufferImpl(state);
+  uint64_t length = 0;
+  for (auto _ : state) {
+    Buffer::OwnedImpl buffer;
+    length += buffer.length();
+  }
+  benchmark::DoNotOptimize(length);
+}
+BENCHMARK(BM_BufferCreate)->Arg(0)->Arg(1);
+
+// Test the performance of OwnedImpl::add() with a variety of data sizes.
+static void BM_BufferAdd(benchmark::State& state) {
+  setBufferImpl(state);
+  const std::string data(state.range(1), 'a');
+  Buffer::OwnedImpl buffer;
+  for (auto _ : state) {
+    buffer.add(data);
+    if (buffer.length() >= 1024 * 1024) {
+      buffer.drain(buffer.length());
+    }
+  }
+  benchmark::DoNotOptimize(buffer.length());
+}
+BENCHMARK(BM_BufferAdd)
+    ->Args({0, 1})
+    ->Args({1, 1})
+    ->Args({0, 128})
+    ->Args({1, 128})
+    ->Args({0, 4096})
+    ->Args({1, 4096})
+    ->Args({0, 16384})
+    ->Args({1, 16384});
+
+// Test the performance of OwnedImpl::prepend() with a small header.
+static void BM_BufferPrepend(benchmark::State& state) {
+  setBufferImpl(state);
+  const std::string body(state.range(1), 'b');
+  const absl::string_view prefix("0123456789");
+  for (auto _ : state) {
+    Buffer::OwnedImpl buffer(body);
+    buffer.prepend(prefix);
+    benchmark::DoNotOptimize(buffer.length());
+  }
+}
+BENCHMARK(BM_BufferPrepend)->Args({0, 128})->Args({1, 128})->Args({0, 16384})->Args({1, 16384});
+
+// Test moving data between buffers, as done by filters that pass data through unchanged.
+static void BM_BufferMove(benchmark::State& state) {
+  setBufferImpl(state);
+  const std::string data(state.range(1), 'c');
+  Buffer::OwnedImpl buffer1(data);
+  Buffer::OwnedImpl buffer2;
+  for (auto _ : state) {
+    buffer2.move(buffer1);
+    buffer1.move(buffer2);
+  }
+  benchmark::DoNotOptimize(buffer1.length());
+}
+BENCHMARK(BM_BufferMove)->Args({0, 128})->Args({1, 128})->Args({0, 65536})->Args({1, 65536});
+
+// Test linearize() on a buffer built from several fragments, as done by codecs that need a
+// contiguous frame header.
+static void BM_BufferLinearize(benchmark::State& state) {
+  setBufferImpl(state);
+  const std::string data(1024, 'd');
+  for (auto _ : state) {
+    Buffer::OwnedImpl buffer;
+    Buffer::OwnedImpl chunk;
+    for (int i = 0; i < 16; i++) {
+      chunk.add(data);
+      buffer.move(chunk);
+    }
+    benchmark::DoNotOptimize(buffer.linearize(static_cast<uint32_t>(state.range(1))));
+  }
+}
+BENCHMARK(BM_BufferLinearize)->Args({0, 16})->Args({1, 16})->Args({0, 8192})->Args({1, 8192});
+
+// Simulate the HTTP/1 proxy data path for a small request: the request is read from the socket
+// into a read buffer via reserve()/commit(), the end of the headers is located with search(),
+// the headers are drained and the body is moved to the upstream write buffer, which is then
+// drained as if written to the socket.
+static void BM_Http1ProxyPattern(benchmark::State& state) {
+  setBufferImpl(state);
+  const std::string body(state.range(1), 'e');
+  const std::string request = requestHeaders() + body;
+  for (auto _ : state) {
+    Buffer::OwnedImpl read_buffer;
+    Buffer::OwnedImpl write_buffer;
+
+    // "Read" the request from the socket.
+    Buffer::RawSlice iovecs[2];
+    uint64_t remaining = request.size();
+    const char* src = request.data();
+    while (remaining != 0) {
+      const uint64_t num_iovecs = read_buffer.reserve(16384, iovecs, 2);
+      uint64_t num_to_commit = 0;
+      for (uint64_t i = 0; i < num_iovecs && remaining != 0; i++) {
+        const uint64_t to_copy = std::min<uint64_t>(iovecs[i].len_, remaining);
+        memcpy(iovecs[i].mem_, src, to_copy);
+        iovecs[i].len_ = to_copy;
+        src += to_copy;
+        remaining -= to_copy;
+        num_to_commit++;
+      }
+      read_buffer.commit(iovecs, num_to_commit);
+    }
+
+    // "Parse" and re-encode the headers, then pass through the body.
+    const ssize_t headers_end = read_buffer.search("\r\n\r\n", 4, 0);
+    const uint64_t headers_size = headers_end + 4;
+    std::string header_block(headers_size, 0);
+    read_buffer.copyOut(0, headers_size, &header_block[0]);
+    read_buffer.drain(headers_size);
+    write_buffer.add(header_block);
+    write_buffer.move(read_buffer);
+
+    // "Write" the request to the upstream socket in 16KB chunks.
+    while (write_buffer.length() != 0) {
+      Buffer::RawSlice slices[16];
+      const uint64_t num_slices = std::min<uint64_t>(write_buffer.getRawSlices(slices, 16), 16);
+      uint64_t written = 0;
+      for (uint64_t i = 0; i < num_slices && written < 16384; i++) {
+        written += std::min<uint64_t>(slices[i].len_, 16384 - written);
+      }
+      write_buffer.drain(written);
+    }
+  }
+}
+BENCHMARK(BM_Http1ProxyPattern)
+    ->Args({0, 0})
+    ->Args({1, 0})
+    ->Args({0, 1024})
+    ->Args({1, 1024})
+    ->Args({0, 65536})
+    ->Args({1, 65536});
+
+// Simulate the HTTP/2 data path: the codec produces a 9-byte frame header for each DATA frame
+// and moves up to 16KB of payload from the stream's buffer into the connection's write buffer,
+// which is then drained as if written to the socket.
+static void BM_Http2ProxyPattern(benchmark::State& state) {
+  setBufferImpl(state);
+  const std::string body(state.range(1), 'f');
+  const char frame_header[9] = {0, 0x40, 0, 0, 1, 0, 0, 0, 1};
+  Buffer::OwnedImpl write_buffer;
+  for (auto _ : state) {
+    Buffer::OwnedImpl stream_buffer(body);
+    while (stream_buffer.length() != 0) {
+      const uint64_t frame_size = std::min<uint64_t>(stream_buffer.length(), 16384);
+      write_buffer.add(frame_header, sizeof(frame_header));
+      Buffer::OwnedImpl frame;
+      frame.move(stream_buffer, frame_size);
+      write_buffer.move(frame);
+    }
+    write_buffer.drain(write_buffer.length());
+  }
+}
+BENCHMARK(BM_Http2ProxyPattern)->Args({0, 128})->Args({1, 128})->Args({0, 65536})->Args({1, 65536});
+
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
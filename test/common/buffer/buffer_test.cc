@@ -0,0 +1,255 @@
+#include "common/buffer/buffer_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Buffer {
+namespace {
+
+class DummySlice : public Slice {
+public:
+  DummySlice(const std::string& data, const std::function<void()>& deletion_callback)
+      : Slice(0, data.size(), data.size()), deletion_callback_(deletion_callback) {
+    base_ = reinterpret_cast<uint8_t*>(const_cast<char*>(data.c_str()));
+  }
+  ~DummySlice() override {
+    if (deletion_callback_ != nullptr) {
+      deletion_callback_();
+    }
+  }
+
+private:
+  const std::function<void()> deletion_callback_;
+};
+
+TEST(OwnedSliceTest, Create) {
+  static constexpr uint64_t Sizes[] = {0, 1, 64, 4096 - sizeof(OwnedSlice), 65535};
+  for (const auto size : Sizes) {
+    auto slice = OwnedSlice::create(size);
+    EXPECT_NE(nullptr, slice->data());
+    EXPECT_EQ(0, slice->dataSize());
+    EXPECT_LE(size, slice->reservableSize());
+    // Slices are allocated in whole pages, including the slice header and pool block header.
+    EXPECT_EQ(0, (slice->reservableSize() + sizeof(OwnedSlice) + SlicePool::BlockOverhead) %
+                     OwnedSlice::PageSize);
+  }
+}
+
+TEST(OwnedSliceTest, CreateWithData) {
+  static constexpr char input[] = "hello world";
+  auto slice = OwnedSlice::create(input, sizeof(input) - 1);
+  EXPECT_EQ(sizeof(input) - 1, slice->dataSize());
+  EXPECT_EQ(0, memcmp(slice->data(), input, slice->dataSize()));
+}
+
+TEST(OwnedSliceTest, ReserveCommit) {
+  auto slice = OwnedSlice::create(100);
+  const uint64_t initial_capacity = slice->reservableSize();
+  EXPECT_LE(100, initial_capacity);
+
+  {
+    // Verify that a zero-byte reservation is rejected.
+    RawSlice reservation = slice->reserve(0);
+    EXPECT_EQ(nullptr, reservation.mem_);
+    EXPECT_EQ(0, reservation.len_);
+  }
+
+  {
+    // Create a reservation smaller than the reservable size.
+    RawSlice reservation = slice->reserve(10);
+    EXPECT_NE(nullptr, reservation.mem_);
+    EXPECT_EQ(slice->data(), reservation.mem_);
+    EXPECT_EQ(10, reservation.len_);
+    EXPECT_EQ(0, slice->dataSize());
+    EXPECT_EQ(initial_capacity, slice->reservableSize());
+    bool committed = slice->commit(reservation);
+    EXPECT_TRUE(committed);
+    EXPECT_EQ(10, slice->dataSize());
+    EXPECT_EQ(initial_capacity - 10, slice->reservableSize());
+  }
+
+  {
+    // Commit a reservation that doesn't belong to the slice.
+    char other[10];
+    RawSlice reservation{other, sizeof(other)};
+    EXPECT_FALSE(slice->commit(reservation));
+    EXPECT_EQ(10, slice->dataSize());
+  }
+
+  {
+    // Create a reservation larger than the reservable size.
+    RawSlice reservation = slice->reserve(initial_capacity);
+    EXPECT_NE(nullptr, reservation.mem_);
+    EXPECT_EQ(slice->data() + 10, reservation.mem_);
+    EXPECT_EQ(initial_capacity - 10, reservation.len_);
+    // Commit only part of the reservation.
+    reservation.len_ = 5;
+    EXPECT_TRUE(slice->commit(reservation));
+    EXPECT_EQ(15, slice->dataSize());
+    EXPECT_EQ(initial_capacity - 15, slice->reservableSize());
+  }
+
+  {
+    // Fill the rest of the slice, then verify that no more space can be reserved.
+    RawSlice reservation = slice->reserve(initial_capacity);
+    EXPECT_TRUE(slice->commit(reservation));
+    EXPECT_EQ(initial_capacity, slice->dataSize());
+    EXPECT_EQ(0, slice->reservableSize());
+    reservation = slice->reserve(1);
+    EXPECT_EQ(nullptr, reservation.mem_);
+    EXPECT_EQ(0, reservation.len_);
+  }
+}
+
+TEST(OwnedSliceTest, Drain) {
+  // Create a slice and commit all the available space.
+  auto slice = OwnedSlice::create(100);
+  RawSlice reservation = slice->reserve(slice->reservableSize());
+  EXPECT_TRUE(slice->commit(reservation));
+  const uint64_t capacity = slice->dataSize();
+
+  // Drain some data from the front of the view and verify that the data start moves accordingly.
+  const uint8_t* original_data = static_cast<const uint8_t*>(slice->data());
+  slice->drain(0);
+  EXPECT_EQ(original_data, slice->data());
+  EXPECT_EQ(capacity, slice->dataSize());
+  slice->drain(10);
+  EXPECT_EQ(original_data + 10, slice->data());
+  EXPECT_EQ(capacity - 10, slice->dataSize());
+  slice->drain(capacity - 10);
+  EXPECT_EQ(0, slice->dataSize());
+  EXPECT_EQ(0, slice->reservableSize());
+}
+
+TEST(OwnedSliceTest, AppendPrepend) {
+  auto slice = OwnedSlice::create(1);
+  const uint64_t capacity = slice->reservableSize();
+
+  // Prepend into an empty slice puts the data at the end, leaving room for further prepends.
+  EXPECT_EQ(5, slice->prepend("world", 5));
+  EXPECT_EQ(0, slice->reservableSize());
+  EXPECT_EQ(7, slice->prepend("hello, ", 7));
+  EXPECT_EQ("hello, world",
+            std::string(reinterpret_cast<const char*>(slice->data()), slice->dataSize()));
+
+  // The slice has no space at the end, so nothing can be appended.
+  EXPECT_EQ(0, slice->append("!", 1));
+
+  // Prepend more data than fits; only the last bytes are copied.
+  const std::string filler(capacity, 'x');
+  EXPECT_EQ(capacity - 12, slice->prepend(filler.data(), filler.size()));
+  EXPECT_EQ(capacity, slice->dataSize());
+
+  auto slice2 = OwnedSlice::create(1);
+  EXPECT_EQ(5, slice2->append("hello", 5));
+  // There is no drained space at the front, so nothing can be prepended.
+  EXPECT_EQ(0, slice2->prepend("x", 1));
+  slice2->drain(2);
+  EXPECT_EQ(2, slice2->prepend("abc", 3));
+  EXPECT_EQ("bcllo",
+            std::string(reinterpret_cast<const char*>(slice2->data()), slice2->dataSize()));
+}
+
+TEST(UnownedSliceTest, CreateDelete) {
+  constexpr char input[] = "hello world";
+  bool release_callback_called = false;
+  BufferFragmentImpl fragment(
+      input, sizeof(input) - 1,
+      [&release_callback_called](const void*, size_t, const BufferFragmentImpl*) {
+        release_callback_called = true;
+      });
+  auto slice = std::make_unique<UnownedSlice>(fragment);
+  EXPECT_EQ(11, slice->dataSize());
+  EXPECT_EQ(0, slice->reservableSize());
+  EXPECT_EQ(0, memcmp(slice->data(), input, slice->dataSize()));
+  EXPECT_EQ(0, slice->append("x", 1));
+  EXPECT_EQ(0, slice->prepend("x", 1));
+  EXPECT_FALSE(release_callback_called);
+  slice.reset(nullptr);
+  EXPECT_TRUE(release_callback_called);
+}
+
+TEST(SliceDequeTest, CreateDelete) {
+  bool slice1_deleted = false;
+  bool slice2_deleted = false;
+  bool slice3_deleted = false;
+
+  {
+    // Create an empty deque.
+    SliceDeque slices;
+    EXPECT_TRUE(slices.empty());
+    EXPECT_EQ(0, slices.size());
+
+    // Append a slice and verify that the deque is no longer empty.
+    SlicePtr slice1(new DummySlice("slice1", [&slice1_deleted]() { slice1_deleted = true; }));
+    slices.emplace_back(std::move(slice1));
+    EXPECT_FALSE(slices.empty());
+    ASSERT_EQ(1, slices.size());
+    EXPECT_FALSE(slice1_deleted);
+    EXPECT_EQ(6, slices.front()->dataSize());
+
+    // Append another slice and verify the size.
+    SlicePtr slice2(new DummySlice("slice2", [&slice2_deleted]() { slice2_deleted = true; }));
+    slices.emplace_back(std::move(slice2));
+    EXPECT_FALSE(slices.empty());
+    ASSERT_EQ(2, slices.size());
+    EXPECT_FALSE(slice2_deleted);
+
+    // Prepend a slice and verify the size.
+    SlicePtr slice3(new DummySlice("slice3", [&slice3_deleted]() { slice3_deleted = true; }));
+    slices.emplace_front(std::move(slice3));
+    EXPECT_FALSE(slices.empty());
+    ASSERT_EQ(3, slices.size());
+    EXPECT_FALSE(slice3_deleted);
+
+    // Remove the first slice and verify that it is deleted.
+    slices.pop_front();
+    EXPECT_FALSE(slices.empty());
+    ASSERT_EQ(2, slices.size());
+    EXPECT_TRUE(slice3_deleted);
+
+    // Remove the last slice and verify that it is deleted.
+    slices.pop_back();
+    EXPECT_FALSE(slices.empty());
+    ASSERT_EQ(1, slices.size());
+    EXPECT_TRUE(slice2_deleted);
+  }
+
+  // Verify that the remaining slice was deleted when the deque went out of scope.
+  EXPECT_TRUE(slice1_deleted);
+}
+
+TEST(SliceDequeTest, Grow) {
+  // Add enough slices at both ends to force the deque to move from its inline storage to an
+  // external ring, and to wrap around the ring along the way.
+  std::vector<std::string> contents;
+  for (size_t i = 0; i < 100; i++) {
+    contents.push_back(std::to_string(i));
+  }
+
+  SliceDeque slices;
+  for (size_t i = 50; i < 100; i++) {
+    slices.emplace_back(SlicePtr(new DummySlice(contents[i], nullptr)));
+  }
+  for (size_t i = 50; i > 0; i--) {
+    slices.emplace_front(SlicePtr(new DummySlice(contents[i - 1], nullptr)));
+  }
+  ASSERT_EQ(100, slices.size());
+  for (size_t i = 0; i < 100; i++) {
+    EXPECT_EQ(contents[i], std::string(reinterpret_cast<const char*>(slices[i]->data()),
+                                       slices[i]->dataSize()));
+  }
+  EXPECT_EQ(contents.front(), std::string(reinterpret_cast<const char*>(slices.front()->data()),
+                                          slices.front()->dataSize()));
+  EXPECT_EQ(contents.back(), std::string(reinterpret_cast<const char*>(slices.back()->data()),
+                                         slices.back()->dataSize()));
+
+  while (!slices.empty()) {
+    slices.pop_front();
+  }
+  EXPECT_EQ(0, slices.size());
+}
+
+} // namespace
+} // namespace Buffer
+} // namespace Envoy
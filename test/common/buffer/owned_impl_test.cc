@@ -1,6 +1,7 @@
 #include "common/api/os_sys_calls_impl.h"
 #include "common/buffer/buffer_impl.h"
 
+#include "test/common/buffer/utility.h"
 #include "test/mocks/api/mocks.h"
 #include "test/test_common/threadsafe_singleton_injector.h"
 
@@ -8,6 +9,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::Invoke;
 using testing::Return;
 using testing::_;
 
@@ -15,17 +17,19 @@ namespace Envoy {
 namespace Buffer {
 namespace {
 
-class OwnedImplTest : public testing::Test {
+class OwnedImplTest : public BufferImplementationParamTest {
 public:
-  OwnedImplTest() {}
-
   bool release_callback_called_ = false;
 };
 
-TEST_F(OwnedImplTest, AddBufferFragmentNoCleanup) {
+INSTANTIATE_TEST_CASE_P(OwnedImplTest, OwnedImplTest,
+                        testing::ValuesIn({BufferImplementation::Old, BufferImplementation::New}));
+
+TEST_P(OwnedImplTest, AddBufferFragmentNoCleanup) {
   char input[] = "hello world";
   BufferFragmentImpl frag(input, 11, nullptr);
   Buffer::OwnedImpl buffer;
+  verifyImplementation(buffer);
   buffer.addBufferFragment(frag);
   EXPECT_EQ(11, buffer.length());
 
@@ -33,12 +37,13 @@ TEST_F(OwnedImplTest, AddBufferFragmentNoCleanup) {
   EXPECT_EQ(0, buffer.length());
 }
 
-TEST_F(OwnedImplTest, AddBufferFragmentWithCleanup) {
+TEST_P(OwnedImplTest, AddBufferFragmentWithCleanup) {
   char input[] = "hello world";
   BufferFragmentImpl frag(input, 11, [this](const void*, size_t, const BufferFragmentImpl*) {
     release_callback_called_ = true;
   });
   Buffer::OwnedImpl buffer;
+  verifyImplementation(buffer);
   buffer.addBufferFragment(frag);
   EXPECT_EQ(11, buffer.length());
 
@@ -51,7 +56,7 @@ TEST_F(OwnedImplTest, AddBufferFragmentWithCleanup) {
   EXPECT_TRUE(release_callback_called_);
 }
 
-TEST_F(OwnedImplTest, AddBufferFragmentDynamicAllocation) {
+TEST_P(OwnedImplTest, AddBufferFragmentDynamicAllocation) {
   char input_stack[] = "hello world";
   char* input = new char[11];
   std::copy(input_stack, input_stack + 11, input);
@@ -76,45 +81,65 @@ TEST_F(OwnedImplTest, AddBufferFragmentDynamicAllocation) {
   EXPECT_TRUE(release_callback_called_);
 }
 
-TEST_F(OwnedImplTest, Write) {
+TEST_P(OwnedImplTest, Write) {
   Api::MockOsSysCalls os_sys_calls;
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
 
   Buffer::OwnedImpl buffer;
   buffer.add("example");
-  EXPECT_CALL(os_sys_calls, writev(_, _, _)).WillOnce(Return(7));
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _)).WillOnce(Return(7));
   int rc = buffer.write(-1);
   EXPECT_EQ(7, rc);
   EXPECT_EQ(0, buffer.length());
 
   buffer.add("example");
-  EXPECT_CALL(os_sys_calls, writev(_, _, _)).WillOnce(Return(6));
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _)).WillOnce(Return(6));
   rc = buffer.write(-1);
   EXPECT_EQ(6, rc);
   EXPECT_EQ(1, buffer.length());
 
-  EXPECT_CALL(os_sys_calls, writev(_, _, _)).WillOnce(Return(0));
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _)).WillOnce(Return(0));
   rc = buffer.write(-1);
   EXPECT_EQ(0, rc);
   EXPECT_EQ(1, buffer.length());
 
-  EXPECT_CALL(os_sys_calls, writev(_, _, _)).WillOnce(Return(-1));
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _)).WillOnce(Return(-1));
   rc = buffer.write(-1);
   EXPECT_EQ(-1, rc);
   EXPECT_EQ(1, buffer.length());
 
-  EXPECT_CALL(os_sys_calls, writev(_, _, _)).WillOnce(Return(1));
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _)).WillOnce(Return(1));
   rc = buffer.write(-1);
   EXPECT_EQ(1, rc);
   EXPECT_EQ(0, buffer.length());
 
-  EXPECT_CALL(os_sys_calls, writev(_, _, _)).Times(0);
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _)).Times(0);
   rc = buffer.write(-1);
   EXPECT_EQ(0, rc);
   EXPECT_EQ(0, buffer.length());
 }
 
-TEST_F(OwnedImplTest, Read) {
+TEST_P(OwnedImplTest, WriteGathersAllSlices) {
+  Api::MockOsSysCalls os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+
+  // Fragments are never coalesced, so each one is a separate slice.
+  constexpr int NumFragments = 100;
+  char input[] = "example";
+  std::vector<std::unique_ptr<BufferFragmentImpl>> fragments;
+  Buffer::OwnedImpl buffer;
+  verifyImplementation(buffer);
+  for (int i = 0; i < NumFragments; i++) {
+    fragments.emplace_back(new BufferFragmentImpl(input, 7, nullptr));
+    buffer.addBufferFragment(*fragments.back());
+  }
+
+  EXPECT_CALL(os_sys_calls, writev_(_, _, NumFragments)).WillOnce(Return(7 * NumFragments));
+  EXPECT_EQ(7 * NumFragments, buffer.write(-1));
+  EXPECT_EQ(0, buffer.length());
+}
+
+TEST_P(OwnedImplTest, Read) {
   Api::MockOsSysCalls os_sys_calls;
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
 
@@ -135,7 +160,7 @@ TEST_F(OwnedImplTest, Read) {
   EXPECT_EQ(0, buffer.length());
 }
 
-TEST_F(OwnedImplTest, ToString) {
+TEST_P(OwnedImplTest, ToString) {
   Buffer::OwnedImpl buffer;
   EXPECT_EQ("", buffer.toString());
   auto append = [&buffer](absl::string_view str) { buffer.add(str.data(), str.size()); };
@@ -150,6 +175,246 @@ TEST_F(OwnedImplTest, ToString) {
   EXPECT_EQ(absl::StrCat("Hello, world!" + long_string), buffer.toString());
 }
 
+TEST_P(OwnedImplTest, Prepend) {
+  const std::string suffix = "World!", prefix = "Hello, ";
+  Buffer::OwnedImpl buffer;
+  verifyImplementation(buffer);
+  buffer.add(suffix);
+  buffer.prepend(prefix);
+
+  EXPECT_EQ(suffix.size() + prefix.size(), buffer.length());
+  EXPECT_EQ(prefix + suffix, buffer.toString());
+
+  // Prepending an empty string does nothing.
+  buffer.prepend("");
+  EXPECT_EQ(prefix + suffix, buffer.toString());
+}
+
+TEST_P(OwnedImplTest, PrependLarge) {
+  // Prepend more data than fits in a single slice.
+  const std::string suffix(10, 'b');
+  const std::string prefix(3 * OwnedSlice::PageSize, 'a');
+  Buffer::OwnedImpl buffer;
+  verifyImplementation(buffer);
+  buffer.add(suffix);
+  buffer.prepend(prefix);
+  buffer.prepend("<");
+  EXPECT_EQ("<" + prefix + suffix, buffer.toString());
+}
+
+TEST_P(OwnedImplTest, PrependToEmptyBuffer) {
+  std::string data = "Hello, World!";
+  Buffer::OwnedImpl buffer;
+  verifyImplementation(buffer);
+  buffer.prepend(data);
+
+  EXPECT_EQ(data.size(), buffer.length());
+  EXPECT_EQ(data, buffer.toString());
+}
+
+TEST_P(OwnedImplTest, PrependBuffer) {
+  std::string suffix = "World!", prefix = "Hello, ";
+  Buffer::OwnedImpl buffer;
+  verifyImplementation(buffer);
+  buffer.add(suffix);
+  Buffer::OwnedImpl prefixBuffer;
+  prefixBuffer.add(prefix);
+
+  buffer.prepend(prefixBuffer);
+
+  EXPECT_EQ(suffix.size() + prefix.size(), buffer.length());
+  EXPECT_EQ(prefix + suffix, buffer.toString());
+  EXPECT_EQ(0, prefixBuffer.length());
+}
+
+TEST_P(OwnedImplTest, Move) {
+  Buffer::OwnedImpl buffer1;
+  Buffer::OwnedImpl buffer2;
+  verifyImplementation(buffer1);
+  buffer1.add("hello ");
+  buffer2.add("world");
+  buffer1.move(buffer2);
+  EXPECT_EQ("hello world", buffer1.toString());
+  EXPECT_EQ(0, buffer2.length());
+
+  // Move a large amount of data so that whole slices are transferred rather than copied.
+  const std::string large(2 * OwnedSlice::PageSize, 'x');
+  buffer2.add(large);
+  buffer1.move(buffer2);
+  EXPECT_EQ("hello world" + large, buffer1.toString());
+  EXPECT_EQ(0, buffer2.length());
+}
+
+TEST_P(OwnedImplTest, MovePartial) {
+  const std::string large(2 * OwnedSlice::PageSize, 'x');
+  Buffer::OwnedImpl buffer1;
+  Buffer::OwnedImpl buffer2;
+  verifyImplementation(buffer1);
+  buffer2.add("hello");
+  buffer2.add(large);
+  buffer1.move(buffer2, 3);
+  EXPECT_EQ("hel", buffer1.toString());
+  EXPECT_EQ("lo" + large, buffer2.toString());
+
+  buffer1.move(buffer2, 2 + OwnedSlice::PageSize);
+  EXPECT_EQ("hello" + large.substr(0, OwnedSlice::PageSize), buffer1.toString());
+  EXPECT_EQ(large.substr(OwnedSlice::PageSize), buffer2.toString());
+
+  buffer1.move(buffer2, buffer2.length());
+  EXPECT_EQ("hello" + large, buffer1.toString());
+  EXPECT_EQ(0, buffer2.length());
+}
+
+TEST_P(OwnedImplTest, CopyOutAcrossSlices) {
+  char input[] = "fragment";
+  BufferFragmentImpl frag(input, 8, nullptr);
+  Buffer::OwnedImpl buffer;
+  verifyImplementation(buffer);
+  buffer.add("abc");
+  buffer.addBufferFragment(frag);
+  buffer.add("xyz");
+
+  char out[9];
+  buffer.copyOut(2, 9, out);
+  EXPECT_EQ("cfragment", std::string(out, 9));
+  buffer.copyOut(9, 4, out);
+  EXPECT_EQ("ntxy", std::string(out, 4));
+}
+
+TEST_P(OwnedImplTest, Search) {
+  char input[] = "needle";
+  BufferFragmentImpl frag(input, 6, nullptr);
+  Buffer::OwnedImpl buffer;
+  verifyImplementation(buffer);
+  buffer.add("haystack nee");
+  buffer.addBufferFragment(frag);
+  buffer.add(" haystack");
+
+  // The first match spans two slices.
+  EXPECT_EQ(-1, buffer.search("needles", 7, 0));
+  EXPECT_EQ(12, buffer.search("needle", 6, 0));
+  EXPECT_EQ(9, buffer.search("neene", 5, 0));
+  EXPECT_EQ(19, buffer.search("haystack", 8, 1));
+  EXPECT_EQ(0, buffer.search("haystack", 8, 0));
+  EXPECT_EQ(-1, buffer.search("haystack", 8, 20));
+  EXPECT_EQ(-1, buffer.search("x", 1, 0));
+}
+
+TEST_P(OwnedImplTest, Linearize) {
+  char input[] = "fragment";
+  BufferFragmentImpl frag(input, 8, nullptr);
+  Buffer::OwnedImpl buffer;
+  verifyImplementation(buffer);
+  buffer.add("abc");
+  buffer.addBufferFragment(frag);
+  buffer.add(std::string(2 * OwnedSlice::PageSize, 'z'));
+
+  EXPECT_EQ("abc", std::string(static_cast<char*>(buffer.linearize(3)), 3));
+  EXPECT_EQ("abcfrag", std::string(static_cast<char*>(buffer.linearize(7)), 7));
+  EXPECT_EQ("abcfragmentzz", std::string(static_cast<char*>(buffer.linearize(13)), 13));
+  EXPECT_EQ(11 + 2 * OwnedSlice::PageSize, buffer.length());
+  EXPECT_EQ("abcfragment" + std::string(2 * OwnedSlice::PageSize, 'z'), buffer.toString());
+}
+
+TEST_P(OwnedImplTest, ReserveCommit) {
+  Buffer::OwnedImpl buffer;
+  verifyImplementation(buffer);
+  buffer.add("abc");
+
+  RawSlice iovecs[2];
+  const uint64_t num_reserved = buffer.reserve(100, iovecs, 2);
+  EXPECT_GE(num_reserved, 1);
+  uint64_t reserved = 0;
+  for (uint64_t i = 0; i < num_reserved; i++) {
+    reserved += iovecs[i].len_;
+  }
+  EXPECT_GE(reserved, 100);
+  EXPECT_EQ(3, buffer.length());
+
+  memcpy(iovecs[0].mem_, "def", 3);
+  iovecs[0].len_ = 3;
+  buffer.commit(iovecs, 1);
+  EXPECT_EQ("abcdef", buffer.toString());
+
+  // A reservation that is never committed doesn't change the buffer contents.
+  buffer.reserve(OwnedSlice::PageSize * 3, iovecs, 2);
+  EXPECT_EQ("abcdef", buffer.toString());
+  buffer.drain(6);
+  EXPECT_EQ(0, buffer.length());
+  EXPECT_EQ(0, buffer.getRawSlices(nullptr, 0));
+}
+
+TEST_P(OwnedImplTest, GetRawSlicesSkipsEmpty) {
+  char input[] = "";
+  BufferFragmentImpl frag(input, 0, nullptr);
+  Buffer::OwnedImpl buffer;
+  verifyImplementation(buffer);
+  buffer.add("abc");
+  buffer.addBufferFragment(frag);
+  buffer.add(std::string(OwnedSlice::PageSize, 'z'));
+
+  const uint64_t num_slices = buffer.getRawSlices(nullptr, 0);
+  RawSlice slices[num_slices];
+  EXPECT_EQ(num_slices, buffer.getRawSlices(slices, num_slices));
+  for (RawSlice& slice : slices) {
+    EXPECT_NE(0, slice.len_);
+  }
+}
+
+class OwnedImplNativeTest : public BufferImplementationParamTest {};
+
+INSTANTIATE_TEST_CASE_P(OwnedImplNativeTest, OwnedImplNativeTest,
+                        testing::ValuesIn({BufferImplementation::New}));
+
+TEST_P(OwnedImplNativeTest, WriteRetained) {
+  Api::MockOsSysCalls os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+
+  char input1[] = "aaaa";
+  char input2[] = "bbbb";
+  bool done1 = false;
+  bool done2 = false;
+  BufferFragmentImpl frag1(input1, 4, [&](const void*, size_t, const BufferFragmentImpl*) {
+    done1 = true;
+  });
+  BufferFragmentImpl frag2(input2, 4, [&](const void*, size_t, const BufferFragmentImpl*) {
+    done2 = true;
+  });
+  Buffer::OwnedImpl buffer;
+  verifyImplementation(buffer);
+  buffer.addBufferFragment(frag1);
+  buffer.addBufferFragment(frag2);
+
+  std::vector<SlicePtr> written;
+  EXPECT_CALL(os_sys_calls, sendmsg(_, _, 0))
+      .WillOnce(Invoke([](int, const msghdr* message, int) -> ssize_t {
+        EXPECT_EQ(2, message->msg_iovlen);
+        return 6;
+      }));
+  EXPECT_EQ(6, buffer.writeRetained(-1, 0, written));
+  EXPECT_EQ(2, buffer.length());
+  EXPECT_EQ("bb", buffer.toString());
+  ASSERT_EQ(2, written.size());
+  EXPECT_EQ(4, written[0]->dataSize());
+  EXPECT_EQ(2, written[1]->dataSize());
+  EXPECT_EQ(static_cast<void*>(input2), written[1]->data());
+
+  // The written memory stays alive until the caller releases it, even once the rest of the
+  // partially written slice is gone.
+  buffer.drain(2);
+  EXPECT_FALSE(done1);
+  EXPECT_FALSE(done2);
+  written.clear();
+  EXPECT_TRUE(done1);
+  EXPECT_TRUE(done2);
+
+  buffer.add("example");
+  EXPECT_CALL(os_sys_calls, sendmsg(_, _, 0)).WillOnce(Return(-1));
+  EXPECT_EQ(-1, buffer.writeRetained(-1, 0, written));
+  EXPECT_EQ(7, buffer.length());
+  EXPECT_TRUE(written.empty());
+}
+
 } // namespace
 } // namespace Buffer
 } // namespace Envoy
@@ -0,0 +1,142 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/buffer/slice_pool.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/common/buffer/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Buffer {
+namespace {
+
+TEST(SlicePoolTest, NoCurrentPool) {
+  EXPECT_EQ(nullptr, SlicePool::current());
+  void* block = SlicePool::allocate(100);
+  EXPECT_NE(nullptr, block);
+  SlicePool::release(block);
+  SlicePool::release(nullptr);
+}
+
+TEST(SlicePoolTest, ScopedInstall) {
+  SlicePool pool1;
+  SlicePool pool2;
+  {
+    ScopedSlicePool scoped1(pool1);
+    EXPECT_EQ(&pool1, SlicePool::current());
+    {
+      ScopedSlicePool scoped2(pool2);
+      EXPECT_EQ(&pool2, SlicePool::current());
+    }
+    EXPECT_EQ(&pool1, SlicePool::current());
+  }
+  EXPECT_EQ(nullptr, SlicePool::current());
+}
+
+TEST(SlicePoolTest, ReuseWithinSizeClass) {
+  Stats::IsolatedStoreImpl store;
+  SlicePool pool;
+  pool.initializeStats(store, "test.");
+  ScopedSlicePool scoped(pool);
+
+  void* block = SlicePool::allocate(100);
+  EXPECT_EQ(1UL, store.counter("test.slice_pool.misses").value());
+  SlicePool::release(block);
+  EXPECT_EQ(SlicePool::PageSize, pool.bytesRetained());
+  EXPECT_EQ(SlicePool::PageSize, store.gauge("test.slice_pool.bytes_retained").value());
+
+  // Any size in the same class is served from the cached block.
+  void* block2 = SlicePool::allocate(SlicePool::PageSize - SlicePool::BlockOverhead);
+  EXPECT_EQ(block, block2);
+  EXPECT_EQ(1UL, store.counter("test.slice_pool.hits").value());
+  EXPECT_EQ(0UL, pool.bytesRetained());
+  EXPECT_EQ(0UL, store.gauge("test.slice_pool.bytes_retained").value());
+
+  // The next size class up does not use blocks from a smaller class.
+  SlicePool::release(block2);
+  void* block3 = SlicePool::allocate(SlicePool::PageSize);
+  EXPECT_NE(block2, block3);
+  EXPECT_EQ(2UL, store.counter("test.slice_pool.misses").value());
+  SlicePool::release(block3);
+  EXPECT_EQ(3 * SlicePool::PageSize, pool.bytesRetained());
+}
+
+TEST(SlicePoolTest, ReadSizedBlocksArePooled) {
+  SlicePool pool;
+  ScopedSlicePool scoped(pool);
+
+  void* block = SlicePool::allocate(SlicePool::ReadSize + 256);
+  SlicePool::release(block);
+  EXPECT_EQ(SlicePool::NumSizeClasses * SlicePool::PageSize, pool.bytesRetained());
+  EXPECT_EQ(block, SlicePool::allocate(SlicePool::ReadSize));
+  SlicePool::release(block);
+}
+
+TEST(SlicePoolTest, LargeBlocksAreNotPooled) {
+  SlicePool pool;
+  ScopedSlicePool scoped(pool);
+
+  void* block = SlicePool::allocate(SlicePool::NumSizeClasses * SlicePool::PageSize);
+  SlicePool::release(block);
+  EXPECT_EQ(0UL, pool.bytesRetained());
+}
+
+TEST(SlicePoolTest, RetentionLimit) {
+  SlicePool pool(2 * SlicePool::PageSize);
+  ScopedSlicePool scoped(pool);
+
+  void* blocks[3];
+  for (void*& block : blocks) {
+    block = SlicePool::allocate(1);
+  }
+  for (void* block : blocks) {
+    SlicePool::release(block);
+  }
+  EXPECT_EQ(2 * SlicePool::PageSize, pool.bytesRetained());
+}
+
+TEST(SlicePoolTest, ReleaseToDifferentPool) {
+  SlicePool pool1;
+  SlicePool pool2;
+  void* block;
+  {
+    ScopedSlicePool scoped(pool1);
+    block = SlicePool::allocate(1);
+  }
+  {
+    ScopedSlicePool scoped(pool2);
+    SlicePool::release(block);
+  }
+  EXPECT_EQ(0UL, pool1.bytesRetained());
+  EXPECT_EQ(SlicePool::PageSize, pool2.bytesRetained());
+}
+
+class SlicePoolBufferTest : public BufferImplementationParamTest {};
+
+INSTANTIATE_TEST_CASE_P(SlicePoolBufferTest, SlicePoolBufferTest,
+                        testing::ValuesIn({BufferImplementation::New}));
+
+// A buffer that repeatedly reads into and drains a 16KiB reservation reuses the same slice memory.
+TEST_P(SlicePoolBufferTest, ReadSizedReservationsAreReused) {
+  Stats::IsolatedStoreImpl store;
+  SlicePool pool;
+  pool.initializeStats(store, "test.");
+  ScopedSlicePool scoped(pool);
+
+  OwnedImpl buffer;
+  verifyImplementation(buffer);
+  for (int i = 0; i < 10; i++) {
+    RawSlice iovec;
+    EXPECT_EQ(1, buffer.reserve(SlicePool::ReadSize, &iovec, 1));
+    EXPECT_GE(iovec.len_, SlicePool::ReadSize);
+    iovec.len_ = SlicePool::ReadSize;
+    buffer.commit(&iovec, 1);
+    buffer.drain(buffer.length());
+  }
+  EXPECT_EQ(1UL, store.counter("test.slice_pool.misses").value());
+  EXPECT_EQ(9UL, store.counter("test.slice_pool.hits").value());
+}
+
+} // namespace
+} // namespace Buffer
+} // namespace Envoy
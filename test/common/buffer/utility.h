@@ -0,0 +1,46 @@
+#pragma once
+
+#include "common/buffer/buffer_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Buffer {
+namespace {
+
+enum class BufferImplementation {
+  Old,
+  New,
+};
+
+/**
+ * Base class for tests that are parameterized based on BufferImplementation. Buffers created while
+ * the test is running use the implementation selected by the test parameter.
+ */
+class BufferImplementationParamTest : public testing::TestWithParam<BufferImplementation> {
+protected:
+  BufferImplementationParamTest() : previous_use_old_impl_(OwnedImpl::newBuffersUseOldImpl()) {
+    OwnedImpl::useOldImpl(GetParam() == BufferImplementation::Old);
+  }
+
+  ~BufferImplementationParamTest() override { OwnedImpl::useOldImpl(previous_use_old_impl_); }
+
+  /** Verify that a buffer has been constructed using the expected implementation. */
+  void verifyImplementation(const OwnedImpl& buffer) {
+    switch (GetParam()) {
+    case BufferImplementation::Old:
+      ASSERT_TRUE(buffer.usesOldImpl());
+      break;
+    case BufferImplementation::New:
+      ASSERT_FALSE(buffer.usesOldImpl());
+      break;
+    }
+  }
+
+private:
+  const bool previous_use_old_impl_;
+};
+
+} // namespace
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,89 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "common/common/assert.h"
+#include "common/common/regex.h"
+
+#include "absl/strings/string_view.h"
+#include "testing/base/public/benchmark.h"
+
+// NOLINT(namespace-envoy)
+
+static const char* RouteRegex = "/api/v[0-9]+/users/[0-9]+/(profile|settings)";
+
+static const std::vector<std::string>& routePaths() {
+  static const std::vector<std::string>* paths = new std::vector<std::string>{
+      "/api/v1/users/12345/profile", "/api/v2/users/1/settings", "/api/v1/users/abc/profile",
+      "/static/js/app.min.js",       "/api/v10/users/987654321/settings/extra"};
+  return *paths;
+}
+
+// The default regex for envoy.http_user_agent, before and after the removal of lookahead.
+static const char* TagRegexEcmaScript = "^http(?=\\.).*?\\.user_agent\\.((.*?)\\.)\\w+?$";
+static const char* TagRegexRe2 = "^http\\.(?:.*?\\.)??user_agent\\.((.*?)\\.)\\w+?$";
+static const char* StatName = "http.egress_dynamodb_iad.user_agent.ios.downstream_cx_total";
+
+static void BM_StdRegexRouteMatch(benchmark::State& state) {
+  const std::regex regex(RouteRegex, std::regex::optimize);
+  size_t matched = 0;
+  for (auto _ : state) {
+    for (const std::string& path : routePaths()) {
+      matched += std::regex_match(path, regex);
+    }
+  }
+  RELEASE_ASSERT(matched == 2 * state.iterations());
+}
+BENCHMARK(BM_StdRegexRouteMatch);
+
+static void BM_CompiledMatcherRouteMatch(benchmark::State& state) {
+  const Envoy::Regex::CompiledMatcherPtr regex = Envoy::Regex::Utility::parseRegex(RouteRegex);
+  size_t matched = 0;
+  for (auto _ : state) {
+    for (const std::string& path : routePaths()) {
+      matched += regex->match(path);
+    }
+  }
+  RELEASE_ASSERT(matched == 2 * state.iterations());
+}
+BENCHMARK(BM_CompiledMatcherRouteMatch);
+
+static void BM_StdRegexTagSearch(benchmark::State& state) {
+  const std::regex regex(TagRegexEcmaScript, std::regex::optimize);
+  const std::string stat_name(StatName);
+  std::smatch match;
+  size_t extracted = 0;
+  for (auto _ : state) {
+    if (std::regex_search(stat_name, match, regex)) {
+      extracted += match.length(2);
+    }
+  }
+  RELEASE_ASSERT(extracted == 3 * state.iterations());
+}
+BENCHMARK(BM_StdRegexTagSearch);
+
+static void BM_CompiledMatcherTagSearch(benchmark::State& state) {
+  const Envoy::Regex::CompiledMatcherPtr regex = Envoy::Regex::Utility::parseRegex(TagRegexRe2);
+  const absl::string_view stat_name(StatName);
+  std::vector<absl::string_view> groups;
+  size_t extracted = 0;
+  for (auto _ : state) {
+    if (regex->search(stat_name, groups)) {
+      extracted += groups[2].size();
+    }
+  }
+  RELEASE_ASSERT(extracted == 3 * state.iterations());
+}
+BENCHMARK(BM_CompiledMatcherTagSearch);
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,64 @@
+#include <string>
+#include <vector>
+
+#include "common/common/regex.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Regex {
+namespace {
+
+TEST(RegexTest, InvalidRegex) {
+  EXPECT_THROW_WITH_REGEX(Utility::parseRegex("(+invalid)"), EnvoyException,
+                          "Invalid regex '\\(\\+invalid\\)': .+");
+  // Lookaround and backreferences need backtracking, which RE2 does not support.
+  EXPECT_THROW_WITH_REGEX(Utility::parseRegex("foo(?=\\.)"), EnvoyException,
+                          "Invalid regex 'foo\\(\\?=\\\\.\\)': .+");
+  EXPECT_THROW_WITH_REGEX(Utility::parseRegex("(a)\\1"), EnvoyException, "Invalid regex");
+}
+
+TEST(RegexTest, Match) {
+  CompiledMatcherPtr regex = Utility::parseRegex("/b[io]t");
+  EXPECT_TRUE(regex->match("/bit"));
+  EXPECT_TRUE(regex->match("/bot"));
+  EXPECT_FALSE(regex->match("/bite"));
+  EXPECT_FALSE(regex->match("/bit/bot"));
+  EXPECT_FALSE(regex->match(""));
+
+  // Only the viewed part of the underlying buffer is matched.
+  const std::string path = "/bit?foo=bar";
+  EXPECT_TRUE(regex->match(absl::string_view(path.c_str(), 4)));
+}
+
+TEST(RegexTest, SearchGroups) {
+  CompiledMatcherPtr regex = Utility::parseRegex("^cluster\\.((.*?)\\.)(x)?");
+  const std::string stat_name = "cluster.foo.upstream_rq_timeout";
+  std::vector<absl::string_view> groups;
+
+  ASSERT_TRUE(regex->search(stat_name, groups));
+  ASSERT_EQ(4, groups.size());
+  EXPECT_EQ("cluster.foo.", groups[0]);
+  EXPECT_EQ("foo.", groups[1]);
+  EXPECT_EQ("foo", groups[2]);
+  EXPECT_EQ(stat_name.data() + 8, groups[1].data());
+  EXPECT_EQ(nullptr, groups[3].data());
+
+  EXPECT_FALSE(regex->search("listener.foo.bar", groups));
+}
+
+TEST(RegexTest, SearchUnanchored) {
+  CompiledMatcherPtr regex = Utility::parseRegex("_rq(_(\\d{3}))$");
+  std::vector<absl::string_view> groups;
+
+  ASSERT_TRUE(regex->search("cluster.foo.upstream_rq_200", groups));
+  EXPECT_EQ("_rq_200", groups[0]);
+  EXPECT_EQ("200", groups[2]);
+  EXPECT_FALSE(regex->search("cluster.foo.upstream_rq_200.bar", groups));
+}
+
+} // namespace
+} // namespace Regex
+} // namespace Envoy
@@ -1,5 +1,6 @@
 #include <functional>
 
+#include "common/buffer/slice_pool.h"
 #include "common/common/lock_guard.h"
 #include "common/common/thread.h"
 #include "common/event/dispatcher_impl.h"
@@ -53,6 +54,15 @@ TEST(DeferredDeleteTest, DeferredDelete) {
   dispatcher.clearDeferredDeleteList();
 }
 
+TEST(DispatcherSlicePoolTest, InstalledWhileRunning) {
+  DispatcherImpl dispatcher;
+  Buffer::SlicePool* pool_while_running = nullptr;
+  dispatcher.post([&]() -> void { pool_while_running = Buffer::SlicePool::current(); });
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  EXPECT_NE(nullptr, pool_while_running);
+  EXPECT_EQ(nullptr, Buffer::SlicePool::current());
+}
+
 class DispatcherImplTest : public ::testing::Test {
 protected:
   DispatcherImplTest() : dispatcher_(std::make_unique<DispatcherImpl>()), work_finished_(false) {
@@ -27,13 +27,25 @@ using testing::Throw;
 using testing::_;
 
 namespace Envoy {
+namespace {
+
+std::string iovecsToString(const iovec* iov, int num_iov) {
+  std::string result;
+  for (int i = 0; i < num_iov; i++) {
+    result.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+  }
+  return result;
+}
+
+} // namespace
 
 TEST(FileSystemImpl, BadFile) {
   Event::MockDispatcher dispatcher;
   Thread::MutexBasicLockable lock;
   Stats::IsolatedStoreImpl store;
   EXPECT_CALL(dispatcher, createTimer_(_));
-  EXPECT_THROW(Filesystem::FileImpl("", dispatcher, lock, store, std::chrono::milliseconds(10000)),
+  EXPECT_THROW(Filesystem::FileImpl("", dispatcher, lock, store, std::chrono::milliseconds(10000),
+                                    std::make_shared<Filesystem::FileFlusher>()),
                EnvoyException);
 }
 
@@ -114,16 +126,17 @@ TEST(FileSystemImpl, flushToLogFilePeriodically) {
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
 
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).WillOnce(Return(5));
-  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40));
+  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40),
+                            std::make_shared<Filesystem::FileFlusher>());
 
   EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(40)));
-  EXPECT_CALL(os_sys_calls, write_(_, _, _))
-      .WillOnce(Invoke([](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
-        std::string written = std::string(reinterpret_cast<const char*>(buffer), num_bytes);
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _))
+      .WillOnce(Invoke([](int fd, const iovec* iov, int num_iov) -> ssize_t {
+        const std::string written = iovecsToString(iov, num_iov);
         EXPECT_EQ("test", written);
         EXPECT_EQ(5, fd);
 
-        return num_bytes;
+        return written.size();
       }));
 
   file.write("test");
@@ -135,13 +148,13 @@ TEST(FileSystemImpl, flushToLogFilePeriodically) {
     }
   }
 
-  EXPECT_CALL(os_sys_calls, write_(_, _, _))
-      .WillOnce(Invoke([](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
-        std::string written = std::string(reinterpret_cast<const char*>(buffer), num_bytes);
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _))
+      .WillOnce(Invoke([](int fd, const iovec* iov, int num_iov) -> ssize_t {
+        const std::string written = iovecsToString(iov, num_iov);
         EXPECT_EQ("test2", written);
         EXPECT_EQ(5, fd);
 
-        return num_bytes;
+        return written.size();
       }));
 
   // make sure timer is re-enabled on callback call
@@ -167,15 +180,18 @@ TEST(FileSystemImpl, flushToLogFileOnDemand) {
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
 
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).WillOnce(Return(5));
-  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40));
+  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40),
+                            std::make_shared<Filesystem::FileFlusher>());
 
   EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(40)));
 
   // The first write to a given file will start the flush thread, which can flush
   // immediately (race on whether it will or not). So do a write and flush to
   // get that state out of the way, then test that small writes don't trigger a flush.
-  EXPECT_CALL(os_sys_calls, write_(_, _, _))
-      .WillOnce(Invoke([](int, const void*, size_t num_bytes) -> ssize_t { return num_bytes; }));
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _))
+      .WillOnce(Invoke([](int, const iovec* iov, int num_iov) -> ssize_t {
+        return iovecsToString(iov, num_iov).size();
+      }));
   file.write("prime-it");
   file.flush();
   uint32_t expected_writes = 1;
@@ -184,13 +200,13 @@ TEST(FileSystemImpl, flushToLogFileOnDemand) {
     EXPECT_EQ(expected_writes, os_sys_calls.num_writes_);
   }
 
-  EXPECT_CALL(os_sys_calls, write_(_, _, _))
-      .WillOnce(Invoke([](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
-        std::string written = std::string(reinterpret_cast<const char*>(buffer), num_bytes);
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _))
+      .WillOnce(Invoke([](int fd, const iovec* iov, int num_iov) -> ssize_t {
+        const std::string written = iovecsToString(iov, num_iov);
         EXPECT_EQ("test", written);
         EXPECT_EQ(5, fd);
 
-        return num_bytes;
+        return written.size();
       }));
 
   file.write("test");
@@ -207,13 +223,13 @@ TEST(FileSystemImpl, flushToLogFileOnDemand) {
     EXPECT_EQ(expected_writes, os_sys_calls.num_writes_);
   }
 
-  EXPECT_CALL(os_sys_calls, write_(_, _, _))
-      .WillOnce(Invoke([](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
-        std::string written = std::string(reinterpret_cast<const char*>(buffer), num_bytes);
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _))
+      .WillOnce(Invoke([](int fd, const iovec* iov, int num_iov) -> ssize_t {
+        const std::string written = iovecsToString(iov, num_iov);
         EXPECT_EQ("test2", written);
         EXPECT_EQ(5, fd);
 
-        return num_bytes;
+        return written.size();
       }));
 
   // make sure timer is re-enabled on callback call
@@ -241,16 +257,17 @@ TEST(FileSystemImpl, reopenFile) {
 
   Sequence sq;
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).InSequence(sq).WillOnce(Return(5));
-  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40));
+  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40),
+                            std::make_shared<Filesystem::FileFlusher>());
 
-  EXPECT_CALL(os_sys_calls, write_(_, _, _))
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _))
       .InSequence(sq)
-      .WillOnce(Invoke([](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
-        std::string written = std::string(reinterpret_cast<const char*>(buffer), num_bytes);
+      .WillOnce(Invoke([](int fd, const iovec* iov, int num_iov) -> ssize_t {
+        const std::string written = iovecsToString(iov, num_iov);
         EXPECT_EQ("before", written);
         EXPECT_EQ(5, fd);
 
-        return num_bytes;
+        return written.size();
       }));
 
   file.write("before");
@@ -266,14 +283,14 @@ TEST(FileSystemImpl, reopenFile) {
   EXPECT_CALL(os_sys_calls, close(5)).InSequence(sq);
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).InSequence(sq).WillOnce(Return(10));
 
-  EXPECT_CALL(os_sys_calls, write_(_, _, _))
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _))
       .InSequence(sq)
-      .WillOnce(Invoke([](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
-        std::string written = std::string(reinterpret_cast<const char*>(buffer), num_bytes);
+      .WillOnce(Invoke([](int fd, const iovec* iov, int num_iov) -> ssize_t {
+        const std::string written = iovecsToString(iov, num_iov);
         EXPECT_EQ("reopened", written);
         EXPECT_EQ(10, fd);
 
-        return num_bytes;
+        return written.size();
       }));
 
   EXPECT_CALL(os_sys_calls, close(10)).InSequence(sq);
@@ -299,18 +316,16 @@ TEST(FilesystemImpl, reopenThrows) {
   NiceMock<Api::MockOsSysCalls> os_sys_calls;
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
 
-  EXPECT_CALL(os_sys_calls, write_(_, _, _))
-      .WillRepeatedly(Invoke([](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
-        UNREFERENCED_PARAMETER(fd);
-        UNREFERENCED_PARAMETER(buffer);
-
-        return num_bytes;
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _))
+      .WillRepeatedly(Invoke([](int, const iovec* iov, int num_iov) -> ssize_t {
+        return iovecsToString(iov, num_iov).size();
       }));
 
   Sequence sq;
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).InSequence(sq).WillOnce(Return(5));
 
-  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40));
+  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40),
+                            std::make_shared<Filesystem::FileFlusher>());
   EXPECT_CALL(os_sys_calls, close(5)).InSequence(sq);
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).InSequence(sq).WillOnce(Return(-1));
 
@@ -346,17 +361,18 @@ TEST(FilesystemImpl, bigDataChunkShouldBeFlushedWithoutTimer) {
   NiceMock<Api::MockOsSysCalls> os_sys_calls;
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
 
-  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40));
+  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40),
+                            std::make_shared<Filesystem::FileFlusher>());
 
-  EXPECT_CALL(os_sys_calls, write_(_, _, _))
-      .WillOnce(Invoke([](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _))
+      .WillOnce(Invoke([](int fd, const iovec* iov, int num_iov) -> ssize_t {
         UNREFERENCED_PARAMETER(fd);
 
-        std::string written = std::string(reinterpret_cast<const char*>(buffer), num_bytes);
+        const std::string written = iovecsToString(iov, num_iov);
         std::string expected("a");
         EXPECT_EQ(expected, written);
 
-        return num_bytes;
+        return written.size();
       }));
 
   file.write("a");
@@ -370,15 +386,15 @@ TEST(FilesystemImpl, bigDataChunkShouldBeFlushedWithoutTimer) {
 
   // First write happens without waiting on thread_flush_. Now make a big string and it should be
   // flushed even when timer is not enabled
-  EXPECT_CALL(os_sys_calls, write_(_, _, _))
-      .WillOnce(Invoke([](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _))
+      .WillOnce(Invoke([](int fd, const iovec* iov, int num_iov) -> ssize_t {
         UNREFERENCED_PARAMETER(fd);
 
-        std::string written = std::string(reinterpret_cast<const char*>(buffer), num_bytes);
+        const std::string written = iovecsToString(iov, num_iov);
         std::string expected(1024 * 64 + 1, 'b');
         EXPECT_EQ(expected, written);
 
-        return num_bytes;
+        return written.size();
       }));
 
   std::string big_string(1024 * 64 + 1, 'b');
@@ -391,4 +407,100 @@ TEST(FilesystemImpl, bigDataChunkShouldBeFlushedWithoutTimer) {
     }
   }
 }
+
+// A write that is only partly completed is carried on from where it stopped.
+TEST(FilesystemImpl, shortWritesAreCompleted) {
+  NiceMock<Event::MockDispatcher> dispatcher;
+  Thread::MutexBasicLockable mutex;
+  Stats::IsolatedStoreImpl stats_store;
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+
+  EXPECT_CALL(os_sys_calls, open_(_, _, _)).WillOnce(Return(5));
+  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40),
+                            std::make_shared<Filesystem::FileFlusher>());
+
+  // Get the flush of the first write out of the way, see flushToLogFileOnDemand.
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _))
+      .WillOnce(Invoke([](int, const iovec* iov, int num_iov) -> ssize_t {
+        return iovecsToString(iov, num_iov).size();
+      }));
+  file.write("prime-it");
+  file.flush();
+
+  InSequence s;
+  EXPECT_CALL(os_sys_calls, writev_(5, _, _))
+      .WillOnce(Invoke([](int, const iovec* iov, int num_iov) -> ssize_t {
+        EXPECT_EQ("hello world", iovecsToString(iov, num_iov));
+        return 3;
+      }));
+  EXPECT_CALL(os_sys_calls, writev_(5, _, _))
+      .WillOnce(Invoke([](int, const iovec* iov, int num_iov) -> ssize_t {
+        EXPECT_EQ("lo world", iovecsToString(iov, num_iov));
+        return 8;
+      }));
+
+  file.write("hello world");
+  file.flush();
+  EXPECT_EQ(3UL, stats_store.counter("filesystem.write_completed").value());
+  EXPECT_EQ(0UL, stats_store.gauge("filesystem.write_total_buffered").value());
+}
+
+// Writes that would grow the flush buffer beyond its limit are dropped.
+TEST(FilesystemImpl, writesBeyondBufferLimitAreDropped) {
+  NiceMock<Event::MockDispatcher> dispatcher;
+  Thread::MutexBasicLockable mutex;
+  Stats::IsolatedStoreImpl stats_store;
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+
+  EXPECT_CALL(os_sys_calls, open_(_, _, _)).WillOnce(Return(5));
+  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40),
+                            std::make_shared<Filesystem::FileFlusher>());
+
+  EXPECT_CALL(os_sys_calls, writev_(_, _, _)).Times(0);
+  file.write(std::string(1024 * 1024 * 16 + 1, 'a'));
+  EXPECT_EQ(1UL, stats_store.counter("filesystem.write_dropped").value());
+  EXPECT_EQ(0UL, stats_store.counter("filesystem.write_buffered").value());
+  EXPECT_EQ(0UL, stats_store.gauge("filesystem.write_total_buffered").value());
+}
+
+// Files that share a flusher are all flushed by its thread.
+TEST(FilesystemImpl, filesShareFlusher) {
+  NiceMock<Event::MockDispatcher> dispatcher;
+  Thread::MutexBasicLockable mutex;
+  Stats::IsolatedStoreImpl stats_store;
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+  Filesystem::FileFlusherSharedPtr flusher = std::make_shared<Filesystem::FileFlusher>();
+
+  EXPECT_CALL(os_sys_calls, open_(_, _, _)).WillOnce(Return(5)).WillOnce(Return(6));
+  Filesystem::FileImpl file1("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40),
+                             flusher);
+  Filesystem::FileImpl file2("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40),
+                             flusher);
+
+  EXPECT_CALL(os_sys_calls, writev_(5, _, _))
+      .WillOnce(Invoke([](int, const iovec* iov, int num_iov) -> ssize_t {
+        const std::string written = iovecsToString(iov, num_iov);
+        EXPECT_EQ("file1", written);
+        return written.size();
+      }));
+  EXPECT_CALL(os_sys_calls, writev_(6, _, _))
+      .WillOnce(Invoke([](int, const iovec* iov, int num_iov) -> ssize_t {
+        const std::string written = iovecsToString(iov, num_iov);
+        EXPECT_EQ("file2", written);
+        return written.size();
+      }));
+
+  file1.write("file1");
+  file2.write("file2");
+
+  {
+    Thread::LockGuard lock(os_sys_calls.write_mutex_);
+    while (os_sys_calls.num_writes_ != 2) {
+      os_sys_calls.write_event_.wait(os_sys_calls.write_mutex_);
+    }
+  }
+}
 } // namespace Envoy
@@ -1686,6 +1686,123 @@ TEST_F(HttpConnectionManagerImplTest, DownstreamProtocolError) {
   conn_manager_->onData(fake_input, false);
 }
 
+TEST_F(HttpConnectionManagerImplTest, PipelinedRequestsInFlight) {
+  http1_settings_.max_pipelined_requests_ = 2;
+  setup(false, "");
+
+  std::shared_ptr<MockStreamDecoderFilter> filter(new NiceMock<MockStreamDecoderFilter>());
+  EXPECT_CALL(*filter, decodeHeaders(_, true))
+      .Times(2)
+      .WillRepeatedly(Return(FilterHeadersStatus::StopIteration));
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        callbacks.addStreamDecoderFilter(filter);
+      }));
+
+  // A complete request does not stop reading while more requests may be pipelined.
+  NiceMock<MockStreamEncoder> encoder1;
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    StreamDecoder* decoder = &conn_manager_->newStream(encoder1);
+    HeaderMapPtr headers{new TestHeaderMapImpl{{":authority", "host"}, {":path", "/"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+    data.drain(data.length());
+  }));
+  EXPECT_CALL(filter_callbacks_.connection_, readDisable(_)).Times(0);
+
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input, false);
+
+  // Once the codec leaves data in the buffer the maximum number of requests are in flight, so
+  // reading stops until a response completes.
+  NiceMock<MockStreamEncoder> encoder2;
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    StreamDecoder* decoder = &conn_manager_->newStream(encoder2);
+    HeaderMapPtr headers{new TestHeaderMapImpl{{":authority", "host"}, {":path", "/"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+    data.drain(2);
+  }));
+  EXPECT_CALL(filter_callbacks_.connection_, readDisable(true));
+
+  Buffer::OwnedImpl more_input("1234");
+  conn_manager_->onData(more_input, false);
+
+  // The other request is still in flight, so only the read-disable above is undone.
+  EXPECT_CALL(filter_callbacks_.connection_, readEnabled()).Times(0);
+  EXPECT_CALL(filter_callbacks_.connection_, readDisable(false));
+  filter->callbacks_->encodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}}, true);
+}
+
+// A pipelined stream completing must not undo the read-disable of another stream that is above
+// its high watermark.
+TEST_F(HttpConnectionManagerImplTest, PipelinedRequestAboveHighWatermark) {
+  http1_settings_.max_pipelined_requests_ = 2;
+  setup(false, "");
+
+  // Model the connection's read-disable count. HTTP/1 streams read-disable the connection.
+  int read_disables = 0;
+  ON_CALL(filter_callbacks_.connection_, readDisable(_)).WillByDefault(Invoke([&](bool disable) {
+    if (disable) {
+      read_disables++;
+    } else {
+      ASSERT_GT(read_disables, 0);
+      read_disables--;
+    }
+  }));
+  ON_CALL(filter_callbacks_.connection_, readEnabled())
+      .WillByDefault(Invoke([&]() -> bool { return read_disables == 0; }));
+  NiceMock<MockStreamEncoder> encoder1;
+  NiceMock<MockStreamEncoder> encoder2;
+  for (MockStreamEncoder* encoder : {&encoder1, &encoder2}) {
+    ON_CALL(encoder->stream_, readDisable(_)).WillByDefault(Invoke([&](bool disable) {
+      filter_callbacks_.connection_.readDisable(disable);
+    }));
+  }
+
+  std::shared_ptr<MockStreamDecoderFilter> filter1(new NiceMock<MockStreamDecoderFilter>());
+  std::shared_ptr<MockStreamDecoderFilter> filter2(new NiceMock<MockStreamDecoderFilter>());
+  EXPECT_CALL(*filter1, decodeHeaders(_, true))
+      .WillOnce(Return(FilterHeadersStatus::StopIteration));
+  EXPECT_CALL(*filter2, decodeHeaders(_, true))
+      .WillOnce(Return(FilterHeadersStatus::StopIteration));
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .WillOnce(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        callbacks.addStreamDecoderFilter(filter1);
+      }))
+      .WillOnce(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        callbacks.addStreamDecoderFilter(filter2);
+      }));
+
+  // Both requests arrive with a third behind them, so reading stops.
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    for (MockStreamEncoder* encoder : {&encoder1, &encoder2}) {
+      StreamDecoder* decoder = &conn_manager_->newStream(*encoder);
+      HeaderMapPtr headers{new TestHeaderMapImpl{{":authority", "host"}, {":path", "/"}}};
+      decoder->decodeHeaders(std::move(headers), true);
+    }
+    data.drain(2);
+  }));
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input, false);
+  EXPECT_EQ(1, read_disables);
+
+  // The upstream of the first request backs up.
+  filter1->callbacks_->onDecoderFilterAboveWriteBufferHighWatermark();
+  EXPECT_EQ(2, read_disables);
+
+  // The second request completing only undoes the read-disable of the connection manager.
+  filter2->callbacks_->encodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}},
+                                     true);
+  EXPECT_EQ(1, read_disables);
+
+  filter1->callbacks_->onDecoderFilterBelowWriteBufferLowWatermark();
+  EXPECT_EQ(0, read_disables);
+
+  filter1->callbacks_->encodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}},
+                                     true);
+  EXPECT_EQ(0, read_disables);
+}
+
 TEST_F(HttpConnectionManagerImplTest, IdleTimeoutNoCodec) {
   // Not used in the test.
   delete codec_;
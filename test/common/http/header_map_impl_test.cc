@@ -1,4 +1,5 @@
 #include <string>
+#include <vector>
 
 #include "common/http/header_map_impl.h"
 
@@ -460,6 +461,24 @@ TEST(HeaderMapImplTest, SetReferenceKey) {
   EXPECT_STREQ("monde", headers.get(foo)->value().c_str());
 }
 
+TEST(HeaderMapImplTest, AddAndSetReferenceKeyViaMove) {
+  HeaderMapImpl headers;
+  LowerCaseString foo("hello");
+  HeaderString value;
+  value.append("wor", 3);
+  value.append("ld", 2);
+  headers.addReferenceKey(foo, std::move(value));
+  EXPECT_TRUE(value.empty());
+  EXPECT_STREQ("world", headers.get(foo)->value().c_str());
+
+  HeaderString new_value;
+  new_value.append("monde", 5);
+  headers.setReferenceKey(foo, std::move(new_value));
+  EXPECT_TRUE(new_value.empty());
+  EXPECT_STREQ("monde", headers.get(foo)->value().c_str());
+  EXPECT_EQ(1UL, headers.size());
+}
+
 TEST(HeaderMapImplTest, AddCopy) {
   HeaderMapImpl headers;
 
@@ -643,6 +662,82 @@ TEST(HeaderMapImplTest, Get) {
   }
 }
 
+// Exercise lookups and removals once the map is large enough to be indexed.
+TEST(HeaderMapImplTest, ManyHeaders) {
+  TestHeaderMapImpl headers;
+  for (int i = 0; i < 64; i++) {
+    headers.addCopy("x-header-" + std::to_string(i), "value-" + std::to_string(i));
+  }
+  headers.addCopy("x-header-10", "duplicate");
+  headers.insertHost().value(std::string("host"));
+  EXPECT_EQ(66UL, headers.size());
+
+  for (int i = 0; i < 64; i++) {
+    EXPECT_EQ("value-" + std::to_string(i), headers.get_("x-header-" + std::to_string(i)));
+  }
+  EXPECT_EQ("host", headers.get_(":authority"));
+  EXPECT_FALSE(headers.has("x-header-64"));
+
+  // Removing a key removes every entry with it.
+  headers.remove("x-header-10");
+  EXPECT_FALSE(headers.has("x-header-10"));
+  EXPECT_EQ(64UL, headers.size());
+  for (int i = 11; i < 64; i++) {
+    EXPECT_EQ("value-" + std::to_string(i), headers.get_("x-header-" + std::to_string(i)));
+  }
+
+  // Removing an inline header keeps the rest of the index intact.
+  headers.removeHost();
+  EXPECT_FALSE(headers.has(":authority"));
+  EXPECT_EQ("value-63", headers.get_("x-header-63"));
+
+  headers.removePrefix(LowerCaseString("x-header-2"));
+  EXPECT_FALSE(headers.has("x-header-2"));
+  EXPECT_FALSE(headers.has("x-header-25"));
+  EXPECT_EQ("value-30", headers.get_("x-header-30"));
+  EXPECT_EQ(52UL, headers.size());
+
+  LowerCaseString key30("x-header-30");
+  headers.setReferenceKey(key30, "replaced");
+  EXPECT_EQ("replaced", headers.get_("x-header-30"));
+  EXPECT_EQ(52UL, headers.size());
+}
+
+// Removals leave holes in the underlying list, which must not show up when iterating.
+TEST(HeaderMapImplTest, RemoveMostHeaders) {
+  TestHeaderMapImpl headers;
+  for (int i = 0; i < 64; i++) {
+    headers.addCopy("x-header-" + std::to_string(i), std::to_string(i));
+  }
+  for (int i = 0; i < 64; i++) {
+    if (i % 8 != 0) {
+      headers.remove("x-header-" + std::to_string(i));
+    }
+  }
+  headers.addCopy("x-header-0", "duplicate");
+  headers.insertMethod().value(std::string("GET"));
+  EXPECT_EQ(10UL, headers.size());
+  EXPECT_EQ("0", headers.get_("x-header-0"));
+
+  std::vector<std::string> keys;
+  headers.iterate(
+      [](const Http::HeaderEntry& header, void* context) -> HeaderMap::Iterate {
+        static_cast<std::vector<std::string>*>(context)->push_back(header.key().c_str());
+        return HeaderMap::Iterate::Continue;
+      },
+      &keys);
+  EXPECT_EQ((std::vector<std::string>{":method", "x-header-0", "x-header-8", "x-header-16",
+                                      "x-header-24", "x-header-32", "x-header-40", "x-header-48",
+                                      "x-header-56", "x-header-0"}),
+            keys);
+
+  headers.removeMethod();
+  headers.remove("x-header-0");
+  EXPECT_EQ(7UL, headers.size());
+  EXPECT_FALSE(headers.has("x-header-0"));
+  EXPECT_EQ("56", headers.get_("x-header-56"));
+}
+
 TEST(HeaderMapImplTest, TestAppendHeader) {
   // Test appending to a string with a value.
   {
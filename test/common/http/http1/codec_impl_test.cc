@@ -1,4 +1,5 @@
 #include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
 #include "envoy/event/dispatcher.h"
@@ -27,8 +28,10 @@ namespace Envoy {
 namespace Http {
 namespace Http1 {
 
-class Http1ServerConnectionImplTest : public ::testing::Test {
+class Http1ServerConnectionImplTest : public ::testing::TestWithParam<Http1Settings::Parser> {
 public:
+  Http1ServerConnectionImplTest() { codec_settings_.parser_ = GetParam(); }
+
   void initialize() {
     codec_.reset(new ServerConnectionImpl(connection_, callbacks_, codec_settings_));
   }
@@ -43,6 +46,10 @@ public:
   void expect400(Protocol p, bool allow_absolute_url, Buffer::OwnedImpl& buffer);
 };
 
+INSTANTIATE_TEST_CASE_P(Parsers, Http1ServerConnectionImplTest,
+                        ::testing::Values(Http1Settings::Parser::HttpParser,
+                                          Http1Settings::Parser::Vectorized));
+
 void Http1ServerConnectionImplTest::expect400(Protocol p, bool allow_absolute_url,
                                               Buffer::OwnedImpl& buffer) {
   InSequence sequence;
@@ -83,7 +90,7 @@ void Http1ServerConnectionImplTest::expectHeadersTest(Protocol p, bool allow_abs
   EXPECT_EQ(p, codec_->protocol());
 }
 
-TEST_F(Http1ServerConnectionImplTest, EmptyHeader) {
+TEST_P(Http1ServerConnectionImplTest, EmptyHeader) {
   initialize();
 
   InSequence sequence;
@@ -104,7 +111,7 @@ TEST_F(Http1ServerConnectionImplTest, EmptyHeader) {
   EXPECT_EQ(0U, buffer.length());
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http10) {
+TEST_P(Http1ServerConnectionImplTest, Http10) {
   initialize();
 
   InSequence sequence;
@@ -121,7 +128,7 @@ TEST_F(Http1ServerConnectionImplTest, Http10) {
   EXPECT_EQ(Protocol::Http10, codec_->protocol());
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http10AbsoluteNoOp) {
+TEST_P(Http1ServerConnectionImplTest, Http10AbsoluteNoOp) {
   initialize();
 
   TestHeaderMapImpl expected_headers{{":path", "/"}, {":method", "GET"}};
@@ -129,7 +136,7 @@ TEST_F(Http1ServerConnectionImplTest, Http10AbsoluteNoOp) {
   expectHeadersTest(Protocol::Http10, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http10Absolute) {
+TEST_P(Http1ServerConnectionImplTest, Http10Absolute) {
   initialize();
 
   TestHeaderMapImpl expected_headers{
@@ -138,7 +145,7 @@ TEST_F(Http1ServerConnectionImplTest, Http10Absolute) {
   expectHeadersTest(Protocol::Http10, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePath1) {
+TEST_P(Http1ServerConnectionImplTest, Http11AbsolutePath1) {
   initialize();
 
   TestHeaderMapImpl expected_headers{
@@ -147,7 +154,7 @@ TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePath1) {
   expectHeadersTest(Protocol::Http11, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePath2) {
+TEST_P(Http1ServerConnectionImplTest, Http11AbsolutePath2) {
   initialize();
 
   TestHeaderMapImpl expected_headers{
@@ -156,7 +163,7 @@ TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePath2) {
   expectHeadersTest(Protocol::Http11, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePathWithPort) {
+TEST_P(Http1ServerConnectionImplTest, Http11AbsolutePathWithPort) {
   TestHeaderMapImpl expected_headers{
       {":authority", "www.somewhere.com:4532"}, {":path", "/foo/bar"}, {":method", "GET"}};
   Buffer::OwnedImpl buffer(
@@ -164,7 +171,7 @@ TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePathWithPort) {
   expectHeadersTest(Protocol::Http11, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11AbsoluteEnabledNoOp) {
+TEST_P(Http1ServerConnectionImplTest, Http11AbsoluteEnabledNoOp) {
   initialize();
 
   TestHeaderMapImpl expected_headers{
@@ -173,7 +180,7 @@ TEST_F(Http1ServerConnectionImplTest, Http11AbsoluteEnabledNoOp) {
   expectHeadersTest(Protocol::Http11, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11InvalidRequest) {
+TEST_P(Http1ServerConnectionImplTest, Http11InvalidRequest) {
   initialize();
 
   // Invalid because www.somewhere.com is not an absolute path nor an absolute url
@@ -181,7 +188,7 @@ TEST_F(Http1ServerConnectionImplTest, Http11InvalidRequest) {
   expect400(Protocol::Http11, true, buffer);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePathNoSlash) {
+TEST_P(Http1ServerConnectionImplTest, Http11AbsolutePathNoSlash) {
   initialize();
 
   TestHeaderMapImpl expected_headers{
@@ -190,21 +197,21 @@ TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePathNoSlash) {
   expectHeadersTest(Protocol::Http11, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePathBad) {
+TEST_P(Http1ServerConnectionImplTest, Http11AbsolutePathBad) {
   initialize();
 
   Buffer::OwnedImpl buffer("GET * HTTP/1.1\r\nHost: bah\r\n\r\n");
   expect400(Protocol::Http11, true, buffer);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePortTooLarge) {
+TEST_P(Http1ServerConnectionImplTest, Http11AbsolutePortTooLarge) {
   initialize();
 
   Buffer::OwnedImpl buffer("GET http://foobar.com:1000000 HTTP/1.1\r\nHost: bah\r\n\r\n");
   expect400(Protocol::Http11, true, buffer);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11RelativeOnly) {
+TEST_P(Http1ServerConnectionImplTest, Http11RelativeOnly) {
   initialize();
 
   TestHeaderMapImpl expected_headers{
@@ -213,7 +220,7 @@ TEST_F(Http1ServerConnectionImplTest, Http11RelativeOnly) {
   expectHeadersTest(Protocol::Http11, false, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11Options) {
+TEST_P(Http1ServerConnectionImplTest, Http11Options) {
   initialize();
 
   TestHeaderMapImpl expected_headers{
@@ -222,7 +229,7 @@ TEST_F(Http1ServerConnectionImplTest, Http11Options) {
   expectHeadersTest(Protocol::Http11, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, SimpleGet) {
+TEST_P(Http1ServerConnectionImplTest, SimpleGet) {
   initialize();
 
   InSequence sequence;
@@ -238,7 +245,7 @@ TEST_F(Http1ServerConnectionImplTest, SimpleGet) {
   EXPECT_EQ(0U, buffer.length());
 }
 
-TEST_F(Http1ServerConnectionImplTest, BadRequestNoStream) {
+TEST_P(Http1ServerConnectionImplTest, BadRequestNoStream) {
   initialize();
 
   std::string output;
@@ -249,7 +256,7 @@ TEST_F(Http1ServerConnectionImplTest, BadRequestNoStream) {
   EXPECT_EQ("HTTP/1.1 400 Bad Request\r\ncontent-length: 0\r\nconnection: close\r\n\r\n", output);
 }
 
-TEST_F(Http1ServerConnectionImplTest, BadRequestStartedStream) {
+TEST_P(Http1ServerConnectionImplTest, BadRequestStartedStream) {
   initialize();
 
   std::string output;
@@ -266,7 +273,7 @@ TEST_F(Http1ServerConnectionImplTest, BadRequestStartedStream) {
   EXPECT_EQ("HTTP/1.1 400 Bad Request\r\ncontent-length: 0\r\nconnection: close\r\n\r\n", output);
 }
 
-TEST_F(Http1ServerConnectionImplTest, HostHeaderTranslation) {
+TEST_P(Http1ServerConnectionImplTest, HostHeaderTranslation) {
   initialize();
 
   InSequence sequence;
@@ -282,7 +289,7 @@ TEST_F(Http1ServerConnectionImplTest, HostHeaderTranslation) {
   EXPECT_EQ(0U, buffer.length());
 }
 
-TEST_F(Http1ServerConnectionImplTest, CloseDuringHeadersComplete) {
+TEST_P(Http1ServerConnectionImplTest, CloseDuringHeadersComplete) {
   initialize();
 
   InSequence sequence;
@@ -302,7 +309,7 @@ TEST_F(Http1ServerConnectionImplTest, CloseDuringHeadersComplete) {
   EXPECT_NE(0U, buffer.length());
 }
 
-TEST_F(Http1ServerConnectionImplTest, PostWithContentLength) {
+TEST_P(Http1ServerConnectionImplTest, PostWithContentLength) {
   initialize();
 
   InSequence sequence;
@@ -324,7 +331,7 @@ TEST_F(Http1ServerConnectionImplTest, PostWithContentLength) {
   EXPECT_EQ(0U, buffer.length());
 }
 
-TEST_F(Http1ServerConnectionImplTest, HeaderOnlyResponse) {
+TEST_P(Http1ServerConnectionImplTest, HeaderOnlyResponse) {
   initialize();
 
   NiceMock<Http::MockStreamDecoder> decoder;
@@ -347,7 +354,7 @@ TEST_F(Http1ServerConnectionImplTest, HeaderOnlyResponse) {
   EXPECT_EQ("HTTP/1.1 200 OK\r\ncontent-length: 0\r\n\r\n", output);
 }
 
-TEST_F(Http1ServerConnectionImplTest, ChunkedResponse) {
+TEST_P(Http1ServerConnectionImplTest, ChunkedResponse) {
   initialize();
 
   NiceMock<Http::MockStreamDecoder> decoder;
@@ -374,7 +381,7 @@ TEST_F(Http1ServerConnectionImplTest, ChunkedResponse) {
             output);
 }
 
-TEST_F(Http1ServerConnectionImplTest, ContentLengthResponse) {
+TEST_P(Http1ServerConnectionImplTest, ContentLengthResponse) {
   initialize();
 
   NiceMock<Http::MockStreamDecoder> decoder;
@@ -400,7 +407,7 @@ TEST_F(Http1ServerConnectionImplTest, ContentLengthResponse) {
   EXPECT_EQ("HTTP/1.1 200 OK\r\ncontent-length: 11\r\n\r\nHello World", output);
 }
 
-TEST_F(Http1ServerConnectionImplTest, HeadRequestResponse) {
+TEST_P(Http1ServerConnectionImplTest, HeadRequestResponse) {
   initialize();
 
   NiceMock<Http::MockStreamDecoder> decoder;
@@ -423,7 +430,7 @@ TEST_F(Http1ServerConnectionImplTest, HeadRequestResponse) {
   EXPECT_EQ("HTTP/1.1 200 OK\r\ncontent-length: 5\r\n\r\n", output);
 }
 
-TEST_F(Http1ServerConnectionImplTest, HeadChunkedRequestResponse) {
+TEST_P(Http1ServerConnectionImplTest, HeadChunkedRequestResponse) {
   initialize();
 
   NiceMock<Http::MockStreamDecoder> decoder;
@@ -446,7 +453,7 @@ TEST_F(Http1ServerConnectionImplTest, HeadChunkedRequestResponse) {
   EXPECT_EQ("HTTP/1.1 200 OK\r\ntransfer-encoding: chunked\r\n\r\n", output);
 }
 
-TEST_F(Http1ServerConnectionImplTest, DoubleRequest) {
+TEST_P(Http1ServerConnectionImplTest, DoubleRequest) {
   initialize();
 
   NiceMock<Http::MockStreamDecoder> decoder;
@@ -471,7 +478,39 @@ TEST_F(Http1ServerConnectionImplTest, DoubleRequest) {
   EXPECT_EQ(0U, buffer.length());
 }
 
-TEST_F(Http1ServerConnectionImplTest, RequestWithTrailers) {
+TEST_P(Http1ServerConnectionImplTest, RequestSplitAcrossDispatches) {
+  initialize();
+
+  InSequence sequence;
+
+  Http::MockStreamDecoder decoder;
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder));
+
+  TestHeaderMapImpl expected_headers{
+      {"host", "www.lyft.com"},
+      {"x-empty", ""},
+      {"user-agent", "curl/7.54.0"},
+      {"transfer-encoding", "chunked"},
+      {":path", "/some/path?query=1"},
+      {":method", "POST"},
+  };
+  EXPECT_CALL(decoder, decodeHeaders_(HeaderMapEqual(&expected_headers), false)).Times(1);
+  Buffer::OwnedImpl expected_data("hello");
+  EXPECT_CALL(decoder, decodeData(BufferEqual(&expected_data), false)).Times(1);
+  Buffer::OwnedImpl empty;
+  EXPECT_CALL(decoder, decodeData(BufferEqual(&empty), true)).Times(1);
+
+  const std::string request("POST /some/path?query=1 HTTP/1.1\r\nHost: www.lyft.com\r\n"
+                            "X-Empty:\r\nUser-Agent:  curl/7.54.0\r\n"
+                            "Transfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n");
+  for (const char c : request) {
+    Buffer::OwnedImpl buffer(&c, 1);
+    codec_->dispatch(buffer);
+    EXPECT_EQ(0U, buffer.length());
+  }
+}
+
+TEST_P(Http1ServerConnectionImplTest, RequestWithTrailers) {
   initialize();
 
   NiceMock<Http::MockStreamDecoder> decoder;
@@ -488,7 +527,7 @@ TEST_F(Http1ServerConnectionImplTest, RequestWithTrailers) {
   EXPECT_EQ(0U, buffer.length());
 }
 
-TEST_F(Http1ServerConnectionImplTest, WatermarkTest) {
+TEST_P(Http1ServerConnectionImplTest, WatermarkTest) {
   EXPECT_CALL(connection_, bufferLimit()).Times(1).WillOnce(Return(10));
   initialize();
 
@@ -522,6 +561,145 @@ TEST_F(Http1ServerConnectionImplTest, WatermarkTest) {
       ->onUnderlyingConnectionBelowWriteBufferLowWatermark();
 }
 
+TEST_P(Http1ServerConnectionImplTest, PipelinedResponsesInOrder) {
+  codec_settings_.max_pipelined_requests_ = 3;
+  initialize();
+
+  std::string output;
+  ON_CALL(connection_, write(_, _)).WillByDefault(AddBufferToString(&output));
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  std::vector<Http::StreamEncoder*> response_encoders;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoders.push_back(&encoder);
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET /0 HTTP/1.1\r\n\r\nGET /1 HTTP/1.1\r\n\r\nGET /2 HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+  ASSERT_EQ(3U, response_encoders.size());
+
+  // The response to the second request is held until the response to the first is complete.
+  response_encoders[1]->encodeHeaders(TestHeaderMapImpl{{":status", "201"}}, true);
+  EXPECT_EQ("", output);
+
+  response_encoders[0]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, false);
+  EXPECT_EQ("HTTP/1.1 200 OK\r\ntransfer-encoding: chunked\r\n\r\n", output);
+  Buffer::OwnedImpl data("hello");
+  response_encoders[0]->encodeData(data, true);
+  EXPECT_EQ("HTTP/1.1 200 OK\r\ntransfer-encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n"
+            "HTTP/1.1 201 Created\r\ncontent-length: 0\r\n\r\n",
+            output);
+  output.clear();
+
+  // The third request is now at the front, so its response is written directly.
+  response_encoders[2]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+  EXPECT_EQ("HTTP/1.1 200 OK\r\ncontent-length: 0\r\n\r\n", output);
+}
+
+TEST_P(Http1ServerConnectionImplTest, PipelinedMaxRequestsInFlight) {
+  codec_settings_.max_pipelined_requests_ = 2;
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  std::vector<Http::StreamEncoder*> response_encoders;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoders.push_back(&encoder);
+        return decoder;
+      }));
+
+  std::string request("GET / HTTP/1.1\r\n\r\n");
+  Buffer::OwnedImpl buffer(request + request + request);
+  codec_->dispatch(buffer);
+  EXPECT_EQ(request.size(), buffer.length());
+
+  // Nothing more is decoded until a response completes, even if it is not the first.
+  codec_->dispatch(buffer);
+  EXPECT_EQ(request.size(), buffer.length());
+  response_encoders[1]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+  codec_->dispatch(buffer);
+  EXPECT_EQ(request.size(), buffer.length());
+
+  EXPECT_CALL(callbacks_, newStream(_))
+      .WillOnce(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoders.push_back(&encoder);
+        return decoder;
+      }));
+  response_encoders[0]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+}
+
+TEST_P(Http1ServerConnectionImplTest, PipelinedHeldResponseWatermarks) {
+  EXPECT_CALL(connection_, bufferLimit()).WillRepeatedly(Return(10));
+  codec_settings_.max_pipelined_requests_ = 2;
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  std::vector<Http::StreamEncoder*> response_encoders;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoders.push_back(&encoder);
+        return decoder;
+      }));
+
+  std::string request("GET / HTTP/1.1\r\n\r\n");
+  Buffer::OwnedImpl buffer(request + request);
+  codec_->dispatch(buffer);
+
+  Http::MockStreamCallbacks stream_callbacks;
+  response_encoders[1]->getStream().addCallbacks(stream_callbacks);
+
+  // Encoding passes through the connection's output buffer, which goes above and below its
+  // watermarks, and then stays above the held buffer's high watermark.
+  EXPECT_CALL(stream_callbacks, onAboveWriteBufferHighWatermark()).Times(2);
+  EXPECT_CALL(stream_callbacks, onBelowWriteBufferLowWatermark());
+  response_encoders[1]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, false);
+  testing::Mock::VerifyAndClearExpectations(&stream_callbacks);
+
+  // The first response passes through the connection's output buffer too, and then the held
+  // response is released and drained.
+  EXPECT_CALL(stream_callbacks, onAboveWriteBufferHighWatermark());
+  EXPECT_CALL(stream_callbacks, onBelowWriteBufferLowWatermark()).Times(2);
+  response_encoders[0]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+}
+
+TEST_P(Http1ServerConnectionImplTest, PipelinedReset) {
+  codec_settings_.max_pipelined_requests_ = 3;
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  std::vector<Http::StreamEncoder*> response_encoders;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoders.push_back(&encoder);
+        return decoder;
+      }));
+
+  std::string request("GET / HTTP/1.1\r\n\r\n");
+  Buffer::OwnedImpl buffer(request + request + request);
+  codec_->dispatch(buffer);
+
+  Http::MockStreamCallbacks callbacks[3];
+  for (size_t i = 0; i < 3; i++) {
+    response_encoders[i]->getStream().addCallbacks(callbacks[i]);
+  }
+
+  // A reset applies to all requests in flight except those that are already complete.
+  response_encoders[1]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+  EXPECT_CALL(callbacks[0], onResetStream(StreamResetReason::LocalReset));
+  EXPECT_CALL(callbacks[1], onResetStream(_)).Times(0);
+  EXPECT_CALL(callbacks[2], onResetStream(StreamResetReason::LocalReset));
+  response_encoders[0]->getStream().resetStream(StreamResetReason::LocalReset);
+}
+
 class Http1ClientConnectionImplTest : public testing::Test {
 public:
   void initialize() { codec_.reset(new ClientConnectionImpl(connection_, callbacks_)); }
@@ -586,6 +764,10 @@ TEST_F(Http1ClientConnectionImplTest, MultipleHeaderOnlyThenNoContentLength) {
   EXPECT_EQ("GET / HTTP/1.1\r\nhost: host\r\ncontent-length: 0\r\n\r\n", output);
   output.clear();
 
+  EXPECT_CALL(response_decoder, decodeHeaders_(_, true));
+  Buffer::OwnedImpl response("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+  codec_->dispatch(response);
+
   // Simulate the underlying connection being backed up. Ensure that it is
   // read-enabled as the new stream is created.
   EXPECT_CALL(connection_, readEnabled())
@@ -782,8 +964,87 @@ TEST_F(Http1ClientConnectionImplTest, HighwatermarkMultipleResponses) {
       ->onUnderlyingConnectionBelowWriteBufferLowWatermark();
 }
 
+TEST_F(Http1ClientConnectionImplTest, PipelinedRequests) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> response_decoder1;
+  Http::StreamEncoder& request_encoder1 = codec_->newStream(response_decoder1);
+  TestHeaderMapImpl headers{{":method", "GET"}, {":path", "/"}, {":authority", "host"}};
+  request_encoder1.encodeHeaders(headers, true);
+
+  // The second request gets its own encoder. The first request still owns flow control on the
+  // connection, so it is left alone until the first response completes.
+  connection_.read_enabled_ = false;
+  EXPECT_CALL(connection_, readDisable(_)).Times(0);
+  NiceMock<Http::MockStreamDecoder> response_decoder2;
+  Http::StreamEncoder& request_encoder2 = codec_->newStream(response_decoder2);
+  EXPECT_NE(&request_encoder1, &request_encoder2);
+  TestHeaderMapImpl head_headers{{":method", "HEAD"}, {":path", "/"}, {":authority", "host"}};
+  request_encoder2.encodeHeaders(head_headers, true);
+
+  // Responses are matched to requests in order, including the HEAD request's lack of a body.
+  InSequence s;
+  EXPECT_CALL(response_decoder1, decodeHeaders_(_, false));
+  EXPECT_CALL(response_decoder1, decodeData(_, false));
+  EXPECT_CALL(response_decoder1, decodeData(_, true));
+  EXPECT_CALL(connection_, readDisable(false)).WillOnce(Invoke([&](bool) -> void {
+    connection_.read_enabled_ = true;
+  }));
+  EXPECT_CALL(response_decoder2, decodeHeaders_(_, true));
+  Buffer::OwnedImpl response("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nhi"
+                             "HTTP/1.1 200 OK\r\nContent-Length: 20\r\n\r\n");
+  codec_->dispatch(response);
+}
+
+TEST_F(Http1ClientConnectionImplTest, PipelinedReset) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> response_decoder1;
+  Http::StreamEncoder& request_encoder1 = codec_->newStream(response_decoder1);
+  Http::MockStreamCallbacks callbacks1;
+  request_encoder1.getStream().addCallbacks(callbacks1);
+  TestHeaderMapImpl headers{{":method", "GET"}, {":path", "/"}, {":authority", "host"}};
+  request_encoder1.encodeHeaders(headers, true);
+
+  NiceMock<Http::MockStreamDecoder> response_decoder2;
+  Http::StreamEncoder& request_encoder2 = codec_->newStream(response_decoder2);
+  Http::MockStreamCallbacks callbacks2;
+  request_encoder2.getStream().addCallbacks(callbacks2);
+
+  // Resetting any stream resets every request on the connection.
+  EXPECT_CALL(callbacks1, onResetStream(StreamResetReason::LocalReset));
+  EXPECT_CALL(callbacks2, onResetStream(StreamResetReason::LocalReset));
+  request_encoder2.getStream().resetStream(StreamResetReason::LocalReset);
+}
+
+TEST_F(Http1ClientConnectionImplTest, PipelinedWatermarks) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> response_decoder1;
+  Http::StreamEncoder& request_encoder1 = codec_->newStream(response_decoder1);
+  Http::MockStreamCallbacks callbacks1;
+  request_encoder1.getStream().addCallbacks(callbacks1);
+
+  EXPECT_CALL(callbacks1, onAboveWriteBufferHighWatermark());
+  static_cast<ClientConnection*>(codec_.get())
+      ->onUnderlyingConnectionAboveWriteBufferHighWatermark();
+
+  // A request pipelined onto a backed up connection starts out above the high watermark.
+  EXPECT_CALL(connection_, aboveHighWatermark()).WillOnce(Return(true));
+  NiceMock<Http::MockStreamDecoder> response_decoder2;
+  Http::StreamEncoder& request_encoder2 = codec_->newStream(response_decoder2);
+  Http::MockStreamCallbacks callbacks2;
+  EXPECT_CALL(callbacks2, onAboveWriteBufferHighWatermark());
+  request_encoder2.getStream().addCallbacks(callbacks2);
+
+  EXPECT_CALL(callbacks1, onBelowWriteBufferLowWatermark());
+  EXPECT_CALL(callbacks2, onBelowWriteBufferLowWatermark());
+  static_cast<ClientConnection*>(codec_.get())
+      ->onUnderlyingConnectionBelowWriteBufferLowWatermark();
+}
+
 // For issue #1421 regression test that Envoy's HTTP parser applies header limits early.
-TEST_F(Http1ServerConnectionImplTest, TestCodecHeaderLimits) {
+TEST_P(Http1ServerConnectionImplTest, TestCodecHeaderLimits) {
   initialize();
 
   std::string exception_reason;
@@ -799,10 +1060,10 @@ TEST_F(Http1ServerConnectionImplTest, TestCodecHeaderLimits) {
   codec_->dispatch(buffer);
   std::string long_string = "foo: " + std::string(1024, 'q') + "\r\n";
   for (int i = 0; i < 79; ++i) {
-    buffer = Buffer::OwnedImpl(long_string);
+    buffer.add(long_string);
     codec_->dispatch(buffer);
   }
-  buffer = Buffer::OwnedImpl(long_string);
+  buffer.add(long_string);
   EXPECT_THROW_WITH_MESSAGE(codec_->dispatch(buffer), EnvoyException,
                             "http/1.1 protocol error: HPE_HEADER_OVERFLOW");
 }
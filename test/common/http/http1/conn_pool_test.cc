@@ -22,6 +22,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::AnyNumber;
 using testing::DoAll;
 using testing::InSequence;
 using testing::Invoke;
@@ -51,6 +52,7 @@ public:
   ~ConnPoolImplForTest() {
     EXPECT_EQ(0U, ready_clients_.size());
     EXPECT_EQ(0U, busy_clients_.size());
+    EXPECT_EQ(0U, pipelining_clients_.size());
     EXPECT_EQ(0U, pending_requests_.size());
   }
 
@@ -189,6 +191,10 @@ struct ActiveTestRequest {
 
   void startRequest() { callbacks_.outer_encoder_->encodeHeaders(TestHeaderMapImpl{}, true); }
 
+  void startRequest(const std::string& method) {
+    callbacks_.outer_encoder_->encodeHeaders(TestHeaderMapImpl{{":method", method}}, true);
+  }
+
   Http1ConnPoolImplTest& parent_;
   size_t client_index_;
   NiceMock<Http::MockStreamDecoder> outer_decoder_;
@@ -711,6 +717,188 @@ TEST_F(Http1ConnPoolImplTest, RemoteCloseToCompleteResponse) {
   dispatcher_.clearDeferredDeleteList();
 }
 
+/**
+ * Test that the most recently used idle connection is reused first.
+ */
+TEST_F(Http1ConnPoolImplTest, ReuseMostRecentlyUsedConnection) {
+  EXPECT_CALL(cluster_->stats_store_, deliverHistogramToSinks(_, _)).Times(AnyNumber());
+  InSequence s;
+
+  cluster_->resource_manager_.reset(
+      new Upstream::ResourceManagerImpl(runtime_, "fake_key", 2, 1024, 1024, 1));
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection);
+  r1.startRequest();
+
+  ActiveTestRequest r2(*this, 1, ActiveTestRequest::Type::CreateConnection);
+  r2.startRequest();
+
+  // Client 1 goes idle last, so it is used for the next two requests while client 0 stays idle.
+  r1.completeResponse(false);
+  r2.completeResponse(false);
+
+  EXPECT_CALL(cluster_->stats_store_,
+              deliverHistogramToSinks(
+                  Property(&Stats::Metric::name, "upstream_cx_reuse_distance"), 0))
+      .RetiresOnSaturation();
+  ActiveTestRequest r3(*this, 1, ActiveTestRequest::Type::Immediate);
+  r3.startRequest();
+  r3.completeResponse(false);
+
+  EXPECT_CALL(cluster_->stats_store_,
+              deliverHistogramToSinks(
+                  Property(&Stats::Metric::name, "upstream_cx_reuse_distance"), 0))
+      .RetiresOnSaturation();
+  ActiveTestRequest r4(*this, 1, ActiveTestRequest::Type::Immediate);
+  r4.startRequest();
+  r4.completeResponse(false);
+
+  // Client 0 has been idle while three requests were started on client 1.
+  ActiveTestRequest r5(*this, 1, ActiveTestRequest::Type::Immediate);
+  EXPECT_CALL(cluster_->stats_store_,
+              deliverHistogramToSinks(
+                  Property(&Stats::Metric::name, "upstream_cx_reuse_distance"), 3));
+  ActiveTestRequest r6(*this, 0, ActiveTestRequest::Type::Immediate);
+  r5.startRequest();
+  r6.startRequest();
+  r5.completeResponse(false);
+  r6.completeResponse(false);
+
+  EXPECT_CALL(conn_pool_, onClientDestroy()).Times(2);
+  conn_pool_.test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+/**
+ * Test that idempotent requests are pipelined on a busy connection once they have been sent.
+ */
+TEST_F(Http1ConnPoolImplTest, PipelineIdempotentRequests) {
+  EXPECT_CALL(cluster_->stats_store_, deliverHistogramToSinks(_, _)).Times(AnyNumber());
+  InSequence s;
+
+  cluster_->http1_settings_.max_pipelined_requests_ = 2;
+  cluster_->resource_manager_.reset(
+      new Upstream::ResourceManagerImpl(runtime_, "fake_key", 1, 1024, 1024, 1));
+
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection);
+  r1.startRequest("GET");
+
+  EXPECT_CALL(cluster_->stats_store_,
+              deliverHistogramToSinks(
+                  Property(&Stats::Metric::name, "upstream_rq_pipeline_depth"), 2))
+      .RetiresOnSaturation();
+  ActiveTestRequest r2(*this, 0, ActiveTestRequest::Type::Immediate);
+  r2.startRequest("HEAD");
+  EXPECT_EQ(1U, cluster_->stats_.upstream_rq_pipelined_.value());
+
+  // The connection is at its pipeline limit, so this request waits.
+  ActiveTestRequest r3(*this, 0, ActiveTestRequest::Type::Pending);
+
+  // Finishing r1 makes room for r3 behind r2.
+  conn_pool_.expectEnableUpstreamReady();
+  r1.completeResponse(false);
+  r3.expectNewStream();
+  conn_pool_.expectAndRunUpstreamReady();
+  r3.startRequest("GET");
+  EXPECT_EQ(2U, cluster_->stats_.upstream_rq_pipelined_.value());
+
+  r2.completeResponse(false);
+  r3.completeResponse(false);
+
+  EXPECT_CALL(conn_pool_, onClientDestroy());
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+  EXPECT_EQ(0U, cluster_->stats_.upstream_cx_destroy_with_active_rq_.value());
+}
+
+/**
+ * Test that requests are not pipelined behind a request that is incomplete or not idempotent.
+ */
+TEST_F(Http1ConnPoolImplTest, NoPipelineBehindUnsafeRequest) {
+  InSequence s;
+
+  cluster_->http1_settings_.max_pipelined_requests_ = 2;
+  cluster_->resource_manager_.reset(
+      new Upstream::ResourceManagerImpl(runtime_, "fake_key", 2, 1024, 1024, 1));
+
+  // r1 has not been sent yet, so r2 needs a new connection.
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection);
+  ActiveTestRequest r2(*this, 1, ActiveTestRequest::Type::CreateConnection);
+  r1.startRequest("POST");
+  r2.startRequest("GET");
+
+  // r2 is idempotent and has been sent, so r3 is pipelined behind it rather than behind the POST.
+  ActiveTestRequest r3(*this, 1, ActiveTestRequest::Type::Immediate);
+  r3.startRequest("GET");
+  EXPECT_EQ(1U, cluster_->stats_.upstream_rq_pipelined_.value());
+
+  r1.completeResponse(false);
+  r2.completeResponse(false);
+  r3.completeResponse(false);
+
+  EXPECT_CALL(conn_pool_, onClientDestroy()).Times(2);
+  conn_pool_.test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+/**
+ * Test that all pipelined requests are reset when their connection is lost.
+ */
+TEST_F(Http1ConnPoolImplTest, DisconnectWithPipelinedRequests) {
+  InSequence s;
+
+  cluster_->http1_settings_.max_pipelined_requests_ = 2;
+
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection);
+  r1.startRequest("GET");
+  ActiveTestRequest r2(*this, 0, ActiveTestRequest::Type::Immediate);
+  r2.startRequest("GET");
+
+  Http::MockStreamCallbacks stream_callbacks1;
+  Http::MockStreamCallbacks stream_callbacks2;
+  r1.request_encoder_.getStream().addCallbacks(stream_callbacks1);
+  r2.request_encoder_.getStream().addCallbacks(stream_callbacks2);
+  EXPECT_CALL(stream_callbacks1, onResetStream(StreamResetReason::ConnectionTermination));
+  EXPECT_CALL(stream_callbacks2, onResetStream(StreamResetReason::ConnectionTermination));
+
+  EXPECT_CALL(conn_pool_, onClientDestroy());
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_destroy_with_active_rq_.value());
+}
+
+/**
+ * Test that draining a connection with pipelined requests waits for all of their responses.
+ */
+TEST_F(Http1ConnPoolImplTest, DrainWithPipelinedRequests) {
+  InSequence s;
+
+  cluster_->http1_settings_.max_pipelined_requests_ = 3;
+
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection);
+  r1.startRequest("GET");
+  ActiveTestRequest r2(*this, 0, ActiveTestRequest::Type::Immediate);
+  r2.startRequest("GET");
+
+  conn_pool_.drainConnections();
+
+  // Nothing more may be pipelined onto the draining connection.
+  ActiveTestRequest r3(*this, 1, ActiveTestRequest::Type::CreateConnection);
+  r3.startRequest("GET");
+
+  r1.completeResponse(false);
+  EXPECT_CALL(conn_pool_, onClientDestroy());
+  r2.completeResponse(false);
+  dispatcher_.clearDeferredDeleteList();
+  EXPECT_EQ(0U, cluster_->stats_.upstream_cx_destroy_with_active_rq_.value());
+
+  r3.completeResponse(false);
+  EXPECT_CALL(conn_pool_, onClientDestroy());
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+}
+
 } // namespace Http1
 } // namespace Http
 } // namespace Envoy
@@ -0,0 +1,139 @@
+// Differential fuzzer for VectorizedParserImpl. Whatever the vectorized parser accepts, with any of
+// its scanners, http_parser must accept too and report the same callbacks.
+//
+// The first byte of the input selects the parser type (low bit) and the size of the spans the rest
+// of the input is passed to the parsers in.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "common/common/assert.h"
+#include "common/http/http1/http_parser_impl.h"
+#include "common/http/http1/scanner.h"
+#include "common/http/http1/vectorized_parser_impl.h"
+
+#include "test/fuzz/fuzz_runner.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+namespace {
+
+// Records callbacks as a list of events, joining the pieces of data delivered by consecutive calls
+// of the same callback. Trailers are dropped, since only http_parser reports them.
+class RecordingCallbacks : public ParserCallbacks {
+public:
+  RecordingCallbacks(ParserType type) : type_(type) {}
+
+  // Http1::ParserCallbacks
+  void onMessageBeginBase() override { event("begin"); }
+  void onUrl(const char* data, size_t length) override { append("url", data, length); }
+  void onHeaderField(const char* data, size_t length) override {
+    if (!in_body_) {
+      append("field", data, length);
+    }
+  }
+  void onHeaderValue(const char* data, size_t length) override {
+    if (!in_body_) {
+      append("value", data, length);
+    }
+  }
+  int onHeadersCompleteBase() override {
+    // The method is only meaningful for requests and the status code only for responses.
+    const int start_line =
+        type_ == ParserType::Request ? static_cast<int>(parser_->method()) : parser_->statusCode();
+    event("headers " + std::to_string(start_line) + " " + std::to_string(parser_->httpMajor()) +
+          "." + std::to_string(parser_->httpMinor()));
+    in_body_ = true;
+    return 0;
+  }
+  void onBody(const char* data, size_t length) override { append("body", data, length); }
+  void onMessageComplete() override {
+    event("complete");
+    in_body_ = false;
+  }
+
+  void event(const std::string& name) {
+    events_.push_back(name);
+    last_ = name;
+  }
+  void append(const std::string& name, const char* data, size_t length) {
+    if (last_ != name) {
+      event(name + ":");
+    }
+    events_.back().append(data, length);
+  }
+
+  const ParserType type_;
+  Parser* parser_{};
+  bool in_body_{};
+  std::string last_;
+  std::vector<std::string> events_;
+};
+
+struct ParseResult {
+  http_errno error_;
+  size_t consumed_;
+  std::vector<std::string> events_;
+};
+
+ParseResult parse(Parser& parser, RecordingCallbacks& callbacks, const char* data, size_t length,
+                  size_t span) {
+  callbacks.parser_ = &parser;
+  size_t consumed = 0;
+  while (consumed < length) {
+    const size_t span_length = std::min(span, length - consumed);
+    const size_t rc = parser.execute(data + consumed, span_length);
+    consumed += rc;
+    if (parser.error() != HPE_OK || rc != span_length) {
+      // An error, or an upgrade, after which the rest of the data is not HTTP.
+      return {parser.error(), consumed, callbacks.events_};
+    }
+  }
+  // Signal the end of the connection, which completes bodies delimited by it.
+  parser.execute(nullptr, 0);
+  return {parser.error(), consumed, callbacks.events_};
+}
+
+} // namespace
+} // namespace Http1
+} // namespace Http
+
+namespace Fuzz {
+
+DEFINE_FUZZER(const uint8_t* buf, size_t len) {
+  using namespace Http::Http1;
+
+  if (len == 0) {
+    return;
+  }
+  const ParserType type = (buf[0] & 1) ? ParserType::Response : ParserType::Request;
+  const size_t span = (buf[0] >> 1) + 1;
+  const char* data = reinterpret_cast<const char*>(buf + 1);
+  len--;
+
+  RecordingCallbacks expected_callbacks(type);
+  HttpParserImpl http_parser(type, expected_callbacks);
+  const ParseResult expected = parse(http_parser, expected_callbacks, data, len, span);
+
+  const Scanner::Impl previous_impl = Scanner::impl();
+  for (Scanner::Impl impl : {Scanner::Impl::Scalar, Scanner::Impl::Sse42, Scanner::Impl::Avx2}) {
+    if (!Scanner::supported(impl)) {
+      continue;
+    }
+    Scanner::setImpl(impl);
+    RecordingCallbacks callbacks(type);
+    VectorizedParserImpl parser(type, callbacks);
+    const ParseResult result = parse(parser, callbacks, data, len, span);
+    if (result.error_ == HPE_OK) {
+      RELEASE_ASSERT(expected.error_ == HPE_OK);
+      RELEASE_ASSERT(result.consumed_ == expected.consumed_);
+      RELEASE_ASSERT(result.events_ == expected.events_);
+    }
+  }
+  Scanner::setImpl(previous_impl);
+}
+
+} // namespace Fuzz
+} // namespace Envoy
@@ -0,0 +1,125 @@
+#include <memory>
+#include <string>
+
+#include "common/http/http1/http_parser_impl.h"
+#include "common/http/http1/scanner.h"
+#include "common/http/http1/vectorized_parser_impl.h"
+
+#include "testing/base/public/benchmark.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+// A typical browser request as received by an edge proxy.
+static const std::string& request() {
+  static const auto* request = new std::string(
+      "GET /api/v1/resource?id=12345&fields=name,description,owner HTTP/1.1\r\n"
+      "Host: service.example.com\r\n"
+      "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+      "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+      "Accept-Encoding: gzip, deflate, br\r\n"
+      "Accept-Language: en-US,en;q=0.9\r\n"
+      "Cache-Control: max-age=0\r\n"
+      "Cookie: session=4f2c7e0b9a; theme=dark; tracking=opt-out\r\n"
+      "Referer: https://www.example.com/index.html\r\n"
+      "X-Forwarded-For: 203.0.113.1, 198.51.100.7\r\n"
+      "X-Forwarded-Proto: https\r\n"
+      "X-Request-Id: 2e1c9a6d-1f7a-4bb9-8f4f-6a0e5c2a8a11\r\n"
+      "If-None-Match: \"33a64df551425fcc55e4d42a148795d9f25f89d4\"\r\n"
+      "\r\n");
+  return *request;
+}
+
+// Touches every byte delivered so the benchmarks include the cost of the callbacks that the codec
+// makes.
+class CountingCallbacks : public ParserCallbacks {
+public:
+  // Http1::ParserCallbacks
+  void onMessageBeginBase() override {}
+  void onUrl(const char* data, size_t length) override { count(data, length); }
+  void onHeaderField(const char* data, size_t length) override { count(data, length); }
+  void onHeaderValue(const char* data, size_t length) override { count(data, length); }
+  int onHeadersCompleteBase() override { return 0; }
+  void onBody(const char* data, size_t length) override { count(data, length); }
+  void onMessageComplete() override { messages_++; }
+
+  void count(const char* data, size_t length) {
+    callbacks_++;
+    bytes_ += length;
+    benchmark::DoNotOptimize(data);
+  }
+
+  size_t callbacks_{};
+  size_t bytes_{};
+  size_t messages_{};
+};
+
+// Parse state.range(0) pipelined requests per call to execute().
+static void parse(benchmark::State& state, ParserPtr (*factory)(ParserCallbacks&)) {
+  std::string data;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    data += request();
+  }
+
+  CountingCallbacks callbacks;
+  ParserPtr parser = factory(callbacks);
+  for (auto _ : state) {
+    parser->execute(data.data(), data.size());
+  }
+  if (parser->error() != HPE_OK) {
+    state.SkipWithError(http_errno_name(parser->error()));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+  state.counters["callbacks"] = static_cast<double>(callbacks.callbacks_) / callbacks.messages_;
+}
+
+static ParserPtr httpParser(ParserCallbacks& callbacks) {
+  return std::make_unique<HttpParserImpl>(ParserType::Request, callbacks);
+}
+
+static ParserPtr vectorizedParser(ParserCallbacks& callbacks) {
+  return std::make_unique<VectorizedParserImpl>(ParserType::Request, callbacks);
+}
+
+static void BM_HttpParser(benchmark::State& state) { parse(state, httpParser); }
+BENCHMARK(BM_HttpParser)->Arg(1)->Arg(16);
+
+static void vectorized(benchmark::State& state, Scanner::Impl impl) {
+  if (!Scanner::supported(impl)) {
+    state.SkipWithError("scanner implementation not supported");
+    return;
+  }
+  const Scanner::Impl previous_impl = Scanner::impl();
+  Scanner::setImpl(impl);
+  parse(state, vectorizedParser);
+  Scanner::setImpl(previous_impl);
+}
+
+static void BM_VectorizedParserScalar(benchmark::State& state) {
+  vectorized(state, Scanner::Impl::Scalar);
+}
+BENCHMARK(BM_VectorizedParserScalar)->Arg(1)->Arg(16);
+
+static void BM_VectorizedParserSse42(benchmark::State& state) {
+  vectorized(state, Scanner::Impl::Sse42);
+}
+BENCHMARK(BM_VectorizedParserSse42)->Arg(1)->Arg(16);
+
+static void BM_VectorizedParserAvx2(benchmark::State& state) {
+  vectorized(state, Scanner::Impl::Avx2);
+}
+BENCHMARK(BM_VectorizedParserAvx2)->Arg(1)->Arg(16);
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,421 @@
+#include <string>
+#include <vector>
+
+#include "common/http/http1/scanner.h"
+#include "common/http/http1/vectorized_parser_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+namespace {
+
+std::vector<Scanner::Impl> supportedScannerImpls() {
+  std::vector<Scanner::Impl> impls;
+  for (Scanner::Impl impl : {Scanner::Impl::Scalar, Scanner::Impl::Sse42, Scanner::Impl::Avx2}) {
+    if (Scanner::supported(impl)) {
+      impls.push_back(impl);
+    }
+  }
+  return impls;
+}
+
+// Selects a scanner implementation for the duration of a test.
+class ScannerImplTestBase : public ::testing::TestWithParam<Scanner::Impl> {
+public:
+  ScannerImplTestBase() : previous_impl_(Scanner::impl()) { Scanner::setImpl(GetParam()); }
+  ~ScannerImplTestBase() { Scanner::setImpl(previous_impl_); }
+
+private:
+  const Scanner::Impl previous_impl_;
+};
+
+// Records callbacks as a list of events, joining the pieces of data delivered by consecutive calls
+// of the same callback.
+class RecordingCallbacks : public ParserCallbacks {
+public:
+  // Http1::ParserCallbacks
+  void onMessageBeginBase() override { event("begin"); }
+  void onUrl(const char* data, size_t length) override { append("url", data, length); }
+  void onHeaderField(const char* data, size_t length) override {
+    field_callbacks_++;
+    append("field", data, length);
+  }
+  void onHeaderValue(const char* data, size_t length) override {
+    value_callbacks_++;
+    append("value", data, length);
+  }
+  int onHeadersCompleteBase() override {
+    event("headers");
+    if (pause_on_headers_complete_) {
+      parser_->pause();
+    }
+    return skip_body_ ? 1 : 0;
+  }
+  void onBody(const char* data, size_t length) override { append("body", data, length); }
+  void onMessageComplete() override {
+    event("complete");
+    if (pause_on_message_complete_) {
+      parser_->pause();
+    }
+  }
+
+  void event(const std::string& name) {
+    events_.push_back(name);
+    last_ = name;
+  }
+  void append(const std::string& name, const char* data, size_t length) {
+    if (last_ != name) {
+      event(name + ":");
+      last_ = name;
+    }
+    events_.back().append(data, length);
+  }
+
+  Parser* parser_{};
+  bool skip_body_{};
+  bool pause_on_headers_complete_{};
+  bool pause_on_message_complete_{};
+  size_t field_callbacks_{};
+  size_t value_callbacks_{};
+  std::vector<std::string> events_;
+  std::string last_;
+};
+
+typedef std::vector<std::string> Events;
+
+class VectorizedParserImplTest : public ScannerImplTestBase {
+public:
+  void initialize(ParserType type) {
+    parser_.reset(new VectorizedParserImpl(type, callbacks_));
+    callbacks_.parser_ = parser_.get();
+  }
+
+  // Parse data in one call.
+  size_t execute(const std::string& data) { return parser_->execute(data.data(), data.size()); }
+
+  // Parse data in pieces of at most piece_size bytes, resuming if paused.
+  void executeInPieces(const std::string& data, size_t piece_size) {
+    size_t offset = 0;
+    while (offset < data.size() && parser_->error() == HPE_OK) {
+      const size_t length = std::min(piece_size, data.size() - offset);
+      const size_t parsed = parser_->execute(data.data() + offset, length);
+      offset += parsed;
+      if (parser_->error() == HPE_PAUSED) {
+        parser_->resume();
+      } else if (parser_->error() == HPE_OK) {
+        EXPECT_EQ(length, parsed);
+      }
+    }
+  }
+
+  // Expect the same events however the data is split up.
+  void expectEvents(ParserType type, const std::string& data, const Events& expected) {
+    for (size_t piece_size : {data.size(), size_t(1), size_t(2), size_t(7), size_t(33)}) {
+      initialize(type);
+      executeInPieces(data, piece_size);
+      EXPECT_EQ(HPE_OK, parser_->error()) << piece_size;
+      EXPECT_EQ(expected, callbacks_.events_) << piece_size;
+      callbacks_.events_.clear();
+      callbacks_.last_.clear();
+    }
+  }
+
+  void expectError(ParserType type, const std::string& data, http_errno error) {
+    initialize(type);
+    execute(data);
+    EXPECT_EQ(error, parser_->error()) << data;
+  }
+
+  RecordingCallbacks callbacks_;
+  std::unique_ptr<VectorizedParserImpl> parser_;
+};
+
+INSTANTIATE_TEST_CASE_P(ScannerImpls, VectorizedParserImplTest,
+                        ::testing::ValuesIn(supportedScannerImpls()));
+
+TEST_P(VectorizedParserImplTest, SimpleRequest) {
+  expectEvents(ParserType::Request,
+               "GET /path?query=1 HTTP/1.1\r\nHost: lyft.com\r\nEmpty:\r\nTabs:\t a\tb \r\n\r\n",
+               {"begin", "url:/path?query=1", "field:Host", "value:lyft.com", "field:Empty",
+                "value:", "field:Tabs", "value:a\tb ", "headers", "complete"});
+
+  initialize(ParserType::Request);
+  execute("M-SEARCH * HTTP/1.0\n\n");
+  EXPECT_EQ(HTTP_MSEARCH, parser_->method());
+  EXPECT_EQ(1, parser_->httpMajor());
+  EXPECT_EQ(0, parser_->httpMinor());
+}
+
+TEST_P(VectorizedParserImplTest, LongHeaders) {
+  // Long enough for several vector blocks.
+  const std::string value(1000, 'v');
+  const std::string url = "/" + std::string(300, 'u');
+  expectEvents(ParserType::Request, "GET " + url + " HTTP/1.1\r\nx-long: " + value + "\r\n\r\n",
+               {"begin", "url:" + url, "field:x-long", "value:" + value, "headers", "complete"});
+}
+
+TEST_P(VectorizedParserImplTest, SingleCallbacks) {
+  // A header that is not split across spans is delivered with one field and one value callback.
+  initialize(ParserType::Request);
+  const std::string request("GET / HTTP/1.1\r\na: 1\r\nb: " + std::string(100, 'x') + "\r\n\r\n");
+  EXPECT_EQ(request.size(), execute(request));
+  EXPECT_EQ(2U, callbacks_.field_callbacks_);
+  EXPECT_EQ(2U, callbacks_.value_callbacks_);
+}
+
+TEST_P(VectorizedParserImplTest, ContentLength) {
+  expectEvents(ParserType::Request,
+               "POST / HTTP/1.1\r\nContent-Length: 11\r\n\r\nhello worldGET / HTTP/1.1\r\n\r\n",
+               {"begin", "url:/", "field:Content-Length", "value:11", "headers", "body:hello world",
+                "complete", "begin", "url:/", "headers", "complete"});
+
+  initialize(ParserType::Request);
+  execute("POST / HTTP/1.1\r\ncontent-length: 5 \r\n\r\n");
+  EXPECT_EQ(5U, parser_->contentLength().value());
+  EXPECT_FALSE(parser_->isChunked());
+}
+
+TEST_P(VectorizedParserImplTest, Chunked) {
+  expectEvents(ParserType::Request,
+               "POST / HTTP/1.1\r\nTransfer-Encoding: gzip, Chunked\r\n\r\n"
+               "5\r\nhello\r\nA;name=value\r\n0123456789\r\n0\r\nTrailer: x\r\n\r\n",
+               {"begin", "url:/", "field:Transfer-Encoding", "value:gzip, Chunked", "headers",
+                "body:hello0123456789", "complete"});
+
+  initialize(ParserType::Request);
+  execute("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n");
+  EXPECT_TRUE(parser_->isChunked());
+  EXPECT_FALSE(parser_->contentLength().has_value());
+}
+
+TEST_P(VectorizedParserImplTest, Pipelined) {
+  std::string data;
+  Events expected;
+  for (int i = 0; i < 16; i++) {
+    data += "GET /" + std::to_string(i) + " HTTP/1.1\r\nHost: a\r\n\r\n";
+    expected.insert(expected.end(), {"begin", "url:/" + std::to_string(i), "field:Host",
+                                     "value:a", "headers", "complete"});
+  }
+  expectEvents(ParserType::Request, data, expected);
+}
+
+TEST_P(VectorizedParserImplTest, PauseOnMessageComplete) {
+  initialize(ParserType::Request);
+  callbacks_.pause_on_message_complete_ = true;
+  const std::string request("GET / HTTP/1.1\r\n\r\n");
+  const std::string data = request + request;
+
+  EXPECT_EQ(request.size(), execute(data));
+  EXPECT_EQ(HPE_PAUSED, parser_->error());
+  EXPECT_EQ(0U, parser_->execute(data.data() + request.size(), request.size()));
+
+  parser_->resume();
+  EXPECT_EQ(HPE_OK, parser_->error());
+  EXPECT_EQ(request.size(), parser_->execute(data.data() + request.size(), request.size()));
+  EXPECT_EQ((Events{"begin", "url:/", "headers", "complete", "begin", "url:/", "headers",
+                    "complete"}),
+            callbacks_.events_);
+}
+
+TEST_P(VectorizedParserImplTest, PauseOnHeadersComplete) {
+  initialize(ParserType::Request);
+  callbacks_.pause_on_headers_complete_ = true;
+  const std::string headers("POST / HTTP/1.1\r\ncontent-length: 2\r\n\r\n");
+
+  EXPECT_EQ(headers.size(), execute(headers + "ab"));
+  EXPECT_EQ(HPE_PAUSED, parser_->error());
+  parser_->resume();
+  EXPECT_EQ(2U, execute("ab"));
+  EXPECT_EQ((Events{"begin", "url:/", "field:content-length", "value:2", "headers", "body:ab",
+                    "complete"}),
+            callbacks_.events_);
+}
+
+TEST_P(VectorizedParserImplTest, SimpleResponse) {
+  expectEvents(ParserType::Response,
+               "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhelloHTTP/1.1 404\r\n"
+               "content-length: 0\r\n\r\n",
+               {"begin", "field:Content-Length", "value:5", "headers", "body:hello", "complete",
+                "begin", "field:content-length", "value:0", "headers", "complete"});
+
+  initialize(ParserType::Response);
+  execute("HTTP/1.0 503 Service Unavailable\r\n");
+  EXPECT_EQ(503, parser_->statusCode());
+  EXPECT_EQ(1, parser_->httpMajor());
+  EXPECT_EQ(0, parser_->httpMinor());
+}
+
+TEST_P(VectorizedParserImplTest, ResponseBodyUntilEof) {
+  initialize(ParserType::Response);
+  execute("HTTP/1.1 200 OK\r\n\r\nsome");
+  execute(" body");
+  EXPECT_EQ(0U, parser_->execute(nullptr, 0));
+  EXPECT_EQ(HPE_OK, parser_->error());
+  EXPECT_EQ((Events{"begin", "headers", "body:some body", "complete"}), callbacks_.events_);
+}
+
+TEST_P(VectorizedParserImplTest, ResponsesWithoutBody) {
+  for (const std::string status : {"100 Continue", "204 No Content", "304 Not Modified"}) {
+    expectEvents(ParserType::Response, "HTTP/1.1 " + status + "\r\n\r\n",
+                 {"begin", "headers", "complete"});
+  }
+
+  // Body skipped by the callbacks, e.g. for a response to a HEAD request.
+  initialize(ParserType::Response);
+  callbacks_.skip_body_ = true;
+  execute("HTTP/1.1 200 OK\r\ncontent-length: 10\r\n\r\n");
+  EXPECT_EQ((Events{"begin", "field:content-length", "value:10", "headers", "complete"}),
+            callbacks_.events_);
+}
+
+TEST_P(VectorizedParserImplTest, Upgrade) {
+  initialize(ParserType::Request);
+  const std::string request(
+      "GET / HTTP/1.1\r\nConnection: keep-alive, Upgrade\r\nUpgrade: websocket\r\n\r\n");
+  // Parsing stops after the upgrade request.
+  EXPECT_EQ(request.size(), execute(request + "\x81\x05"));
+  EXPECT_EQ(HPE_OK, parser_->error());
+  EXPECT_EQ("complete", callbacks_.events_.back());
+
+  initialize(ParserType::Request);
+  const std::string connect("CONNECT host:443 HTTP/1.1\n\n");
+  EXPECT_EQ(connect.size(), execute(connect + "bytes"));
+  EXPECT_EQ(HTTP_CONNECT, parser_->method());
+}
+
+TEST_P(VectorizedParserImplTest, Http09) {
+  expectEvents(ParserType::Request, "GET /\r\n\r\n", {"begin", "url:/", "headers", "complete"});
+  initialize(ParserType::Request);
+  execute("GET /\r\n\r\n");
+  EXPECT_EQ(0, parser_->httpMajor());
+  EXPECT_EQ(9, parser_->httpMinor());
+}
+
+TEST_P(VectorizedParserImplTest, Eof) {
+  initialize(ParserType::Request);
+  EXPECT_EQ(0U, parser_->execute(nullptr, 0));
+  EXPECT_EQ(HPE_OK, parser_->error());
+
+  initialize(ParserType::Request);
+  execute("GET / HTTP/1.1\r\n");
+  parser_->execute(nullptr, 0);
+  EXPECT_EQ(HPE_INVALID_EOF_STATE, parser_->error());
+}
+
+TEST_P(VectorizedParserImplTest, Errors) {
+  expectError(ParserType::Request, "get / HTTP/1.1\r\n", HPE_INVALID_METHOD);
+  expectError(ParserType::Request, "GETT / HTTP/1.1\r\n", HPE_INVALID_METHOD);
+  expectError(ParserType::Request, "GET \x01 HTTP/1.1\r\n", HPE_INVALID_URL);
+  expectError(ParserType::Request, "GET # HTTP/1.1\r\n", HPE_INVALID_URL);
+  expectError(ParserType::Request, "GET / HTTX/1.1\r\n", HPE_INVALID_CONSTANT);
+  expectError(ParserType::Request, "GET / HTTP/1.x\r\n", HPE_INVALID_VERSION);
+  expectError(ParserType::Request, "GET / HTTP/1.1\rx", HPE_LF_EXPECTED);
+  expectError(ParserType::Request, "GET / HTTP/1.1\r\nbad name: x\r\n", HPE_INVALID_HEADER_TOKEN);
+  expectError(ParserType::Request, "GET / HTTP/1.1\r\n: x\r\n", HPE_INVALID_HEADER_TOKEN);
+  expectError(ParserType::Request, "GET / HTTP/1.1\r\na: x\x7f\r\n", HPE_INVALID_HEADER_TOKEN);
+  expectError(ParserType::Response, "XTTP/1.1 200 OK\r\n", HPE_INVALID_CONSTANT);
+  expectError(ParserType::Response, "HTTP/1.1 20 OK\r\n", HPE_INVALID_STATUS);
+  expectError(ParserType::Response, "HTTP/1.1 2000 OK\r\n", HPE_INVALID_STATUS);
+}
+
+TEST_P(VectorizedParserImplTest, ObsFold) {
+  expectError(ParserType::Request, "GET / HTTP/1.1\r\na: b\r\n c\r\n\r\n",
+              HPE_INVALID_HEADER_TOKEN);
+}
+
+TEST_P(VectorizedParserImplTest, FramingErrors) {
+  expectError(ParserType::Request, "POST / HTTP/1.1\r\ncontent-length: 1x\r\n",
+              HPE_INVALID_CONTENT_LENGTH);
+  expectError(ParserType::Request, "POST / HTTP/1.1\r\ncontent-length:\r\n",
+              HPE_INVALID_CONTENT_LENGTH);
+  expectError(ParserType::Request,
+              "POST / HTTP/1.1\r\ncontent-length: 99999999999999999999\r\n",
+              HPE_INVALID_CONTENT_LENGTH);
+  expectError(ParserType::Request, "POST / HTTP/1.1\r\ncontent-length: 1\r\ncontent-length: 1\r\n",
+              HPE_UNEXPECTED_CONTENT_LENGTH);
+  expectError(ParserType::Request,
+              "POST / HTTP/1.1\r\ncontent-length: 1\r\ntransfer-encoding: chunked\r\n\r\n",
+              HPE_UNEXPECTED_CONTENT_LENGTH);
+  expectError(ParserType::Request,
+              "POST / HTTP/1.1\r\ntransfer-encoding: chunked\r\n\r\nx\r\n",
+              HPE_INVALID_CHUNK_SIZE);
+  expectError(ParserType::Request,
+              "POST / HTTP/1.1\r\ntransfer-encoding: chunked\r\n\r\n1\r\nab\r\n",
+              HPE_INVALID_CHUNK_SIZE);
+  expectError(ParserType::Request,
+              "POST / HTTP/1.1\r\ntransfer-encoding: chunked\r\n\r\n11111111111111111\r\n",
+              HPE_INVALID_CONTENT_LENGTH);
+}
+
+TEST_P(VectorizedParserImplTest, HeaderOverflow) {
+  const std::string headers =
+      "GET / HTTP/1.1\r\n" + std::string(VectorizedParserImpl::MaxHeaderSize, 'a');
+  initialize(ParserType::Request);
+  executeInPieces(headers, 1000);
+  EXPECT_EQ(HPE_HEADER_OVERFLOW, parser_->error());
+
+  // The limit applies to each message.
+  std::string data;
+  for (int i = 0; i < 20; i++) {
+    data += "GET / HTTP/1.1\r\nx: " + std::string(8 * 1024, 'a') + "\r\n\r\n";
+  }
+  initialize(ParserType::Request);
+  EXPECT_EQ(data.size(), execute(data));
+  EXPECT_EQ(HPE_OK, parser_->error());
+}
+
+TEST_P(VectorizedParserImplTest, ErrorIsSticky) {
+  expectError(ParserType::Request, "BAD!", HPE_INVALID_METHOD);
+  EXPECT_EQ(0U, execute("GET / HTTP/1.1\r\n\r\n"));
+  EXPECT_EQ(HPE_INVALID_METHOD, parser_->error());
+}
+
+class ScannerTest : public ScannerImplTestBase {
+public:
+  size_t valueEnd(const std::string& data) {
+    return Scanner::findValueEnd(data.data(), data.data() + data.size()) - data.data();
+  }
+  size_t targetEnd(const std::string& data) {
+    return Scanner::findTargetEnd(data.data(), data.data() + data.size()) - data.data();
+  }
+};
+
+INSTANTIATE_TEST_CASE_P(ScannerImpls, ScannerTest, ::testing::ValuesIn(supportedScannerImpls()));
+
+// Every byte value at every offset, in spans longer than any vector width.
+TEST_P(ScannerTest, AllBytesAllOffsets) {
+  EXPECT_EQ(0U, valueEnd(""));
+  EXPECT_EQ(0U, targetEnd(""));
+  for (size_t c = 0; c < 256; c++) {
+    const bool ends_value = (c < 0x20 && c != '\t') || c == 0x7f;
+    const bool ends_target = c <= 0x20 || c == 0x7f;
+    for (size_t offset = 0; offset < 70; offset++) {
+      std::string data(offset, 'a');
+      data.push_back(static_cast<char>(c));
+      data.append(40, 'b');
+      EXPECT_EQ(ends_value ? offset : data.size(), valueEnd(data)) << c << " at " << offset;
+      EXPECT_EQ(ends_target ? offset : data.size(), targetEnd(data)) << c << " at " << offset;
+    }
+  }
+}
+
+TEST_P(ScannerTest, FirstOfSeveral) {
+  std::string data(100, 'x');
+  data[37] = '\r';
+  data[38] = '\n';
+  data[60] = ' ';
+  data[70] = '\x7f';
+  EXPECT_EQ(37U, valueEnd(data));
+  EXPECT_EQ(37U, targetEnd(data));
+
+  data[37] = data[38] = '\t';
+  EXPECT_EQ(70U, valueEnd(data));
+  EXPECT_EQ(37U, targetEnd(data));
+}
+
+} // namespace
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
@@ -753,6 +753,98 @@ TEST_P(Http2CodecImplTest, TestCodecHeaderLimits) {
   request_encoder_->encodeHeaders(request_headers, false);
 }
 
+TEST_P(Http2CodecImplTest, HeaderCompressionStats) {
+  initialize();
+
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, true));
+  request_encoder_->encodeHeaders(request_headers, true);
+
+  TestHeaderMapImpl response_headers{{":status", "200"}};
+  EXPECT_CALL(response_decoder_, decodeHeaders_(_, true));
+  response_encoder_->encodeHeaders(response_headers, true);
+
+  // The client and server share a stats store, so everything sent is also counted as received.
+  const uint64_t header_bytes = stats_store_.counter("http2.tx_header_bytes").value();
+  const uint64_t compressed_bytes = stats_store_.counter("http2.tx_header_bytes_compressed").value();
+  EXPECT_EQ(request_headers.byteSize() + response_headers.byteSize(), header_bytes);
+  EXPECT_EQ(header_bytes, stats_store_.counter("http2.rx_header_bytes").value());
+  EXPECT_EQ(compressed_bytes, stats_store_.counter("http2.rx_header_bytes_compressed").value());
+  EXPECT_LT(compressed_bytes, header_bytes);
+  EXPECT_EQ(0, stats_store_.counter("http2.tx_header_never_indexed").value());
+}
+
+class Http2CodecImplHpackTest : public testing::Test {
+public:
+  Http2CodecImplHpackTest()
+      : client_(client_connection_, client_callbacks_, stats_store_, clientSettings()),
+        server_(server_connection_, server_callbacks_, stats_store_, Http2Settings()) {
+    ON_CALL(client_connection_, write(_, _))
+        .WillByDefault(Invoke([&](Buffer::Instance& data, bool) -> void {
+          server_wrapper_.dispatch(data, server_);
+        }));
+    ON_CALL(server_connection_, write(_, _))
+        .WillByDefault(Invoke([&](Buffer::Instance& data, bool) -> void {
+          client_wrapper_.dispatch(data, client_);
+        }));
+  }
+
+  static Http2Settings clientSettings() {
+    Http2Settings http2_settings;
+    http2_settings.hpack_never_index_headers_ =
+        std::make_shared<std::vector<LowerCaseString>>(1, LowerCaseString("x-request-id"));
+    return http2_settings;
+  }
+
+  // Send a header only request on a new stream and return the size of its header block.
+  uint64_t sendRequest(const TestHeaderMapImpl& request_headers) {
+    response_decoders_.emplace_back(new MockStreamDecoder());
+    request_decoders_.emplace_back(new MockStreamDecoder());
+    StreamEncoder& request_encoder = client_.newStream(*response_decoders_.back());
+    EXPECT_CALL(server_callbacks_, newStream(_))
+        .WillOnce(Invoke([&](StreamEncoder&) -> StreamDecoder& {
+          return *request_decoders_.back();
+        }));
+    EXPECT_CALL(*request_decoders_.back(), decodeHeaders_(HeaderMapEqual(&request_headers), true));
+
+    Stats::Counter& compressed_bytes = stats_store_.counter("http2.tx_header_bytes_compressed");
+    const uint64_t compressed_bytes_before = compressed_bytes.value();
+    request_encoder.encodeHeaders(request_headers, true);
+    return compressed_bytes.value() - compressed_bytes_before;
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  NiceMock<Network::MockConnection> client_connection_;
+  MockConnectionCallbacks client_callbacks_;
+  TestClientConnectionImpl client_;
+  Http2CodecImplTest::ConnectionWrapper client_wrapper_;
+  NiceMock<Network::MockConnection> server_connection_;
+  MockServerConnectionCallbacks server_callbacks_;
+  TestServerConnectionImpl server_;
+  Http2CodecImplTest::ConnectionWrapper server_wrapper_;
+  std::vector<std::unique_ptr<MockStreamDecoder>> response_decoders_;
+  std::vector<std::unique_ptr<MockStreamDecoder>> request_decoders_;
+};
+
+TEST_F(Http2CodecImplHpackTest, NeverIndexHeaders) {
+  const std::string request_id = "2e1c9a6d-1f7a-4bb9-8f4f-6a0e5c2a8a11";
+  TestHeaderMapImpl request_headers{{"x-request-id", request_id}, {"x-trace-id", request_id}};
+  HttpTestUtility::addDefaultHeaders(request_headers);
+
+  const uint64_t first_request_bytes = sendRequest(request_headers);
+  const uint64_t second_request_bytes = sendRequest(request_headers);
+  EXPECT_EQ(2, stats_store_.counter("http2.tx_header_never_indexed").value());
+
+  // The first request sends both IDs as literals. The second request refers to the indexed
+  // x-trace-id, but still sends x-request-id as a literal, which even Huffman coded takes more
+  // than half the length of the ID.
+  EXPECT_GT(first_request_bytes, request_id.size());
+  EXPECT_GT(second_request_bytes, request_id.size() / 2);
+  EXPECT_LT(second_request_bytes, first_request_bytes - request_id.size() / 2);
+  EXPECT_LT(0, stats_store_.gauge("http2.hpack_encoder_table_bytes").value());
+}
+
 } // namespace Http2
 } // namespace Http
 } // namespace Envoy
@@ -140,6 +140,10 @@ TEST(HttpUtility, parseHttp2Settings) {
               http2_settings.initial_stream_window_size_);
     EXPECT_EQ(Http2Settings::DEFAULT_INITIAL_CONNECTION_WINDOW_SIZE,
               http2_settings.initial_connection_window_size_);
+    EXPECT_EQ(Http2Settings::DEFAULT_MAX_CONNECTIONS_PER_HOST,
+              http2_settings.max_connections_per_host_);
+    EXPECT_EQ(Http2Settings::DEFAULT_HPACK_TABLE_SIZE, http2_settings.hpack_encoder_table_size_);
+    EXPECT_EQ(nullptr, http2_settings.hpack_never_index_headers_);
   }
 
   {
@@ -156,6 +160,17 @@ TEST(HttpUtility, parseHttp2Settings) {
     EXPECT_EQ(3U, http2_settings.initial_stream_window_size_);
     EXPECT_EQ(4U, http2_settings.initial_connection_window_size_);
   }
+
+  {
+    envoy::api::v2::core::Http2ProtocolOptions http2_protocol_options;
+    http2_protocol_options.mutable_hpack_encoder_table_size()->set_value(0);
+    http2_protocol_options.add_hpack_never_index_headers("x-request-id");
+    auto http2_settings = Utility::parseHttp2Settings(http2_protocol_options);
+    EXPECT_EQ(0U, http2_settings.hpack_encoder_table_size_);
+    ASSERT_NE(nullptr, http2_settings.hpack_never_index_headers_);
+    ASSERT_EQ(1U, http2_settings.hpack_never_index_headers_->size());
+    EXPECT_EQ("x-request-id", (*http2_settings.hpack_never_index_headers_)[0].get());
+  }
 }
 
 TEST(HttpUtility, getLastAddressFromXFF) {
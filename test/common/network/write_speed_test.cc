@@ -0,0 +1,144 @@
+// Usage: bazel run //test/common/network:write_speed_test
+//
+// Measures writing 1MiB response bodies to a loopback TCP connection, as a proxy does when
+// downloading a large object: the body arrives as 16KiB upstream reads and is written to the
+// downstream socket as fast as the peer drains it. The socket buffers are limited to 128KiB so
+// that, like a real downstream connection, a body takes several writes. Reports the number of
+// write system calls per body for each write path. Note that the kernel always copies
+// MSG_ZEROCOPY writes to loopback peers, so the zero copy numbers show the system call pattern
+// rather than the copy savings.
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/network/zero_copy.h"
+
+#include "testing/base/public/benchmark.h"
+
+namespace Envoy {
+namespace Network {
+namespace {
+
+constexpr uint64_t BodySize = 1024 * 1024;
+constexpr uint64_t ReadSize = 16384;
+
+enum class WriteMode { LibeventWritev = 0, NativeWritev = 1, NativeZeroCopy = 2 };
+
+// A connected pair of non-blocking loopback TCP sockets.
+class LoopbackConnection {
+public:
+  LoopbackConnection() {
+    const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    RELEASE_ASSERT(listener != -1);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_length = sizeof(address);
+    RELEASE_ASSERT(::bind(listener, reinterpret_cast<sockaddr*>(&address), address_length) == 0);
+    RELEASE_ASSERT(::listen(listener, 1) == 0);
+    RELEASE_ASSERT(::getsockname(listener, reinterpret_cast<sockaddr*>(&address),
+                                 &address_length) == 0);
+
+    writer_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    RELEASE_ASSERT(writer_ != -1);
+    const int buffer_size = 128 * 1024;
+    ::setsockopt(writer_, SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+    ::setsockopt(listener, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    const int rc = ::connect(writer_, reinterpret_cast<sockaddr*>(&address), address_length);
+    RELEASE_ASSERT(rc == 0 || errno == EINPROGRESS);
+    reader_ = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK);
+    RELEASE_ASSERT(reader_ != -1);
+    ::close(listener);
+  }
+
+  ~LoopbackConnection() {
+    ::close(writer_);
+    ::close(reader_);
+  }
+
+  // Read everything the peer has received so far.
+  void drain() {
+    while (::recv(reader_, scratch_.data(), scratch_.size(), 0) > 0) {
+    }
+  }
+
+  int writer_;
+  int reader_;
+  std::vector<uint8_t> scratch_ = std::vector<uint8_t>(256 * 1024);
+};
+
+static void BM_Download1MiB(benchmark::State& state) {
+  const WriteMode mode = static_cast<WriteMode>(state.range(0));
+  const bool previous_impl = Buffer::OwnedImpl::newBuffersUseOldImpl();
+  Buffer::OwnedImpl::useOldImpl(mode == WriteMode::LibeventWritev);
+
+  LoopbackConnection connection;
+  ZeroCopyWrites zero_copy_writes;
+  if (mode == WriteMode::NativeZeroCopy && !ZeroCopyWrites::enable(connection.writer_)) {
+    state.SkipWithError("MSG_ZEROCOPY is not supported");
+    Buffer::OwnedImpl::useOldImpl(previous_impl);
+    return;
+  }
+
+  const std::vector<uint8_t> chunk(ReadSize, 'a');
+  uint64_t write_calls = 0;
+  uint64_t completion_calls = 0;
+  for (auto _ : state) {
+    Buffer::OwnedImpl body;
+    for (uint64_t i = 0; i < BodySize / ReadSize; i++) {
+      body.add(chunk.data(), chunk.size());
+    }
+
+    while (body.length() != 0) {
+      const int rc = mode == WriteMode::NativeZeroCopy
+                         ? zero_copy_writes.write(connection.writer_, body)
+                         : body.write(connection.writer_);
+      write_calls++;
+      if (rc == -1) {
+        RELEASE_ASSERT(errno == EAGAIN);
+        connection.drain();
+      }
+    }
+    connection.drain();
+
+    // Release the memory of completed zero copy writes. The connection's write path does this
+    // when the socket reports an error event, which is what poll() waits for here.
+    while (!zero_copy_writes.empty()) {
+      pollfd error_event{connection.writer_, 0, 0};
+      RELEASE_ASSERT(::poll(&error_event, 1, 1000) == 1);
+      zero_copy_writes.processCompletions(connection.writer_);
+      completion_calls++;
+    }
+  }
+
+  state.SetBytesProcessed(state.iterations() * BodySize);
+  state.counters["write_calls_per_body"] = static_cast<double>(write_calls) / state.iterations();
+  state.counters["completion_calls_per_body"] =
+      static_cast<double>(completion_calls) / state.iterations();
+  Buffer::OwnedImpl::useOldImpl(previous_impl);
+}
+BENCHMARK(BM_Download1MiB)
+    ->Arg(static_cast<int>(WriteMode::LibeventWritev))
+    ->Arg(static_cast<int>(WriteMode::NativeWritev))
+    ->Arg(static_cast<int>(WriteMode::NativeZeroCopy));
+
+} // namespace
+} // namespace Network
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
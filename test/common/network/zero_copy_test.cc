@@ -0,0 +1,263 @@
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/buffer/watermark_buffer.h"
+#include "common/event/dispatcher_impl.h"
+#include "common/network/zero_copy.h"
+
+#include "test/common/buffer/utility.h"
+#include "test/mocks/api/mocks.h"
+#include "test/mocks/event/mocks.h"
+#include "test/test_common/threadsafe_singleton_injector.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Network {
+namespace {
+
+class ZeroCopyWritesTest : public Buffer::BufferImplementationParamTest {
+public:
+  void SetUp() override {
+    const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_NE(-1, listener);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_length = sizeof(address);
+    ASSERT_EQ(0, ::bind(listener, reinterpret_cast<sockaddr*>(&address), address_length));
+    ASSERT_EQ(0, ::listen(listener, 1));
+    ASSERT_EQ(0, ::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &address_length));
+    writer_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(0, ::connect(writer_, reinterpret_cast<sockaddr*>(&address), address_length));
+    reader_ = ::accept(listener, nullptr, nullptr);
+    ASSERT_NE(-1, reader_);
+    ::close(listener);
+  }
+
+  void TearDown() override {
+    ::close(writer_);
+    ::close(reader_);
+  }
+
+  int writer_{-1};
+  int reader_{-1};
+};
+
+INSTANTIATE_TEST_CASE_P(ZeroCopyWritesTest, ZeroCopyWritesTest,
+                        testing::ValuesIn({Buffer::BufferImplementation::New}));
+
+TEST_P(ZeroCopyWritesTest, WriteAndComplete) {
+  if (!ZeroCopyWrites::supported() || !ZeroCopyWrites::enable(writer_)) {
+    // MSG_ZEROCOPY needs Linux 4.14 or later.
+    return;
+  }
+
+  bool released = false;
+  const std::string data(64 * 1024, 'z');
+  Buffer::BufferFragmentImpl fragment(
+      data.data(), data.size(),
+      [&](const void*, size_t, const Buffer::BufferFragmentImpl*) { released = true; });
+  Buffer::OwnedImpl buffer;
+  verifyImplementation(buffer);
+  buffer.add("hello");
+  buffer.addBufferFragment(fragment);
+
+  ZeroCopyWrites writes;
+  const uint64_t length = buffer.length();
+  uint64_t written = 0;
+  while (written < length) {
+    const int rc = writes.write(writer_, buffer);
+    ASSERT_GT(rc, 0);
+    written += rc;
+  }
+  EXPECT_EQ(0, buffer.length());
+  EXPECT_FALSE(writes.empty());
+  EXPECT_FALSE(released);
+
+  std::string received(length, '\0');
+  uint64_t bytes_received = 0;
+  while (bytes_received < length) {
+    const ssize_t rc = ::recv(reader_, &received[bytes_received], length - bytes_received, 0);
+    ASSERT_GT(rc, 0);
+    bytes_received += rc;
+  }
+  EXPECT_EQ("hello" + data, received);
+
+  while (!writes.empty()) {
+    pollfd error_event{writer_, 0, 0};
+    ASSERT_EQ(1, ::poll(&error_event, 1, 5000));
+    writes.processCompletions(writer_);
+  }
+  EXPECT_TRUE(released);
+  // Loopback peers always get a copy.
+  EXPECT_TRUE(writes.copied());
+}
+
+// Zero copy writes move the written slices out of the buffer instead of draining it, which must
+// still let a watermark buffer re-enable writes to it.
+TEST_P(ZeroCopyWritesTest, WatermarkBufferLowWatermark) {
+  if (!ZeroCopyWrites::supported() || !ZeroCopyWrites::enable(writer_)) {
+    return;
+  }
+
+  uint32_t below_low = 0;
+  uint32_t above_high = 0;
+  Buffer::WatermarkBuffer buffer([&below_low]() { ++below_low; },
+                                 [&above_high]() { ++above_high; });
+  verifyImplementation(buffer);
+  buffer.setWatermarks(4 * 1024, 16 * 1024);
+  buffer.add(std::string(32 * 1024, 'z'));
+  EXPECT_EQ(1, above_high);
+
+  ZeroCopyWrites writes;
+  const uint64_t length = buffer.length();
+  uint64_t written = 0;
+  while (written < length) {
+    const int rc = writes.write(writer_, buffer);
+    ASSERT_GT(rc, 0);
+    written += rc;
+  }
+  EXPECT_EQ(0, buffer.length());
+  EXPECT_EQ(1, below_low);
+
+  std::string received(length, '\0');
+  uint64_t bytes_received = 0;
+  while (bytes_received < length) {
+    const ssize_t rc = ::recv(reader_, &received[bytes_received], length - bytes_received, 0);
+    ASSERT_GT(rc, 0);
+    bytes_received += rc;
+  }
+  while (!writes.empty()) {
+    pollfd error_event{writer_, 0, 0};
+    ASSERT_EQ(1, ::poll(&error_event, 1, 5000));
+    writes.processCompletions(writer_);
+  }
+}
+
+TEST_P(ZeroCopyWritesTest, NoCompletionsPending) {
+  ZeroCopyWrites writes;
+  EXPECT_TRUE(writes.empty());
+  writes.processCompletions(writer_);
+  EXPECT_TRUE(writes.empty());
+  EXPECT_FALSE(writes.copied());
+}
+
+TEST_P(ZeroCopyWritesTest, LingerResetOnDispatcherShutdown) {
+  if (!ZeroCopyWrites::supported() || !ZeroCopyWrites::enable(writer_)) {
+    return;
+  }
+
+  bool released = false;
+  const std::string data(1024 * 1024, 'z');
+  Buffer::BufferFragmentImpl fragment(
+      data.data(), data.size(),
+      [&](const void*, size_t, const Buffer::BufferFragmentImpl*) { released = true; });
+  ZeroCopyWritesPtr writes = std::make_unique<ZeroCopyWrites>();
+  {
+    Buffer::OwnedImpl buffer;
+    verifyImplementation(buffer);
+    buffer.addBufferFragment(fragment);
+    // Nothing reads from the other end, so the socket fills up and the writes stay pending.
+    ASSERT_EQ(0, ::fcntl(writer_, F_SETFL, O_NONBLOCK));
+    while (buffer.length() > 0 && writes->write(writer_, buffer) > 0) {
+    }
+    buffer.drain(buffer.length());
+  }
+  writes->processCompletions(writer_);
+  ASSERT_FALSE(writes->empty());
+
+  {
+    Event::DispatcherImpl dispatcher;
+    ZeroCopyLinger::start(dispatcher, writer_, std::move(writes));
+    ::close(writer_);
+    writer_ = -1;
+    EXPECT_FALSE(released);
+  }
+  EXPECT_TRUE(released);
+
+  // The pending linger reset the connection rather than leaving the kernel with released memory.
+  char received[64 * 1024];
+  ssize_t rc;
+  while ((rc = ::recv(reader_, received, sizeof(received), 0)) > 0) {
+  }
+  EXPECT_EQ(-1, rc);
+  EXPECT_EQ(ECONNRESET, errno);
+}
+
+class ZeroCopyLingerTest : public Buffer::BufferImplementationParamTest {
+public:
+  // Leaves writes_ with a write of "hello" on fd 5 that has not completed.
+  void SetUp() override {
+    if (!ZeroCopyWrites::supported()) {
+      return;
+    }
+    Buffer::OwnedImpl buffer("hello");
+    verifyImplementation(buffer);
+    EXPECT_CALL(os_sys_calls_, sendmsg(5, _, _)).WillOnce(Return(5));
+    EXPECT_EQ(5, writes_->write(5, buffer));
+    ON_CALL(os_sys_calls_, recvmsg(_, _, MSG_ERRQUEUE)).WillByDefault(Return(-1));
+  }
+
+  NiceMock<Api::MockOsSysCalls> os_sys_calls_;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls_{&os_sys_calls_};
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  ZeroCopyWritesPtr writes_{new ZeroCopyWrites()};
+};
+
+INSTANTIATE_TEST_CASE_P(ZeroCopyLingerTest, ZeroCopyLingerTest,
+                        testing::ValuesIn({Buffer::BufferImplementation::New}));
+
+// When the socket cannot be duplicated, closing it resets the connection and the caller keeps the
+// writes.
+TEST_P(ZeroCopyLingerTest, DupFailure) {
+  if (!ZeroCopyWrites::supported()) {
+    return;
+  }
+
+  EXPECT_CALL(os_sys_calls_, dup(5)).WillOnce(Return(-1));
+  EXPECT_CALL(os_sys_calls_, setsockopt_(5, SOL_SOCKET, SO_LINGER, _, sizeof(linger)));
+  ZeroCopyLinger::start(dispatcher_, 5, std::move(writes_));
+  ASSERT_NE(nullptr, writes_);
+  EXPECT_FALSE(writes_->empty());
+  EXPECT_TRUE(dispatcher_.owned_.empty());
+}
+
+// The linger shuts down the duplicate in place of the close, and resets the connection if the
+// writes do not complete in time.
+TEST_P(ZeroCopyLingerTest, Timeout) {
+  if (!ZeroCopyWrites::supported()) {
+    return;
+  }
+
+  EXPECT_CALL(os_sys_calls_, dup(5)).WillOnce(Return(6));
+  EXPECT_CALL(os_sys_calls_, shutdown(6, SHUT_WR));
+  EXPECT_CALL(dispatcher_, createFileEvent_(6, _, _, _))
+      .WillOnce(Return(new NiceMock<Event::MockFileEvent>()));
+  Event::MockTimer* timer = new Event::MockTimer(&dispatcher_);
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(30000)));
+  ZeroCopyLinger::start(dispatcher_, 5, std::move(writes_));
+  EXPECT_EQ(1, dispatcher_.owned_.size());
+
+  EXPECT_CALL(os_sys_calls_, setsockopt_(6, SOL_SOCKET, SO_LINGER, _, sizeof(linger)));
+  EXPECT_CALL(os_sys_calls_, close(6));
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  timer->callback_();
+  EXPECT_TRUE(dispatcher_.owned_.empty());
+}
+
+} // namespace
+} // namespace Network
+} // namespace Envoy
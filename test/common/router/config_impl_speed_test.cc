@@ -0,0 +1,131 @@
+#include <string>
+#include <vector>
+
+#include "envoy/api/v2/rds.pb.h"
+
+#include "common/common/fmt.h"
+#include "common/router/config_impl.h"
+
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "testing/base/public/benchmark.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Router {
+
+// Build a single virtual host whose routes are a mix of exact paths and prefixes, as generated by
+// API gateways that expose one route per endpoint. Every tenth route is a prefix, and the table
+// ends with a catch-all route.
+static envoy::api::v2::RouteConfiguration genRouteConfig(size_t num_routes) {
+  envoy::api::v2::RouteConfiguration route_config;
+  auto* virtual_host = route_config.add_virtual_hosts();
+  virtual_host->set_name("service");
+  virtual_host->add_domains("*");
+  for (size_t i = 0; i < num_routes; i++) {
+    auto* route = virtual_host->add_routes();
+    if (i % 10 == 0) {
+      route->mutable_match()->set_prefix(fmt::format("/service/{}/", i));
+    } else {
+      route->mutable_match()->set_path(fmt::format("/api/v1/resource/{}", i));
+    }
+    route->mutable_route()->set_cluster(fmt::format("cluster_{}", i));
+  }
+  auto* route = virtual_host->add_routes();
+  route->mutable_match()->set_prefix("/");
+  route->mutable_route()->set_cluster("default");
+  return route_config;
+}
+
+// Test routing requests that match routes spread evenly over the table, as well as requests that
+// fall through to the catch-all route.
+static void BM_RouteTableMatch(benchmark::State& state) {
+  const size_t num_routes = state.range(0);
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  ConfigImpl config(genRouteConfig(num_routes), factory_context, false);
+
+  std::vector<Http::TestHeaderMapImpl> requests;
+  for (size_t i = 0; i < num_routes; i += num_routes / 16 + 1) {
+    const std::string path = i % 10 == 0 ? fmt::format("/service/{}/item?id=1", i)
+                                         : fmt::format("/api/v1/resource/{}", i);
+    requests.push_back(Http::TestHeaderMapImpl{
+        {":authority", "service.example.com"}, {":path", path}, {":method", "GET"}});
+  }
+  requests.push_back(Http::TestHeaderMapImpl{
+      {":authority", "service.example.com"}, {":path", "/not/found"}, {":method", "GET"}});
+
+  size_t matched = 0;
+  for (auto _ : state) {
+    for (const Http::TestHeaderMapImpl& request : requests) {
+      matched += config.route(request, 0) != nullptr;
+    }
+  }
+  benchmark::DoNotOptimize(matched);
+}
+BENCHMARK(BM_RouteTableMatch)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+// Build one virtual host per tenant of a multi-tenant service. Each tenant has an exact domain, a
+// suffix wildcard domain and a prefix wildcard domain, and there is a default virtual host.
+static envoy::api::v2::RouteConfiguration genVirtualHostConfig(size_t num_virtual_hosts) {
+  envoy::api::v2::RouteConfiguration route_config;
+  for (size_t i = 0; i < num_virtual_hosts; i++) {
+    auto* virtual_host = route_config.add_virtual_hosts();
+    virtual_host->set_name(fmt::format("tenant_{}", i));
+    virtual_host->add_domains(fmt::format("tenant-{}.example.com", i));
+    virtual_host->add_domains(fmt::format("*.tenant-{}.example.com", i));
+    virtual_host->add_domains(fmt::format("tenant-{}.internal.*", i));
+    auto* route = virtual_host->add_routes();
+    route->mutable_match()->set_prefix("/");
+    route->mutable_route()->set_cluster(fmt::format("cluster_{}", i));
+  }
+  auto* virtual_host = route_config.add_virtual_hosts();
+  virtual_host->set_name("default");
+  virtual_host->add_domains("*");
+  auto* route = virtual_host->add_routes();
+  route->mutable_match()->set_prefix("/");
+  route->mutable_route()->set_cluster("default");
+  return route_config;
+}
+
+// Test finding the virtual host for hosts that match each kind of domain, in mixed case, as well
+// as hosts that fall through to the default virtual host.
+static void BM_VirtualHostMatch(benchmark::State& state) {
+  const size_t num_virtual_hosts = state.range(0);
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  ConfigImpl config(genVirtualHostConfig(num_virtual_hosts), factory_context, false);
+
+  std::vector<Http::TestHeaderMapImpl> requests;
+  for (size_t i = 0; i < num_virtual_hosts; i += num_virtual_hosts / 16 + 1) {
+    for (const std::string& host :
+         {fmt::format("tenant-{}.example.com", i), fmt::format("API.Tenant-{}.Example.com", i),
+          fmt::format("tenant-{}.internal.cluster.local", i)}) {
+      requests.push_back(
+          Http::TestHeaderMapImpl{{":authority", host}, {":path", "/"}, {":method", "GET"}});
+    }
+  }
+  requests.push_back(Http::TestHeaderMapImpl{
+      {":authority", "unknown.example.org"}, {":path", "/"}, {":method", "GET"}});
+
+  size_t matched = 0;
+  for (auto _ : state) {
+    for (const Http::TestHeaderMapImpl& request : requests) {
+      matched += config.route(request, 0) != nullptr;
+    }
+  }
+  benchmark::DoNotOptimize(matched);
+}
+BENCHMARK(BM_VirtualHostMatch)->Arg(10)->Arg(1000)->Arg(50000);
+
+} // namespace Router
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -531,6 +531,52 @@ virtual_hosts:
 }
 
 // Validates behavior of request_headers_to_add at router, vhost, and route levels.
+// Exact domains take precedence over suffix wildcards, which take precedence over prefix
+// wildcards, which take precedence over the default virtual host.
+TEST(RouteMatcherTest, PrefixAndSuffixWildcardDomains) {
+  const std::string yaml = R"EOF(
+name: foo
+virtual_hosts:
+  - name: exact
+    domains: ["www.lyft.com"]
+    routes:
+      - match: { prefix: "/" }
+        route: { cluster: exact }
+  - name: suffix
+    domains: ["*.lyft.com"]
+    routes:
+      - match: { prefix: "/" }
+        route: { cluster: suffix }
+  - name: prefix
+    domains: ["www.*", "api-*"]
+    routes:
+      - match: { prefix: "/" }
+        route: { cluster: prefix }
+  - name: default
+    domains: ["*"]
+    routes:
+      - match: { prefix: "/" }
+        route: { cluster: default }
+)EOF";
+
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  ConfigImpl config(parseRouteConfigurationFromV2Yaml(yaml), factory_context, true);
+
+  EXPECT_EQ("exact",
+            config.route(genHeaders("WWW.lyft.com", "/", "GET"), 0)->routeEntry()->clusterName());
+  EXPECT_EQ("suffix",
+            config.route(genHeaders("api.lyft.com", "/", "GET"), 0)->routeEntry()->clusterName());
+  EXPECT_EQ("prefix",
+            config.route(genHeaders("www.lyft.net", "/", "GET"), 0)->routeEntry()->clusterName());
+  EXPECT_EQ(
+      "prefix",
+      config.route(genHeaders("api-staging.lyft.net", "/", "GET"), 0)->routeEntry()->clusterName());
+  EXPECT_EQ("default",
+            config.route(genHeaders("www.", "/", "GET"), 0)->routeEntry()->clusterName());
+  EXPECT_EQ("default",
+            config.route(genHeaders("lyft.com", "/", "GET"), 0)->routeEntry()->clusterName());
+}
+
 TEST(RouteMatcherTest, TestAddRemoveRequestHeaders) {
   std::string json = R"EOF(
 {
@@ -1193,6 +1239,58 @@ TEST(RouteMatcherTest, QueryParamMatchedRouting) {
   }
 }
 
+// Routes are indexed by path, but the first route in configuration order that matches must win
+// regardless of the kind of path match each route uses.
+TEST(RouteMatcherTest, FirstMatchAcrossPathMatchTypes) {
+  const std::string yaml = R"EOF(
+virtual_hosts:
+  - name: www2
+    domains: ["*"]
+    routes:
+      - match:
+          prefix: "/api"
+          headers:
+            - name: x-canary
+              exact_match: "true"
+        route: { cluster: canary }
+      - match: { regex: "/api/v[0-9]+/users" }
+        route: { cluster: users_regex }
+      - match: { path: "/api/v1/users" }
+        route: { cluster: users_path }
+      - match: { prefix: "/API/V1", case_sensitive: false }
+        route: { cluster: v1 }
+      - match: { path: "/api/v2/users" }
+        route: { cluster: users_v2 }
+      - match: { prefix: "/api/v2" }
+        route: { cluster: v2 }
+      - match: { prefix: "/" }
+        route: { cluster: default }
+  )EOF";
+
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  ConfigImpl config(parseRouteConfigurationFromV2Yaml(yaml), factory_context, false);
+
+  EXPECT_EQ("users_regex", config.route(genHeaders("www.lyft.com", "/api/v1/users", "GET"), 0)
+                               ->routeEntry()
+                               ->clusterName());
+  EXPECT_EQ("users_regex", config.route(genHeaders("www.lyft.com", "/api/v2/users?a=b", "GET"), 0)
+                               ->routeEntry()
+                               ->clusterName());
+  EXPECT_EQ("v1", config.route(genHeaders("www.lyft.com", "/Api/v1/Users", "GET"), 0)
+                      ->routeEntry()
+                      ->clusterName());
+  EXPECT_EQ("v2", config.route(genHeaders("www.lyft.com", "/api/v2/groups", "GET"), 0)
+                      ->routeEntry()
+                      ->clusterName());
+  EXPECT_EQ("default", config.route(genHeaders("www.lyft.com", "/API/V2", "GET"), 0)
+                           ->routeEntry()
+                           ->clusterName());
+
+  Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/api/v1/users", "GET");
+  headers.addCopy("x-canary", "true");
+  EXPECT_EQ("canary", config.route(headers, 0)->routeEntry()->clusterName());
+}
+
 // Verify the fixes for https://github.com/envoyproxy/envoy/issues/2406
 TEST(RouteMatcherTest, InvalidQueryParamMatchedRoutingConfig) {
   std::string value_with_regex_chars = R"EOF(
@@ -3974,6 +4072,68 @@ virtual_hosts:
   EXPECT_EQ("foo", route_entry->virtualHost().routeConfig().name());
 }
 
+// Virtual hosts whose configuration is unchanged are shared with the previous version of a route
+// configuration, as long as the parts of the configuration that all virtual hosts share are
+// unchanged too.
+TEST(RouteConfigurationV2, SharesUnchangedVirtualHosts) {
+  const std::string yaml = R"EOF(
+name: foo
+virtual_hosts:
+  - name: bar
+    domains: ["bar.lyft.com"]
+    routes:
+      - match: { prefix: "/" }
+        route: { cluster: bar }
+  - name: baz
+    domains: ["baz.lyft.com"]
+    routes:
+      - match: { prefix: "/" }
+        route: { cluster: baz }
+)EOF";
+
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  const envoy::api::v2::RouteConfiguration first_config = parseRouteConfigurationFromV2Yaml(yaml);
+  const ConfigImpl first(first_config, factory_context, true);
+
+  const auto virtual_host = [](const ConfigImpl& config, const std::string& host) {
+    return &config.route(genHeaders(host, "/", "GET"), 0)->routeEntry()->virtualHost();
+  };
+
+  envoy::api::v2::RouteConfiguration second_config = first_config;
+  second_config.mutable_virtual_hosts(1)->mutable_routes(0)->mutable_route()->set_cluster("qux");
+  const ConfigImpl second(second_config, factory_context, true, &first, &first_config);
+  EXPECT_EQ(virtual_host(first, "bar.lyft.com"), virtual_host(second, "bar.lyft.com"));
+  EXPECT_NE(virtual_host(first, "baz.lyft.com"), virtual_host(second, "baz.lyft.com"));
+  EXPECT_EQ("qux", second.route(genHeaders("baz.lyft.com", "/", "GET"), 0)
+                       ->routeEntry()
+                       ->clusterName());
+  EXPECT_EQ("foo", virtual_host(second, "bar.lyft.com")->routeConfig().name());
+
+  // Reused virtual hosts are validated against the current clusters.
+  EXPECT_CALL(factory_context.cluster_manager_, get("bar")).WillRepeatedly(Return(nullptr));
+  EXPECT_THROW_WITH_MESSAGE(
+      ConfigImpl(second_config, factory_context, true, &second, &second_config), EnvoyException,
+      "route: unknown cluster 'bar'");
+  const ConfigImpl third(second_config, factory_context, false, &second, &second_config);
+  EXPECT_EQ(virtual_host(first, "bar.lyft.com"), virtual_host(third, "bar.lyft.com"));
+
+  // A matching hash is not enough for a virtual host to be shared: its configuration must also
+  // equal the previous one. Passing a previous configuration that differs from the one third was
+  // built from stands in for a hash collision.
+  envoy::api::v2::RouteConfiguration fourth_config = second_config;
+  fourth_config.mutable_virtual_hosts(0)->mutable_routes(0)->mutable_route()->set_cluster("qux");
+  const ConfigImpl fourth(second_config, factory_context, false, &third, &fourth_config);
+  EXPECT_NE(virtual_host(third, "bar.lyft.com"), virtual_host(fourth, "bar.lyft.com"));
+  EXPECT_EQ(virtual_host(third, "baz.lyft.com"), virtual_host(fourth, "baz.lyft.com"));
+
+  // A change to the shared parts of the configuration rebuilds all virtual hosts.
+  envoy::api::v2::RouteConfiguration fifth_config = second_config;
+  fifth_config.add_internal_only_headers("x-internal");
+  const ConfigImpl fifth(fifth_config, factory_context, false, &third, &second_config);
+  EXPECT_NE(virtual_host(third, "bar.lyft.com"), virtual_host(fifth, "bar.lyft.com"));
+  EXPECT_EQ(1, fifth.internalOnlyHeaders().size());
+}
+
 // Test to check Prefix Rewrite for redirects
 TEST(RouteConfigurationV2, RedirectPrefixRewrite) {
   std::string RedirectPrefixRewrite = R"EOF(
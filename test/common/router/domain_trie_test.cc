@@ -0,0 +1,106 @@
+#include <cstdint>
+#include <string>
+
+#include "common/router/domain_trie.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+// Returns the position of the virtual host for host, or -1 if there is none.
+int64_t find(const DomainTrie& trie, const std::string& host) {
+  const absl::optional<uint32_t> index = trie.find(host);
+  return index ? static_cast<int64_t>(index.value()) : -1;
+}
+
+TEST(DomainTrieTest, Empty) {
+  DomainTrie trie;
+  EXPECT_TRUE(trie.empty());
+  EXPECT_EQ(-1, find(trie, "foo.com"));
+  EXPECT_EQ(-1, find(trie, ""));
+}
+
+TEST(DomainTrieTest, Exact) {
+  DomainTrie trie;
+  EXPECT_TRUE(trie.addExact("foo.com", 0));
+  EXPECT_TRUE(trie.addExact("www.foo.com", 1));
+  EXPECT_TRUE(trie.addExact("com", 2));
+  EXPECT_TRUE(trie.addExact("foo.com:8080", 3));
+  EXPECT_FALSE(trie.addExact("foo.com", 4));
+  EXPECT_FALSE(trie.empty());
+
+  EXPECT_EQ(0, find(trie, "foo.com"));
+  EXPECT_EQ(0, find(trie, "FOO.Com"));
+  EXPECT_EQ(1, find(trie, "www.foo.com"));
+  EXPECT_EQ(2, find(trie, "com"));
+  EXPECT_EQ(3, find(trie, "foo.com:8080"));
+  EXPECT_EQ(-1, find(trie, "bar.foo.com"));
+  EXPECT_EQ(-1, find(trie, ".foo.com"));
+  EXPECT_EQ(-1, find(trie, "oo.com"));
+  EXPECT_EQ(-1, find(trie, "foo.com."));
+  EXPECT_EQ(-1, find(trie, ""));
+}
+
+TEST(DomainTrieTest, SuffixWildcard) {
+  DomainTrie trie;
+  trie.addSuffixWildcard(".foo.com", 0);
+  trie.addSuffixWildcard("-bar.foo.com", 1);
+  trie.addSuffixWildcard("com", 2);
+  trie.addSuffixWildcard(".foo.com", 3);
+  EXPECT_FALSE(trie.empty());
+
+  EXPECT_EQ(0, find(trie, "www.foo.com"));
+  EXPECT_EQ(0, find(trie, "a.b.foo.com"));
+  EXPECT_EQ(0, find(trie, "WWW.FOO.COM"));
+  EXPECT_EQ(1, find(trie, "baz-bar.foo.com"));
+  EXPECT_EQ(1, find(trie, "x.baz-bar.foo.com"));
+  EXPECT_EQ(0, find(trie, "-bar.foo.com"));
+  EXPECT_EQ(0, find(trie, "bar.foo.com"));
+  EXPECT_EQ(2, find(trie, ".foo.com"));
+  EXPECT_EQ(2, find(trie, "foo.com"));
+  EXPECT_EQ(2, find(trie, "telecom"));
+  EXPECT_EQ(-1, find(trie, "com"));
+  EXPECT_EQ(-1, find(trie, "foo.org"));
+}
+
+TEST(DomainTrieTest, PrefixWildcard) {
+  DomainTrie trie;
+  trie.addPrefixWildcard("foo.", 0);
+  trie.addPrefixWildcard("foo-", 1);
+  trie.addPrefixWildcard("foo.bar.", 2);
+  trie.addPrefixWildcard("foo", 3);
+
+  EXPECT_EQ(0, find(trie, "foo.com"));
+  EXPECT_EQ(0, find(trie, "Foo.Com"));
+  EXPECT_EQ(0, find(trie, "foo.baz.com"));
+  EXPECT_EQ(1, find(trie, "foo-staging.com"));
+  EXPECT_EQ(2, find(trie, "foo.bar.com"));
+  EXPECT_EQ(0, find(trie, "foo.bar"));
+  EXPECT_EQ(3, find(trie, "foo."));
+  EXPECT_EQ(3, find(trie, "foobar.com"));
+  EXPECT_EQ(-1, find(trie, "foo"));
+  EXPECT_EQ(-1, find(trie, "bar.foo.com"));
+}
+
+// Exact domains take precedence over suffix wildcards, which take precedence over prefix
+// wildcards, regardless of the order they were added in.
+TEST(DomainTrieTest, Precedence) {
+  DomainTrie trie;
+  trie.addPrefixWildcard("www.", 0);
+  trie.addSuffixWildcard(".foo.com", 1);
+  trie.addSuffixWildcard(".com", 2);
+  trie.addExact("www.foo.com", 3);
+
+  EXPECT_EQ(3, find(trie, "www.foo.com"));
+  EXPECT_EQ(1, find(trie, "api.foo.com"));
+  EXPECT_EQ(1, find(trie, "www.api.foo.com"));
+  EXPECT_EQ(2, find(trie, "www.bar.com"));
+  EXPECT_EQ(0, find(trie, "www.bar.org"));
+  EXPECT_EQ(-1, find(trie, "api.bar.org"));
+}
+
+} // namespace
+} // namespace Router
+} // namespace Envoy
@@ -600,6 +600,39 @@ TEST(HeaderParserTest, EvaluateHeadersWithAppendFalse) {
   EXPECT_EQ(1, counts["x-request-start"]);
 }
 
+// A variable that several headers use is evaluated once per request.
+TEST(HeaderParserTest, EvaluateSharedVariablesOnce) {
+  const std::string yaml = R"EOF(
+match: { prefix: "/new_endpoint" }
+route:
+  cluster: www2
+  request_headers_to_add:
+    - header:
+        key: "x-protocol"
+        value: "%PROTOCOL%"
+    - header:
+        key: "x-protocol-and-ip"
+        value: "%PROTOCOL% from %DOWNSTREAM_REMOTE_ADDRESS_WITHOUT_PORT%"
+    - header:
+        key: "x-static"
+        value: "static-value"
+)EOF";
+
+  HeaderParserPtr req_header_parser =
+      HeaderParser::configure(parseRouteFromV2Yaml(yaml).route().request_headers_to_add());
+  Http::TestHeaderMapImpl header_map{{":method", "POST"}};
+  NiceMock<Envoy::RequestInfo::MockRequestInfo> request_info;
+  absl::optional<Envoy::Http::Protocol> protocol = Envoy::Http::Protocol::Http11;
+  EXPECT_CALL(request_info, protocol()).WillOnce(ReturnPointee(&protocol));
+
+  req_header_parser->evaluateHeaders(header_map, request_info);
+  EXPECT_EQ("HTTP/1.1", header_map.get_("x-protocol"));
+  EXPECT_EQ("HTTP/1.1 from 127.0.0.1", header_map.get_("x-protocol-and-ip"));
+  // Values without variables are added by reference rather than copied.
+  EXPECT_EQ(Http::HeaderString::Type::Reference,
+            header_map.get(Http::LowerCaseString("x-static"))->value().type());
+}
+
 TEST(HeaderParserTest, EvaluateResponseHeaders) {
   const std::string yaml = R"EOF(
 match: { prefix: "/new_endpoint" }
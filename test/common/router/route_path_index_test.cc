@@ -0,0 +1,130 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/router/route_path_index.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+std::vector<uint32_t> candidates(const RoutePathIndex& index, const std::string& path) {
+  std::vector<uint32_t> ret;
+  RoutePathIndex::Candidates candidates = index.candidates(path);
+  uint32_t route;
+  while (candidates.next(route)) {
+    ret.push_back(route);
+  }
+  return ret;
+}
+
+TEST(RoutePathIndexTest, Empty) {
+  RoutePathIndex index;
+  EXPECT_THAT(candidates(index, "/"), IsEmpty());
+}
+
+TEST(RoutePathIndexTest, Exact) {
+  RoutePathIndex index;
+  index.addExact("/foo", true, 0);
+  index.addExact("/foo/bar", true, 1);
+  index.addExact("/foo", true, 2);
+
+  EXPECT_THAT(candidates(index, "/foo"), ElementsAre(0, 2));
+  EXPECT_THAT(candidates(index, "/foo?bar=baz"), ElementsAre(0, 2));
+  EXPECT_THAT(candidates(index, "/foo/bar"), ElementsAre(1));
+  EXPECT_THAT(candidates(index, "/foo/"), IsEmpty());
+  EXPECT_THAT(candidates(index, "/FOO"), IsEmpty());
+  EXPECT_THAT(candidates(index, "/fo"), IsEmpty());
+}
+
+TEST(RoutePathIndexTest, Prefix) {
+  RoutePathIndex index;
+  index.addPrefix("/foo/bar", true, 0);
+  index.addPrefix("/foo", true, 1);
+  index.addPrefix("/fob", true, 2);
+  index.addPrefix("/foo/baz", true, 3);
+  index.addPrefix("/", true, 4);
+  index.addPrefix("/foo", true, 5);
+  index.addPrefix("", true, 6);
+
+  EXPECT_THAT(candidates(index, ""), ElementsAre(6));
+  EXPECT_THAT(candidates(index, "/"), ElementsAre(4, 6));
+  EXPECT_THAT(candidates(index, "/fo"), ElementsAre(4, 6));
+  EXPECT_THAT(candidates(index, "/foo"), ElementsAre(1, 4, 5, 6));
+  EXPECT_THAT(candidates(index, "/fob/"), ElementsAre(2, 4, 6));
+  EXPECT_THAT(candidates(index, "/foo/ba"), ElementsAre(1, 4, 5, 6));
+  EXPECT_THAT(candidates(index, "/foo/bar/baz"), ElementsAre(0, 1, 4, 5, 6));
+  EXPECT_THAT(candidates(index, "/foo/baz?a=b"), ElementsAre(1, 3, 4, 5, 6));
+  EXPECT_THAT(candidates(index, "/FOO/bar"), ElementsAre(4, 6));
+}
+
+TEST(RoutePathIndexTest, PrefixIncludesQueryString) {
+  RoutePathIndex index;
+  index.addPrefix("/foo?bar", true, 0);
+
+  EXPECT_THAT(candidates(index, "/foo?bar=baz"), ElementsAre(0));
+  EXPECT_THAT(candidates(index, "/foo"), IsEmpty());
+}
+
+TEST(RoutePathIndexTest, CaseInsensitive) {
+  RoutePathIndex index;
+  index.addPrefix("/Foo", false, 0);
+  index.addExact("/FOO/Bar", false, 1);
+  index.addPrefix("/foo", true, 2);
+
+  EXPECT_THAT(candidates(index, "/foo/bar"), ElementsAre(0, 1, 2));
+  EXPECT_THAT(candidates(index, "/FOO/BAR?Baz"), ElementsAre(0, 1));
+  EXPECT_THAT(candidates(index, "/fOo"), ElementsAre(0));
+}
+
+TEST(RoutePathIndexTest, Unindexed) {
+  RoutePathIndex index;
+  index.addExact("/foo", true, 0);
+  index.addUnindexed(1);
+  index.addPrefix("/", true, 2);
+  index.addUnindexed(3);
+
+  EXPECT_THAT(candidates(index, "/foo"), ElementsAre(0, 1, 2, 3));
+  EXPECT_THAT(candidates(index, "/bar"), ElementsAre(1, 2, 3));
+  EXPECT_THAT(candidates(index, "bar"), ElementsAre(1, 3));
+}
+
+TEST(RoutePathIndexTest, RoutesAddedAroundSplit) {
+  RoutePathIndex index;
+  index.addPrefix("/foo/bar", true, 0);
+  index.addUnindexed(1);
+  index.addPrefix("/foo/baz", true, 2);
+  index.addPrefix("/foo", true, 3);
+  index.addUnindexed(4);
+  index.addPrefix("/foo/bar/", true, 5);
+
+  EXPECT_THAT(candidates(index, "/foo/bar/"), ElementsAre(0, 1, 3, 4, 5));
+  EXPECT_THAT(candidates(index, "/foo/baz"), ElementsAre(1, 2, 3, 4));
+  EXPECT_THAT(candidates(index, "/foo/b"), ElementsAre(1, 3, 4));
+  EXPECT_THAT(candidates(index, "/fo"), ElementsAre(1, 4));
+}
+
+TEST(RoutePathIndexTest, CandidatesOutliveRequestPath) {
+  RoutePathIndex index;
+  index.addExact(std::string("/foo"), true, 0);
+  index.addExact(std::string("/FOO"), false, 1);
+  index.addPrefix("/f", false, 2);
+
+  RoutePathIndex::Candidates ret = index.candidates(std::string("/Foo"));
+  uint32_t route;
+  EXPECT_TRUE(ret.next(route));
+  EXPECT_EQ(1, route);
+  EXPECT_TRUE(ret.next(route));
+  EXPECT_EQ(2, route);
+  EXPECT_FALSE(ret.next(route));
+}
+
+} // namespace
+} // namespace Router
+} // namespace Envoy
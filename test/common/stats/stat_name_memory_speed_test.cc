@@ -0,0 +1,201 @@
+// Note: this should be run with --compilation_mode=opt, and requires a build with tcmalloc, which
+// is used to measure the memory allocated for the stats.
+
+#include <string>
+#include <vector>
+
+#include "common/common/lock_guard.h"
+#include "common/common/thread.h"
+#include "common/event/dispatcher_impl.h"
+#include "common/memory/stats.h"
+#include "common/stats/stats_impl.h"
+#include "common/stats/thread_local_store.h"
+#include "common/thread_local/thread_local_impl.h"
+
+#include "testing/base/public/benchmark.h"
+
+// NOLINT(namespace-envoy)
+
+// A representative subset of the stats created for each upstream cluster.
+static const std::vector<std::string>& clusterCounterNames() {
+  static const std::vector<std::string>* names = new std::vector<std::string>{
+      "bind_errors",
+      "lb_healthy_panic",
+      "lb_local_cluster_not_ok",
+      "lb_recalculate_zone_structures",
+      "lb_zone_cluster_too_small",
+      "lb_zone_no_capacity_left",
+      "lb_zone_number_differs",
+      "lb_zone_routing_all_directly",
+      "lb_zone_routing_cross_zone",
+      "lb_zone_routing_sampled",
+      "membership_change",
+      "retry_or_shadow_abandoned",
+      "update_attempt",
+      "update_empty",
+      "update_failure",
+      "update_no_rebuild",
+      "update_success",
+      "upstream_cx_close_notify",
+      "upstream_cx_connect_attempts_exceeded",
+      "upstream_cx_connect_fail",
+      "upstream_cx_connect_timeout",
+      "upstream_cx_destroy",
+      "upstream_cx_destroy_local",
+      "upstream_cx_destroy_local_with_active_rq",
+      "upstream_cx_destroy_remote",
+      "upstream_cx_destroy_remote_with_active_rq",
+      "upstream_cx_destroy_with_active_rq",
+      "upstream_cx_http1_total",
+      "upstream_cx_http2_total",
+      "upstream_cx_idle_timeout",
+      "upstream_cx_max_requests",
+      "upstream_cx_none_healthy",
+      "upstream_cx_overflow",
+      "upstream_cx_protocol_error",
+      "upstream_cx_rx_bytes_total",
+      "upstream_cx_total",
+      "upstream_cx_tx_bytes_total",
+      "upstream_flow_control_backed_up_total",
+      "upstream_flow_control_drained_total",
+      "upstream_flow_control_paused_reading_total",
+      "upstream_flow_control_resumed_reading_total",
+      "upstream_rq_cancelled",
+      "upstream_rq_completed",
+      "upstream_rq_maintenance_mode",
+      "upstream_rq_pending_failure_eject",
+      "upstream_rq_pending_overflow",
+      "upstream_rq_pending_total",
+      "upstream_rq_per_try_timeout",
+      "upstream_rq_retry",
+      "upstream_rq_retry_overflow",
+      "upstream_rq_retry_success",
+      "upstream_rq_rx_reset",
+      "upstream_rq_timeout",
+      "upstream_rq_total",
+      "upstream_rq_tx_reset",
+  };
+  return *names;
+}
+
+static const std::vector<std::string>& clusterGaugeNames() {
+  static const std::vector<std::string>* names = new std::vector<std::string>{
+      "lb_subsets_active",
+      "max_host_weight",
+      "membership_healthy",
+      "membership_total",
+      "upstream_cx_active",
+      "upstream_cx_rx_bytes_buffered",
+      "upstream_cx_tx_bytes_buffered",
+      "upstream_rq_active",
+      "upstream_rq_pending_active",
+      "version",
+  };
+  return *names;
+}
+
+// Looks up every stat of each cluster scope, creating it if needed.
+static void lookupClusterStats(const std::vector<Envoy::Stats::ScopePtr>& scopes) {
+  for (const Envoy::Stats::ScopePtr& scope : scopes) {
+    for (const std::string& name : clusterCounterNames()) {
+      scope->counter(name);
+    }
+    for (const std::string& name : clusterGaugeNames()) {
+      scope->gauge(name);
+    }
+  }
+}
+
+// Creates the stats of a large number of clusters from the main thread, and looks them all up from
+// a number of workers, so that each thread caches them as it does in a server. Reports the memory
+// used per stat, including the central and per thread caches, so that the cost of the stat name
+// representation can be compared across changes.
+static void BM_ClusterStatsMemory(benchmark::State& state) {
+  const uint64_t num_clusters = state.range(0);
+  const uint64_t num_workers = state.range(1);
+  for (auto _ : state) {
+    Envoy::Stats::HeapRawStatDataAllocator alloc;
+    Envoy::ThreadLocal::InstanceImpl tls;
+    Envoy::Event::DispatcherImpl main_dispatcher;
+    std::vector<std::unique_ptr<Envoy::Event::DispatcherImpl>> worker_dispatchers;
+    tls.registerThread(main_dispatcher, true);
+    for (uint64_t i = 0; i < num_workers; ++i) {
+      worker_dispatchers.emplace_back(new Envoy::Event::DispatcherImpl());
+      tls.registerThread(*worker_dispatchers.back(), false);
+    }
+
+    uint64_t num_stats = 0;
+    uint64_t bytes = 0;
+    {
+      Envoy::Stats::ThreadLocalStoreImpl store(alloc);
+      store.initializeThreading(main_dispatcher, tls);
+      const uint64_t start_bytes = Envoy::Memory::Stats::totalCurrentlyAllocated();
+      std::vector<Envoy::Stats::ScopePtr> scopes;
+      for (uint64_t i = 0; i < num_clusters; ++i) {
+        scopes.push_back(store.createScope("cluster.cluster_" + std::to_string(i) + "."));
+      }
+      lookupClusterStats(scopes);
+      num_stats = num_clusters * (clusterCounterNames().size() + clusterGaugeNames().size());
+
+      // The cache of a worker is released when it shuts down, so the workers wait for the memory
+      // to be measured before doing so.
+      Envoy::Thread::MutexBasicLockable mutex;
+      Envoy::Thread::CondVar cond_var;
+      uint64_t workers_done = 0;
+      bool shutdown = false;
+      std::vector<Envoy::Thread::ThreadPtr> workers;
+      for (const auto& worker_dispatcher : worker_dispatchers) {
+        Envoy::Event::DispatcherImpl& dispatcher = *worker_dispatcher;
+        workers.emplace_back(new Envoy::Thread::Thread([&]() {
+          // Runs the callbacks posted when the thread and the store's cache slot were registered.
+          dispatcher.run(Envoy::Event::Dispatcher::RunType::NonBlock);
+          lookupClusterStats(scopes);
+          {
+            Envoy::Thread::LockGuard lock(mutex);
+            ++workers_done;
+            cond_var.notifyAll();
+            while (!shutdown) {
+              cond_var.wait(mutex); // Safe since CondVar::wait won't throw.
+            }
+          }
+          tls.shutdownThread();
+        }));
+      }
+
+      {
+        Envoy::Thread::LockGuard lock(mutex);
+        while (workers_done < num_workers) {
+          cond_var.wait(mutex); // Safe since CondVar::wait won't throw.
+        }
+      }
+      bytes = Envoy::Memory::Stats::totalCurrentlyAllocated() - start_bytes;
+
+      store.shutdownThreading();
+      tls.shutdownGlobalThreading();
+      {
+        Envoy::Thread::LockGuard lock(mutex);
+        shutdown = true;
+        cond_var.notifyAll();
+      }
+      for (const Envoy::Thread::ThreadPtr& worker : workers) {
+        worker->join();
+      }
+      tls.shutdownThread();
+    }
+    state.counters["stats"] = num_stats;
+    state.counters["bytes_per_stat"] = static_cast<double>(bytes) / num_stats;
+  }
+}
+BENCHMARK(BM_ClusterStatsMemory)
+    ->Args({10000, 4})
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(1);
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -196,8 +196,8 @@ public:
     // for this test, however.
     std::list<const TagExtractor*> extractors; // Note push-front is used to reverse order.
     tag_extractors_.forEachExtractorMatching(metric_name,
-                                             [&extractors](const TagExtractorPtr& tag_extractor) {
-                                               extractors.push_front(tag_extractor.get());
+                                             [&extractors](const TagExtractorImpl& tag_extractor) {
+                                               extractors.push_front(&tag_extractor);
                                              });
 
     IntervalSetImpl<size_t> remove_characters;
@@ -427,6 +427,36 @@ TEST(TagExtractorTest, ExtractRegexPrefix) {
   EXPECT_EQ("", extractRegexPrefix("prefix(foo)"));
 }
 
+TEST(TagExtractorTest, CompiledTokenMatcher) {
+  TagExtractorImpl compiled("cluster_name", "^cluster\\.((.*?)\\.)");
+  EXPECT_TRUE(compiled.compiled());
+  TagExtractorImpl regex("cluster_name", "^cluster\\.((.+?)\\.)");
+  EXPECT_FALSE(regex.compiled());
+
+  for (const TagExtractorImpl* tag_extractor : {&compiled, &regex}) {
+    std::vector<Tag> tags;
+    IntervalSetImpl<size_t> remove_characters;
+    ASSERT_TRUE(tag_extractor->extractTag("cluster.test_cluster.upstream_cx_total", tags,
+                                          remove_characters));
+    ASSERT_EQ(1, tags.size());
+    EXPECT_EQ("test_cluster", tags.at(0).value_);
+    EXPECT_EQ("cluster.upstream_cx_total",
+              StringUtil::removeCharacters("cluster.test_cluster.upstream_cx_total",
+                                           remove_characters));
+  }
+}
+
+// Most default tag regexes are matched by tokens rather than with the regex engine.
+TEST(TagExtractorTest, DefaultTagExtractorsCompiled) {
+  uint32_t num_compiled = 0;
+  for (const auto& desc : Config::TagNames::get().descriptorVec()) {
+    if (TagExtractorImpl::createTagExtractor(desc.name_, desc.regex_, desc.substr_)->compiled()) {
+      ++num_compiled;
+    }
+  }
+  EXPECT_EQ(16, num_compiled);
+}
+
 TEST(TagExtractorTest, CreateTagExtractorNoRegex) {
   EXPECT_THROW_WITH_REGEX(TagExtractorImpl::createTagExtractor("no such default tag", ""),
                           EnvoyException, "^No regex specified for tag specifier and no default");
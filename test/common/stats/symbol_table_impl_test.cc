@@ -0,0 +1,159 @@
+#include <string>
+#include <vector>
+
+#include "common/stats/symbol_table_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+
+class StatNameTest : public testing::Test {
+protected:
+  ~StatNameTest() {
+    for (StatNameStorage& storage : storage_) {
+      storage.free(table_);
+    }
+    storage_.clear();
+    EXPECT_EQ(0, table_.numSymbols());
+  }
+
+  StatName makeStat(absl::string_view name) {
+    storage_.emplace_back(name, table_);
+    return storage_.back().statName();
+  }
+
+  std::string encodeDecode(absl::string_view name) { return table_.toString(makeStat(name)); }
+
+  SymbolTable table_;
+  std::vector<StatNameStorage> storage_;
+};
+
+TEST_F(StatNameTest, RoundTrip) {
+  for (const std::string& name :
+       {"", "a", "a.b", "a.b.c", "a..b", ".a", "a.", ".", "..", "cluster.foo.upstream_rq_2xx",
+        "listener.127.0.0.1_0.downstream_cx_total"}) {
+    EXPECT_EQ(name, encodeDecode(name));
+  }
+}
+
+TEST_F(StatNameTest, ManySymbols) {
+  // Enough distinct tokens to need multi-byte symbols.
+  std::vector<std::string> names;
+  for (int i = 0; i < 20000; ++i) {
+    names.push_back("cluster.cluster_" + std::to_string(i) + ".upstream_rq_total");
+  }
+  std::vector<StatName> stat_names;
+  for (const std::string& name : names) {
+    stat_names.push_back(makeStat(name));
+  }
+  EXPECT_EQ(20002, table_.numSymbols());
+  for (size_t i = 0; i < names.size(); ++i) {
+    EXPECT_EQ(names[i], table_.toString(stat_names[i]));
+  }
+}
+
+TEST_F(StatNameTest, SharedTokens) {
+  StatName foo_bar = makeStat("foo.bar");
+  StatName foo_baz = makeStat("foo.baz");
+  StatName bar_foo = makeStat("bar.foo");
+  EXPECT_EQ(3, table_.numSymbols());
+
+  // Each token takes a single byte, after the length prefix.
+  EXPECT_EQ(2, foo_bar.dataSize());
+  EXPECT_EQ(4, foo_bar.size());
+  EXPECT_NE(foo_bar, foo_baz);
+  EXPECT_NE(foo_bar, bar_foo);
+  EXPECT_EQ(foo_bar, makeStat("foo.bar"));
+  EXPECT_EQ(foo_bar.hash(), makeStat("foo.bar").hash());
+}
+
+TEST_F(StatNameTest, FreeReleasesSymbols) {
+  StatNameStorage foo_bar("foo.bar", table_);
+  StatNameStorage foo_baz("foo.baz", table_);
+  EXPECT_EQ(3, table_.numSymbols());
+
+  foo_bar.free(table_);
+  EXPECT_EQ(2, table_.numSymbols());
+  EXPECT_EQ("foo.baz", table_.toString(foo_baz.statName()));
+
+  // Released symbols are reused.
+  StatNameStorage foo_qux("foo.qux", table_);
+  EXPECT_EQ(3, table_.numSymbols());
+  EXPECT_EQ("foo.qux", table_.toString(foo_qux.statName()));
+
+  foo_baz.free(table_);
+  foo_qux.free(table_);
+  EXPECT_EQ(0, table_.numSymbols());
+}
+
+TEST_F(StatNameTest, Copy) {
+  StatNameStorage original("foo.bar", table_);
+  StatNameStorage copy(original.statName(), table_);
+  EXPECT_EQ(original.statName(), copy.statName());
+
+  original.free(table_);
+  EXPECT_EQ(2, table_.numSymbols());
+  EXPECT_EQ("foo.bar", table_.toString(copy.statName()));
+  copy.free(table_);
+  EXPECT_EQ(0, table_.numSymbols());
+}
+
+TEST_F(StatNameTest, TryEncodeInterned) {
+  StatName foo_bar = makeStat("foo.bar");
+  std::vector<uint8_t> bytes;
+  EXPECT_TRUE(table_.tryEncodeInterned("foo.bar", bytes));
+  EXPECT_EQ(foo_bar, StatName(bytes.data()));
+  EXPECT_TRUE(table_.tryEncodeInterned("bar.foo", bytes));
+  EXPECT_NE(foo_bar, StatName(bytes.data()));
+  EXPECT_EQ("bar.foo", table_.toString(StatName(bytes.data())));
+  EXPECT_FALSE(table_.tryEncodeInterned("foo.baz", bytes));
+  EXPECT_EQ(2, table_.numSymbols());
+
+  // No references were taken, so freeing the only stored name releases all symbols.
+  storage_.back().free(table_);
+  storage_.pop_back();
+  EXPECT_EQ(0, table_.numSymbols());
+}
+
+TEST_F(StatNameTest, HashMap) {
+  StatNameHashMap<int> map;
+  map[makeStat("foo.bar")] = 1;
+  map[makeStat("foo.baz")] = 2;
+  map[makeStat("foo.bar")] = 3;
+  EXPECT_EQ(2, map.size());
+  EXPECT_EQ(3, map[makeStat("foo.bar")]);
+}
+
+TEST_F(StatNameTest, List) {
+  StatNameList list;
+  EXPECT_FALSE(list.populated());
+  list.populate({"cluster.foo.upstream_rq_2xx", "cluster.upstream_rq_xx", "envoy.cluster_name",
+                 "foo", "", "envoy.response_code_class", "2"},
+                table_);
+  EXPECT_TRUE(list.populated());
+
+  std::vector<std::string> decoded;
+  list.iterate([this, &decoded](StatName stat_name) -> bool {
+    decoded.push_back(table_.toString(stat_name));
+    return true;
+  });
+  EXPECT_EQ((std::vector<std::string>{"cluster.foo.upstream_rq_2xx", "cluster.upstream_rq_xx",
+                                      "envoy.cluster_name", "foo", "", "envoy.response_code_class",
+                                      "2"}),
+            decoded);
+
+  decoded.clear();
+  list.iterate([this, &decoded](StatName stat_name) -> bool {
+    decoded.push_back(table_.toString(stat_name));
+    return decoded.size() < 2;
+  });
+  EXPECT_EQ(2, decoded.size());
+
+  list.clear(table_);
+  EXPECT_FALSE(list.populated());
+  EXPECT_EQ(0, table_.numSymbols());
+}
+
+} // namespace Stats
+} // namespace Envoy
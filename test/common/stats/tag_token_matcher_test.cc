@@ -0,0 +1,93 @@
+#include <string>
+#include <vector>
+
+#include "common/common/regex.h"
+#include "common/stats/tag_token_matcher.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+
+class TagTokenMatcherTest : public testing::Test {
+protected:
+  // Checks that the compiled matcher finds the same value, and removes the same characters, as the
+  // regex does for each of the names.
+  void expectSameAsRegex(const std::string& regex, const std::vector<std::string>& names) {
+    TagTokenMatcherPtr matcher = TagTokenMatcher::compile(regex);
+    ASSERT_NE(nullptr, matcher) << regex;
+    Regex::CompiledMatcherPtr compiled_regex = Regex::Utility::parseRegex(regex);
+
+    for (const std::string& name : names) {
+      std::vector<absl::string_view> groups;
+      const bool regex_matched = compiled_regex->search(name, groups);
+      absl::string_view value;
+      absl::string_view remove;
+      ASSERT_EQ(regex_matched, matcher->match(TagTokenMatcher::tokenize(name), value, remove))
+          << regex << " " << name;
+      if (regex_matched) {
+        EXPECT_EQ(groups[2].data(), value.data()) << regex << " " << name;
+        EXPECT_EQ(groups[2], value) << regex << " " << name;
+        EXPECT_EQ(groups[1].data(), remove.data()) << regex << " " << name;
+        EXPECT_EQ(groups[1], remove) << regex << " " << name;
+      }
+    }
+  }
+};
+
+TEST_F(TagTokenMatcherTest, Tokenize) {
+  EXPECT_EQ(std::vector<absl::string_view>({""}), TagTokenMatcher::tokenize(""));
+  EXPECT_EQ(std::vector<absl::string_view>({"a", "", "b", ""}), TagTokenMatcher::tokenize("a..b."));
+}
+
+TEST_F(TagTokenMatcherTest, NotCompiled) {
+  // Unanchored.
+  EXPECT_EQ(nullptr, TagTokenMatcher::compile("_rq(_(\\d{3}))$"));
+  // A value that must not be empty.
+  EXPECT_EQ(nullptr, TagTokenMatcher::compile("^cluster\\.((.+?)\\.)"));
+  // No value.
+  EXPECT_EQ(nullptr, TagTokenMatcher::compile("^cluster\\.foo$"));
+  // Two values.
+  EXPECT_EQ(nullptr, TagTokenMatcher::compile("^cluster\\.((.*?)\\.)((.*?)\\.)"));
+  // A literal that is only part of a token.
+  EXPECT_EQ(nullptr, TagTokenMatcher::compile("^http\\.dynamodb.table\\.((.*?)\\.)"));
+  EXPECT_EQ(nullptr, TagTokenMatcher::compile("^http\\.(?:foo|)\\.((.*?)\\.)"));
+}
+
+TEST_F(TagTokenMatcherTest, Prefix) {
+  expectSameAsRegex("^cluster\\.((.*?)\\.)",
+                    {"", "cluster", "cluster.", "cluster..", "cluster.foo", "cluster.foo.bar",
+                     "cluster.foo.bar.baz", "cluster..bar", "clusters.foo.bar",
+                     "x.cluster.foo.bar"});
+}
+
+TEST_F(TagTokenMatcherTest, SkipThenValue) {
+  expectSameAsRegex("^listener\\.(?:.*?\\.)??http\\.((.*?)\\.)",
+                    {"listener.http.foo.bar", "listener.a.b.http.foo.bar", "listener.http.http.x",
+                     "listener.http.foo", "listener.a.http", "listener..http..x", "listener.x",
+                     "listener.a\nb.http.foo.bar", "listener.http.a\nb.c.d"});
+}
+
+TEST_F(TagTokenMatcherTest, Alternatives) {
+  expectSameAsRegex("^http\\.(?:.*?\\.)??dynamodb\\.(?:table|error)\\.((.*?)\\.)",
+                    {"http.dynamodb.table.foo.x", "http.a.dynamodb.error.foo.x",
+                     "http.dynamodb.tables.foo.x", "http.dynamodb.error.foo",
+                     "http.dynamodb.dynamodb.table.a.b"});
+}
+
+TEST_F(TagTokenMatcherTest, ValueThenWord) {
+  expectSameAsRegex("^mongo\\.(?:.*?\\.)??cmd\\.((.*?)\\.)\\w+?$",
+                    {"mongo.cmd.insert.total", "mongo.a.b.cmd.find.total", "mongo.cmd.a.b.total",
+                     "mongo.cmd.insert.", "mongo.cmd.insert.total-x", "mongo.cmd.cmd.x.y",
+                     "mongo.cmd.insert"});
+}
+
+TEST_F(TagTokenMatcherTest, LiteralThenValue) {
+  expectSameAsRegex("^listener\\.(?:.*?\\.)??ssl\\.cipher(\\.(.*?))$",
+                    {"listener.ssl.cipher.AES128-SHA", "listener.a.ssl.cipher.foo.bar",
+                     "listener.ssl.cipher", "listener.ssl.cipher.", "listener.ssl.ciphers.x",
+                     "listener.ssl.cipher.a\nb", "listener.ssl.ssl.cipher.x"});
+}
+
+} // namespace Stats
+} // namespace Envoy
@@ -4,6 +4,7 @@
 #include <unordered_map>
 
 #include "common/common/c_smart_ptr.h"
+#include "common/common/thread.h"
 #include "common/stats/thread_local_store.h"
 
 #include "test/mocks/event/mocks.h"
@@ -15,6 +16,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::Contains;
 using testing::InSequence;
 using testing::Invoke;
 using testing::NiceMock;
@@ -37,6 +39,8 @@ public:
     }));
 
     EXPECT_CALL(*this, alloc("stats.overflow"));
+    EXPECT_CALL(*this, alloc("stats.central_cache_lock_contention"));
+    EXPECT_CALL(*this, alloc("stats.symbol_table_lock_contention"));
     store_.reset(new ThreadLocalStoreImpl(*this));
     store_->addSink(sink_);
   }
@@ -65,6 +69,8 @@ public:
     }));
 
     EXPECT_CALL(*this, alloc("stats.overflow"));
+    EXPECT_CALL(*this, alloc("stats.central_cache_lock_contention"));
+    EXPECT_CALL(*this, alloc("stats.symbol_table_lock_contention"));
     store_.reset(new ThreadLocalStoreImpl(*this));
     store_->addSink(sink_);
     store_->initializeThreading(main_thread_dispatcher_, tls_);
@@ -73,8 +79,8 @@ public:
   void TearDown() override {
     store_->shutdownThreading();
     tls_.shutdownThread();
-    // Includes overflow stat.
-    EXPECT_CALL(*this, free(_));
+    // Includes overflow and lock contention stats.
+    EXPECT_CALL(*this, free(_)).Times(3);
   }
 
   NameHistogramMap makeHistogramMap(const std::vector<ParentHistogramSharedPtr>& hist_list) {
@@ -183,15 +189,15 @@ TEST_F(StatsThreadLocalStoreTest, NoTls) {
   EXPECT_CALL(sink_, onHistogramComplete(Ref(h1), 100));
   store_->deliverHistogramToSinks(h1, 100);
 
-  EXPECT_EQ(2UL, store_->counters().size());
-  EXPECT_EQ(&c1, store_->counters().front().get());
-  EXPECT_EQ(2L, store_->counters().front().use_count());
+  EXPECT_EQ(4UL, store_->counters().size());
+  EXPECT_EQ(&c1, TestUtility::findCounter(*store_, "c1").get());
+  EXPECT_EQ(2L, TestUtility::findCounter(*store_, "c1").use_count());
   EXPECT_EQ(1UL, store_->gauges().size());
   EXPECT_EQ(&g1, store_->gauges().front().get());
   EXPECT_EQ(2L, store_->gauges().front().use_count());
 
-  // Includes overflow stat.
-  EXPECT_CALL(*this, free(_)).Times(3);
+  // Includes overflow and lock contention stats.
+  EXPECT_CALL(*this, free(_)).Times(5);
 
   store_->shutdownThreading();
 }
@@ -211,9 +217,9 @@ TEST_F(StatsThreadLocalStoreTest, Tls) {
   Histogram& h1 = store_->histogram("h1");
   EXPECT_EQ(&h1, &store_->histogram("h1"));
 
-  EXPECT_EQ(2UL, store_->counters().size());
-  EXPECT_EQ(&c1, store_->counters().front().get());
-  EXPECT_EQ(3L, store_->counters().front().use_count());
+  EXPECT_EQ(4UL, store_->counters().size());
+  EXPECT_EQ(&c1, TestUtility::findCounter(*store_, "c1").get());
+  EXPECT_EQ(3L, TestUtility::findCounter(*store_, "c1").use_count());
   EXPECT_EQ(1UL, store_->gauges().size());
   EXPECT_EQ(&g1, store_->gauges().front().get());
   EXPECT_EQ(3L, store_->gauges().front().use_count());
@@ -221,15 +227,15 @@ TEST_F(StatsThreadLocalStoreTest, Tls) {
   store_->shutdownThreading();
   tls_.shutdownThread();
 
-  EXPECT_EQ(2UL, store_->counters().size());
-  EXPECT_EQ(&c1, store_->counters().front().get());
-  EXPECT_EQ(2L, store_->counters().front().use_count());
+  EXPECT_EQ(4UL, store_->counters().size());
+  EXPECT_EQ(&c1, TestUtility::findCounter(*store_, "c1").get());
+  EXPECT_EQ(2L, TestUtility::findCounter(*store_, "c1").use_count());
   EXPECT_EQ(1UL, store_->gauges().size());
   EXPECT_EQ(&g1, store_->gauges().front().get());
   EXPECT_EQ(2L, store_->gauges().front().use_count());
 
-  // Includes overflow stat.
-  EXPECT_CALL(*this, free(_)).Times(3);
+  // Includes overflow and lock contention stats.
+  EXPECT_CALL(*this, free(_)).Times(5);
 }
 
 TEST_F(StatsThreadLocalStoreTest, BasicScope) {
@@ -262,8 +268,8 @@ TEST_F(StatsThreadLocalStoreTest, BasicScope) {
   scope1->deliverHistogramToSinks(h2, 200);
   tls_.shutdownThread();
 
-  // Includes overflow stat.
-  EXPECT_CALL(*this, free(_)).Times(5);
+  // Includes overflow and lock contention stats.
+  EXPECT_CALL(*this, free(_)).Times(7);
 }
 
 // Validate that we sanitize away bad characters in the stats prefix.
@@ -279,8 +285,8 @@ TEST_F(StatsThreadLocalStoreTest, SanitizePrefix) {
   store_->shutdownThreading();
   tls_.shutdownThread();
 
-  // Includes overflow stat.
-  EXPECT_CALL(*this, free(_)).Times(2);
+  // Includes overflow and lock contention stats.
+  EXPECT_CALL(*this, free(_)).Times(4);
 }
 
 TEST_F(StatsThreadLocalStoreTest, ScopeDelete) {
@@ -290,18 +296,18 @@ TEST_F(StatsThreadLocalStoreTest, ScopeDelete) {
   ScopePtr scope1 = store_->createScope("scope1.");
   EXPECT_CALL(*this, alloc(_));
   scope1->counter("c1");
-  EXPECT_EQ(2UL, store_->counters().size());
-  CounterSharedPtr c1 = store_->counters().front();
-  EXPECT_EQ("scope1.c1", c1->name());
-  EXPECT_EQ(store_->source().cachedCounters().front(), c1);
+  EXPECT_EQ(4UL, store_->counters().size());
+  CounterSharedPtr c1 = TestUtility::findCounter(*store_, "scope1.c1");
+  ASSERT_NE(nullptr, c1);
+  EXPECT_THAT(store_->source().cachedCounters(), Contains(c1));
 
   EXPECT_CALL(main_thread_dispatcher_, post(_));
   EXPECT_CALL(tls_, runOnAllThreads(_));
   scope1.reset();
-  EXPECT_EQ(1UL, store_->counters().size());
-  EXPECT_EQ(2UL, store_->source().cachedCounters().size());
+  EXPECT_EQ(3UL, store_->counters().size());
+  EXPECT_EQ(4UL, store_->source().cachedCounters().size());
   store_->source().clearCache();
-  EXPECT_EQ(1UL, store_->source().cachedCounters().size());
+  EXPECT_EQ(3UL, store_->source().cachedCounters().size());
 
   EXPECT_CALL(*this, free(_));
   EXPECT_EQ(1L, c1.use_count());
@@ -310,8 +316,8 @@ TEST_F(StatsThreadLocalStoreTest, ScopeDelete) {
   store_->shutdownThreading();
   tls_.shutdownThread();
 
-  // Includes overflow stat.
-  EXPECT_CALL(*this, free(_));
+  // Includes overflow and lock contention stats.
+  EXPECT_CALL(*this, free(_)).Times(3);
 }
 
 TEST_F(StatsThreadLocalStoreTest, NestedScopes) {
@@ -341,8 +347,8 @@ TEST_F(StatsThreadLocalStoreTest, NestedScopes) {
   store_->shutdownThreading();
   tls_.shutdownThread();
 
-  // Includes overflow stat.
-  EXPECT_CALL(*this, free(_)).Times(4);
+  // Includes overflow and lock contention stats.
+  EXPECT_CALL(*this, free(_)).Times(6);
 }
 
 TEST_F(StatsThreadLocalStoreTest, OverlappingScopes) {
@@ -367,7 +373,7 @@ TEST_F(StatsThreadLocalStoreTest, OverlappingScopes) {
   EXPECT_EQ(2UL, c2.value());
 
   // We should dedup when we fetch all counters to handle the overlapping case.
-  EXPECT_EQ(2UL, store_->counters().size());
+  EXPECT_EQ(4UL, store_->counters().size());
 
   // Gauges should work the same way.
   EXPECT_CALL(*this, alloc(_)).Times(2);
@@ -387,7 +393,7 @@ TEST_F(StatsThreadLocalStoreTest, OverlappingScopes) {
   scope1.reset();
   c2.inc();
   EXPECT_EQ(3UL, c2.value());
-  EXPECT_EQ(2UL, store_->counters().size());
+  EXPECT_EQ(4UL, store_->counters().size());
   g2.set(10);
   EXPECT_EQ(10UL, g2.value());
   EXPECT_EQ(1UL, store_->gauges().size());
@@ -395,8 +401,8 @@ TEST_F(StatsThreadLocalStoreTest, OverlappingScopes) {
   store_->shutdownThreading();
   tls_.shutdownThread();
 
-  // Includes overflow stat.
-  EXPECT_CALL(*this, free(_)).Times(3);
+  // Includes overflow and lock contention stats.
+  EXPECT_CALL(*this, free(_)).Times(5);
 }
 
 TEST_F(StatsThreadLocalStoreTest, AllocFailed) {
@@ -413,8 +419,9 @@ TEST_F(StatsThreadLocalStoreTest, AllocFailed) {
   store_->shutdownThreading();
   tls_.shutdownThread();
 
-  // Includes overflow but not the failsafe stat which we allocated from the heap.
-  EXPECT_CALL(*this, free(_));
+  // Includes overflow and lock contention but not the failsafe stat which we allocated from the
+  // heap.
+  EXPECT_CALL(*this, free(_)).Times(3);
 }
 
 TEST_F(StatsThreadLocalStoreTest, ShuttingDown) {
@@ -436,8 +443,8 @@ TEST_F(StatsThreadLocalStoreTest, ShuttingDown) {
 
   tls_.shutdownThread();
 
-  // Includes overflow stat.
-  EXPECT_CALL(*this, free(_)).Times(5);
+  // Includes overflow and lock contention stats.
+  EXPECT_CALL(*this, free(_)).Times(7);
 }
 
 TEST_F(StatsThreadLocalStoreTest, MergeDuringShutDown) {
@@ -460,7 +467,65 @@ TEST_F(StatsThreadLocalStoreTest, MergeDuringShutDown) {
 
   tls_.shutdownThread();
 
-  EXPECT_CALL(*this, free(_));
+  EXPECT_CALL(*this, free(_)).Times(3);
+}
+
+// Validate that threads making the same stats concurrently, without TLS caches, end up sharing a
+// single entry in the central cache for each name.
+TEST(StatsThreadLocalStoreConcurrencyTest, ConcurrentCentralCacheFills) {
+  HeapRawStatDataAllocator alloc;
+  ThreadLocalStoreImpl store(alloc);
+  ScopePtr scope = store.createScope("cluster.foo.");
+
+  const uint32_t num_threads = 8;
+  const uint32_t num_stats = 100;
+  std::vector<std::vector<Counter*>> counters(num_threads);
+  std::vector<Thread::ThreadPtr> threads;
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    threads.push_back(std::make_unique<Thread::Thread>([&scope, &counters, i]() -> void {
+      for (uint32_t j = 0; j < num_stats; ++j) {
+        counters[i].push_back(&scope->counter("c" + std::to_string(j)));
+        scope->counter("c" + std::to_string(j)).inc();
+      }
+    }));
+  }
+  for (Thread::ThreadPtr& thread : threads) {
+    thread->join();
+  }
+
+  for (uint32_t j = 0; j < num_stats; ++j) {
+    for (uint32_t i = 1; i < num_threads; ++i) {
+      EXPECT_EQ(counters[0][j], counters[i][j]);
+    }
+    EXPECT_EQ(num_threads, counters[0][j]->value());
+  }
+  // Includes overflow and lock contention stats.
+  EXPECT_EQ(num_stats + 3, store.counters().size());
+  EXPECT_NE(nullptr, TestUtility::findCounter(store, "stats.central_cache_lock_contention"));
+  EXPECT_NE(nullptr, TestUtility::findCounter(store, "stats.symbol_table_lock_contention"));
+
+  store.shutdownThreading();
+}
+
+// Validate that the store encodes names with the symbol table of its allocator, and that the caches
+// keep no names of their own, so the tokens of a stat are released along with it.
+TEST(StatsThreadLocalStoreSymbolTableTest, NamesHeldByStats) {
+  HeapRawStatDataAllocator alloc;
+  {
+    ThreadLocalStoreImpl store(alloc);
+    // "stats", "overflow", "central_cache_lock_contention" and "symbol_table_lock_contention".
+    EXPECT_EQ(4, alloc.symbolTable().numSymbols());
+
+    ScopePtr scope = store.createScope("cluster.foo.");
+    Counter& c1 = scope->counter("c1");
+    EXPECT_EQ(&c1, &scope->counter("c1"));
+    EXPECT_EQ(7, alloc.symbolTable().numSymbols());
+
+    scope.reset();
+    EXPECT_EQ(4, alloc.symbolTable().numSymbols());
+    store.shutdownThreading();
+  }
+  EXPECT_EQ(0, alloc.symbolTable().numSymbols());
 }
 
 // Histogram tests
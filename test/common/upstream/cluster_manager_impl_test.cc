@@ -667,6 +667,26 @@ TEST_F(ClusterManagerImplTest, ShutdownOrder) {
   EXPECT_EQ(3U, cluster.info().use_count());
 }
 
+// Workers share the host vectors of the main thread's host sets instead of copying them.
+TEST_F(ClusterManagerImplTest, ThreadLocalHostSetsShareHostVectors) {
+  const std::string json =
+      fmt::sprintf("{%s}", clustersJson({defaultStaticClusterJson("cluster_1")}));
+
+  create(parseBootstrapFromJson(json));
+  const HostSet& host_set =
+      *cluster_manager_->clusters().begin()->second.get().prioritySet().hostSetsPerPriority()[0];
+  const HostSet& thread_local_host_set =
+      *cluster_manager_->get("cluster_1")->prioritySet().hostSetsPerPriority()[0];
+  EXPECT_EQ(1UL, thread_local_host_set.hosts().size());
+  EXPECT_EQ(host_set.hostsPtr(), thread_local_host_set.hostsPtr());
+  EXPECT_EQ(host_set.healthyHostsPtr(), thread_local_host_set.healthyHostsPtr());
+  EXPECT_EQ(host_set.hostsPerLocalityPtr(), thread_local_host_set.hostsPerLocalityPtr());
+  EXPECT_EQ(host_set.healthyHostsPerLocalityPtr(),
+            thread_local_host_set.healthyHostsPerLocalityPtr());
+
+  factory_.tls_.shutdownThread();
+}
+
 TEST_F(ClusterManagerImplTest, InitializeOrder) {
   EXPECT_CALL(system_time_source_, currentTime())
       .WillRepeatedly(Return(SystemTime(std::chrono::milliseconds(1234567891234))));
@@ -0,0 +1,124 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <memory>
+#include <string>
+
+#include "envoy/api/v2/eds.pb.h"
+
+#include "common/common/fmt.h"
+#include "common/stats/stats_impl.h"
+#include "common/upstream/eds.h"
+
+#include "test/common/upstream/utility.h"
+#include "test/mocks/local_info/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/ssl/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+
+#include "testing/base/public/benchmark.h"
+
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Upstream {
+
+class EdsSpeedTest {
+public:
+  EdsSpeedTest() {
+    eds_cluster_ = parseClusterFromV2Yaml(R"EOF(
+      name: name
+      connect_timeout: 0.25s
+      type: EDS
+      lb_policy: ROUND_ROBIN
+      eds_cluster_config:
+        service_name: fare
+        eds_config:
+          api_config_source:
+            cluster_names:
+            - eds
+            refresh_delay: 1s
+    )EOF");
+    Upstream::ClusterManager::ClusterInfoMap cluster_map;
+    cluster_map.emplace("eds", eds_config_cluster_);
+    ON_CALL(cm_, clusters()).WillByDefault(Return(cluster_map));
+    cluster_.reset(new EdsClusterImpl(eds_cluster_, runtime_, stats_, ssl_context_manager_,
+                                      local_info_, cm_, dispatcher_, random_, false));
+
+    // Propagate updates to a host set standing in for a worker's, as the cluster manager does.
+    cluster_->prioritySet().addMemberUpdateCb(
+        [this](uint32_t priority, const HostVector& hosts_added, const HostVector& hosts_removed) {
+          const HostSet& host_set = *cluster_->prioritySet().hostSetsPerPriority()[priority];
+          worker_priority_set_.getOrCreateHostSet(priority).updateHosts(
+              host_set.hostsPtr(), host_set.healthyHostsPtr(), host_set.hostsPerLocalityPtr(),
+              host_set.healthyHostsPerLocalityPtr(), host_set.localityWeights(), hosts_added,
+              hosts_removed);
+        });
+  }
+
+  // Build an assignment of num_hosts endpoints spread over 3 localities. The endpoint with index
+  // changed_host has a different port in each generation, so that each update adds and removes
+  // one host.
+  Protobuf::RepeatedPtrField<envoy::api::v2::ClusterLoadAssignment>
+  assignment(uint32_t num_hosts, uint32_t changed_host, uint32_t generation) {
+    Protobuf::RepeatedPtrField<envoy::api::v2::ClusterLoadAssignment> resources;
+    auto* cluster_load_assignment = resources.Add();
+    cluster_load_assignment->set_cluster_name("fare");
+    for (uint32_t zone = 0; zone < 3; zone++) {
+      auto* endpoints = cluster_load_assignment->add_endpoints();
+      endpoints->mutable_locality()->set_zone(fmt::format("zone-{}", zone));
+      for (uint32_t i = zone; i < num_hosts; i += 3) {
+        auto* socket_address = endpoints->add_lb_endpoints()
+                                   ->mutable_endpoint()
+                                   ->mutable_address()
+                                   ->mutable_socket_address();
+        socket_address->set_address(fmt::format("10.{}.{}.{}", i / 65536, i / 256 % 256, i % 256));
+        socket_address->set_port_value(i == changed_host ? 10000 + generation : 80);
+      }
+    }
+    return resources;
+  }
+
+  Stats::IsolatedStoreImpl stats_;
+  Ssl::MockContextManager ssl_context_manager_;
+  envoy::api::v2::Cluster eds_cluster_;
+  NiceMock<MockClusterManager> cm_;
+  NiceMock<MockCluster> eds_config_cluster_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  std::shared_ptr<EdsClusterImpl> cluster_;
+  NiceMock<Runtime::MockRandomGenerator> random_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  PrioritySetImpl worker_priority_set_;
+};
+
+// Test the cost of an EDS update that replaces one host of a cluster, including propagating the
+// new host set to a worker.
+static void BM_EdsUpdateOneHost(benchmark::State& state) {
+  const uint32_t num_hosts = state.range(0);
+  EdsSpeedTest test;
+  const auto first = test.assignment(num_hosts, num_hosts / 2, 0);
+  const auto second = test.assignment(num_hosts, num_hosts / 2, 1);
+  test.cluster_->onConfigUpdate(first, "");
+
+  bool use_second = true;
+  for (auto _ : state) {
+    test.cluster_->onConfigUpdate(use_second ? second : first, "");
+    use_second = !use_second;
+  }
+  benchmark::DoNotOptimize(test.worker_priority_set_.hostSetsPerPriority()[0]->hosts().size());
+}
+BENCHMARK(BM_EdsUpdateOneHost)->Arg(100)->Arg(1000)->Arg(5000)->Arg(20000);
+
+} // namespace Upstream
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
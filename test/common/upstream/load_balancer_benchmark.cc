@@ -22,18 +22,56 @@ public:
   BaseTester(uint64_t num_hosts, uint32_t weighted_subset_percent, uint32_t weight) {
     HostSet& host_set = priority_set_.getOrCreateHostSet(0);
 
-    HostVector hosts;
     ASSERT(num_hosts < 65536);
     for (uint64_t i = 0; i < num_hosts; i++) {
       const bool should_weight = i < num_hosts * (weighted_subset_percent / 100.0);
-      hosts.push_back(makeTestHost(info_, fmt::format("tcp://10.0.{}.{}:6379", i / 256, i % 256),
-                                   should_weight ? weight : 1));
+      hosts_.push_back(makeTestHost(info_, fmt::format("tcp://10.0.{}.{}:6379", i / 256, i % 256),
+                                    should_weight ? weight : 1));
+    }
+    HostVectorConstSharedPtr updated_hosts{new HostVector(hosts_)};
+    host_set.updateHosts(updated_hosts, updated_hosts, nullptr, nullptr, {}, hosts_, {});
+  }
+
+  // Set up churnHosts() to replace the first num_hosts hosts with other hosts, or if health_only
+  // is true, to only make them unhealthy.
+  void setupChurn(uint64_t num_hosts, bool health_only) {
+    HostVector churned_hosts;
+    for (uint64_t i = 0; i < num_hosts; i++) {
+      if (!health_only) {
+        churned_hosts.push_back(
+            makeTestHost(info_, fmt::format("tcp://10.1.{}.{}:6379", i / 256, i % 256)));
+        removed_hosts_.push_back(hosts_[i]);
+      }
+    }
+    added_hosts_ = churned_hosts;
+    churned_hosts.insert(churned_hosts.end(), hosts_.begin() + num_hosts, hosts_.end());
+
+    original_hosts_.reset(new HostVector(hosts_));
+    churned_healthy_hosts_.reset(new HostVector(churned_hosts));
+    churned_hosts_ = health_only ? original_hosts_ : churned_healthy_hosts_;
+  }
+
+  // Apply the change set up by setupChurn(), or undo it if it was applied by the previous call.
+  void churnHosts() {
+    HostSet& host_set = priority_set_.getOrCreateHostSet(0);
+    churned_ = !churned_;
+    if (churned_) {
+      host_set.updateHosts(churned_hosts_, churned_healthy_hosts_, nullptr, nullptr, {},
+                           added_hosts_, removed_hosts_);
+    } else {
+      host_set.updateHosts(original_hosts_, original_hosts_, nullptr, nullptr, {}, removed_hosts_,
+                           added_hosts_);
     }
-    HostVectorConstSharedPtr updated_hosts{new HostVector(hosts)};
-    host_set.updateHosts(updated_hosts, updated_hosts, nullptr, nullptr, {}, hosts, {});
   }
 
   PrioritySetImpl priority_set_;
+  HostVector hosts_;
+  HostVectorConstSharedPtr original_hosts_;
+  HostVectorConstSharedPtr churned_hosts_;
+  HostVectorConstSharedPtr churned_healthy_hosts_;
+  HostVector added_hosts_;
+  HostVector removed_hosts_;
+  bool churned_{};
   std::shared_ptr<MockClusterInfo> info_{new NiceMock<MockClusterInfo>()};
 };
 
@@ -55,6 +93,21 @@ public:
   envoy::api::v2::Cluster::CommonLbConfig common_config_;
 };
 
+class MaglevTester : public BaseTester {
+public:
+  MaglevTester(uint64_t num_hosts) : BaseTester(num_hosts) {
+    maglev_lb_.reset(
+        new MaglevLoadBalancer{priority_set_, stats_, runtime_, random_, common_config_});
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  ClusterStats stats_{ClusterInfoImpl::generateStats(stats_store_)};
+  NiceMock<Runtime::MockLoader> runtime_;
+  Runtime::RandomGeneratorImpl random_;
+  envoy::api::v2::Cluster::CommonLbConfig common_config_;
+  std::unique_ptr<MaglevLoadBalancer> maglev_lb_;
+};
+
 uint64_t hashInt(uint64_t i) {
   // Hack to hash an integer.
   return HashUtil::xxHash64(absl::string_view(reinterpret_cast<const char*>(&i), sizeof(i)));
@@ -79,6 +132,7 @@ BENCHMARK(BM_RingHashLoadBalancerBuildRing)
     ->Args({100, 256000})
     ->Args({200, 256000})
     ->Args({500, 256000})
+    ->Args({500, 1000000})
     ->Unit(benchmark::kMillisecond);
 
 void BM_MaglevLoadBalancerBuildTable(benchmark::State& state) {
@@ -97,6 +151,62 @@ BENCHMARK(BM_MaglevLoadBalancerBuildTable)
     ->Arg(500)
     ->Unit(benchmark::kMillisecond);
 
+// Measures the cost of rebuilding the ring when a few hosts are replaced or become unhealthy.
+void BM_RingHashLoadBalancerChurn(benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t min_ring_size = state.range(1);
+  const uint64_t hosts_to_change = state.range(2);
+  const bool health_only = state.range(3);
+  RingHashTester tester(num_hosts, min_ring_size);
+  tester.ring_hash_lb_->initialize();
+  tester.setupChurn(hosts_to_change, health_only);
+
+  for (auto _ : state) {
+    tester.churnHosts();
+  }
+
+  // Averages per update.
+  state.counters["entries_moved"] =
+      static_cast<double>(tester.stats_.lb_rebuild_entries_moved_.value()) / state.iterations();
+  state.counters["incremental"] =
+      static_cast<double>(tester.stats_.lb_rebuild_incremental_.value()) / state.iterations();
+}
+BENCHMARK(BM_RingHashLoadBalancerChurn)
+    ->Args({100, 65536, 1, false})
+    ->Args({500, 65536, 1, false})
+    ->Args({500, 65536, 5, false})
+    ->Args({500, 65536, 1, true})
+    ->Args({500, 256000, 1, false})
+    ->Args({500, 256000, 1, true})
+    ->Args({5000, 1024, 1, false})
+    ->Args({5000, 1024, 50, true})
+    ->Unit(benchmark::kMillisecond);
+
+// Measures the cost of rebuilding the table when a few hosts are replaced or become unhealthy.
+void BM_MaglevLoadBalancerChurn(benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t hosts_to_change = state.range(1);
+  const bool health_only = state.range(2);
+  MaglevTester tester(num_hosts);
+  tester.maglev_lb_->initialize();
+  tester.setupChurn(hosts_to_change, health_only);
+
+  for (auto _ : state) {
+    tester.churnHosts();
+  }
+
+  // Average per update.
+  state.counters["entries_moved"] =
+      static_cast<double>(tester.stats_.lb_rebuild_entries_moved_.value()) / state.iterations();
+}
+BENCHMARK(BM_MaglevLoadBalancerChurn)
+    ->Args({100, 1, false})
+    ->Args({500, 1, false})
+    ->Args({500, 5, false})
+    ->Args({500, 1, true})
+    ->Args({5000, 50, true})
+    ->Unit(benchmark::kMillisecond);
+
 class TestLoadBalancerContext : public LoadBalancerContext {
 public:
   // Upstream::LoadBalancerContext
@@ -165,6 +275,7 @@ BENCHMARK(BM_RingHashLoadBalancerChooseHost)
     ->Args({100, 256000, 100000})
     ->Args({200, 256000, 100000})
     ->Args({500, 256000, 100000})
+    ->Args({500, 1000000, 100000})
     ->Unit(benchmark::kMillisecond);
 
 void BM_MaglevLoadBalancerChooseHost(benchmark::State& state) {
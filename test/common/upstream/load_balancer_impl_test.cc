@@ -1,3 +1,4 @@
+#include <chrono>
 #include <memory>
 #include <set>
 #include <string>
@@ -966,6 +967,71 @@ TEST_P(RandomLoadBalancerTest, Normal) {
 
 INSTANTIATE_TEST_CASE_P(PrimaryOrFailover, RandomLoadBalancerTest, ::testing::Values(true, false));
 
+class PeakEwmaLoadBalancerTest : public LoadBalancerTestBase {
+public:
+  void putLatency(const HostSharedPtr& host, std::chrono::milliseconds latency) {
+    host->latencyEstimator().putLatency(latency, std::chrono::steady_clock::now());
+  }
+
+  // Choose between the first and second hosts.
+  HostConstSharedPtr chooseHost() {
+    EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
+    return lb_.chooseHost(nullptr);
+  }
+
+  PeakEwmaLoadBalancer lb_{priority_set_, nullptr, stats_, runtime_, random_, common_config_};
+};
+
+TEST_P(PeakEwmaLoadBalancerTest, NoHosts) { EXPECT_EQ(nullptr, lb_.chooseHost(nullptr)); }
+
+TEST_P(PeakEwmaLoadBalancerTest, Normal) {
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
+                              makeTestHost(info_, "tcp://127.0.0.1:81")};
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  hostSet().runCallbacks({}, {}); // Trigger callbacks. The added/removed lists are not relevant.
+  EXPECT_EQ(hostSet().healthy_hosts_[1], chooseHost());
+
+  putLatency(hostSet().healthy_hosts_[0], std::chrono::milliseconds(10));
+  putLatency(hostSet().healthy_hosts_[1], std::chrono::milliseconds(50));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], chooseHost());
+
+  // A faster host is chosen even with more active requests, until its cost passes the other's.
+  hostSet().healthy_hosts_[0]->stats().rq_active_.set(2);
+  EXPECT_EQ(hostSet().healthy_hosts_[0], chooseHost());
+  hostSet().healthy_hosts_[0]->stats().rq_active_.set(5);
+  EXPECT_EQ(hostSet().healthy_hosts_[1], chooseHost());
+}
+
+TEST_P(PeakEwmaLoadBalancerTest, Weighted) {
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", 2),
+                              makeTestHost(info_, "tcp://127.0.0.1:81", 1)};
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  hostSet().runCallbacks({}, {}); // Trigger callbacks. The added/removed lists are not relevant.
+
+  putLatency(hostSet().healthy_hosts_[0], std::chrono::milliseconds(20));
+  putLatency(hostSet().healthy_hosts_[1], std::chrono::milliseconds(15));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], chooseHost());
+  hostSet().healthy_hosts_[0]->weight(1);
+  EXPECT_EQ(hostSet().healthy_hosts_[1], chooseHost());
+}
+
+// A host that has active requests but has never responded is chosen after any host that has.
+TEST_P(PeakEwmaLoadBalancerTest, NoLatencyPenalty) {
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
+                              makeTestHost(info_, "tcp://127.0.0.1:81")};
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  hostSet().runCallbacks({}, {}); // Trigger callbacks. The added/removed lists are not relevant.
+
+  putLatency(hostSet().healthy_hosts_[1], std::chrono::seconds(1));
+  hostSet().healthy_hosts_[1]->stats().rq_active_.set(10);
+  EXPECT_EQ(hostSet().healthy_hosts_[0], chooseHost());
+  hostSet().healthy_hosts_[0]->stats().rq_active_.set(1);
+  EXPECT_EQ(hostSet().healthy_hosts_[1], chooseHost());
+}
+
+INSTANTIATE_TEST_CASE_P(PrimaryOrFailover, PeakEwmaLoadBalancerTest,
+                        ::testing::Values(true, false));
+
 TEST(LoadBalancerSubsetInfoImplTest, DefaultConfigIsDiabled) {
   auto subset_info =
       LoadBalancerSubsetInfoImpl(envoy::api::v2::Cluster::LbSubsetConfig::default_instance());
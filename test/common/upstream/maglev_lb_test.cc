@@ -1,3 +1,6 @@
+#include <unordered_map>
+
+#include "common/common/fmt.h"
 #include "common/upstream/maglev_lb.h"
 
 #include "test/common/upstream/utility.h"
@@ -74,6 +77,81 @@ TEST_F(MaglevLoadBalancerTest, Basic) {
   }
 }
 
+// With a hash balance factor, requests skip the hosts of the following entries of the table
+// while those are over their bound of active requests.
+TEST_F(MaglevLoadBalancerTest, BoundedLoads) {
+  host_set_.hosts_ = {
+      makeTestHost(info_, "tcp://127.0.0.1:90"), makeTestHost(info_, "tcp://127.0.0.1:91"),
+      makeTestHost(info_, "tcp://127.0.0.1:92"), makeTestHost(info_, "tcp://127.0.0.1:93"),
+      makeTestHost(info_, "tcp://127.0.0.1:94"), makeTestHost(info_, "tcp://127.0.0.1:95")};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+  common_config_.mutable_consistent_hashing_lb_config()->mutable_hash_balance_factor()->set_value(
+      150);
+  init(7);
+
+  // Same table as in Basic. With 5 active requests in the cluster, a host can take the next one
+  // if it has less than ceil(6 / 6 * 1.5) = 2 active requests.
+  stats_.upstream_rq_active_.set(5);
+  LoadBalancerPtr lb = lb_->factory()->create();
+  TestLoadBalancerContext first_entry(0);
+  TestLoadBalancerContext last_entry(6);
+  EXPECT_EQ(host_set_.hosts_[2], lb->chooseHost(&first_entry));
+
+  host_set_.hosts_[2]->stats().rq_active_.set(2);
+  EXPECT_EQ(host_set_.hosts_[4], lb->chooseHost(&first_entry));
+  host_set_.hosts_[4]->stats().rq_active_.set(2);
+  EXPECT_EQ(host_set_.hosts_[0], lb->chooseHost(&first_entry));
+
+  // The walk wraps around the table.
+  host_set_.hosts_[3]->stats().rq_active_.set(2);
+  EXPECT_EQ(host_set_.hosts_[0], lb->chooseHost(&last_entry));
+
+  // When all hosts are over their bound, the request goes to the host its hash maps to.
+  for (const auto& host : host_set_.hosts_) {
+    host->stats().rq_active_.set(2);
+  }
+  EXPECT_EQ(host_set_.hosts_[2], lb->chooseHost(&first_entry));
+  EXPECT_EQ(host_set_.hosts_[3], lb->chooseHost(&last_entry));
+}
+
+// The walk asks each host at most once whether it is overloaded, however many entries it has, and
+// stops once every host has been asked.
+TEST_F(MaglevLoadBalancerTest, BoundedLoadsAllButOneOverloaded) {
+  MaglevTable::WeightedHostVector weighted_hosts;
+  for (uint32_t i = 0; i < 8; ++i) {
+    weighted_hosts.emplace_back(makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", 90 + i)), 1);
+  }
+  const MaglevTable table(weighted_hosts, MaglevTable::DefaultTableSize);
+
+  for (const uint64_t hash : {0UL, 12345UL, MaglevTable::DefaultTableSize - 1}) {
+    for (const auto& available : weighted_hosts) {
+      std::unordered_map<const Host*, uint32_t> calls;
+      EXPECT_EQ(available.first,
+                table.chooseHost(hash, [&calls, &available](const Host& host, double) -> bool {
+                  ++calls[&host];
+                  return &host != available.first.get();
+                }));
+      EXPECT_EQ(1, calls[available.first.get()]);
+      for (const auto& call : calls) {
+        EXPECT_EQ(1, call.second);
+      }
+    }
+
+    // With every host overloaded, each is asked once and the request goes to the host its hash
+    // maps to.
+    std::unordered_map<const Host*, uint32_t> calls;
+    EXPECT_EQ(table.chooseHost(hash), table.chooseHost(hash, [&calls](const Host& host, double) {
+      ++calls[&host];
+      return true;
+    }));
+    EXPECT_EQ(weighted_hosts.size(), calls.size());
+    for (const auto& call : calls) {
+      EXPECT_EQ(1, call.second);
+    }
+  }
+}
+
 // Weighted sanity test.
 TEST_F(MaglevLoadBalancerTest, Weighted) {
   host_set_.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:90", 1),
@@ -228,5 +306,42 @@ TEST_F(MaglevLoadBalancerTest, LocalityWeightedGlobalPanic) {
   }
 }
 
+// The table is kept when its hosts and weights do not change, and rebuilt otherwise.
+TEST_F(MaglevLoadBalancerTest, RebuildOnlyChangedTable) {
+  host_set_.hosts_ = {
+      makeTestHost(info_, "tcp://127.0.0.1:90"), makeTestHost(info_, "tcp://127.0.0.1:91"),
+      makeTestHost(info_, "tcp://127.0.0.1:92"), makeTestHost(info_, "tcp://127.0.0.1:93"),
+      makeTestHost(info_, "tcp://127.0.0.1:94"), makeTestHost(info_, "tcp://127.0.0.1:95")};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+  init(7);
+  LoadBalancerPtr lb = lb_->factory()->create();
+
+  host_set_.runCallbacks({}, {});
+  EXPECT_EQ(1UL, stats_.lb_rebuild_incremental_.value());
+  EXPECT_EQ(0UL, stats_.lb_rebuild_entries_moved_.value());
+
+  host_set_.healthy_hosts_.pop_back();
+  host_set_.runCallbacks({}, {});
+  EXPECT_EQ(1UL, stats_.lb_rebuild_incremental_.value());
+  LoadBalancerPtr new_lb = lb_->factory()->create();
+  MaglevTable expected_table(HostsPerLocalityImpl(host_set_.healthy_hosts_, false), nullptr, 7);
+  uint64_t entries_moved = 0;
+  for (uint32_t i = 0; i < 7; ++i) {
+    TestLoadBalancerContext context(i);
+    EXPECT_EQ(expected_table.chooseHost(i), new_lb->chooseHost(&context));
+    if (lb->chooseHost(&context) != new_lb->chooseHost(&context)) {
+      entries_moved++;
+    }
+  }
+  EXPECT_NE(0UL, entries_moved);
+  EXPECT_EQ(entries_moved, stats_.lb_rebuild_entries_moved_.value());
+
+  // Changing the weight of a host changes the table.
+  host_set_.healthy_hosts_[0]->weight(2);
+  host_set_.runCallbacks({}, {});
+  EXPECT_EQ(1UL, stats_.lb_rebuild_incremental_.value());
+}
+
 } // namespace Upstream
 } // namespace Envoy
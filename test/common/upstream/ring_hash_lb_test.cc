@@ -1,9 +1,14 @@
+#include <algorithm>
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "envoy/router/router.h"
 
+#include "common/common/fmt.h"
+#include "common/common/hash.h"
 #include "common/network/utility.h"
 #include "common/upstream/ring_hash_lb.h"
 #include "common/upstream/upstream_impl.h"
@@ -49,6 +54,50 @@ public:
   // all the load balancers have equivalent functonality for failover host sets.
   MockHostSet& hostSet() { return GetParam() ? host_set_ : failover_host_set_; }
 
+  // Expect the current ring to choose the same hosts as a ring built from scratch for the hosts of
+  // hostSet().
+  void expectSameHostsAsNewRing() {
+    NiceMock<MockPrioritySet> priority_set;
+    MockHostSet& host_set = *priority_set.getMockHostSet(0);
+    host_set.hosts_ = hostSet().hosts_;
+    host_set.healthy_hosts_ = hostSet().healthy_hosts_;
+    Stats::IsolatedStoreImpl stats_store;
+    ClusterStats stats{ClusterInfoImpl::generateStats(stats_store)};
+    RingHashLoadBalancer new_lb(priority_set, stats, runtime_, random_, config_, common_config_);
+    new_lb.initialize();
+
+    LoadBalancerPtr lb = lb_->factory()->create();
+    LoadBalancerPtr expected_lb = new_lb.factory()->create();
+    for (uint64_t i = 0; i < 1000; i++) {
+      TestLoadBalancerContext context(HashUtil::xxHash64(std::to_string(i)));
+      EXPECT_EQ(expected_lb->chooseHost(&context), lb->chooseHost(&context));
+    }
+  }
+
+  // Expect the ring of the hosts of hostSet(), built with a minimum size of 1 and xxHash, to choose
+  // the host of the entry with the smallest hash that is not smaller than the hash of the request,
+  // or the first entry if there is none, for hashes around the entries of the ring.
+  void expectSortedRingLookups() {
+    std::vector<std::pair<uint64_t, HostSharedPtr>> entries;
+    for (const auto& host : hostSet().hosts_) {
+      entries.emplace_back(HashUtil::xxHash64(host->address()->asString() + "_0"), host);
+    }
+    std::sort(entries.begin(), entries.end());
+
+    LoadBalancerPtr lb = lb_->factory()->create();
+    const auto expect_host = [&lb](uint64_t hash, const HostSharedPtr& host) {
+      TestLoadBalancerContext context(hash);
+      EXPECT_EQ(host, lb->chooseHost(&context)) << hash;
+    };
+    expect_host(0, entries.front().second);
+    expect_host(std::numeric_limits<uint64_t>::max(), entries.front().second);
+    for (uint64_t i = 0; i < entries.size(); i++) {
+      expect_host(entries[i].first - 1, entries[i].second);
+      expect_host(entries[i].first, entries[i].second);
+      expect_host(entries[i].first + 1, entries[(i + 1) % entries.size()].second);
+    }
+  }
+
   NiceMock<MockPrioritySet> priority_set_;
   MockHostSet& host_set_ = *priority_set_.getMockHostSet(0);
   MockHostSet& failover_host_set_ = *priority_set_.getMockHostSet(1);
@@ -143,6 +192,83 @@ TEST_P(RingHashLoadBalancerTest, Basic) {
   EXPECT_EQ(1UL, stats_.lb_healthy_panic_.value());
 }
 
+// With a hash balance factor, requests skip the hosts of the following entries of the ring while
+// those are over their bound of active requests.
+TEST_P(RingHashLoadBalancerTest, BoundedLoads) {
+  hostSet().hosts_ = {
+      makeTestHost(info_, "tcp://127.0.0.1:90"), makeTestHost(info_, "tcp://127.0.0.1:91"),
+      makeTestHost(info_, "tcp://127.0.0.1:92"), makeTestHost(info_, "tcp://127.0.0.1:93"),
+      makeTestHost(info_, "tcp://127.0.0.1:94"), makeTestHost(info_, "tcp://127.0.0.1:95")};
+  hostSet().healthy_hosts_ = hostSet().hosts_;
+  hostSet().runCallbacks({}, {});
+
+  config_ = (envoy::api::v2::Cluster::RingHashLbConfig());
+  config_.value().mutable_minimum_ring_size()->set_value(12);
+  config_.value().mutable_deprecated_v1()->mutable_use_std_hash()->set_value(false);
+  common_config_.mutable_consistent_hashing_lb_config()->mutable_hash_balance_factor()->set_value(
+      150);
+  init();
+
+  // Same ring as in Basic. With 5 active requests in the cluster, a host can take the next one if
+  // it has less than ceil(6 / 6 * 1.5) = 2 active requests.
+  stats_.upstream_rq_active_.set(5);
+  LoadBalancerPtr lb = lb_->factory()->create();
+  TestLoadBalancerContext first_entry(0);
+  TestLoadBalancerContext last_entry(16117243373044804889UL);
+  EXPECT_EQ(hostSet().hosts_[4], lb->chooseHost(&first_entry));
+  EXPECT_EQ(hostSet().hosts_[0], lb->chooseHost(&last_entry));
+
+  hostSet().hosts_[4]->stats().rq_active_.set(2);
+  EXPECT_EQ(hostSet().hosts_[2], lb->chooseHost(&first_entry));
+
+  // The walk wraps around the ring.
+  hostSet().hosts_[2]->stats().rq_active_.set(2);
+  hostSet().hosts_[0]->stats().rq_active_.set(2);
+  EXPECT_EQ(hostSet().hosts_[5], lb->chooseHost(&first_entry));
+  EXPECT_EQ(hostSet().hosts_[5], lb->chooseHost(&last_entry));
+
+  // More active requests in the cluster raise the bound.
+  stats_.upstream_rq_active_.set(11);
+  EXPECT_EQ(hostSet().hosts_[4], lb->chooseHost(&first_entry));
+
+  // When all hosts are over their bound, the request goes to the host its hash maps to.
+  for (const auto& host : hostSet().hosts_) {
+    host->stats().rq_active_.set(10);
+  }
+  EXPECT_EQ(hostSet().hosts_[4], lb->chooseHost(&first_entry));
+  EXPECT_EQ(hostSet().hosts_[0], lb->chooseHost(&last_entry));
+}
+
+// With all hosts but one over their bound, every request goes to that host, wherever its hash
+// falls on a ring with many entries per host.
+TEST_P(RingHashLoadBalancerTest, BoundedLoadsAllButOneOverloaded) {
+  hostSet().hosts_ = {
+      makeTestHost(info_, "tcp://127.0.0.1:90"), makeTestHost(info_, "tcp://127.0.0.1:91"),
+      makeTestHost(info_, "tcp://127.0.0.1:92"), makeTestHost(info_, "tcp://127.0.0.1:93"),
+      makeTestHost(info_, "tcp://127.0.0.1:94"), makeTestHost(info_, "tcp://127.0.0.1:95")};
+  hostSet().healthy_hosts_ = hostSet().hosts_;
+  hostSet().runCallbacks({}, {});
+
+  config_ = (envoy::api::v2::Cluster::RingHashLbConfig());
+  config_.value().mutable_minimum_ring_size()->set_value(1024);
+  config_.value().mutable_deprecated_v1()->mutable_use_std_hash()->set_value(false);
+  common_config_.mutable_consistent_hashing_lb_config()->mutable_hash_balance_factor()->set_value(
+      150);
+  init();
+
+  // A host can take the next request if it has less than ceil(6 / 6 * 1.5) = 2 active requests.
+  stats_.upstream_rq_active_.set(5);
+  LoadBalancerPtr lb = lb_->factory()->create();
+  for (const auto& host : hostSet().hosts_) {
+    host->stats().rq_active_.set(2);
+  }
+  hostSet().hosts_[3]->stats().rq_active_.set(0);
+  for (uint64_t i = 0; i < 100; ++i) {
+    TestLoadBalancerContext context(i * 184467440737095516UL);
+    EXPECT_EQ(hostSet().hosts_[3], lb->chooseHost(&context));
+  }
+}
+
 // Ensure if all the hosts with priority 0 unhealthy, the next priority hosts are used.
 TEST_P(RingHashFailoverTest, BasicFailover) {
   host_set_.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80")};
@@ -281,5 +407,101 @@ TEST_P(RingHashLoadBalancerTest, UnevenHosts) {
   }
 }
 
+// Lookups in rings of any size find the same entries as in a sorted ring.
+TEST_P(RingHashLoadBalancerTest, LookupMatchesSortedRing) {
+  config_ = (envoy::api::v2::Cluster::RingHashLbConfig());
+  config_.value().mutable_minimum_ring_size()->set_value(1);
+  config_.value().mutable_deprecated_v1()->mutable_use_std_hash()->set_value(false);
+  for (uint32_t i = 0; i < 70; i++) {
+    hostSet().hosts_.push_back(makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", 90 + i)));
+    hostSet().healthy_hosts_ = hostSet().hosts_;
+    init();
+    expectSortedRingLookups();
+  }
+}
+
+// Rings of more than 65536 hosts index them with 32 bits.
+TEST_P(RingHashFailoverTest, ManyHosts) {
+  config_ = (envoy::api::v2::Cluster::RingHashLbConfig());
+  config_.value().mutable_minimum_ring_size()->set_value(1);
+  config_.value().mutable_deprecated_v1()->mutable_use_std_hash()->set_value(false);
+  for (uint32_t i = 0; i < 70000; i++) {
+    hostSet().hosts_.push_back(makeTestHost(
+        info_, fmt::format("tcp://10.{}.{}.{}:80", i / 65536, i / 256 % 256, i % 256)));
+  }
+  hostSet().healthy_hosts_ = hostSet().hosts_;
+  init();
+  expectSortedRingLookups();
+}
+
+// Rings are updated in place of being rebuilt when most of their entries are kept.
+TEST_P(RingHashLoadBalancerTest, IncrementalRebuild) {
+  hostSet().hosts_ = {
+      makeTestHost(info_, "tcp://127.0.0.1:90"), makeTestHost(info_, "tcp://127.0.0.1:91"),
+      makeTestHost(info_, "tcp://127.0.0.1:92"), makeTestHost(info_, "tcp://127.0.0.1:93"),
+      makeTestHost(info_, "tcp://127.0.0.1:94"), makeTestHost(info_, "tcp://127.0.0.1:95")};
+  hostSet().healthy_hosts_ = hostSet().hosts_;
+  hostSet().runCallbacks({}, {});
+
+  config_ = (envoy::api::v2::Cluster::RingHashLbConfig());
+  config_.value().mutable_minimum_ring_size()->set_value(12);
+  config_.value().mutable_deprecated_v1()->mutable_use_std_hash()->set_value(false);
+  init();
+  EXPECT_EQ(0UL, stats_.lb_rebuild_entries_moved_.value());
+
+  // With 5 hosts, each host has 3 entries instead of 2. The 2 entries of the removed host are
+  // dropped and one entry is added for each of the other hosts.
+  hostSet().healthy_hosts_.pop_back();
+  hostSet().runCallbacks({}, {});
+  EXPECT_EQ(7UL, stats_.lb_rebuild_entries_moved_.value());
+  EXPECT_EQ(1UL, stats_.lb_rebuild_incremental_.value());
+  expectSameHostsAsNewRing();
+
+  // The same hosts keep the same ring.
+  hostSet().runCallbacks({}, {});
+  EXPECT_EQ(7UL, stats_.lb_rebuild_entries_moved_.value());
+  EXPECT_EQ(2UL, stats_.lb_rebuild_incremental_.value());
+  expectSameHostsAsNewRing();
+
+  // Adding a host back removes one entry of each host and adds 2 entries, which is more than half
+  // of the 12 entries of the ring, so the ring is rebuilt.
+  hostSet().healthy_hosts_.push_back(makeTestHost(info_, "tcp://127.0.0.1:96"));
+  hostSet().runCallbacks({}, {});
+  EXPECT_EQ(14UL, stats_.lb_rebuild_entries_moved_.value());
+  EXPECT_EQ(2UL, stats_.lb_rebuild_incremental_.value());
+  expectSameHostsAsNewRing();
+
+  // Replacing a host keeps the number of entries per host.
+  hostSet().healthy_hosts_[0] = makeTestHost(info_, "tcp://127.0.0.1:97");
+  hostSet().runCallbacks({}, {});
+  EXPECT_EQ(18UL, stats_.lb_rebuild_entries_moved_.value());
+  EXPECT_EQ(3UL, stats_.lb_rebuild_incremental_.value());
+  expectSameHostsAsNewRing();
+}
+
+// Only the ring of the priority level whose hosts changed is rebuilt.
+TEST_P(RingHashFailoverTest, RebuildUpdatedPriorityOnly) {
+  host_set_.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
+                      makeTestHost(info_, "tcp://127.0.0.1:81")};
+  host_set_.healthy_hosts_ = {host_set_.hosts_[0]};
+  failover_host_set_.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:82"),
+                               makeTestHost(info_, "tcp://127.0.0.1:83")};
+  failover_host_set_.healthy_hosts_ = failover_host_set_.hosts_;
+  init();
+
+  // The 2 failover hosts have 342 entries each instead of 512, and the added host 342 entries.
+  failover_host_set_.healthy_hosts_.push_back(makeTestHost(info_, "tcp://127.0.0.1:84"));
+  failover_host_set_.runCallbacks({}, {});
+  EXPECT_EQ(682UL, stats_.lb_rebuild_entries_moved_.value());
+  EXPECT_EQ(0UL, stats_.lb_rebuild_incremental_.value());
+
+  // A priority level that enters panic mode is rebuilt with all its hosts, even if it was not
+  // updated. Its healthy host had 1024 entries, and both hosts have 512 entries.
+  host_set_.healthy_hosts_.clear();
+  failover_host_set_.runCallbacks({}, {});
+  EXPECT_EQ(1706UL, stats_.lb_rebuild_entries_moved_.value());
+  EXPECT_EQ(1UL, stats_.lb_rebuild_incremental_.value());
+}
+
 } // namespace Upstream
 } // namespace Envoy
@@ -807,6 +807,10 @@ TEST_P(SubsetLoadBalancerTest, LoadBalancerTypesRingHash) {
 
 TEST_P(SubsetLoadBalancerTest, LoadBalancerTypesMaglev) { doLbTypeTest(LoadBalancerType::Maglev); }
 
+TEST_P(SubsetLoadBalancerTest, LoadBalancerTypesPeakEwma) {
+  doLbTypeTest(LoadBalancerType::PeakEwma);
+}
+
 TEST_F(SubsetLoadBalancerTest, ZoneAwareFallback) {
   EXPECT_CALL(subset_info_, fallbackPolicy())
       .WillRepeatedly(Return(envoy::api::v2::Cluster::LbSubsetConfig::ANY_ENDPOINT));
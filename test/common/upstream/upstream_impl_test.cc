@@ -1,4 +1,5 @@
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <list>
 #include <string>
@@ -398,6 +399,30 @@ TEST(HostImplTest, Weight) {
   EXPECT_EQ(128U, host->weight());
 }
 
+TEST(HostImplTest, PeakEwmaLatencyEstimator) {
+  MockCluster cluster;
+  HostSharedPtr host = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234");
+  LatencyEstimator& estimator = host->latencyEstimator();
+  const MonotonicTime start = std::chrono::steady_clock::now();
+  EXPECT_EQ(0, estimator.estimate(start));
+
+  // The estimate jumps to a latency above it, and decays towards 0 without latencies.
+  estimator.putLatency(std::chrono::milliseconds(100), start);
+  EXPECT_DOUBLE_EQ(100000, estimator.estimate(start));
+  EXPECT_DOUBLE_EQ(100000 * std::exp(-1), estimator.estimate(start + std::chrono::seconds(10)));
+
+  // It moves towards a latency below it.
+  estimator.putLatency(std::chrono::milliseconds(10), start + std::chrono::seconds(10));
+  EXPECT_DOUBLE_EQ(100000 * std::exp(-1) + 10000 * (1 - std::exp(-1)),
+                   estimator.estimate(start + std::chrono::seconds(10)));
+
+  // A latency recorded at a later time than the one read does not decay.
+  EXPECT_DOUBLE_EQ(100000 * std::exp(-1) + 10000 * (1 - std::exp(-1)),
+                   estimator.estimate(start + std::chrono::seconds(5)));
+  estimator.putLatency(std::chrono::milliseconds(200), start + std::chrono::seconds(20));
+  EXPECT_DOUBLE_EQ(200000, estimator.estimate(start + std::chrono::seconds(20)));
+}
+
 TEST(HostImplTest, HostnameCanaryAndLocality) {
   MockCluster cluster;
   envoy::api::v2::core::Metadata metadata;
@@ -874,6 +899,27 @@ TEST(ClusterMetadataTest, Metadata) {
   EXPECT_EQ(LoadBalancerType::Maglev, cluster.info()->lbType());
 }
 
+TEST(StrictDnsClusterImplTest, PeakEwmaLbPolicy) {
+  Stats::IsolatedStoreImpl stats;
+  Ssl::MockContextManager ssl_context_manager;
+  auto dns_resolver = std::make_shared<Network::MockDnsResolver>();
+  NiceMock<Event::MockDispatcher> dispatcher;
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<MockClusterManager> cm;
+
+  const std::string yaml = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: PEAK_EWMA
+    hosts: [{ socket_address: { address: foo.bar.com, port_value: 443 }}]
+  )EOF";
+
+  StrictDnsClusterImpl cluster(parseClusterFromV2Yaml(yaml), runtime, stats, ssl_context_manager,
+                               dns_resolver, cm, dispatcher, false);
+  EXPECT_EQ(LoadBalancerType::PeakEwma, cluster.info()->lbType());
+}
+
 // Validate empty singleton for HostsPerLocalityImpl.
 TEST(HostsPerLocalityImpl, Empty) {
   EXPECT_FALSE(HostsPerLocalityImpl::empty()->hasLocalLocality());
@@ -0,0 +1,163 @@
+#include <string>
+#include <vector>
+
+#include "envoy/config/accesslog/v2/binary.pb.h"
+#include "envoy/data/accesslog/v2/accesslog.pb.h"
+#include "envoy/registry/registry.h"
+
+#include "common/access_log/access_log_impl.h"
+#include "common/api/os_sys_calls_impl.h"
+#include "common/common/fmt.h"
+#include "common/filesystem/filesystem_impl.h"
+
+#include "extensions/access_loggers/binary/binary_access_log_impl.h"
+#include "extensions/access_loggers/binary/config.h"
+#include "extensions/access_loggers/well_known_names.h"
+
+#include "test/mocks/request_info/mocks.h"
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Binary {
+
+class BinaryAccessLogTest : public testing::Test {
+protected:
+  BinaryAccessLogTest() : path_(TestEnvironment::temporaryPath("binary_access_log_test")) {
+    ::unlink((path_ + ".0").c_str());
+    ::unlink((path_ + ".1").c_str());
+    config_.set_path(path_);
+    config_.mutable_file_size_bytes()->set_value(4 * RingFileWriter::DefaultBlockSize);
+  }
+
+  AccessLog::InstanceSharedPtr createLog() {
+    return BinaryAccessLogFactory().createAccessLogInstance(config_, nullptr, context_);
+  }
+
+  // Reads the entries written to the file with the given index, by default the main thread's.
+  std::vector<envoy::data::accesslog::v2::HTTPAccessLogEntry> readEntries(uint32_t index = 0) {
+    std::vector<envoy::data::accesslog::v2::HTTPAccessLogEntry> entries;
+    RingFileReader::forEachRecord(Filesystem::fileReadToEnd(fmt::format("{}.{}", path_, index)),
+                                  [&entries](absl::string_view record) {
+                                    entries.emplace_back();
+                                    EXPECT_TRUE(entries.back().ParseFromArray(record.data(),
+                                                                              record.size()));
+                                  });
+    return entries;
+  }
+
+  const std::string path_;
+  envoy::config::accesslog::v2::BinaryAccessLog config_;
+  NiceMock<Server::Configuration::MockFactoryContext> context_;
+  NiceMock<RequestInfo::MockRequestInfo> request_info_;
+};
+
+TEST_F(BinaryAccessLogTest, ValidateFail) {
+  EXPECT_THROW(BinaryAccessLogFactory().createAccessLogInstance(
+                   envoy::config::accesslog::v2::BinaryAccessLog(), nullptr, context_),
+               ProtoValidationException);
+
+  config_.mutable_file_size_bytes()->set_value(2 * RingFileWriter::DefaultBlockSize);
+  EXPECT_THROW_WITH_MESSAGE(createLog(), EnvoyException,
+                            "binary access log file_size_bytes must be at least 196608");
+}
+
+TEST_F(BinaryAccessLogTest, ConfigureFromProto) {
+  envoy::config::filter::accesslog::v2::AccessLog config;
+  config.set_name(AccessLogNames::get().BINARY);
+  MessageUtil::jsonConvert(config_, *config.mutable_config());
+
+  AccessLog::InstanceSharedPtr log = AccessLog::AccessLogFactory::fromProto(config, context_);
+  EXPECT_NE(nullptr, dynamic_cast<BinaryAccessLog*>(log.get()));
+}
+
+TEST_F(BinaryAccessLogTest, Log) {
+  config_.add_additional_request_headers_to_log("x-custom");
+  AccessLog::InstanceSharedPtr log = createLog();
+
+  Http::TestHeaderMapImpl request_headers{{":path", "/first"}, {"x-custom", "value"}};
+  log->log(&request_headers, nullptr, nullptr, request_info_);
+  request_headers.insertPath().value(std::string("/second"));
+  log->log(&request_headers, nullptr, nullptr, request_info_);
+
+  const std::vector<envoy::data::accesslog::v2::HTTPAccessLogEntry> entries = readEntries();
+  ASSERT_EQ(2, entries.size());
+  EXPECT_EQ("/first", entries[0].request().path());
+  EXPECT_EQ("value", entries[0].request().request_headers().at("x-custom"));
+  EXPECT_EQ("/second", entries[1].request().path());
+  EXPECT_EQ(2, TestUtility::findCounter(context_.scope_, "access_log.binary.records_written")
+                   ->value());
+}
+
+TEST_F(BinaryAccessLogTest, RecordTooLarge) {
+  AccessLog::InstanceSharedPtr log = createLog();
+
+  Http::TestHeaderMapImpl request_headers{
+      {":path", std::string(RingFileWriter::DefaultBlockSize, 'x')}};
+  log->log(&request_headers, nullptr, nullptr, request_info_);
+
+  EXPECT_TRUE(readEntries().empty());
+  EXPECT_EQ(1, TestUtility::findCounter(context_.scope_, "access_log.binary.records_dropped")
+                   ->value());
+}
+
+// Logs that write to the same path share their files, so that each file has one writer.
+TEST_F(BinaryAccessLogTest, SharedPath) {
+  AccessLog::InstanceSharedPtr first = createLog();
+  AccessLog::InstanceSharedPtr second = createLog();
+
+  Http::TestHeaderMapImpl request_headers{{":path", "/first"}};
+  first->log(&request_headers, nullptr, nullptr, request_info_);
+  request_headers.insertPath().value(std::string("/second"));
+  second->log(&request_headers, nullptr, nullptr, request_info_);
+
+  const std::vector<envoy::data::accesslog::v2::HTTPAccessLogEntry> entries = readEntries();
+  ASSERT_EQ(2, entries.size());
+  EXPECT_EQ("/first", entries[0].request().path());
+  EXPECT_EQ("/second", entries[1].request().path());
+
+  config_.mutable_file_size_bytes()->set_value(8 * RingFileWriter::DefaultBlockSize);
+  EXPECT_THROW_WITH_MESSAGE(
+      createLog(), EnvoyException,
+      fmt::format("binary access log '{}' is in use with a file size of 262144 bytes, not "
+                  "524288 bytes",
+                  path_));
+
+  // Once the files are no longer used, they can be opened with another size.
+  first.reset();
+  second.reset();
+  EXPECT_NE(nullptr, createLog());
+}
+
+// A file still written by another writer, as during a hot restart, is skipped for the next one.
+TEST_F(BinaryAccessLogTest, LockedFile) {
+  Api::OsSysCallsImpl os_sys_calls;
+  RingFileWriter parent_writer(path_ + ".0", RingFileWriter::DefaultBlockSize, 3, os_sys_calls);
+  AccessLog::InstanceSharedPtr log = createLog();
+
+  Http::TestHeaderMapImpl request_headers{{":path", "/first"}};
+  log->log(&request_headers, nullptr, nullptr, request_info_);
+
+  EXPECT_TRUE(readEntries(0).empty());
+  const std::vector<envoy::data::accesslog::v2::HTTPAccessLogEntry> entries = readEntries(1);
+  ASSERT_EQ(1, entries.size());
+  EXPECT_EQ("/first", entries[0].request().path());
+}
+
+TEST_F(BinaryAccessLogTest, OpenFailure) {
+  config_.set_path(TestEnvironment::temporaryPath("does/not/exist/binary_access_log"));
+  EXPECT_THROW(createLog(), EnvoyException);
+}
+
+} // namespace Binary
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,220 @@
+#include <sys/file.h>
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "envoy/common/exception.h"
+
+#include "common/api/os_sys_calls_impl.h"
+#include "common/common/fmt.h"
+#include "common/filesystem/filesystem_impl.h"
+
+#include "extensions/access_loggers/binary/ring_file.h"
+
+#include "test/mocks/api/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Binary {
+
+// Small blocks, so that a few records fill one: each holds 8 records with a 4 byte payload.
+const uint32_t BlockSize = sizeof(RingFileBlockHeader) + 8 * (sizeof(uint32_t) + 4);
+
+class RingFileTest : public testing::Test {
+protected:
+  RingFileTest() : path_(TestEnvironment::temporaryPath("ring_file_test")) {
+    ::unlink(path_.c_str());
+  }
+
+  RingFileWriterPtr makeWriter(uint64_t num_blocks = 4) {
+    return std::make_unique<RingFileWriter>(path_, BlockSize, num_blocks, os_sys_calls_);
+  }
+
+  std::vector<std::string> readRecords() {
+    std::vector<std::string> records;
+    RingFileReader::forEachRecord(Filesystem::fileReadToEnd(path_),
+                                  [&records](absl::string_view record) {
+                                    records.emplace_back(std::string(record));
+                                  });
+    return records;
+  }
+
+  const std::string path_;
+  Api::OsSysCallsImpl os_sys_calls_;
+};
+
+TEST_F(RingFileTest, Empty) {
+  makeWriter();
+  EXPECT_TRUE(readRecords().empty());
+}
+
+TEST_F(RingFileTest, WriteAndRead) {
+  RingFileWriterPtr writer = makeWriter();
+  EXPECT_TRUE(writer->write("r000"));
+  EXPECT_TRUE(writer->write(""));
+  EXPECT_TRUE(writer->write("r2"));
+  EXPECT_EQ(std::vector<std::string>({"r000", "", "r2"}), readRecords());
+}
+
+TEST_F(RingFileTest, TooLarge) {
+  RingFileWriterPtr writer = makeWriter();
+  EXPECT_EQ(BlockSize - sizeof(RingFileBlockHeader) - sizeof(uint32_t), writer->maxRecordSize());
+  EXPECT_FALSE(writer->write(std::string(writer->maxRecordSize() + 1, 'x')));
+  EXPECT_TRUE(writer->write(std::string(writer->maxRecordSize(), 'x')));
+  EXPECT_EQ(std::vector<std::string>({std::string(writer->maxRecordSize(), 'x')}), readRecords());
+}
+
+// Once every block is full, the oldest block is overwritten and its records are lost.
+TEST_F(RingFileTest, Wrap) {
+  RingFileWriterPtr writer = makeWriter(3);
+  for (uint32_t i = 0; i < 30; ++i) {
+    EXPECT_TRUE(writer->write(fmt::format("r{:03}", i)));
+  }
+
+  // 30 records fill 3 blocks and start a 4th, which replaced the first block.
+  std::vector<std::string> expected;
+  for (uint32_t i = 8; i < 30; ++i) {
+    expected.push_back(fmt::format("r{:03}", i));
+  }
+  EXPECT_EQ(expected, readRecords());
+}
+
+TEST_F(RingFileTest, Resume) {
+  makeWriter()->write("r000");
+  makeWriter()->write("r001");
+  EXPECT_EQ(std::vector<std::string>({"r000", "r001"}), readRecords());
+
+  // A writer with a different layout starts again.
+  makeWriter(5)->write("r002");
+  EXPECT_EQ(std::vector<std::string>({"r002"}), readRecords());
+}
+
+TEST_F(RingFileTest, ResumeAfterWrap) {
+  {
+    RingFileWriterPtr writer = makeWriter(2);
+    for (uint32_t i = 0; i < 20; ++i) {
+      writer->write(fmt::format("r{:03}", i));
+    }
+  }
+  // The last block, with 4 records, is appended to.
+  makeWriter(2)->write("r020");
+
+  std::vector<std::string> expected;
+  for (uint32_t i = 8; i < 21; ++i) {
+    expected.push_back(fmt::format("r{:03}", i));
+  }
+  EXPECT_EQ(expected, readRecords());
+}
+
+TEST_F(RingFileTest, NotARingFile) {
+  EXPECT_THROW_WITH_MESSAGE(RingFileReader::forEachRecord("short", nullptr), EnvoyException,
+                            "not a ring file: too short");
+  EXPECT_THROW_WITH_MESSAGE(
+      RingFileReader::forEachRecord(std::string(BlockSize * 3, 'x'), nullptr), EnvoyException,
+      "not a ring file: bad magic");
+
+  makeWriter();
+  const std::string contents = Filesystem::fileReadToEnd(path_);
+  EXPECT_THROW_WITH_MESSAGE(
+      RingFileReader::forEachRecord(contents.substr(0, BlockSize * 4), nullptr), EnvoyException,
+      "not a ring file: truncated");
+}
+
+// A corrupt header must not wrap the block count around and pass for a long enough file.
+TEST_F(RingFileTest, CorruptHeader) {
+  makeWriter();
+  std::string contents = Filesystem::fileReadToEnd(path_);
+  RingFileHeader header;
+  memcpy(&header, contents.data(), sizeof(header));
+  header.num_blocks_ = std::numeric_limits<uint64_t>::max();
+  memcpy(&contents[0], &header, sizeof(header));
+  EXPECT_THROW_WITH_MESSAGE(RingFileReader::forEachRecord(contents, nullptr), EnvoyException,
+                            "not a ring file: truncated");
+}
+
+TEST_F(RingFileTest, Locked) {
+  RingFileWriterPtr writer = makeWriter();
+  EXPECT_THROW_WITH_MESSAGE(makeWriter(), RingFileLockedException,
+                            fmt::format("ring file '{}' is locked by another writer", path_));
+
+  // The lock is released with the writer.
+  writer->write("r000");
+  writer.reset();
+  makeWriter()->write("r001");
+  EXPECT_EQ(std::vector<std::string>({"r000", "r001"}), readRecords());
+}
+
+TEST_F(RingFileTest, Layout) {
+  EXPECT_THROW_WITH_MESSAGE(RingFileWriter(path_, BlockSize, 1, os_sys_calls_), EnvoyException,
+                            fmt::format("ring file '{}' needs at least two blocks larger than 20 "
+                                        "bytes",
+                                        path_));
+  EXPECT_THROW(RingFileWriter(path_, 20, 2, os_sys_calls_), EnvoyException);
+}
+
+TEST(RingFileErrorTest, OpenFailure) {
+  testing::NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  EXPECT_CALL(os_sys_calls, open(_, _, _)).WillOnce(Return(-1));
+  EXPECT_THROW(RingFileWriter("/nonexistent/ring", 1024, 2, os_sys_calls), EnvoyException);
+}
+
+TEST(RingFileErrorTest, LockFailure) {
+  testing::NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  EXPECT_CALL(os_sys_calls, open(_, _, _)).WillOnce(Return(5));
+  EXPECT_CALL(os_sys_calls, flock(5, LOCK_EX | LOCK_NB)).WillOnce(Invoke([](int, int) {
+    errno = ENOLCK;
+    return -1;
+  }));
+  EXPECT_CALL(os_sys_calls, close(5));
+  EXPECT_THROW_WITH_MESSAGE(RingFileWriter("ring", 1024, 2, os_sys_calls), EnvoyException,
+                            fmt::format("unable to lock ring file 'ring': {}", strerror(ENOLCK)));
+}
+
+// A sparse file could raise SIGBUS when written through the mapping with the disk full, so the
+// writer fails if the file cannot be allocated.
+TEST(RingFileErrorTest, AllocateFailure) {
+  testing::NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  EXPECT_CALL(os_sys_calls, open(_, _, _)).WillOnce(Return(5));
+  EXPECT_CALL(os_sys_calls, fstat(5, _)).WillOnce(Invoke([](int, struct stat* info) {
+    info->st_size = 3 * 1024;
+    return 0;
+  }));
+  EXPECT_CALL(os_sys_calls, posixFallocate(5, 0, 3 * 1024)).WillOnce(Return(ENOSPC));
+  EXPECT_CALL(os_sys_calls, mmap(_, _, _, _, _, _)).Times(0);
+  EXPECT_CALL(os_sys_calls, close(5));
+  EXPECT_THROW_WITH_MESSAGE(RingFileWriter("ring", 1024, 2, os_sys_calls), EnvoyException,
+                            fmt::format("unable to allocate ring file 'ring': {}",
+                                        strerror(ENOSPC)));
+}
+
+TEST(RingFileErrorTest, MapFailure) {
+  testing::NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  EXPECT_CALL(os_sys_calls, open(_, _, _)).WillOnce(Return(5));
+  EXPECT_CALL(os_sys_calls, fstat(5, _)).WillOnce(Invoke([](int, struct stat* info) {
+    info->st_size = 0;
+    return 0;
+  }));
+  EXPECT_CALL(os_sys_calls, ftruncate(5, 3 * 1024)).WillOnce(Return(0));
+  EXPECT_CALL(os_sys_calls, posixFallocate(5, 0, 3 * 1024)).WillOnce(Return(0));
+  EXPECT_CALL(os_sys_calls, mmap(_, 3 * 1024, _, _, 5, 0)).WillOnce(Return(MAP_FAILED));
+  EXPECT_CALL(os_sys_calls, close(5));
+  EXPECT_THROW(RingFileWriter("ring", 1024, 2, os_sys_calls), EnvoyException);
+}
+
+} // namespace Binary
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -416,7 +416,8 @@ TEST(responseFlagsToAccessLogResponseFlagsTest, All) {
   NiceMock<RequestInfo::MockRequestInfo> request_info;
   ON_CALL(request_info, hasResponseFlag(_)).WillByDefault(Return(true));
   envoy::data::accesslog::v2::AccessLogCommon common_access_log;
-  HttpGrpcAccessLog::responseFlagsToAccessLogResponseFlags(common_access_log, request_info);
+  Common::HttpLogEntryBuilder::responseFlagsToAccessLogResponseFlags(common_access_log,
+                                                                    request_info);
 
   envoy::data::accesslog::v2::AccessLogCommon common_access_log_expected;
   common_access_log_expected.mutable_response_flags()->set_failed_local_healthcheck(true);
@@ -98,20 +98,20 @@ class HystrixSinkTest : public testing::Test {
 public:
   HystrixSinkTest() { sink_.reset(new HystrixSink(server_, window_size_)); }
 
-  Buffer::OwnedImpl createClusterAndCallbacks() {
+  // Set the cluster, and callbacks that send the data of the sink to buffer. The buffer must
+  // outlive the callbacks.
+  void createClusterAndCallbacks(Buffer::Instance& buffer) {
     // Set cluster.
     cluster_map_.emplace(cluster1_name_, cluster1_.cluster_);
     ON_CALL(server_, clusterManager()).WillByDefault(ReturnRef(cluster_manager_));
     ON_CALL(cluster_manager_, clusters()).WillByDefault(Return(cluster_map_));
 
-    Buffer::OwnedImpl buffer;
     auto encode_callback = [&buffer](Buffer::Instance& data, bool) {
       // Set callbacks to send data to buffer. This will append to the end of the buffer, so
       // multiple calls will all be dumped one after another into this buffer.
       buffer.add(data);
     };
     ON_CALL(callbacks_, encodeData(_, _)).WillByDefault(Invoke(encode_callback));
-    return buffer;
   }
 
   void addClusterToMap(const std::string& cluster_name, NiceMock<Upstream::MockCluster>& cluster) {
@@ -228,7 +228,8 @@ public:
 
 TEST_F(HystrixSinkTest, EmptyFlush) {
   InSequence s;
-  Buffer::OwnedImpl buffer = createClusterAndCallbacks();
+  Buffer::OwnedImpl buffer;
+  createClusterAndCallbacks(buffer);
   // Register callback to sink.
   sink_->registerConnection(&callbacks_);
   sink_->flush(source_);
@@ -239,7 +240,8 @@ TEST_F(HystrixSinkTest, EmptyFlush) {
 
 TEST_F(HystrixSinkTest, BasicFlow) {
   InSequence s;
-  Buffer::OwnedImpl buffer = createClusterAndCallbacks();
+  Buffer::OwnedImpl buffer;
+  createClusterAndCallbacks(buffer);
   // Register callback to sink.
   sink_->registerConnection(&callbacks_);
 
@@ -309,7 +311,8 @@ TEST_F(HystrixSinkTest, BasicFlow) {
 //
 TEST_F(HystrixSinkTest, Disconnect) {
   InSequence s;
-  Buffer::OwnedImpl buffer = createClusterAndCallbacks();
+  Buffer::OwnedImpl buffer;
+  createClusterAndCallbacks(buffer);
 
   sink_->flush(source_);
   EXPECT_EQ(buffer.length(), 0);
@@ -364,7 +367,8 @@ TEST_F(HystrixSinkTest, AddCluster) {
   const uint64_t error_step2 = 33;
   const uint64_t timeout_step2 = 22;
 
-  Buffer::OwnedImpl buffer = createClusterAndCallbacks();
+  Buffer::OwnedImpl buffer;
+  createClusterAndCallbacks(buffer);
 
   // Add cluster and "run" some traffic.
   std::unordered_map<std::string, std::string> cluster_message_map =
@@ -398,7 +402,8 @@ TEST_F(HystrixSinkTest, AddAndRemoveClusters) {
   const uint64_t error_step2 = 934;
   const uint64_t timeout_step2 = 212;
 
-  Buffer::OwnedImpl buffer = createClusterAndCallbacks();
+  Buffer::OwnedImpl buffer;
+  createClusterAndCallbacks(buffer);
 
   // Add cluster and "run" some traffic.
   addSecondClusterAndSendDataHelper(buffer, success_step, error_step, timeout_step, success_step2,
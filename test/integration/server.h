@@ -64,6 +64,7 @@ public:
   uint64_t maxStats() const override { return 16384; }
   uint64_t maxObjNameLength() const override { return 60; }
   bool hotRestartDisabled() const override { return false; }
+  bool libeventBuffersEnabled() const override { return true; }
 
   // asConfigYaml returns a new config that empties the configPath() and populates configYaml()
   Server::TestOptionsImpl asConfigYaml();
@@ -1,5 +1,6 @@
 #include "test/integration/websocket_integration_test.h"
 
+#include <regex>
 #include <string>
 
 #include "envoy/config/accesslog/v2/file.pb.h"
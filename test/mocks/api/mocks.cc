@@ -40,16 +40,27 @@ ssize_t MockOsSysCalls::write(int fd, const void* buffer, size_t num_bytes) {
   return result;
 }
 
+ssize_t MockOsSysCalls::writev(int fd, const iovec* iovec, int num_iovec) {
+  Thread::LockGuard lock(write_mutex_);
+
+  ssize_t result = writev_(fd, iovec, num_iovec);
+  num_writes_++;
+  write_event_.notifyOne();
+
+  return result;
+}
+
 int MockOsSysCalls::setsockopt(int sockfd, int level, int optname, const void* optval,
                                socklen_t optlen) {
-  ASSERT(optlen == sizeof(int));
-
   // Allow mocking system call failure.
   if (setsockopt_(sockfd, level, optname, optval, optlen) != 0) {
     return -1;
   }
 
-  boolsockopts_[SockOptKey(sockfd, level, optname)] = !!*reinterpret_cast<const int*>(optval);
+  // Only boolean options are recorded for getsockopt(), others such as SO_LINGER are only mocked.
+  if (optlen == sizeof(int)) {
+    boolsockopts_[SockOptKey(sockfd, level, optname)] = !!*reinterpret_cast<const int*>(optval);
+  }
   return 0;
 };
 
@@ -43,23 +43,32 @@ public:
 
   // Api::OsSysCalls
   ssize_t write(int fd, const void* buffer, size_t num_bytes) override;
+  ssize_t writev(int fd, const iovec* iovec, int num_iovec) override;
   int open(const std::string& full_path, int flags, int mode) override;
   int setsockopt(int sockfd, int level, int optname, const void* optval, socklen_t optlen) override;
   int getsockopt(int sockfd, int level, int optname, void* optval, socklen_t* optlen) override;
 
   MOCK_METHOD3(bind, int(int sockfd, const sockaddr* addr, socklen_t addrlen));
   MOCK_METHOD1(close, int(int));
+  MOCK_METHOD1(dup, int(int fd));
+  MOCK_METHOD2(shutdown, int(int sockfd, int how));
   MOCK_METHOD3(open_, int(const std::string& full_path, int flags, int mode));
   MOCK_METHOD3(write_, ssize_t(int, const void*, size_t));
-  MOCK_METHOD3(writev, ssize_t(int, const iovec*, int));
+  MOCK_METHOD3(writev_, ssize_t(int, const iovec*, int));
   MOCK_METHOD3(readv, ssize_t(int, const iovec*, int));
   MOCK_METHOD4(recv, ssize_t(int socket, void* buffer, size_t length, int flags));
+  MOCK_METHOD3(sendmsg, ssize_t(int socket, const msghdr* message, int flags));
+  MOCK_METHOD3(recvmsg, ssize_t(int socket, msghdr* message, int flags));
 
   MOCK_METHOD3(shmOpen, int(const char*, int, mode_t));
   MOCK_METHOD1(shmUnlink, int(const char*));
   MOCK_METHOD2(ftruncate, int(int fd, off_t length));
   MOCK_METHOD6(mmap, void*(void* addr, size_t length, int prot, int flags, int fd, off_t offset));
+  MOCK_METHOD2(munmap, int(void* addr, size_t length));
   MOCK_METHOD2(stat, int(const char* name, struct stat* stat));
+  MOCK_METHOD2(fstat, int(int fd, struct stat* stat));
+  MOCK_METHOD2(flock, int(int fd, int operation));
+  MOCK_METHOD3(posixFallocate, int(int fd, off_t offset, off_t length));
   MOCK_METHOD5(setsockopt_,
                int(int sockfd, int level, int optname, const void* optval, socklen_t optlen));
   MOCK_METHOD5(getsockopt_,
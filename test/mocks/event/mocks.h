@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <functional>
 #include <list>
+#include <unordered_map>
 
 #include "envoy/event/deferred_deletable.h"
 #include "envoy/event/dispatcher.h"
@@ -69,6 +70,17 @@ public:
     }
   }
 
+  void own(DeferredDeletablePtr&& to_own) override {
+    DeferredDeletable* key = to_own.get();
+    owned_.emplace(key, std::move(to_own));
+  }
+
+  DeferredDeletablePtr disown(DeferredDeletable& owned) override {
+    DeferredDeletablePtr item = std::move(owned_[&owned]);
+    owned_.erase(&owned);
+    return item;
+  }
+
   SignalEventPtr listenForSignal(int signal_num, SignalCb cb) override {
     return SignalEventPtr{listenForSignal_(signal_num, cb)};
   }
@@ -101,8 +113,10 @@ public:
   MOCK_METHOD1(post, void(std::function<void()> callback));
   MOCK_METHOD1(run, void(RunType type));
   Buffer::WatermarkFactory& getWatermarkFactory() override { return buffer_factory_; }
+  MOCK_METHOD2(initializeStats, void(Stats::Scope& scope, const std::string& prefix));
 
   std::list<DeferredDeletablePtr> to_delete_;
+  std::unordered_map<DeferredDeletable*, DeferredDeletablePtr> owned_;
   MockBufferFactory buffer_factory_;
 };
 
@@ -57,7 +57,10 @@ MockServerConnection::MockServerConnection() {
 
 MockServerConnection::~MockServerConnection() {}
 
-MockClientConnection::MockClientConnection() {}
+MockClientConnection::MockClientConnection() {
+  ON_CALL(*this, maxConcurrentStreams())
+      .WillByDefault(Return(Http2Settings::DEFAULT_MAX_CONCURRENT_STREAMS));
+}
 MockClientConnection::~MockClientConnection() {}
 
 MockFilterChainFactory::MockFilterChainFactory() {}
@@ -155,6 +155,7 @@ public:
 
   // Http::ClientConnection
   MOCK_METHOD1(newStream, StreamEncoder&(StreamDecoder& response_decoder));
+  MOCK_METHOD0(maxConcurrentStreams, uint32_t());
 };
 
 class MockFilterChainFactory : public FilterChainFactory {
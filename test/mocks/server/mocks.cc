@@ -30,6 +30,8 @@ MockOptions::MockOptions(const std::string& config_path) : config_path_(config_p
   ON_CALL(*this, maxStats()).WillByDefault(Return(1000));
   ON_CALL(*this, maxObjNameLength()).WillByDefault(Return(150));
   ON_CALL(*this, hotRestartDisabled()).WillByDefault(ReturnPointee(&hot_restart_disabled_));
+  ON_CALL(*this, libeventBuffersEnabled())
+      .WillByDefault(ReturnPointee(&libevent_buffers_enabled_));
 }
 MockOptions::~MockOptions() {}
 
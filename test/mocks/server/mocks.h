@@ -70,6 +70,7 @@ public:
   MOCK_CONST_METHOD0(maxStats, uint64_t());
   MOCK_CONST_METHOD0(maxObjNameLength, uint64_t());
   MOCK_CONST_METHOD0(hotRestartDisabled, bool());
+  MOCK_CONST_METHOD0(libeventBuffersEnabled, bool());
 
   std::string config_path_;
   std::string config_yaml_;
@@ -80,6 +81,7 @@ public:
   std::string service_zone_name_;
   std::string log_path_;
   bool hot_restart_disabled_{};
+  bool libevent_buffers_enabled_{true};
 };
 
 class MockConfigTracker : public ConfigTracker {
@@ -53,6 +53,8 @@ public:
     }));
 
     EXPECT_CALL(*this, alloc("stats.overflow"));
+    EXPECT_CALL(*this, alloc("stats.central_cache_lock_contention"));
+    EXPECT_CALL(*this, alloc("stats.symbol_table_lock_contention"));
     store_.reset(new Stats::ThreadLocalStoreImpl(*this));
     store_->addSink(sink_);
   }
@@ -120,7 +122,7 @@ TEST_P(AdminStatsTest, StatsAsJson) {
 
   store_->mergeHistograms([]() -> void {});
 
-  EXPECT_CALL(*this, free(_));
+  EXPECT_CALL(*this, free(_)).Times(3);
 
   std::map<std::string, uint64_t> all_stats;
 
@@ -256,7 +258,7 @@ TEST_P(AdminStatsTest, UsedOnlyStatsAsJson) {
 
   store_->mergeHistograms([]() -> void {});
 
-  EXPECT_CALL(*this, free(_));
+  EXPECT_CALL(*this, free(_)).Times(3);
 
   std::map<std::string, uint64_t> all_stats;
 
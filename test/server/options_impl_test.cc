@@ -65,7 +65,8 @@ TEST(OptionsImplTest, All) {
       "envoy --mode validate --concurrency 2 -c hello --admin-address-path path --restart-epoch 1 "
       "--local-address-ip-version v6 -l info --service-cluster cluster --service-node node "
       "--service-zone zone --file-flush-interval-msec 9000 --drain-time-s 60 --log-format [%v] "
-      "--parent-shutdown-time-s 90 --log-path /foo/bar --v2-config-only --disable-hot-restart");
+      "--parent-shutdown-time-s 90 --log-path /foo/bar --v2-config-only --disable-hot-restart "
+      "--use-libevent-buffers 0");
   EXPECT_EQ(Server::Mode::Validate, options->mode());
   EXPECT_EQ(2U, options->concurrency());
   EXPECT_EQ("hello", options->configPath());
@@ -83,6 +84,7 @@ TEST(OptionsImplTest, All) {
   EXPECT_EQ(std::chrono::seconds(60), options->drainTime());
   EXPECT_EQ(std::chrono::seconds(90), options->parentShutdownTime());
   EXPECT_EQ(true, options->hotRestartDisabled());
+  EXPECT_EQ(false, options->libeventBuffersEnabled());
 
   options = createOptionsImpl("envoy --mode init_only");
   EXPECT_EQ(Server::Mode::InitOnly, options->mode());
@@ -92,6 +94,7 @@ TEST(OptionsImplTest, SetAll) {
   std::unique_ptr<OptionsImpl> options = createOptionsImpl("envoy -c hello");
   bool v2_config_only = options->v2ConfigOnly();
   bool hot_restart_disabled = options->hotRestartDisabled();
+  bool libevent_buffers_enabled = options->libeventBuffersEnabled();
   options->setBaseId(109876);
   options->setConcurrency(42);
   options->setConfigPath("foo");
@@ -113,6 +116,7 @@ TEST(OptionsImplTest, SetAll) {
   options->setMaxStats(12345);
   options->setMaxObjNameLength(54321);
   options->setHotRestartDisabled(!options->hotRestartDisabled());
+  options->setLibeventBuffersEnabled(!options->libeventBuffersEnabled());
 
   EXPECT_EQ(109876, options->baseId());
   EXPECT_EQ(42U, options->concurrency());
@@ -135,6 +139,7 @@ TEST(OptionsImplTest, SetAll) {
   EXPECT_EQ(12345U, options->maxStats());
   EXPECT_EQ(54321U, options->maxObjNameLength());
   EXPECT_EQ(!hot_restart_disabled, options->hotRestartDisabled());
+  EXPECT_EQ(!libevent_buffers_enabled, options->libeventBuffersEnabled());
 }
 
 TEST(OptionsImplTest, DefaultParams) {
@@ -145,6 +150,7 @@ TEST(OptionsImplTest, DefaultParams) {
   EXPECT_EQ(Network::Address::IpVersion::v4, options->localAddressIpVersion());
   EXPECT_EQ(Server::Mode::Serve, options->mode());
   EXPECT_EQ(false, options->hotRestartDisabled());
+  EXPECT_EQ(true, options->libeventBuffersEnabled());
 }
 
 TEST(OptionsImplTest, BadCliOption) {
@@ -0,0 +1,50 @@
+/**
+ * Utility to print the records of a binary access log ring file.
+ *
+ * Usage:
+ *
+ * binary_access_log_reader <ring file path> [--text]
+ *
+ * Each HTTPAccessLogEntry record is printed as a line of JSON, oldest first, or as text proto
+ * with --text.
+ */
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "envoy/common/exception.h"
+#include "envoy/data/accesslog/v2/accesslog.pb.h"
+
+#include "common/filesystem/filesystem_impl.h"
+#include "common/protobuf/utility.h"
+
+#include "extensions/access_loggers/binary/ring_file.h"
+
+// NOLINT(namespace-envoy)
+int main(int argc, char** argv) {
+  if (argc < 2 || argc > 3 || (argc == 3 && strcmp(argv[2], "--text") != 0)) {
+    std::cerr << "Usage: " << argv[0] << " <ring file path> [--text]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const bool text = argc == 3;
+
+  try {
+    Envoy::Extensions::AccessLoggers::Binary::RingFileReader::forEachRecord(
+        Envoy::Filesystem::fileReadToEnd(argv[1]), [text](absl::string_view record) {
+          envoy::data::accesslog::v2::HTTPAccessLogEntry entry;
+          if (!entry.ParseFromArray(record.data(), record.size())) {
+            std::cerr << "skipping a record that does not parse" << std::endl;
+            return;
+          }
+          if (text) {
+            std::cout << entry.DebugString() << std::endl;
+          } else {
+            std::cout << Envoy::MessageUtil::getJsonStringFromMessage(entry) << std::endl;
+          }
+        });
+  } catch (const Envoy::EnvoyException& e) {
+    std::cerr << argv[1] << ": " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}